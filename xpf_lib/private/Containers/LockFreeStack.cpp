@@ -0,0 +1,286 @@
+﻿/**
+ * @file        xpf_lib/private/Containers/LockFreeStack.cpp
+ *
+ * @brief       This is a lock-free LIFO stack (Treiber stack).
+ *              It uses a tagged head pointer to protect against the ABA problem,
+ *              and an epoch scheme so the popped elements can be safely freed.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+/**
+ * @brief   By default all code in here goes into default section.
+ */
+XPF_SECTION_DEFAULT;
+
+
+//
+// ************************************************************************************************
+// This is the section containing the reclamation of the popped elements.
+// A Pop reads the Next field of an element it does not own yet, so the element
+// must stay readable until that Pop is over. Each Pop announces itself in one of
+// two counters - the one matching the parity of the epoch it saw - and an element
+// which should be freed is first retired in the list of the current epoch E.
+//
+// Reclaim moves the epoch from E to E + 1 only when the counter of the parity of
+// E + 1 is zero - so all the Pop calls which saw that parity are over. A Pop that
+// could still read an element retired in E registered before the element left the
+// stack - so before the step to E + 1. The steps to E + 2 and E + 3 then saw both
+// counters empty, so that Pop is over and the list of E can be freed. A Pop which
+// registers later reads the head after the element left the stack.
+//
+// Nobody waits: if a counter is not empty, Reclaim returns what it has so far.
+// ************************************************************************************************
+//
+
+/**
+ * @brief       Converts a head word back to the element it points to.
+ *
+ * @param[in]   Word - The word to be converted.
+ *
+ * @return      The element. Can be NULL.
+ */
+static inline xpf::XPF_SINGLE_LIST_ENTRY* XPF_API
+XpfLfsWordToElement(
+    _In_ size_t Word
+) noexcept(true)
+{
+    return reinterpret_cast<xpf::XPF_SINGLE_LIST_ENTRY*>(Word);
+}
+
+/**
+ * @brief       Atomically detaches a retired list.
+ *
+ * @param[in,out] List - The head of the retired list.
+ *
+ * @return      The first element of the detached chain, or NULL if the list was empty.
+ */
+static inline xpf::XPF_SINGLE_LIST_ENTRY* XPF_API
+XpfLfsDetachRetired(
+    _Inout_ void* volatile* List
+) noexcept(true)
+{
+    void* top = *List;
+    while (nullptr != top)
+    {
+        void* previousTop = xpf::ApiAtomicCompareExchangePointer(List, nullptr, top);
+        if (previousTop == top)
+        {
+            break;
+        }
+        top = previousTop;
+    }
+    return static_cast<xpf::XPF_SINGLE_LIST_ENTRY*>(top);
+}
+
+void
+XPF_API
+xpf::LockFreeStack::Push(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Element
+) noexcept(true)
+{
+    this->PushList(Element, Element);
+}
+
+void
+XPF_API
+xpf::LockFreeStack::PushList(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true)
+{
+    //
+    // We can't insert a null chain.
+    //
+    if ((nullptr == First) || (nullptr == Last))
+    {
+        return;
+    }
+
+    xpf::AtomicWordPair oldHead = xpf::ApiAtomicLoadPair(&this->m_Head);
+    xpf::AtomicWordPair newHead;
+    newHead.Low = static_cast<size_t>(xpf::AlgoPointerToValue(First));
+
+    do
+    {
+        Last->Next = XpfLfsWordToElement(oldHead.Low);
+        newHead.High = oldHead.High + 1;
+    } while (!xpf::ApiAtomicTryCompareExchangePair(&this->m_Head, oldHead, newHead));
+}
+
+_Ret_maybenull_
+xpf::XPF_SINGLE_LIST_ENTRY*
+XPF_API
+xpf::LockFreeStack::Pop(
+    void
+) noexcept(true)
+{
+    //
+    // Announce ourselves before reading the head - see the section above.
+    //
+    const uint64_t parity = this->m_Epoch.Load(xpf::MemoryOrder::Relaxed) & 1;
+    (void) this->m_ActivePops[parity].FetchAdd(1);
+
+    XPF_SINGLE_LIST_ENTRY* top = nullptr;
+    xpf::AtomicWordPair oldHead = xpf::ApiAtomicLoadPair(&this->m_Head);
+    while (true)
+    {
+        top = XpfLfsWordToElement(oldHead.Low);
+        if (nullptr == top)
+        {
+            break;
+        }
+
+        //
+        // The top might have been popped by someone else already - in which case
+        // Next is garbage. But then the tag changed as well, so the CAS below fails.
+        // The element itself can't be freed yet, as we are still registered.
+        //
+        xpf::AtomicWordPair newHead;
+        newHead.Low = static_cast<size_t>(xpf::AlgoPointerToValue(top->Next));
+        newHead.High = oldHead.High + 1;
+
+        if (xpf::ApiAtomicTryCompareExchangePair(&this->m_Head, oldHead, newHead))
+        {
+            break;
+        }
+    }
+
+    (void) this->m_ActivePops[parity].FetchSub(1, xpf::MemoryOrder::Release);
+
+    if (nullptr != top)
+    {
+        top->Next = nullptr;
+    }
+    return top;
+}
+
+_Ret_maybenull_
+xpf::XPF_SINGLE_LIST_ENTRY*
+XPF_API
+xpf::LockFreeStack::Flush(
+    void
+) noexcept(true)
+{
+    xpf::AtomicWordPair oldHead = xpf::ApiAtomicLoadPair(&this->m_Head);
+    while (0 != oldHead.Low)
+    {
+        xpf::AtomicWordPair newHead;
+        newHead.Low = 0;
+        newHead.High = oldHead.High + 1;
+
+        if (xpf::ApiAtomicTryCompareExchangePair(&this->m_Head, oldHead, newHead))
+        {
+            return XpfLfsWordToElement(oldHead.Low);
+        }
+    }
+    return nullptr;
+}
+
+bool
+XPF_API
+xpf::LockFreeStack::IsEmpty(
+    void
+) const noexcept(true)
+{
+    return 0 == xpf::ApiAtomicLoad(&this->m_Head.Low, xpf::MemoryOrder::Relaxed);
+}
+
+void
+XPF_API
+xpf::LockFreeStack::Retire(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true)
+{
+    if ((nullptr == First) || (nullptr == Last))
+    {
+        return;
+    }
+
+    //
+    // The epoch is read after the elements left the stack. If it moves on
+    // while we push, the elements are only given back later - never earlier.
+    //
+    const uint64_t epoch = this->m_Epoch.Load();
+    void* volatile* list = &this->m_Retired[epoch % XPF_LFS_RETIRED_LISTS];
+
+    void* oldTop = *list;
+    while (true)
+    {
+        Last->Next = static_cast<XPF_SINGLE_LIST_ENTRY*>(oldTop);
+
+        void* previousTop = xpf::ApiAtomicCompareExchangePointer(list, First, oldTop);
+        if (previousTop == oldTop)
+        {
+            break;
+        }
+        oldTop = previousTop;
+    }
+}
+
+_Ret_maybenull_
+xpf::XPF_SINGLE_LIST_ENTRY*
+XPF_API
+xpf::LockFreeStack::Reclaim(
+    void
+) noexcept(true)
+{
+    //
+    // Only one reclaimer moves the epoch. The others have nothing to do.
+    //
+    uint32_t isReclaiming = 0;
+    if (!this->m_IsReclaiming.CompareExchange(isReclaiming, 1, xpf::MemoryOrder::Acquire))
+    {
+        return nullptr;
+    }
+
+    XPF_SINGLE_LIST_ENTRY* first = nullptr;
+    XPF_SINGLE_LIST_ENTRY* last = nullptr;
+
+    //
+    // When no Pop is in progress, as many steps as lists give back everything.
+    //
+    for (size_t step = 0; step < XPF_LFS_RETIRED_LISTS; ++step)
+    {
+        const uint64_t epoch = this->m_Epoch.Load(xpf::MemoryOrder::Relaxed);
+        if (0 != this->m_ActivePops[(epoch + 1) & 1].Load())
+        {
+            break;
+        }
+        this->m_Epoch.Store(epoch + 1);
+
+        //
+        // The list of (epoch + 1) - 3 can be given back now.
+        //
+        XPF_SINGLE_LIST_ENTRY* chain = XpfLfsDetachRetired(&this->m_Retired[(epoch + 2) % XPF_LFS_RETIRED_LISTS]);
+        if (nullptr == chain)
+        {
+            continue;
+        }
+
+        if (nullptr == last)
+        {
+            first = chain;
+        }
+        else
+        {
+            last->Next = chain;
+        }
+        last = chain;
+        while (nullptr != last->Next)
+        {
+            last = last->Next;
+        }
+    }
+
+    this->m_IsReclaiming.Store(0, xpf::MemoryOrder::Release);
+    return first;
+}
@@ -80,6 +80,63 @@ xpf::TlqPush(
     }
 }
 
+void
+XPF_API
+xpf::TlqPushList(
+    _Inout_ TwoLockQueue& Queue,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true)
+{
+    //
+    // We can't insert a null chain.
+    //
+    if ((nullptr == First) || (nullptr == Last))
+    {
+        return;
+    }
+    Last->Next = nullptr;
+
+    //
+    // Same as TlqPush - we usually get away with the tail lock only.
+    //
+    {
+        xpf::ExclusiveLockGuard tailGuard{ Queue.TailLock };
+        if (nullptr != Queue.Tail)
+        {
+            Queue.Tail->Next = First;
+            Queue.Tail = Last;
+            return;
+        }
+    }
+
+    //
+    // The queue is empty, so we need to modify the head as well.
+    //
+    {
+        xpf::ExclusiveLockGuard headGuard{ Queue.HeadLock };
+        xpf::ExclusiveLockGuard tailGuard{ Queue.TailLock };
+
+        //
+        // Might have raced so check again.
+        //
+        if (nullptr != Queue.Tail)
+        {
+            XPF_ASSERT(nullptr != Queue.Head);
+
+            Queue.Tail->Next = First;
+            Queue.Tail = Last;
+        }
+        else
+        {
+            XPF_ASSERT(nullptr == Queue.Head);
+
+            Queue.Head = First;
+            Queue.Tail = Last;
+        }
+    }
+}
+
 xpf::XPF_SINGLE_LIST_ENTRY*
 XPF_API
 xpf::TlqPop(
@@ -142,6 +199,95 @@ xpf::TlqPop(
     }
 }
 
+xpf::XPF_SINGLE_LIST_ENTRY*
+XPF_API
+xpf::TlqPopList(
+    _Inout_ TwoLockQueue& Queue,
+    _In_ size_t MaxElements,
+    _Out_ size_t* RemovedElements
+) noexcept(true)
+{
+    *RemovedElements = 0;
+
+    if (0 == MaxElements)
+    {
+        return nullptr;
+    }
+
+    //
+    // We usually get away with the head lock only - as long as we leave
+    // at least one element behind, the tail is never touched.
+    //
+    {
+        xpf::ExclusiveLockGuard headGuard{ Queue.HeadLock };
+        if (nullptr == Queue.Head)
+        {
+            return nullptr;
+        }
+        else if (Queue.Head->Next != nullptr)
+        {
+            xpf::XPF_SINGLE_LIST_ENTRY* first = Queue.Head;
+            xpf::XPF_SINGLE_LIST_ENTRY* last = Queue.Head;
+            size_t count = 1;
+
+            while ((count < MaxElements) && (nullptr != last->Next->Next))
+            {
+                last = last->Next;
+                count++;
+            }
+
+            Queue.Head = last->Next;
+            last->Next = nullptr;
+
+            *RemovedElements = count;
+            return first;
+        }
+    }
+
+    //
+    // Only one element might be left, so we need to update tail as well.
+    //
+    {
+        xpf::ExclusiveLockGuard headGuard{ Queue.HeadLock };
+        xpf::ExclusiveLockGuard tailGuard{ Queue.TailLock };
+
+        //
+        // Might have raced so check again.
+        //
+        if (nullptr == Queue.Head)
+        {
+            return nullptr;
+        }
+
+        xpf::XPF_SINGLE_LIST_ENTRY* first = Queue.Head;
+        xpf::XPF_SINGLE_LIST_ENTRY* last = Queue.Head;
+        size_t count = 1;
+
+        while ((count < MaxElements) && (nullptr != last->Next))
+        {
+            last = last->Next;
+            count++;
+        }
+
+        if (nullptr == last->Next)
+        {
+            XPF_ASSERT(last == Queue.Tail);
+
+            Queue.Tail = nullptr;
+            Queue.Head = nullptr;
+        }
+        else
+        {
+            Queue.Head = last->Next;
+        }
+
+        last->Next = nullptr;
+
+        *RemovedElements = count;
+        return first;
+    }
+}
+
 xpf::XPF_SINGLE_LIST_ENTRY*
 XPF_API
 xpf::TlqFlush(
@@ -39,13 +39,15 @@ xpf::BusyLock::LockExclusive(
         // This is important as this is the comparison value where we are doing the atomic op below.
         // If a writer already has the lock, we won't be able to acquire it.
         //
-        const uint16_t oldLock = xpf::ApiAtomicCompareExchange(&this->m_Lock, uint16_t{ 0 }, uint16_t{ 0 }) & 0x7fff;
+        // A plain read is enough - the exchange below validates it.
+        //
+        uint16_t oldLock = this->m_Lock.Load(xpf::MemoryOrder::Relaxed) & 0x7fff;
 
         //
         // Set the writer bit and try to acquire the lock similar with "read" access.
         //
         const uint16_t newLock = (oldLock | 0x8000);
-        if (oldLock != xpf::ApiAtomicCompareExchange(&this->m_Lock, newLock, oldLock))
+        if (!this->m_Lock.CompareExchange(oldLock, newLock, xpf::MemoryOrder::Acquire))
         {
             xpf::ApiYieldProcesor();
             continue;
@@ -56,7 +58,9 @@ xpf::BusyLock::LockExclusive(
         // Then we will be the only one with access. Setting the writer bit will prevent any other
         // reader or writer to acquire the lock in the meantime.
         //
-        while ((xpf::ApiAtomicCompareExchange(&this->m_Lock, uint16_t{ 0 }, uint16_t{ 0 }) & 0x7fff) != 0)
+        // The readers are polled with plain reads, so they can leave without contention.
+        //
+        while ((this->m_Lock.Load(xpf::MemoryOrder::Acquire) & 0x7fff) != 0)
         {
             xpf::ApiYieldProcesor();
         }
@@ -81,7 +85,7 @@ xpf::BusyLock::UnLockExclusive(
         // Assert here then go into an infinite cycle as this is an invalid usage.
         // It is not safe to recover.
         //
-        const uint16_t oldLock = xpf::ApiAtomicCompareExchange(&this->m_Lock, uint16_t{ 0 }, uint16_t{ 0 });
+        uint16_t oldLock = this->m_Lock.Load(xpf::MemoryOrder::Relaxed);
         if (oldLock != 0x8000)
         {
             xpf::ApiPanic(STATUS_MUTANT_NOT_OWNED);
@@ -93,7 +97,7 @@ xpf::BusyLock::UnLockExclusive(
         // If not, assert here and investigate what happened.
         //
         const uint16_t newLock = 0;
-        if (oldLock != xpf::ApiAtomicCompareExchange(&this->m_Lock, newLock, oldLock))
+        if (!this->m_Lock.CompareExchange(oldLock, newLock, xpf::MemoryOrder::Release))
         {
             xpf::ApiPanic(STATUS_MUTANT_NOT_OWNED);
             break;
@@ -122,7 +126,7 @@ xpf::BusyLock::LockShared(
         // A corner case is when we have max concurrent readers.
         // Should never happen but spin if we reach 2 ^ 15 concurrent readers.
         //
-        const uint16_t oldLock = (xpf::ApiAtomicCompareExchange(&this->m_Lock, uint16_t{ 0 }, uint16_t{ 0 }) & 0x7fff);
+        uint16_t oldLock = (this->m_Lock.Load(xpf::MemoryOrder::Relaxed) & 0x7fff);
         if (oldLock == 0x7fff)
         {
             xpf::ApiYieldProcesor();
@@ -134,7 +138,7 @@ xpf::BusyLock::LockShared(
         // If someone managed to change the lock value, spin and try again.
         //
         const uint16_t newLock = (oldLock + 1);
-        if (oldLock != xpf::ApiAtomicCompareExchange(&this->m_Lock, newLock, oldLock))
+        if (!this->m_Lock.CompareExchange(oldLock, newLock, xpf::MemoryOrder::Acquire))
         {
             xpf::ApiYieldProcesor();
             continue;
@@ -158,7 +162,7 @@ xpf::BusyLock::UnLockShared(
         //
         // 0 value means the lock is not taken. This is an invalid usage.
         //
-        const uint16_t oldLock = xpf::ApiAtomicCompareExchange(&this->m_Lock, uint16_t{ 0 }, uint16_t{ 0 });
+        uint16_t oldLock = this->m_Lock.Load(xpf::MemoryOrder::Relaxed);
         if (oldLock == 0)
         {
             xpf::ApiPanic(STATUS_MUTANT_NOT_OWNED);
@@ -170,7 +174,7 @@ xpf::BusyLock::UnLockShared(
         // If someone managed to change the lock value, spin and try again.
         //
         const uint16_t newLock = (oldLock - 1);
-        if (oldLock != xpf::ApiAtomicCompareExchange(&this->m_Lock, newLock, oldLock))
+        if (!this->m_Lock.CompareExchange(oldLock, newLock, xpf::MemoryOrder::Release))
         {
             xpf::ApiYieldProcesor();
             continue;
@@ -0,0 +1,148 @@
+﻿/**
+ * @file        xpf_lib/private/Memory/CacheRegistry.cpp
+ *
+ * @brief       Module-wide registry of the allocators which cache memory,
+ *              so the cached memory can be reclaimed under memory pressure.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+
+/**
+ * @brief   By default all code in here goes into default section.
+ *          Allocators register from non-paged code.
+ */
+XPF_SECTION_DEFAULT;
+
+/**
+ * @brief   Guards the registry. Trims take it shared, so they can run in parallel,
+ *          and unregistering takes it exclusive - so it waits for the trims in progress.
+ */
+static xpf::BusyLock gXpfCacheRegistryLock;
+
+/**
+ * @brief   The first registered entry.
+ */
+static xpf::CacheRegistryEntry* gXpfCacheRegistryHead = nullptr;
+
+
+void
+XPF_API
+xpf::ApiRegisterCache(
+    _Inout_ xpf::CacheRegistryEntry* Entry
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    XPF_DEATH_ON_FAILURE(nullptr != Entry);
+    XPF_DEATH_ON_FAILURE((nullptr != Entry->TrimFunction) && (nullptr != Entry->SizeFunction));
+
+    xpf::ExclusiveLockGuard guard{ gXpfCacheRegistryLock };
+
+    if (Entry->IsRegistered)
+    {
+        return;
+    }
+
+    Entry->Previous = nullptr;
+    Entry->Next = gXpfCacheRegistryHead;
+    if (nullptr != gXpfCacheRegistryHead)
+    {
+        gXpfCacheRegistryHead->Previous = Entry;
+    }
+    gXpfCacheRegistryHead = Entry;
+    Entry->IsRegistered = true;
+}
+
+void
+XPF_API
+xpf::ApiUnregisterCache(
+    _Inout_ xpf::CacheRegistryEntry* Entry
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (nullptr == Entry)
+    {
+        return;
+    }
+
+    //
+    // Only the owner registers and unregisters its entry, so the flag can be checked
+    // without the lock. An entry which never joined doesn't contend on the registry.
+    //
+    if (!Entry->IsRegistered)
+    {
+        return;
+    }
+
+    xpf::ExclusiveLockGuard guard{ gXpfCacheRegistryLock };
+
+    if (!Entry->IsRegistered)
+    {
+        return;
+    }
+
+    if (nullptr != Entry->Previous)
+    {
+        Entry->Previous->Next = Entry->Next;
+    }
+    else
+    {
+        gXpfCacheRegistryHead = Entry->Next;
+    }
+    if (nullptr != Entry->Next)
+    {
+        Entry->Next->Previous = Entry->Previous;
+    }
+
+    Entry->Previous = nullptr;
+    Entry->Next = nullptr;
+    Entry->IsRegistered = false;
+}
+
+size_t
+XPF_API
+xpf::ApiTrimCaches(
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true)
+{
+    //
+    // Some caches (the slab allocator) use paged memory.
+    //
+    XPF_MAX_APC_LEVEL();
+
+    size_t trimmedBytes = 0;
+
+    xpf::SharedLockGuard guard{ gXpfCacheRegistryLock };
+    for (xpf::CacheRegistryEntry* entry = gXpfCacheRegistryHead; nullptr != entry; entry = entry->Next)
+    {
+        trimmedBytes += entry->TrimFunction(entry->Context, Level);
+    }
+    return trimmedBytes;
+}
+
+size_t
+XPF_API
+xpf::ApiCachedBytes(
+    void
+) noexcept(true)
+{
+    XPF_MAX_APC_LEVEL();
+
+    size_t cachedBytes = 0;
+
+    xpf::SharedLockGuard guard{ gXpfCacheRegistryLock };
+    for (xpf::CacheRegistryEntry* entry = gXpfCacheRegistryHead; nullptr != entry; entry = entry->Next)
+    {
+        cachedBytes += entry->SizeFunction(entry->Context);
+    }
+    return cachedBytes;
+}
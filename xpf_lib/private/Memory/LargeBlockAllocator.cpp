@@ -0,0 +1,147 @@
+﻿/**
+ * @file        xpf_lib/private/Memory/LargeBlockAllocator.cpp
+ *
+ * @brief       Side table of the big blocks mapped directly from the system pages.
+ *              The blocks carry no header, so their mapped size is kept here.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+
+/**
+ * @brief   By default all code in here goes into default section.
+ *          We don't want to page out the allocator.
+ */
+XPF_SECTION_DEFAULT;
+
+
+//
+// ************************************************************************************************
+// This is the section of structures and data definitions.
+// ************************************************************************************************
+//
+
+/**
+ * @brief   One entry of the side table - describes a mapped block.
+ */
+struct XPF_LARGE_BLOCK_RECORD
+{
+    /**
+     * @brief   The next record.
+     */
+    XPF_LARGE_BLOCK_RECORD* Next;
+
+    /**
+     * @brief   The block returned by ApiAllocatePages.
+     */
+    void* Block;
+
+    /**
+     * @brief   The size given to ApiAllocatePages.
+     */
+    size_t MappedSize;
+};
+
+/**
+ * @brief   Guards the side table. The big blocks are few and each one costs a system call
+ *          anyway, so a list is good enough.
+ */
+static xpf::BusyLock gXpfLargeBlockLock;
+
+/**
+ * @brief   The first record of the side table.
+ */
+static XPF_LARGE_BLOCK_RECORD* gXpfLargeBlockRecords = nullptr;
+
+
+//
+// ************************************************************************************************
+// This is the section containing the side table implementation.
+// ************************************************************************************************
+//
+
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+xpf::ApiAllocateLargeBlock(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    XPF_LARGE_BLOCK_RECORD* record = static_cast<XPF_LARGE_BLOCK_RECORD*>(
+                                     xpf::ApiAllocateMemory(sizeof(XPF_LARGE_BLOCK_RECORD), false));
+    if (nullptr == record)
+    {
+        return nullptr;
+    }
+
+    record->Block = xpf::ApiAllocatePages(BlockSize, true);
+    if (nullptr == record->Block)
+    {
+        xpf::ApiFreeMemory(record);
+        return nullptr;
+    }
+    record->MappedSize = BlockSize;
+
+    void* block = record->Block;
+    {
+        xpf::ExclusiveLockGuard guard{ gXpfLargeBlockLock };
+
+        record->Next = gXpfLargeBlockRecords;
+        gXpfLargeBlockRecords = record;
+    }
+    return block;
+}
+
+_Check_return_
+bool
+XPF_API
+xpf::ApiFreeLargeBlock(
+    _Inout_opt_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (nullptr == MemoryBlock)
+    {
+        return false;
+    }
+
+    XPF_LARGE_BLOCK_RECORD* record = nullptr;
+    {
+        xpf::ExclusiveLockGuard guard{ gXpfLargeBlockLock };
+
+        XPF_LARGE_BLOCK_RECORD** link = &gXpfLargeBlockRecords;
+        while ((nullptr != *link) && ((*link)->Block != MemoryBlock))
+        {
+            link = &((*link)->Next);
+        }
+
+        record = *link;
+        if (nullptr != record)
+        {
+            *link = record->Next;
+        }
+    }
+
+    //
+    // Not ours - the caller frees it some other way.
+    //
+    if (nullptr == record)
+    {
+        return false;
+    }
+
+    xpf::ApiFreePages(record->Block, record->MappedSize);
+    xpf::ApiFreeMemory(record);
+    return true;
+}
@@ -24,6 +24,88 @@
   */
 XPF_SECTION_DEFAULT;
 
+/**
+ * @brief Atomically reads a value. The counters here are best effort, so no ordering is needed.
+ *
+ * @param[in] Value - The value to be read.
+ *
+ * @return The current value.
+ */
+template <class Type>
+static inline Type XPF_API
+LookasideAtomicRead(
+    _In_ volatile Type* Value
+) noexcept(true)
+{
+    return xpf::ApiAtomicLoad(Value, xpf::MemoryOrder::Relaxed);
+}
+
+/**
+ * @brief Atomically replaces a value.
+ *
+ * @param[in,out] Value - The value to be replaced.
+ *
+ * @param[in] NewValue - The value to be stored.
+ *
+ * @return None.
+ */
+template <class Type>
+static inline void XPF_API
+LookasideAtomicStore(
+    _Inout_ volatile Type* Value,
+    _In_ Type NewValue
+) noexcept(true)
+{
+    xpf::ApiAtomicStore(Value, NewValue, xpf::MemoryOrder::Relaxed);
+}
+
+/**
+ * @brief Atomically adds to a value.
+ *
+ * @param[in,out] Value - The value to be increased.
+ *
+ * @param[in] Addend - How much to add.
+ *
+ * @return None.
+ */
+template <class Type>
+static inline void XPF_API
+LookasideAtomicAdd(
+    _Inout_ volatile Type* Value,
+    _In_ Type Addend
+) noexcept(true)
+{
+    (void) xpf::ApiAtomicFetchAdd(Value, Addend, xpf::MemoryOrder::Relaxed);
+}
+
+/**
+ * @brief Atomically moves a water mark towards a candidate value.
+ *
+ * @param[in,out] Mark - The water mark to be updated.
+ *
+ * @param[in] Candidate - The newly observed value.
+ *
+ * @param[in] IsHighMark - If true, the mark only goes up. Otherwise it only goes down.
+ *
+ * @return None.
+ */
+static inline void XPF_API
+LookasideUpdateWaterMark(
+    _Inout_ volatile uint32_t* Mark,
+    _In_ uint32_t Candidate,
+    _In_ bool IsHighMark
+) noexcept(true)
+{
+    uint32_t currentValue = LookasideAtomicRead(Mark);
+    while (IsHighMark ? (Candidate > currentValue) : (Candidate < currentValue))
+    {
+        if (xpf::ApiAtomicTryCompareExchange(Mark, currentValue, Candidate, xpf::MemoryOrder::Relaxed))
+        {
+            break;
+        }
+    }
+}
+
 void
 XPF_API
 xpf::LookasideListAllocator::Destroy(
@@ -33,16 +115,36 @@ xpf::LookasideListAllocator::Destroy(
     XPF_MAX_DISPATCH_LEVEL();
 
     //
-    // Walk the list and free everything.
+    // Leave the registry first, if we joined it - this also waits for a trim in progress.
     //
-    XPF_SINGLE_LIST_ENTRY* crtEntry = xpf::TlqFlush(this->m_TwoLockQueue);
-    while (nullptr != crtEntry)
+    xpf::ApiUnregisterCache(&this->m_CacheEntry);
+
+    //
+    // First empty the magazines - if any. Nobody should use the allocator at this point.
+    //
+    void* magazinesBlock = this->m_MagazinesBlock;
+    if (nullptr != magazinesBlock)
     {
-        void* blockToBeDestroyed = static_cast<void*>(crtEntry);
-        crtEntry = crtEntry->Next;
+        LookasideMagazine* magazines = static_cast<LookasideMagazine*>(magazinesBlock);
 
-        this->DeleteMemoryBlock(blockToBeDestroyed);
-        blockToBeDestroyed = nullptr;
+        for (uint32_t i = 0; i < this->m_NumberOfMagazines; ++i)
+        {
+            this->DeleteMemoryBlocks(magazines[i].Top);
+            xpf::MemoryAllocator::Destruct(&magazines[i]);
+        }
+
+        xpf::ApiFreeMemoryAligned(magazinesBlock);
+        this->m_MagazinesBlock = nullptr;
+    }
+
+    //
+    // Walk the list and free everything. Nobody pops anymore,
+    // so the retired blocks are all given back as well.
+    //
+    this->DeleteMemoryBlocks(this->SharedStoreFlush());
+    if (this->m_UseLockFreeStack)
+    {
+        this->DeleteMemoryBlocks(this->m_LockFreeStack.Reclaim());
     }
 
     //
@@ -50,7 +152,11 @@ xpf::LookasideListAllocator::Destroy(
     //
     this->m_ElementSize = 0;
     this->m_CurrentElements = 0;
-    this->m_MaxElements = 0;
+    this->m_HighWaterElements = 0;
+    this->m_LowWaterElements = 0;
+    this->m_MaxElements.Store(0, xpf::MemoryOrder::Relaxed);
+    this->m_NumberOfMagazines = 0;
+    this->m_MagazineCapacity.Store(0, xpf::MemoryOrder::Relaxed);
 }
 
 _Ret_maybenull_
@@ -78,6 +184,268 @@ xpf::LookasideListAllocator::DeleteMemoryBlock(
                                   : xpf::MemoryAllocator::FreeMemory(MemoryBlock);
 }
 
+void
+XPF_API
+xpf::LookasideListAllocator::DeleteMemoryBlocks(
+    _Inout_opt_ XPF_SINGLE_LIST_ENTRY* First
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    XPF_SINGLE_LIST_ENTRY* crtEntry = First;
+    while (nullptr != crtEntry)
+    {
+        void* blockToBeDestroyed = static_cast<void*>(crtEntry);
+        crtEntry = crtEntry->Next;
+
+        this->DeleteMemoryBlock(blockToBeDestroyed);
+        blockToBeDestroyed = nullptr;
+    }
+}
+
+void
+XPF_API
+xpf::LookasideListAllocator::ReleaseToSystem(
+    _Inout_opt_ XPF_SINGLE_LIST_ENTRY* First
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (!this->m_UseLockFreeStack)
+    {
+        this->DeleteMemoryBlocks(First);
+        return;
+    }
+
+    if (nullptr != First)
+    {
+        XPF_SINGLE_LIST_ENTRY* last = First;
+        while (nullptr != last->Next)
+        {
+            last = last->Next;
+        }
+        this->m_LockFreeStack.Retire(First, last);
+    }
+    this->DeleteMemoryBlocks(this->m_LockFreeStack.Reclaim());
+}
+
+_Ret_maybenull_
+xpf::LookasideListAllocator::LookasideMagazine*
+XPF_API
+xpf::LookasideListAllocator::AllocatedMagazines(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    void* magazinesBlock = xpf::ApiAtomicLoad(&this->m_MagazinesBlock, xpf::MemoryOrder::Acquire);
+    if (nullptr == magazinesBlock)
+    {
+        return nullptr;
+    }
+    return static_cast<LookasideMagazine*>(magazinesBlock);
+}
+
+_Ret_maybenull_
+xpf::LookasideListAllocator::LookasideMagazine*
+XPF_API
+xpf::LookasideListAllocator::CurrentMagazine(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (0 == this->m_NumberOfMagazines)
+    {
+        return nullptr;
+    }
+
+    //
+    // Lazily allocate the magazines. The block is cache line aligned, so each magazine has its own line.
+    // If we race with someone else, only one will win, and the other one will free its block.
+    //
+    void* magazinesBlock = xpf::ApiAtomicLoad(&this->m_MagazinesBlock, xpf::MemoryOrder::Acquire);
+    if (nullptr == magazinesBlock)
+    {
+        const size_t blockSize = sizeof(LookasideMagazine) * size_t{ this->m_NumberOfMagazines };
+
+        void* newBlock = xpf::ApiAllocateMemoryAligned(blockSize,
+                                                       alignof(LookasideMagazine),
+                                                       this->m_IsCriticalAllocator);
+        if (nullptr == newBlock)
+        {
+            return nullptr;
+        }
+
+        LookasideMagazine* magazines = static_cast<LookasideMagazine*>(newBlock);
+        for (uint32_t i = 0; i < this->m_NumberOfMagazines; ++i)
+        {
+            xpf::MemoryAllocator::Construct(&magazines[i]);
+        }
+
+        magazinesBlock = xpf::ApiAtomicCompareExchangePointer(&this->m_MagazinesBlock, newBlock, nullptr);
+        if (nullptr == magazinesBlock)
+        {
+            magazinesBlock = newBlock;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < this->m_NumberOfMagazines; ++i)
+            {
+                xpf::MemoryAllocator::Destruct(&magazines[i]);
+            }
+            xpf::ApiFreeMemoryAligned(newBlock);
+            newBlock = nullptr;
+        }
+    }
+
+    LookasideMagazine* magazines = static_cast<LookasideMagazine*>(magazinesBlock);
+    return &magazines[xpf::ApiCurrentProcessorNumber() % this->m_NumberOfMagazines];
+}
+
+void
+XPF_API
+xpf::LookasideListAllocator::SharedStorePush(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (this->m_UseLockFreeStack)
+    {
+        this->m_LockFreeStack.PushList(First, Last);
+    }
+    else
+    {
+        xpf::TlqPushList(this->m_TwoLockQueue, First, Last);
+    }
+}
+
+_Ret_maybenull_
+xpf::XPF_SINGLE_LIST_ENTRY*
+XPF_API
+xpf::LookasideListAllocator::SharedStorePop(
+    _In_ size_t MaxElements,
+    _Out_ size_t* RemovedElements
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (!this->m_UseLockFreeStack)
+    {
+        return xpf::TlqPopList(this->m_TwoLockQueue, MaxElements, RemovedElements);
+    }
+
+    //
+    // The lock-free stack can only detach the top element atomically,
+    // so we build the batch one element at a time.
+    //
+    XPF_SINGLE_LIST_ENTRY* first = nullptr;
+    XPF_SINGLE_LIST_ENTRY* last = nullptr;
+    size_t removedElements = 0;
+
+    while (removedElements < MaxElements)
+    {
+        XPF_SINGLE_LIST_ENTRY* element = this->m_LockFreeStack.Pop();
+        if (nullptr == element)
+        {
+            break;
+        }
+
+        if (nullptr == last)
+        {
+            first = element;
+        }
+        else
+        {
+            last->Next = element;
+        }
+        last = element;
+        removedElements++;
+    }
+
+    *RemovedElements = removedElements;
+    return first;
+}
+
+_Ret_maybenull_
+xpf::XPF_SINGLE_LIST_ENTRY*
+XPF_API
+xpf::LookasideListAllocator::SharedStoreFlush(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    return (this->m_UseLockFreeStack) ? this->m_LockFreeStack.Flush()
+                                      : xpf::TlqFlush(this->m_TwoLockQueue);
+}
+
+void
+XPF_API
+xpf::LookasideListAllocator::AdjustCurrentElements(
+    _In_ size_t Count,
+    _In_ bool Add
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // This is a best effort counter, so we just need it to not wrap around.
+    //
+    uint32_t currentValue = LookasideAtomicRead(&this->m_CurrentElements);
+    while (true)
+    {
+        uint32_t newValue = 0;
+        if (Add)
+        {
+            newValue = currentValue + static_cast<uint32_t>(Count);
+        }
+        else
+        {
+            newValue = (currentValue > Count) ? currentValue - static_cast<uint32_t>(Count)
+                                              : 0;
+        }
+
+        if (xpf::ApiAtomicTryCompareExchange(&this->m_CurrentElements,
+                                             currentValue,
+                                             newValue,
+                                             xpf::MemoryOrder::Relaxed))
+        {
+            LookasideUpdateWaterMark((Add) ? &this->m_HighWaterElements : &this->m_LowWaterElements,
+                                     newValue,
+                                     Add);
+            break;
+        }
+    }
+}
+
+void
+XPF_API
+xpf::LookasideListAllocator::ReleaseBlocks(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last,
+    _In_ size_t Count
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // We might not want to store the blocks into the list if we have too many elements.
+    // Same as for a single block - this is a best effort to not store too much memory at once.
+    //
+    if (LookasideAtomicRead(&this->m_CurrentElements) >= this->m_MaxElements.Load(xpf::MemoryOrder::Relaxed))
+    {
+        this->ReleaseToSystem(First);
+    }
+    else
+    {
+        this->SharedStorePush(First, Last);
+        this->AdjustCurrentElements(Count, true);
+    }
+}
+
 _Check_return_
 _Ret_maybenull_
 void*
@@ -115,9 +483,61 @@ xpf::LookasideListAllocator::AllocateMemory(
     #endif  // XPF_PLATFORM_WIN_KM
 
     //
-    // If we have a memory block in list, we return it.
+    // If we have a per-cpu magazine, we first try to serve the request from it.
+    // When it is empty, we refill it with a batch from the shared queue.
     //
-    memoryBlock = xpf::TlqPop(this->m_TwoLockQueue);
+    LookasideMagazine* magazine = this->CurrentMagazine();
+    if (nullptr != magazine)
+    {
+        xpf::ExclusiveLockGuard guard{ magazine->Lock };
+
+        if (0 == magazine->Count)
+        {
+            magazine->LowWater = 0;
+
+            size_t removedElements = 0;
+            magazine->Top = this->SharedStorePop(this->m_MagazineCapacity.Load(xpf::MemoryOrder::Relaxed) / 2,
+                                                 &removedElements);
+            magazine->Count = removedElements;
+            if (0 != removedElements)
+            {
+                this->AdjustCurrentElements(removedElements, false);
+            }
+        }
+        if (0 != magazine->Count)
+        {
+            memoryBlock = magazine->Top;
+            magazine->Top = memoryBlock->Next;
+            magazine->Count--;
+            magazine->Hits++;
+
+            if (magazine->Count < magazine->LowWater)
+            {
+                magazine->LowWater = magazine->Count;
+            }
+        }
+        else
+        {
+            magazine->Misses++;
+        }
+    }
+    else
+    {
+        //
+        // If we have a memory block in list, we return it.
+        //
+        size_t removedElements = 0;
+        memoryBlock = this->SharedStorePop(1, &removedElements);
+        if (nullptr != memoryBlock)
+        {
+            this->AdjustCurrentElements(1, false);
+            xpf::ApiAtomicIncrement(&this->m_Hits);
+        }
+        else
+        {
+            xpf::ApiAtomicIncrement(&this->m_Misses);
+        }
+    }
 
     //
     // If we didn't have a memory block we take the long route.
@@ -126,10 +546,9 @@ xpf::LookasideListAllocator::AllocateMemory(
     {
         memoryBlock = static_cast<XPF_SINGLE_LIST_ENTRY*>(this->NewMemoryBlock());
     }
-    else
+    else if (this->m_ZeroOnReuse)
     {
         xpf::ApiZeroMemory(memoryBlock, this->m_ElementSize);
-        xpf::ApiAtomicDecrement(&this->m_CurrentElements);
     }
 
     //
@@ -184,20 +603,75 @@ xpf::LookasideListAllocator::FreeMemory(
     #endif  // XPF_PLATFORM_WIN_KM
 
     //
-    // We might not want to store it into the list if we have too many elements.
-    // In such cases we free the memory directly. We don't care if we might race.
-    // This value is a best effort to not store too much memory at once.
-    // The algorithm works correctly regardless of how many blocks we have.
+    // If we have a per-cpu magazine, the block goes there. When the magazine is full,
+    // we first spill half of it to the shared queue, so we touch the queue only once per batch.
     //
-    if (xpf::ApiAtomicCompareExchange(&this->m_CurrentElements, uint32_t{0}, uint32_t{0}) >= this->m_MaxElements)
+    LookasideMagazine* magazine = this->CurrentMagazine();
+    if (nullptr != magazine)
     {
-        this->DeleteMemoryBlock(newEntry);
-        newEntry = nullptr;
+        //
+        // The capacity can be changed via SetMaxDepth(), so we read it only once.
+        //
+        const size_t magazineCapacity = this->m_MagazineCapacity.Load(xpf::MemoryOrder::Relaxed);
+
+        XPF_SINGLE_LIST_ENTRY* spillFirst = nullptr;
+        XPF_SINGLE_LIST_ENTRY* spillLast = nullptr;
+        size_t spillCount = 0;
+
+        {
+            xpf::ExclusiveLockGuard guard{ magazine->Lock };
+
+            if (magazine->Count >= magazineCapacity)
+            {
+                spillCount = magazineCapacity / 2;
+                spillFirst = magazine->Top;
+                spillLast = magazine->Top;
+                for (size_t i = 1; i < spillCount; ++i)
+                {
+                    spillLast = spillLast->Next;
+                }
+
+                magazine->Top = spillLast->Next;
+                magazine->Count -= spillCount;
+                spillLast->Next = nullptr;
+
+                if (magazine->Count < magazine->LowWater)
+                {
+                    magazine->LowWater = magazine->Count;
+                }
+            }
+
+            newEntry->Next = magazine->Top;
+            magazine->Top = newEntry;
+            magazine->Count++;
+        }
+
+        //
+        // The spilled blocks are handled outside the magazine lock.
+        //
+        if (nullptr != spillFirst)
+        {
+            this->ReleaseBlocks(spillFirst, spillLast, spillCount);
+        }
     }
     else
     {
-        xpf::TlqPush(this->m_TwoLockQueue, newEntry);
-        xpf::ApiAtomicIncrement(&this->m_CurrentElements);
+        //
+        // We might not want to store it into the list if we have too many elements.
+        // In such cases we free the memory directly. We don't care if we might race.
+        // This value is a best effort to not store too much memory at once.
+        // The algorithm works correctly regardless of how many blocks we have.
+        //
+        if (LookasideAtomicRead(&this->m_CurrentElements) >= this->m_MaxElements.Load(xpf::MemoryOrder::Relaxed))
+        {
+            this->ReleaseToSystem(newEntry);
+            newEntry = nullptr;
+        }
+        else
+        {
+            this->SharedStorePush(newEntry, newEntry);
+            this->AdjustCurrentElements(1, true);
+        }
     }
 
     //
@@ -211,3 +685,187 @@ xpf::LookasideListAllocator::FreeMemory(
         }
     #endif  // XPF_PLATFORM_WIN_KM
 }
+
+void
+XPF_API
+xpf::LookasideListAllocator::SetMaxDepth(
+    _In_ size_t MaxDepth
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // Allocate and Free read these concurrently. Each value is consistent on its own,
+    // a caller observing the old depth for a while is harmless.
+    //
+    this->m_MaxElements.Store(MaxDepth, xpf::MemoryOrder::Relaxed);
+
+    //
+    // Same rule as in the constructor - the magazines keep at most half of the elements.
+    // But once we have magazines, we can't drop them, so each keeps at least a couple of elements.
+    //
+    if (0 != this->m_NumberOfMagazines)
+    {
+        size_t magazineCapacity = (MaxDepth / 2) / this->m_NumberOfMagazines;
+        if (magazineCapacity > LOOKASIDE_MAGAZINE_CAPACITY)
+        {
+            magazineCapacity = LOOKASIDE_MAGAZINE_CAPACITY;
+        }
+        if (magazineCapacity < 2)
+        {
+            magazineCapacity = 2;
+        }
+        this->m_MagazineCapacity.Store(magazineCapacity, xpf::MemoryOrder::Relaxed);
+    }
+}
+
+size_t
+XPF_API
+xpf::LookasideListAllocator::Trim(
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    size_t trimmedBlocks = 0;
+
+    //
+    // First the magazines. The blocks under the low-water mark were not touched
+    // since the last trim, so they go back to the system.
+    //
+    LookasideMagazine* magazines = this->AllocatedMagazines();
+    if (nullptr != magazines)
+    {
+        for (uint32_t i = 0; i < this->m_NumberOfMagazines; ++i)
+        {
+            XPF_SINGLE_LIST_ENTRY* releaseFirst = nullptr;
+            size_t releaseCount = 0;
+
+            {
+                xpf::ExclusiveLockGuard guard{ magazines[i].Lock };
+
+                releaseCount = (magazines[i].LowWater < magazines[i].Count) ? magazines[i].LowWater
+                                                                            : magazines[i].Count;
+                if (xpf::CacheTrimLevel::Full == Level)
+                {
+                    releaseCount = magazines[i].Count;
+                }
+                if (0 != releaseCount)
+                {
+                    XPF_SINGLE_LIST_ENTRY* releaseLast = magazines[i].Top;
+                    for (size_t j = 1; j < releaseCount; ++j)
+                    {
+                        releaseLast = releaseLast->Next;
+                    }
+
+                    releaseFirst = magazines[i].Top;
+                    magazines[i].Top = releaseLast->Next;
+                    magazines[i].Count -= releaseCount;
+                    releaseLast->Next = nullptr;
+                }
+                magazines[i].LowWater = magazines[i].Count;
+            }
+
+            this->ReleaseToSystem(releaseFirst);
+            trimmedBlocks += releaseCount;
+        }
+    }
+
+    //
+    // Now the shared store. Besides the idle blocks, we also give back
+    // everything above the maximum depth - it might have been lowered.
+    //
+    const size_t currentElements = LookasideAtomicRead(&this->m_CurrentElements);
+    const size_t maxElements = this->m_MaxElements.Load(xpf::MemoryOrder::Relaxed);
+    size_t releaseCount = LookasideAtomicRead(&this->m_LowWaterElements);
+    if (currentElements > maxElements && currentElements - maxElements > releaseCount)
+    {
+        releaseCount = currentElements - maxElements;
+    }
+    if (xpf::CacheTrimLevel::Full == Level)
+    {
+        releaseCount = currentElements;
+    }
+
+    //
+    // The shared store may hand out fewer elements than requested at once, so we loop.
+    //
+    while (0 != releaseCount)
+    {
+        size_t removedElements = 0;
+        XPF_SINGLE_LIST_ENTRY* releaseFirst = this->SharedStorePop(releaseCount, &removedElements);
+        if (0 == removedElements)
+        {
+            break;
+        }
+        this->AdjustCurrentElements(removedElements, false);
+
+        this->ReleaseToSystem(releaseFirst);
+        trimmedBlocks += removedElements;
+        releaseCount -= removedElements;
+    }
+
+    //
+    // A new interval begins. The low-water mark starts from the current depth.
+    //
+    LookasideAtomicStore(&this->m_LowWaterElements, LookasideAtomicRead(&this->m_CurrentElements));
+    LookasideAtomicAdd(&this->m_TrimmedBlocks, static_cast<uint64_t>(trimmedBlocks));
+
+    return trimmedBlocks;
+}
+
+xpf::LookasideListStatistics
+XPF_API
+xpf::LookasideListAllocator::GetStatistics(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    xpf::LookasideListStatistics statistics;
+
+    statistics.Hits = LookasideAtomicRead(&this->m_Hits);
+    statistics.Misses = LookasideAtomicRead(&this->m_Misses);
+    statistics.TrimmedBlocks = LookasideAtomicRead(&this->m_TrimmedBlocks);
+    statistics.CurrentDepth = LookasideAtomicRead(&this->m_CurrentElements);
+    statistics.HighWaterDepth = LookasideAtomicRead(&this->m_HighWaterElements);
+    statistics.MaxDepth = this->m_MaxElements.Load(xpf::MemoryOrder::Relaxed);
+
+    LookasideMagazine* magazines = this->AllocatedMagazines();
+    if (nullptr != magazines)
+    {
+        for (uint32_t i = 0; i < this->m_NumberOfMagazines; ++i)
+        {
+            xpf::ExclusiveLockGuard guard{ magazines[i].Lock };
+
+            statistics.Hits += magazines[i].Hits;
+            statistics.Misses += magazines[i].Misses;
+            statistics.CurrentDepth += magazines[i].Count;
+        }
+    }
+
+    return statistics;
+}
+
+size_t
+xpf::LookasideListAllocator::CacheTrimCallback(
+    _In_ void* Context,
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+
+    xpf::LookasideListAllocator* allocator = static_cast<xpf::LookasideListAllocator*>(Context);
+    return allocator->Trim(Level) * allocator->m_ElementSize;
+}
+
+size_t
+xpf::LookasideListAllocator::CacheSizeCallback(
+    _In_ void* Context
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+
+    xpf::LookasideListAllocator* allocator = static_cast<xpf::LookasideListAllocator*>(Context);
+    return allocator->GetStatistics().CurrentDepth * allocator->m_ElementSize;
+}
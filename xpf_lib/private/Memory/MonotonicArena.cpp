@@ -0,0 +1,189 @@
+﻿/**
+ * @file        xpf_lib/private/Memory/MonotonicArena.cpp
+ *
+ * @brief       Bump-pointer allocator. Memory is carved from big chunks
+ *              and it is released all at once, when the arena is released.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+
+/**
+ * @brief   By default all code in here goes into default section.
+ *          We don't want to page out the allocator.
+ */
+XPF_SECTION_DEFAULT;
+
+_Ret_maybenull_
+void*
+XPF_API
+xpf::MonotonicArena::CarveFromCurrentChunk(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    MonotonicArenaChunk* chunk = this->m_CurrentChunk;
+    if ((nullptr == chunk) || (chunk->Capacity - chunk->Used < BlockSize))
+    {
+        return nullptr;
+    }
+
+    void* block = xpf::AlgoAddToPointer(chunk, sizeof(MonotonicArenaChunk) + chunk->Used);
+    chunk->Used += BlockSize;
+    this->m_UsedBytes += BlockSize;
+
+    return block;
+}
+
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+xpf::MonotonicArena::AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // Keep every block aligned - so we round up the requested size.
+    // Avoid 0-size allocations - mimic the system allocator.
+    //
+    if (BlockSize > xpf::NumericLimits<size_t>::MaxValue() - sizeof(MonotonicArenaChunk) - XPF_DEFAULT_ALIGNMENT)
+    {
+        return nullptr;
+    }
+    const size_t alignedSize = xpf::AlgoAlignValueUp((BlockSize == 0) ? size_t{ 1 } : BlockSize,
+                                                     size_t{ XPF_DEFAULT_ALIGNMENT });
+
+    //
+    // The fast path - there is room in the current chunk.
+    //
+    {
+        xpf::ExclusiveLockGuard guard{ this->m_Lock };
+
+        void* block = this->CarveFromCurrentChunk(alignedSize);
+        if (nullptr != block)
+        {
+            return block;
+        }
+    }
+
+    //
+    // We need a new chunk. Allocate it outside of the lock.
+    // Big requests get a dedicated chunk.
+    //
+    const size_t chunkCapacity = (alignedSize > this->m_ChunkSize) ? alignedSize
+                                                                   : this->m_ChunkSize;
+    const size_t chunkSize = sizeof(MonotonicArenaChunk) + chunkCapacity;
+
+    void* memory = (this->m_IsCriticalAllocator) ? xpf::CriticalMemoryAllocator::AllocateMemory(chunkSize)
+                                                 : xpf::MemoryAllocator::AllocateMemory(chunkSize);
+    if (nullptr == memory)
+    {
+        return nullptr;
+    }
+
+    MonotonicArenaChunk* newChunk = static_cast<MonotonicArenaChunk*>(memory);
+    xpf::MemoryAllocator::Construct(newChunk);
+    newChunk->Capacity = chunkCapacity;
+    newChunk->Used = alignedSize;
+
+    xpf::ExclusiveLockGuard guard{ this->m_Lock };
+
+    //
+    // A dedicated chunk is linked behind the current one, so we don't lose the room left in it.
+    // Otherwise the new chunk becomes the current one.
+    //
+    if ((nullptr != this->m_CurrentChunk) && (alignedSize > this->m_ChunkSize))
+    {
+        newChunk->Next = this->m_CurrentChunk->Next;
+        this->m_CurrentChunk->Next = newChunk;
+    }
+    else
+    {
+        newChunk->Next = this->m_CurrentChunk;
+        this->m_CurrentChunk = newChunk;
+    }
+
+    this->m_NumberOfChunks++;
+    this->m_UsedBytes += alignedSize;
+
+    //
+    // The chunk memory is zeroed by the system allocator and it is never reused,
+    // so the block is already zeroed.
+    //
+    return xpf::AlgoAddToPointer(newChunk, sizeof(MonotonicArenaChunk));
+}
+
+void
+XPF_API
+xpf::MonotonicArena::FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // Nothing to do. The memory is given back on Release().
+    //
+    XPF_UNREFERENCED_PARAMETER(MemoryBlock);
+}
+
+void
+XPF_API
+xpf::MonotonicArena::Release(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    MonotonicArenaChunk* chunk = nullptr;
+
+    {
+        xpf::ExclusiveLockGuard guard{ this->m_Lock };
+
+        chunk = this->m_CurrentChunk;
+
+        this->m_CurrentChunk = nullptr;
+        this->m_UsedBytes = 0;
+        this->m_NumberOfChunks = 0;
+    }
+
+    while (nullptr != chunk)
+    {
+        MonotonicArenaChunk* chunkToBeDestroyed = chunk;
+        chunk = chunk->Next;
+
+        xpf::MemoryAllocator::Destruct(chunkToBeDestroyed);
+        (this->m_IsCriticalAllocator) ? xpf::CriticalMemoryAllocator::FreeMemory(chunkToBeDestroyed)
+                                      : xpf::MemoryAllocator::FreeMemory(chunkToBeDestroyed);
+    }
+}
+
+_Ret_maybenull_
+void*
+xpf::MonotonicArena::ContextAllocateMemory(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    return static_cast<xpf::MonotonicArena*>(Context)->AllocateMemory(BlockSize);
+}
+
+void
+xpf::MonotonicArena::ContextFreeMemory(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    static_cast<xpf::MonotonicArena*>(Context)->FreeMemory(MemoryBlock);
+}
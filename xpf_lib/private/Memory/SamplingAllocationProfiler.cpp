@@ -0,0 +1,418 @@
+﻿/**
+ * @file        xpf_lib/private/Memory/SamplingAllocationProfiler.cpp
+ *
+ * @brief       Allocator wrapper which samples allocations and aggregates them
+ *              per call stack, so the heaviest call sites can be found.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+
+/**
+ * @brief   By default all code in here goes into default section.
+ *          We don't want to page out the allocator.
+ */
+XPF_SECTION_DEFAULT;
+
+/**
+ * @brief       Hashes the captured frames (FNV-1a over the addresses).
+ *
+ * @param[in]   Frames - The captured frames.
+ *
+ * @param[in]   FramesCount - How many frames were captured.
+ *
+ * @return      The hash of the frames.
+ */
+static inline uint64_t XPF_API
+XpfProfilerHashFrames(
+    _In_ void* const* Frames,
+    _In_ uint32_t FramesCount
+) noexcept(true)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t i = 0; i < FramesCount; ++i)
+    {
+        hash ^= static_cast<uint64_t>(xpf::AlgoPointerToValue(Frames[i]));
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief       Appends a number to the output.
+ *
+ * @param[in,out]   Output - Where to append.
+ *
+ * @param[in]       Number - The number to be appended.
+ *
+ * @param[in]       Hexadecimal - If true, the number is written in base 16 with a 0x prefix.
+ *
+ * @return      A proper NTSTATUS error code.
+ */
+_Must_inspect_result_
+static inline NTSTATUS XPF_API
+XpfProfilerAppendNumber(
+    _Inout_ xpf::String<char>& Output,
+    _In_ uint64_t Number,
+    _In_ bool Hexadecimal
+) noexcept(true)
+{
+    const char digits[] = "0123456789abcdef";
+    const uint64_t base = (Hexadecimal) ? 16 : 10;
+
+    //
+    // 20 digits are enough for any 64-bit number, plus the prefix.
+    //
+    char buffer[24] = { 0 };
+    size_t position = XPF_ARRAYSIZE(buffer);
+    do
+    {
+        buffer[--position] = digits[Number % base];
+        Number /= base;
+    } while (0 != Number);
+
+    if (Hexadecimal)
+    {
+        buffer[--position] = 'x';
+        buffer[--position] = '0';
+    }
+
+    return Output.Append(xpf::StringView<char>{ &buffer[position], XPF_ARRAYSIZE(buffer) - position });
+}
+
+/**
+ * @brief       Appends the "<count>: <bytes> [<count * rate>: <bytes * rate>] @" prefix of a line.
+ *
+ * @param[in,out]   Output - Where to append.
+ *
+ * @param[in]       Count - The sampled count.
+ *
+ * @param[in]       Bytes - The sampled bytes.
+ *
+ * @param[in]       SampleRate - The rate used to scale the sampled values.
+ *
+ * @return      A proper NTSTATUS error code.
+ */
+_Must_inspect_result_
+static inline NTSTATUS XPF_API
+XpfProfilerAppendCounters(
+    _Inout_ xpf::String<char>& Output,
+    _In_ uint64_t Count,
+    _In_ uint64_t Bytes,
+    _In_ uint32_t SampleRate
+) noexcept(true)
+{
+    NTSTATUS status = XpfProfilerAppendNumber(Output, Count, false);
+    if (NT_SUCCESS(status))
+    {
+        status = Output.Append(": ");
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = XpfProfilerAppendNumber(Output, Bytes, false);
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = Output.Append(" [");
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = XpfProfilerAppendNumber(Output, Count * SampleRate, false);
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = Output.Append(": ");
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = XpfProfilerAppendNumber(Output, Bytes * SampleRate, false);
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = Output.Append("] @");
+    }
+    return status;
+}
+
+bool
+XPF_API
+xpf::SamplingAllocationProfiler::ShouldSample(
+    void
+) noexcept(true)
+{
+    //
+    // If the thread migrates between reading the processor number and the increment,
+    // we just count on another processor's counter. This is fine for sampling.
+    //
+    volatile uint32_t& counter = this->m_Counters[xpf::ApiCurrentProcessorNumber() % PROFILER_MAX_COUNTERS].Get();
+    const uint32_t value = xpf::ApiAtomicIncrement(&counter);
+
+    //
+    // Avoid the division for the usual power of 2 rates.
+    //
+    return (0 != this->m_SampleMask) ? (0 == (value & this->m_SampleMask))
+                                     : (0 == (value % this->m_SampleRate));
+}
+
+void
+XPF_API
+xpf::SamplingAllocationProfiler::RecordSample(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    //
+    // Capture the stack outside of the lock - this is the expensive part.
+    // If the capture fails, the sample is still counted under an empty stack.
+    //
+    void* frames[PROFILER_MAX_FRAMES] = { 0 };
+    uint32_t framesCount = 0;
+    if (!NT_SUCCESS(xpf::ApiCaptureStackBacktrace(frames, PROFILER_MAX_FRAMES, &framesCount)))
+    {
+        framesCount = 0;
+    }
+    const uint64_t hash = XpfProfilerHashFrames(frames, framesCount);
+
+    xpf::ExclusiveLockGuard guard{ this->m_Lock };
+
+    //
+    // The table is allocated on the first sample. It doesn't go through the backing allocator,
+    // so it never shows up in the profile.
+    //
+    if (nullptr == this->m_Table)
+    {
+        this->m_Table = static_cast<ProfilerRecord*>(xpf::ApiAllocateMemory(this->m_TableCapacity * sizeof(ProfilerRecord),
+                                                                            true));
+        if (nullptr == this->m_Table)
+        {
+            this->m_DroppedSamples++;
+            return;
+        }
+    }
+
+    this->m_SampledAllocations++;
+    this->m_SampledBytes += BlockSize;
+
+    //
+    // Linear probing. The capacity is a power of 2.
+    //
+    const size_t mask = this->m_TableCapacity - 1;
+    const size_t maxProbes = (this->m_TableCapacity < PROFILER_MAX_PROBES) ? this->m_TableCapacity
+                                                                          : PROFILER_MAX_PROBES;
+    size_t index = static_cast<size_t>(hash) & mask;
+    for (size_t probe = 0; probe < maxProbes; ++probe)
+    {
+        ProfilerRecord& record = this->m_Table[index];
+
+        if (0 == record.Count)
+        {
+            record.Hash = hash;
+            record.FramesCount = framesCount;
+            xpf::ApiCopyMemory(record.Frames, frames, sizeof(frames));
+
+            record.Count = 1;
+            record.Bytes = BlockSize;
+            this->m_UniqueStacks++;
+            return;
+        }
+        if ((record.Hash == hash) &&
+            (record.FramesCount == framesCount) &&
+            (xpf::ApiEqualMemory(record.Frames, frames, framesCount * sizeof(void*))))
+        {
+            record.Count++;
+            record.Bytes += BlockSize;
+            return;
+        }
+
+        index = (index + 1) & mask;
+    }
+
+    //
+    // The table is too crowded around this slot.
+    //
+    this->m_DroppedSamples++;
+}
+
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+xpf::SamplingAllocationProfiler::AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    void* block = this->m_BackingAllocator.AllocateMemory(BlockSize);
+    if ((nullptr != block) && this->ShouldSample())
+    {
+        this->RecordSample(BlockSize);
+    }
+    return block;
+}
+
+void
+XPF_API
+xpf::SamplingAllocationProfiler::FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    if (nullptr != MemoryBlock)
+    {
+        this->m_BackingAllocator.FreeMemory(MemoryBlock);
+    }
+}
+
+xpf::AllocationProfileStatistics
+XPF_API
+xpf::SamplingAllocationProfiler::GetStatistics(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    xpf::AllocationProfileStatistics statistics;
+    statistics.SampleRate = this->m_SampleRate;
+
+    xpf::ExclusiveLockGuard guard{ this->m_Lock };
+
+    statistics.SampledAllocations = this->m_SampledAllocations;
+    statistics.SampledBytes = this->m_SampledBytes;
+    statistics.UniqueStacks = this->m_UniqueStacks;
+    statistics.DroppedSamples = this->m_DroppedSamples;
+
+    return statistics;
+}
+
+void
+XPF_API
+xpf::SamplingAllocationProfiler::Reset(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    xpf::ExclusiveLockGuard guard{ this->m_Lock };
+
+    if (nullptr != this->m_Table)
+    {
+        xpf::ApiZeroMemory(this->m_Table, this->m_TableCapacity * sizeof(ProfilerRecord));
+    }
+    this->m_SampledAllocations = 0;
+    this->m_SampledBytes = 0;
+    this->m_DroppedSamples = 0;
+    this->m_UniqueStacks = 0;
+}
+
+_Must_inspect_result_
+NTSTATUS
+XPF_API
+xpf::SamplingAllocationProfiler::Dump(
+    _Inout_ xpf::String<char>& Output
+) noexcept(true)
+{
+    XPF_MAX_PASSIVE_LEVEL();
+
+    Output.Reset();
+
+    //
+    // The totals first.
+    //
+    const xpf::AllocationProfileStatistics statistics = this->GetStatistics();
+
+    NTSTATUS status = Output.Append("heap profile: ");
+    if (NT_SUCCESS(status))
+    {
+        status = XpfProfilerAppendCounters(Output,
+                                           statistics.SampledAllocations,
+                                           statistics.SampledBytes,
+                                           statistics.SampleRate);
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = Output.Append(" heap/");
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = XpfProfilerAppendNumber(Output, statistics.SampleRate, false);
+    }
+    if (NT_SUCCESS(status))
+    {
+        status = Output.Append("\n");
+    }
+
+    //
+    // Then a line for each stack. Each record is copied under the lock and appended
+    // without it - the output might be allocated through this very profiler.
+    //
+    for (size_t i = 0; NT_SUCCESS(status) && (i < this->m_TableCapacity); ++i)
+    {
+        ProfilerRecord record;
+        {
+            xpf::ExclusiveLockGuard guard{ this->m_Lock };
+            if (nullptr == this->m_Table)
+            {
+                break;
+            }
+            xpf::ApiCopyMemory(&record, &this->m_Table[i], sizeof(record));
+        }
+        if (0 == record.Count)
+        {
+            continue;
+        }
+
+        status = XpfProfilerAppendCounters(Output,
+                                           record.Count,
+                                           record.Bytes,
+                                           statistics.SampleRate);
+        for (uint32_t frame = 0; NT_SUCCESS(status) && (frame < record.FramesCount); ++frame)
+        {
+            status = Output.Append(" ");
+            if (NT_SUCCESS(status))
+            {
+                status = XpfProfilerAppendNumber(Output,
+                                                 static_cast<uint64_t>(xpf::AlgoPointerToValue(record.Frames[frame])),
+                                                 true);
+            }
+        }
+        if (NT_SUCCESS(status))
+        {
+            status = Output.Append("\n");
+        }
+    }
+
+    if (!NT_SUCCESS(status))
+    {
+        Output.Reset();
+    }
+    return status;
+}
+
+_Ret_maybenull_
+void*
+xpf::SamplingAllocationProfiler::ContextAllocateMemory(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    return static_cast<xpf::SamplingAllocationProfiler*>(Context)->AllocateMemory(BlockSize);
+}
+
+void
+xpf::SamplingAllocationProfiler::ContextFreeMemory(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    static_cast<xpf::SamplingAllocationProfiler*>(Context)->FreeMemory(MemoryBlock);
+}
@@ -0,0 +1,770 @@
+﻿/**
+ * @file        xpf_lib/private/Memory/SlabAllocator.cpp
+ *
+ * @brief       General purpose allocator with geometric size classes.
+ *              Each size class carves slabs into fixed-size blocks
+ *              and keeps its own free list of blocks.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+
+/**
+ * @brief   By default all code in here goes into default section.
+ *          We don't want to page out the allocator.
+ */
+XPF_SECTION_DEFAULT;
+
+
+//
+// ************************************************************************************************
+// This is the section of structures and data definitions.
+// ************************************************************************************************
+//
+
+/**
+ * @brief   The number of size classes: 16, 32, 64, ... 8192.
+ */
+static constexpr size_t XPF_SLAB_NUMBER_OF_CLASSES = 10;
+
+/**
+ * @brief   Marks the sizes which are too big for our classes.
+ */
+static constexpr size_t XPF_SLAB_LARGE_CLASS = ~size_t{ 0 };
+
+/**
+ * @brief   All slabs have this size, and are aligned to it. So the slab owning a block
+ *          is found by masking the block address - the blocks carry no header.
+ */
+static constexpr size_t XPF_SLAB_SIZE = 65536;
+
+/**
+ * @brief   The big blocks are aligned to this. The slab blocks never are - the ones
+ *          which would fall on such a boundary are skipped when the slab is carved.
+ *          This is how FreeMemory tells them apart.
+ */
+static constexpr size_t XPF_SLAB_LARGE_ALIGNMENT = 4096;
+
+/**
+ * @brief   How many per-processor magazines each class has.
+ */
+static constexpr size_t XPF_SLAB_MAX_MAGAZINES = 64;
+
+/**
+ * @brief   How many bytes a magazine caches at most, and the bounds of its capacity in blocks.
+ */
+static constexpr size_t XPF_SLAB_MAGAZINE_BYTES = 65536;
+static constexpr size_t XPF_SLAB_MAGAZINE_MIN_CAPACITY = 4;
+static constexpr size_t XPF_SLAB_MAGAZINE_MAX_CAPACITY = 32;
+
+/**
+ * @brief   This sits at the beginning of each slab. It takes a whole cache line,
+ *          so the first block does not share one with the header.
+ */
+struct alignas(XPF_CACHE_LINE_SIZE) XPF_SLAB_HEADER
+{
+    /**
+     * @brief   The next slab of the same size class.
+     */
+    XPF_SLAB_HEADER* Next;
+
+    /**
+     * @brief   The size class of the blocks from this slab.
+     */
+    size_t ClassIndex;
+
+    /**
+     * @brief   How many blocks from this slab are in the free list.
+     */
+    size_t FreeBlocks;
+
+    /**
+     * @brief   How many blocks this slab was carved into.
+     */
+    size_t TotalBlocks;
+};
+
+/**
+ * @brief   A per-processor cache of free blocks, in front of the size class.
+ *          Same idea as the lookaside list magazines - the blocks move between
+ *          the magazine and the size class in batches, so the class lock is taken
+ *          once per batch instead of once per allocation.
+ */
+struct alignas(XPF_CACHE_LINE_SIZE) XPF_SLAB_MAGAZINE
+{
+    /**
+     * @brief   Guards the magazine. A thread may be migrated to another processor
+     *          while it uses the magazine, so we can't get away without it.
+     */
+    xpf::BusyLock Lock;
+
+    /**
+     * @brief   The top of the stack of free blocks.
+     */
+    xpf::XPF_SINGLE_LIST_ENTRY* Top = nullptr;
+
+    /**
+     * @brief   The number of blocks currently in this magazine.
+     */
+    size_t Count = 0;
+};
+
+/**
+ * @brief   One size class. Aligned to a cache line, so two classes
+ *          used from different threads do not share one.
+ */
+struct alignas(XPF_CACHE_LINE_SIZE) XPF_SLAB_SIZE_CLASS
+{
+    /**
+     * @brief   Guards FreeBlocks, Slabs and the FreeBlocks counters of the slabs.
+     */
+    xpf::BusyLock Lock;
+
+    /**
+     * @brief   The free blocks of this class. The list entry is stored in the block payload.
+     */
+    xpf::XPF_SINGLE_LIST_ENTRY* FreeBlocks = nullptr;
+
+    /**
+     * @brief   All slabs of this class.
+     */
+    XPF_SLAB_HEADER* Slabs = nullptr;
+
+    /**
+     * @brief   The per-processor magazines of this class.
+     */
+    XPF_SLAB_MAGAZINE Magazines[XPF_SLAB_MAX_MAGAZINES];
+};
+
+/**
+ * @brief   The global state of the slab allocator.
+ */
+static XPF_SLAB_SIZE_CLASS gXpfSlabSizeClasses[XPF_SLAB_NUMBER_OF_CLASSES];
+
+/**
+ * @brief   Links the slab allocator in the cache registry.
+ */
+static xpf::CacheRegistryEntry gXpfSlabCacheEntry;
+
+/**
+ * @brief   Set to 1 by the first thread which registers gXpfSlabCacheEntry.
+ */
+alignas(uint32_t) static volatile uint32_t gXpfSlabCacheRegistered = 0;
+
+
+//
+// ************************************************************************************************
+// This is the section containing implementation of internal functions.
+// ************************************************************************************************
+//
+
+/**
+ * @brief       Retrieves the payload size of the given class.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @return      The size of each block of this class. This is also the distance between two blocks.
+ */
+static inline size_t XPF_API
+XpfSlabClassSize(
+    _In_ size_t ClassIndex
+) noexcept(true)
+{
+    return xpf::SlabAllocator::SLAB_MIN_CLASS_SIZE << ClassIndex;
+}
+
+/**
+ * @brief       Retrieves how many blocks a magazine of the given class can hold.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @return      The magazine capacity, in blocks.
+ */
+static inline size_t XPF_API
+XpfSlabMagazineCapacity(
+    _In_ size_t ClassIndex
+) noexcept(true)
+{
+    const size_t capacity = XPF_SLAB_MAGAZINE_BYTES / XpfSlabClassSize(ClassIndex);
+    if (capacity < XPF_SLAB_MAGAZINE_MIN_CAPACITY)
+    {
+        return XPF_SLAB_MAGAZINE_MIN_CAPACITY;
+    }
+    return (capacity > XPF_SLAB_MAGAZINE_MAX_CAPACITY) ? XPF_SLAB_MAGAZINE_MAX_CAPACITY
+                                                       : capacity;
+}
+
+/**
+ * @brief       Finds the smallest class which can hold the requested size.
+ *
+ * @param[in]   BlockSize - The requested size.
+ *
+ * @return      The index of the class, or XPF_SLAB_LARGE_CLASS if the size is too big.
+ */
+static inline size_t XPF_API
+XpfSlabFindClass(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    for (size_t i = 0; i < XPF_SLAB_NUMBER_OF_CLASSES; ++i)
+    {
+        if (BlockSize <= XpfSlabClassSize(i))
+        {
+            return i;
+        }
+    }
+    return XPF_SLAB_LARGE_CLASS;
+}
+
+/**
+ * @brief       Retrieves the slab owning a block.
+ *
+ * @param[in]   MemoryBlock - The block, as it was returned to the caller.
+ *
+ * @return      The header at the base of the owning slab.
+ */
+static inline XPF_SLAB_HEADER* XPF_API
+XpfSlabFromBlock(
+    _In_ void* MemoryBlock
+) noexcept(true)
+{
+    auto blockValue = xpf::AlgoPointerToValue(MemoryBlock);
+    blockValue &= ~static_cast<decltype(blockValue)>(XPF_SLAB_SIZE - 1);
+
+    return reinterpret_cast<XPF_SLAB_HEADER*>(blockValue);
+}
+
+/**
+ * @brief       Retrieves the magazine of the current processor.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @return      The magazine to be used.
+ */
+static inline XPF_SLAB_MAGAZINE& XPF_API
+XpfSlabCurrentMagazine(
+    _In_ size_t ClassIndex
+) noexcept(true)
+{
+    return gXpfSlabSizeClasses[ClassIndex].Magazines[xpf::ApiCurrentProcessorNumber() % XPF_SLAB_MAX_MAGAZINES];
+}
+
+/**
+ * @brief       Allocates a new slab for the given class and carves it into blocks.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @param[out]  FirstBlock - The first block of a NULL-terminated chain with all blocks of the slab.
+ *
+ * @param[out]  LastBlock - The last block of the chain.
+ *
+ * @return      The new slab, or NULL on failure.
+ */
+static XPF_SLAB_HEADER* XPF_API
+XpfSlabCreate(
+    _In_ size_t ClassIndex,
+    _Out_ xpf::XPF_SINGLE_LIST_ENTRY** FirstBlock,
+    _Out_ xpf::XPF_SINGLE_LIST_ENTRY** LastBlock
+) noexcept(true)
+{
+    *FirstBlock = nullptr;
+    *LastBlock = nullptr;
+
+    void* memory = xpf::ApiAllocateMemoryAligned(XPF_SLAB_SIZE, XPF_SLAB_SIZE, false);
+    if (nullptr == memory)
+    {
+        return nullptr;
+    }
+
+    XPF_SLAB_HEADER* slab = static_cast<XPF_SLAB_HEADER*>(memory);
+    slab->Next = nullptr;
+    slab->ClassIndex = ClassIndex;
+    slab->FreeBlocks = 0;
+
+    //
+    // Carve the blocks. We chain them in address order - so the first allocations
+    // from a fresh slab touch consecutive memory. The blocks which would be aligned
+    // like a big block are skipped - only the small classes have such blocks.
+    //
+    const size_t classSize = XpfSlabClassSize(ClassIndex);
+    xpf::XPF_SINGLE_LIST_ENTRY* previous = nullptr;
+
+    for (size_t offset = sizeof(XPF_SLAB_HEADER); offset + classSize <= XPF_SLAB_SIZE; offset += classSize)
+    {
+        if (xpf::AlgoIsNumberAligned(offset, XPF_SLAB_LARGE_ALIGNMENT))
+        {
+            continue;
+        }
+
+        xpf::XPF_SINGLE_LIST_ENTRY* entry = static_cast<xpf::XPF_SINGLE_LIST_ENTRY*>(
+                                            xpf::AlgoAddToPointer(memory, offset));
+        entry->Next = nullptr;
+
+        if (nullptr == previous)
+        {
+            *FirstBlock = entry;
+        }
+        else
+        {
+            previous->Next = entry;
+        }
+        previous = entry;
+        slab->FreeBlocks++;
+    }
+    *LastBlock = previous;
+    slab->TotalBlocks = slab->FreeBlocks;
+
+    return slab;
+}
+
+/**
+ * @brief       Detaches a batch of blocks from the free list of a class.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @param[in]   MaxBlocks - How many blocks to detach at most.
+ *
+ * @param[out]  TakenBlocks - How many blocks were detached.
+ *
+ * @return      A NULL-terminated chain with the detached blocks, or NULL if the class has none.
+ */
+static xpf::XPF_SINGLE_LIST_ENTRY* XPF_API
+XpfSlabTakeBlocks(
+    _In_ size_t ClassIndex,
+    _In_ size_t MaxBlocks,
+    _Out_ size_t* TakenBlocks
+) noexcept(true)
+{
+    XPF_SLAB_SIZE_CLASS& sizeClass = gXpfSlabSizeClasses[ClassIndex];
+    xpf::ExclusiveLockGuard guard{ sizeClass.Lock };
+
+    xpf::XPF_SINGLE_LIST_ENTRY* first = sizeClass.FreeBlocks;
+    xpf::XPF_SINGLE_LIST_ENTRY* last = nullptr;
+    size_t takenBlocks = 0;
+
+    for (xpf::XPF_SINGLE_LIST_ENTRY* crt = first;
+         (nullptr != crt) && (takenBlocks < MaxBlocks);
+         crt = crt->Next)
+    {
+        XpfSlabFromBlock(crt)->FreeBlocks--;
+        last = crt;
+        takenBlocks++;
+    }
+
+    if (nullptr != last)
+    {
+        sizeClass.FreeBlocks = last->Next;
+        last->Next = nullptr;
+    }
+
+    *TakenBlocks = takenBlocks;
+    return (0 == takenBlocks) ? nullptr
+                              : first;
+}
+
+/**
+ * @brief       Gives a chain of blocks back to the free list of a class.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @param[in,out] First - The first block of a NULL-terminated chain. Can be NULL.
+ *
+ * @return      Nothing.
+ */
+static void XPF_API
+XpfSlabGiveBlocks(
+    _In_ size_t ClassIndex,
+    _Inout_opt_ xpf::XPF_SINGLE_LIST_ENTRY* First
+) noexcept(true)
+{
+    if (nullptr == First)
+    {
+        return;
+    }
+
+    XPF_SLAB_SIZE_CLASS& sizeClass = gXpfSlabSizeClasses[ClassIndex];
+    xpf::ExclusiveLockGuard guard{ sizeClass.Lock };
+
+    xpf::XPF_SINGLE_LIST_ENTRY* last = First;
+    while (true)
+    {
+        XpfSlabFromBlock(last)->FreeBlocks++;
+        if (nullptr == last->Next)
+        {
+            break;
+        }
+        last = last->Next;
+    }
+
+    last->Next = sizeClass.FreeBlocks;
+    sizeClass.FreeBlocks = First;
+}
+
+/**
+ * @brief       Gives the blocks from all magazines of a class back to the class.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @return      Nothing.
+ */
+static void XPF_API
+XpfSlabDrainMagazines(
+    _In_ size_t ClassIndex
+) noexcept(true)
+{
+    for (size_t i = 0; i < XPF_SLAB_MAX_MAGAZINES; ++i)
+    {
+        XPF_SLAB_MAGAZINE& magazine = gXpfSlabSizeClasses[ClassIndex].Magazines[i];
+        xpf::XPF_SINGLE_LIST_ENTRY* blocks = nullptr;
+
+        {
+            xpf::ExclusiveLockGuard guard{ magazine.Lock };
+
+            blocks = magazine.Top;
+            magazine.Top = nullptr;
+            magazine.Count = 0;
+        }
+        XpfSlabGiveBlocks(ClassIndex, blocks);
+    }
+}
+
+/**
+ * @brief       Called by the cache registry. The magazines are drained and the unused slabs
+ *              are given back regardless of the level - all their blocks are in the free list,
+ *              so they are idle by definition.
+ *
+ * @param[in]   Context - Unused.
+ *
+ * @param[in]   Level - Unused.
+ *
+ * @return      The number of bytes given back to the system.
+ */
+static size_t
+XpfSlabCacheTrim(
+    _In_ void* Context,
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+    XPF_UNREFERENCED_PARAMETER(Level);
+
+    return xpf::SlabAllocator::ReleaseUnusedSlabs();
+}
+
+/**
+ * @brief       Called by the cache registry.
+ *
+ * @param[in]   Context - Unused.
+ *
+ * @return      The number of bytes held by free blocks - in the slabs and in the magazines.
+ */
+static size_t
+XpfSlabCacheSize(
+    _In_ void* Context
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+
+    size_t cachedBytes = 0;
+    for (size_t classIndex = 0; classIndex < XPF_SLAB_NUMBER_OF_CLASSES; ++classIndex)
+    {
+        XPF_SLAB_SIZE_CLASS& sizeClass = gXpfSlabSizeClasses[classIndex];
+        size_t cachedBlocks = 0;
+
+        for (size_t i = 0; i < XPF_SLAB_MAX_MAGAZINES; ++i)
+        {
+            xpf::ExclusiveLockGuard guard{ sizeClass.Magazines[i].Lock };
+            cachedBlocks += sizeClass.Magazines[i].Count;
+        }
+
+        {
+            xpf::ExclusiveLockGuard guard{ sizeClass.Lock };
+            for (XPF_SLAB_HEADER* slab = sizeClass.Slabs; nullptr != slab; slab = slab->Next)
+            {
+                cachedBlocks += slab->FreeBlocks;
+            }
+        }
+        cachedBytes += cachedBlocks * XpfSlabClassSize(classIndex);
+    }
+    return cachedBytes;
+}
+
+/**
+ * @brief       Registers the slab allocator in the cache registry. Only the first call does it.
+ */
+static inline void XPF_API
+XpfSlabRegisterCache(
+    void
+) noexcept(true)
+{
+    if (0 != xpf::ApiAtomicCompareExchange(&gXpfSlabCacheRegistered, uint32_t{ 1 }, uint32_t{ 0 }))
+    {
+        return;
+    }
+
+    gXpfSlabCacheEntry.Context = nullptr;
+    gXpfSlabCacheEntry.TrimFunction = &XpfSlabCacheTrim;
+    gXpfSlabCacheEntry.SizeFunction = &XpfSlabCacheSize;
+    xpf::ApiRegisterCache(&gXpfSlabCacheEntry);
+}
+
+/**
+ * @brief       Creates a new slab for the given class. One block is handed to the caller,
+ *              the others go to the free list of the class.
+ *
+ * @param[in]   ClassIndex - The index of the class.
+ *
+ * @return      A block from the new slab, or NULL on failure.
+ */
+static xpf::XPF_SINGLE_LIST_ENTRY* XPF_API
+XpfSlabGrow(
+    _In_ size_t ClassIndex
+) noexcept(true)
+{
+    xpf::XPF_SINGLE_LIST_ENTRY* firstBlock = nullptr;
+    xpf::XPF_SINGLE_LIST_ENTRY* lastBlock = nullptr;
+
+    XPF_SLAB_HEADER* slab = XpfSlabCreate(ClassIndex, &firstBlock, &lastBlock);
+    if (nullptr == slab)
+    {
+        return nullptr;
+    }
+    XpfSlabRegisterCache();
+
+    XPF_SLAB_SIZE_CLASS& sizeClass = gXpfSlabSizeClasses[ClassIndex];
+    xpf::ExclusiveLockGuard guard{ sizeClass.Lock };
+
+    slab->Next = sizeClass.Slabs;
+    sizeClass.Slabs = slab;
+
+    if (firstBlock != lastBlock)
+    {
+        lastBlock->Next = sizeClass.FreeBlocks;
+        sizeClass.FreeBlocks = firstBlock->Next;
+    }
+
+    firstBlock->Next = nullptr;
+    slab->FreeBlocks--;
+    return firstBlock;
+}
+
+
+//
+// ************************************************************************************************
+// This is the section containing the slab allocator implementation.
+// ************************************************************************************************
+//
+
+_Check_return_
+_Ret_maybenull_
+void*
+xpf::SlabAllocator::AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_MAX_APC_LEVEL();
+
+    const size_t classIndex = XpfSlabFindClass(BlockSize);
+
+    //
+    // Too big for our classes - go to the system directly. The block is aligned
+    // so FreeMemory knows where it comes from. It is already zeroed.
+    //
+    if (XPF_SLAB_LARGE_CLASS == classIndex)
+    {
+        return xpf::ApiAllocateMemoryAligned(BlockSize, XPF_SLAB_LARGE_ALIGNMENT, false);
+    }
+
+    //
+    // First the magazine of this processor. When it is empty, we refill half of it
+    // with a batch from the class.
+    //
+    XPF_SLAB_MAGAZINE& magazine = XpfSlabCurrentMagazine(classIndex);
+    xpf::XPF_SINGLE_LIST_ENTRY* block = nullptr;
+    {
+        xpf::ExclusiveLockGuard guard{ magazine.Lock };
+
+        if (0 == magazine.Count)
+        {
+            magazine.Top = XpfSlabTakeBlocks(classIndex,
+                                             XpfSlabMagazineCapacity(classIndex) / 2,
+                                             &magazine.Count);
+        }
+        if (0 != magazine.Count)
+        {
+            block = magazine.Top;
+            magazine.Top = block->Next;
+            magazine.Count--;
+        }
+    }
+
+    //
+    // No free blocks - create a new slab outside of the magazine lock.
+    // If we race with someone else, we'll just have more free blocks.
+    //
+    if (nullptr == block)
+    {
+        block = XpfSlabGrow(classIndex);
+        if (nullptr == block)
+        {
+            return nullptr;
+        }
+    }
+
+    //
+    // Don't leave garbage - same as the system allocator, the memory is zeroed.
+    //
+    xpf::ApiZeroMemory(block, BlockSize);
+    return block;
+}
+
+void
+xpf::SlabAllocator::FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_MAX_APC_LEVEL();
+
+    //
+    // Can't free null block...
+    //
+    if (nullptr == MemoryBlock)
+    {
+        return;
+    }
+
+    //
+    // The big blocks are aligned to XPF_SLAB_LARGE_ALIGNMENT. The slab blocks never are.
+    //
+    const auto blockValue = xpf::AlgoPointerToValue(MemoryBlock);
+    if (xpf::AlgoIsNumberAligned(blockValue, static_cast<decltype(blockValue)>(XPF_SLAB_LARGE_ALIGNMENT)))
+    {
+        xpf::ApiFreeMemoryAligned(MemoryBlock);
+        return;
+    }
+
+    //
+    // This is likely a block which was not allocated by us.
+    //
+    const size_t classIndex = XpfSlabFromBlock(MemoryBlock)->ClassIndex;
+    XPF_DEATH_ON_FAILURE(classIndex < XPF_SLAB_NUMBER_OF_CLASSES);
+
+    xpf::XPF_SINGLE_LIST_ENTRY* entry = static_cast<xpf::XPF_SINGLE_LIST_ENTRY*>(MemoryBlock);
+    const size_t magazineCapacity = XpfSlabMagazineCapacity(classIndex);
+    xpf::XPF_SINGLE_LIST_ENTRY* spilledBlocks = nullptr;
+
+    //
+    // The block goes to the magazine of this processor. When the magazine is full,
+    // we first spill half of it to the class, so we touch the class only once per batch.
+    //
+    XPF_SLAB_MAGAZINE& magazine = XpfSlabCurrentMagazine(classIndex);
+    {
+        xpf::ExclusiveLockGuard guard{ magazine.Lock };
+
+        if (magazine.Count >= magazineCapacity)
+        {
+            xpf::XPF_SINGLE_LIST_ENTRY* spillLast = magazine.Top;
+            for (size_t i = 1; i < magazineCapacity / 2; ++i)
+            {
+                spillLast = spillLast->Next;
+            }
+
+            spilledBlocks = magazine.Top;
+            magazine.Top = spillLast->Next;
+            magazine.Count -= magazineCapacity / 2;
+            spillLast->Next = nullptr;
+        }
+
+        entry->Next = magazine.Top;
+        magazine.Top = entry;
+        magazine.Count++;
+    }
+
+    //
+    // The spilled blocks are handled outside the magazine lock.
+    //
+    XpfSlabGiveBlocks(classIndex, spilledBlocks);
+}
+
+size_t
+XPF_API
+xpf::SlabAllocator::ReleaseUnusedSlabs(
+    void
+) noexcept(true)
+{
+    XPF_MAX_APC_LEVEL();
+
+    size_t releasedBytes = 0;
+
+    for (size_t classIndex = 0; classIndex < XPF_SLAB_NUMBER_OF_CLASSES; ++classIndex)
+    {
+        XPF_SLAB_SIZE_CLASS& sizeClass = gXpfSlabSizeClasses[classIndex];
+        XPF_SLAB_HEADER* unusedSlabs = nullptr;
+
+        //
+        // The blocks cached in the magazines would keep their slabs alive.
+        //
+        XpfSlabDrainMagazines(classIndex);
+
+        {
+            xpf::ExclusiveLockGuard guard{ sizeClass.Lock };
+
+            //
+            // First unlink the blocks of unused slabs from the free list.
+            //
+            xpf::XPF_SINGLE_LIST_ENTRY** link = &sizeClass.FreeBlocks;
+            while (nullptr != *link)
+            {
+                const XPF_SLAB_HEADER* slab = XpfSlabFromBlock(*link);
+                if (slab->FreeBlocks == slab->TotalBlocks)
+                {
+                    *link = (*link)->Next;
+                }
+                else
+                {
+                    link = &((*link)->Next);
+                }
+            }
+
+            //
+            // Then unlink the unused slabs themselves.
+            //
+            XPF_SLAB_HEADER** slabLink = &sizeClass.Slabs;
+            while (nullptr != *slabLink)
+            {
+                XPF_SLAB_HEADER* slab = *slabLink;
+                if (slab->FreeBlocks == slab->TotalBlocks)
+                {
+                    *slabLink = slab->Next;
+
+                    slab->Next = unusedSlabs;
+                    unusedSlabs = slab;
+                }
+                else
+                {
+                    slabLink = &slab->Next;
+                }
+            }
+        }
+
+        //
+        // And free them outside of the lock.
+        //
+        while (nullptr != unusedSlabs)
+        {
+            XPF_SLAB_HEADER* slab = unusedSlabs;
+            unusedSlabs = unusedSlabs->Next;
+
+            xpf::ApiFreeMemoryAligned(slab);
+            releasedBytes += XPF_SLAB_SIZE;
+        }
+    }
+    return releasedBytes;
+}
@@ -0,0 +1,130 @@
+﻿/**
+ * @file        xpf_lib/private/Multithreading/CacheTrimmer.cpp
+ *
+ * @brief       A background thread which periodically trims the caches
+ *              registered in the cache registry.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_lib/xpf.hpp"
+
+/**
+ * @brief   By default all code in here goes into default section.
+ */
+XPF_SECTION_DEFAULT;
+
+
+void
+XPF_API
+xpf::CacheTrimmer::Stop(
+    void
+) noexcept(true)
+{
+    XPF_MAX_PASSIVE_LEVEL();
+
+    if (this->m_StopSignal.HasValue())
+    {
+        (*this->m_StopSignal).Set();
+    }
+    if (this->m_Thread.IsJoinable())
+    {
+        this->m_Thread.Join();
+    }
+}
+
+void
+XPF_API
+xpf::CacheTrimmer::TrimmerCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    XPF_MAX_PASSIVE_LEVEL();
+
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    xpf::CacheTrimmer* trimmer = static_cast<xpf::CacheTrimmer*>(Context);
+
+    while (!(*trimmer->m_StopSignal).Wait(trimmer->m_PeriodInMilliseconds))
+    {
+        //
+        // Over budget, everything goes. Otherwise only what was not used during the last period.
+        //
+        if ((0 != trimmer->m_MemoryBudget) && (xpf::ApiCachedBytes() > trimmer->m_MemoryBudget))
+        {
+            (void) xpf::ApiTrimCaches(xpf::CacheTrimLevel::Full);
+            xpf::ApiAtomicIncrement(&trimmer->m_FullTrims);
+        }
+        else
+        {
+            (void) xpf::ApiTrimCaches(xpf::CacheTrimLevel::Idle);
+        }
+        xpf::ApiAtomicIncrement(&trimmer->m_Passes);
+    }
+}
+
+_Must_inspect_result_
+NTSTATUS
+XPF_API
+xpf::CacheTrimmer::Create(
+    _Inout_ xpf::Optional<xpf::CacheTrimmer>* TrimmerToCreate,
+    _In_ size_t MemoryBudget,
+    _In_ uint32_t PeriodInMilliseconds
+) noexcept(true)
+{
+    XPF_MAX_PASSIVE_LEVEL();
+
+    NTSTATUS status = STATUS_UNSUCCESSFUL;
+
+    //
+    // We will not initialize over an already initialized trimmer.
+    // Assert here and bail early.
+    //
+    if ((nullptr == TrimmerToCreate) || (TrimmerToCreate->HasValue()))
+    {
+        XPF_DEATH_ON_FAILURE(false);
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (0 == PeriodInMilliseconds)
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    TrimmerToCreate->Emplace();
+    if (!TrimmerToCreate->HasValue())
+    {
+        XPF_DEATH_ON_FAILURE(false);
+        return STATUS_NO_DATA_DETECTED;
+    }
+    xpf::CacheTrimmer& newTrimmer = (*(*TrimmerToCreate));
+
+    newTrimmer.m_MemoryBudget = MemoryBudget;
+    newTrimmer.m_PeriodInMilliseconds = PeriodInMilliseconds;
+
+    status = xpf::Signal::Create(&newTrimmer.m_StopSignal, true);
+    if (!NT_SUCCESS(status))
+    {
+        goto Exit;
+    }
+
+    //
+    // The thread is started last - it uses all of the above.
+    //
+    status = newTrimmer.m_Thread.Run(xpf::CacheTrimmer::TrimmerCallback, &newTrimmer);
+
+Exit:
+    if (!NT_SUCCESS(status))
+    {
+        TrimmerToCreate->Reset();
+        XPF_DEATH_ON_FAILURE(!TrimmerToCreate->HasValue());
+    }
+    else
+    {
+        XPF_DEATH_ON_FAILURE(TrimmerToCreate->HasValue());
+    }
+    return status;
+}
@@ -34,13 +34,13 @@ xpf::RundownProtection::Acquire(
 {
     XPF_MAX_DISPATCH_LEVEL();
 
+    //
+    // Grab the current value of rundown. A plain read is enough - the exchange below validates it.
+    //
+    uint64_t currentValue = this->m_Rundown.Get().Load(xpf::MemoryOrder::Relaxed);
+
     while (true)
     {
-        //
-        // Grab the current value of rundown.
-        //
-        const uint64_t currentValue = xpf::ApiAtomicCompareExchange(&this->m_Rundown, uint64_t{0}, uint64_t{ 0 });
-
         //
         // The parity bit is used to check if the Rundown is active => no further access is allowed.
         //
@@ -56,6 +56,7 @@ xpf::RundownProtection::Acquire(
         if ((xpf::NumericLimits<uint64_t>::MaxValue() - this->RUNDOWN_INCREMENT) <= currentValue)
         {
             xpf::ApiYieldProcesor();
+            currentValue = this->m_Rundown.Get().Load(xpf::MemoryOrder::Relaxed);
             continue;
         }
 
@@ -66,10 +67,11 @@ xpf::RundownProtection::Acquire(
         XPF_DEATH_ON_FAILURE((newValue & this->RUNDOWN_ACTIVE) == 0);
 
         //
-        // Atomic swap - ApiAtomicCompareExchange returns the original value.
+        // Atomic swap - on failure currentValue receives the new value of the rundown.
         // If we managed to acquire the rundown we are done, otherwise we retry.
+        // The accesses to the protected object can't move before this.
         //
-        if (currentValue == xpf::ApiAtomicCompareExchange(&this->m_Rundown, newValue, currentValue))
+        if (this->m_Rundown.Get().CompareExchange(currentValue, newValue, xpf::MemoryOrder::Acquire))
         {
             return true;
         }
@@ -90,13 +92,13 @@ xpf::RundownProtection::Release(
 {
     XPF_MAX_DISPATCH_LEVEL();
 
+    //
+    // Grab the current value of rundown. A plain read is enough - the exchange below validates it.
+    //
+    uint64_t currentValue = this->m_Rundown.Get().Load(xpf::MemoryOrder::Relaxed);
+
     while (true)
     {
-        //
-        // Grab the current value of rundown.
-        //
-        const uint64_t currentValue = xpf::ApiAtomicCompareExchange(&this->m_Rundown, uint64_t{0}, uint64_t{ 0 });
-
         //
         // We increment with an increment of 2.
         // We shouldn't be below 2. This is an invalid usage.
@@ -113,19 +115,13 @@ xpf::RundownProtection::Release(
         const uint64_t newValue = currentValue - this->RUNDOWN_INCREMENT;
 
         //
-        // Atomic swap - ApiAtomicCompareExchange returns the original value.
-        // If we managed to acquire the rundown we are done, otherwise we retry.
+        // Atomic swap - on failure currentValue receives the new value of the rundown.
+        // The accesses to the protected object can't move after this.
         //
-        if (currentValue == xpf::ApiAtomicCompareExchange(&this->m_Rundown, newValue, currentValue))
+        if (this->m_Rundown.Get().CompareExchange(currentValue, newValue, xpf::MemoryOrder::Release))
         {
             return;
         }
-
-        //
-        // Somebody else changed the rundown.
-        // No biggie, try again.
-        //
-        continue;
     }
 }
 
@@ -143,52 +139,22 @@ xpf::RundownProtection::WaitForRelease(
 {
     XPF_MAX_APC_LEVEL();
 
-    while (true)
+    //
+    // We need to set the rundown bit to prevent further access.
+    // If it was already set, somebody else did it - we'll wait all the same.
+    //
+    (void) this->m_Rundown.Get().FetchOr(this->RUNDOWN_ACTIVE, xpf::MemoryOrder::AcquireRelease);
+
+    //
+    // The rundown is released when the value is 1 (only the active bit is set).
+    // Polling with plain reads does not steal the cache line from the releasing threads.
+    //
+    while (this->m_Rundown.Get().Load(xpf::MemoryOrder::Acquire) != this->RUNDOWN_ACTIVE)
     {
         //
-        // Grab the current value of rundown.
-        //
-        const uint64_t currentValue = xpf::ApiAtomicCompareExchange(&this->m_Rundown, uint64_t{0}, uint64_t{ 0 });
-
-        //
-        // If the rundown bit is set, we wait for rundown to be released.
-        // the rundown is released when the value is 1 (only the active bit is set).
-        // We did not set the bit, so somebody else did. We'll wait here.
+        // Relinquish the resources to allow another thread to run.
+        // This value is small enough so we allow fast response.
         //
-        if ((currentValue & this->RUNDOWN_ACTIVE) != 0)
-        {
-            while (this->m_Rundown != this->RUNDOWN_ACTIVE)
-            {
-                //
-                // Relinquish the resources to allow another thread to run.
-                // This value is small enough so we allow fast response.
-                //
-                xpf::ApiSleep(100);
-            }
-            break;
-        }
-
-        //
-        // We need to set the rundown bit to prevent further access.
-        //
-        const uint64_t newValue = currentValue | this->RUNDOWN_ACTIVE;
-
-        //
-        // Atomic swap - ApiAtomicCompareExchange returns the original value.
-        // If we managed to acquire the rundown we are done, otherwise we retry.
-        //
-        if (currentValue == xpf::ApiAtomicCompareExchange(&this->m_Rundown, newValue, currentValue))
-        {
-            //
-            // Spin again, as we'll enter the check above.
-            //
-            XPF_NOTHING();
-        }
-
-        //
-        // Somebody else changed the rundown.
-        // No biggie, try again.
-        //
-        continue;
+        xpf::ApiSleep(100);
     }
 }
@@ -47,12 +47,11 @@ xpf::ThreadPool::CreateWorkItem(
     //
     // Work items will be stored in non-paged memory. They are critical allocations.
     //
-    workItem = static_cast<ThreadPoolWorkItem*>(this->m_WorkItemAllocator.AllocateMemory(sizeof(*workItem)));
+    workItem = this->m_WorkItemPool.Acquire();
     if (nullptr == workItem)
     {
         return STATUS_INSUFFICIENT_RESOURCES;
     }
-    xpf::MemoryAllocator::Construct(workItem);
 
     //
     // Now initialize the work item properly.
@@ -97,9 +96,7 @@ xpf::ThreadPool::DestroyWorkItem(
     //
     // Destroy the work item.
     //
-    xpf::MemoryAllocator::Destruct(workItem);
-
-    this->m_WorkItemAllocator.FreeMemory(workItem);
+    this->m_WorkItemPool.Release(workItem);
     workItem = nullptr;
 }
 
@@ -283,6 +280,43 @@ xpf::ThreadPool::Rundown(
     this->m_RoundRobinIndex = 0;
 }
 
+_Must_inspect_result_
+NTSTATUS
+XPF_API
+xpf::ThreadPool::Grow(
+    _In_ size_t NumberOfThreads
+) noexcept(true)
+{
+    XPF_MAX_PASSIVE_LEVEL();
+
+    if (NumberOfThreads > xpf::ThreadPool::MAX_THREAD_QUOTA)
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // The workers can spawn threads as well, so we check the size again after each creation.
+    //
+    while (true)
+    {
+        size_t numberOfThreads = 0;
+        {
+            xpf::SharedLockGuard guard{ this->m_ThreadsLock };
+            numberOfThreads = this->m_Threads.Size();
+        }
+        if (numberOfThreads >= NumberOfThreads)
+        {
+            return STATUS_SUCCESS;
+        }
+
+        const NTSTATUS status = this->CreateThreadContext();
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+}
+
 _Must_inspect_result_
 NTSTATUS
 xpf::ThreadPool::CreateThreadContext(
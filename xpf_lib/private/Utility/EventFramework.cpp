@@ -60,13 +60,9 @@ xpf::EventBus::NotifyListeners(
     }
 
     //
-    // Grab a reference to the current listeners list.
+    // Grab a reference to the current listeners list. This takes no lock.
     //
-    xpf::SharedPointer<ListenersList> listenersSnapshot;
-    {
-        xpf::SharedLockGuard listenersLock{ this->m_ListenersLock };
-        listenersSnapshot = this->m_Listeners;
-    }
+    xpf::SharedPointer<ListenersList> listenersSnapshot = this->m_Listeners.Load();
 
     //
     // No listener was registered, so we have nothing to do.
@@ -120,14 +116,14 @@ xpf::EventBus::Rundown(
     this->m_EventBusRundown.WaitForRelease();
 
     //
-    // First we acquire the listeners lock - this will prevent other operations while we are working.
-    // We run down the listeners with the shared lock guard taken as we'll not modify the listeners list lock.
+    // No other updates can happen now, as the bus was run down.
+    // We run down the listeners from the current snapshot.
     //
     {
-        xpf::SharedLockGuard listenersGuard{ this->m_ListenersLock };
-        if (!this->m_Listeners.IsEmpty())
+        xpf::SharedPointer<ListenersList> listenersSnapshot = this->m_Listeners.Load();
+        if (!listenersSnapshot.IsEmpty())
         {
-            xpf::EventBus::ListenersList& listenersList = (*this->m_Listeners);
+            xpf::EventBus::ListenersList& listenersList = (*listenersSnapshot);
             for (size_t i = 0; i < listenersList.Size(); ++i)
             {
                 xpf::SharedPointer<xpf::EventListenerData> currentListener = listenersList[i];
@@ -144,7 +140,7 @@ xpf::EventBus::Rundown(
     //
     {
         xpf::ExclusiveLockGuard listenersGuard{ this->m_ListenersLock };
-        this->m_Listeners.Reset();
+        this->m_Listeners.Store(xpf::SharedPointer<ListenersList>{});
     }
 }
 
@@ -178,7 +174,7 @@ xpf::EventBus::RegisterListener(
     //
     // Now we create the event data listener structure.
     //
-    auto listenerDataSharedPtr = xpf::MakeSharedWithAllocator<xpf::EventListenerData>(this->m_Listeners.GetAllocator());
+    auto listenerDataSharedPtr = xpf::MakeSharedWithAllocator<xpf::EventListenerData>(XPF_EVENT_FRAMEWORK_ALLOCATOR);
     if (listenerDataSharedPtr.IsEmpty())
     {
         return STATUS_INSUFFICIENT_RESOURCES;
@@ -216,7 +212,7 @@ xpf::EventBus::RegisterListener(
     //
     // Now we need to replace the listeners list with the cloned one.
     //
-    this->m_Listeners = newListenersList;
+    this->m_Listeners.Store(newListenersList);
     xpf::ApiCopyMemory(ListenerId, &listenerData.Id, sizeof(listenerData.Id));
 
     return STATUS_SUCCESS;
@@ -244,17 +240,17 @@ xpf::EventBus::UnregisterListener(
     }
 
     //
-    // Frist we acquire the listeners lock - this will prevent other operations while we are working.
-    // We run down the listener with the shared lock guard taken as we'll not modify the listeners list lock.
+    // Frist we grab the current listeners - this takes no lock.
+    // We run down the listener from this snapshot.
     // This will still allow other events to be dispatched.
     //
     {
-        xpf::SharedLockGuard listenersGuard{ this->m_ListenersLock };
-        if (this->m_Listeners.IsEmpty())
+        xpf::SharedPointer<ListenersList> listenersSnapshot = this->m_Listeners.Load();
+        if (listenersSnapshot.IsEmpty())
         {
             return STATUS_NOT_FOUND;
         }
-        xpf::EventBus::ListenersList& currentListenersList = (*this->m_Listeners);
+        xpf::EventBus::ListenersList& currentListenersList = (*listenersSnapshot);
 
         for (size_t i = 0; i < currentListenersList.Size(); ++i)
         {
@@ -291,7 +287,7 @@ xpf::EventBus::UnregisterListener(
         xpf::SharedPointer<ListenersList> newListenersList = this->CloneListeners();
         if (!newListenersList.IsEmpty())
         {
-            this->m_Listeners = newListenersList;
+            this->m_Listeners.Store(newListenersList);
         }
     }
 
@@ -311,7 +307,7 @@ xpf::EventBus::CloneListeners(
     //
     // On insufficient resources, return empty list.
     //
-    clone = xpf::MakeSharedWithAllocator<xpf::EventBus::ListenersList>(this->m_Listeners.GetAllocator());
+    clone = xpf::MakeSharedWithAllocator<xpf::EventBus::ListenersList>(XPF_EVENT_FRAMEWORK_ALLOCATOR);
     if (clone.IsEmpty())
     {
         return clone;
@@ -320,11 +316,12 @@ xpf::EventBus::CloneListeners(
     //
     // If the current list is empty, we're done - return the empty clone.
     //
-    if (this->m_Listeners.IsEmpty())
+    xpf::SharedPointer<xpf::EventBus::ListenersList> currentListenersSnapshot = this->m_Listeners.Load();
+    if (currentListenersSnapshot.IsEmpty())
     {
         return clone;
     }
-    xpf::EventBus::ListenersList& currentListeners = (*this->m_Listeners);
+    xpf::EventBus::ListenersList& currentListeners = (*currentListenersSnapshot);
 
     for (size_t i = 0; i < currentListeners.Size(); ++i)
     {
@@ -351,7 +348,7 @@ xpf::EventBus::CloneListeners(
         //
         // If any allocation is failing, we return an empty list.
         //
-        auto newListenerSharedPtr = xpf::MakeSharedWithAllocator<xpf::EventListenerData>(this->m_Listeners.GetAllocator());
+        auto newListenerSharedPtr = xpf::MakeSharedWithAllocator<xpf::EventListenerData>(XPF_EVENT_FRAMEWORK_ALLOCATOR);
         if (newListenerSharedPtr.IsEmpty())
         {
             clone.Reset();
@@ -775,7 +775,9 @@ ParseSymbolsFromStream(
     XPF_MAX_PASSIVE_LEVEL();
 
     NTSTATUS status = STATUS_UNSUCCESSFUL;
-    xpf::Buffer defragmentedStream{ Symbols.GetAllocator() };
+
+    /* The symbols stream can be big and it is only needed while parsing - keep it out of the heap. */
+    xpf::Buffer defragmentedStream{ XPF_LARGE_BLOCK_ALLOCATOR };
 
     /* Make stream continuous. */
     status = xpf::pdb::DefragmentStream(PdbHeader,
@@ -819,7 +821,7 @@ ExtractSymbols(
     NTSTATUS status = STATUS_UNSUCCESSFUL;
 
     xpf::Buffer directoryStreamBuffer{ Symbols->GetAllocator() };
-    xpf::Buffer debugInfoStreamBuffer{ Symbols->GetAllocator() };
+    xpf::Buffer debugInfoStreamBuffer{ XPF_LARGE_BLOCK_ALLOCATOR };
     xpf::Vector<xpf::pdb::DebugInformationModuleInfoEntry> modules{ Symbols->GetAllocator() };
     xpf::Vector<xpf::pdb::ImageSectionHeader> sectionHeaders{ Symbols->GetAllocator() };
 
@@ -925,22 +927,20 @@ ExtractSymbols(
                         return Left.SymbolRVA < Right.SymbolRVA;
                   });
 
-    /* Also remove duplicates - Now that they are sorted we can easily do so. */
-    for (size_t i = 1; i < Symbols->Size(); )
-    {
-        if ((*Symbols)[i].SymbolRVA == (*Symbols)[i - 1].SymbolRVA)
-        {
-            status = Symbols->Erase(i);
-            if (!NT_SUCCESS(status))
-            {
-                return status;
-            }
-        }
-        else
-        {
-            i++;
-        }
-    }
+    /* Also remove duplicates - Now that they are sorted we can easily do so in a single pass. */
+    /* The predicate is called in order, so we only need to remember the last kept RVA. */
+    bool hasPreviousSymbol = false;
+    uint32_t previousSymbolRVA = 0;
+    (void) Symbols->EraseIf([&](const xpf::pdb::SymbolInformation& Symbol)
+                            {
+                                if (hasPreviousSymbol && Symbol.SymbolRVA == previousSymbolRVA)
+                                {
+                                    return true;
+                                }
+                                hasPreviousSymbol = true;
+                                previousSymbolRVA = Symbol.SymbolRVA;
+                                return false;
+                            });
 
     return STATUS_SUCCESS;
 }
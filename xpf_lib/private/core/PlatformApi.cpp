@@ -309,6 +309,299 @@ xpf::ApiAllocateMemory(
     return block;
 }
 
+void
+XPF_API
+xpf::ApiFreeMemoryAligned(
+    _Inout_opt_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // Sanity checks.
+    //
+    if (nullptr == MemoryBlock)
+    {
+        return;
+    }
+
+    #if defined XPF_PLATFORM_LINUX_UM
+        ::free(MemoryBlock);
+    #elif defined XPF_PLATFORM_WIN_KM || defined XPF_PLATFORM_WIN_UM
+        //
+        // The original block is stored right before the aligned one.
+        //
+        void** originalBlock = static_cast<void**>(MemoryBlock) - 1;
+        xpf::ApiFreeMemory(*originalBlock);
+    #else
+        #error Unknown Platform!
+    #endif
+
+    MemoryBlock = nullptr;
+}
+
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+xpf::ApiAllocateMemoryAligned(
+    _In_ size_t BlockSize,
+    _In_ size_t Alignment,
+    _In_ bool CriticalAllocation
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // The alignment must be a power of 2. We never go below the default one.
+    //
+    if ((0 == Alignment) || (0 != (Alignment & (Alignment - 1))))
+    {
+        return nullptr;
+    }
+    if (Alignment < XPF_DEFAULT_ALIGNMENT)
+    {
+        Alignment = XPF_DEFAULT_ALIGNMENT;
+    }
+
+    //
+    // Avoid 0-size allocations and round the size up to whole alignment units.
+    // We need room for one more unit for the platforms without native support.
+    //
+    if (BlockSize == 0)
+    {
+        BlockSize = 1;
+    }
+    if (BlockSize > xpf::NumericLimits<size_t>::MaxValue() - 2 * Alignment)
+    {
+        return nullptr;
+    }
+    const size_t alignedSize = xpf::AlgoAlignValueUp(BlockSize, Alignment);
+
+    #if defined XPF_PLATFORM_LINUX_UM
+        void* block = nullptr;
+        size_t retries = 0;
+
+        while ((nullptr == block) && (retries < 5))
+        {
+            block = ::aligned_alloc(Alignment,
+                                    alignedSize);
+            if ((nullptr != block) || (!CriticalAllocation))
+            {
+                break;
+            }
+            ++retries;
+        }
+
+        if (nullptr != block)
+        {
+            xpf::ApiZeroMemory(block, alignedSize);
+        }
+        return block;
+    #elif defined XPF_PLATFORM_WIN_KM || defined XPF_PLATFORM_WIN_UM
+        //
+        // There is no aligned variant for pool or heap allocations, so we allocate an extra unit.
+        // The block is at least XPF_DEFAULT_ALIGNMENT aligned, so an extra unit always leaves
+        // enough room before the aligned address to store the original block.
+        //
+        static_assert(XPF_DEFAULT_ALIGNMENT >= sizeof(void*), "We need room for the original block!");
+
+        void* originalBlock = xpf::ApiAllocateMemory(alignedSize + Alignment,
+                                                     CriticalAllocation);
+        if (nullptr == originalBlock)
+        {
+            return nullptr;
+        }
+
+        auto originalValue = xpf::AlgoPointerToValue(originalBlock);
+        auto alignedValue = xpf::AlgoAlignValueUp(originalValue + sizeof(void*),
+                                                  static_cast<decltype(originalValue)>(Alignment));
+        void* block = xpf::AlgoAddToPointer(originalBlock, static_cast<size_t>(alignedValue - originalValue));
+
+        *(static_cast<void**>(block) - 1) = originalBlock;
+        return block;
+    #else
+        #error Unknown Platform!
+    #endif
+}
+
+/**
+ * @brief   The size of a huge page. Smaller blocks gain nothing from huge pages.
+ */
+static constexpr size_t XPF_LARGE_PAGE_SIZE = size_t{ 2 } * 1024 * 1024;
+
+/**
+ * @brief       Retrieves the size of a page.
+ *
+ * @return      The size of a page. Always a power of 2.
+ */
+static inline size_t XPF_API
+XpfPageSize(
+    void
+) noexcept(true)
+{
+    #if defined XPF_PLATFORM_LINUX_UM
+        const long pageSize = sysconf(_SC_PAGESIZE);
+        return (pageSize > 0) ? static_cast<size_t>(pageSize)
+                              : size_t{ 4096 };
+    #else
+        return size_t{ PAGE_SIZE };
+    #endif
+}
+
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+xpf::ApiAllocatePages(
+    _In_ size_t BlockSize,
+    _In_ bool UseLargePages
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    const size_t pageSize = XpfPageSize();
+
+    //
+    // Avoid 0-size allocations and round the size up to whole pages.
+    //
+    if (BlockSize == 0)
+    {
+        BlockSize = 1;
+    }
+    if (BlockSize > xpf::NumericLimits<size_t>::MaxValue() - pageSize - XPF_LARGE_PAGE_SIZE)
+    {
+        return nullptr;
+    }
+    const size_t mappedSize = xpf::AlgoAlignValueUp(BlockSize, pageSize);
+
+    #if defined XPF_PLATFORM_WIN_KM
+        //
+        // Big pool allocations are already page aligned and given back to the system on free.
+        //
+        XPF_UNREFERENCED_PARAMETER(UseLargePages);
+        return xpf::ApiAllocateMemory(mappedSize, false);
+    #elif defined XPF_PLATFORM_WIN_UM
+        //
+        // Large pages require SeLockMemoryPrivilege, which we can't assume. So we ignore the hint.
+        //
+        XPF_UNREFERENCED_PARAMETER(UseLargePages);
+        return ::VirtualAlloc(NULL,
+                              mappedSize,
+                              MEM_RESERVE | MEM_COMMIT,
+                              PAGE_READWRITE);
+    #elif defined XPF_PLATFORM_LINUX_UM
+        //
+        // Transparent huge pages can only back huge page aligned ranges.
+        // Recent kernels already align big anonymous mappings, so we first try the exact size.
+        //
+        const bool useLargePages = UseLargePages && (mappedSize >= XPF_LARGE_PAGE_SIZE);
+
+        void* mapping = ::mmap(NULL,
+                               mappedSize,
+                               PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS,
+                               -1,
+                               0);
+        if (MAP_FAILED == mapping)
+        {
+            return nullptr;
+        }
+        if (!useLargePages)
+        {
+            return mapping;
+        }
+
+        auto mappingValue = xpf::AlgoPointerToValue(mapping);
+        void* block = mapping;
+
+        if (!xpf::AlgoIsNumberAligned(mappingValue, static_cast<decltype(mappingValue)>(XPF_LARGE_PAGE_SIZE)))
+        {
+            //
+            // Not aligned. Map it again with just enough slack to fit an aligned block -
+            // the mapping is already page aligned - and unmap the unaligned head and tail.
+            //
+            (void) ::munmap(mapping, mappedSize);
+
+            const size_t requestedSize = mappedSize + XPF_LARGE_PAGE_SIZE - pageSize;
+            mapping = ::mmap(NULL,
+                             requestedSize,
+                             PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS,
+                             -1,
+                             0);
+            if (MAP_FAILED == mapping)
+            {
+                return nullptr;
+            }
+
+            mappingValue = xpf::AlgoPointerToValue(mapping);
+            auto alignedValue = xpf::AlgoAlignValueUp(mappingValue,
+                                                      static_cast<decltype(mappingValue)>(XPF_LARGE_PAGE_SIZE));
+            const size_t headSize = static_cast<size_t>(alignedValue - mappingValue);
+            const size_t tailSize = requestedSize - headSize - mappedSize;
+
+            block = xpf::AlgoAddToPointer(mapping, headSize);
+            if (0 != headSize)
+            {
+                (void) ::munmap(mapping, headSize);
+            }
+            if (0 != tailSize)
+            {
+                (void) ::munmap(xpf::AlgoAddToPointer(block, mappedSize), tailSize);
+            }
+        }
+
+        //
+        // This is just a hint. If THP is disabled, we still have a valid block.
+        //
+        (void) ::madvise(block, mappedSize, MADV_HUGEPAGE);
+        return block;
+    #else
+        #error Unknown Platform!
+    #endif
+}
+
+void
+XPF_API
+xpf::ApiFreePages(
+    _Inout_opt_ void* MemoryBlock,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    //
+    // Sanity checks.
+    //
+    if (nullptr == MemoryBlock)
+    {
+        return;
+    }
+
+    #if defined XPF_PLATFORM_WIN_KM
+        XPF_UNREFERENCED_PARAMETER(BlockSize);
+        xpf::ApiFreeMemory(MemoryBlock);
+    #elif defined XPF_PLATFORM_WIN_UM
+        XPF_UNREFERENCED_PARAMETER(BlockSize);
+        const BOOL result = ::VirtualFree(MemoryBlock,
+                                          0,
+                                          MEM_RELEASE);
+        /* We allocated with VirtualAlloc. This shouldn't fail. */
+        XPF_DEATH_ON_FAILURE(FALSE != result);
+    #elif defined XPF_PLATFORM_LINUX_UM
+        const size_t mappedSize = xpf::AlgoAlignValueUp((BlockSize == 0) ? size_t{ 1 } : BlockSize,
+                                                        XpfPageSize());
+        const int result = ::munmap(MemoryBlock, mappedSize);
+        /* We allocated with mmap. This shouldn't fail. */
+        XPF_DEATH_ON_FAILURE(0 == result);
+    #else
+        #error Unknown Platform!
+    #endif
+
+    MemoryBlock = nullptr;
+}
+
 void
 XPF_API
 xpf::ApiSleep(
@@ -377,6 +670,57 @@ xpf::ApiYieldProcesor(
     #endif
 }
 
+uint32_t
+XPF_API
+xpf::ApiNumberOfProcessors(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    uint32_t numberOfProcessors = 0;
+
+    #if defined XPF_PLATFORM_WIN_KM
+        numberOfProcessors = static_cast<uint32_t>(::KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS));
+    #elif defined XPF_PLATFORM_WIN_UM
+        numberOfProcessors = static_cast<uint32_t>(::GetActiveProcessorCount(ALL_PROCESSOR_GROUPS));
+    #elif defined XPF_PLATFORM_LINUX_UM
+        const long result = sysconf(_SC_NPROCESSORS_CONF);
+        numberOfProcessors = (result > 0) ? static_cast<uint32_t>(result)
+                                          : 0;
+    #else
+        #error Unknown Platform!
+    #endif
+
+    return (0 == numberOfProcessors) ? 1
+                                     : numberOfProcessors;
+}
+
+uint32_t
+XPF_API
+xpf::ApiCurrentProcessorNumber(
+    void
+) noexcept(true)
+{
+    XPF_MAX_DISPATCH_LEVEL();
+
+    #if defined XPF_PLATFORM_WIN_KM
+        return static_cast<uint32_t>(::KeGetCurrentProcessorNumberEx(NULL));
+    #elif defined XPF_PLATFORM_WIN_UM
+        PROCESSOR_NUMBER processorNumber;
+        xpf::ApiZeroMemory(&processorNumber, sizeof(processorNumber));
+
+        ::GetCurrentProcessorNumberEx(&processorNumber);
+        return static_cast<uint32_t>(processorNumber.Group) * 64 + static_cast<uint32_t>(processorNumber.Number);
+    #elif defined XPF_PLATFORM_LINUX_UM
+        const int result = sched_getcpu();
+        return (result >= 0) ? static_cast<uint32_t>(result)
+                             : 0;
+    #else
+        #error Unknown Platform!
+    #endif
+}
+
 uint64_t
 XPF_API
 xpf::ApiCurrentTime(
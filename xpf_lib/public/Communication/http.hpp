@@ -16,6 +16,7 @@
 
 #include "xpf_lib/public/core/Core.hpp"
 #include "xpf_lib/public/Containers/String.hpp"
+#include "xpf_lib/public/Containers/SmallVector.hpp"
 
 namespace xpf
 {
@@ -132,8 +133,9 @@ struct HttpResponse
 
     /**
      * @brief   The identified headers inside the  ResponseBuffer.
+     *          Most responses have only a few headers, so they are stored inline.
      */
-    xpf::Vector<xpf::http::HeaderItem> Headers;
+    xpf::SmallVector<xpf::http::HeaderItem, 16> Headers;
 
     /**
      * @brief   The body of the response.
@@ -0,0 +1,1257 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/BTreeMap.hpp
+ *
+ * @brief       B-tree ordered map with the same interface as xpf::Map.
+ *              Each node holds many keys stored contiguously, so a lookup
+ *              touches one node (a few cache lines) per level instead of
+ *              one node per key comparison as in the red-black tree.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Containers/RedBlackTree.hpp"
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the B-tree node definitions.
+// A node with Count keys has Count + 1 children when it is internal,
+// laid out in order as:
+//
+//            [C0] K0 [C1] K1 [C2] K2 [C3]
+//
+// Every key in Ci is between K(i-1) and Ki. All leaves are on the same level.
+// ************************************************************************************************
+//
+
+/**
+ * @brief The size targeted by the keys and the values of a node.
+ *        A node of 64-bit keys and values holds 15 keys - the keys fit in two cache lines.
+ */
+constexpr size_t XPF_BTREE_NODE_TARGET_SIZE = 256;
+
+/**
+ * @brief       Computes the maximum number of keys in a node.
+ *              The result is always odd (2t - 1), so a full node splits
+ *              into two halves of t - 1 keys and a median.
+ *
+ * @return The maximum number of keys in a node - at least 3.
+ */
+template <class Key, class Value>
+constexpr inline size_t
+BTreeMaxKeys(
+    void
+) noexcept(true)
+{
+    const size_t pairs = XPF_BTREE_NODE_TARGET_SIZE / (sizeof(Key) + sizeof(Value));
+
+    size_t minimumDegree = (pairs + 1) / 2;
+    if (minimumDegree < 2)
+    {
+        minimumDegree = 2;
+    }
+    if (minimumDegree > 64)
+    {
+        minimumDegree = 64;
+    }
+    return (2 * minimumDegree) - 1;
+}
+
+/**
+ * @brief A B-tree node. Leaves are allocated with this exact size.
+ *        The key and value storage is raw - only [0, Count) is constructed.
+ */
+template <class Key, class Value, size_t MaxKeys>
+struct BTreeNode
+{
+    /**
+     * @brief Default constructor - the storage is left uninitialized.
+     */
+    BTreeNode(
+        void
+    ) noexcept(true)
+    {
+        XPF_NOTHING();
+    }
+
+    /**
+     * @brief       Gets the keys of the node.
+     *
+     * @return A pointer to the first key.
+     */
+    inline Key*
+    Keys(
+        void
+    ) noexcept(true)
+    {
+        return reinterpret_cast<Key*>(this->KeyStorage);
+    }
+
+    /**
+     * @brief       Gets the keys of the node - const variant.
+     *
+     * @return A pointer to the first key.
+     */
+    inline const Key*
+    Keys(
+        void
+    ) const noexcept(true)
+    {
+        return reinterpret_cast<const Key*>(this->KeyStorage);
+    }
+
+    /**
+     * @brief       Gets the values of the node.
+     *
+     * @return A pointer to the first value.
+     */
+    inline Value*
+    Values(
+        void
+    ) noexcept(true)
+    {
+        return reinterpret_cast<Value*>(this->ValueStorage);
+    }
+
+    BTreeNode*  Parent   = nullptr;
+    uint16_t    Position = 0;
+    uint16_t    Count    = 0;
+    bool        IsLeaf   = true;
+
+    alignas(Key)   uint8_t KeyStorage[sizeof(Key) * MaxKeys];
+    alignas(Value) uint8_t ValueStorage[sizeof(Value) * MaxKeys];
+};  // struct BTreeNode
+
+/**
+ * @brief An internal B-tree node - a node followed by its children.
+ *        Each child knows its parent and its position in the parent.
+ */
+template <class Key, class Value, size_t MaxKeys>
+struct BTreeInternalNode : public BTreeNode<Key, Value, MaxKeys>
+{
+    BTreeNode<Key, Value, MaxKeys>* Children[MaxKeys + 1];
+};  // struct BTreeInternalNode
+
+
+//
+// ************************************************************************************************
+// This is the section containing the B-tree iterator.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Minimal iterator for in-order traversal of the B-tree.
+ *        Provides named accessors for key and value, same as RedBlackTreeIterator.
+ */
+template <class Key, class Value, size_t MaxKeys>
+class BTreeIterator
+{
+ public:
+    /**
+     * @brief Internal node type aliases for readability.
+     */
+    using Node = BTreeNode<Key, Value, MaxKeys>;
+    using InternalNode = BTreeInternalNode<Key, Value, MaxKeys>;
+
+/**
+ * @brief       Iterator constructor.
+ *
+ * @param[in]   TreeNode - The node this iterator points to.
+ *                         Can be nullptr to represent End().
+ * @param[in]   Index    - The index of the key in the node.
+ */
+BTreeIterator(
+    _In_opt_ Node* TreeNode,
+    _In_ size_t Index
+) noexcept(true) : m_Node{ TreeNode },
+                   m_Index{ Index }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Default destructor.
+ */
+~BTreeIterator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be both copied and moved.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(BTreeIterator, default);
+
+/**
+ * @brief       Retrieves a const reference to the key of the current element.
+ *
+ * @return A const reference to the key.
+ *
+ * @note The iterator must be valid (not End()).
+ */
+inline const Key&
+GetKey(
+    void
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != this->m_Node);
+    _Analysis_assume_(nullptr != this->m_Node);
+
+    return this->m_Node->Keys()[this->m_Index];
+}
+
+/**
+ * @brief       Retrieves a reference to the value of the current element.
+ *
+ * @return A non-const reference to the value.
+ *
+ * @note The iterator must be valid (not End()).
+ */
+inline Value&
+GetValue(
+    void
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != this->m_Node);
+    _Analysis_assume_(nullptr != this->m_Node);
+
+    return this->m_Node->Values()[this->m_Index];
+}
+
+/**
+ * @brief       Retrieves a const reference to the value of the current element.
+ *
+ * @return A const reference to the value.
+ *
+ * @note The iterator must be valid (not End()).
+ */
+inline const Value&
+GetValue(
+    void
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != this->m_Node);
+    _Analysis_assume_(nullptr != this->m_Node);
+
+    return this->m_Node->Values()[this->m_Index];
+}
+
+/**
+ * @brief       Prefix increment operator. Advances to the in-order successor.
+ *
+ *              In-order successor logic:
+ *              1. In an internal node, the successor is the leftmost key
+ *                 of the child to the right of the current key.
+ *              2. In a leaf, it is the next key of the leaf. When the leaf is
+ *                 exhausted, go up until we come from a child which has a key
+ *                 on its right in the parent.
+ *
+ * @return A reference to this iterator after advancing.
+ */
+inline BTreeIterator&
+operator++(
+    void
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != this->m_Node);
+    _Analysis_assume_(nullptr != this->m_Node);
+
+    if (!this->m_Node->IsLeaf)
+    {
+        Node* current = static_cast<InternalNode*>(this->m_Node)->Children[this->m_Index + 1];
+        while (!current->IsLeaf)
+        {
+            current = static_cast<InternalNode*>(current)->Children[0];
+        }
+        this->m_Node = current;
+        this->m_Index = 0;
+        return *this;
+    }
+
+    this->m_Index++;
+    while (this->m_Index >= this->m_Node->Count)
+    {
+        if (nullptr == this->m_Node->Parent)
+        {
+            /* Climbed past the root - this was the last key. */
+            this->m_Node = nullptr;
+            this->m_Index = 0;
+            break;
+        }
+        this->m_Index = this->m_Node->Position;
+        this->m_Node = this->m_Node->Parent;
+    }
+    return *this;
+}
+
+/**
+ * @brief       Equality operator.
+ *
+ * @param[in]   Other - The other iterator to compare against.
+ *
+ * @return true if both iterators point to the same element, false otherwise.
+ */
+inline bool
+operator==(
+    _In_ _Const_ const BTreeIterator& Other
+) const noexcept(true)
+{
+    return (this->m_Node == Other.m_Node) && (this->m_Index == Other.m_Index);
+}
+
+/**
+ * @brief       Inequality operator.
+ *
+ * @param[in]   Other - The other iterator to compare against.
+ *
+ * @return true if the iterators point to different elements, false otherwise.
+ */
+inline bool
+operator!=(
+    _In_ _Const_ const BTreeIterator& Other
+) const noexcept(true)
+{
+    return !(*this == Other);
+}
+
+ private:
+    /**
+     * @brief   Allow the BTreeMap class to access the node and the index.
+     */
+    template <class, class, class>
+    friend class BTreeMap;
+
+    Node* m_Node = nullptr;
+    size_t m_Index = 0;
+};  // class BTreeIterator
+
+
+//
+// ************************************************************************************************
+// This is the section containing the BTreeMap implementation.
+// A B-tree of minimum degree t:
+//   1. Every node has at most 2t - 1 keys.
+//   2. Every node except the root has at least t - 1 keys.
+//   3. An internal node with k keys has k + 1 children.
+//   4. All leaves have the same depth.
+// Insertion splits full nodes on the way down, so a split never propagates up.
+// Erase removes from a leaf and fixes underflows on the way up, borrowing
+// from a sibling when possible and merging with it otherwise.
+// ************************************************************************************************
+//
+
+/**
+ * @brief B-tree ordered container mapping keys to values.
+ *        Provides O(log n) insert, find, and erase operations with
+ *        far fewer cache misses than the red-black tree for large maps.
+ *        Same interface as Map, so the two can be swapped.
+ *
+ *        Emplace is an upsert: if the key already exists, the value is
+ *        updated in place via move-assign (no allocation).
+ *
+ * @note  Any insertion or erase invalidates the existing iterators,
+ *        as elements move between nodes.
+ */
+template <class Key, class Value, class Comparator = DefaultCompare<Key>>
+class BTreeMap final
+{
+ public:
+    /**
+     * @brief The maximum number of keys in a node (2t - 1).
+     */
+    static constexpr size_t MAX_KEYS = xpf::BTreeMaxKeys<Key, Value>();
+
+    /**
+     * @brief The minimum number of keys in a node other than the root (t - 1).
+     */
+    static constexpr size_t MIN_KEYS = (MAX_KEYS - 1) / 2;
+
+    /**
+     * @brief Internal node type aliases.
+     */
+    using Node = BTreeNode<Key, Value, MAX_KEYS>;
+    using InternalNode = BTreeInternalNode<Key, Value, MAX_KEYS>;
+
+    /**
+     * @brief Iterator type for in-order traversal.
+     */
+    using Iterator = BTreeIterator<Key, Value, MAX_KEYS>;
+
+    static_assert(alignof(InternalNode) <= XPF_DEFAULT_ALIGNMENT, "Over-aligned nodes are not supported!");
+
+/**
+ * @brief       BTreeMap constructor - default.
+ *
+ * @param[in]   Allocator - to be used when performing node allocations.
+ */
+BTreeMap(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Allocator{ Allocator }
+{
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
+}
+
+/**
+ * @brief Destructor. Destroys all elements and frees all nodes.
+ */
+~BTreeMap(
+    void
+) noexcept(true)
+{
+    this->Clear();
+}
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+BTreeMap(
+    _In_ _Const_ const BTreeMap& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor. Steals the root and size from Other.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+BTreeMap(
+    _Inout_ BTreeMap&& Other
+) noexcept(true) : m_Allocator{ Other.m_Allocator },
+                   m_Root{ Other.m_Root },
+                   m_Size{ Other.m_Size },
+                   m_Comparator{ Other.m_Comparator }
+{
+    Other.m_Root = nullptr;
+    Other.m_Size = 0;
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+BTreeMap&
+operator=(
+    _In_ _Const_ const BTreeMap& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment. Steals the root and size from Other.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+BTreeMap&
+operator=(
+    _Inout_ BTreeMap&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->Clear();
+
+        this->m_Allocator = Other.m_Allocator;
+        this->m_Root = Other.m_Root;
+        this->m_Size = Other.m_Size;
+        this->m_Comparator = Other.m_Comparator;
+
+        Other.m_Root = nullptr;
+        Other.m_Size = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief       Inserts or updates a key-value pair in the map.
+ *              If the key already exists, the value is updated via move-assign (no allocation).
+ *              Otherwise every full node met on the way down is split, so the leaf
+ *              which receives the key has room for it.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ *
+ * @return STATUS_SUCCESS if the key-value pair was inserted or updated successfully,
+ *         STATUS_INSUFFICIENT_RESOURCES if a new node could not be allocated.
+ *         On failure the map keeps its elements (some nodes may have been split).
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    /*
+     * Upsert - if the key is already here, only the value changes.
+     */
+    Iterator it = this->Find(KeyToInsert);
+    if (it != this->End())
+    {
+        it.GetValue() = xpf::Move(ValueToInsert);
+        return STATUS_SUCCESS;
+    }
+
+    if (nullptr == this->m_Root)
+    {
+        this->m_Root = this->AllocateNode(true);
+        if (nullptr == this->m_Root)
+        {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    /*
+     * A full root is split under a new root - this is the only way the tree grows.
+     *
+     *                                  [ M ]
+     *      [ A | M | B ]    =>        /     \
+     *                              [ A ]   [ B ]
+     */
+    if (MAX_KEYS == this->m_Root->Count)
+    {
+        Node* newRoot = this->AllocateNode(false);
+        if (nullptr == newRoot)
+        {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        Node* oldRoot = this->m_Root;
+        this->SetChild(newRoot, 0, oldRoot);
+        this->m_Root = newRoot;
+
+        if (!this->SplitChild(newRoot, 0))
+        {
+            oldRoot->Parent = nullptr;
+            oldRoot->Position = 0;
+            this->m_Root = oldRoot;
+            this->FreeNode(newRoot);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    /*
+     * Walk down, splitting the full children before entering them.
+     */
+    Node* node = this->m_Root;
+    while (!node->IsLeaf)
+    {
+        size_t index = this->LowerBound(node, KeyToInsert);
+        Node* child = this->Children(node)[index];
+
+        if (MAX_KEYS == child->Count)
+        {
+            if (!this->SplitChild(node, index))
+            {
+                return STATUS_INSUFFICIENT_RESOURCES;
+            }
+
+            /* The median moved up to index - go right if the key is greater. */
+            if (this->m_Comparator(node->Keys()[index], KeyToInsert))
+            {
+                index++;
+            }
+            child = this->Children(node)[index];
+        }
+        node = child;
+    }
+
+    /*
+     * Make room in the leaf and construct the element in place.
+     */
+    const size_t index = this->LowerBound(node, KeyToInsert);
+    for (size_t i = node->Count; i > index; --i)
+    {
+        this->RelocateElement(node, i, node, i - 1);
+    }
+    xpf::MemoryAllocator::Construct(xpf::AddressOf(node->Keys()[index]),
+                                    xpf::Move(KeyToInsert));
+    xpf::MemoryAllocator::Construct(xpf::AddressOf(node->Values()[index]),
+                                    xpf::Move(ValueToInsert));
+    node->Count++;
+    this->m_Size++;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Finds the element with the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator pointing to the element, or End() if not found.
+ */
+inline Iterator
+Find(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    Node* node = this->m_Root;
+
+    while (nullptr != node)
+    {
+        const size_t index = this->LowerBound(node, KeyToFind);
+        if ((index < node->Count) && !this->m_Comparator(KeyToFind, node->Keys()[index]))
+        {
+            return Iterator{ node, index };
+        }
+        if (node->IsLeaf)
+        {
+            break;
+        }
+        node = this->Children(node)[index];
+    }
+    return this->End();
+}
+
+/**
+ * @brief       Removes the element with the given key.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ *
+ * @return STATUS_SUCCESS if the key was found and removed,
+ *         STATUS_NOT_FOUND if the key was not present.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase
+) noexcept(true)
+{
+    Iterator it = this->Find(KeyToErase);
+    if (it == this->End())
+    {
+        return STATUS_NOT_FOUND;
+    }
+
+    Node* node = it.m_Node;
+    size_t index = it.m_Index;
+
+    /*
+     * Keys are only removed from leaves. An internal key is replaced by its
+     * in-order predecessor (the last key of the rightmost leaf on its left),
+     * and that predecessor is removed from its leaf instead.
+     */
+    if (!node->IsLeaf)
+    {
+        Node* leaf = this->Children(node)[index];
+        while (!leaf->IsLeaf)
+        {
+            leaf = this->Children(leaf)[leaf->Count];
+        }
+
+        node->Keys()[index] = xpf::Move(leaf->Keys()[leaf->Count - 1]);
+        node->Values()[index] = xpf::Move(leaf->Values()[leaf->Count - 1]);
+
+        node = leaf;
+        index = leaf->Count - 1;
+    }
+
+    xpf::MemoryAllocator::Destruct(xpf::AddressOf(node->Keys()[index]));
+    xpf::MemoryAllocator::Destruct(xpf::AddressOf(node->Values()[index]));
+    for (size_t i = index + 1; i < node->Count; ++i)
+    {
+        this->RelocateElement(node, i - 1, node, i);
+    }
+    node->Count--;
+    this->m_Size--;
+
+    this->RebalanceAfterErase(node);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Returns an iterator to the smallest key (first key of the leftmost leaf).
+ *
+ * @return An iterator to the first element in sorted order,
+ *         or End() if the map is empty.
+ */
+inline Iterator
+Begin(
+    void
+) const noexcept(true)
+{
+    Node* node = this->m_Root;
+    if (nullptr == node)
+    {
+        return this->End();
+    }
+    while (!node->IsLeaf)
+    {
+        node = this->Children(node)[0];
+    }
+    return Iterator{ node, 0 };
+}
+
+/**
+ * @brief       Returns a sentinel iterator representing past-the-end.
+ *
+ * @return An iterator with a nullptr node.
+ */
+inline Iterator
+End(
+    void
+) const noexcept(true)
+{
+    return Iterator{ nullptr, 0 };
+}
+
+/**
+ * @brief Gets the number of elements in the map.
+ *
+ * @return The number of key-value pairs.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Size;
+}
+
+/**
+ * @brief Checks if the map is empty.
+ *
+ * @return true if the map has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return (this->m_Size == 0);
+}
+
+/**
+ * @brief Destroys all elements and frees all nodes.
+ *        After this call, the map is empty.
+ *
+ *        The walk needs no stack: an internal node hands out its children
+ *        from the last to the first, destroying its keys on the way. When the
+ *        first child is handed out the node is flagged as a leaf, so it is
+ *        freed when the walk climbs back to it.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    Node* current = this->m_Root;
+
+    while (nullptr != current)
+    {
+        if (current->IsLeaf)
+        {
+            for (size_t i = 0; i < current->Count; ++i)
+            {
+                xpf::MemoryAllocator::Destruct(xpf::AddressOf(current->Keys()[i]));
+                xpf::MemoryAllocator::Destruct(xpf::AddressOf(current->Values()[i]));
+            }
+
+            Node* parent = current->Parent;
+            this->FreeNode(current);
+            current = parent;
+        }
+        else if (current->Count > 0)
+        {
+            Node* child = this->Children(current)[current->Count];
+
+            xpf::MemoryAllocator::Destruct(xpf::AddressOf(current->Keys()[current->Count - 1]));
+            xpf::MemoryAllocator::Destruct(xpf::AddressOf(current->Values()[current->Count - 1]));
+            current->Count--;
+
+            current = child;
+        }
+        else
+        {
+            Node* child = this->Children(current)[0];
+            current->IsLeaf = true;
+            current = child;
+        }
+    }
+
+    this->m_Root = nullptr;
+    this->m_Size = 0;
+}
+
+/**
+ * @brief Gets the underlying allocator.
+ *
+ * @return A const reference to the underlying allocator.
+ */
+inline const xpf::PolymorphicAllocator&
+GetAllocator(
+    void
+) const noexcept(true)
+{
+    return this->m_Allocator;
+}
+
+/**
+ * @brief       Gets the root node of the tree. Primarily for testing.
+ *
+ * @return A pointer to the root node, or nullptr if the map is empty.
+ */
+inline const Node*
+Root(
+    void
+) const noexcept(true)
+{
+    return this->m_Root;
+}
+
+/**
+ * @brief       Gets the children of an internal node.
+ *
+ * @param[in]   InternalTreeNode - The node. Must not be a leaf.
+ *
+ * @return A pointer to the first child.
+ */
+static inline Node* const*
+Children(
+    _In_ const Node* InternalTreeNode
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(!InternalTreeNode->IsLeaf);
+    return static_cast<const InternalNode*>(InternalTreeNode)->Children;
+}
+
+ private:
+/**
+ * @brief       Gets the children of an internal node - writable variant.
+ *
+ * @param[in]   InternalTreeNode - The node. Must not be a leaf.
+ *
+ * @return A pointer to the first child.
+ */
+static inline Node**
+Children(
+    _In_ Node* InternalTreeNode
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(!InternalTreeNode->IsLeaf);
+    return static_cast<InternalNode*>(InternalTreeNode)->Children;
+}
+
+/**
+ * @brief       Finds the first key in a node which is not less than the given key.
+ *
+ *              For trivially copyable keys (integers, uuids, ...) all the keys
+ *              are compared without branching - the comparisons are independent
+ *              and the compiler is free to vectorize them. Other keys stop at
+ *              the first key which is not less, to save comparisons.
+ *
+ * @param[in]   TreeNode  - The node to search in.
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return The index of the first key not less than KeyToFind, or Count.
+ */
+inline size_t
+LowerBound(
+    _In_ const Node* TreeNode,
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    const Key* keys = TreeNode->Keys();
+    const size_t count = TreeNode->Count;
+
+    size_t index = 0;
+    if constexpr (xpf::IsTriviallyCopyable<Key>())
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            index += this->m_Comparator(keys[i], KeyToFind) ? 1 : 0;
+        }
+    }
+    else
+    {
+        while ((index < count) && this->m_Comparator(keys[index], KeyToFind))
+        {
+            index++;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief       Moves an element into an unconstructed slot, leaving its old slot unconstructed.
+ *
+ * @param[in,out]   Destination      - The node receiving the element.
+ * @param[in]       DestinationIndex - The slot receiving the element.
+ * @param[in,out]   Source           - The node giving the element.
+ * @param[in]       SourceIndex      - The slot giving the element.
+ */
+inline void
+RelocateElement(
+    _Inout_ Node* Destination,
+    _In_ size_t DestinationIndex,
+    _Inout_ Node* Source,
+    _In_ size_t SourceIndex
+) noexcept(true)
+{
+    xpf::MemoryAllocator::Construct(xpf::AddressOf(Destination->Keys()[DestinationIndex]),
+                                    xpf::Move(Source->Keys()[SourceIndex]));
+    xpf::MemoryAllocator::Destruct(xpf::AddressOf(Source->Keys()[SourceIndex]));
+
+    xpf::MemoryAllocator::Construct(xpf::AddressOf(Destination->Values()[DestinationIndex]),
+                                    xpf::Move(Source->Values()[SourceIndex]));
+    xpf::MemoryAllocator::Destruct(xpf::AddressOf(Source->Values()[SourceIndex]));
+}
+
+/**
+ * @brief       Stores a child in an internal node and updates its back links.
+ *
+ * @param[in,out]   Parent - The internal node.
+ * @param[in]       Index  - The position of the child.
+ * @param[in,out]   Child  - The child.
+ */
+inline void
+SetChild(
+    _Inout_ Node* Parent,
+    _In_ size_t Index,
+    _Inout_ Node* Child
+) noexcept(true)
+{
+    this->Children(Parent)[Index] = Child;
+    Child->Parent = Parent;
+    Child->Position = static_cast<uint16_t>(Index);
+}
+
+/**
+ * @brief       Splits the full child at Index. The median key moves up into Parent.
+ *
+ *                    [ .. P .. ]                      [ .. P | M .. ]
+ *                        |                 =>             |     \
+ *            [ A0..At-2 | M | B0..Bt-2 ]         [ A0..At-2 ]  [ B0..Bt-2 ]
+ *
+ * @param[in,out]   Parent - A node which is not full.
+ * @param[in]       Index  - The position of the full child.
+ *
+ * @return true if the child was split, false if the new node could not be allocated.
+ */
+_Must_inspect_result_
+inline bool
+SplitChild(
+    _Inout_ Node* Parent,
+    _In_ size_t Index
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(Parent->Count < MAX_KEYS);
+
+    Node* left = this->Children(Parent)[Index];
+    XPF_DEATH_ON_FAILURE(MAX_KEYS == left->Count);
+
+    Node* right = this->AllocateNode(left->IsLeaf);
+    if (nullptr == right)
+    {
+        return false;
+    }
+
+    /* The upper half goes to the new right node. */
+    for (size_t i = 0; i < MIN_KEYS; ++i)
+    {
+        this->RelocateElement(right, i, left, MIN_KEYS + 1 + i);
+    }
+    if (!left->IsLeaf)
+    {
+        for (size_t i = 0; i <= MIN_KEYS; ++i)
+        {
+            this->SetChild(right, i, this->Children(left)[MIN_KEYS + 1 + i]);
+        }
+    }
+    right->Count = static_cast<uint16_t>(MIN_KEYS);
+
+    /* Make room in the parent for the median and the new child. */
+    for (size_t i = Parent->Count; i > Index; --i)
+    {
+        this->RelocateElement(Parent, i, Parent, i - 1);
+        this->SetChild(Parent, i + 1, this->Children(Parent)[i]);
+    }
+    this->RelocateElement(Parent, Index, left, MIN_KEYS);
+    this->SetChild(Parent, Index + 1, right);
+
+    left->Count = static_cast<uint16_t>(MIN_KEYS);
+    Parent->Count++;
+
+    return true;
+}
+
+/**
+ * @brief       Moves one key from the left sibling, through the parent, into the child.
+ *
+ *                 [ .. P .. ]                  [ .. L .. ]
+ *                 /         \        =>        /         \
+ *          [ .. L ]       [ C .. ]          [ .. ]     [ P | C .. ]
+ *
+ * @param[in,out]   Parent    - The parent of both nodes.
+ * @param[in]       LeftIndex - The position of the left sibling.
+ */
+inline void
+BorrowFromLeft(
+    _Inout_ Node* Parent,
+    _In_ size_t LeftIndex
+) noexcept(true)
+{
+    Node* left = this->Children(Parent)[LeftIndex];
+    Node* child = this->Children(Parent)[LeftIndex + 1];
+
+    for (size_t i = child->Count; i > 0; --i)
+    {
+        this->RelocateElement(child, i, child, i - 1);
+    }
+    if (!child->IsLeaf)
+    {
+        for (size_t i = child->Count + 1; i > 0; --i)
+        {
+            this->SetChild(child, i, this->Children(child)[i - 1]);
+        }
+        this->SetChild(child, 0, this->Children(left)[left->Count]);
+    }
+
+    this->RelocateElement(child, 0, Parent, LeftIndex);
+    this->RelocateElement(Parent, LeftIndex, left, left->Count - 1);
+
+    left->Count--;
+    child->Count++;
+}
+
+/**
+ * @brief       Moves one key from the right sibling, through the parent, into the child.
+ *
+ *                 [ .. P .. ]                  [ .. R .. ]
+ *                 /         \        =>        /         \
+ *          [ .. C ]       [ R .. ]        [ .. C | P ]  [ .. ]
+ *
+ * @param[in,out]   Parent    - The parent of both nodes.
+ * @param[in]       LeftIndex - The position of the child (the right sibling follows it).
+ */
+inline void
+BorrowFromRight(
+    _Inout_ Node* Parent,
+    _In_ size_t LeftIndex
+) noexcept(true)
+{
+    Node* child = this->Children(Parent)[LeftIndex];
+    Node* right = this->Children(Parent)[LeftIndex + 1];
+
+    this->RelocateElement(child, child->Count, Parent, LeftIndex);
+    this->RelocateElement(Parent, LeftIndex, right, 0);
+
+    for (size_t i = 1; i < right->Count; ++i)
+    {
+        this->RelocateElement(right, i - 1, right, i);
+    }
+    if (!right->IsLeaf)
+    {
+        this->SetChild(child, child->Count + 1, this->Children(right)[0]);
+        for (size_t i = 1; i <= right->Count; ++i)
+        {
+            this->SetChild(right, i - 1, this->Children(right)[i]);
+        }
+    }
+
+    right->Count--;
+    child->Count++;
+}
+
+/**
+ * @brief       Merges the child at LeftIndex, the separating key, and the next child.
+ *              The right node is freed and the parent loses one key.
+ *
+ *                 [ .. P .. ]
+ *                 /         \        =>        [ .. ]
+ *            [ L .. ]     [ R .. ]               |
+ *                                         [ L .. | P | R .. ]
+ *
+ * @param[in,out]   Parent    - The parent of both nodes.
+ * @param[in]       LeftIndex - The position of the left node.
+ */
+inline void
+MergeChildren(
+    _Inout_ Node* Parent,
+    _In_ size_t LeftIndex
+) noexcept(true)
+{
+    Node* left = this->Children(Parent)[LeftIndex];
+    Node* right = this->Children(Parent)[LeftIndex + 1];
+
+    XPF_DEATH_ON_FAILURE(size_t{ left->Count } + right->Count + 1 <= MAX_KEYS);
+
+    const size_t leftCount = left->Count;
+    this->RelocateElement(left, leftCount, Parent, LeftIndex);
+    for (size_t i = 0; i < right->Count; ++i)
+    {
+        this->RelocateElement(left, leftCount + 1 + i, right, i);
+    }
+    if (!left->IsLeaf)
+    {
+        for (size_t i = 0; i <= right->Count; ++i)
+        {
+            this->SetChild(left, leftCount + 1 + i, this->Children(right)[i]);
+        }
+    }
+    left->Count = static_cast<uint16_t>(leftCount + 1 + right->Count);
+
+    /* Close the gap in the parent. */
+    for (size_t i = LeftIndex + 1; i < Parent->Count; ++i)
+    {
+        this->RelocateElement(Parent, i - 1, Parent, i);
+        this->SetChild(Parent, i, this->Children(Parent)[i + 1]);
+    }
+    Parent->Count--;
+
+    this->FreeNode(right);
+}
+
+/**
+ * @brief       Restores the minimum number of keys after a removal, walking up the tree.
+ *
+ * @param[in,out]   TreeNode - The node which lost a key.
+ */
+inline void
+RebalanceAfterErase(
+    _Inout_ Node* TreeNode
+) noexcept(true)
+{
+    Node* node = TreeNode;
+
+    while ((node != this->m_Root) && (node->Count < MIN_KEYS))
+    {
+        Node* parent = node->Parent;
+        const size_t position = node->Position;
+
+        if ((position > 0) && (this->Children(parent)[position - 1]->Count > MIN_KEYS))
+        {
+            this->BorrowFromLeft(parent, position - 1);
+            return;
+        }
+        if ((position < parent->Count) && (this->Children(parent)[position + 1]->Count > MIN_KEYS))
+        {
+            this->BorrowFromRight(parent, position);
+            return;
+        }
+
+        /* Both siblings are minimal - merge with one, the parent loses a key. */
+        this->MergeChildren(parent, (position > 0) ? position - 1
+                                                   : position);
+        node = parent;
+    }
+
+    /*
+     * An empty root is dropped - this is the only way the tree shrinks.
+     */
+    if ((nullptr != this->m_Root) && (0 == this->m_Root->Count))
+    {
+        Node* oldRoot = this->m_Root;
+        if (oldRoot->IsLeaf)
+        {
+            this->m_Root = nullptr;
+        }
+        else
+        {
+            this->m_Root = this->Children(oldRoot)[0];
+            this->m_Root->Parent = nullptr;
+            this->m_Root->Position = 0;
+        }
+        this->FreeNode(oldRoot);
+    }
+}
+
+/**
+ * @brief       Allocates an empty node. Leaves do not have room for children.
+ *
+ * @param[in]   IsLeaf - true to allocate a leaf, false for an internal node.
+ *
+ * @return A pointer to the new node, or nullptr on allocation failure.
+ */
+_Ret_maybenull_
+inline Node*
+AllocateNode(
+    _In_ bool IsLeaf
+) noexcept(true)
+{
+    Node* node = nullptr;
+    if (IsLeaf)
+    {
+        void* memory = this->m_Allocator.AllocateMemory(sizeof(Node));
+        if (nullptr != memory)
+        {
+            node = static_cast<Node*>(memory);
+            xpf::MemoryAllocator::Construct(node);
+        }
+    }
+    else
+    {
+        void* memory = this->m_Allocator.AllocateMemory(sizeof(InternalNode));
+        if (nullptr != memory)
+        {
+            InternalNode* internalNode = static_cast<InternalNode*>(memory);
+            xpf::MemoryAllocator::Construct(internalNode);
+            node = internalNode;
+        }
+    }
+
+    if (nullptr != node)
+    {
+        node->IsLeaf = IsLeaf;
+    }
+    return node;
+}
+
+/**
+ * @brief       Frees a node. Its elements must have been destroyed or moved out.
+ *
+ * @param[in,out]   TreeNode - The node to be freed.
+ */
+inline void
+FreeNode(
+    _Inout_ Node* TreeNode
+) noexcept(true)
+{
+    xpf::MemoryAllocator::Destruct(TreeNode);
+    this->m_Allocator.FreeMemory(TreeNode);
+}
+
+   /**
+    * @brief The allocator used for the nodes.
+    */
+    xpf::PolymorphicAllocator m_Allocator;
+
+   /**
+    * @brief The root of the tree, or nullptr when the map is empty.
+    */
+    Node* m_Root = nullptr;
+
+   /**
+    * @brief The number of elements currently in the map.
+    */
+    size_t m_Size = 0;
+
+   /**
+    * @brief The comparator used for key ordering.
+    */
+    Comparator m_Comparator{};
+};  // class BTreeMap
+};  // namespace xpf
@@ -0,0 +1,461 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/ConcurrentHashMap.hpp
+ *
+ * @brief       Thread-safe hash map split into independently locked shards.
+ *              Each shard is a HashTable guarded by its own BusyLock and lives
+ *              on its own cache lines, so threads working on different shards
+ *              never touch the same lock word.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Memory/CacheAligned.hpp"
+#include "xpf_lib/public/Locks/Lock.hpp"
+#include "xpf_lib/public/Locks/BusyLock.hpp"
+#include "xpf_lib/public/Containers/HashMap.hpp"
+
+
+/**
+ * @brief The default number of shards. With more shards than threads,
+ *        two threads rarely need the same lock at the same time.
+ */
+#define XPF_CONCURRENT_HASH_MAP_DEFAULT_SHARDS      32
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the ConcurrentHashMap implementation.
+// The top bits of the hash select the shard. The HashTable inside the shard
+// uses the low bits of the same hash, so the keys of a shard still spread
+// over all of its slots:
+//
+//     hash = [ shard bits | ... unused ... | group bits | 7 metadata bits ]
+//
+// The key is hashed once per operation - the table gets the same hash, it doesn't compute it again.
+//
+// Every operation locks exactly one shard: shared for the lookups,
+// exclusive for the updates. Nothing ever holds two shard locks at once.
+// ************************************************************************************************
+//
+
+/**
+ * @brief One shard of the map - a lock and the table it guards.
+ *        The map keeps each shard in a CacheAligned, so two shards never share a cache line.
+ */
+template <class Key, class Value, class Hasher, class KeyEqual>
+struct ConcurrentHashMapShard
+{
+    /**
+     * @brief Guards the table. Shared for lookups, exclusive for updates.
+     */
+    xpf::BusyLock Lock;
+
+    /**
+     * @brief The elements whose hash selects this shard.
+     */
+    xpf::HashTable<Key, Value, Hasher, KeyEqual> Table;
+};  // struct ConcurrentHashMapShard
+
+/**
+ * @brief Hash map which can be used by several threads at once, without any external lock.
+ *
+ *        The map never hands out iterators or references outside of a lock -
+ *        Find and ForEach call the given callback while the shard is locked.
+ *        The callbacks must not call back into the same map.
+ *
+ *        ForEach visits one shard at a time. Each shard is seen in a consistent
+ *        state, but elements of other shards may change in the meantime.
+ */
+template <class Key,
+          class Value,
+          class Hasher = DefaultHash<Key>,
+          class KeyEqual = DefaultKeyEqual<Key>,
+          size_t ShardCount = XPF_CONCURRENT_HASH_MAP_DEFAULT_SHARDS>
+class ConcurrentHashMap final
+{
+    static_assert(ShardCount >= 2 && ShardCount <= 1024, "The number of shards must be between 2 and 1024!");
+    static_assert(0 == (ShardCount & (ShardCount - 1)), "The number of shards must be a power of two!");
+
+ public:
+    /**
+     * @brief Internal shard type alias.
+     */
+    using Shard = ConcurrentHashMapShard<Key, Value, Hasher, KeyEqual>;
+
+    /**
+     * @brief The number of shards.
+     */
+    static constexpr size_t SHARD_COUNT = ShardCount;
+
+/**
+ * @brief       ConcurrentHashMap constructor - default.
+ *              No memory is allocated until the first insertion.
+ *
+ * @param[in]   Allocator - to be used by every shard when allocating its table.
+ */
+ConcurrentHashMap(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true)
+{
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        this->m_Shards[i].Get().Table = xpf::HashTable<Key, Value, Hasher, KeyEqual>{ Allocator };
+    }
+}
+
+/**
+ * @brief Destructor. The map must no longer be used by other threads.
+ */
+~ConcurrentHashMap(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy and move semantics are deleted - the shards own locks.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(ConcurrentHashMap, delete);
+
+/**
+ * @brief       Inserts a key-value pair if the key is not already present.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ *
+ * @return STATUS_SUCCESS if the pair was inserted,
+ *         STATUS_OBJECT_NAME_COLLISION if the key is already present (nothing is moved),
+ *         STATUS_INSUFFICIENT_RESOURCES if the shard could not grow.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Insert(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    const uint64_t hash = this->m_Hasher(KeyToInsert);
+    Shard& shard = this->ShardOfHash(hash);
+    xpf::ExclusiveLockGuard guard{ shard.Lock };
+
+    if (shard.Table.Find(KeyToInsert, hash) != shard.Table.End())
+    {
+        return STATUS_OBJECT_NAME_COLLISION;
+    }
+    return shard.Table.Emplace(xpf::Move(KeyToInsert),
+                               xpf::Move(ValueToInsert),
+                               hash);
+}
+
+/**
+ * @brief       Inserts a key-value pair, or updates the value if the key is already present.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ *
+ * @return STATUS_SUCCESS if the pair was inserted or updated,
+ *         STATUS_INSUFFICIENT_RESOURCES if the shard could not grow.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+InsertOrUpdate(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    const uint64_t hash = this->m_Hasher(KeyToInsert);
+    Shard& shard = this->ShardOfHash(hash);
+    xpf::ExclusiveLockGuard guard{ shard.Lock };
+
+    return shard.Table.Emplace(xpf::Move(KeyToInsert),
+                               xpf::Move(ValueToInsert),
+                               hash);
+}
+
+/**
+ * @brief       Looks up a key and calls the callback with its value.
+ *              The callback runs while the shard is locked shared,
+ *              so it may copy the value but must not keep a reference to it.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ * @param[in]   Callback  - Called as Callback(const Value&) if the key is found.
+ *
+ * @return STATUS_SUCCESS if the key was found, STATUS_NOT_FOUND otherwise.
+ */
+template <class Visitor>
+_Must_inspect_result_
+inline NTSTATUS
+Find(
+    _In_ _Const_ const Key& KeyToFind,
+    _In_ Visitor&& Callback
+) const noexcept(true)
+{
+    const uint64_t hash = this->m_Hasher(KeyToFind);
+    Shard& shard = this->ShardOfHash(hash);
+    xpf::SharedLockGuard guard{ shard.Lock };
+
+    const auto it = shard.Table.Find(KeyToFind, hash);
+    if (it == shard.Table.End())
+    {
+        return STATUS_NOT_FOUND;
+    }
+    Callback(static_cast<const Value&>(it.GetValue()));
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Checks whether a key is present.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return true if the key was present when its shard was checked.
+ */
+inline bool
+Contains(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    const uint64_t hash = this->m_Hasher(KeyToFind);
+    Shard& shard = this->ShardOfHash(hash);
+    xpf::SharedLockGuard guard{ shard.Lock };
+
+    return shard.Table.Find(KeyToFind, hash) != shard.Table.End();
+}
+
+/**
+ * @brief       Removes the element with the given key.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ *
+ * @return STATUS_SUCCESS if the key was found and removed,
+ *         STATUS_NOT_FOUND if the key was not present.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase
+) noexcept(true)
+{
+    const uint64_t hash = this->m_Hasher(KeyToErase);
+    Shard& shard = this->ShardOfHash(hash);
+    xpf::ExclusiveLockGuard guard{ shard.Lock };
+
+    return shard.Table.Erase(KeyToErase, hash);
+}
+
+/**
+ * @brief       Calls the callback for every element of one shard.
+ *              The shard is locked shared for the whole walk, so it is seen
+ *              in a consistent state.
+ *
+ * @param[in]   ShardIndex - The shard to walk, less than SHARD_COUNT.
+ * @param[in]   Callback   - Called as Callback(const Key&, const Value&).
+ */
+template <class Visitor>
+inline void
+ForEachInShard(
+    _In_ size_t ShardIndex,
+    _In_ Visitor&& Callback
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(ShardIndex < ShardCount);
+
+    Shard& shard = this->m_Shards[ShardIndex].Get();
+    xpf::SharedLockGuard guard{ shard.Lock };
+
+    for (auto it = shard.Table.Begin(); it != shard.Table.End(); ++it)
+    {
+        Callback(static_cast<const Key&>(it.GetKey()),
+                 static_cast<const Value&>(it.GetValue()));
+    }
+}
+
+/**
+ * @brief       Calls the callback for every element, one shard after the other.
+ *              Each shard is consistent on its own; the map as a whole is not a snapshot.
+ *
+ * @param[in]   Callback - Called as Callback(const Key&, const Value&).
+ */
+template <class Visitor>
+inline void
+ForEach(
+    _In_ Visitor&& Callback
+) const noexcept(true)
+{
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        this->ForEachInShard(i, Callback);
+    }
+}
+
+/**
+ * @brief       Makes room for at least Count elements in total,
+ *              assuming the keys spread evenly over the shards.
+ *
+ * @param[in]   Count - The number of elements to make room for.
+ *
+ * @return STATUS_SUCCESS if every shard has enough room,
+ *         STATUS_INSUFFICIENT_RESOURCES if a shard could not grow.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Reserve(
+    _In_ size_t Count
+) noexcept(true)
+{
+    /* Leave some slack - the keys never spread perfectly. */
+    const size_t perShard = (Count / ShardCount) + (Count / (ShardCount * 8)) + 1;
+
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        xpf::ExclusiveLockGuard guard{ this->m_Shards[i].Get().Lock };
+
+        const NTSTATUS status = this->m_Shards[i].Get().Table.Reserve(perShard);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Gets the number of elements. The shards are counted one after
+ *              the other, so with concurrent updates this is only an estimate.
+ *
+ * @return The number of key-value pairs.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        xpf::SharedLockGuard guard{ this->m_Shards[i].Get().Lock };
+        size += this->m_Shards[i].Get().Table.Size();
+    }
+    return size;
+}
+
+/**
+ * @brief Checks if the map is empty. Same caveat as Size().
+ *
+ * @return true if no shard has elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return 0 == this->Size();
+}
+
+/**
+ * @brief Destroys all elements and frees the tables, one shard after the other.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    for (size_t i = 0; i < ShardCount; ++i)
+    {
+        xpf::ExclusiveLockGuard guard{ this->m_Shards[i].Get().Lock };
+        this->m_Shards[i].Get().Table.Clear();
+    }
+}
+
+/**
+ * @brief       Gets the shard holding a key.
+ *
+ * @param[in]   KeyToFind - The key.
+ *
+ * @return The index of the shard, less than SHARD_COUNT.
+ */
+inline size_t
+ShardIndexOf(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return ShardIndexOfHash(this->m_Hasher(KeyToFind));
+}
+
+ private:
+/**
+ * @brief       Computes the shift which keeps only the top log2(ShardCount) bits of a hash.
+ *
+ * @return 64 - log2(ShardCount).
+ */
+static constexpr size_t
+ComputeShardShift(
+    void
+) noexcept(true)
+{
+    size_t bits = 0;
+    while ((size_t{ 1 } << bits) < ShardCount)
+    {
+        bits++;
+    }
+    return 64 - bits;
+}
+
+/**
+ * @brief       Gets the shard for a hash - the top log2(ShardCount) bits.
+ *
+ * @param[in]   Hash - The hash of the key.
+ *
+ * @return The index of the shard, less than SHARD_COUNT.
+ */
+static constexpr size_t
+ShardIndexOfHash(
+    _In_ uint64_t Hash
+) noexcept(true)
+{
+    constexpr size_t shift = ComputeShardShift();
+    return static_cast<size_t>(Hash >> shift);
+}
+
+/**
+ * @brief       Gets the shard holding a key. The hash is computed once by the caller
+ *              and then handed to the table as well.
+ *
+ * @param[in]   Hash - The hash of the key.
+ *
+ * @return A reference to the shard.
+ */
+inline Shard&
+ShardOfHash(
+    _In_ uint64_t Hash
+) const noexcept(true)
+{
+    return this->m_Shards[ShardIndexOfHash(Hash)].Get();
+}
+
+   /**
+    * @brief The shards. Mutable because even the lookups take the locks.
+    */
+    mutable xpf::CacheAligned<Shard> m_Shards[ShardCount];
+
+   /**
+    * @brief The hasher - the same one the tables use.
+    */
+    Hasher m_Hasher{};
+};  // class ConcurrentHashMap
+};  // namespace xpf
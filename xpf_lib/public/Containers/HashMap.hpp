@@ -0,0 +1,1903 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/HashMap.hpp
+ *
+ * @brief       Open-addressing HashTable, HashMap, and HashSet implementations.
+ *              HashTable is the standalone data structure with expected O(1)
+ *              insert/find/erase. It keeps one metadata byte per slot and probes
+ *              a whole group of metadata bytes at once (16 with SSE2, 8 otherwise).
+ *              HashMap and HashSet are thin wrappers storing a HashTable internally.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Containers/String.hpp"
+
+
+/**
+ * @brief The metadata groups are probed with SSE2 when the target has it.
+ *        On MSVC the intrinsics are already available via intrin.h.
+ *        Everywhere else we fall back to a portable 8-byte SWAR group.
+ */
+#if (defined XPF_COMPILER_MSVC && (defined _M_X64 || defined _M_AMD64)) ||                          \
+    ((defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG) && defined __SSE2__)
+
+    #define XPF_HASH_TABLE_SSE2
+
+    #if !defined XPF_COMPILER_MSVC
+        #include <emmintrin.h>
+    #endif
+#endif
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the default hash and equality functors.
+// ************************************************************************************************
+//
+
+/**
+ * @brief       Mixes the bits of a 64-bit value (the murmur3 finalizer).
+ *              Every input bit affects every output bit, so both the low
+ *              bits (used for the slot) and the high bits (used for the
+ *              metadata byte) are well distributed.
+ *
+ * @param[in]   Value - The value to be mixed.
+ *
+ * @return The mixed value.
+ */
+constexpr inline uint64_t
+HashMix(
+    _In_ uint64_t Value
+) noexcept(true)
+{
+    Value ^= Value >> 33;
+    Value *= 0xFF51AFD7ED558CCDull;
+    Value ^= Value >> 33;
+    Value *= 0xC4CEB9FE1A85EC53ull;
+    Value ^= Value >> 33;
+    return Value;
+}
+
+/**
+ * @brief       Hashes a buffer, 8 bytes at a time.
+ *
+ * @param[in]   Buffer - The bytes to be hashed.
+ * @param[in]   Size   - The number of bytes in Buffer.
+ *
+ * @return The hash of the buffer.
+ */
+inline uint64_t
+HashBytes(
+    _In_reads_bytes_(Size) const void* Buffer,
+    _In_ size_t Size
+) noexcept(true)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(Buffer);
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(Size) * 0xFF51AFD7ED558CCDull);
+
+    while (Size != 0)
+    {
+        //
+        // Assemble the next word byte by byte - compilers turn this into a
+        // single unaligned load, and the result does not depend on endianess.
+        //
+        const size_t wordSize = (Size < sizeof(uint64_t)) ? Size
+                                                          : sizeof(uint64_t);
+        uint64_t word = 0;
+        for (size_t i = 0; i < wordSize; ++i)
+        {
+            word |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+        }
+
+        hash ^= word;
+        hash *= 0x9FB21C651E98DF25ull;
+        hash ^= hash >> 32;
+
+        bytes += wordSize;
+        Size -= wordSize;
+    }
+    return xpf::HashMix(hash);
+}
+
+/**
+ * @brief Default hasher. Works for integers, enums and anything else
+ *        which can be converted to an uint64_t.
+ */
+template <class Key>
+struct DefaultHash
+{
+    /**
+     * @brief       Hashes a key.
+     *
+     * @param[in]   KeyToHash - The key to be hashed.
+     *
+     * @return The hash of the key.
+     */
+    inline uint64_t
+    operator()(
+        _In_ _Const_ const Key& KeyToHash
+    ) const noexcept(true)
+    {
+        return xpf::HashMix(static_cast<uint64_t>(KeyToHash));
+    }
+};  // struct DefaultHash
+
+/**
+ * @brief Default hasher for pointers - the address is hashed.
+ */
+template <class Type>
+struct DefaultHash<Type*>
+{
+    /**
+     * @brief       Hashes a pointer.
+     *
+     * @param[in]   KeyToHash - The pointer to be hashed.
+     *
+     * @return The hash of the pointer.
+     */
+    inline uint64_t
+    operator()(
+        _In_opt_ _Const_ const Type* KeyToHash
+    ) const noexcept(true)
+    {
+        return xpf::HashMix(static_cast<uint64_t>(xpf::AlgoPointerToValue(KeyToHash)));
+    }
+};  // struct DefaultHash<Type*>
+
+/**
+ * @brief Default hasher for string views - the characters are hashed.
+ */
+template <class CharType>
+struct DefaultHash<xpf::StringView<CharType>>
+{
+    /**
+     * @brief       Hashes a string view.
+     *
+     * @param[in]   KeyToHash - The string view to be hashed.
+     *
+     * @return The hash of the string view.
+     */
+    inline uint64_t
+    operator()(
+        _In_ _Const_ const xpf::StringView<CharType>& KeyToHash
+    ) const noexcept(true)
+    {
+        return xpf::HashBytes(KeyToHash.Buffer(),
+                              KeyToHash.BufferSize() * sizeof(CharType));
+    }
+};  // struct DefaultHash<xpf::StringView<CharType>>
+
+/**
+ * @brief Default hasher for strings - hashes the same as the string view.
+ */
+template <class CharType>
+struct DefaultHash<xpf::String<CharType>>
+{
+    /**
+     * @brief       Hashes a string.
+     *
+     * @param[in]   KeyToHash - The string to be hashed.
+     *
+     * @return The hash of the string.
+     */
+    inline uint64_t
+    operator()(
+        _In_ _Const_ const xpf::String<CharType>& KeyToHash
+    ) const noexcept(true)
+    {
+        return xpf::DefaultHash<xpf::StringView<CharType>>{}(KeyToHash.View());
+    }
+};  // struct DefaultHash<xpf::String<CharType>>
+
+/**
+ * @brief Default equality functor using operator==.
+ */
+template <class Key>
+struct DefaultKeyEqual
+{
+    /**
+     * @brief       Compares two keys.
+     *
+     * @param[in]   Left  - The left operand.
+     * @param[in]   Right - The right operand.
+     *
+     * @return true if Left is equal to Right, false otherwise.
+     */
+    inline bool
+    operator()(
+        _In_ _Const_ const Key& Left,
+        _In_ _Const_ const Key& Right
+    ) const noexcept(true)
+    {
+        return Left == Right;
+    }
+};  // struct DefaultKeyEqual
+
+/**
+ * @brief Default equality functor for string views - case sensitive.
+ */
+template <class CharType>
+struct DefaultKeyEqual<xpf::StringView<CharType>>
+{
+    /**
+     * @brief       Compares two string views.
+     *
+     * @param[in]   Left  - The left operand.
+     * @param[in]   Right - The right operand.
+     *
+     * @return true if Left is equal to Right, false otherwise.
+     */
+    inline bool
+    operator()(
+        _In_ _Const_ const xpf::StringView<CharType>& Left,
+        _In_ _Const_ const xpf::StringView<CharType>& Right
+    ) const noexcept(true)
+    {
+        return Left.Equals(Right, true);
+    }
+};  // struct DefaultKeyEqual<xpf::StringView<CharType>>
+
+/**
+ * @brief Default equality functor for strings - case sensitive.
+ */
+template <class CharType>
+struct DefaultKeyEqual<xpf::String<CharType>>
+{
+    /**
+     * @brief       Compares two strings.
+     *
+     * @param[in]   Left  - The left operand.
+     * @param[in]   Right - The right operand.
+     *
+     * @return true if Left is equal to Right, false otherwise.
+     */
+    inline bool
+    operator()(
+        _In_ _Const_ const xpf::String<CharType>& Left,
+        _In_ _Const_ const xpf::String<CharType>& Right
+    ) const noexcept(true)
+    {
+        return Left.View().Equals(Right.View(), true);
+    }
+};  // struct DefaultKeyEqual<xpf::String<CharType>>
+
+/**
+ * @brief On windows uuid_t is a GUID structure, so it can be used as a key.
+ *        On linux it is an array type, which can not be stored in a container.
+ */
+#if defined XPF_PLATFORM_WIN_UM || defined XPF_PLATFORM_WIN_KM
+
+/**
+ * @brief Default hasher for uuids - the 16 bytes are hashed.
+ */
+template <>
+struct DefaultHash<uuid_t>
+{
+    /**
+     * @brief       Hashes an uuid.
+     *
+     * @param[in]   KeyToHash - The uuid to be hashed.
+     *
+     * @return The hash of the uuid.
+     */
+    inline uint64_t
+    operator()(
+        _In_ _Const_ const uuid_t& KeyToHash
+    ) const noexcept(true)
+    {
+        return xpf::HashBytes(&KeyToHash, sizeof(KeyToHash));
+    }
+};  // struct DefaultHash<uuid_t>
+
+/**
+ * @brief Default equality functor for uuids.
+ */
+template <>
+struct DefaultKeyEqual<uuid_t>
+{
+    /**
+     * @brief       Compares two uuids.
+     *
+     * @param[in]   Left  - The left operand.
+     * @param[in]   Right - The right operand.
+     *
+     * @return true if Left is equal to Right, false otherwise.
+     */
+    inline bool
+    operator()(
+        _In_ _Const_ const uuid_t& Left,
+        _In_ _Const_ const uuid_t& Right
+    ) const noexcept(true)
+    {
+        return xpf::ApiAreUuidsEqual(Left, Right);
+    }
+};  // struct DefaultKeyEqual<uuid_t>
+
+#endif  // XPF_PLATFORM_WIN_UM || XPF_PLATFORM_WIN_KM
+
+
+//
+// ************************************************************************************************
+// This is the section containing the metadata bytes and the group probing.
+// Each slot has one metadata (control) byte:
+//   EMPTY   = 0x80 (1000 0000) - never used since the last rehash.
+//   DELETED = 0xFE (1111 1110) - a tombstone left by erase.
+//   FULL    = 0xxx xxxx        - the low 7 bits of the hash (H2).
+// The remaining hash bits (H1) select the first group to be probed.
+// ************************************************************************************************
+//
+
+/**
+ * @brief The metadata byte of a slot which was never used since the last rehash.
+ */
+constexpr uint8_t XPF_HASH_TABLE_CONTROL_EMPTY = 0x80;
+
+/**
+ * @brief The metadata byte of a slot which was erased.
+ */
+constexpr uint8_t XPF_HASH_TABLE_CONTROL_DELETED = 0xFE;
+
+/**
+ * @brief A group of consecutive metadata bytes which are inspected at once.
+ *        The Match* methods return a bitmask with one bit set per matching byte;
+ *        use Index() to convert the lowest set bit to a byte index in the group.
+ */
+class HashTableGroup final
+{
+ public:
+#if defined XPF_HASH_TABLE_SSE2
+    /**
+     * @brief The number of metadata bytes in a group - one SSE2 register.
+     */
+    static constexpr size_t WIDTH = 16;
+#else
+    /**
+     * @brief The number of metadata bytes in a group - one 64-bit word.
+     */
+    static constexpr size_t WIDTH = 8;
+#endif
+
+/**
+ * @brief       Loads a group of metadata bytes.
+ *
+ * @param[in]   Control - Points to WIDTH metadata bytes.
+ */
+explicit HashTableGroup(
+    _In_ const uint8_t* Control
+) noexcept(true)
+{
+    #if defined XPF_HASH_TABLE_SSE2
+        this->m_Control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Control));
+    #else
+        this->m_Control = 0;
+        for (size_t i = 0; i < WIDTH; ++i)
+        {
+            this->m_Control |= static_cast<uint64_t>(Control[i]) << (i * 8);
+        }
+    #endif
+}
+
+/**
+ * @brief Default destructor.
+ */
+~HashTableGroup(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be both copied and moved.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(HashTableGroup, default);
+
+/**
+ * @brief       Finds the full slots having the given H2.
+ *
+ * @param[in]   H2 - The low 7 bits of the hash.
+ *
+ * @return A bitmask of the candidates. The portable variant may report
+ *         false positives, which are filtered out by the key comparison.
+ */
+inline uint64_t
+Match(
+    _In_ uint8_t H2
+) const noexcept(true)
+{
+    #if defined XPF_HASH_TABLE_SSE2
+        const __m128i match = _mm_set1_epi8(static_cast<char>(H2));
+        return static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(match, this->m_Control)));
+    #else
+        const uint64_t x = this->m_Control ^ (LSBS * H2);
+        return (x - LSBS) & ~x & MSBS;
+    #endif
+}
+
+/**
+ * @brief       Finds the empty slots.
+ *
+ * @return A bitmask of the empty slots.
+ */
+inline uint64_t
+MatchEmpty(
+    void
+) const noexcept(true)
+{
+    #if defined XPF_HASH_TABLE_SSE2
+        const __m128i match = _mm_set1_epi8(static_cast<char>(XPF_HASH_TABLE_CONTROL_EMPTY));
+        return static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(match, this->m_Control)));
+    #else
+        //
+        // EMPTY is the only value with bit 7 set and bit 1 clear.
+        //
+        return this->m_Control & ~(this->m_Control << 6) & MSBS;
+    #endif
+}
+
+/**
+ * @brief       Finds the slots which can receive a new element.
+ *
+ * @return A bitmask of the empty or deleted slots.
+ */
+inline uint64_t
+MatchEmptyOrDeleted(
+    void
+) const noexcept(true)
+{
+    #if defined XPF_HASH_TABLE_SSE2
+        return static_cast<uint64_t>(_mm_movemask_epi8(this->m_Control));
+    #else
+        return this->m_Control & MSBS;
+    #endif
+}
+
+/**
+ * @brief       Converts the lowest set bit of a bitmask to a byte index.
+ *
+ * @param[in]   Mask - A non-zero bitmask returned by one of the Match* methods.
+ *
+ * @return The index of the first matching byte in the group.
+ */
+static inline size_t
+Index(
+    _In_ uint64_t Mask
+) noexcept(true)
+{
+    #if defined XPF_HASH_TABLE_SSE2
+        return xpf::AlgoCountTrailingZeros(Mask);
+    #else
+        return xpf::AlgoCountTrailingZeros(Mask) >> 3;
+    #endif
+}
+
+ private:
+#if defined XPF_HASH_TABLE_SSE2
+    __m128i m_Control;
+#else
+    static constexpr uint64_t LSBS = 0x0101010101010101ull;
+    static constexpr uint64_t MSBS = 0x8080808080808080ull;
+
+    uint64_t m_Control = 0;
+#endif
+};  // class HashTableGroup
+
+
+//
+// ************************************************************************************************
+// This is the section containing the slot and the iterator.
+// ************************************************************************************************
+//
+
+/**
+ * @brief A slot of the hash table. The memory of the slots is raw -
+ *        the key and the value are constructed only while the slot is full.
+ */
+template <class Key, class Value>
+struct HashTableSlot
+{
+    Key     SlotKey;
+    Value   SlotValue;
+};  // struct HashTableSlot
+
+/**
+ * @brief Minimal forward iterator over the full slots of the hash table.
+ *        The iteration order is unspecified. Any insertion or erase
+ *        invalidates the existing iterators.
+ */
+template <class Key, class Value>
+class HashTableIterator
+{
+ public:
+    /**
+     * @brief Internal slot type alias for readability.
+     */
+    using Slot = HashTableSlot<Key, Value>;
+
+/**
+ * @brief       Iterator constructor.
+ *
+ * @param[in]   Slots    - The slots of the table.
+ * @param[in]   Control  - The metadata bytes of the table.
+ * @param[in]   Index    - The index of a full slot, or Capacity for End().
+ * @param[in]   Capacity - The number of slots in the table.
+ */
+HashTableIterator(
+    _In_opt_ Slot* Slots,
+    _In_opt_ const uint8_t* Control,
+    _In_ size_t Index,
+    _In_ size_t Capacity
+) noexcept(true) : m_Slots{ Slots },
+                   m_Control{ Control },
+                   m_Index{ Index },
+                   m_Capacity{ Capacity }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Default destructor.
+ */
+~HashTableIterator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be both copied and moved.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(HashTableIterator, default);
+
+/**
+ * @brief       Retrieves a const reference to the key of the current slot.
+ *
+ * @return A const reference to the key.
+ *
+ * @note The iterator must be valid (not End()).
+ */
+inline const Key&
+GetKey(
+    void
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(this->m_Index < this->m_Capacity);
+    _Analysis_assume_(nullptr != this->m_Slots);
+
+    return this->m_Slots[this->m_Index].SlotKey;
+}
+
+/**
+ * @brief       Retrieves a reference to the value of the current slot.
+ *
+ * @return A non-const reference to the value.
+ *
+ * @note The iterator must be valid (not End()).
+ */
+inline Value&
+GetValue(
+    void
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(this->m_Index < this->m_Capacity);
+    _Analysis_assume_(nullptr != this->m_Slots);
+
+    return this->m_Slots[this->m_Index].SlotValue;
+}
+
+/**
+ * @brief       Retrieves a const reference to the value of the current slot.
+ *
+ * @return A const reference to the value.
+ *
+ * @note The iterator must be valid (not End()).
+ */
+inline const Value&
+GetValue(
+    void
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(this->m_Index < this->m_Capacity);
+    _Analysis_assume_(nullptr != this->m_Slots);
+
+    return this->m_Slots[this->m_Index].SlotValue;
+}
+
+/**
+ * @brief       Prefix increment operator. Advances to the next full slot.
+ *
+ * @return A reference to this iterator after advancing.
+ */
+inline HashTableIterator&
+operator++(
+    void
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(this->m_Index < this->m_Capacity);
+    _Analysis_assume_(nullptr != this->m_Control);
+
+    do
+    {
+        this->m_Index++;
+    } while ((this->m_Index < this->m_Capacity) &&
+             (0 != (this->m_Control[this->m_Index] & XPF_HASH_TABLE_CONTROL_EMPTY)));
+
+    return *this;
+}
+
+/**
+ * @brief       Equality operator.
+ *
+ * @param[in]   Other - The other iterator to compare against.
+ *
+ * @return true if both iterators point to the same slot, false otherwise.
+ */
+inline bool
+operator==(
+    _In_ _Const_ const HashTableIterator& Other
+) const noexcept(true)
+{
+    return (this->m_Slots == Other.m_Slots) && (this->m_Index == Other.m_Index);
+}
+
+/**
+ * @brief       Inequality operator.
+ *
+ * @param[in]   Other - The other iterator to compare against.
+ *
+ * @return true if the iterators point to different slots, false otherwise.
+ */
+inline bool
+operator!=(
+    _In_ _Const_ const HashTableIterator& Other
+) const noexcept(true)
+{
+    return !(*this == Other);
+}
+
+ private:
+    Slot* m_Slots = nullptr;
+    const uint8_t* m_Control = nullptr;
+    size_t m_Index = 0;
+    size_t m_Capacity = 0;
+};  // class HashTableIterator
+
+
+//
+// ************************************************************************************************
+// This is the section containing the HashTable implementation.
+// The table is a single allocation:
+//
+//     [Slot 0][Slot 1]...[Slot Capacity - 1][Control 0][Control 1]...[Control Capacity - 1]
+//
+// The capacity is a power of two and a multiple of the group width. The groups are
+// aligned (group g covers the bytes [g * WIDTH, (g + 1) * WIDTH)) and are probed
+// triangularly: g, g + 1, g + 3, g + 6, ... which visits every group exactly once.
+// At most 7/8 of the slots are used, so every probe sequence ends in an empty slot.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Open-addressing hash table.
+ *        Provides expected O(1) insert, find, and erase operations.
+ *        This is the standalone data structure containing all the hashing logic.
+ *        HashMap and HashSet are thin wrappers over this class.
+ *
+ *        Emplace is an upsert: if the key already exists, the value is
+ *        updated in place via move-assign (no allocation). If the key is new,
+ *        it is placed in the first free slot of its probe sequence, growing
+ *        the table when the load factor is exceeded.
+ */
+template <class Key,
+          class Value,
+          class Hasher = DefaultHash<Key>,
+          class KeyEqual = DefaultKeyEqual<Key>>
+class HashTable final
+{
+ public:
+    /**
+     * @brief Internal slot type alias.
+     */
+    using Slot = HashTableSlot<Key, Value>;
+
+    /**
+     * @brief Iterator type over the full slots.
+     */
+    using Iterator = HashTableIterator<Key, Value>;
+
+    /**
+     * @brief The control bytes are stored right after the slots,
+     *        so the allocator alignment must be enough for the slots.
+     */
+    static_assert(alignof(Slot) <= XPF_DEFAULT_ALIGNMENT, "Over-aligned slots are not supported!");
+
+/**
+ * @brief       HashTable constructor - default.
+ *              No memory is allocated until the first insertion.
+ *
+ * @param[in]   Allocator - to be used when allocating the table.
+ */
+HashTable(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Allocator{ Allocator }
+{
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
+}
+
+/**
+ * @brief Destructor. Destroys all elements and frees the table.
+ */
+~HashTable(
+    void
+) noexcept(true)
+{
+    this->Clear();
+}
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+HashTable(
+    _In_ _Const_ const HashTable& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor. Steals the table from Other.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+HashTable(
+    _Inout_ HashTable&& Other
+) noexcept(true)
+{
+    this->Steal(Other);
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+HashTable&
+operator=(
+    _In_ _Const_ const HashTable& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment. Steals the table from Other.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+HashTable&
+operator=(
+    _Inout_ HashTable&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->Clear();
+        this->Steal(Other);
+    }
+    return *this;
+}
+
+/**
+ * @brief       Inserts or updates a key-value pair in the table.
+ *              If the key already exists, the value is updated via move-assign (no allocation).
+ *              If the key is new, it is moved into a free slot - the table may be rehashed first.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ *
+ * @return STATUS_SUCCESS if the key-value pair was inserted or updated successfully,
+ *         STATUS_INSUFFICIENT_RESOURCES if the table could not grow.
+ *         On failure the table is left unchanged.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    const uint64_t hash = this->m_Hasher(KeyToInsert);
+    return this->Emplace(xpf::Move(KeyToInsert),
+                         xpf::Move(ValueToInsert),
+                         hash);
+}
+
+/**
+ * @brief       Same as Emplace above, for a caller which already hashed the key -
+ *              for example to pick a shard - so it is not hashed again.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ * @param[in]       Hash          - The hash of KeyToInsert, as computed by the Hasher of this table.
+ *
+ * @return STATUS_SUCCESS if the key-value pair was inserted or updated successfully,
+ *         STATUS_INSUFFICIENT_RESOURCES if the table could not grow.
+ *         On failure the table is left unchanged.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert,
+    _In_ uint64_t Hash
+) noexcept(true)
+{
+    //
+    // Upsert - if the key is already here, only the value changes.
+    //
+    const size_t existing = this->FindIndex(KeyToInsert, Hash);
+    if (existing != this->m_Capacity)
+    {
+        this->m_Slots[existing].SlotValue = xpf::Move(ValueToInsert);
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // A tombstone can be reused without consuming the growth budget.
+    // Otherwise, when the budget is exhausted, we rehash first.
+    //
+    size_t target = this->FindFirstNonFull(Hash);
+    const bool isTombstone = (target != this->m_Capacity) &&
+                             (XPF_HASH_TABLE_CONTROL_DELETED == this->m_Control[target]);
+    if ((0 == this->m_GrowthLeft) && (!isTombstone))
+    {
+        const NTSTATUS status = this->Rehash(this->m_Size + 1);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+        target = this->FindFirstNonFull(Hash);
+    }
+    XPF_DEATH_ON_FAILURE(target < this->m_Capacity);
+
+    if (XPF_HASH_TABLE_CONTROL_EMPTY == this->m_Control[target])
+    {
+        this->m_GrowthLeft--;
+    }
+    this->ConstructSlot(target,
+                        Hash,
+                        xpf::Move(KeyToInsert),
+                        xpf::Move(ValueToInsert));
+    this->m_Size++;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Finds the element with the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator pointing to the element, or End() if not found.
+ */
+inline Iterator
+Find(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->Find(KeyToFind, this->m_Hasher(KeyToFind));
+}
+
+/**
+ * @brief       Finds the element with the given key, which the caller already hashed.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ * @param[in]   Hash      - The hash of KeyToFind, as computed by the Hasher of this table.
+ *
+ * @return An iterator pointing to the element, or End() if not found.
+ */
+inline Iterator
+Find(
+    _In_ _Const_ const Key& KeyToFind,
+    _In_ uint64_t Hash
+) const noexcept(true)
+{
+    const size_t index = this->FindIndex(KeyToFind, Hash);
+    return Iterator{ this->m_Slots, this->m_Control, index, this->m_Capacity };
+}
+
+/**
+ * @brief       Removes the element with the given key.
+ *              The memory of the table is kept - use Clear() to release it.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ *
+ * @return STATUS_SUCCESS if the key was found and removed,
+ *         STATUS_NOT_FOUND if the key was not present.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase
+) noexcept(true)
+{
+    return this->Erase(KeyToErase, this->m_Hasher(KeyToErase));
+}
+
+/**
+ * @brief       Removes the element with the given key, which the caller already hashed.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ * @param[in]   Hash       - The hash of KeyToErase, as computed by the Hasher of this table.
+ *
+ * @return STATUS_SUCCESS if the key was found and removed,
+ *         STATUS_NOT_FOUND if the key was not present.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase,
+    _In_ uint64_t Hash
+) noexcept(true)
+{
+    const size_t index = this->FindIndex(KeyToErase, Hash);
+    if (index == this->m_Capacity)
+    {
+        return STATUS_NOT_FOUND;
+    }
+
+    xpf::MemoryAllocator::Destruct(xpf::AddressOf(this->m_Slots[index].SlotKey));
+    xpf::MemoryAllocator::Destruct(xpf::AddressOf(this->m_Slots[index].SlotValue));
+    this->m_Size--;
+
+    //
+    // A probe sequence stops at the first group having an empty byte.
+    // If this group already has one, no probe ever went past it, so the
+    // slot can become empty again. Otherwise we leave a tombstone.
+    //
+    const size_t groupStart = index & ~(HashTableGroup::WIDTH - 1);
+    if (0 != HashTableGroup{ xpf::AddressOf(this->m_Control[groupStart]) }.MatchEmpty())
+    {
+        this->m_Control[index] = XPF_HASH_TABLE_CONTROL_EMPTY;
+        this->m_GrowthLeft++;
+    }
+    else
+    {
+        this->m_Control[index] = XPF_HASH_TABLE_CONTROL_DELETED;
+    }
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Makes room for at least Count elements, so the next
+ *              insertions up to Count will not rehash the table.
+ *
+ * @param[in]   Count - The number of elements to make room for.
+ *
+ * @return STATUS_SUCCESS if the table has enough room,
+ *         STATUS_INSUFFICIENT_RESOURCES if the table could not grow.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Reserve(
+    _In_ size_t Count
+) noexcept(true)
+{
+    if (Count <= this->m_Size + this->m_GrowthLeft)
+    {
+        return STATUS_SUCCESS;
+    }
+    return this->Rehash(Count);
+}
+
+/**
+ * @brief       Returns an iterator to the first full slot.
+ *
+ * @return An iterator to the first element, or End() if the table is empty.
+ */
+inline Iterator
+Begin(
+    void
+) const noexcept(true)
+{
+    size_t index = 0;
+    while ((index < this->m_Capacity) &&
+           (0 != (this->m_Control[index] & XPF_HASH_TABLE_CONTROL_EMPTY)))
+    {
+        index++;
+    }
+    return Iterator{ this->m_Slots, this->m_Control, index, this->m_Capacity };
+}
+
+/**
+ * @brief       Returns a sentinel iterator representing past-the-end.
+ *
+ * @return An iterator with the index equal to the capacity.
+ */
+inline Iterator
+End(
+    void
+) const noexcept(true)
+{
+    return Iterator{ this->m_Slots, this->m_Control, this->m_Capacity, this->m_Capacity };
+}
+
+/**
+ * @brief Gets the number of elements in the table.
+ *
+ * @return The number of key-value pairs.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Size;
+}
+
+/**
+ * @brief Gets the number of slots in the table.
+ *
+ * @return The number of slots - at most 7/8 of them can be used.
+ */
+inline size_t
+Capacity(
+    void
+) const noexcept(true)
+{
+    return this->m_Capacity;
+}
+
+/**
+ * @brief Checks if the table is empty.
+ *
+ * @return true if the table has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return (this->m_Size == 0);
+}
+
+/**
+ * @brief Destroys all elements and frees the table.
+ *        After this call, the table is empty.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    this->DestroyTable(this->m_Slots, this->m_Control, this->m_Capacity);
+
+    this->m_Slots = nullptr;
+    this->m_Control = nullptr;
+    this->m_Capacity = 0;
+    this->m_Size = 0;
+    this->m_GrowthLeft = 0;
+}
+
+/**
+ * @brief Gets the underlying allocator.
+ *
+ * @return A const reference to the underlying allocator.
+ */
+inline const xpf::PolymorphicAllocator&
+GetAllocator(
+    void
+) const noexcept(true)
+{
+    return this->m_Allocator;
+}
+
+ private:
+/**
+ * @brief       Computes the number of elements a table of the given capacity can hold.
+ *
+ * @param[in]   Capacity - The number of slots.
+ *
+ * @return The maximum number of elements - 7/8 of the capacity.
+ */
+static inline size_t
+MaxLoad(
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    return Capacity - (Capacity / 8);
+}
+
+/**
+ * @brief       Searches the probe sequence of a key for a slot holding it.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ * @param[in]   Hash      - The hash of KeyToFind.
+ *
+ * @return The index of the slot, or m_Capacity if the key is not present.
+ */
+inline size_t
+FindIndex(
+    _In_ _Const_ const Key& KeyToFind,
+    _In_ uint64_t Hash
+) const noexcept(true)
+{
+    if (0 == this->m_Capacity)
+    {
+        return this->m_Capacity;
+    }
+
+    const uint8_t h2 = static_cast<uint8_t>(Hash & 0x7F);
+    const size_t groupMask = (this->m_Capacity / HashTableGroup::WIDTH) - 1;
+
+    size_t group = static_cast<size_t>(Hash >> 7) & groupMask;
+    size_t step = 0;
+
+    while (true)
+    {
+        const size_t groupStart = group * HashTableGroup::WIDTH;
+        const HashTableGroup metadata{ xpf::AddressOf(this->m_Control[groupStart]) };
+
+        for (uint64_t mask = metadata.Match(h2); mask != 0; mask &= (mask - 1))
+        {
+            const size_t index = groupStart + HashTableGroup::Index(mask);
+            if (this->m_KeyEqual(this->m_Slots[index].SlotKey, KeyToFind))
+            {
+                return index;
+            }
+        }
+
+        //
+        // An empty byte means the key would have been placed here.
+        //
+        if (0 != metadata.MatchEmpty())
+        {
+            return this->m_Capacity;
+        }
+
+        step++;
+        group = (group + step) & groupMask;
+        XPF_DEATH_ON_FAILURE(step <= groupMask);
+    }
+}
+
+/**
+ * @brief       Searches the probe sequence of a hash for an empty or deleted slot.
+ *
+ * @param[in]   Hash - The hash of the key to be inserted.
+ *
+ * @return The index of the slot, or m_Capacity if the table is not allocated.
+ */
+inline size_t
+FindFirstNonFull(
+    _In_ uint64_t Hash
+) const noexcept(true)
+{
+    if (0 == this->m_Capacity)
+    {
+        return this->m_Capacity;
+    }
+
+    const size_t groupMask = (this->m_Capacity / HashTableGroup::WIDTH) - 1;
+
+    size_t group = static_cast<size_t>(Hash >> 7) & groupMask;
+    size_t step = 0;
+
+    while (true)
+    {
+        const size_t groupStart = group * HashTableGroup::WIDTH;
+        const HashTableGroup metadata{ xpf::AddressOf(this->m_Control[groupStart]) };
+
+        const uint64_t mask = metadata.MatchEmptyOrDeleted();
+        if (0 != mask)
+        {
+            return groupStart + HashTableGroup::Index(mask);
+        }
+
+        step++;
+        group = (group + step) & groupMask;
+        XPF_DEATH_ON_FAILURE(step <= groupMask);
+    }
+}
+
+/**
+ * @brief       Moves a key-value pair into a slot and marks it as full.
+ *
+ * @param[in]       Index         - The index of an empty or deleted slot.
+ * @param[in]       Hash          - The hash of the key.
+ * @param[in,out]   KeyToInsert   - The key to insert. Will be moved.
+ * @param[in,out]   ValueToInsert - The value to insert. Will be moved.
+ */
+inline void
+ConstructSlot(
+    _In_ size_t Index,
+    _In_ uint64_t Hash,
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    xpf::MemoryAllocator::Construct(xpf::AddressOf(this->m_Slots[Index].SlotKey),
+                                    xpf::Move(KeyToInsert));
+    xpf::MemoryAllocator::Construct(xpf::AddressOf(this->m_Slots[Index].SlotValue),
+                                    xpf::Move(ValueToInsert));
+    this->m_Control[Index] = static_cast<uint8_t>(Hash & 0x7F);
+}
+
+/**
+ * @brief       Moves all elements into a new table able to hold at least Count elements.
+ *              The new capacity is chosen so that the tombstones are dropped and,
+ *              when the table is more than half full, it doubles.
+ *
+ * @param[in]   Count - The number of elements the new table must hold.
+ *
+ * @return STATUS_SUCCESS if the elements were moved,
+ *         STATUS_INSUFFICIENT_RESOURCES if the new table could not be allocated.
+ *         On failure the table is left unchanged.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Rehash(
+    _In_ size_t Count
+) noexcept(true)
+{
+    //
+    // Keep the capacity when only the tombstones must go - at most 7/16 used,
+    // so a same-size rehash frees at least half of the slots. Otherwise grow.
+    //
+    size_t newCapacity = (this->m_Capacity < HashTableGroup::WIDTH) ? HashTableGroup::WIDTH
+                                                                    : this->m_Capacity;
+    if (this->m_Size > (newCapacity * 7) / 16)
+    {
+        newCapacity = newCapacity * 2;
+    }
+    while (MaxLoad(newCapacity) < Count)
+    {
+        if (newCapacity > (xpf::NumericLimits<size_t>::MaxValue() / 2))
+        {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+        newCapacity = newCapacity * 2;
+    }
+
+    //
+    // [slots][control bytes] in one allocation.
+    //
+    size_t slotsSize = 0;
+    size_t tableSize = 0;
+    if (!xpf::ApiNumbersSafeMul(newCapacity, sizeof(Slot), &slotsSize) ||
+        !xpf::ApiNumbersSafeAdd(slotsSize, newCapacity, &tableSize))
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    void* table = this->m_Allocator.AllocateMemory(tableSize);
+    if (nullptr == table)
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    Slot* oldSlots = this->m_Slots;
+    uint8_t* oldControl = this->m_Control;
+    const size_t oldCapacity = this->m_Capacity;
+
+    this->m_Slots = static_cast<Slot*>(table);
+    this->m_Control = static_cast<uint8_t*>(xpf::AlgoAddToPointer(table, slotsSize));
+    this->m_Capacity = newCapacity;
+    this->m_GrowthLeft = MaxLoad(newCapacity) - this->m_Size;
+
+    for (size_t i = 0; i < newCapacity; ++i)
+    {
+        this->m_Control[i] = XPF_HASH_TABLE_CONTROL_EMPTY;
+    }
+
+    //
+    // The keys are unique, so they go straight into the first free slot.
+    //
+    for (size_t i = 0; i < oldCapacity; ++i)
+    {
+        if (0 == (oldControl[i] & XPF_HASH_TABLE_CONTROL_EMPTY))
+        {
+            const uint64_t hash = this->m_Hasher(oldSlots[i].SlotKey);
+            this->ConstructSlot(this->FindFirstNonFull(hash),
+                                hash,
+                                xpf::Move(oldSlots[i].SlotKey),
+                                xpf::Move(oldSlots[i].SlotValue));
+        }
+    }
+
+    this->DestroyTable(oldSlots, oldControl, oldCapacity);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Destroys the full slots of a table and frees its memory.
+ *
+ * @param[in,out]   Slots    - The slots of the table. Can be nullptr.
+ * @param[in]       Control  - The metadata bytes of the table.
+ * @param[in]       Capacity - The number of slots.
+ */
+inline void
+DestroyTable(
+    _Inout_opt_ Slot* Slots,
+    _In_opt_ const uint8_t* Control,
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    if (nullptr == Slots)
+    {
+        return;
+    }
+    _Analysis_assume_(nullptr != Control);
+
+    for (size_t i = 0; i < Capacity; ++i)
+    {
+        if (0 == (Control[i] & XPF_HASH_TABLE_CONTROL_EMPTY))
+        {
+            xpf::MemoryAllocator::Destruct(xpf::AddressOf(Slots[i].SlotKey));
+            xpf::MemoryAllocator::Destruct(xpf::AddressOf(Slots[i].SlotValue));
+        }
+    }
+    this->m_Allocator.FreeMemory(Slots);
+}
+
+/**
+ * @brief       Takes over the table of Other and leaves Other empty.
+ *
+ * @param[in,out]   Other - The table to steal from.
+ */
+inline void
+Steal(
+    _Inout_ HashTable& Other
+) noexcept(true)
+{
+    this->m_Allocator = Other.m_Allocator;
+    this->m_Slots = Other.m_Slots;
+    this->m_Control = Other.m_Control;
+    this->m_Capacity = Other.m_Capacity;
+    this->m_Size = Other.m_Size;
+    this->m_GrowthLeft = Other.m_GrowthLeft;
+    this->m_Hasher = Other.m_Hasher;
+    this->m_KeyEqual = Other.m_KeyEqual;
+
+    Other.m_Slots = nullptr;
+    Other.m_Control = nullptr;
+    Other.m_Capacity = 0;
+    Other.m_Size = 0;
+    Other.m_GrowthLeft = 0;
+}
+
+   /**
+    * @brief The allocator used for the table.
+    */
+    xpf::PolymorphicAllocator m_Allocator;
+
+   /**
+    * @brief The slots - the start of the table allocation.
+    */
+    Slot* m_Slots = nullptr;
+
+   /**
+    * @brief The metadata bytes - they follow the slots in the same allocation.
+    */
+    uint8_t* m_Control = nullptr;
+
+   /**
+    * @brief The number of slots. Zero or a power of two multiple of the group width.
+    */
+    size_t m_Capacity = 0;
+
+   /**
+    * @brief The number of elements currently in the table.
+    */
+    size_t m_Size = 0;
+
+   /**
+    * @brief The number of empty slots which can still be filled before a rehash.
+    */
+    size_t m_GrowthLeft = 0;
+
+   /**
+    * @brief The functor used to hash the keys.
+    */
+    Hasher m_Hasher{};
+
+   /**
+    * @brief The functor used to compare the keys.
+    */
+    KeyEqual m_KeyEqual{};
+};  // class HashTable
+
+
+//
+// ************************************************************************************************
+// This is the section containing the HashMap implementation.
+// A thin wrapper over HashTable<Key, Value, Hasher, KeyEqual>.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Unordered associative container mapping keys to values.
+ *        Internally stores a HashTable and delegates all operations to it.
+ */
+template <class Key,
+          class Value,
+          class Hasher = DefaultHash<Key>,
+          class KeyEqual = DefaultKeyEqual<Key>>
+class HashMap final
+{
+ public:
+    /**
+     * @brief Iterator type over the elements.
+     */
+    using Iterator = typename HashTable<Key, Value, Hasher, KeyEqual>::Iterator;
+
+/**
+ * @brief       HashMap constructor - default.
+ *
+ * @param[in]   Allocator - to be used when allocating the table.
+ */
+HashMap(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Table{ Allocator }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Destructor.
+ */
+~HashMap(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+HashMap(
+    _In_ _Const_ const HashMap& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+HashMap(
+    _Inout_ HashMap&& Other
+) noexcept(true) : m_Table{ xpf::Move(Other.m_Table) }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+HashMap&
+operator=(
+    _In_ _Const_ const HashMap& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+HashMap&
+operator=(
+    _Inout_ HashMap&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->m_Table = xpf::Move(Other.m_Table);
+    }
+    return *this;
+}
+
+/**
+ * @brief       Inserts or updates a key-value pair in the map.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INSUFFICIENT_RESOURCES if allocation failed.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    return this->m_Table.Emplace(xpf::Move(KeyToInsert),
+                                 xpf::Move(ValueToInsert));
+}
+
+/**
+ * @brief       Finds the element with the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator pointing to the element, or End() if not found.
+ */
+inline Iterator
+Find(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Table.Find(KeyToFind);
+}
+
+/**
+ * @brief       Removes the element with the given key.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ *
+ * @return STATUS_SUCCESS if the key was found and removed,
+ *         STATUS_NOT_FOUND if the key was not present.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase
+) noexcept(true)
+{
+    return this->m_Table.Erase(KeyToErase);
+}
+
+/**
+ * @brief       Makes room for at least Count elements.
+ *
+ * @param[in]   Count - The number of elements to make room for.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INSUFFICIENT_RESOURCES if allocation failed.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Reserve(
+    _In_ size_t Count
+) noexcept(true)
+{
+    return this->m_Table.Reserve(Count);
+}
+
+/**
+ * @brief       Returns an iterator to the first element.
+ *
+ * @return An iterator to the first element, or End() if empty.
+ */
+inline Iterator
+Begin(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.Begin();
+}
+
+/**
+ * @brief       Returns a sentinel iterator representing past-the-end.
+ *
+ * @return The end iterator.
+ */
+inline Iterator
+End(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.End();
+}
+
+/**
+ * @brief Gets the number of elements in the map.
+ *
+ * @return The number of key-value pairs.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.Size();
+}
+
+/**
+ * @brief Checks if the map is empty.
+ *
+ * @return true if the map has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.IsEmpty();
+}
+
+/**
+ * @brief Destroys all elements and frees the table.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    this->m_Table.Clear();
+}
+
+/**
+ * @brief Gets the underlying allocator.
+ *
+ * @return A const reference to the underlying allocator.
+ */
+inline const xpf::PolymorphicAllocator&
+GetAllocator(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.GetAllocator();
+}
+
+ private:
+    HashTable<Key, Value, Hasher, KeyEqual> m_Table;
+};  // class HashMap
+
+
+//
+// ************************************************************************************************
+// This is the section containing the HashSet implementation.
+// A thin wrapper over HashTable<Key, uint8_t, Hasher, KeyEqual>.
+// ************************************************************************************************
+//
+
+/**
+ * @brief An unordered set implementation backed by a hash table.
+ *        Internally wraps HashTable<Key, uint8_t> with uint8_t as a dummy value.
+ */
+template <class Key,
+          class Hasher = DefaultHash<Key>,
+          class KeyEqual = DefaultKeyEqual<Key>>
+class HashSet final
+{
+ public:
+    /**
+     * @brief Iterator type. Returns keys only (value is a dummy uint8_t).
+     */
+    using Iterator = typename HashTable<Key, uint8_t, Hasher, KeyEqual>::Iterator;
+
+/**
+ * @brief       HashSet constructor - default.
+ *
+ * @param[in]   Allocator - to be used when allocating the table.
+ */
+HashSet(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Table{ Allocator }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Destructor.
+ */
+~HashSet(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+HashSet(
+    _In_ _Const_ const HashSet& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+HashSet(
+    _Inout_ HashSet&& Other
+) noexcept(true) : m_Table{ xpf::Move(Other.m_Table) }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+HashSet&
+operator=(
+    _In_ _Const_ const HashSet& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+HashSet&
+operator=(
+    _Inout_ HashSet&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->m_Table = xpf::Move(Other.m_Table);
+    }
+    return *this;
+}
+
+/**
+ * @brief       Inserts a key into the set.
+ *              If the key already exists, this is a no-op (idempotent).
+ *
+ * @param[in,out]   KeyToInsert - The key to insert. Will be moved.
+ *
+ * @return STATUS_SUCCESS if the key was inserted or already existed,
+ *         STATUS_INSUFFICIENT_RESOURCES if allocation failed.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Insert(
+    _Inout_ Key&& KeyToInsert
+) noexcept(true)
+{
+    uint8_t dummyValue = 0;
+    return this->m_Table.Emplace(xpf::Move(KeyToInsert),
+                                 xpf::Move(dummyValue));
+}
+
+/**
+ * @brief       Checks if the set contains the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return true if the key exists in the set, false otherwise.
+ */
+inline bool
+Contains(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return (this->m_Table.Find(KeyToFind) != this->m_Table.End());
+}
+
+/**
+ * @brief       Removes a key from the set.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ *
+ * @return STATUS_SUCCESS if the key was found and removed,
+ *         STATUS_NOT_FOUND if the key was not present.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase
+) noexcept(true)
+{
+    return this->m_Table.Erase(KeyToErase);
+}
+
+/**
+ * @brief       Makes room for at least Count keys.
+ *
+ * @param[in]   Count - The number of keys to make room for.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INSUFFICIENT_RESOURCES if allocation failed.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Reserve(
+    _In_ size_t Count
+) noexcept(true)
+{
+    return this->m_Table.Reserve(Count);
+}
+
+/**
+ * @brief       Returns an iterator to the first key.
+ *              Use GetKey() on the iterator to access the key.
+ *
+ * @return An iterator to the first element, or End() if empty.
+ */
+inline Iterator
+Begin(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.Begin();
+}
+
+/**
+ * @brief       Returns a sentinel iterator representing past-the-end.
+ *
+ * @return The end iterator.
+ */
+inline Iterator
+End(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.End();
+}
+
+/**
+ * @brief Gets the number of keys in the set.
+ *
+ * @return The number of keys.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.Size();
+}
+
+/**
+ * @brief Checks if the set is empty.
+ *
+ * @return true if the set has no keys, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return this->m_Table.IsEmpty();
+}
+
+/**
+ * @brief Destroys all keys and frees the table.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    this->m_Table.Clear();
+}
+
+ private:
+    HashTable<Key, uint8_t, Hasher, KeyEqual> m_Table;
+};  // class HashSet
+};  // namespace xpf
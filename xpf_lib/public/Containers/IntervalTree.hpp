@@ -0,0 +1,628 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/IntervalTree.hpp
+ *
+ * @brief       Ordered collection of half-open intervals [Low, High) answering
+ *              "which intervals contain this point" and "which intervals overlap
+ *              this range". A single match is found in O(log n), all k matches
+ *              in O(min(n, k * log n)).
+ *              A red-black tree ordered by Low, augmented with the largest High
+ *              of every subtree.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Containers/RedBlackTree.hpp"
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the interval key and the interval augmentation.
+// The intervals are ordered by Low, then by High, so two intervals may start
+// at the same point. Each node also knows the largest High in its subtree:
+//
+//                       [10, 20) max 40
+//                      /               \    the left child ends last
+//           [5, 40) max 40        [15, 18) max 30
+//                                          \    [25, 30) ends after [15, 18)
+//                                     [25, 30) max 30
+//
+// A subtree whose largest High is <= the query start holds no interval
+// reaching the query, so it is skipped as a whole.
+// ************************************************************************************************
+//
+
+/**
+ * @brief A half-open interval [Low, High). It is the key of the interval tree.
+ */
+template <class Bound>
+struct IntervalTreeKey
+{
+    Bound Low{};
+    Bound High{};
+};  // struct IntervalTreeKey
+
+/**
+ * @brief Orders the intervals by Low, then by High, using operator< on the bounds.
+ */
+template <class Bound>
+struct IntervalTreeCompare
+{
+    /**
+     * @brief       Compares two intervals.
+     *
+     * @param[in]   Left  - The left operand.
+     * @param[in]   Right - The right operand.
+     *
+     * @return true if Left is ordered before Right, false otherwise.
+     */
+    inline bool
+    operator()(
+        _In_ _Const_ const IntervalTreeKey<Bound>& Left,
+        _In_ _Const_ const IntervalTreeKey<Bound>& Right
+    ) const noexcept(true)
+    {
+        if (Left.Low < Right.Low)
+        {
+            return true;
+        }
+        if (Right.Low < Left.Low)
+        {
+            return false;
+        }
+        return Left.High < Right.High;
+    }
+};  // struct IntervalTreeCompare
+
+/**
+ * @brief Red-black tree augmentation keeping the largest interval end of each subtree.
+ */
+template <class Bound>
+struct IntervalTreeAugmentation
+{
+    /**
+     * @brief The per-node data - the largest High in the subtree rooted here.
+     */
+    struct Summary
+    {
+        Bound MaxHigh{};
+    };
+
+    /**
+     * @brief       Recomputes the largest High of a node from its interval and its children.
+     *
+     * @param[in,out]   TreeNode - The node whose summary is recomputed.
+     */
+    template <class Node>
+    static inline void
+    Update(
+        _Inout_ Node* TreeNode
+    ) noexcept(true)
+    {
+        TreeNode->MaxHigh = TreeNode->NodeKey.High;
+        if ((nullptr != TreeNode->Left) && (TreeNode->MaxHigh < TreeNode->Left->MaxHigh))
+        {
+            TreeNode->MaxHigh = TreeNode->Left->MaxHigh;
+        }
+        if ((nullptr != TreeNode->Right) && (TreeNode->MaxHigh < TreeNode->Right->MaxHigh))
+        {
+            TreeNode->MaxHigh = TreeNode->Right->MaxHigh;
+        }
+    }
+};  // struct IntervalTreeAugmentation
+
+
+//
+// ************************************************************************************************
+// This is the section containing the IntervalTree implementation.
+// A thin wrapper over RedBlackTree<IntervalTreeKey, Value, IntervalTreeCompare, IntervalTreeAugmentation>.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Collection of half-open intervals [Low, High), each with a value.
+ *        A point P is contained by [Low, High) when Low <= P < High.
+ *        Two intervals overlap when each starts before the other ends.
+ *        Bound needs operator<, like the keys of Map.
+ *
+ *        Emplace is an upsert on the (Low, High) pair.
+ */
+template <class Bound, class Value>
+class IntervalTree final
+{
+ public:
+    /**
+     * @brief The key type - an interval.
+     */
+    using Interval = IntervalTreeKey<Bound>;
+
+    /**
+     * @brief The underlying tree type.
+     */
+    using TreeType = RedBlackTree<Interval, Value, IntervalTreeCompare<Bound>, IntervalTreeAugmentation<Bound>>;
+
+    /**
+     * @brief Iterator type for in-order traversal. GetKey() returns the interval.
+     */
+    using Iterator = typename TreeType::Iterator;
+
+    /**
+     * @brief Internal node type alias.
+     */
+    using Node = typename TreeType::Node;
+
+/**
+ * @brief       IntervalTree constructor - default.
+ *
+ * @param[in]   Allocator - to be used when performing node allocations.
+ */
+IntervalTree(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Tree{ Allocator }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Destructor.
+ */
+~IntervalTree(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+IntervalTree(
+    _In_ _Const_ const IntervalTree& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+IntervalTree(
+    _Inout_ IntervalTree&& Other
+) noexcept(true) : m_Tree{ xpf::Move(Other.m_Tree) }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+IntervalTree&
+operator=(
+    _In_ _Const_ const IntervalTree& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+IntervalTree&
+operator=(
+    _Inout_ IntervalTree&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->m_Tree = xpf::Move(Other.m_Tree);
+    }
+    return *this;
+}
+
+/**
+ * @brief       Inserts an interval, or updates its value if it is already present.
+ *
+ * @param[in]       Low           - The first point of the interval.
+ * @param[in]       High          - The point right after the interval. Must be greater than Low.
+ * @param[in,out]   ValueToInsert - The value of the interval. Moved on success.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INVALID_PARAMETER if the interval is empty (High <= Low),
+ *         STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    _In_ _Const_ const Bound& Low,
+    _In_ _Const_ const Bound& High,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    if (!(Low < High))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Interval interval{ Low, High };
+    return this->m_Tree.Emplace(xpf::Move(interval),
+                                xpf::Move(ValueToInsert));
+}
+
+/**
+ * @brief       Finds the interval with exactly the given bounds.
+ *
+ * @param[in]   Low  - The first point of the interval.
+ * @param[in]   High - The point right after the interval.
+ *
+ * @return An iterator pointing to the interval, or End() if not found.
+ */
+inline Iterator
+Find(
+    _In_ _Const_ const Bound& Low,
+    _In_ _Const_ const Bound& High
+) const noexcept(true)
+{
+    return this->m_Tree.Find(Interval{ Low, High });
+}
+
+/**
+ * @brief       Removes the interval with exactly the given bounds.
+ *
+ * @param[in]   Low  - The first point of the interval.
+ * @param[in]   High - The point right after the interval.
+ *
+ * @return STATUS_SUCCESS if removed, STATUS_NOT_FOUND if absent.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Bound& Low,
+    _In_ _Const_ const Bound& High
+) noexcept(true)
+{
+    return this->m_Tree.Erase(Interval{ Low, High });
+}
+
+/**
+ * @brief       Finds an interval containing the given point. O(log n).
+ *              When the intervals do not overlap (such as the address ranges
+ *              of loaded modules) this is the only one.
+ *
+ * @param[in]   Point - The point to look for.
+ *
+ * @return An iterator to an interval with Low <= Point < High, or End().
+ */
+inline Iterator
+FindContaining(
+    _In_ _Const_ const Bound& Point
+) const noexcept(true)
+{
+    return Iterator{ this->FindAnyOverlap(Point, Point, true) };
+}
+
+/**
+ * @brief       Finds an interval overlapping the range [Low, High). O(log n).
+ *
+ * @param[in]   Low  - The first point of the range.
+ * @param[in]   High - The point right after the range.
+ *
+ * @return An iterator to an interval overlapping [Low, High), or End().
+ */
+inline Iterator
+FindOverlapping(
+    _In_ _Const_ const Bound& Low,
+    _In_ _Const_ const Bound& High
+) const noexcept(true)
+{
+    return Iterator{ this->FindAnyOverlap(Low, High, false) };
+}
+
+/**
+ * @brief       Calls the callback for every interval containing the given point,
+ *              in interval order. O(min(n, k * log n)) for k intervals found -
+ *              the subtrees which can't hold a match are skipped, but every match
+ *              can be reached on its own path from the root.
+ *
+ * @param[in]   Point    - The point to look for.
+ * @param[in]   Callback - Called as Callback(const Interval&, Value&).
+ *                         Must not modify the tree.
+ */
+template <class Visitor>
+inline void
+ForEachContaining(
+    _In_ _Const_ const Bound& Point,
+    _In_ Visitor&& Callback
+) const noexcept(true)
+{
+    this->ForEachOverlap(Point, Point, true, Callback);
+}
+
+/**
+ * @brief       Calls the callback for every interval overlapping the range [Low, High),
+ *              in interval order. O(min(n, k * log n)) for k intervals found.
+ *
+ * @param[in]   Low      - The first point of the range.
+ * @param[in]   High     - The point right after the range.
+ * @param[in]   Callback - Called as Callback(const Interval&, Value&).
+ *                         Must not modify the tree.
+ */
+template <class Visitor>
+inline void
+ForEachOverlapping(
+    _In_ _Const_ const Bound& Low,
+    _In_ _Const_ const Bound& High,
+    _In_ Visitor&& Callback
+) const noexcept(true)
+{
+    this->ForEachOverlap(Low, High, false, Callback);
+}
+
+/**
+ * @brief       Returns an iterator to the interval with the smallest Low.
+ *
+ * @return An iterator to the first interval, or End() if empty.
+ */
+inline Iterator
+Begin(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.Begin();
+}
+
+/**
+ * @brief       Returns a sentinel iterator representing past-the-end.
+ *
+ * @return An iterator with a nullptr node.
+ */
+inline Iterator
+End(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.End();
+}
+
+/**
+ * @brief Gets the number of intervals.
+ *
+ * @return The number of intervals.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.Size();
+}
+
+/**
+ * @brief Checks if the tree is empty.
+ *
+ * @return true if the tree has no intervals, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.IsEmpty();
+}
+
+/**
+ * @brief Removes all intervals.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    this->m_Tree.Clear();
+}
+
+/**
+ * @brief Gets the underlying allocator.
+ *
+ * @return A const reference to the underlying allocator.
+ */
+inline const xpf::PolymorphicAllocator&
+GetAllocator(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.GetAllocator();
+}
+
+/**
+ * @brief       Gets the root node of the tree. Primarily for testing.
+ *
+ * @return A pointer to the root node, or nullptr if the tree is empty.
+ */
+inline Node*
+Root(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.Root();
+}
+
+ private:
+/**
+ * @brief       Checks whether an interval starts before the end of the query.
+ *              For a point query the interval must start at or before the point.
+ *
+ * @param[in]   IntervalLow  - The start of the interval.
+ * @param[in]   QueryHigh    - The end of the range, or the point.
+ * @param[in]   IsPointQuery - true if QueryHigh is a point.
+ *
+ * @return true if the interval starts early enough to meet the query.
+ */
+static inline bool
+StartsBeforeQueryEnd(
+    _In_ _Const_ const Bound& IntervalLow,
+    _In_ _Const_ const Bound& QueryHigh,
+    _In_ bool IsPointQuery
+) noexcept(true)
+{
+    return (IsPointQuery) ? !(QueryHigh < IntervalLow)
+                          : (IntervalLow < QueryHigh);
+}
+
+/**
+ * @brief       Checks whether a node interval meets the query.
+ *
+ * @param[in]   TreeNode     - The node.
+ * @param[in]   QueryLow     - The start of the range, or the point.
+ * @param[in]   QueryHigh    - The end of the range, or the point.
+ * @param[in]   IsPointQuery - true for a point query.
+ *
+ * @return true if the interval of the node overlaps the range or contains the point.
+ */
+static inline bool
+Overlaps(
+    _In_ const Node* TreeNode,
+    _In_ _Const_ const Bound& QueryLow,
+    _In_ _Const_ const Bound& QueryHigh,
+    _In_ bool IsPointQuery
+) noexcept(true)
+{
+    return StartsBeforeQueryEnd(TreeNode->NodeKey.Low, QueryHigh, IsPointQuery) &&
+           (QueryLow < TreeNode->NodeKey.High);
+}
+
+/**
+ * @brief       Finds any interval meeting the query (CLRS Interval-Search).
+ *
+ *              Go left when the left subtree reaches past the query start:
+ *              if none of its intervals meets the query, one of them ends after
+ *              the query start and so must start after the query end - and so
+ *              does every interval of the right subtree. Otherwise go right.
+ *
+ * @param[in]   QueryLow     - The start of the range, or the point.
+ * @param[in]   QueryHigh    - The end of the range, or the point.
+ * @param[in]   IsPointQuery - true for a point query.
+ *
+ * @return The node found, or nullptr.
+ */
+inline Node*
+FindAnyOverlap(
+    _In_ _Const_ const Bound& QueryLow,
+    _In_ _Const_ const Bound& QueryHigh,
+    _In_ bool IsPointQuery
+) const noexcept(true)
+{
+    if (!IsPointQuery && !(QueryLow < QueryHigh))
+    {
+        return nullptr;
+    }
+
+    Node* current = this->m_Tree.Root();
+    while ((nullptr != current) && !Overlaps(current, QueryLow, QueryHigh, IsPointQuery))
+    {
+        if ((nullptr != current->Left) && (QueryLow < current->Left->MaxHigh))
+        {
+            current = current->Left;
+        }
+        else
+        {
+            current = current->Right;
+        }
+    }
+    return current;
+}
+
+/**
+ * @brief       Visits in order every interval meeting the query.
+ *              The walk follows the parent links, so it uses no stack, and it
+ *              skips the subtrees which cannot hold a result:
+ *              - a left subtree whose largest High does not pass the query start;
+ *              - a right subtree of a node which starts after the query end
+ *                (all intervals on the right start even later);
+ *              - a right subtree whose largest High does not pass the query start.
+ *
+ * @param[in]   QueryLow     - The start of the range, or the point.
+ * @param[in]   QueryHigh    - The end of the range, or the point.
+ * @param[in]   IsPointQuery - true for a point query.
+ * @param[in]   Callback     - Called as Callback(const Interval&, Value&).
+ */
+template <class Visitor>
+inline void
+ForEachOverlap(
+    _In_ _Const_ const Bound& QueryLow,
+    _In_ _Const_ const Bound& QueryHigh,
+    _In_ bool IsPointQuery,
+    _In_ Visitor& Callback
+) const noexcept(true)
+{
+    if (!IsPointQuery && !(QueryLow < QueryHigh))
+    {
+        return;
+    }
+
+    Node* current = this->m_Tree.Root();
+    bool goingDown = true;
+
+    while (nullptr != current)
+    {
+        /* First the left subtree, if it reaches the query. */
+        if (goingDown && (nullptr != current->Left) && (QueryLow < current->Left->MaxHigh))
+        {
+            current = current->Left;
+            continue;
+        }
+
+        /* The left subtree is done - the node, then the right subtree. */
+        if (Overlaps(current, QueryLow, QueryHigh, IsPointQuery))
+        {
+            Callback(current->NodeKey, current->NodeValue);
+        }
+
+        if ((nullptr != current->Right) &&
+            StartsBeforeQueryEnd(current->NodeKey.Low, QueryHigh, IsPointQuery) &&
+            (QueryLow < current->Right->MaxHigh))
+        {
+            goingDown = true;
+            current = current->Right;
+            continue;
+        }
+
+        /* Nothing more on the right - climb past the finished right subtrees. */
+        /* The first ancestor reached from its left child is visited next.     */
+        Node* child = current;
+        current = current->Parent;
+        while ((nullptr != current) && (child == current->Right))
+        {
+            child = current;
+            current = current->Parent;
+        }
+        goingDown = false;
+    }
+}
+
+   /**
+    * @brief The augmented red-black tree holding the intervals.
+    */
+    TreeType m_Tree;
+};  // class IntervalTree
+};  // namespace xpf
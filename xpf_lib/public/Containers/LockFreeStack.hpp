@@ -0,0 +1,211 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/LockFreeStack.hpp
+ *
+ * @brief       This is a lock-free LIFO stack (Treiber stack).
+ *              It uses a tagged head pointer to protect against the ABA problem,
+ *              and an epoch scheme so the popped elements can be safely freed.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
+
+#include "xpf_lib/public/Containers/TwoLockQueue.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief This is a lock-free LIFO stack, as presented in "Systems Programming: Coping with Parallelism"
+ *        by R. K. Treiber. Elements are XPF_SINGLE_LIST_ENTRY, same as for the two-lock queue.
+ *
+ *        The head is a pair of machine words - the pointer to the top element and a tag
+ *        which is incremented on each change - updated with a double-width compare-exchange.
+ *        The tag guards against the ABA problem: an element which is popped and pushed back
+ *        between our read and our CAS changes the tag, so the CAS fails. The tag is as wide
+ *        as a pointer, so it does not wrap around in practice.
+ *
+ * @note  As with any Treiber stack, Pop() reads the Next field of the top element
+ *        which might have been popped by another thread in the meantime. The tag makes sure
+ *        the value is discarded, but the memory must still be readable. So an element which
+ *        was ever in the stack must not be given back to the system directly - it is handed
+ *        to Retire() instead, and freed once Reclaim() returns it. See the section below.
+ */
+class LockFreeStack final
+{
+ public:
+/**
+ * @brief LockFreeStack constructor - default.
+ */
+LockFreeStack(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Default destructor. The stack should be empty, and the retired
+ *        elements given back by Reclaim(). The elements are not owned by the stack.
+ */
+~LockFreeStack(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy and move semantics are deleted.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(LockFreeStack, delete);
+
+/**
+ * @brief Pushes an element on top of the stack.
+ *
+ * @param[in,out] Element - The element to be inserted.
+ *
+ * @return void.
+ *
+ * @note This function can not fail.
+ */
+void
+XPF_API
+Push(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Element
+) noexcept(true);
+
+/**
+ * @brief Pushes an already linked chain of elements on top of the stack.
+ *        The whole chain is inserted with a single atomic operation.
+ *
+ * @param[in,out] First - The first element of the chain. This will be the new top.
+ *
+ * @param[in,out] Last - The last element of the chain. Must be reachable from First.
+ *
+ * @return void.
+ *
+ * @note This function can not fail.
+ */
+void
+XPF_API
+PushList(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true);
+
+/**
+ * @brief Pops the element from the top of the stack.
+ *
+ * @returns The removed element, or NULL if the stack was empty.
+ */
+_Ret_maybenull_
+XPF_SINGLE_LIST_ENTRY*
+XPF_API
+Pop(
+    void
+) noexcept(true);
+
+/**
+ * @brief Removes all elements from the stack with a single atomic operation.
+ *
+ * @returns The old top of the stack. It can be used to walk the elements.
+ *          NULL if the stack was empty.
+ */
+_Ret_maybenull_
+XPF_SINGLE_LIST_ENTRY*
+XPF_API
+Flush(
+    void
+) noexcept(true);
+
+/**
+ * @brief Checks if the stack is empty.
+ *
+ * @return true if the stack is empty, false otherwise.
+ *
+ * @note This is only a snapshot - the stack can change right after.
+ */
+bool
+XPF_API
+IsEmpty(
+    void
+) const noexcept(true);
+
+/**
+ * @brief Hands over a chain of elements which were removed from this stack (by Pop or Flush)
+ *        and which the caller wants to give back to the system. A Pop which started earlier
+ *        might still read their Next field, so they are kept until Reclaim() returns them.
+ *        The chain must not be used by the caller anymore.
+ *
+ * @param[in,out] First - The first element of a NULL-terminated chain.
+ *
+ * @param[in,out] Last - The last element of the chain.
+ *
+ * @return void.
+ *
+ * @note This function can not fail.
+ */
+void
+XPF_API
+Retire(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true);
+
+/**
+ * @brief Retrieves the retired elements which no Pop can read anymore.
+ *        This never waits: if a Pop is still in progress, the elements stay retired
+ *        and a later call returns them. If no Pop is in progress, all elements
+ *        retired before this call are returned.
+ *
+ * @returns The first element of a NULL-terminated chain which can be freed,
+ *          or NULL if there is nothing to free yet.
+ */
+_Ret_maybenull_
+XPF_SINGLE_LIST_ENTRY*
+XPF_API
+Reclaim(
+    void
+) noexcept(true);
+
+ private:
+    /**
+     * @brief The number of retired lists. An element retired in epoch E goes to the list
+     *        E % XPF_LFS_RETIRED_LISTS and is given back when the epoch reaches E + 3.
+     */
+    static constexpr size_t XPF_LFS_RETIRED_LISTS = 4;
+
+    /**
+     * @brief The top element (Low) and the tag (High).
+     */
+    volatile xpf::AtomicWordPair m_Head;
+
+    /**
+     * @brief Advanced by Reclaim(), one step at a time.
+     */
+    xpf::Atomic<uint64_t> m_Epoch{ 0 };
+
+    /**
+     * @brief The number of Pop() calls in progress, split by the parity of the epoch they saw.
+     */
+    xpf::Atomic<uint64_t> m_ActivePops[2];
+
+    /**
+     * @brief The retired elements, by epoch. Only pushed to and flushed, so no ABA here.
+     */
+    void* volatile m_Retired[XPF_LFS_RETIRED_LISTS] = { nullptr };
+
+    /**
+     * @brief Set while a Reclaim() is in progress - the others don't wait, they return.
+     */
+    xpf::Atomic<uint32_t> m_IsReclaiming{ 0 };
+};  // class LockFreeStack
+};  // namespace xpf
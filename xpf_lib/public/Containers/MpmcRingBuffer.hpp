@@ -0,0 +1,315 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/MpmcRingBuffer.hpp
+ *
+ * @brief       Bounded lock-free queue for many producers and many consumers.
+ *              The elements live in a fixed array of cells, so nothing is allocated
+ *              per element - and nothing at all, as the array is part of the object.
+ *              Each cell carries a sequence number telling whose turn it is.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Memory/CacheAligned.hpp"
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the MpmcRingBuffer implementation.
+// The enqueue and dequeue positions only grow. Position P uses the cell P % Capacity,
+// and the sequence number of that cell says what may happen to it next:
+//
+//     Sequence == P                 - the cell is free, the producer of P may fill it;
+//     Sequence == P + 1             - the cell is full, the consumer of P may empty it;
+//     Sequence == P + Capacity      - emptied, free for the producer of P + Capacity.
+//
+// A producer claims P with a compare-exchange on the enqueue position, then
+// publishes the element by storing P + 1 (release). A consumer claims P the
+// same way on the dequeue position, and gives the cell back by storing
+// P + Capacity. A cell whose sequence is behind means the buffer is full
+// (for a producer) or empty (for a consumer) - Try* return false right away.
+// ************************************************************************************************
+//
+
+/**
+ * @brief One cell of the ring - the sequence number and the room for one element.
+ */
+template <class Type>
+struct MpmcRingBufferCell
+{
+    /**
+     * @brief Whose turn it is - see the section description.
+     */
+    xpf::Atomic<uint64_t> Sequence;
+
+    /**
+     * @brief The element, constructed only while the cell is full.
+     */
+    alignas(Type) uint8_t Storage[sizeof(Type)];
+};  // struct MpmcRingBufferCell
+
+/**
+ * @brief Bounded FIFO queue, safe for any number of producers and consumers.
+ *        Lock-free: TryPush and TryPop never wait for another thread.
+ *        SpinPush and SpinPop retry them, with ApiYieldProcesor between attempts,
+ *        until there is room (or an element). They busy-wait - nothing blocks on
+ *        a kernel object - so they are callable up to DISPATCH_LEVEL, but they only
+ *        make progress while the other side runs on another processor. Callers which
+ *        may wait for long should use TryPush / TryPop and wait on a Signal of their own.
+ *
+ *        Capacity must be a power of two. The cells are stored inline,
+ *        so a large buffer should not live on the stack.
+ */
+template <class Type, size_t Capacity>
+class MpmcRingBuffer final
+{
+    static_assert(Capacity >= 2, "The capacity must be at least 2!");
+    static_assert(0 == (Capacity & (Capacity - 1)), "The capacity must be a power of two!");
+
+ public:
+    /**
+     * @brief Internal cell type alias.
+     */
+    using Cell = MpmcRingBufferCell<Type>;
+
+    /**
+     * @brief The maximum number of elements in the buffer.
+     */
+    static constexpr size_t CAPACITY = Capacity;
+
+/**
+ * @brief MpmcRingBuffer constructor - default. All cells are free.
+ */
+MpmcRingBuffer(
+    void
+) noexcept(true)
+{
+    for (size_t i = 0; i < Capacity; ++i)
+    {
+        this->m_Cells[i].Sequence.Store(i, xpf::MemoryOrder::Relaxed);
+    }
+}
+
+/**
+ * @brief Destructor. Destroys the elements still in the buffer.
+ *        The buffer must no longer be used by other threads.
+ */
+~MpmcRingBuffer(
+    void
+) noexcept(true)
+{
+    const uint64_t end = this->m_EnqueuePosition.Get().Load(xpf::MemoryOrder::Acquire);
+    for (uint64_t position = this->m_DequeuePosition.Get().Load(xpf::MemoryOrder::Acquire); position != end; ++position)
+    {
+        Cell& cell = this->m_Cells[position & (Capacity - 1)];
+        xpf::MemoryAllocator::Destruct(reinterpret_cast<Type*>(&cell.Storage[0]));
+    }
+}
+
+/**
+ * @brief Copy and move semantics are deleted - other threads may hold a reference.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(MpmcRingBuffer, delete);
+
+/**
+ * @brief       Adds an element at the back, if there is room.
+ *
+ * @param[in,out]   Value - The element. Moved only on success.
+ *
+ * @return true if the element was added, false if the buffer is full.
+ */
+_Must_inspect_result_
+inline bool
+TryPush(
+    _Inout_ Type&& Value
+) noexcept(true)
+{
+    uint64_t position = this->m_EnqueuePosition.Get().Load(xpf::MemoryOrder::Relaxed);
+    Cell* cell = nullptr;
+
+    while (true)
+    {
+        cell = &this->m_Cells[position & (Capacity - 1)];
+        const uint64_t sequence = cell->Sequence.Load(xpf::MemoryOrder::Acquire);
+        const int64_t difference = static_cast<int64_t>(sequence - position);
+
+        if (0 == difference)
+        {
+            /* The cell is free - claim the position. On failure, position is refreshed. */
+            if (this->m_EnqueuePosition.Get().CompareExchange(position, position + 1, xpf::MemoryOrder::Relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            /* The consumer of the previous lap did not empty the cell yet. */
+            return false;
+        }
+        else
+        {
+            /* Another producer took this position. */
+            position = this->m_EnqueuePosition.Get().Load(xpf::MemoryOrder::Relaxed);
+        }
+    }
+
+    xpf::MemoryAllocator::Construct(reinterpret_cast<Type*>(&cell->Storage[0]),
+                                    xpf::Move(Value));
+    cell->Sequence.Store(position + 1, xpf::MemoryOrder::Release);
+    return true;
+}
+
+/**
+ * @brief       Removes the element at the front, if there is one.
+ *
+ * @param[out]  Value - Receives the element (move-assigned) on success.
+ *
+ * @return true if an element was removed, false if the buffer is empty.
+ */
+_Must_inspect_result_
+inline bool
+TryPop(
+    _Out_ Type& Value
+) noexcept(true)
+{
+    uint64_t position = this->m_DequeuePosition.Get().Load(xpf::MemoryOrder::Relaxed);
+    Cell* cell = nullptr;
+
+    while (true)
+    {
+        cell = &this->m_Cells[position & (Capacity - 1)];
+        const uint64_t sequence = cell->Sequence.Load(xpf::MemoryOrder::Acquire);
+        const int64_t difference = static_cast<int64_t>(sequence - (position + 1));
+
+        if (0 == difference)
+        {
+            /* The cell is full - claim the position. On failure, position is refreshed. */
+            if (this->m_DequeuePosition.Get().CompareExchange(position, position + 1, xpf::MemoryOrder::Relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            /* The producer of this position did not publish yet. */
+            return false;
+        }
+        else
+        {
+            /* Another consumer took this position. */
+            position = this->m_DequeuePosition.Get().Load(xpf::MemoryOrder::Relaxed);
+        }
+    }
+
+    Type* element = reinterpret_cast<Type*>(&cell->Storage[0]);
+    Value = xpf::Move(*element);
+    xpf::MemoryAllocator::Destruct(element);
+
+    cell->Sequence.Store(position + Capacity, xpf::MemoryOrder::Release);
+    return true;
+}
+
+/**
+ * @brief       Adds an element at the back, spinning until there is room.
+ *              See the class description for when this may be used.
+ *
+ * @param[in,out]   Value - The element. Moved.
+ */
+inline void
+SpinPush(
+    _Inout_ Type&& Value
+) noexcept(true)
+{
+    while (!this->TryPush(xpf::Move(Value)))
+    {
+        xpf::ApiYieldProcesor();
+    }
+}
+
+/**
+ * @brief       Removes the element at the front, spinning until there is one.
+ *              See the class description for when this may be used.
+ *
+ * @param[out]  Value - Receives the element (move-assigned).
+ */
+inline void
+SpinPop(
+    _Out_ Type& Value
+) noexcept(true)
+{
+    while (!this->TryPop(Value))
+    {
+        xpf::ApiYieldProcesor();
+    }
+}
+
+/**
+ * @brief       Gets the number of elements. With concurrent pushes and pops
+ *              this is only an estimate - it may also count the elements
+ *              which are being pushed or popped right now.
+ *
+ * @return The number of elements, at most CAPACITY.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    const uint64_t dequeue = this->m_DequeuePosition.Get().Load(xpf::MemoryOrder::Relaxed);
+    const uint64_t enqueue = this->m_EnqueuePosition.Get().Load(xpf::MemoryOrder::Relaxed);
+
+    /* The positions are read one after the other, so the dequeue one may have passed. */
+    const uint64_t size = (enqueue > dequeue) ? enqueue - dequeue
+                                              : 0;
+    return (size < Capacity) ? static_cast<size_t>(size)
+                             : Capacity;
+}
+
+/**
+ * @brief Checks if the buffer is empty. Same caveat as Size().
+ *
+ * @return true if the buffer has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return 0 == this->Size();
+}
+
+ private:
+   /**
+    * @brief The next position to be filled. Written by producers only,
+    *        on cache lines of its own so it does not slow down the consumers.
+    */
+    xpf::CacheAligned<xpf::Atomic<uint64_t>> m_EnqueuePosition{ uint64_t{ 0 } };
+
+   /**
+    * @brief The next position to be emptied. Written by consumers only.
+    */
+    xpf::CacheAligned<xpf::Atomic<uint64_t>> m_DequeuePosition{ uint64_t{ 0 } };
+
+   /**
+    * @brief The ring of cells.
+    */
+    Cell m_Cells[Capacity];
+};  // class MpmcRingBuffer
+};  // namespace xpf
@@ -0,0 +1,469 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/OrderStatisticTree.hpp
+ *
+ * @brief       Ordered map answering "the k-th key" and "the rank of a key" in O(log n).
+ *              A red-black tree augmented with the size of every subtree.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Containers/RedBlackTree.hpp"
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the order statistic augmentation.
+// Each node knows how many nodes its subtree holds, shown as [key, size]:
+//
+//                    [d, 5]
+//                   /      \    the root holds all 5 nodes
+//               [b, 3]    [e, 1]
+//              /      \         b holds a, b and c
+//          [a, 1]    [c, 1]
+//
+// The rank of a node is the size of its left subtree plus the sizes of
+// the left subtrees (and the nodes) we pass when going right from the root.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Red-black tree augmentation keeping the number of nodes of each subtree.
+ */
+struct OrderStatisticAugmentation
+{
+    /**
+     * @brief The per-node data - the number of nodes in the subtree rooted here.
+     */
+    struct Summary
+    {
+        size_t SubtreeSize = 1;
+    };
+
+    /**
+     * @brief       Recomputes the subtree size of a node from its children.
+     *
+     * @param[in,out]   TreeNode - The node whose summary is recomputed.
+     */
+    template <class Node>
+    static inline void
+    Update(
+        _Inout_ Node* TreeNode
+    ) noexcept(true)
+    {
+        size_t size = 1;
+        if (nullptr != TreeNode->Left)
+        {
+            size += TreeNode->Left->SubtreeSize;
+        }
+        if (nullptr != TreeNode->Right)
+        {
+            size += TreeNode->Right->SubtreeSize;
+        }
+        TreeNode->SubtreeSize = size;
+    }
+};  // struct OrderStatisticAugmentation
+
+
+//
+// ************************************************************************************************
+// This is the section containing the OrderStatisticTree implementation.
+// A thin wrapper over RedBlackTree<Key, Value, Comparator, OrderStatisticAugmentation>.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Ordered associative container mapping keys to values, with positional access.
+ *        Same interface as Map, plus Select (the element at a position in key order)
+ *        and Rank (the position of a key), both O(log n).
+ */
+template <class Key, class Value, class Comparator = DefaultCompare<Key>>
+class OrderStatisticTree final
+{
+ public:
+    /**
+     * @brief The underlying tree type.
+     */
+    using TreeType = RedBlackTree<Key, Value, Comparator, OrderStatisticAugmentation>;
+
+    /**
+     * @brief Iterator type for in-order traversal.
+     */
+    using Iterator = typename TreeType::Iterator;
+
+    /**
+     * @brief Internal node type alias.
+     */
+    using Node = typename TreeType::Node;
+
+/**
+ * @brief       OrderStatisticTree constructor - default.
+ *
+ * @param[in]   Allocator - to be used when performing node allocations.
+ */
+OrderStatisticTree(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Tree{ Allocator }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Destructor.
+ */
+~OrderStatisticTree(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+OrderStatisticTree(
+    _In_ _Const_ const OrderStatisticTree& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+OrderStatisticTree(
+    _Inout_ OrderStatisticTree&& Other
+) noexcept(true) : m_Tree{ xpf::Move(Other.m_Tree) }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+OrderStatisticTree&
+operator=(
+    _In_ _Const_ const OrderStatisticTree& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+OrderStatisticTree&
+operator=(
+    _Inout_ OrderStatisticTree&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->m_Tree = xpf::Move(Other.m_Tree);
+    }
+    return *this;
+}
+
+/**
+ * @brief       Inserts or updates a key-value pair.
+ *
+ * @param[in,out]   KeyToInsert   - The key to insert. Moved on success.
+ * @param[in,out]   ValueToInsert - The value to insert. Moved on success.
+ *
+ * @return STATUS_SUCCESS on success, STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    _Inout_ Key&& KeyToInsert,
+    _Inout_ Value&& ValueToInsert
+) noexcept(true)
+{
+    return this->m_Tree.Emplace(xpf::Move(KeyToInsert),
+                                xpf::Move(ValueToInsert));
+}
+
+/**
+ * @brief       Finds the element with the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator pointing to the element, or End() if not found.
+ */
+inline Iterator
+Find(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.Find(KeyToFind);
+}
+
+/**
+ * @brief       Removes the element with the given key.
+ *
+ * @param[in]   KeyToErase - The key to remove.
+ *
+ * @return STATUS_SUCCESS if removed, STATUS_NOT_FOUND if absent.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ _Const_ const Key& KeyToErase
+) noexcept(true)
+{
+    return this->m_Tree.Erase(KeyToErase);
+}
+
+/**
+ * @brief       Finds the element at the given position in key order.
+ *
+ *              Walks down from the root: with L nodes in the left subtree,
+ *              the node itself is at position L, the left subtree holds
+ *              positions [0, L) and the right subtree the positions after L.
+ *
+ * @param[in]   Index - The zero-based position.
+ *
+ * @return An iterator to the Index-th smallest element, or End() if Index >= Size().
+ */
+inline Iterator
+Select(
+    _In_ size_t Index
+) const noexcept(true)
+{
+    Node* current = this->m_Tree.Root();
+    size_t remaining = Index;
+
+    while (nullptr != current)
+    {
+        const size_t leftSize = (nullptr != current->Left) ? current->Left->SubtreeSize
+                                                           : 0;
+        if (remaining < leftSize)
+        {
+            current = current->Left;
+        }
+        else if (remaining == leftSize)
+        {
+            return Iterator{ current };
+        }
+        else
+        {
+            remaining -= leftSize + 1;
+            current = current->Right;
+        }
+    }
+    return this->End();
+}
+
+/**
+ * @brief       Counts the keys less than the given key.
+ *              For a key in the tree, this is its zero-based position: Select(Rank(k)) finds k.
+ *
+ * @param[in]   KeyToRank - The key to rank. Does not need to be in the tree.
+ *
+ * @return The number of keys strictly less than KeyToRank.
+ */
+inline size_t
+Rank(
+    _In_ _Const_ const Key& KeyToRank
+) const noexcept(true)
+{
+    const Comparator& comparator = this->m_Tree.GetComparator();
+    Node* current = this->m_Tree.Root();
+    size_t rank = 0;
+
+    while (nullptr != current)
+    {
+        if (comparator(current->NodeKey, KeyToRank))
+        {
+            /* The node and its whole left subtree are smaller. */
+            rank += 1 + ((nullptr != current->Left) ? current->Left->SubtreeSize
+                                                    : 0);
+            current = current->Right;
+        }
+        else
+        {
+            current = current->Left;
+        }
+    }
+    return rank;
+}
+
+/**
+ * @brief       Finds the first element whose key is not less than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key >= KeyToFind, or End().
+ */
+inline Iterator
+LowerBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.LowerBound(KeyToFind);
+}
+
+/**
+ * @brief       Finds the first element whose key is greater than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key > KeyToFind, or End().
+ */
+inline Iterator
+UpperBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.UpperBound(KeyToFind);
+}
+
+/**
+ * @brief       Replaces the content with the given sorted elements in O(n).
+ *
+ * @param[in]   Keys   - The keys, strictly increasing by the comparator. Copied.
+ * @param[in]   Values - The values, one for each key. Copied.
+ *
+ * @return STATUS_SUCCESS if the tree was built, an error otherwise.
+ *         On failure the tree is left empty.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+BuildFromSorted(
+    _In_ _Const_ const xpf::Span<Key>& Keys,
+    _In_ _Const_ const xpf::Span<Value>& Values
+) noexcept(true)
+{
+    return this->m_Tree.BuildFromSorted(Keys, Values);
+}
+
+/**
+ * @brief       Returns an iterator to the smallest key.
+ *
+ * @return An iterator to the first element, or End() if empty.
+ */
+inline Iterator
+Begin(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.Begin();
+}
+
+/**
+ * @brief       Returns a sentinel iterator representing past-the-end.
+ *
+ * @return An iterator with a nullptr node.
+ */
+inline Iterator
+End(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.End();
+}
+
+/**
+ * @brief Gets the number of elements.
+ *
+ * @return The number of key-value pairs.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.Size();
+}
+
+/**
+ * @brief Checks if the tree is empty.
+ *
+ * @return true if the tree has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.IsEmpty();
+}
+
+/**
+ * @brief Removes all elements.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    this->m_Tree.Clear();
+}
+
+/**
+ * @brief Gets the underlying allocator.
+ *
+ * @return A const reference to the underlying allocator.
+ */
+inline const xpf::PolymorphicAllocator&
+GetAllocator(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.GetAllocator();
+}
+
+/**
+ * @brief Gets the comparator used to order the keys.
+ *
+ * @return A const reference to the comparator.
+ */
+inline const Comparator&
+GetComparator(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.GetComparator();
+}
+
+/**
+ * @brief       Gets the root node of the tree. Primarily for testing.
+ *
+ * @return A pointer to the root node, or nullptr if the tree is empty.
+ */
+inline Node*
+Root(
+    void
+) const noexcept(true)
+{
+    return this->m_Tree.Root();
+}
+
+ private:
+   /**
+    * @brief The augmented red-black tree holding the elements.
+    */
+    TreeType m_Tree;
+};  // class OrderStatisticTree
+};  // namespace xpf
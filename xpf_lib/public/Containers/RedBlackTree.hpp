@@ -26,6 +26,8 @@
 #include "xpf_lib/public/Memory/MemoryAllocator.hpp"
 #include "xpf_lib/public/Memory/CompressedPair.hpp"
 
+#include "xpf_lib/public/Containers/Span.hpp"
+
 
 namespace xpf
 {
@@ -46,9 +48,49 @@ enum class NodeColor : uint8_t
     Black = 1
 };  // enum class NodeColor
 
+/**
+ * @brief The default augmentation of the red-black tree - the nodes carry no summary.
+ *
+ *        An augmentation keeps a summary of each subtree in the root of that subtree
+ *        (the number of nodes, the largest interval end, ...). It provides:
+ *          - Summary: the per-node data. The node derives from it, so an empty
+ *                     summary costs no memory.
+ *          - Update:  recomputes the summary of a node from its own key and value
+ *                     and from the summaries of its children.
+ *
+ *        The tree calls Update bottom-up on every node whose subtree changed:
+ *        on the path to the root after an insert, an erase or a value update,
+ *        and on the two nodes of each rotation, so the fixups keep it current.
+ *        When the summary is empty, Update is never called.
+ */
+struct RedBlackTreeNoAugmentation
+{
+    /**
+     * @brief No per-node data.
+     */
+    struct Summary
+    {
+    };
+
+    /**
+     * @brief       Recomputes the summary of a node - nothing to do.
+     *
+     * @param[in,out]   TreeNode - The node whose summary is recomputed.
+     */
+    template <class Node>
+    static inline void
+    Update(
+        _Inout_ Node* TreeNode
+    ) noexcept(true)
+    {
+        XPF_UNREFERENCED_PARAMETER(TreeNode);
+    }
+};  // struct RedBlackTreeNoAugmentation
+
 /**
  * @brief Represents a single node in the red-black tree.
  *        Each node stores a key-value pair and pointers to its parent and children.
+ *        It derives from the summary of the tree augmentation (empty by default).
  *
  *        The layout is:
  *
@@ -58,9 +100,31 @@ enum class NodeColor : uint8_t
  *              /       \
  *          [Left]    [Right]
  */
-template <class Key, class Value>
-struct RedBlackTreeNode
+template <class Key, class Value, class Summary = typename RedBlackTreeNoAugmentation::Summary>
+struct RedBlackTreeNode : public Summary
 {
+    /**
+     * @brief Default constructor.
+     */
+    RedBlackTreeNode(
+        void
+    ) noexcept(true) = default;
+
+    /**
+     * @brief       Constructs the key and the value in place.
+     *
+     * @param[in,out]   KeyToStore   - The key of the node. Will be moved.
+     * @param[in,out]   ValueToStore - The value of the node. Will be moved.
+     */
+    RedBlackTreeNode(
+        _Inout_ Key&& KeyToStore,
+        _Inout_ Value&& ValueToStore
+    ) noexcept(true) : NodeKey{ xpf::Move(KeyToStore) },
+                       NodeValue{ xpf::Move(ValueToStore) }
+    {
+        XPF_NOTHING();
+    }
+
     Key     NodeKey{};
     Value   NodeValue{};
 
@@ -71,6 +135,34 @@ struct RedBlackTreeNode
     NodeColor          Color  = NodeColor::Red;
 };  // struct RedBlackTreeNode
 
+/**
+ * @brief Header of a chunk of tree nodes carved from a single allocation.
+ *        The nodes follow the header (aligned for the node type):
+ *
+ *          [Header][Node 0][Node 1]...[Node Capacity - 1]
+ *
+ *        Nodes are handed out in order (Used grows up to Capacity).
+ *        Erased nodes go to the tree free list and are reused first.
+ */
+struct RedBlackTreeNodeSlab
+{
+    RedBlackTreeNodeSlab*  Next     = nullptr;
+    size_t                 Capacity = 0;
+    size_t                 Used     = 0;
+};  // struct RedBlackTreeNodeSlab
+
+/**
+ * @brief The number of nodes in the first slab of a tree.
+ *        Every new slab doubles the previous one.
+ */
+constexpr size_t XPF_RED_BLACK_TREE_SLAB_MIN_NODES = 4;
+
+/**
+ * @brief The slabs stop doubling when they reach this size in bytes,
+ *        so trees with large keys or values do not allocate huge chunks.
+ */
+constexpr size_t XPF_RED_BLACK_TREE_SLAB_MAX_BYTES = 16 * 1024;
+
 
 //
 // ************************************************************************************************
@@ -116,14 +208,14 @@ struct DefaultCompare
  *        Provides named accessors for key and value instead of operator*
  *        since we need to access key and value separately.
  */
-template <class Key, class Value>
+template <class Key, class Value, class Summary = typename RedBlackTreeNoAugmentation::Summary>
 class RedBlackTreeIterator
 {
  public:
     /**
      * @brief Internal node type alias for readability.
      */
-    using Node = RedBlackTreeNode<Key, Value>;
+    using Node = RedBlackTreeNode<Key, Value, Summary>;
 
 /**
  * @brief       Iterator constructor.
@@ -352,12 +444,22 @@ operator!=(
     /**
      * @brief   Allow the RedBlackTree class to access the internal node pointer.
      */
-    template <class, class, class>
+    template <class, class, class, class>
     friend class RedBlackTree;
 
     Node* m_Node = nullptr;
 };  // class RedBlackTreeIterator
 
+/**
+ * @brief A half-open range of elements [First, Last) in key order.
+ */
+template <class Key, class Value, class Summary = typename RedBlackTreeNoAugmentation::Summary>
+struct RedBlackTreeRange
+{
+    RedBlackTreeIterator<Key, Value, Summary> First;
+    RedBlackTreeIterator<Key, Value, Summary> Last;
+};  // struct RedBlackTreeRange
+
 
 //
 // ************************************************************************************************
@@ -381,20 +483,42 @@ operator!=(
  *        Emplace is an upsert: if the key already exists, the value is
  *        updated in place via move-assign (no allocation). If the key is new,
  *        a new node is allocated, inserted, and the tree is rebalanced.
+ *
+ *        The nodes are carved from slabs owned by the tree, so inserting
+ *        n keys costs O(log n) allocations and the nodes inserted together
+ *        stay close in memory. Erased nodes are kept on a free list and
+ *        reused; the slabs are released by Clear() or when the tree empties.
+ *
+ *        The Augmentation keeps a per-subtree summary in every node
+ *        (see RedBlackTreeNoAugmentation). OrderStatisticTree and
+ *        IntervalTree are built on it.
  */
-template <class Key, class Value, class Comparator = DefaultCompare<Key>>
+template <class Key,
+          class Value,
+          class Comparator = DefaultCompare<Key>,
+          class Augmentation = RedBlackTreeNoAugmentation>
 class RedBlackTree final
 {
  public:
+    /**
+     * @brief The per-node summary of the augmentation.
+     */
+    using Summary = typename Augmentation::Summary;
+
     /**
      * @brief Internal node type alias.
      */
-    using Node = RedBlackTreeNode<Key, Value>;
+    using Node = RedBlackTreeNode<Key, Value, Summary>;
 
     /**
      * @brief Iterator type for in-order traversal.
      */
-    using Iterator = RedBlackTreeIterator<Key, Value>;
+    using Iterator = RedBlackTreeIterator<Key, Value, Summary>;
+
+    /**
+     * @brief Range type returned by EqualRange.
+     */
+    using Range = RedBlackTreeRange<Key, Value, Summary>;
 
 /**
  * @brief       RedBlackTree constructor - default.
@@ -407,8 +531,7 @@ RedBlackTree(
                    m_Size{ 0 },
                    m_Comparator{}
 {
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.AllocFunction);
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.FreeFunction);
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
 
     this->m_CompressedPair.First() = Allocator;
     this->m_CompressedPair.Second() = nullptr;
@@ -459,12 +582,16 @@ RedBlackTree(
     root = otherRoot;
     this->m_Size = Other.m_Size;
     this->m_Comparator = Other.m_Comparator;
+    this->m_Slabs = Other.m_Slabs;
+    this->m_FreeNodes = Other.m_FreeNodes;
 
     /*
      * Invalidate Other.
      */
     otherRoot = nullptr;
     Other.m_Size = 0;
+    Other.m_Slabs = nullptr;
+    Other.m_FreeNodes = nullptr;
 }
 
 /**
@@ -515,12 +642,16 @@ operator=(
         root = otherRoot;
         this->m_Size = Other.m_Size;
         this->m_Comparator = Other.m_Comparator;
+        this->m_Slabs = Other.m_Slabs;
+        this->m_FreeNodes = Other.m_FreeNodes;
 
         /*
          * Invalidate Other.
          */
         otherRoot = nullptr;
         Other.m_Size = 0;
+        Other.m_Slabs = nullptr;
+        Other.m_FreeNodes = nullptr;
     }
     return *this;
 }
@@ -579,6 +710,7 @@ Emplace(
              * No allocation needed.
              */
             current->NodeValue = xpf::Move(ValueToInsert);
+            this->UpdateSummaryToRoot(current);
             return STATUS_SUCCESS;
         }
     }
@@ -615,8 +747,10 @@ Emplace(
     }
 
     /*
-     * New nodes are always red. Fix up any red-black violations.
+     * Every ancestor gained a node. Then, new nodes are always red.
+     * Fix up any red-black violations - the rotations keep the summaries.
      */
+    this->UpdateSummaryToRoot(newNode);
     this->InsertFixup(newNode);
     this->m_Size++;
 
@@ -662,6 +796,93 @@ Find(
     return this->End();
 }
 
+/**
+ * @brief       Finds the first element whose key is not less than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key >= KeyToFind,
+ *         or End() if there is none. O(log n).
+ */
+inline Iterator
+LowerBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    Node* current = this->m_CompressedPair.Second();
+    Node* candidate = nullptr;
+
+    while (nullptr != current)
+    {
+        if (!this->m_Comparator(current->NodeKey, KeyToFind))
+        {
+            /* current key >= KeyToFind - a candidate, a smaller one may be on the left. */
+            candidate = current;
+            current = current->Left;
+        }
+        else
+        {
+            current = current->Right;
+        }
+    }
+    return Iterator{ candidate };
+}
+
+/**
+ * @brief       Finds the first element whose key is greater than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key > KeyToFind,
+ *         or End() if there is none. O(log n).
+ */
+inline Iterator
+UpperBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    Node* current = this->m_CompressedPair.Second();
+    Node* candidate = nullptr;
+
+    while (nullptr != current)
+    {
+        if (this->m_Comparator(KeyToFind, current->NodeKey))
+        {
+            /* current key > KeyToFind - a candidate, a smaller one may be on the left. */
+            candidate = current;
+            current = current->Left;
+        }
+        else
+        {
+            current = current->Right;
+        }
+    }
+    return Iterator{ candidate };
+}
+
+/**
+ * @brief       Finds the elements equal to the given key.
+ *              Keys are unique, so the range holds at most one element.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return The range [LowerBound(KeyToFind), UpperBound(KeyToFind)).
+ */
+inline Range
+EqualRange(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    Iterator first = this->LowerBound(KeyToFind);
+    Iterator last = first;
+
+    if ((last != this->End()) && !this->m_Comparator(KeyToFind, last.GetKey()))
+    {
+        ++last;
+    }
+    return Range{ first, last };
+}
+
 /**
  * @brief       Removes the node with the given key from the tree.
  *              Frees the node memory and rebalances the tree.
@@ -686,121 +907,121 @@ Erase(
         return STATUS_NOT_FOUND;
     }
 
-    Node* nodeToDelete = it.m_Node;
-
-    /*
-     * Standard BST delete for a red-black tree (CLRS algorithm).
-     *
-     * y is the node that will actually be spliced out of the tree.
-     * x is the child that will take y's position.
-     * xParent tracks the parent of x (needed when x is nullptr).
-     *
-     * originalColor is y's color before splicing, which determines
-     * whether we need to fix up the tree afterwards.
-     */
-    Node* y = nodeToDelete;
-    NodeColor originalColor = y->Color;
-    Node* x = nullptr;
-    Node* xParent = nullptr;
+    this->EraseNode(it.m_Node);
+    return STATUS_SUCCESS;
+}
 
-    if (nullptr == nodeToDelete->Left)
-    {
-        /*
-         * Case 1: Node has no left child.
-         * Replace node with its right child (which may be nullptr).
-         *
-         *     [nodeToDelete]           [Right]
-         *          \            =>
-         *        [Right]
-         */
-        x = nodeToDelete->Right;
-        xParent = nodeToDelete->Parent;
-        this->Transplant(nodeToDelete, nodeToDelete->Right);
-    }
-    else if (nullptr == nodeToDelete->Right)
+/**
+ * @brief       Removes all the elements in [First, Last), in order.
+ *              Erasing never moves the other nodes, so Last stays valid.
+ *              Erasing [Begin(), End()) is the same as Clear() - O(n).
+ *              Otherwise each element costs an O(log n) erase.
+ *
+ * @param[in]   First - The first element to erase.
+ * @param[in]   Last  - The element following the last one to erase.
+ *                      Must be First or come after it in order.
+ *
+ * @return The number of erased elements.
+ */
+inline size_t
+EraseRange(
+    _In_ Iterator First,
+    _In_ Iterator Last
+) noexcept(true)
+{
+    if ((First == this->Begin()) && (Last == this->End()))
     {
-        /*
-         * Case 2: Node has no right child.
-         * Replace node with its left child.
-         *
-         *     [nodeToDelete]           [Left]
-         *          /            =>
-         *       [Left]
-         */
-        x = nodeToDelete->Left;
-        xParent = nodeToDelete->Parent;
-        this->Transplant(nodeToDelete, nodeToDelete->Left);
+        const size_t erased = this->m_Size;
+        this->Clear();
+        return erased;
     }
-    else
+
+    size_t erased = 0;
+    while (First != Last)
     {
-        /*
-         * Case 3: Node has two children.
-         * Find the in-order successor (minimum of right subtree).
-         * Copy the successor's key/value into the node, then delete the successor.
-         *
-         *       [nodeToDelete]         [successor]
-         *        /          \    =>    /          \
-         *     [Left]      [Right]   [Left]      [Right]
-         *                  /                      /
-         *           [successor]             [succ.Right]
-         */
-        y = this->Minimum(nodeToDelete->Right);
-        originalColor = y->Color;
-        x = y->Right;
-        xParent = y;
+        XPF_DEATH_ON_FAILURE(First != this->End());
 
-        if (y->Parent == nodeToDelete)
-        {
-            /*
-             * The successor is the direct right child of nodeToDelete.
-             * After transplant, x's parent is y.
-             */
-            if (nullptr != x)
-            {
-                x->Parent = y;
-            }
-            xParent = y;
-        }
-        else
-        {
-            /*
-             * The successor is deeper in the right subtree.
-             * First splice out the successor, then put it in nodeToDelete's spot.
-             */
-            xParent = y->Parent;
-            this->Transplant(y, y->Right);
-            y->Right = nodeToDelete->Right;
-            if (nullptr != y->Right)
-            {
-                y->Right->Parent = y;
-            }
-        }
+        Node* nodeToErase = First.m_Node;
+        ++First;
 
-        this->Transplant(nodeToDelete, y);
-        y->Left = nodeToDelete->Left;
-        if (nullptr != y->Left)
-        {
-            y->Left->Parent = y;
-        }
-        y->Color = nodeToDelete->Color;
+        this->EraseNode(nodeToErase);
+        erased++;
     }
+    return erased;
+}
 
-    /*
-     * Free the removed node.
-     */
-    this->DeallocateNode(nodeToDelete);
-    this->m_Size--;
-
-    /*
-     * If the spliced-out node was black, we may have violated the
-     * black-height property. Fix it up.
-     */
-    if (NodeColor::Black == originalColor)
+/**
+ * @brief       Replaces the content of the tree with the given sorted elements.
+ *              The tree is built in O(n) - each key is read once, in order,
+ *              and linked into its final place, with no rotation and no fixup.
+ *
+ *              For n keys, the first 2^H - 1 (H maximal) form a perfect tree
+ *              of black nodes, and the e = n - (2^H - 1) others become red leaves
+ *              on the level below. In-order, the red leaves fill the child slots
+ *              of the bottom black nodes from left to right, so red leaf s comes
+ *              right before black node s + 1:
+ *
+ *                n = 10, H = 3, e = 3:             [6]
+ *                                               /       \
+ *                                            [3]         [8]
+ *                                           /   \       /   \
+ *                                         [1]   [5]   [7]   [9]
+ *                                        /   \   /
+ *                                      (0)  (2) (4)     <- red leaves
+ *
+ *              Every path to a leaf crosses H black nodes and no red node has a
+ *              red child, so the result is a valid red-black tree of height H + 1.
+ *
+ * @param[in]   Keys   - The keys, strictly increasing by the comparator. Copied.
+ * @param[in]   Values - The values, one for each key. Copied.
+ *
+ * @return STATUS_SUCCESS if the tree was built,
+ *         STATUS_INVALID_PARAMETER if the sizes differ or the keys are not strictly increasing,
+ *         STATUS_INSUFFICIENT_RESOURCES if the nodes could not be allocated.
+ *         On failure the tree is left empty.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+BuildFromSorted(
+    _In_ _Const_ const xpf::Span<Key>& Keys,
+    _In_ _Const_ const xpf::Span<Value>& Values
+) noexcept(true)
+{
+    if (Keys.Size() != Values.Size())
     {
-        this->EraseFixup(x, xParent);
+        this->Clear();
+        return STATUS_INVALID_PARAMETER;
     }
+    return this->BuildFromSortedElements(Keys,
+                                         [&](size_t Index) noexcept(true) -> Value
+                                         {
+                                             return Values[Index];
+                                         });
+}
 
-    return STATUS_SUCCESS;
+/**
+ * @brief       Replaces the content of the tree with the given sorted keys.
+ *              The values are value-initialized. Same algorithm as above.
+ *
+ * @param[in]   Keys - The keys, strictly increasing by the comparator. Copied.
+ *
+ * @return STATUS_SUCCESS if the tree was built,
+ *         STATUS_INVALID_PARAMETER if the keys are not strictly increasing,
+ *         STATUS_INSUFFICIENT_RESOURCES if the nodes could not be allocated.
+ *         On failure the tree is left empty.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+BuildFromSorted(
+    _In_ _Const_ const xpf::Span<Key>& Keys
+) noexcept(true)
+{
+    return this->BuildFromSortedElements(Keys,
+                                         [&](size_t Index) noexcept(true) -> Value
+                                         {
+                                             XPF_UNREFERENCED_PARAMETER(Index);
+                                             return Value{};
+                                         });
 }
 
 /**
@@ -863,8 +1084,11 @@ IsEmpty(
 }
 
 /**
- * @brief Destroys all nodes in the tree via post-order traversal.
+ * @brief Destroys all nodes in the tree and releases the slabs.
  *        After this call, the tree is empty.
+ *
+ * @note  When the key and the value are trivially destructible
+ *        no node is visited - only the slabs are freed.
  */
 inline void
 Clear(
@@ -875,6 +1099,7 @@ Clear(
     this->DestroySubtree(root);
     root = nullptr;
     this->m_Size = 0;
+    this->ReleaseSlabs();
 }
 
 /**
@@ -890,6 +1115,19 @@ GetAllocator(
     return this->m_CompressedPair.First();
 }
 
+/**
+ * @brief Gets the comparator used to order the keys.
+ *
+ * @return A const reference to the comparator.
+ */
+inline const Comparator&
+GetComparator(
+    void
+) const noexcept(true)
+{
+    return this->m_Comparator;
+}
+
 
 //
 // ************************************************************************************************
@@ -959,6 +1197,12 @@ RotateLeft(
      */
     y->Left = X;
     X->Parent = y;
+
+    /*
+     * x is now below y - its summary first.
+     */
+    this->UpdateSummary(X);
+    this->UpdateSummary(y);
 }
 
 /**
@@ -1022,7 +1266,13 @@ RotateRight(
      */
     y->Right = X;
     X->Parent = y;
-}
+
+    /*
+     * x is now below y - its summary first.
+     */
+    this->UpdateSummary(X);
+    this->UpdateSummary(y);
+}
 
 /**
  * @brief       Restores red-black tree properties after an insertion.
@@ -1443,6 +1693,416 @@ Transplant(
     }
 }
 
+/**
+ * @brief       Unlinks the given node from the tree, frees it and rebalances the tree.
+ *              The other nodes are only relinked, never moved, so iterators
+ *              to them stay valid.
+ *
+ * @param[in,out]   NodeToErase - The node to erase. Must belong to this tree.
+ */
+inline void
+EraseNode(
+    _Inout_ Node* NodeToErase
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != NodeToErase);
+
+    Node* nodeToDelete = NodeToErase;
+
+    /*
+     * Standard BST delete for a red-black tree (CLRS algorithm).
+     *
+     * y is the node that will actually be spliced out of the tree.
+     * x is the child that will take y's position.
+     * xParent tracks the parent of x (needed when x is nullptr).
+     *
+     * originalColor is y's color before splicing, which determines
+     * whether we need to fix up the tree afterwards.
+     */
+    Node* y = nodeToDelete;
+    NodeColor originalColor = y->Color;
+    Node* x = nullptr;
+    Node* xParent = nullptr;
+
+    if (nullptr == nodeToDelete->Left)
+    {
+        /*
+         * Case 1: Node has no left child.
+         * Replace node with its right child (which may be nullptr).
+         *
+         *     [nodeToDelete]           [Right]
+         *          \            =>
+         *        [Right]
+         */
+        x = nodeToDelete->Right;
+        xParent = nodeToDelete->Parent;
+        this->Transplant(nodeToDelete, nodeToDelete->Right);
+    }
+    else if (nullptr == nodeToDelete->Right)
+    {
+        /*
+         * Case 2: Node has no right child.
+         * Replace node with its left child.
+         *
+         *     [nodeToDelete]           [Left]
+         *          /            =>
+         *       [Left]
+         */
+        x = nodeToDelete->Left;
+        xParent = nodeToDelete->Parent;
+        this->Transplant(nodeToDelete, nodeToDelete->Left);
+    }
+    else
+    {
+        /*
+         * Case 3: Node has two children.
+         * Find the in-order successor (minimum of right subtree).
+         * Copy the successor's key/value into the node, then delete the successor.
+         *
+         *       [nodeToDelete]         [successor]
+         *        /          \    =>    /          \
+         *     [Left]      [Right]   [Left]      [Right]
+         *                  /                      /
+         *           [successor]             [succ.Right]
+         */
+        y = this->Minimum(nodeToDelete->Right);
+        originalColor = y->Color;
+        x = y->Right;
+        xParent = y;
+
+        if (y->Parent == nodeToDelete)
+        {
+            /*
+             * The successor is the direct right child of nodeToDelete.
+             * After transplant, x's parent is y.
+             */
+            if (nullptr != x)
+            {
+                x->Parent = y;
+            }
+            xParent = y;
+        }
+        else
+        {
+            /*
+             * The successor is deeper in the right subtree.
+             * First splice out the successor, then put it in nodeToDelete's spot.
+             */
+            xParent = y->Parent;
+            this->Transplant(y, y->Right);
+            y->Right = nodeToDelete->Right;
+            if (nullptr != y->Right)
+            {
+                y->Right->Parent = y;
+            }
+        }
+
+        this->Transplant(nodeToDelete, y);
+        y->Left = nodeToDelete->Left;
+        if (nullptr != y->Left)
+        {
+            y->Left->Parent = y;
+        }
+        y->Color = nodeToDelete->Color;
+    }
+
+    /*
+     * Free the removed node. xParent is the lowest node whose subtree
+     * changed - every summary from it up to the root is recomputed
+     * before the fixup, whose rotations keep them current.
+     */
+    this->DeallocateNode(nodeToDelete);
+    this->m_Size--;
+    this->UpdateSummaryToRoot(xParent);
+
+    /*
+     * If the spliced-out node was black, we may have violated the
+     * black-height property. Fix it up.
+     */
+    if (NodeColor::Black == originalColor)
+    {
+        this->EraseFixup(x, xParent);
+    }
+
+    /*
+     * The last node is gone - give the slabs back.
+     */
+    if (0 == this->m_Size)
+    {
+        this->ReleaseSlabs();
+    }
+}
+
+/**
+ * @brief       Builds the tree from sorted keys and values produced by ValueAt.
+ *              See BuildFromSorted for the shape of the tree.
+ *
+ * @param[in]   Keys    - The keys, strictly increasing by the comparator. Copied.
+ * @param[in]   ValueAt - Returns the value for the key at the given index.
+ *
+ * @return STATUS_SUCCESS if the tree was built, an error otherwise.
+ *         On failure the tree is left empty.
+ */
+template <class ValueProvider>
+_Must_inspect_result_
+inline NTSTATUS
+BuildFromSortedElements(
+    _In_ _Const_ const xpf::Span<Key>& Keys,
+    _In_ ValueProvider ValueAt
+) noexcept(true)
+{
+    auto& root = this->m_CompressedPair.Second();
+
+    this->Clear();
+
+    const size_t count = Keys.Size();
+    for (size_t i = 1; i < count; ++i)
+    {
+        if (!this->m_Comparator(Keys[i - 1], Keys[i]))
+        {
+            return STATUS_INVALID_PARAMETER;
+        }
+    }
+    if (0 == count)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    /*
+     * H is the number of black levels: the largest H with 2^H - 1 <= count.
+     */
+    size_t levels = 0;
+    while ((levels + 1 < 64) && (((size_t{ 1 } << (levels + 1)) - 1) <= count))
+    {
+        levels++;
+    }
+    const size_t blackCount = (size_t{ 1 } << levels) - 1;
+    const size_t redCount = count - blackCount;
+
+    /*
+     * Black node k (1-based, in order) sits on level ctz(k) counted from the bottom.
+     * lastOnLevel[b] is the newest node on level b - when a node on level b arrives,
+     * the newest node on level b - 1 is its left child. A node which is the right
+     * child of its parent (its bit b + 1 is set) is linked to the newest node on level b + 1.
+     * pendingRed is a red leaf waiting for the next bottom black node to adopt it.
+     */
+    Node* lastOnLevel[64] = { nullptr };
+    Node* pendingRed = nullptr;
+
+    size_t keyIndex = 0;
+    for (size_t k = 1; k <= blackCount; ++k)
+    {
+        /*
+         * Red leaf k - 1 comes right before black node k.
+         */
+        if (k - 1 < redCount)
+        {
+            Key key{ Keys[keyIndex] };
+            Value value{ ValueAt(keyIndex) };
+            Node* red = this->AllocateNode(xpf::Move(key), xpf::Move(value));
+            if (nullptr == red)
+            {
+                this->DestroyPartialBuild(keyIndex);
+                return STATUS_INSUFFICIENT_RESOURCES;
+            }
+            keyIndex++;
+
+            red->Color = NodeColor::Red;
+            if (0 == ((k - 1) % 2))
+            {
+                /* Left child of black leaf k - it is not here yet. */
+                pendingRed = red;
+            }
+            else
+            {
+                /* Right child of black leaf k - 1, the newest leaf. */
+                lastOnLevel[0]->Right = red;
+                red->Parent = lastOnLevel[0];
+            }
+        }
+
+        Key key{ Keys[keyIndex] };
+        Value value{ ValueAt(keyIndex) };
+        Node* black = this->AllocateNode(xpf::Move(key), xpf::Move(value));
+        if (nullptr == black)
+        {
+            this->DestroyPartialBuild(keyIndex);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+        keyIndex++;
+
+        black->Color = NodeColor::Black;
+
+        const size_t level = xpf::AlgoCountTrailingZeros(static_cast<uint64_t>(k));
+        if (0 == level)
+        {
+            if (nullptr != pendingRed)
+            {
+                black->Left = pendingRed;
+                pendingRed->Parent = black;
+                pendingRed = nullptr;
+            }
+        }
+        else
+        {
+            black->Left = lastOnLevel[level - 1];
+            black->Left->Parent = black;
+        }
+
+        if ((level + 1 < levels) && (0 != ((k >> (level + 1)) & 1)))
+        {
+            lastOnLevel[level + 1]->Right = black;
+            black->Parent = lastOnLevel[level + 1];
+        }
+        lastOnLevel[level] = black;
+    }
+
+    /*
+     * The root is the middle black node, alone on the top level.
+     */
+    root = lastOnLevel[levels - 1];
+    root->Parent = nullptr;
+    this->m_Size = count;
+
+    this->UpdateSummarySubtree(root);
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Recomputes the summary of a single node.
+ *              Its children must have up to date summaries.
+ *
+ * @param[in,out]   TreeNode - The node. Can be nullptr.
+ */
+inline void
+UpdateSummary(
+    _Inout_opt_ Node* TreeNode
+) noexcept(true)
+{
+    if constexpr (!xpf::IsTypeEmpty<Summary>())
+    {
+        if (nullptr != TreeNode)
+        {
+            Augmentation::Update(TreeNode);
+        }
+    }
+    else
+    {
+        XPF_UNREFERENCED_PARAMETER(TreeNode);
+    }
+}
+
+/**
+ * @brief       Recomputes the summaries from the given node up to the root. O(log n).
+ *
+ * @param[in,out]   TreeNode - The lowest node whose subtree changed. Can be nullptr.
+ */
+inline void
+UpdateSummaryToRoot(
+    _Inout_opt_ Node* TreeNode
+) noexcept(true)
+{
+    if constexpr (!xpf::IsTypeEmpty<Summary>())
+    {
+        for (Node* current = TreeNode; nullptr != current; current = current->Parent)
+        {
+            Augmentation::Update(current);
+        }
+    }
+    else
+    {
+        XPF_UNREFERENCED_PARAMETER(TreeNode);
+    }
+}
+
+/**
+ * @brief       Recomputes the summaries of a whole subtree, children before parents.
+ *              The post-order walk follows the parent links - O(n) time, O(1) space.
+ *
+ * @param[in,out]   SubtreeRoot - The root of the subtree. Can be nullptr.
+ */
+inline void
+UpdateSummarySubtree(
+    _Inout_opt_ Node* SubtreeRoot
+) noexcept(true)
+{
+    if constexpr (!xpf::IsTypeEmpty<Summary>())
+    {
+        /* The first node in post-order below Start: go left when possible, else right. */
+        auto deepestFirst = [](Node* Start) noexcept(true) -> Node*
+                            {
+                                Node* current = Start;
+                                while ((nullptr != current->Left) || (nullptr != current->Right))
+                                {
+                                    current = (nullptr != current->Left) ? current->Left
+                                                                         : current->Right;
+                                }
+                                return current;
+                            };
+
+        if (nullptr == SubtreeRoot)
+        {
+            return;
+        }
+
+        Node* current = deepestFirst(SubtreeRoot);
+        while (true)
+        {
+            Augmentation::Update(current);
+            if (current == SubtreeRoot)
+            {
+                break;
+            }
+
+            /* After a left child comes the right subtree of the parent, then the parent. */
+            Node* parent = current->Parent;
+            if ((current == parent->Left) && (nullptr != parent->Right))
+            {
+                current = deepestFirst(parent->Right);
+            }
+            else
+            {
+                current = parent;
+            }
+        }
+    }
+    else
+    {
+        XPF_UNREFERENCED_PARAMETER(SubtreeRoot);
+    }
+}
+
+/**
+ * @brief       Destroys the nodes created by a build which ran out of memory.
+ *              They are not linked into a tree yet, but they are exactly
+ *              the nodes carved so far from the slabs, as the build starts
+ *              from an empty tree.
+ *
+ * @param[in]   Count - The number of constructed nodes.
+ */
+inline void
+DestroyPartialBuild(
+    _In_ size_t Count
+) noexcept(true)
+{
+    size_t destroyed = 0;
+    for (RedBlackTreeNodeSlab* slab = this->m_Slabs; nullptr != slab; slab = slab->Next)
+    {
+        Node* nodes = static_cast<Node*>(xpf::AlgoAddToPointer(slab, SLAB_HEADER_SIZE));
+        for (size_t i = 0; i < slab->Used; ++i)
+        {
+            xpf::MemoryAllocator::Destruct(xpf::AddressOf(nodes[i]));
+            destroyed++;
+        }
+    }
+    XPF_DEATH_ON_FAILURE(destroyed == Count);
+
+    this->m_CompressedPair.Second() = nullptr;
+    this->m_Size = 0;
+    this->ReleaseSlabs();
+}
+
 /**
  * @brief       Finds the minimum (leftmost) node in the given subtree.
  *
@@ -1491,6 +2151,10 @@ Maximum(
  * @brief       Allocates and constructs a new tree node with the given key and value.
  *              The node is initialized as red with no children and no parent.
  *
+ *              The node comes from the free list if an erased node is available,
+ *              otherwise it is carved from the newest slab. A new slab is allocated
+ *              only when the newest one is fully used.
+ *
  * @param[in,out]   NodeKey   - The key for the new node. Will be moved.
  * @param[in,out]   NodeValue - The value for the new node. Will be moved.
  *
@@ -1503,31 +2167,41 @@ AllocateNode(
     _Inout_ Value&& NodeValue
 ) noexcept(true)
 {
-    auto& allocator = this->m_CompressedPair.First();
+    void* memory = nullptr;
 
-    void* memory = allocator.AllocFunction(sizeof(Node));
-    if (nullptr == memory)
+    if (nullptr != this->m_FreeNodes)
     {
-        return nullptr;
+        /* Reuse an erased node. The link was stored in its first bytes. */
+        memory = this->m_FreeNodes;
+        this->m_FreeNodes = *static_cast<void**>(memory);
     }
+    else
+    {
+        if ((nullptr == this->m_Slabs) || (this->m_Slabs->Used == this->m_Slabs->Capacity))
+        {
+            if (!this->AllocateSlab())
+            {
+                return nullptr;
+            }
+        }
 
-    xpf::ApiZeroMemory(memory, sizeof(Node));
+        /* Carve the next node from the newest slab. */
+        Node* nodes = static_cast<Node*>(xpf::AlgoAddToPointer(this->m_Slabs, SLAB_HEADER_SIZE));
+        memory = xpf::AddressOf(nodes[this->m_Slabs->Used]);
+        this->m_Slabs->Used++;
+    }
 
+    /* Key and value are moved straight into their final place. */
     Node* node = static_cast<Node*>(memory);
-    xpf::MemoryAllocator::Construct(node);
-
-    node->NodeKey = xpf::Move(NodeKey);
-    node->NodeValue = xpf::Move(NodeValue);
-    node->Left = nullptr;
-    node->Right = nullptr;
-    node->Parent = nullptr;
-    node->Color = NodeColor::Red;
-
+    xpf::MemoryAllocator::Construct(node,
+                                    xpf::Move(NodeKey),
+                                    xpf::Move(NodeValue));
     return node;
 }
 
 /**
- * @brief       Destructs and frees a tree node.
+ * @brief       Destructs a tree node and puts it on the free list.
+ *              The memory goes back to the allocator with its slab.
  *
  * @param[in,out]   NodeToFree - The node to destroy and free. Must not be nullptr.
  */
@@ -1538,29 +2212,34 @@ DeallocateNode(
 {
     XPF_DEATH_ON_FAILURE(nullptr != NodeToFree);
 
-    auto& allocator = this->m_CompressedPair.First();
-
     xpf::MemoryAllocator::Destruct(NodeToFree);
-    allocator.FreeFunction(NodeToFree);
+
+    /* The first bytes of the dead node now hold the free list link. */
+    xpf::MemoryAllocator::Construct(reinterpret_cast<void**>(NodeToFree),
+                                    this->m_FreeNodes);
+    this->m_FreeNodes = NodeToFree;
 }
 
 /**
  * @brief       Iteratively destroys all nodes in the given subtree.
  *              Uses an O(1) extra-space algorithm safe for kernel mode (limited stack).
+ *              The memory of the nodes is not freed - it belongs to the slabs.
  *
  *              The algorithm flattens the tree into a right-only vine by moving
  *              each left child up as the new current node (making the old current
- *              a right child of the left child), then deallocates nodes along
+ *              a right child of the left child), then destroys nodes along
  *              the resulting right spine:
  *
  *              While current != nullptr:
  *                  if current has no left child:
- *                      save current->Right, deallocate current, advance
+ *                      save current->Right, destroy current, advance
  *                  else:
  *                      move left child up: left->Right = current,
  *                      current->Left = nullptr, current = left
  *
  *              Each node is visited at most twice, so this is O(n) time, O(1) space.
+ *              Nothing needs to be destroyed for trivially destructible keys and values,
+ *              so the walk is skipped entirely.
  *
  * @param[in,out]   SubtreeRoot - The root of the subtree to destroy. Can be nullptr.
  */
@@ -1569,29 +2248,101 @@ DestroySubtree(
     _Inout_opt_ Node* SubtreeRoot
 ) noexcept(true)
 {
-    Node* current = SubtreeRoot;
-
-    while (nullptr != current)
+    if constexpr (xpf::IsTriviallyDestructible<Key>() && xpf::IsTriviallyDestructible<Value>())
     {
-        if (nullptr == current->Left)
-        {
-            /* No left child -- deallocate current and move right. */
-            Node* next = current->Right;
-            this->DeallocateNode(current);
-            current = next;
-        }
-        else
+        XPF_UNREFERENCED_PARAMETER(SubtreeRoot);
+    }
+    else
+    {
+        Node* current = SubtreeRoot;
+
+        while (nullptr != current)
         {
-            /* Rotate the left child up to flatten the tree.        */
-            /* current becomes right child of its former left child. */
-            Node* left = current->Left;
-            current->Left = left->Right;
-            left->Right = current;
-            current = left;
+            if (nullptr == current->Left)
+            {
+                /* No left child -- destroy current and move right. */
+                Node* next = current->Right;
+                xpf::MemoryAllocator::Destruct(current);
+                current = next;
+            }
+            else
+            {
+                /* Rotate the left child up to flatten the tree.        */
+                /* current becomes right child of its former left child. */
+                Node* left = current->Left;
+                current->Left = left->Right;
+                left->Right = current;
+                current = left;
+            }
         }
     }
 }
 
+/**
+ * @brief       Allocates a new slab and makes it the newest one.
+ *              Each slab doubles the previous one, up to XPF_RED_BLACK_TREE_SLAB_MAX_BYTES.
+ *
+ * @return true if the slab was allocated, false otherwise.
+ */
+_Must_inspect_result_
+inline bool
+AllocateSlab(
+    void
+) noexcept(true)
+{
+    auto& allocator = this->m_CompressedPair.First();
+
+    const size_t maxNodes = (XPF_RED_BLACK_TREE_SLAB_MAX_BYTES / sizeof(Node) > XPF_RED_BLACK_TREE_SLAB_MIN_NODES)
+                            ? XPF_RED_BLACK_TREE_SLAB_MAX_BYTES / sizeof(Node)
+                            : XPF_RED_BLACK_TREE_SLAB_MIN_NODES;
+
+    size_t capacity = XPF_RED_BLACK_TREE_SLAB_MIN_NODES;
+    if (nullptr != this->m_Slabs)
+    {
+        capacity = (this->m_Slabs->Capacity < maxNodes / 2) ? this->m_Slabs->Capacity * 2
+                                                            : maxNodes;
+    }
+
+    void* memory = allocator.AllocateMemory(SLAB_HEADER_SIZE + capacity * sizeof(Node));
+    if (nullptr == memory)
+    {
+        return false;
+    }
+
+    RedBlackTreeNodeSlab* slab = static_cast<RedBlackTreeNodeSlab*>(memory);
+    xpf::MemoryAllocator::Construct(slab);
+
+    slab->Next = this->m_Slabs;
+    slab->Capacity = capacity;
+    slab->Used = 0;
+
+    this->m_Slabs = slab;
+    return true;
+}
+
+/**
+ * @brief       Frees all slabs and empties the free list.
+ *              All nodes must have been destroyed before.
+ */
+inline void
+ReleaseSlabs(
+    void
+) noexcept(true)
+{
+    auto& allocator = this->m_CompressedPair.First();
+
+    while (nullptr != this->m_Slabs)
+    {
+        RedBlackTreeNodeSlab* next = this->m_Slabs->Next;
+
+        xpf::MemoryAllocator::Destruct(this->m_Slabs);
+        allocator.FreeMemory(this->m_Slabs);
+
+        this->m_Slabs = next;
+    }
+    this->m_FreeNodes = nullptr;
+}
+
 /**
  * @brief       Gets the root node of the tree. Primarily for testing.
  *
@@ -1623,6 +2374,23 @@ Root(
     * @brief The comparator used for key ordering.
     */
     Comparator m_Comparator;
+
+   /**
+    * @brief The slabs the nodes are carved from. The newest slab is first.
+    */
+    RedBlackTreeNodeSlab* m_Slabs = nullptr;
+
+   /**
+    * @brief The erased nodes, linked through their first bytes.
+    */
+    void* m_FreeNodes = nullptr;
+
+   /**
+    * @brief The nodes start right after the slab header, aligned for the node type.
+    */
+    static constexpr size_t SLAB_HEADER_SIZE = xpf::AlgoAlignValueUp(sizeof(RedBlackTreeNodeSlab),
+                                                                     alignof(Node));
+    static_assert(alignof(Node) <= XPF_DEFAULT_ALIGNMENT, "Over-aligned nodes are not supported!");
 };  // class RedBlackTree
 
 
@@ -1646,6 +2414,11 @@ class Map final
      */
     using Iterator = typename RedBlackTree<Key, Value, Comparator>::Iterator;
 
+    /**
+     * @brief Range type returned by EqualRange.
+     */
+    using Range = typename RedBlackTree<Key, Value, Comparator>::Range;
+
 /**
  * @brief       Map constructor - default.
  *
@@ -1770,6 +2543,87 @@ Erase(
     return this->m_Tree.Erase(KeyToErase);
 }
 
+/**
+ * @brief       Finds the first element whose key is not less than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key >= KeyToFind, or End().
+ */
+inline Iterator
+LowerBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.LowerBound(KeyToFind);
+}
+
+/**
+ * @brief       Finds the first element whose key is greater than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key > KeyToFind, or End().
+ */
+inline Iterator
+UpperBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.UpperBound(KeyToFind);
+}
+
+/**
+ * @brief       Finds the elements equal to the given key (at most one).
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return The range [LowerBound(KeyToFind), UpperBound(KeyToFind)).
+ */
+inline Range
+EqualRange(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.EqualRange(KeyToFind);
+}
+
+/**
+ * @brief       Removes all the elements in [First, Last).
+ *
+ * @param[in]   First - The first element to erase.
+ * @param[in]   Last  - The element following the last one to erase.
+ *
+ * @return The number of erased elements.
+ */
+inline size_t
+EraseRange(
+    _In_ Iterator First,
+    _In_ Iterator Last
+) noexcept(true)
+{
+    return this->m_Tree.EraseRange(First, Last);
+}
+
+/**
+ * @brief       Replaces the content of the map with the given sorted elements in O(n).
+ *
+ * @param[in]   Keys   - The keys, strictly increasing by the comparator. Copied.
+ * @param[in]   Values - The values, one for each key. Copied.
+ *
+ * @return STATUS_SUCCESS if the map was built, an error otherwise.
+ *         On failure the map is left empty.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+BuildFromSorted(
+    _In_ _Const_ const xpf::Span<Key>& Keys,
+    _In_ _Const_ const xpf::Span<Value>& Values
+) noexcept(true)
+{
+    return this->m_Tree.BuildFromSorted(Keys, Values);
+}
+
 /**
  * @brief       Returns an iterator to the smallest key.
  *
@@ -1899,6 +2753,11 @@ class Set final
      */
     using Iterator = typename RedBlackTree<Key, uint8_t, Comparator>::Iterator;
 
+    /**
+     * @brief Range type returned by EqualRange.
+     */
+    using Range = typename RedBlackTree<Key, uint8_t, Comparator>::Range;
+
 /**
  * @brief       Set constructor - default.
  *
@@ -2024,6 +2883,85 @@ Erase(
     return this->m_Tree.Erase(KeyToErase);
 }
 
+/**
+ * @brief       Finds the first element whose key is not less than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key >= KeyToFind, or End().
+ */
+inline Iterator
+LowerBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.LowerBound(KeyToFind);
+}
+
+/**
+ * @brief       Finds the first element whose key is greater than the given key.
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return An iterator to the first element with key > KeyToFind, or End().
+ */
+inline Iterator
+UpperBound(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.UpperBound(KeyToFind);
+}
+
+/**
+ * @brief       Finds the elements equal to the given key (at most one).
+ *
+ * @param[in]   KeyToFind - The key to search for.
+ *
+ * @return The range [LowerBound(KeyToFind), UpperBound(KeyToFind)).
+ */
+inline Range
+EqualRange(
+    _In_ _Const_ const Key& KeyToFind
+) const noexcept(true)
+{
+    return this->m_Tree.EqualRange(KeyToFind);
+}
+
+/**
+ * @brief       Removes all the elements in [First, Last).
+ *
+ * @param[in]   First - The first element to erase.
+ * @param[in]   Last  - The element following the last one to erase.
+ *
+ * @return The number of erased elements.
+ */
+inline size_t
+EraseRange(
+    _In_ Iterator First,
+    _In_ Iterator Last
+) noexcept(true)
+{
+    return this->m_Tree.EraseRange(First, Last);
+}
+
+/**
+ * @brief       Replaces the content of the set with the given sorted keys in O(n).
+ *
+ * @param[in]   Keys - The keys, strictly increasing by the comparator. Copied.
+ *
+ * @return STATUS_SUCCESS if the set was built, an error otherwise.
+ *         On failure the set is left empty.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+BuildFromSorted(
+    _In_ _Const_ const xpf::Span<Key>& Keys
+) noexcept(true)
+{
+    return this->m_Tree.BuildFromSorted(Keys);
+}
+
 /**
  * @brief       Returns an iterator to the smallest key.
  *
@@ -0,0 +1,911 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/SmallVector.hpp
+ *
+ * @brief       C++ -like vector which stores the first few elements inline.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+#include "xpf_lib/public/core/Sort.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+
+#include "xpf_lib/public/Containers/Span.hpp"
+
+
+namespace xpf
+{
+/**
+ * @brief This is a vector which stores up to InlineCapacity elements inside the object.
+ *        Only when it grows past that it spills to memory from the allocator.
+ *        So small collections don't pay for an allocation and a pointer chase.
+ *
+ *        It has the same API as xpf::Vector.
+ *
+ * @note  Unlike xpf::Vector, moving a small vector which stores its elements inline
+ *        moves each element. The object is also as large as its inline storage.
+ */
+template <class Type, size_t InlineCapacity>
+class SmallVector final
+{
+    static_assert(InlineCapacity > 0, "The inline capacity can't be 0. Use xpf::Vector instead!");
+
+ public:
+/**
+ * @brief       SmallVector constructor - default.
+ *
+ * @param[in]   Allocator - to be used when the elements don't fit inline.
+ *
+ * @note        Stateful allocators must outlive this object.
+ */
+SmallVector(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Allocator{ Allocator }
+{
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
+
+    this->m_Elements = this->InlineElements();
+    this->m_Capacity = InlineCapacity;
+}
+
+/**
+ * @brief Destructor will destroy the elements and the allocated memory - if any.
+ */
+~SmallVector(
+    void
+) noexcept(true)
+{
+    this->Clear();
+}
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+SmallVector(
+    _In_ _Const_ const SmallVector& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move constructor.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ */
+SmallVector(
+    _Inout_ SmallVector&& Other
+) noexcept(true) : m_Allocator{ Other.m_Allocator }
+{
+    this->m_Elements = this->InlineElements();
+    this->m_Capacity = InlineCapacity;
+
+    this->TakeElements(Other);
+}
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+SmallVector&
+operator=(
+    _In_ _Const_ const SmallVector& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Move assignment.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *                        Will be invalidated after this call.
+ *
+ * @return A reference to *this object after move.
+ */
+SmallVector&
+operator=(
+    _Inout_ SmallVector&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        this->Clear();
+
+        this->m_Allocator = Other.m_Allocator;
+        this->TakeElements(Other);
+    }
+    return *this;
+}
+
+/**
+ * @brief Retrieves a const reference to the element at given index.
+ *
+ * @param[in] Index - The index to retrieve the element from.
+ *
+ * @return A const reference to the element at given position.
+ */
+inline const Type&
+operator[](
+    _In_ size_t Index
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(Index < this->m_Size);
+    return this->m_Elements[Index];
+}
+
+/**
+ * @brief Retrieves a reference to a element at given index.
+ *
+ * @param[in] Index - The index to retrieve the element from.
+ *
+ * @return A reference to the element at given position.
+ */
+inline Type&
+operator[](
+    _In_ size_t Index
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(Index < this->m_Size);
+    return this->m_Elements[Index];
+}
+
+/**
+ * @brief Checks if there are no elements.
+ *
+ * @return true if there are no elements,
+ *         false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return (this->m_Size == 0);
+}
+
+/**
+ * @brief Gets the number of elements.
+ *
+ * @return The number of elements.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Size;
+}
+
+/**
+ * @brief Gets the number of elements the vector can hold without reallocating.
+ *
+ * @return The current capacity of the vector - at least InlineCapacity.
+ */
+inline size_t
+Capacity(
+    void
+) const noexcept(true)
+{
+    return this->m_Capacity;
+}
+
+/**
+ * @brief Checks whether the elements are stored inside the object.
+ *
+ * @return true if the elements are stored inline,
+ *         false if they were spilled to the allocator.
+ */
+inline bool
+IsInline(
+    void
+) const noexcept(true)
+{
+    return this->m_Elements == this->InlineElements();
+}
+
+/**
+ * @brief Gets the underlying Allocator.
+ *
+ * @return A const reference to the underlying allocator.
+ */
+inline const xpf::PolymorphicAllocator&
+GetAllocator(
+    void
+) const noexcept(true)
+{
+    return this->m_Allocator;
+}
+
+/**
+ * @brief Destroys the elements and goes back to the inline storage.
+ */
+inline void
+Clear(
+    void
+) noexcept(true)
+{
+    for (size_t i = 0; i < this->m_Size; ++i)
+    {
+        xpf::MemoryAllocator::Destruct(&this->m_Elements[i]);
+    }
+    this->m_Size = 0;
+
+    if (!this->IsInline())
+    {
+        this->m_Allocator.FreeMemory(this->m_Elements);
+
+        this->m_Elements = this->InlineElements();
+        this->m_Capacity = InlineCapacity;
+    }
+}
+
+/**
+ * @brief Resize the vector to have the given Capacity.
+ *        A capacity up to InlineCapacity moves the elements back inline.
+ *
+ * @param[in] Capacity - The new capacity of the vector.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the Capacity is not large enough to accomodate the
+ *       current elements, the function fails and the remaining vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Resize(
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    //
+    // Ensure the new capacity can store all elements.
+    //
+    if (Capacity < this->m_Size)
+    {
+        return STATUS_INVALID_BUFFER_SIZE;
+    }
+
+    //
+    // The elements fit inline. Move them back if they were spilled.
+    //
+    if (Capacity <= InlineCapacity)
+    {
+        if (!this->IsInline())
+        {
+            Type* oldElements = this->m_Elements;
+
+            SmallVector::RelocateElements(this->InlineElements(), oldElements, this->m_Size);
+            this->m_Allocator.FreeMemory(oldElements);
+
+            this->m_Elements = this->InlineElements();
+            this->m_Capacity = InlineCapacity;
+        }
+        return STATUS_SUCCESS;
+    }
+    if (Capacity == this->m_Capacity)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // Ensure the new capacity won't overflow.
+    //
+    size_t sizeInBytes = 0;
+    if (!xpf::ApiNumbersSafeMul(Capacity, sizeof(Type), &sizeInBytes))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+
+    Type* newElements = static_cast<Type*>(this->m_Allocator.AllocateMemory(sizeInBytes));
+    if (nullptr == newElements)
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    SmallVector::RelocateElements(newElements, this->m_Elements, this->m_Size);
+    if (!this->IsInline())
+    {
+        this->m_Allocator.FreeMemory(this->m_Elements);
+    }
+
+    this->m_Elements = newElements;
+    this->m_Capacity = Capacity;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Ensures the vector can hold at least Capacity elements without reallocating.
+ *        The current elements are preserved. The capacity is never decreased.
+ *
+ * @param[in] Capacity - The minimum number of elements the vector should be able to hold.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+ReserveCapacity(
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    if (Capacity <= this->m_Capacity)
+    {
+        return STATUS_SUCCESS;
+    }
+    return this->Resize(Capacity);
+}
+
+/**
+ * @brief Constructs an element at the back of the vector.
+ *        Uses the provided arguments
+ *
+ * @param[in,out] ConstructorArguments - To be provided to the object.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+template <typename... Arguments>
+_Must_inspect_result_
+inline NTSTATUS
+Emplace(
+    Arguments&& ...ConstructorArguments
+) noexcept(true)
+{
+    if (this->m_Size == this->m_Capacity)
+    {
+        const NTSTATUS status = this->Grow(this->m_Size + 1);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+
+    xpf::MemoryAllocator::Construct(&this->m_Elements[this->m_Size],
+                                    xpf::Forward<Arguments>(ConstructorArguments)...);
+    this->m_Size++;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Reserves n slots in vector, note they are initialized
+ *        with the provided value. The other elements are erased.
+ *
+ * @param[in] N     - The number of elements to reserve
+ * @param[in] Value - The value to initialzie the elements with.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ *       If the operations succeeds, the current elements are destroyed.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Reserve(
+    _In_ size_t N,
+    _In_ _Const_ const Type& Value
+) noexcept(true)
+{
+    xpf::SmallVector<Type, InlineCapacity> clone(this->m_Allocator);
+
+    NTSTATUS status = clone.ReserveCapacity(N);
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        status = clone.Emplace(Value);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+
+    *this = xpf::Move(clone);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Erases the element at the given position
+ *
+ * @param[in] Position - the position where the element to be erased is.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Erase(
+    _In_ size_t Position
+) noexcept(true)
+{
+    return this->EraseRange(Position, 1);
+}
+
+/**
+ * @brief Erases Count consecutive elements starting at the given position.
+ *        The elements from the right are moved only once.
+ *
+ * @param[in] Position - the position of the first element to be erased.
+ *
+ * @param[in] Count - the number of elements to be erased.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+EraseRange(
+    _In_ size_t Position,
+    _In_ size_t Count
+) noexcept(true)
+{
+    //
+    // Sanity check. The second condition can't overflow as Position < m_Size.
+    //
+    if ((Position >= this->m_Size) || (Count > this->m_Size - Position))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (0 == Count)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    for (size_t i = Position; i < Position + Count; ++i)
+    {
+        xpf::MemoryAllocator::Destruct(&this->m_Elements[i]);
+    }
+    this->ShiftElements(Position + Count, Position);
+    this->m_Size -= Count;
+
+    this->ShrinkIfMostlyEmpty();
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Erases all elements for which the predicate returns true, in a single pass.
+ *        The remaining elements keep their relative order.
+ *
+ * @param[in] ErasePredicate - a lambda with the signature(const& Element) which returns
+ *                             true if the element should be erased.
+ *                             It is called exactly once for every element, in order.
+ *
+ * @return The number of erased elements.
+ */
+template <class Predicate>
+inline size_t
+EraseIf(
+    _In_ Predicate ErasePredicate
+) noexcept(true)
+{
+    size_t kept = 0;
+
+    for (size_t i = 0; i < this->m_Size; ++i)
+    {
+        if (ErasePredicate(static_cast<const Type&>(this->m_Elements[i])))
+        {
+            xpf::MemoryAllocator::Destruct(&this->m_Elements[i]);
+            continue;
+        }
+        if (kept != i)
+        {
+            SmallVector::RelocateElements(&this->m_Elements[kept], &this->m_Elements[i], 1);
+        }
+        kept++;
+    }
+
+    const size_t erased = this->m_Size - kept;
+    this->m_Size = kept;
+
+    this->ShrinkIfMostlyEmpty();
+    return erased;
+}
+
+/**
+ * @brief Erases the element at the given position by moving the last element in its place.
+ *        The order of the elements is not preserved, but no other element is moved.
+ *
+ * @param[in] Position - the position where the element to be erased is.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+SwapRemove(
+    _In_ size_t Position
+) noexcept(true)
+{
+    if (Position >= this->m_Size)
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    const size_t last = this->m_Size - 1;
+
+    xpf::MemoryAllocator::Destruct(&this->m_Elements[Position]);
+    if (Position != last)
+    {
+        SmallVector::RelocateElements(&this->m_Elements[Position], &this->m_Elements[last], 1);
+    }
+    this->m_Size--;
+
+    this->ShrinkIfMostlyEmpty();
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Copies the given elements at the back of the vector.
+ *
+ * @param[in] Elements - The elements to be copied. They must not belong to this vector.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+AppendRange(
+    _In_ _Const_ const xpf::Span<Type>& Elements
+) noexcept(true)
+{
+    return this->InsertRange(this->m_Size, Elements);
+}
+
+/**
+ * @brief Copies the given elements at the given position.
+ *        The vector grows at most once and the elements from the right are moved only once.
+ *
+ * @param[in] Position - Where to insert the elements. Can be Size() to append them.
+ *
+ * @param[in] Elements - The elements to be copied. They must not belong to this vector.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+InsertRange(
+    _In_ size_t Position,
+    _In_ _Const_ const xpf::Span<Type>& Elements
+) noexcept(true)
+{
+    const size_t count = Elements.Size();
+
+    if (Position > this->m_Size)
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (0 == count)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // The elements can't come from our own storage - we might reallocate it.
+    //
+    if ((Elements.Buffer() + count > this->m_Elements) &&
+        (Elements.Buffer() < this->m_Elements + this->m_Capacity))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    size_t requiredCapacity = 0;
+    if (!xpf::ApiNumbersSafeAdd(this->m_Size, count, &requiredCapacity))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+    if (requiredCapacity > this->m_Capacity)
+    {
+        const NTSTATUS status = this->Grow(requiredCapacity);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+
+    //
+    // Make room and copy-construct the new elements in place.
+    //
+    this->ShiftElements(Position, Position + count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        xpf::MemoryAllocator::Construct(&this->m_Elements[Position + i],
+                                        Elements[i]);
+    }
+    this->m_Size += count;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Sorts the elements with the provided SortingPredicate.
+ *              See xpf::AlgoSort for details. This is an unstable sort.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ */
+template <class Predicate>
+inline void
+Sort(
+    _In_ Predicate SortingPredicate
+) noexcept(true)
+{
+    xpf::AlgoSort(this->m_Elements,
+                  this->m_Size,
+                  SortingPredicate);
+}
+
+/**
+ * @brief       Sorts the elements with the provided SortingPredicate.
+ *              Equal elements keep their relative order. See xpf::AlgoStableSort for details.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ *
+ * @return      STATUS_INSUFFICIENT_RESOURCES if the scratch buffer could not be allocated -
+ *              the vector is left unchanged. STATUS_SUCCESS otherwise.
+ *
+ * @note        A scratch buffer of half the size of the vector is allocated using the vector's allocator.
+ */
+template <class Predicate>
+_Must_inspect_result_
+inline NTSTATUS
+StableSort(
+    _In_ Predicate SortingPredicate
+) noexcept(true)
+{
+    if (this->m_Size <= xpf::XPF_STABLE_SORT_RUN_SIZE)
+    {
+        xpf::AlgoStableSort(this->m_Elements, this->m_Size, static_cast<Type*>(nullptr), SortingPredicate);
+        return STATUS_SUCCESS;
+    }
+
+    size_t scratchSize = 0;
+    if (!xpf::ApiNumbersSafeMul(this->m_Size / 2, sizeof(Type), &scratchSize))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+
+    Type* scratch = static_cast<Type*>(this->m_Allocator.AllocateMemory(scratchSize));
+    if (nullptr == scratch)
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    xpf::AlgoStableSort(this->m_Elements,
+                        this->m_Size,
+                        scratch,
+                        SortingPredicate);
+
+    this->m_Allocator.FreeMemory(scratch);
+    return STATUS_SUCCESS;
+}
+
+ private:
+/**
+ * @brief Gets the inline storage.
+ *
+ * @return A pointer to the first inline element.
+ */
+inline Type*
+InlineElements(
+    void
+) noexcept(true)
+{
+    return static_cast<Type*>(static_cast<void*>(&this->m_InlineStorage[0]));
+}
+
+/**
+ * @brief Gets the inline storage - const variant.
+ *
+ * @return A pointer to the first inline element.
+ */
+inline const Type*
+InlineElements(
+    void
+) const noexcept(true)
+{
+    return static_cast<const Type*>(static_cast<const void*>(&this->m_InlineStorage[0]));
+}
+
+/**
+ * @brief Moves Count elements to a location which does not overlap with the source.
+ *        The source elements are destroyed.
+ *
+ * @param[out] Destination - Where to move the elements. Uninitialized memory.
+ *
+ * @param[in,out] Source - The elements to be moved.
+ *
+ * @param[in] Count - The number of elements.
+ */
+static inline void
+RelocateElements(
+    _Out_ Type* Destination,
+    _Inout_ Type* Source,
+    _In_ size_t Count
+) noexcept(true)
+{
+    if constexpr (xpf::IsTriviallyRelocatable<Type>())
+    {
+        xpf::ApiCopyMemory(Destination,
+                           Source,
+                           Count * sizeof(Type));
+    }
+    else
+    {
+        for (size_t i = 0; i < Count; ++i)
+        {
+            xpf::MemoryAllocator::Construct(&Destination[i],
+                                            xpf::Move(Source[i]));
+            xpf::MemoryAllocator::Destruct(&Source[i]);
+        }
+    }
+}
+
+/**
+ * @brief Moves the elements in [From, m_Size) so they start at To.
+ *        The slots left behind are uninitialized. m_Size is not updated.
+ *
+ * @param[in] From - The index of the first element to be moved.
+ *
+ * @param[in] To - The new index of that element. The capacity must be large enough.
+ */
+inline void
+ShiftElements(
+    _In_ size_t From,
+    _In_ size_t To
+) noexcept(true)
+{
+    const size_t count = this->m_Size - From;
+
+    if constexpr (xpf::IsTriviallyRelocatable<Type>())
+    {
+        //
+        // ApiCopyMemory handles the overlapping ranges.
+        //
+        xpf::ApiCopyMemory(&this->m_Elements[To],
+                           &this->m_Elements[From],
+                           count * sizeof(Type));
+    }
+    else
+    {
+        //
+        // Moving to the right starts with the last element, so we don't overwrite any element.
+        //
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t index = (To > From) ? (count - 1 - i) : i;
+
+            xpf::MemoryAllocator::Construct(&this->m_Elements[To + index],
+                                            xpf::Move(this->m_Elements[From + index]));
+            xpf::MemoryAllocator::Destruct(&this->m_Elements[From + index]);
+        }
+    }
+}
+
+/**
+ * @brief Grows the vector so it can hold at least RequiredCapacity elements.
+ *        It doubles the capacity, or grows to RequiredCapacity if that is not enough.
+ *
+ * @param[in] RequiredCapacity - The minimum number of elements.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Grow(
+    _In_ size_t RequiredCapacity
+) noexcept(true)
+{
+    size_t newCapacity = 0;
+    if (!xpf::ApiNumbersSafeMul(this->m_Capacity, this->GROWTH_FACTOR, &newCapacity))
+    {
+        newCapacity = RequiredCapacity;
+    }
+    if (newCapacity < RequiredCapacity)
+    {
+        newCapacity = RequiredCapacity;
+    }
+    return this->Resize(newCapacity);
+}
+
+/**
+ * @brief Gives back memory when the vector is mostly empty. This is a best effort.
+ *        Uses the same hysteresis as xpf::Vector, and goes back inline when possible.
+ *        The inline storage is the floor - going back to it does not allocate.
+ */
+inline void
+ShrinkIfMostlyEmpty(
+    void
+) noexcept(true)
+{
+    size_t newCapacity = this->m_Capacity;
+
+    while ((newCapacity > InlineCapacity) &&
+           ((newCapacity / this->SHRINK_FACTOR) > this->m_Size))
+    {
+        newCapacity = newCapacity / this->GROWTH_FACTOR;
+    }
+
+    if (newCapacity != this->m_Capacity)
+    {
+        (void) this->Resize(newCapacity);
+    }
+}
+
+/**
+ * @brief Takes the elements from Other. This object must be empty and inline.
+ *
+ * @param[in,out] Other - The vector to take the elements from. It is left empty.
+ */
+inline void
+TakeElements(
+    _Inout_ SmallVector& Other
+) noexcept(true)
+{
+    if (Other.IsInline())
+    {
+        SmallVector::RelocateElements(this->m_Elements, Other.m_Elements, Other.m_Size);
+    }
+    else
+    {
+        this->m_Elements = Other.m_Elements;
+        this->m_Capacity = Other.m_Capacity;
+
+        Other.m_Elements = Other.InlineElements();
+        Other.m_Capacity = InlineCapacity;
+    }
+
+    this->m_Size = Other.m_Size;
+    Other.m_Size = 0;
+}
+
+ private:
+    /**
+     * @brief Every time we need to grow, we'll do that by doubling the capacity.
+     */
+    static constexpr size_t GROWTH_FACTOR = 2;
+
+    /**
+    * @brief We shrink only when less than a quarter of the capacity is used.
+    */
+    static constexpr size_t SHRINK_FACTOR = 4;
+
+    xpf::PolymorphicAllocator m_Allocator;
+    Type* m_Elements = nullptr;
+    size_t m_Size = 0;
+    size_t m_Capacity = 0;
+
+    /**
+     * @brief The inline storage. The elements are constructed in place only when used.
+     */
+    alignas(Type) uint8_t m_InlineStorage[InlineCapacity * sizeof(Type)];
+};  // class SmallVector
+};  // namespace xpf
@@ -195,4 +195,179 @@ SubSpan(
     const Type* m_Buffer = nullptr;
     size_t      m_Size   = 0;
 };  // class Span
+
+//
+// ************************************************************************************************
+// This is the section containing the MutableSpan implementation.
+// The same non-owning view, for callees which write the elements - output buffers.
+// ************************************************************************************************
+//
+
+/**
+ * @brief This is a non-owning view over contiguous elements which may be written.
+ *        It does not manage the lifetime of the underlying data.
+ *        It converts to the read-only Span where one is expected.
+ */
+template <class Type>
+class MutableSpan final
+{
+ public:
+/**
+ * @brief       MutableSpan constructor - default. Creates an empty span.
+ */
+MutableSpan(
+    void
+) noexcept(true) : m_Buffer{ nullptr },
+                   m_Size{ 0 }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief       MutableSpan constructor from raw pointer and size.
+ *
+ * @param[in]   Buffer - Pointer to the first element. Can be nullptr if Size is 0.
+ *
+ * @param[in]   Size   - Number of elements in the span.
+ */
+MutableSpan(
+    _In_opt_ Type* Buffer,
+    _In_ size_t Size
+) noexcept(true) : m_Buffer{ Buffer },
+                   m_Size{ Size }
+{
+    /*
+     * Same as Span - if the buffer is null, the size must be 0.
+     */
+    if (nullptr == this->m_Buffer)
+    {
+        this->m_Size = 0;
+    }
+}
+
+/**
+ * @brief       MutableSpan constructor from a C-style array.
+ *              The size is automatically deduced from the array.
+ *
+ * @param[in]   Array - Reference to a C-style array of N elements.
+ */
+template <size_t N>
+MutableSpan(
+    _In_ Type (&Array)[N]
+) noexcept(true) : m_Buffer{ &Array[0] },
+                   m_Size{ N }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Default destructor.
+ */
+~MutableSpan(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be both copied and moved (shallow copy, non-owning).
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(MutableSpan, default);
+
+/**
+ * @brief Checks if the span is empty (contains no elements).
+ *
+ * @return true if the span has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return (this->m_Size == 0);
+}
+
+/**
+ * @brief Gets the number of elements in the span.
+ *
+ * @return The number of elements in the span.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    return this->m_Size;
+}
+
+/**
+ * @brief Gets a pointer to the underlying buffer.
+ *
+ * @return A pointer to the first element, or nullptr if the span is empty.
+ */
+inline Type*
+Buffer(
+    void
+) const noexcept(true)
+{
+    return this->m_Buffer;
+}
+
+/**
+ * @brief Retrieves a reference to the element at the given index.
+ *        Bounds-checked: triggers XPF_DEATH_ON_FAILURE on out-of-bounds access.
+ *
+ * @param[in] Index - The index of the element to retrieve.
+ *
+ * @return A reference to the element at the given index.
+ */
+inline Type&
+operator[](
+    _In_ size_t Index
+) const noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(Index < this->m_Size);
+    return this->m_Buffer[Index];
+}
+
+/**
+ * @brief       Creates a sub-span, clamped to valid bounds the same way as Span::SubSpan.
+ *
+ * @param[in]   Offset - The starting index for the sub-span.
+ *
+ * @param[in]   Count  - The number of elements in the sub-span.
+ *
+ * @return A new MutableSpan representing the requested sub-range.
+ */
+inline MutableSpan
+SubSpan(
+    _In_ size_t Offset,
+    _In_ size_t Count
+) const noexcept(true)
+{
+    if (Offset >= this->m_Size)
+    {
+        return MutableSpan{};
+    }
+
+    const size_t available = this->m_Size - Offset;
+    const size_t clampedCount = (Count < available) ? Count : available;
+
+    return MutableSpan{ this->m_Buffer + Offset, clampedCount };
+}
+
+/**
+ * @brief Allows the span to be used where a read-only Span is expected.
+ *
+ * @return A read-only Span over the same elements.
+ */
+inline operator Span<Type>(
+    void
+) const noexcept(true)
+{
+    return Span<Type>{ this->m_Buffer, this->m_Size };
+}
+
+ private:
+    Type*   m_Buffer = nullptr;
+    size_t  m_Size   = 0;
+};  // class MutableSpan
 };  // namespace xpf
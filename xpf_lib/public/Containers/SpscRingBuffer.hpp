@@ -0,0 +1,669 @@
+﻿/**
+ * @file        xpf_lib/public/Containers/SpscRingBuffer.hpp
+ *
+ * @brief       Wait-free ring buffer for exactly one producer and one consumer.
+ *              Each side owns its index and keeps a cached copy of the other
+ *              side's index, so most operations touch no shared cache line at all.
+ *              The indices and the elements live in one region, either allocated
+ *              by the ring or supplied by the caller - for example shared memory.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Memory/CacheAligned.hpp"
+#include "xpf_lib/public/Containers/Span.hpp"
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the SpscRingBuffer implementation.
+// The head (next element to pop) and the tail (next element to push) only grow.
+// The element at position P is in the cell P & (Capacity - 1), and the ring
+// holds Tail - Head elements:
+//
+//       Head            Tail
+//        |               |
+//     [ .. | e0 | e1 | e2 | .. | .. ]
+//
+// The producer writes only the tail and the consumer writes only the head.
+// Each side reads the other's index only when its cached copy says the ring
+// is full (for the producer) or empty (for the consumer). The elements are
+// published with a release store of the index and picked up with an acquire
+// load - no compare-exchange, no retry loop, so every call is wait-free.
+//
+// Everything the two sides share is in one region, and nothing in it is a pointer:
+//
+//     [ SpscRingBufferHeader | cell 0 | cell 1 | ... | cell Capacity - 1 ]
+//
+// So the producer and the consumer may each use their own SpscRingBuffer object,
+// in different processes, over a region mapped at different addresses.
+// ************************************************************************************************
+//
+
+/**
+ * @brief The state written by the producer - kept on cache lines of its own.
+ */
+struct SpscRingBufferProducer
+{
+    /**
+     * @brief The next position to be filled. Written by the producer only.
+     */
+    xpf::Atomic<uint64_t> Tail{ 0 };
+
+    /**
+     * @brief The last head seen by the producer. Only the producer touches it.
+     */
+    uint64_t CachedHead = 0;
+};  // struct SpscRingBufferProducer
+
+/**
+ * @brief The state written by the consumer - kept on cache lines of its own.
+ */
+struct SpscRingBufferConsumer
+{
+    /**
+     * @brief The next position to be emptied. Written by the consumer only.
+     */
+    xpf::Atomic<uint64_t> Head{ 0 };
+
+    /**
+     * @brief The last tail seen by the consumer. Only the consumer touches it.
+     */
+    uint64_t CachedTail = 0;
+};  // struct SpscRingBufferConsumer
+
+/**
+ * @brief The start of the region of a ring - the cells follow it.
+ */
+struct SpscRingBufferHeader
+{
+    /**
+     * @brief The tail and the producer's copy of the head.
+     */
+    xpf::CacheAligned<SpscRingBufferProducer> Producer;
+
+    /**
+     * @brief The head and the consumer's copy of the tail.
+     */
+    xpf::CacheAligned<SpscRingBufferConsumer> Consumer;
+
+    /**
+     * @brief The number of cells. Written once, when the region is laid out.
+     */
+    uint64_t Capacity = 0;
+};  // struct SpscRingBufferHeader
+
+static_assert(0 == (sizeof(SpscRingBufferHeader) % XPF_DEFAULT_ALIGNMENT),
+              "The cells following the header must stay aligned!");
+
+/**
+ * @brief Bounded FIFO queue for one producer thread and one consumer thread.
+ *        TryPush/PushN may only be called by the producer and TryPop/PopN only
+ *        by the consumer - the ring does not guard against a second one.
+ *
+ *        The elements are copied in and out with memcpy, so Type must be trivially
+ *        copyable. Before the ring is used it needs a region - either Allocate it,
+ *        or Attach to a caller-supplied one. A region laid out by Attach can be
+ *        joined with AttachExisting by another SpscRingBuffer object - for example
+ *        when the producer and the consumer each map the same shared memory.
+ */
+template <class Type>
+class SpscRingBuffer final
+{
+    static_assert(xpf::IsTriviallyCopyable<Type>(), "The elements are copied with memcpy!");
+    static_assert(alignof(Type) <= XPF_DEFAULT_ALIGNMENT, "The cells are XPF_DEFAULT_ALIGNMENT aligned!");
+
+ public:
+/**
+ * @brief       SpscRingBuffer constructor - default. The ring has no region yet.
+ *
+ * @param[in]   Allocator - to be used by Allocate.
+ */
+SpscRingBuffer(
+    _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
+) noexcept(true) : m_Allocator{ Allocator }
+{
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
+}
+
+/**
+ * @brief Destructor. Frees the region if it was allocated by the ring.
+ *        The ring must no longer be used by the producer or the consumer.
+ */
+~SpscRingBuffer(
+    void
+) noexcept(true)
+{
+    if (this->m_OwnsRegion)
+    {
+        xpf::MemoryAllocator::Destruct(this->m_Header);
+        this->m_Allocator.FreeMemory(this->m_Header);
+    }
+    this->m_Header = nullptr;
+    this->m_Cells = nullptr;
+}
+
+/**
+ * @brief Copy and move semantics are deleted - the producer and the consumer hold a reference.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(SpscRingBuffer, delete);
+
+/**
+ * @brief       Computes the size of the region of a ring - the header and the cells.
+ *
+ * @param[in]   Capacity    - The number of elements. Must be a power of two.
+ * @param[out]  SizeInBytes - Receives the size of the region.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INVALID_PARAMETER if Capacity is not a power of two,
+ *         STATUS_INTEGER_OVERFLOW if the size overflows.
+ */
+_Must_inspect_result_
+static inline NTSTATUS
+RegionSize(
+    _In_ size_t Capacity,
+    _Out_ size_t* SizeInBytes
+) noexcept(true)
+{
+    *SizeInBytes = 0;
+
+    if (!SpscRingBuffer::IsValidCapacity(Capacity))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    size_t cellsSize = 0;
+    if (!xpf::ApiNumbersSafeMul(Capacity, sizeof(Type), &cellsSize))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+    if (!xpf::ApiNumbersSafeAdd(cellsSize, sizeof(SpscRingBufferHeader), SizeInBytes))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Allocates the region of the ring. Must be called before the ring is shared.
+ *
+ * @param[in]   Capacity - The number of elements. Must be a power of two.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INVALID_PARAMETER if Capacity is not a power of two,
+ *         STATUS_INVALID_STATE_TRANSITION if the ring already has a region,
+ *         STATUS_INTEGER_OVERFLOW if the region size overflows,
+ *         STATUS_INSUFFICIENT_RESOURCES on allocation failure.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Allocate(
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    size_t sizeInBytes = 0;
+    NTSTATUS status = SpscRingBuffer::RegionSize(Capacity, &sizeInBytes);
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+    if (nullptr != this->m_Header)
+    {
+        return STATUS_INVALID_STATE_TRANSITION;
+    }
+
+    void* region = this->m_Allocator.AllocateMemory(sizeInBytes);
+    if (nullptr == region)
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    status = this->Attach(region, sizeInBytes, Capacity);
+    XPF_DEATH_ON_FAILURE(NT_SUCCESS(status));
+
+    this->m_OwnsRegion = true;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Lays out an empty ring in a caller-supplied region and uses it.
+ *              Must be called before the region is shared. The region is not
+ *              freed by the ring and must outlive it.
+ *
+ * @param[in,out]   Region            - The region. Must be XPF_DEFAULT_ALIGNMENT aligned.
+ * @param[in]       RegionSizeInBytes - The size of Region. At least RegionSize(Capacity).
+ * @param[in]       Capacity          - The number of elements. Must be a power of two.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INVALID_PARAMETER if the region is null, misaligned or too small,
+ *                                  or if Capacity is not a power of two,
+ *         STATUS_INVALID_STATE_TRANSITION if the ring already has a region.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+Attach(
+    _Inout_ void* Region,
+    _In_ size_t RegionSizeInBytes,
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    if (!SpscRingBuffer::IsValidRegion(Region, RegionSizeInBytes, Capacity))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (nullptr != this->m_Header)
+    {
+        return STATUS_INVALID_STATE_TRANSITION;
+    }
+
+    SpscRingBufferHeader* header = static_cast<SpscRingBufferHeader*>(Region);
+    xpf::MemoryAllocator::Construct(header);
+    header->Capacity = Capacity;
+
+    this->Use(header, Capacity);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Uses a region already laid out by Attach - possibly through another
+ *              mapping, in another process. The capacity is the one stored in the region.
+ *              The region is not freed by the ring and must outlive it.
+ *
+ * @param[in,out]   Region            - The region. Must be XPF_DEFAULT_ALIGNMENT aligned.
+ * @param[in]       RegionSizeInBytes - The size of Region, to validate the stored capacity.
+ *
+ * @return STATUS_SUCCESS on success,
+ *         STATUS_INVALID_PARAMETER if the region is null or misaligned,
+ *                                  or if the stored capacity does not fit in it,
+ *         STATUS_INVALID_STATE_TRANSITION if the ring already has a region.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+AttachExisting(
+    _Inout_ void* Region,
+    _In_ size_t RegionSizeInBytes
+) noexcept(true)
+{
+    if ((nullptr == Region) || (RegionSizeInBytes < sizeof(SpscRingBufferHeader)))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    SpscRingBufferHeader* header = static_cast<SpscRingBufferHeader*>(Region);
+    const size_t capacity = static_cast<size_t>(header->Capacity);
+    if ((uint64_t{ capacity } != header->Capacity) ||
+        !SpscRingBuffer::IsValidRegion(Region, RegionSizeInBytes, capacity))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (nullptr != this->m_Header)
+    {
+        return STATUS_INVALID_STATE_TRANSITION;
+    }
+
+    this->Use(header, capacity);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief       Adds an element at the back, if there is room. Producer only.
+ *
+ * @param[in]   Value - The element to be copied in.
+ *
+ * @return true if the element was added, false if the ring is full (or has no region).
+ */
+_Must_inspect_result_
+inline bool
+TryPush(
+    _In_ _Const_ const Type& Value
+) noexcept(true)
+{
+    if (nullptr == this->m_Header)
+    {
+        return false;
+    }
+
+    SpscRingBufferProducer& producer = this->m_Header->Producer.Get();
+    const uint64_t tail = producer.Tail.Load(xpf::MemoryOrder::Relaxed);
+
+    /* Look at the real head only if the cached one says the ring is full. */
+    if (tail - producer.CachedHead > this->m_Mask)
+    {
+        producer.CachedHead = this->m_Header->Consumer.Get().Head.Load(xpf::MemoryOrder::Acquire);
+        if (tail - producer.CachedHead > this->m_Mask)
+        {
+            return false;
+        }
+    }
+
+    this->m_Cells[tail & this->m_Mask] = Value;
+    producer.Tail.Store(tail + 1, xpf::MemoryOrder::Release);
+    return true;
+}
+
+/**
+ * @brief       Removes the element at the front, if there is one. Consumer only.
+ *
+ * @param[out]  Value - Receives the element.
+ *
+ * @return true if an element was removed, false if the ring is empty (or has no region).
+ */
+_Must_inspect_result_
+inline bool
+TryPop(
+    _Out_ Type& Value
+) noexcept(true)
+{
+    if (nullptr == this->m_Header)
+    {
+        return false;
+    }
+
+    SpscRingBufferConsumer& consumer = this->m_Header->Consumer.Get();
+    const uint64_t head = consumer.Head.Load(xpf::MemoryOrder::Relaxed);
+
+    /* Look at the real tail only if the cached one says the ring is empty. */
+    if (consumer.CachedTail == head)
+    {
+        consumer.CachedTail = this->m_Header->Producer.Get().Tail.Load(xpf::MemoryOrder::Acquire);
+        if (consumer.CachedTail == head)
+        {
+            return false;
+        }
+    }
+
+    Value = this->m_Cells[head & this->m_Mask];
+    consumer.Head.Store(head + 1, xpf::MemoryOrder::Release);
+    return true;
+}
+
+/**
+ * @brief       Adds as many of the given elements as there is room for, in order,
+ *              with at most two copies and one publication. Producer only.
+ *
+ * @param[in]   Values - The elements to be copied in.
+ *
+ * @return The number of elements added - a prefix of Values.
+ */
+inline size_t
+PushN(
+    _In_ _Const_ const xpf::Span<Type>& Values
+) noexcept(true)
+{
+    if (nullptr == this->m_Header)
+    {
+        return 0;
+    }
+
+    SpscRingBufferProducer& producer = this->m_Header->Producer.Get();
+    const uint64_t capacity = uint64_t{ this->m_Mask } + 1;
+    const uint64_t tail = producer.Tail.Load(xpf::MemoryOrder::Relaxed);
+
+    /* Look at the real head only if the cached one says there is not enough room. */
+    uint64_t room = capacity - (tail - producer.CachedHead);
+    if (room < Values.Size())
+    {
+        producer.CachedHead = this->m_Header->Consumer.Get().Head.Load(xpf::MemoryOrder::Acquire);
+        room = capacity - (tail - producer.CachedHead);
+    }
+
+    const size_t count = (room < Values.Size()) ? static_cast<size_t>(room)
+                                                : Values.Size();
+    if (0 == count)
+    {
+        return 0;
+    }
+
+    this->CopyIn(static_cast<size_t>(tail & this->m_Mask), Values.Buffer(), count);
+    producer.Tail.Store(tail + count, xpf::MemoryOrder::Release);
+    return count;
+}
+
+/**
+ * @brief       Removes as many elements as Values has room for, in order,
+ *              with at most two copies and one publication. Consumer only.
+ *
+ * @param[in]   Values - Receives the elements - a prefix of it is written.
+ *
+ * @return The number of elements removed and written to Values.
+ */
+inline size_t
+PopN(
+    _In_ _Const_ const xpf::MutableSpan<Type>& Values
+) noexcept(true)
+{
+    if (nullptr == this->m_Header)
+    {
+        return 0;
+    }
+
+    SpscRingBufferConsumer& consumer = this->m_Header->Consumer.Get();
+    const uint64_t head = consumer.Head.Load(xpf::MemoryOrder::Relaxed);
+
+    /* Look at the real tail only if the cached one says there are not enough elements. */
+    uint64_t available = consumer.CachedTail - head;
+    if (available < Values.Size())
+    {
+        consumer.CachedTail = this->m_Header->Producer.Get().Tail.Load(xpf::MemoryOrder::Acquire);
+        available = consumer.CachedTail - head;
+    }
+
+    const size_t count = (available < Values.Size()) ? static_cast<size_t>(available)
+                                                     : Values.Size();
+    if (0 == count)
+    {
+        return 0;
+    }
+
+    this->CopyOut(static_cast<size_t>(head & this->m_Mask), Values.Buffer(), count);
+    consumer.Head.Store(head + count, xpf::MemoryOrder::Release);
+    return count;
+}
+
+/**
+ * @brief       Gets the number of elements. Exact when called by the producer
+ *              or the consumer while the other side is idle, an estimate otherwise.
+ *
+ * @return The number of elements in the ring.
+ */
+inline size_t
+Size(
+    void
+) const noexcept(true)
+{
+    if (nullptr == this->m_Header)
+    {
+        return 0;
+    }
+
+    const uint64_t head = this->m_Header->Consumer.Get().Head.Load(xpf::MemoryOrder::Acquire);
+    const uint64_t tail = this->m_Header->Producer.Get().Tail.Load(xpf::MemoryOrder::Acquire);
+
+    /* The indices are read one after the other, so the head may have passed the tail we saw. */
+    return (tail > head) ? static_cast<size_t>(tail - head)
+                         : 0;
+}
+
+/**
+ * @brief Checks if the ring is empty. Same caveat as Size().
+ *
+ * @return true if the ring has no elements, false otherwise.
+ */
+inline bool
+IsEmpty(
+    void
+) const noexcept(true)
+{
+    return 0 == this->Size();
+}
+
+/**
+ * @brief Gets the maximum number of elements.
+ *
+ * @return The capacity of the ring, or 0 if it has no region yet.
+ */
+inline size_t
+Capacity(
+    void
+) const noexcept(true)
+{
+    return (nullptr == this->m_Header) ? 0
+                                       : this->m_Mask + 1;
+}
+
+ private:
+/**
+ * @brief       Checks that a capacity is a non-zero power of two.
+ *
+ * @param[in]   Capacity - The capacity to be checked.
+ *
+ * @return true if the capacity can be used.
+ */
+static inline bool
+IsValidCapacity(
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    return (0 != Capacity) && (0 == (Capacity & (Capacity - 1)));
+}
+
+/**
+ * @brief       Checks that a region can hold a ring of the given capacity.
+ *
+ * @param[in]   Region            - The region to be checked.
+ * @param[in]   RegionSizeInBytes - The size of Region.
+ * @param[in]   Capacity          - The number of elements.
+ *
+ * @return true if the region is aligned and large enough, and the capacity is valid.
+ */
+static inline bool
+IsValidRegion(
+    _In_opt_ const void* Region,
+    _In_ size_t RegionSizeInBytes,
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    size_t sizeInBytes = 0;
+    if ((nullptr == Region) || !NT_SUCCESS(SpscRingBuffer::RegionSize(Capacity, &sizeInBytes)))
+    {
+        return false;
+    }
+    return xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Region),
+                                    size_t{ XPF_DEFAULT_ALIGNMENT }) &&
+           (RegionSizeInBytes >= sizeInBytes);
+}
+
+/**
+ * @brief       Starts using a laid out region. The cells follow the header.
+ *
+ * @param[in]   Header   - The start of the region.
+ * @param[in]   Capacity - The number of cells.
+ */
+inline void
+Use(
+    _In_ SpscRingBufferHeader* Header,
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    this->m_Header = Header;
+    this->m_Cells = reinterpret_cast<Type*>(reinterpret_cast<uint8_t*>(Header) + sizeof(SpscRingBufferHeader));
+    this->m_Mask = Capacity - 1;
+    this->m_OwnsRegion = false;
+}
+
+/**
+ * @brief       Copies elements into the ring, wrapping around the end of the cells.
+ *
+ * @param[in]   Cell   - The cell of the first element.
+ * @param[in]   Values - The elements to be copied.
+ * @param[in]   Count  - The number of elements. At most the capacity.
+ */
+inline void
+CopyIn(
+    _In_ size_t Cell,
+    _In_ const Type* Values,
+    _In_ size_t Count
+) noexcept(true)
+{
+    const size_t untilEnd = this->m_Mask + 1 - Cell;
+    const size_t first = (Count < untilEnd) ? Count
+                                            : untilEnd;
+
+    xpf::ApiCopyMemory(&this->m_Cells[Cell], Values, first * sizeof(Type));
+    if (first != Count)
+    {
+        xpf::ApiCopyMemory(&this->m_Cells[0], &Values[first], (Count - first) * sizeof(Type));
+    }
+}
+
+/**
+ * @brief       Copies elements out of the ring, wrapping around the end of the cells.
+ *
+ * @param[in]   Cell   - The cell of the first element.
+ * @param[out]  Values - Receives the elements.
+ * @param[in]   Count  - The number of elements. At most the capacity.
+ */
+inline void
+CopyOut(
+    _In_ size_t Cell,
+    _Out_ Type* Values,
+    _In_ size_t Count
+) const noexcept(true)
+{
+    const size_t untilEnd = this->m_Mask + 1 - Cell;
+    const size_t first = (Count < untilEnd) ? Count
+                                            : untilEnd;
+
+    xpf::ApiCopyMemory(Values, &this->m_Cells[Cell], first * sizeof(Type));
+    if (first != Count)
+    {
+        xpf::ApiCopyMemory(&Values[first], &this->m_Cells[0], (Count - first) * sizeof(Type));
+    }
+}
+
+   /**
+    * @brief The start of the region - the indices shared by the producer and the consumer.
+    *        Set once, before the ring is shared.
+    */
+    SpscRingBufferHeader* m_Header = nullptr;
+
+   /**
+    * @brief The cells - right after the header, as this object sees the region.
+    */
+    Type* m_Cells = nullptr;
+
+   /**
+    * @brief Capacity - 1, to turn a position into a cell.
+    */
+    size_t m_Mask = 0;
+
+   /**
+    * @brief true if the region was allocated by Allocate and must be freed.
+    */
+    bool m_OwnsRegion = false;
+
+   /**
+    * @brief The allocator used by Allocate.
+    */
+    xpf::PolymorphicAllocator m_Allocator;
+};  // class SpscRingBuffer
+};  // namespace xpf
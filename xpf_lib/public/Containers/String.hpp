@@ -546,7 +546,7 @@ static_assert(xpf::IsSameType<CharType, char>     ||
  *
  * @param[in]   Allocator - to be used when performing allocations.
  *
- * @note        For now only state-less allocators are supported.
+ * @note        Stateful allocators must outlive this object.
  */
 String(
     _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
@@ -875,6 +875,12 @@ ExtendWithBuffer(
     xpf::Buffer m_Buffer;
 };  // class String
 
+/**
+ * @brief The string holds no pointers to itself, so it can be relocated with a memory copy.
+ */
+template <class CharType>
+constexpr inline bool TriviallyRelocatableOptIn<xpf::String<CharType>> = true;
+
 //
 // ************************************************************************************************
 // This is the section containing string conversions API.
@@ -23,6 +23,7 @@
 #include "xpf_lib/public/core/TypeTraits.hpp"
 #include "xpf_lib/public/core/PlatformApi.hpp"
 
+#include "xpf_lib/public/Memory/CacheAligned.hpp"
 #include "xpf_lib/public/Locks/BusyLock.hpp"
 
 namespace xpf
@@ -57,8 +58,10 @@ struct TwoLockQueue final
     /**
      * @brief This lock is responsible for synchronizing Head access.
      *        We always pop at head. 
+     *        Producers and consumers take different locks, so the locks get
+     *        cache lines of their own - otherwise they would still contend on the line.
      */
-    xpf::BusyLock HeadLock;
+    xpf::CacheAligned<xpf::BusyLock> HeadLock;
     /**
      * @brief This points to the first element (the oldest) from queue.
      */
@@ -67,7 +70,7 @@ struct TwoLockQueue final
      * @brief This lock is responsible for synchronizing Tail access.
      *        We always insert at tail. 
      */
-    xpf::BusyLock TailLock;
+    xpf::CacheAligned<xpf::BusyLock> TailLock;
     /**
      * @brief This points to the last element (the newest) from queue.
      */
@@ -93,6 +96,30 @@ TlqPush(
     _Inout_ XPF_SINGLE_LIST_ENTRY* Element
 ) noexcept(true);
 
+/**
+ * @brief Inserts an already linked chain of elements in the given Two Lock Queue.
+ *        The chain will be inserted at the tail of the queue, preserving its order.
+ *        This takes the locks only once for the whole chain.
+ *
+ * @param[in,out] Queue - The queue where the elements should be inserted.
+ *
+ * @param[in,out] First - The first element of the chain.
+ *
+ * @param[in,out] Last - The last element of the chain. Must be reachable from First.
+ *                       Its Next field will be set to NULL.
+ *
+ * @return void.
+ *
+ * @note This function can not fail.
+ */
+void
+XPF_API
+TlqPushList(
+    _Inout_ TwoLockQueue& Queue,                                                // NOLINT(runtime/references)
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true);
+
 /**
  * @brief Removes an element in the given Two Lock Queue.
  *        The element will be removed from the head of the queue.
@@ -108,6 +135,30 @@ TlqPop(
     _Inout_ TwoLockQueue& Queue                                                 // NOLINT(runtime/references)
 ) noexcept(true);
 
+/**
+ * @brief Removes up to MaxElements elements from the head of the given Two Lock Queue.
+ *        This takes the locks only once for the whole chain.
+ *
+ * @param[in,out] Queue - The queue where we should pop from.
+ *
+ * @param[in] MaxElements - The maximum number of elements to be removed.
+ *
+ * @param[out] RemovedElements - The number of elements which were actually removed.
+ *
+ * @returns The first entry of a NULL-terminated chain containing the removed elements,
+ *          in queue order. NULL if the queue was empty.
+ *
+ * @note This might return fewer than MaxElements even if the queue holds more,
+ *       as it prefers to not acquire the tail lock when possible.
+ */
+XPF_SINGLE_LIST_ENTRY*
+XPF_API
+TlqPopList(
+    _Inout_ TwoLockQueue& Queue,                                                // NOLINT(runtime/references)
+    _In_ size_t MaxElements,
+    _Out_ size_t* RemovedElements
+) noexcept(true);
+
 /**
  * @brief Clears the list and returns a pointer to the first element.
  *        This will make both head and tail be NULL.
@@ -19,10 +19,13 @@
 #include "xpf_lib/public/core/TypeTraits.hpp"
 #include "xpf_lib/public/core/PlatformApi.hpp"
 #include "xpf_lib/public/core/Algorithm.hpp"
+#include "xpf_lib/public/core/Sort.hpp"
 
 #include "xpf_lib/public/Memory/MemoryAllocator.hpp"
 #include "xpf_lib/public/Memory/CompressedPair.hpp"
 
+#include "xpf_lib/public/Containers/Span.hpp"
+
 
 namespace xpf
 {
@@ -45,14 +48,13 @@ class Buffer final
  *
  * @param[in]   Allocator - to be used when performing allocations.
  *
- * @note        For now only state-less allocators are supported.
+ * @note        Stateful allocators must outlive this object.
  */
 Buffer(
     _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
 ) noexcept(true)
 {
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.AllocFunction);
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.FreeFunction);
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
 
     this->m_CompressedPair.First() = Allocator;
     this->m_CompressedPair.Second() = nullptr;
@@ -184,7 +186,7 @@ Clear(
 
     if (nullptr != buffer)
     {
-        allocator.FreeFunction(buffer);
+        allocator.FreeMemory(buffer);
         buffer = nullptr;
     }
 
@@ -295,18 +297,18 @@ Resize(
     //
     // The size is not zero, so we need a large-enough buffer to accomodate the elements.
     // We'll copy the rest of the elements in the newBuffer.
+    // Only the bytes which are not copied need to be zeroed.
     //
-    void* newBuffer = this->GetAllocator().AllocFunction(Size);
+    void* newBuffer = this->GetAllocator().AllocateMemory(Size);
     if (nullptr != newBuffer)
     {
-        xpf::ApiZeroMemory(newBuffer, Size);
+        const size_t copiedBytes = (this->m_Size < Size) ? this->m_Size : Size;
 
-        if (this->m_Size != 0)
-        {
-            xpf::ApiCopyMemory(newBuffer,
-                               this->GetBuffer(),
-                               (this->m_Size < Size) ? this->m_Size : Size);
-        }
+        xpf::ApiCopyMemory(newBuffer,
+                           this->GetBuffer(),
+                           copiedBytes);
+        xpf::ApiZeroMemory(static_cast<uint8_t*>(newBuffer) + copiedBytes,
+                           Size - copiedBytes);
     }
 
     if (this->m_Size < Size)
@@ -360,6 +362,13 @@ Resize(
     xpf::CompressedPair<xpf::PolymorphicAllocator, void*> m_CompressedPair;
     size_t m_Size = 0;
 };  // class Buffer
+
+/**
+ * @brief The buffer holds no pointers to itself, so it can be relocated with a memory copy.
+ */
+template <>
+constexpr inline bool TriviallyRelocatableOptIn<xpf::Buffer> = true;
+
 //
 // ************************************************************************************************
 // This is the section containing vector implementation.
@@ -379,7 +388,7 @@ class Vector final
  *
  * @param[in]   Allocator - to be used when performing allocations.
  *
- * @note        For now only state-less allocators are supported.
+ * @note        Stateful allocators must outlive this object.
  */
 Vector(
     _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
@@ -528,6 +537,19 @@ Size(
     return this->m_Size;
 }
 
+/**
+ * @brief Gets the number of elements the vector can hold without reallocating.
+ *
+ * @return The current capacity of the vector.
+ */
+inline size_t
+Capacity(
+    void
+) const noexcept(true)
+{
+    return this->m_Buffer.GetSize() / sizeof(Type);
+}
+
 /**
  * @brief Gets the underlying Allocator.
  *
@@ -604,41 +626,17 @@ Resize(
     }
 
     //
-    // Allocate a new buffer with the given size.
+    // Trivially relocatable elements are moved together with the bytes of the buffer.
+    // Buffer::Resize copies the old content to the new location, so we're done.
     //
-    Buffer tempBuffer{ this->m_Buffer.GetAllocator() };
-    const NTSTATUS status = tempBuffer.Resize(sizeInBytes);
-    if (!NT_SUCCESS(status))
+    if constexpr (xpf::IsTriviallyRelocatable<Type>())
     {
-        return status;
+        return this->m_Buffer.Resize(sizeInBytes);
     }
-
-    //
-    // Move-construct all elements to the new location.
-    //
-    Type* oldBuffer = static_cast<Type*>(this->m_Buffer.GetBuffer());
-    Type* newBuffer = static_cast<Type*>(tempBuffer.GetBuffer());
-
-    const size_t currentSize = this->m_Size;
-
-    for (size_t i = 0; i < currentSize; ++i)
+    else
     {
-        xpf::MemoryAllocator::Construct(&newBuffer[i],
-                                        xpf::Move(oldBuffer[i]));
+        return this->ResizeByMoving(sizeInBytes);
     }
-
-    //
-    // Clear previously allocated resources.
-    //
-    this->Clear();
-
-    //
-    // And now properly set the details.
-    //
-    this->m_Size = currentSize;
-    this->m_Buffer = xpf::Move(tempBuffer);
-
-    return STATUS_SUCCESS;
 }
 
 /**
@@ -659,7 +657,7 @@ Emplace(
     Arguments&& ...ConstructorArguments
 ) noexcept(true)
 {
-    const size_t capacity = this->m_Buffer.GetSize() / sizeof(Type);
+    const size_t capacity = this->Capacity();
 
     //
     // We need to grow.
@@ -718,7 +716,15 @@ Reserve(
 ) noexcept(true)
 {
     xpf::Vector<Type> clone(this->m_Buffer.GetAllocator());
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
+
+    //
+    // Allocate all slots at once, so the emplace calls below won't reallocate.
+    //
+    NTSTATUS status = clone.ReserveCapacity(N);
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
 
     for (size_t i = 0; i < N; ++i)
     {
@@ -733,6 +739,31 @@ Reserve(
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Ensures the vector can hold at least Capacity elements without reallocating.
+ *        The current elements are preserved. The capacity is never decreased.
+ *
+ * @param[in] Capacity - The minimum number of elements the vector should be able to hold.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ *       Erase() may give back the memory when the vector becomes mostly empty.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+ReserveCapacity(
+    _In_ size_t Capacity
+) noexcept(true)
+{
+    if (Capacity <= this->Capacity())
+    {
+        return STATUS_SUCCESS;
+    }
+    return this->Resize(Capacity);
+}
+
 /**
  * @brief Erases the element at the given position
  *
@@ -746,9 +777,146 @@ inline NTSTATUS
 Erase(
     _In_ size_t Position
 ) noexcept(true)
+{
+    return this->EraseRange(Position, 1);
+}
+
+/**
+ * @brief Erases Count consecutive elements starting at the given position.
+ *        The elements from the right are moved only once.
+ *
+ * @param[in] Position - the position of the first element to be erased.
+ *
+ * @param[in] Count - the number of elements to be erased.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+EraseRange(
+    _In_ size_t Position,
+    _In_ size_t Count
+) noexcept(true)
+{
+    Type* buffer = static_cast<Type*>(this->m_Buffer.GetBuffer());
+
+    //
+    // Sanity check. The second condition can't overflow as Position < m_Size.
+    //
+    if ((Position >= this->m_Size) || (Count > this->m_Size - Position))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (0 == Count)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    for (size_t i = Position; i < Position + Count; ++i)
+    {
+        xpf::MemoryAllocator::Destruct(&buffer[i]);
+    }
+
+    if constexpr (xpf::IsTriviallyRelocatable<Type>())
+    {
+        //
+        // Slide the elements from the right over the erased ones in one go.
+        // ApiCopyMemory handles the overlapping ranges.
+        //
+        xpf::ApiCopyMemory(&buffer[Position],
+                           &buffer[Position + Count],
+                           (this->m_Size - Position - Count) * sizeof(Type));
+    }
+    else
+    {
+        //
+        // We'll move all elements from the right to override the erased ones.
+        //
+        for (size_t i = Position + Count; i < this->m_Size; ++i)
+        {
+            xpf::MemoryAllocator::Construct(&buffer[i - Count],
+                                            xpf::Move(buffer[i]));
+            xpf::MemoryAllocator::Destruct(&buffer[i]);
+        }
+    }
+    this->m_Size -= Count;
+
+    this->ShrinkIfMostlyEmpty();
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Erases all elements for which the predicate returns true, in a single pass.
+ *        The remaining elements keep their relative order.
+ *
+ * @param[in] ErasePredicate - a lambda with the signature(const& Element) which returns
+ *                             true if the element should be erased.
+ *                             It is called exactly once for every element, in order.
+ *
+ * @return The number of erased elements.
+ */
+template <class Predicate>
+inline size_t
+EraseIf(
+    _In_ Predicate ErasePredicate
+) noexcept(true)
+{
+    Type* buffer = static_cast<Type*>(this->m_Buffer.GetBuffer());
+    size_t kept = 0;
+
+    for (size_t i = 0; i < this->m_Size; ++i)
+    {
+        if (ErasePredicate(static_cast<const Type&>(buffer[i])))
+        {
+            xpf::MemoryAllocator::Destruct(&buffer[i]);
+            continue;
+        }
+
+        //
+        // Compact the kept element over the erased ones - if there were any.
+        //
+        if (kept != i)
+        {
+            if constexpr (xpf::IsTriviallyRelocatable<Type>())
+            {
+                xpf::ApiCopyMemory(&buffer[kept],
+                                   &buffer[i],
+                                   sizeof(Type));
+            }
+            else
+            {
+                xpf::MemoryAllocator::Construct(&buffer[kept],
+                                                xpf::Move(buffer[i]));
+                xpf::MemoryAllocator::Destruct(&buffer[i]);
+            }
+        }
+        kept++;
+    }
+
+    const size_t erased = this->m_Size - kept;
+    this->m_Size = kept;
+
+    this->ShrinkIfMostlyEmpty();
+    return erased;
+}
+
+/**
+ * @brief Erases the element at the given position by moving the last element in its place.
+ *        The order of the elements is not preserved, but no other element is moved.
+ *
+ * @param[in] Position - the position where the element to be erased is.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+SwapRemove(
+    _In_ size_t Position
+) noexcept(true)
 {
     Type* buffer = static_cast<Type*>(this->m_Buffer.GetBuffer());
-    const size_t capacity = this->m_Buffer.GetSize() / sizeof(Type);
 
     //
     // Sanity check.
@@ -758,48 +926,160 @@ Erase(
         return STATUS_INVALID_PARAMETER;
     }
 
+    const size_t last = this->m_Size - 1;
+
+    xpf::MemoryAllocator::Destruct(&buffer[Position]);
+    if (Position != last)
+    {
+        if constexpr (xpf::IsTriviallyRelocatable<Type>())
+        {
+            xpf::ApiCopyMemory(&buffer[Position],
+                               &buffer[last],
+                               sizeof(Type));
+        }
+        else
+        {
+            xpf::MemoryAllocator::Construct(&buffer[Position],
+                                            xpf::Move(buffer[last]));
+            xpf::MemoryAllocator::Destruct(&buffer[last]);
+        }
+    }
+    this->m_Size--;
+
+    this->ShrinkIfMostlyEmpty();
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Copies the given elements at the back of the vector.
+ *
+ * @param[in] Elements - The elements to be copied. They must not belong to this vector.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+AppendRange(
+    _In_ _Const_ const xpf::Span<Type>& Elements
+) noexcept(true)
+{
+    return this->InsertRange(this->m_Size, Elements);
+}
+
+/**
+ * @brief Copies the given elements at the given position.
+ *        The vector grows at most once and the elements from the right are moved only once.
+ *
+ * @param[in] Position - Where to insert the elements. Can be Size() to append them.
+ *
+ * @param[in] Elements - The elements to be copied. They must not belong to this vector.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+InsertRange(
+    _In_ size_t Position,
+    _In_ _Const_ const xpf::Span<Type>& Elements
+) noexcept(true)
+{
+    const size_t count = Elements.Size();
+
     //
-    // We'll move all elements from the right to override this one.
+    // Sanity check.
     //
-    for (size_t i = Position + 1; i < this->m_Size; ++i)
+    if (Position > this->m_Size)
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+    if (0 == count)
     {
-        xpf::MemoryAllocator::Destruct(&buffer[i - 1]);
-        xpf::MemoryAllocator::Construct(&buffer[i - 1],
-                                        xpf::Move(buffer[i]));
+        return STATUS_SUCCESS;
     }
 
     //
-    // And now destroy the last element.
+    // The elements can't come from our own buffer - we might reallocate it.
     //
-    xpf::MemoryAllocator::Destruct(&buffer[this->m_Size - 1]);
-    this->m_Size--;
+    const Type* buffer = static_cast<const Type*>(this->m_Buffer.GetBuffer());
+    if ((nullptr != buffer) &&
+        (Elements.Buffer() + count > buffer) &&
+        (Elements.Buffer() < buffer + this->Capacity()))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // Grow once - to double the capacity, or to what is needed if that is not enough.
+    //
+    size_t requiredCapacity = 0;
+    if (!xpf::ApiNumbersSafeAdd(this->m_Size, count, &requiredCapacity))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+    if (requiredCapacity > this->Capacity())
+    {
+        size_t newCapacity = 0;
+        if (!xpf::ApiNumbersSafeMul(this->Capacity(), this->GROWTH_FACTOR, &newCapacity))
+        {
+            newCapacity = requiredCapacity;
+        }
+        if (newCapacity < requiredCapacity)
+        {
+            newCapacity = requiredCapacity;
+        }
+
+        const NTSTATUS status = this->Resize(newCapacity);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+
+    //
+    // Make room - move the elements from the right, starting with the last one.
+    //
+    Type* newBuffer = static_cast<Type*>(this->m_Buffer.GetBuffer());
+    if constexpr (xpf::IsTriviallyRelocatable<Type>())
+    {
+        xpf::ApiCopyMemory(&newBuffer[Position + count],
+                           &newBuffer[Position],
+                           (this->m_Size - Position) * sizeof(Type));
+    }
+    else
+    {
+        for (size_t i = this->m_Size; i > Position; --i)
+        {
+            xpf::MemoryAllocator::Construct(&newBuffer[i - 1 + count],
+                                            xpf::Move(newBuffer[i - 1]));
+            xpf::MemoryAllocator::Destruct(&newBuffer[i - 1]);
+        }
+    }
 
     //
-    // Maybe we can shrink. This is a best effort.
-    // If we can't we move on - not critical as the Resize has strong guarantees
-    // that the vector remains intact on fail.
+    // And now copy-construct the new elements in place.
     //
-    if ((capacity / this->SHRINK_FACTOR) > this->m_Size)
+    for (size_t i = 0; i < count; ++i)
     {
-        (void) this->Resize(capacity / this->SHRINK_FACTOR);
+        xpf::MemoryAllocator::Construct(&newBuffer[Position + i],
+                                        Elements[i]);
     }
+    this->m_Size += count;
 
     return STATUS_SUCCESS;
 }
 
 /**
- * @brief       Uses iterative heapsort to sort the elements with the provided SortingPredicate.
- *              The heapsort implementation here is considered an unstable sort.
- *              Unstable sorting algorithm can be defined as sorting algorithm in which the order of objects
- *              with the same values in the sorted array are not guaranteed to be the same as in the input array.
+ * @brief       Sorts the elements with the provided SortingPredicate.
+ *              See xpf::AlgoSort for details. This is an unstable sort.
  *
  * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
  *                                 true if left should appear before right in the sorted array.
- *
- * @note        Please see the following rerefence:
- *              " Knuth, Donald (1997). "ï¿½5.2.3, Sorting by Selection".
- *                The Art of Computer Programming. Vol. 3: Sorting and Searching (3rd ed.).
- *                Addison-Wesley. pp. 144ï¿½155. ISBN 978-0-201-89685-5. "
  */
 template <class Predicate>
 inline void
@@ -807,89 +1087,142 @@ Sort(
     _In_ Predicate SortingPredicate
 ) noexcept(true)
 {
-    //
-    // In a max-heap, the children of an element from index i are the ones from index
-    // (i*2) + 1 and (i*2) + 2 respectively. So the elements in the second half are leafs.
-    //
-    size_t start = this->Size() / 2;
-    size_t end = this->Size();
+    xpf::AlgoSort(static_cast<Type*>(this->m_Buffer.GetBuffer()),
+                  this->m_Size,
+                  SortingPredicate);
+}
 
+/**
+ * @brief       Sorts the elements with the provided SortingPredicate.
+ *              Equal elements keep their relative order. See xpf::AlgoStableSort for details.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ *
+ * @return      STATUS_INSUFFICIENT_RESOURCES if the scratch buffer could not be allocated -
+ *              the vector is left unchanged. STATUS_SUCCESS otherwise.
+ *
+ * @note        A scratch buffer of half the size of the vector is allocated using the vector's allocator.
+ */
+template <class Predicate>
+_Must_inspect_result_
+inline NTSTATUS
+StableSort(
+    _In_ Predicate SortingPredicate
+) noexcept(true)
+{
+    Type* elements = static_cast<Type*>(this->m_Buffer.GetBuffer());
 
-    /* Doxygen does not play nice with macros. */
-    #ifndef DOXYGEN_SHOULD_SKIP_THIS
-        #define XPF_VECTOR_SWAP_ELEMENTS_AT(idx1, idx2)     \
-        {                                                   \
-            Type& a = this->operator[](idx1);               \
-            Type& b = this->operator[](idx2);               \
-                                                            \
-            Type temp{ xpf::Move(a) };                      \
-            a = xpf::Move(b);                               \
-            b = xpf::Move(temp);                            \
-        }
-    #endif  // DOXYGEN_SHOULD_SKIP_THIS
+    if (this->m_Size <= xpf::XPF_STABLE_SORT_RUN_SIZE)
+    {
+        xpf::AlgoStableSort(elements, this->m_Size, static_cast<Type*>(nullptr), SortingPredicate);
+        return STATUS_SUCCESS;
+    }
+
+    size_t scratchSize = 0;
+    if (!xpf::ApiNumbersSafeMul(this->m_Size / 2, sizeof(Type), &scratchSize))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+
+    Buffer scratch{ this->m_Buffer.GetAllocator() };
+    const NTSTATUS status = scratch.Resize(scratchSize);
+    if (!NT_SUCCESS(status))
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    xpf::AlgoStableSort(elements,
+                        this->m_Size,
+                        static_cast<Type*>(scratch.GetBuffer()),
+                        SortingPredicate);
+    return STATUS_SUCCESS;
+}
+
+ private:
+/**
+ * @brief Gives back memory when the vector is mostly empty. This is a best effort.
+ *        If we can't we move on - not critical as the Resize has strong guarantees
+ *        that the vector remains intact on fail.
+ *
+ *        We shrink only when less than a quarter of the capacity is used, and then by halves.
+ *        This leaves room to grow and to erase before the next reallocation,
+ *        so alternating Emplace and Erase around a boundary won't thrash the buffer.
+ *        The halves are computed upfront, so there is at most one reallocation.
+ */
+inline void
+ShrinkIfMostlyEmpty(
+    void
+) noexcept(true)
+{
+    const size_t capacity = this->Capacity();
+    size_t newCapacity = capacity;
 
+    while ((newCapacity > this->MINIMUM_SHRINK_CAPACITY) &&
+           ((newCapacity / this->SHRINK_FACTOR) > this->m_Size))
+    {
+        newCapacity = newCapacity / this->GROWTH_FACTOR;
+    }
+
+    if (newCapacity != capacity)
+    {
+        (void) this->Resize(newCapacity);
+    }
+}
+
+/**
+ * @brief Moves the elements one by one into a new buffer of the given size.
+ *        Used for the types which can't be relocated with a memory copy.
+ *
+ * @param[in] SizeInBytes - The size of the new buffer. It can hold all current elements.
+ *
+ * @return STATUS_SUCCESS if everything went well,
+ *         a proper NTSTATUS error code if not.
+ *
+ * @note If the operation fails, the vector remains intact.
+ */
+_Must_inspect_result_
+inline NTSTATUS
+ResizeByMoving(
+    _In_ size_t SizeInBytes
+) noexcept(true)
+{
     //
-    // The heapsort has two steps:
-    //      1. Construction of the max heap - we need to re-arange the elements
-    //         so that they have the max heap property.
-    //      2. The actual sorting which basically means moving the root (element 0)
-    //         to the end, and then restoring the max heap property.
+    // Allocate a new buffer with the given size.
     //
-    while (end > 1)
+    Buffer tempBuffer{ this->m_Buffer.GetAllocator() };
+    const NTSTATUS status = tempBuffer.Resize(SizeInBytes);
+    if (!NT_SUCCESS(status))
     {
-        if (start > 0)
-        {
-            //
-            // We are constructing the max heap. This will decrease until it is 0.
-            // Only after then the sorting begins.
-            //
-            start = start - 1;
-        }
-        else
-        {
-            //
-            // We're in sorting phase. Decrease the end and move the root to the last.
-            //
-            end = end - 1;
-            XPF_VECTOR_SWAP_ELEMENTS_AT(0, end);
-        }
+        return status;
+    }
 
-        //
-        // Restore the max-heap property.
-        //
-        size_t root = start;
-        while (2 * root < end - 1)            /* While the root has at least one child */
-        {
-            size_t child = 2 * root + 1;      /* Left child of root. */
+    //
+    // Move-construct all elements to the new location.
+    //
+    Type* oldBuffer = static_cast<Type*>(this->m_Buffer.GetBuffer());
+    Type* newBuffer = static_cast<Type*>(tempBuffer.GetBuffer());
 
-            if (child < end - 1)              /* Check if there is a right child. */
-            {
-                /* Check if the right child is bigger than left. We need the bigger child, always. */
-                const bool isLeftSmaller = SortingPredicate(this->operator[](child),
-                                                            this->operator[](child+1));
-                if (isLeftSmaller)
-                {
-                    child = child + 1;
-                }
-            }
+    const size_t currentSize = this->m_Size;
 
-            /* Now check if root is smaller. */
-            const bool isRootSmaller = SortingPredicate(this->operator[](root),
-                                                        this->operator[](child));
-            if (isRootSmaller)
-            {
-                /* Swap root and child and continue swapping the child down the heap. */
-                XPF_VECTOR_SWAP_ELEMENTS_AT(root, child);
-                root = child;
-            }
-            else
-            {
-                break;
-            }
-        }
+    for (size_t i = 0; i < currentSize; ++i)
+    {
+        xpf::MemoryAllocator::Construct(&newBuffer[i],
+                                        xpf::Move(oldBuffer[i]));
     }
 
-    #undef XPF_VECTOR_SWAP_ELEMENTS_AT
+    //
+    // Clear previously allocated resources.
+    //
+    this->Clear();
+
+    //
+    // And now properly set the details.
+    //
+    this->m_Size = currentSize;
+    this->m_Buffer = xpf::Move(tempBuffer);
+
+    return STATUS_SUCCESS;
 }
 
  private:
@@ -899,11 +1232,22 @@ Sort(
     static constexpr size_t GROWTH_FACTOR = 2;
 
     /**
-    * @brief Every time we need to shrink, we'll check with a factor of four.
+    * @brief We shrink only when less than a quarter of the capacity is used.
     */
     static constexpr size_t SHRINK_FACTOR = 4;
 
+    /**
+     * @brief Small buffers are never shrunk - it is not worth the reallocation.
+     */
+    static constexpr size_t MINIMUM_SHRINK_CAPACITY = 16;
+
     xpf::Buffer m_Buffer;
     size_t m_Size = 0;
 };  // class Vector
+
+/**
+ * @brief The vector holds no pointers to itself, so it can be relocated with a memory copy.
+ */
+template <class Type>
+constexpr inline bool TriviallyRelocatableOptIn<xpf::Vector<Type>> = true;
 };  // namespace xpf
@@ -21,6 +21,7 @@
 
 
 #include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
 #include "xpf_lib/public/Locks/Lock.hpp"
 
 
@@ -122,8 +123,8 @@ UnLockShared(
 
  private:
     //
-    // Because we are using atomic intrinsics, this value need to be properly aligned.
+    // The upper bit marks the writer, the other 15 bits count the readers.
     //
-    alignas(uint16_t) volatile uint16_t m_Lock = 0;
+    xpf::Atomic<uint16_t> m_Lock;
 };  // class BusyLock
 };  // namespace xpf
@@ -0,0 +1,241 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/AtomicSharedPointer.hpp
+ *
+ * @brief       This is a shared pointer which can be loaded and stored concurrently.
+ *              It is meant for publishing immutable snapshots (copy-on-write).
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
+
+#include "xpf_lib/public/Memory/SharedPointer.hpp"
+#include "xpf_lib/public/Locks/BusyLock.hpp"
+
+
+namespace xpf
+{
+/**
+ * @brief This is a shared pointer which can be used by multiple threads at once.
+ *        Load() takes no lock - it grabs a reference to the current value,
+ *        which stays valid for as long as the caller keeps it, even if the value is replaced.
+ *
+ *        The value lives in one of two slots. Readers announce themselves in the counter
+ *        of the current slot. A writer fills the other slot, flips the current one,
+ *        and then waits for the readers of the old slot to leave before dropping its reference.
+ *        This is the two-phase deferred reclamation used by RCU, so readers never see
+ *        a value whose reference counter can reach 0 while they are copying it.
+ *
+ * @note  Writers are serialized between themselves and wait for the in-flight readers.
+ *        So this is a good fit when reads vastly outnumber writes.
+ */
+template <class Type>
+class AtomicSharedPointer final
+{
+ public:
+/**
+ * @brief AtomicSharedPointer constructor - default. It holds no value.
+ */
+AtomicSharedPointer(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Constructs the atomic shared pointer holding a reference to Value.
+ *
+ * @param[in] Value - The initial value.
+ */
+AtomicSharedPointer(
+    _In_ _Const_ const xpf::SharedPointer<Type>& Value
+) noexcept(true)
+{
+    this->m_Slots[0] = Value;
+}
+
+/**
+ * @brief Destructor. It drops the reference to the current value.
+ *        There must be no concurrent access when the object is destroyed.
+ */
+~AtomicSharedPointer(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy and move semantics are deleted.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(AtomicSharedPointer, delete);
+
+/**
+ * @brief Grabs a reference to the current value. Does not take any lock.
+ *
+ * @return A shared pointer to the current value - might be empty.
+ */
+inline xpf::SharedPointer<Type>
+Load(
+    void
+) const noexcept(true)
+{
+    xpf::SharedPointer<Type> snapshot;
+
+    while (true)
+    {
+        //
+        // Announce ourselves in the current slot. If the writer flipped the slot
+        // in the meantime, it might not wait for us - so try again.
+        //
+        // The increment and the re-check are sequentially consistent, as are the flip and
+        // the poll in Publish(). Either the writer sees our increment, or we see the flip.
+        // Weaker orders allow both sides to miss each other (a store followed by a load).
+        //
+        const uint32_t slot = this->m_CurrentSlot.Load();
+        (void) this->m_Readers[slot].FetchAdd(1);
+
+        if (slot == this->m_CurrentSlot.Load())
+        {
+            snapshot = this->m_Slots[slot];
+            (void) this->m_Readers[slot].FetchSub(1, xpf::MemoryOrder::Release);
+            break;
+        }
+        (void) this->m_Readers[slot].FetchSub(1, xpf::MemoryOrder::Release);
+    }
+    return snapshot;
+}
+
+/**
+ * @brief Replaces the current value.
+ *
+ * @param[in] Desired - The new value. Can be empty.
+ */
+inline void
+Store(
+    _In_ _Const_ const xpf::SharedPointer<Type>& Desired
+) noexcept(true)
+{
+    //
+    // The previous value is released after the lock.
+    //
+    xpf::SharedPointer<Type> previous = this->Exchange(Desired);
+}
+
+/**
+ * @brief Replaces the current value and returns the previous one.
+ *
+ * @param[in] Desired - The new value. Can be empty.
+ *
+ * @return The previous value.
+ */
+inline xpf::SharedPointer<Type>
+Exchange(
+    _In_ _Const_ const xpf::SharedPointer<Type>& Desired
+) noexcept(true)
+{
+    xpf::SharedPointer<Type> previous;
+    {
+        xpf::ExclusiveLockGuard guard{ this->m_WritersLock };
+        this->Publish(Desired, previous);
+    }
+    return previous;
+}
+
+/**
+ * @brief Replaces the current value only if it is the same as Expected.
+ *        The values are compared by the object they point to.
+ *
+ * @param[in,out] Expected - The value the caller expects to be current.
+ *                           On failure it is updated with the current value.
+ *
+ * @param[in] Desired - The new value. Can be empty.
+ *
+ * @return true if the value was replaced, false otherwise.
+ */
+inline bool
+CompareExchange(
+    _Inout_ xpf::SharedPointer<Type>& Expected,
+    _In_ _Const_ const xpf::SharedPointer<Type>& Desired
+) noexcept(true)
+{
+    xpf::SharedPointer<Type> previous;
+    {
+        xpf::ExclusiveLockGuard guard{ this->m_WritersLock };
+
+        xpf::SharedPointer<Type>& current = this->m_Slots[this->m_CurrentSlot.Load(xpf::MemoryOrder::Relaxed)];
+        if (current.GetMemoryBlock().ReferenceCounter != Expected.GetMemoryBlock().ReferenceCounter)
+        {
+            Expected = current;
+            return false;
+        }
+        this->Publish(Desired, previous);
+    }
+    return true;
+}
+
+ private:
+/**
+ * @brief Makes Desired the current value. Must be called with the writers lock taken.
+ *
+ * @param[in] Desired - The new value.
+ *
+ * @param[out] Previous - Receives the previous value.
+ */
+inline void
+Publish(
+    _In_ _Const_ const xpf::SharedPointer<Type>& Desired,
+    _Out_ xpf::SharedPointer<Type>& Previous
+) noexcept(true)
+{
+    const uint32_t currentSlot = this->m_CurrentSlot.Load(xpf::MemoryOrder::Relaxed);
+    const uint32_t nextSlot = currentSlot ^ 1;
+
+    //
+    // Nobody reads the next slot - its readers were waited for by the previous writer.
+    // The exchange below is sequentially consistent, so the value is visible before the flip.
+    //
+    this->m_Slots[nextSlot] = Desired;
+    const uint32_t flippedSlot = this->m_CurrentSlot.Exchange(nextSlot);
+    XPF_DEATH_ON_FAILURE(flippedSlot == currentSlot);
+
+    //
+    // New readers go to the next slot. Wait for the ones still copying the old value.
+    // The poll must be sequentially consistent - it can't be ordered before the flip.
+    //
+    while (0 != this->m_Readers[currentSlot].Load())
+    {
+        xpf::ApiYieldProcesor();
+    }
+    Previous = xpf::Move(this->m_Slots[currentSlot]);
+}
+
+ private:
+    /**
+     * @brief   The two slots. Only m_Slots[m_CurrentSlot] is visible to readers.
+     */
+    xpf::SharedPointer<Type> m_Slots[2];
+
+    /**
+     * @brief   The number of readers currently copying each slot.
+     */
+    mutable xpf::Atomic<uint32_t> m_Readers[2];
+
+    /**
+     * @brief   The index of the slot which holds the current value.
+     */
+    xpf::Atomic<uint32_t> m_CurrentSlot;
+
+    /**
+     * @brief   Serializes the writers.
+     */
+    xpf::BusyLock m_WritersLock;
+};  // class AtomicSharedPointer
+};  // namespace xpf
@@ -0,0 +1,139 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/CacheAligned.hpp
+ *
+ * @brief       Padding wrapper which keeps an object on cache lines of its own.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief This wraps an object which is written a lot by different processors
+ *        (a lock, a counter), so that no other data shares its cache lines.
+ *
+ *        The containers can't allocate types aligned above XPF_DEFAULT_ALIGNMENT,
+ *        so instead of alignas(XPF_CACHE_LINE_SIZE) this uses padding: there are enough
+ *        bytes before and after the object so that, for any XPF_DEFAULT_ALIGNMENT aligned
+ *        address of the wrapper, the lines touched by the object are not touched by neighbours.
+ *        This costs about two cache lines worth of memory, so use it only for hot data.
+ */
+template <class Type>
+class CacheAligned final
+{
+ public:
+/**
+ * @brief Constructs the wrapped object.
+ *
+ * @param[in] ConstructorArguments - To be forwarded to the wrapped object constructor.
+ */
+template <typename... Arguments>
+CacheAligned(
+    Arguments&& ...ConstructorArguments
+) noexcept(true) : m_Value(xpf::Forward<Arguments>(ConstructorArguments)...)
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Default destructor.
+ */
+~CacheAligned(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy and move semantics are deleted.
+ *        The wrapped objects are usually locks or atomics.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(CacheAligned, delete);
+
+/**
+ * @brief Retrieves the wrapped object.
+ *
+ * @return A reference to the wrapped object.
+ */
+inline Type&
+Get(
+    void
+) noexcept(true)
+{
+    return this->m_Value;
+}
+
+/**
+ * @brief Retrieves the wrapped object.
+ *
+ * @return A const reference to the wrapped object.
+ */
+inline const Type&
+Get(
+    void
+) const noexcept(true)
+{
+    return this->m_Value;
+}
+
+/**
+ * @brief Allows the wrapper to be used where the wrapped object is expected.
+ *
+ * @return A reference to the wrapped object.
+ */
+inline operator Type&(
+    void
+) noexcept(true)
+{
+    return this->m_Value;
+}
+
+/**
+ * @brief Allows the wrapper to be used where the wrapped object is expected.
+ *
+ * @return A const reference to the wrapped object.
+ */
+inline operator const Type&(
+    void
+) const noexcept(true)
+{
+    return this->m_Value;
+}
+
+/**
+ * @brief Accesses the members of the wrapped object.
+ *
+ * @return A pointer to the wrapped object.
+ */
+inline Type*
+operator->(
+    void
+) noexcept(true)
+{
+    return &this->m_Value;
+}
+
+ private:
+    /**
+     * @brief   The wrapper is at least XPF_DEFAULT_ALIGNMENT aligned, so the cache line of the
+     *          first byte of the object starts at most this many bytes before it.
+     */
+    static constexpr size_t CACHE_ALIGNED_PADDING = XPF_CACHE_LINE_SIZE - XPF_DEFAULT_ALIGNMENT;
+
+    uint8_t m_LeadingPadding[CACHE_ALIGNED_PADDING] = { 0 };
+    alignas(XPF_DEFAULT_ALIGNMENT) Type m_Value;
+    uint8_t m_TrailingPadding[CACHE_ALIGNED_PADDING] = { 0 };
+};  // class CacheAligned
+};  // namespace xpf
@@ -0,0 +1,150 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/CacheRegistry.hpp
+ *
+ * @brief       Module-wide registry of the allocators which cache memory,
+ *              so the cached memory can be reclaimed under memory pressure.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief   How much of the cached memory should be given back to the system.
+ */
+enum class CacheTrimLevel : uint32_t
+{
+    /**
+     * @brief   Only the memory which was not needed since the previous trim.
+     *          Call this periodically - the period defines what "idle" means.
+     */
+    Idle = 0,
+
+    /**
+     * @brief   All cached memory which is not in use.
+     */
+    Full = 1,
+};  // enum class CacheTrimLevel
+
+/**
+ * @brief   Gives the cached memory of an allocator back to the system.
+ *          The first parameter is the allocator context.
+ *          Returns the number of bytes given back.
+ */
+using FnCacheTrim = size_t (*)(_In_ void* Context, _In_ xpf::CacheTrimLevel Level) noexcept(true);
+
+/**
+ * @brief   Retrieves how many bytes an allocator currently caches.
+ *          The first parameter is the allocator context.
+ */
+using FnCacheSize = size_t (*)(_In_ void* Context) noexcept(true);
+
+/**
+ * @brief   A caching allocator embeds one of these and registers it with ApiRegisterCache().
+ *          The registry is an intrusive list, so registering can't fail.
+ */
+struct CacheRegistryEntry
+{
+    /**
+     * @brief   The previous entry in the registry. Owned by the registry.
+     */
+    CacheRegistryEntry* Previous = nullptr;
+
+    /**
+     * @brief   The next entry in the registry. Owned by the registry.
+     */
+    CacheRegistryEntry* Next = nullptr;
+
+    /**
+     * @brief   Given to the functions below - usually the allocator.
+     */
+    void* Context = nullptr;
+
+    /**
+     * @brief   Called by ApiTrimCaches().
+     */
+    FnCacheTrim TrimFunction = nullptr;
+
+    /**
+     * @brief   Called by ApiCachedBytes().
+     */
+    FnCacheSize SizeFunction = nullptr;
+
+    /**
+     * @brief   True while the entry is in the registry. Owned by the registry.
+     */
+    bool IsRegistered = false;
+};  // struct CacheRegistryEntry
+
+/**
+ * @brief Adds an entry to the registry. The Context, TrimFunction and SizeFunction must be set.
+ *
+ * @param[in,out] Entry - To be registered. Must stay valid until ApiUnregisterCache() is called.
+ *
+ * @return Nothing.
+ *
+ * @note Register when the allocator is fully constructed - it can be trimmed right away.
+ */
+void
+XPF_API
+ApiRegisterCache(
+    _Inout_ xpf::CacheRegistryEntry* Entry
+) noexcept(true);
+
+/**
+ * @brief Removes an entry from the registry. Waits for any trim in progress.
+ *        It is fine to call this for an entry which is not registered - it returns
+ *        right away, without taking the registry lock.
+ *
+ * @param[in,out] Entry - To be unregistered.
+ *
+ * @return Nothing.
+ *
+ * @note Unregister before tearing down the allocator.
+ *       Must not be called from a trim or size function.
+ */
+void
+XPF_API
+ApiUnregisterCache(
+    _Inout_ xpf::CacheRegistryEntry* Entry
+) noexcept(true);
+
+/**
+ * @brief Walks all registered allocators and gives their cached memory back to the system.
+ *
+ * @param[in] Level - How much to give back.
+ *
+ * @return The number of bytes given back to the system.
+ */
+size_t
+XPF_API
+ApiTrimCaches(
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true);
+
+/**
+ * @brief Retrieves how many bytes are cached by all registered allocators.
+ *
+ * @return The number of cached bytes. Best effort - the caches can change right after.
+ */
+size_t
+XPF_API
+ApiCachedBytes(
+    void
+) noexcept(true);
+};  // namespace xpf
@@ -0,0 +1,166 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/LargeBlockAllocator.hpp
+ *
+ * @brief       Allocator which backs big blocks directly with pages from the system
+ *              (anonymous mmap and transparent huge pages on linux).
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+
+
+/**
+ * @brief   A polymorphic allocator which sends blocks of at least 2 MB directly to the system pages.
+ *          Useful for big, transient buffers (defragmented streams, serialization blobs, and so on).
+ */
+#define XPF_LARGE_BLOCK_ALLOCATOR   xpf::LargeBlockAllocator<>::GetAllocator()
+
+
+namespace xpf
+{
+
+/**
+ * @brief Maps whole pages for a big block, backed by huge pages where possible.
+ *        The mapped size is kept in a module-wide side table, so the block needs no header -
+ *        a power-of-two request maps exactly that many pages.
+ *
+ * @param[in] BlockSize - The requsted block size. It is rounded up to the page size.
+ *
+ * @return A zeroed, page aligned block of memory, or null on failure.
+ *         It must be freed with ApiFreeLargeBlock.
+ */
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+ApiAllocateLargeBlock(
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Frees a block allocated with ApiAllocateLargeBlock.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return true if the block was found in the side table and freed,
+ *         false if it was not allocated with ApiAllocateLargeBlock - it is left untouched.
+ */
+_Check_return_
+bool
+XPF_API
+ApiFreeLargeBlock(
+    _Inout_opt_ void* MemoryBlock
+) noexcept(true);
+
+/**
+ * @brief This is a memory allocator for big blocks.
+ *        Blocks of at least Threshold bytes are allocated as whole pages directly from the system,
+ *        and backed by huge pages where possible. This cuts the TLB misses when the big
+ *        blocks are scanned, doesn't fragment the heap, and the pages are given back as soon
+ *        as the block is freed. Smaller blocks go to the default allocator.
+ *
+ * @note  The blocks carry no header. The big ones are page aligned and their size is kept
+ *        in a side table (see ApiAllocateLargeBlock), so only page aligned blocks are looked up on free.
+ */
+template <size_t Threshold = size_t{ 2 } * 1024 * 1024>
+class LargeBlockAllocator
+{
+ public:
+/**
+ * @brief Default constructor.
+ */
+LargeBlockAllocator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Default destructor.
+ */
+~LargeBlockAllocator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be moved and copied.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(LargeBlockAllocator, default);
+
+/**
+ * @brief Allocates a block of memory with the required size.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A zeroed block of memory with the required size, or null on failure.
+ *         The block is aligned to XPF_DEFAULT_ALIGNMENT.
+ */
+_Check_return_
+_Ret_maybenull_
+static inline void*
+AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    return (BlockSize >= Threshold) ? xpf::ApiAllocateLargeBlock(BlockSize)
+                                    : xpf::ApiAllocateMemory(BlockSize, false);
+}
+
+/**
+ * @brief Frees a block of memory.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ */
+static inline void
+FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    if (nullptr == MemoryBlock)
+    {
+        return;
+    }
+
+    //
+    // The big blocks are always page aligned. A small block can be as well, by chance -
+    // then the side table lookup just misses.
+    //
+    const bool isPageAligned = xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(MemoryBlock),
+                                                        decltype(xpf::AlgoPointerToValue(MemoryBlock)){ 4096 });
+    if (isPageAligned && xpf::ApiFreeLargeBlock(MemoryBlock))
+    {
+        return;
+    }
+    xpf::ApiFreeMemory(MemoryBlock);
+}
+
+/**
+ * @brief Retrieves a polymorphic allocator which uses this allocator.
+ *
+ * @return A stateless polymorphic allocator.
+ */
+static inline xpf::PolymorphicAllocator
+GetAllocator(
+    void
+) noexcept(true)
+{
+    return xpf::PolymorphicAllocator{ .AllocFunction = &LargeBlockAllocator::AllocateMemory,
+                                      .FreeFunction  = &LargeBlockAllocator::FreeMemory };
+}
+};  // class LargeBlockAllocator
+};  // namespace xpf
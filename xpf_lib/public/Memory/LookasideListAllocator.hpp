@@ -25,14 +25,52 @@
 
 #include "xpf_lib/public/Memory/MemoryAllocator.hpp"
 #include "xpf_lib/public/Memory/Optional.hpp"
+#include "xpf_lib/public/Memory/CacheRegistry.hpp"
 
 #include "xpf_lib/public/Locks/BusyLock.hpp"
 #include "xpf_lib/public/Containers/TwoLockQueue.hpp"
+#include "xpf_lib/public/Containers/LockFreeStack.hpp"
 
 
 namespace xpf
 {
 
+/**
+ * @brief A snapshot of the lookaside list statistics.
+ *        The counters are best effort - they may be slightly off while the allocator is in use.
+ */
+struct LookasideListStatistics
+{
+    /**
+     * @brief The number of allocations served from the cache.
+     */
+    uint64_t Hits = 0;
+
+    /**
+     * @brief The number of allocations which had to go to the system allocator.
+     */
+    uint64_t Misses = 0;
+
+    /**
+     * @brief The number of blocks given back to the system by Trim().
+     */
+    uint64_t TrimmedBlocks = 0;
+
+    /**
+     * @brief The number of blocks currently cached - shared store and per-cpu magazines.
+     */
+    size_t CurrentDepth = 0;
+
+    /**
+     * @brief The highest number of blocks ever cached in the shared store.
+     */
+    size_t HighWaterDepth = 0;
+
+    /**
+     * @brief The maximum number of blocks that can be cached in the shared store.
+     */
+    size_t MaxDepth = 0;
+};  // struct LookasideListStatistics
 
 /**
  * @brief This is a memory allocator which allocates memory and keeps it inside a list.
@@ -42,6 +80,22 @@ namespace xpf
  *        The two-lock queue is a Live-lock free structure presented in  "Simple, Fast, and Practical
  *        Non-Blocking and Blocking Concurrent Queue Algorithms" by Maged M. Michael and Michael L. Scott.
  *        (http://www.cs.rochester.edu/research/synchronization/pseudocode/queues.html)
+ *
+ *        Optionally, a per-processor cache (magazine) can be placed in front of the shared queue.
+ *        Most allocations and frees are then served from the magazine of the current processor,
+ *        and the shared queue is touched only in batches - when a magazine is empty or full.
+ *
+ *        Instead of the two-lock queue, a lock-free stack can be used as the shared store.
+ *        This also returns the most recently freed (and likely cache-hot) blocks first.
+ *
+ *        The cache depth adapts to the demand: Trim() gives back to the system the blocks
+ *        which were not needed since the previous Trim() - the low-water mark of each list.
+ *        So a burst doesn't pin its memory forever.
+ *
+ *        An instance can join the module-wide cache registry (see JoinCacheRegistry), so ApiTrimCaches()
+ *        can reclaim the cached blocks of all long-lived lookaside lists at once. This is opt-in,
+ *        so short-lived allocators don't take the registry lock when they are created and destroyed.
+ *        ObjectPool forwards it, and the ThreadPool joins its work item pool this way.
  */
 class LookasideListAllocator final
 {
@@ -54,10 +108,20 @@ class LookasideListAllocator final
  *
  * @param[in] IsCriticalAllocator - If true, it will allocate using the Critical default allocator,
  *                                  if false, it will allocate using the Memory default allocator.
+ *
+ * @param[in] UsePerCpuCache - If true, a per-processor magazine is used in front of the shared queue.
+ *                             This trades a bit of memory for less contention on hot allocators.
+ *
+ * @param[in] UseLockFreeStack - If true, the shared store is a lock-free stack instead of the two-lock queue.
+ *                               See the notes on xpf::LockFreeStack - a block might still be read
+ *                               by a concurrent Pop, so the blocks given back to the system are
+ *                               retired first, and freed once the stack says no Pop can read them.
  */
 LookasideListAllocator(
     _In_ size_t ElementSize,
-    _In_ bool IsCriticalAllocator
+    _In_ bool IsCriticalAllocator,
+    _In_ bool UsePerCpuCache = false,
+    _In_ bool UseLockFreeStack = false
 ) noexcept(true)
 {
     //
@@ -66,17 +130,52 @@ LookasideListAllocator(
     this->m_ElementSize = (ElementSize < sizeof(XPF_SINGLE_LIST_ENTRY)) ? sizeof(XPF_SINGLE_LIST_ENTRY)
                                                                         : ElementSize;
     this->m_IsCriticalAllocator = IsCriticalAllocator;
+    this->m_UseLockFreeStack = UseLockFreeStack;
 
     //
     // Now let's see how many elements we can store. Compute this based on element size.
     // We don't want to exceed approximatively 50 mb in one allocator.
     // If the allocation is somehow bigger than this limit, we'll store 20 elements in our lookaside list.
-    // These numbers can be changed if we notice we have a problem.
+    // These numbers can be changed if we notice we have a problem - or via SetMaxDepth().
     //
     const size_t maxElements = size_t{ 1048576 * 50 } / this->m_ElementSize;
-    this->m_MaxElements = (maxElements < 20) ? 20
-                                             : maxElements;
+    this->m_MaxElements.Store((maxElements < 20) ? 20
+                                                 : maxElements,
+                              xpf::MemoryOrder::Relaxed);
     this->m_CurrentElements = 0;
+
+    //
+    // The magazines are allowed to keep at most half of the elements we can cache.
+    // The rest remain for the shared queue. If a magazine can't hold at least
+    // a couple of elements, there is no point in having per-cpu caches.
+    //
+    if (UsePerCpuCache)
+    {
+        uint32_t numberOfMagazines = xpf::ApiNumberOfProcessors();
+        if (numberOfMagazines > LOOKASIDE_MAX_MAGAZINES)
+        {
+            numberOfMagazines = LOOKASIDE_MAX_MAGAZINES;
+        }
+
+        size_t magazineCapacity = (this->m_MaxElements.Load(xpf::MemoryOrder::Relaxed) / 2) / numberOfMagazines;
+        if (magazineCapacity > LOOKASIDE_MAGAZINE_CAPACITY)
+        {
+            magazineCapacity = LOOKASIDE_MAGAZINE_CAPACITY;
+        }
+
+        if (magazineCapacity >= 2)
+        {
+            this->m_NumberOfMagazines = numberOfMagazines;
+            this->m_MagazineCapacity.Store(magazineCapacity, xpf::MemoryOrder::Relaxed);
+        }
+    }
+
+    //
+    // The registry entry is prepared here, but only linked by JoinCacheRegistry().
+    //
+    this->m_CacheEntry.Context = this;
+    this->m_CacheEntry.TrimFunction = &LookasideListAllocator::CacheTrimCallback;
+    this->m_CacheEntry.SizeFunction = &LookasideListAllocator::CacheSizeCallback;
 }
 
 /**
@@ -166,7 +265,119 @@ FreeMemory(
     _Inout_ void* MemoryBlock
 ) noexcept(true);
 
+/**
+ * @brief Changes the maximum number of blocks cached in the shared store.
+ *        The per-cpu magazines are resized accordingly, but each keeps at least 2 blocks.
+ *
+ * @param[in] MaxDepth - The new maximum depth. 0 means nothing is cached in the shared store.
+ *
+ * @return None.
+ *
+ * @note Blocks already cached above the new depth are given back on the next Trim().
+ */
+void
+XPF_API
+SetMaxDepth(
+    _In_ size_t MaxDepth
+) noexcept(true);
+
+/**
+ * @brief Controls whether the blocks reused from the cache are zeroed.
+ *        The default is true. Callers which fully initialize the block can opt out.
+ *        Blocks coming from the system allocator are always zeroed.
+ *
+ * @param[in] ZeroOnReuse - If false, reused blocks are returned as they were freed.
+ *
+ * @return None.
+ */
+inline void
+SetZeroOnReuse(
+    _In_ bool ZeroOnReuse
+) noexcept(true)
+{
+    this->m_ZeroOnReuse = ZeroOnReuse;
+}
+
+/**
+ * @brief Adds this allocator to the module-wide cache registry, so ApiTrimCaches() and
+ *        the CacheTrimmer reclaim its cached blocks as well. The allocator leaves the registry
+ *        when it is destroyed. Calling this more than once has no effect.
+ *
+ * @return None.
+ *
+ * @note Meant for long-lived allocators - joining and leaving take the registry lock exclusively.
+ */
+inline void
+JoinCacheRegistry(
+    void
+) noexcept(true)
+{
+    xpf::ApiRegisterCache(&this->m_CacheEntry);
+}
+
+/**
+ * @brief Gives back to the system the blocks which were not needed since the previous call.
+ *        For each list (shared store and magazines) we track the lowest depth it had -
+ *        these many blocks stayed idle for the whole interval, so they are released.
+ *        Meant to be called periodically, and safe to call while other threads allocate and free.
+ *        With the lock-free stack, the released blocks are retired first - a block is given
+ *        back once no concurrent Pop can read it anymore, possibly by a later call.
+ *
+ * @param[in] Level - CacheTrimLevel::Idle releases the idle blocks as described above,
+ *                    CacheTrimLevel::Full releases all cached blocks.
+ *
+ * @return The number of blocks given back to the system.
+ */
+size_t
+XPF_API
+Trim(
+    _In_ xpf::CacheTrimLevel Level = xpf::CacheTrimLevel::Idle
+) noexcept(true);
+
+/**
+ * @brief Retrieves a snapshot of the allocator statistics.
+ *
+ * @return The statistics.
+ */
+xpf::LookasideListStatistics
+XPF_API
+GetStatistics(
+    void
+) noexcept(true);
+
  private:
+/**
+ * @brief A per-processor cache of free blocks. It is accessed (almost always)
+ *        only by the processor which owns it, so the lock is mostly uncontended.
+ *        It is aligned to a cache line so two magazines never share one.
+ */
+struct alignas(XPF_CACHE_LINE_SIZE) LookasideMagazine
+{
+    /**
+     * @brief Guards the magazine. A thread may be migrated to another processor
+     *        while it uses the magazine, so we can't get away without it.
+     */
+    xpf::BusyLock Lock;
+    /**
+     * @brief The top of the stack of free blocks.
+     */
+    XPF_SINGLE_LIST_ENTRY* Top = nullptr;
+    /**
+     * @brief The number of blocks currently in this magazine.
+     */
+    size_t Count = 0;
+    /**
+     * @brief The lowest Count since the last Trim().
+     */
+    size_t LowWater = 0;
+    /**
+     * @brief Allocations served by this magazine, and the ones which went to the system.
+     *        Kept per magazine (under its lock) so the hot path doesn't share a counter.
+     */
+    uint64_t Hits = 0;
+    uint64_t Misses = 0;
+};  // struct LookasideMagazine
+
 /**
  * @brief Clears the underlying resources allocated.
  *
@@ -204,16 +415,212 @@ DeleteMemoryBlock(
     _Inout_ void* MemoryBlock
 ) noexcept(true);
 
+/**
+ * @brief Retrieves the magazine of the current processor.
+ *        The magazines are lazily allocated on first use.
+ *
+ * @return The magazine of the current processor, or null if
+ *         the per-cpu cache is not used or could not be allocated.
+ */
+_Ret_maybenull_
+LookasideMagazine*
+XPF_API
+CurrentMagazine(
+    void
+) noexcept(true);
+
+/**
+ * @brief Either caches the given chain of blocks in the shared queue,
+ *        or frees them if we already cache too many elements.
+ *
+ * @param[in,out] First - The first block of a NULL-terminated chain.
+ *
+ * @param[in,out] Last - The last block of the chain.
+ *
+ * @param[in] Count - The number of blocks in the chain.
+ *
+ * @return None.
+ */
+void
+XPF_API
+ReleaseBlocks(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last,
+    _In_ size_t Count
+) noexcept(true);
+
+/**
+ * @brief Inserts a chain of blocks in the shared store.
+ *
+ * @param[in,out] First - The first block of a NULL-terminated chain.
+ *
+ * @param[in,out] Last - The last block of the chain.
+ *
+ * @return None.
+ */
+void
+XPF_API
+SharedStorePush(
+    _Inout_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true);
+
+/**
+ * @brief Removes at most MaxElements blocks from the shared store.
+ *
+ * @param[in] MaxElements - The maximum number of blocks to be removed.
+ *
+ * @param[out] RemovedElements - The number of blocks actually removed.
+ *
+ * @return The first block of a NULL-terminated chain, or NULL if the store was empty.
+ */
+_Ret_maybenull_
+XPF_SINGLE_LIST_ENTRY*
+XPF_API
+SharedStorePop(
+    _In_ size_t MaxElements,
+    _Out_ size_t* RemovedElements
+) noexcept(true);
+
+/**
+ * @brief Removes all blocks from the shared store.
+ *
+ * @return The first block of a NULL-terminated chain, or NULL if the store was empty.
+ */
+_Ret_maybenull_
+XPF_SINGLE_LIST_ENTRY*
+XPF_API
+SharedStoreFlush(
+    void
+) noexcept(true);
+
+/**
+ * @brief Trampoline used by the cache registry.
+ *
+ * @param[in] Context - The LookasideListAllocator instance.
+ *
+ * @param[in] Level - How much to give back.
+ *
+ * @return The number of bytes given back to the system.
+ */
+static size_t
+CacheTrimCallback(
+    _In_ void* Context,
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true);
+
+/**
+ * @brief Trampoline used by the cache registry.
+ *
+ * @param[in] Context - The LookasideListAllocator instance.
+ *
+ * @return The number of bytes currently cached.
+ */
+static size_t
+CacheSizeCallback(
+    _In_ void* Context
+) noexcept(true);
+
+/**
+ * @brief Retrieves the per-cpu magazines, if they were already allocated.
+ *
+ * @return The first magazine, or null.
+ */
+_Ret_maybenull_
+LookasideMagazine*
+XPF_API
+AllocatedMagazines(
+    void
+) noexcept(true);
+
+/**
+ * @brief Frees a NULL-terminated chain of blocks to the system.
+ *
+ * @param[in,out] First - The first block of the chain. Can be NULL.
+ *
+ * @return None.
+ */
+void
+XPF_API
+DeleteMemoryBlocks(
+    _Inout_opt_ XPF_SINGLE_LIST_ENTRY* First
+) noexcept(true);
+
+/**
+ * @brief Gives a NULL-terminated chain of blocks back to the system. With the lock-free stack,
+ *        a concurrent Pop might still read them - so they are retired in the stack, and only
+ *        the blocks which are safe (these or older ones) are freed now.
+ *
+ * @param[in,out] First - The first block of the chain. Can be NULL.
+ *
+ * @return None.
+ */
+void
+XPF_API
+ReleaseToSystem(
+    _Inout_opt_ XPF_SINGLE_LIST_ENTRY* First
+) noexcept(true);
+
+/**
+ * @brief Adjusts the number of elements cached in the shared queue.
+ *        Also keeps the high and low water marks up to date.
+ *
+ * @param[in] Count - The number of elements to be added or removed.
+ *
+ * @param[in] Add - If true, the elements are added, otherwise they are removed.
+ *
+ * @return None.
+ */
+void
+XPF_API
+AdjustCurrentElements(
+    _In_ size_t Count,
+    _In_ bool Add
+) noexcept(true);
+
  private:
     xpf::TwoLockQueue m_TwoLockQueue;
+    xpf::LockFreeStack m_LockFreeStack;
+    bool m_UseLockFreeStack = false;
     bool m_IsCriticalAllocator = false;
 
     /*
      * @brief   We'll compute the number of elements that we can store in the list.
      *          We'll not exceed this number, to not gobble memory forever.
+     *          SetMaxDepth can change it while other threads allocate, so it is atomic.
      */
     size_t m_ElementSize = 0;
-    size_t m_MaxElements = 0;
+    xpf::Atomic<size_t> m_MaxElements{ 0 };
     alignas(uint32_t) volatile uint32_t m_CurrentElements = 0;
+    alignas(uint32_t) volatile uint32_t m_HighWaterElements = 0;
+    alignas(uint32_t) volatile uint32_t m_LowWaterElements = 0;
+    bool m_ZeroOnReuse = true;
+
+    /*
+     * @brief   Statistics for the shared store path. The magazines keep their own.
+     */
+    alignas(uint64_t) volatile uint64_t m_Hits = 0;
+    alignas(uint64_t) volatile uint64_t m_Misses = 0;
+    alignas(uint64_t) volatile uint64_t m_TrimmedBlocks = 0;
+
+    /*
+     * @brief   The per-cpu magazines. These are lazily allocated as a single block,
+     *          which is aligned to a cache line. m_NumberOfMagazines is 0
+     *          when the per-cpu cache is not used. The capacity is changed by SetMaxDepth.
+     */
+    void* volatile m_MagazinesBlock = nullptr;
+    uint32_t m_NumberOfMagazines = 0;
+    xpf::Atomic<size_t> m_MagazineCapacity{ 0 };
+
+    /*
+     * @brief   Links this allocator in the module-wide cache registry.
+     */
+    xpf::CacheRegistryEntry m_CacheEntry;
+
+    /*
+     * @brief   Upper bounds for the per-cpu cache. These can be changed if we notice we have a problem.
+     */
+    static constexpr uint32_t LOOKASIDE_MAX_MAGAZINES = 128;
+    static constexpr size_t LOOKASIDE_MAGAZINE_CAPACITY = 32;
 };  // class LookasideListAllocator
 };  // namespace xpf
@@ -217,8 +217,28 @@ using FnMemoryAlloc = decltype(xpf::MemoryAllocator::AllocateMemory)*;
  */
 using FnMemoryFree = decltype(xpf::MemoryAllocator::FreeMemory)*;
 
+/**
+ * @brief   Helper for allocating memory from a stateful allocator.
+ *          The first parameter is the allocator context.
+ */
+using FnContextMemoryAlloc = void* (*)(_In_ void* Context, _In_ size_t BlockSize) noexcept(true);
+
+/**
+ * @brief   Helper for freeing memory to a stateful allocator.
+ *          The first parameter is the allocator context.
+ */
+using FnContextMemoryFree = void (*)(_In_ void* Context, _Inout_ void* MemoryBlock) noexcept(true);
+
 /**
  * @brief   A simple structure to store alloc and free functions.
+ *
+ *          By default it is stateless - AllocFunction and FreeFunction are used.
+ *          When ContextAllocFunction and ContextFreeFunction are set, they are used
+ *          instead and they receive the Context. This way the allocator can point to
+ *          an allocator instance (an arena, a pool, and so on).
+ *
+ * @note    For stateful allocators the instance pointed by Context must outlive
+ *          all objects which use this allocator.
  */
 struct PolymorphicAllocator
 {
@@ -231,6 +251,159 @@ struct PolymorphicAllocator
      * @brief   This API is used to free memory. 
      */
     FnMemoryFree FreeFunction = &xpf::MemoryAllocator::FreeMemory;
+
+    /**
+     * @brief   Opaque context given to the context-aware functions below.
+     */
+    void* Context = nullptr;
+
+    /**
+     * @brief   If set, this API is used to allocate memory instead of AllocFunction.
+     */
+    FnContextMemoryAlloc ContextAllocFunction = nullptr;
+
+    /**
+     * @brief   If set, this API is used to free memory instead of FreeFunction.
+     */
+    FnContextMemoryFree ContextFreeFunction = nullptr;
+
+    /**
+     * @brief   Checks whether this allocator can be used.
+     *
+     * @return  true if either the stateful or the stateless pair of functions is set.
+     */
+    inline bool
+    IsValid(
+        void
+    ) const noexcept(true)
+    {
+        if ((nullptr != this->ContextAllocFunction) || (nullptr != this->ContextFreeFunction))
+        {
+            return (nullptr != this->ContextAllocFunction) && (nullptr != this->ContextFreeFunction);
+        }
+        return (nullptr != this->AllocFunction) && (nullptr != this->FreeFunction);
+    }
+
+    /**
+     * @brief   Allocates a block of memory using the configured functions.
+     *
+     * @param[in] BlockSize - The requsted block size.
+     *
+     * @return  A block of memory with the required size, or null on failure.
+     */
+    _Check_return_
+    _Ret_maybenull_
+    inline void*
+    AllocateMemory(
+        _In_ size_t BlockSize
+    ) const noexcept(true)
+    {
+        return (nullptr != this->ContextAllocFunction) ? this->ContextAllocFunction(this->Context, BlockSize)
+                                                       : this->AllocFunction(BlockSize);
+    }
+
+    /**
+     * @brief   Frees a block of memory using the configured functions.
+     *
+     * @param[in,out] MemoryBlock - To be freed.
+     *
+     * @return  Nothing.
+     */
+    inline void
+    FreeMemory(
+        _Inout_ void* MemoryBlock
+    ) const noexcept(true)
+    {
+        (nullptr != this->ContextFreeFunction) ? this->ContextFreeFunction(this->Context, MemoryBlock)
+                                               : this->FreeFunction(MemoryBlock);
+    }
 };  // struct PolymorphicAllocator
 
+/**
+ * @brief This is a memory allocator which allocates memory with a custom alignment.
+ *        Each block spans whole alignment units, so with a cache line alignment
+ *        two blocks never share a cache line.
+ *
+ * @note  Use GetAllocator() to plug it into the containers via PolymorphicAllocator.
+ */
+template <size_t Alignment, bool IsCriticalAllocator = false>
+class AlignedMemoryAllocator
+{
+    static_assert((Alignment != 0) && (0 == (Alignment & (Alignment - 1))),
+                  "Alignment must be a power of 2!");
+
+ public:
+/**
+ * @brief Default constructor.
+ */
+AlignedMemoryAllocator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Default destructor.
+ */
+~AlignedMemoryAllocator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be moved and copied.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(AlignedMemoryAllocator, default);
+
+/**
+ * @brief Allocates a block of memory with the required size.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A block of memory with the required size and alignment, or null on failure.
+ */
+_Check_return_
+_Ret_maybenull_
+static inline void*
+AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    return xpf::ApiAllocateMemoryAligned(BlockSize,
+                                         Alignment,
+                                         IsCriticalAllocator);
+}
+
+/**
+ * @brief Frees a block of memory.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ */
+static inline void
+FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    xpf::ApiFreeMemoryAligned(MemoryBlock);
+}
+
+/**
+ * @brief Retrieves a polymorphic allocator which uses this allocator.
+ *
+ * @return A stateless polymorphic allocator.
+ */
+static inline xpf::PolymorphicAllocator
+GetAllocator(
+    void
+) noexcept(true)
+{
+    return xpf::PolymorphicAllocator{ .AllocFunction = &AlignedMemoryAllocator::AllocateMemory,
+                                      .FreeFunction  = &AlignedMemoryAllocator::FreeMemory };
+}
+};  // class AlignedMemoryAllocator
+
+/**
+ * @brief   An allocator which hands out whole cache lines.
+ */
+using CacheAlignedMemoryAllocator = xpf::AlignedMemoryAllocator<XPF_CACHE_LINE_SIZE>;
+
 };  // namespace xpf
@@ -0,0 +1,231 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/MonotonicArena.hpp
+ *
+ * @brief       Bump-pointer allocator. Memory is carved from big chunks
+ *              and it is released all at once, when the arena is released.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Locks/BusyLock.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief This is a monotonic (bump-pointer) allocator.
+ *        Allocations are carved sequentially from big chunks, so they are very cheap.
+ *        Individual frees are no-ops - all memory is given back to the system when
+ *        the arena is released or destroyed. This makes it a good fit for request-scoped
+ *        work, where a lot of small objects share the same lifetime.
+ *
+ *        It can be given to containers via GetAllocator(), which returns
+ *        a stateful PolymorphicAllocator pointing to this arena.
+ *
+ * @note  The arena must outlive all objects which allocated from it.
+ */
+class MonotonicArena final
+{
+ public:
+/**
+ * @brief Default constructor.
+ *
+ * @param[in] ChunkSize - The size of a chunk. Bigger requests get a dedicated chunk.
+ *
+ * @param[in] IsCriticalAllocator - If true, the chunks are allocated using the Critical default allocator,
+ *                                  if false, they are allocated using the Memory default allocator.
+ */
+MonotonicArena(
+    _In_ size_t ChunkSize = 65536,
+    _In_ bool IsCriticalAllocator = false
+) noexcept(true)
+{
+    this->m_ChunkSize = (ChunkSize < MONOTONIC_ARENA_MIN_CHUNK_SIZE) ? MONOTONIC_ARENA_MIN_CHUNK_SIZE
+                                                                     : ChunkSize;
+    this->m_IsCriticalAllocator = IsCriticalAllocator;
+}
+
+/**
+ * @brief Default destructor. Releases all memory.
+ */
+~MonotonicArena(
+    void
+) noexcept(true)
+{
+    this->Release();
+}
+
+/**
+ * @brief Copy and move semantics are deleted.
+ *        The allocators given to containers point to this instance.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(MonotonicArena, delete);
+
+/**
+ * @brief Allocates a block of memory with the required size.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A zeroed block of memory with the required size, or null on failure.
+ *         The block is aligned to XPF_DEFAULT_ALIGNMENT.
+ */
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Frees a block of memory.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ *
+ * @note This is a no-op. The memory is given back on Release().
+ */
+void
+XPF_API
+FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true);
+
+/**
+ * @brief Gives all memory back to the system.
+ *        All blocks allocated so far are invalidated.
+ *
+ * @return Nothing.
+ */
+void
+XPF_API
+Release(
+    void
+) noexcept(true);
+
+/**
+ * @brief Retrieves the number of bytes handed out so far.
+ *
+ * @return The number of bytes, alignment padding included.
+ */
+inline size_t
+UsedBytes(
+    void
+) const noexcept(true)
+{
+    return this->m_UsedBytes;
+}
+
+/**
+ * @brief Retrieves a polymorphic allocator which routes the requests to this arena.
+ *
+ * @return A stateful polymorphic allocator. Can be given to Vector, String, RedBlackTree and so on.
+ */
+inline xpf::PolymorphicAllocator
+GetAllocator(
+    void
+) noexcept(true)
+{
+    return xpf::PolymorphicAllocator{ .Context              = this,
+                                      .ContextAllocFunction = &MonotonicArena::ContextAllocateMemory,
+                                      .ContextFreeFunction  = &MonotonicArena::ContextFreeMemory };
+}
+
+ private:
+/**
+ * @brief A chunk of memory. The blocks are carved right after this header.
+ */
+struct alignas(XPF_DEFAULT_ALIGNMENT) MonotonicArenaChunk
+{
+    /**
+     * @brief The previously allocated chunk.
+     */
+    MonotonicArenaChunk* Next = nullptr;
+
+    /**
+     * @brief How many bytes can be carved from this chunk.
+     */
+    size_t Capacity = 0;
+
+    /**
+     * @brief How many bytes were already carved from this chunk.
+     */
+    size_t Used = 0;
+};  // struct MonotonicArenaChunk
+
+/**
+ * @brief Tries to carve a block from the current chunk. Lock must be held.
+ *
+ * @param[in] BlockSize - The requested size, already aligned.
+ *
+ * @return The block, or null if the current chunk doesn't have enough room.
+ */
+_Ret_maybenull_
+void*
+XPF_API
+CarveFromCurrentChunk(
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Trampoline used by the polymorphic allocator.
+ *
+ * @param[in] Context - The MonotonicArena instance.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A block of memory with the required size, or null on failure.
+ */
+_Ret_maybenull_
+static void*
+ContextAllocateMemory(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Trampoline used by the polymorphic allocator.
+ *
+ * @param[in] Context - The MonotonicArena instance.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ */
+static void
+ContextFreeMemory(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true);
+
+ private:
+    xpf::BusyLock m_Lock;
+    MonotonicArenaChunk* m_CurrentChunk = nullptr;
+
+    size_t m_ChunkSize = 0;
+    size_t m_UsedBytes = 0;
+    size_t m_NumberOfChunks = 0;
+    bool m_IsCriticalAllocator = false;
+
+    /*
+     * @brief   We don't want chunks so small that the header dominates.
+     */
+    static constexpr size_t MONOTONIC_ARENA_MIN_CHUNK_SIZE = 256;
+};  // class MonotonicArena
+};  // namespace xpf
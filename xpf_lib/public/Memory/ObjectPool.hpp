@@ -0,0 +1,445 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/ObjectPool.hpp
+ *
+ * @brief       Typed pool of objects built on top of the lookaside list allocator.
+ *              Released objects can be kept constructed and handed out again.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Memory/SharedPointer.hpp"
+#include "xpf_lib/public/Memory/LookasideListAllocator.hpp"
+#include "xpf_lib/public/Containers/LockFreeStack.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief   Brings a released object back to a reusable state, instead of destroying it.
+ *          Must not fail.
+ */
+template <class Type>
+using ObjectPoolResetHook = void (*)(_Inout_ Type& Object) noexcept(true);
+
+/**
+ * @brief This is a typed pool of objects. The memory comes from a lookaside list allocator
+ *        (with a per-cpu cache by default), so acquiring and releasing an object doesn't go
+ *        to the system allocator and the blocks are not zeroed - the constructor initializes the object.
+ *
+ *        If a reset hook is given, released objects are not destroyed. The hook brings them back
+ *        to a clean state and they are kept constructed in a lock-free stack, so the next Acquire()
+ *        returns the most recently released (likely cache-hot) object without running any constructor.
+ *        At most OBJECT_POOL_MAX_CONSTRUCTED objects are kept this way, the rest are destroyed.
+ *        A concurrent Acquire() might still read a slot which went through the stack, so such
+ *        slots are retired in the stack and only given back to the allocator once it reclaims them.
+ *        This makes Release() and Trim() safe to call while other threads acquire objects.
+ *
+ *        The same blocks can also hold a SharedPointer control block and the object - see MakePooledShared.
+ *
+ * @note  The pool must outlive all objects acquired from it.
+ */
+template <class Type>
+class ObjectPool final
+{
+    static_assert((sizeof(Type) > 0) && (alignof(Type) <= XPF_DEFAULT_ALIGNMENT),
+                  "Invalid object properties!");
+
+ public:
+/**
+ * @brief Default constructor.
+ *
+ * @param[in] ResetHook - If not null, released objects are reset with this hook and kept constructed.
+ *
+ * @param[in] IsCriticalAllocator - If true, the blocks are allocated using the Critical default allocator,
+ *                                  if false, they are allocated using the Memory default allocator.
+ *
+ * @param[in] UsePerCpuCache - If true, the lookaside list uses a per-processor magazine.
+ */
+ObjectPool(
+    _In_opt_ xpf::ObjectPoolResetHook<Type> ResetHook = nullptr,
+    _In_ bool IsCriticalAllocator = false,
+    _In_ bool UsePerCpuCache = true
+) noexcept(true) : m_Allocator(OBJECT_POOL_BLOCK_SIZE, IsCriticalAllocator, UsePerCpuCache)
+{
+    //
+    // The objects are always constructed (or reset) before being handed out.
+    //
+    this->m_Allocator.SetZeroOnReuse(false);
+    this->m_ResetHook = ResetHook;
+}
+
+/**
+ * @brief Default destructor. Destroys the objects kept constructed.
+ */
+~ObjectPool(
+    void
+) noexcept(true)
+{
+    this->DestroyConstructedObjects();
+}
+
+/**
+ * @brief Copy and move semantics are deleted.
+ *        The objects and the allocators given to shared pointers point to this instance.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(ObjectPool, delete);
+
+/**
+ * @brief Retrieves an object from the pool.
+ *
+ * @param[in,out] ConstructorArguments - To be provided to the object if a new one must be constructed.
+ *                                       A recycled object (reset hook) is returned as the hook left it.
+ *
+ * @return The object, or null on failure. Must be given back with Release().
+ */
+template <typename... Arguments>
+_Ret_maybenull_
+inline Type*
+Acquire(
+    Arguments&&... ConstructorArguments
+) noexcept(true)
+{
+    if (nullptr != this->m_ResetHook)
+    {
+        XPF_SINGLE_LIST_ENTRY* entry = this->m_ConstructedObjects.Pop();
+        if (nullptr != entry)
+        {
+            xpf::ApiAtomicDecrement(&this->m_ConstructedCount);
+            return ObjectFromSlot(XPF_CONTAINING_RECORD(entry, ObjectPoolSlot, ListEntry));
+        }
+    }
+
+    ObjectPoolSlot* slot = static_cast<ObjectPoolSlot*>(this->m_Allocator.AllocateMemory(OBJECT_POOL_BLOCK_SIZE));
+    if (nullptr == slot)
+    {
+        return nullptr;
+    }
+
+    Type* object = ObjectFromSlot(slot);
+    xpf::MemoryAllocator::Construct(object,
+                                    xpf::Forward<Arguments>(ConstructorArguments)...);
+    return object;
+}
+
+/**
+ * @brief Gives an object back to the pool.
+ *
+ * @param[in,out] Object - Returned by Acquire(). Can be null.
+ *
+ * @return Nothing.
+ */
+inline void
+Release(
+    _Inout_opt_ Type* Object
+) noexcept(true)
+{
+    if (nullptr == Object)
+    {
+        return;
+    }
+    ObjectPoolSlot* slot = SlotFromObject(Object);
+
+    //
+    // Keep the object constructed if we can. The counter is only a soft limit.
+    //
+    if ((nullptr != this->m_ResetHook) &&
+        (xpf::ApiAtomicIncrement(&this->m_ConstructedCount) <= OBJECT_POOL_MAX_CONSTRUCTED))
+    {
+        this->m_ResetHook(*Object);
+
+        slot->ListEntry.Next = nullptr;
+        this->m_ConstructedObjects.Push(&slot->ListEntry);
+        return;
+    }
+    if (nullptr != this->m_ResetHook)
+    {
+        xpf::ApiAtomicDecrement(&this->m_ConstructedCount);
+    }
+
+    xpf::MemoryAllocator::Destruct(Object);
+    if (nullptr != this->m_ResetHook)
+    {
+        slot->ListEntry.Next = nullptr;
+        this->ReleaseSlots(&slot->ListEntry, &slot->ListEntry);
+    }
+    else
+    {
+        this->m_Allocator.FreeMemory(slot);
+    }
+}
+
+/**
+ * @brief Destroys the objects kept constructed and trims the lookaside list.
+ *
+ * @return The number of blocks given back to the system.
+ */
+inline size_t
+Trim(
+    void
+) noexcept(true)
+{
+    this->DestroyConstructedObjects();
+    return this->m_Allocator.Trim();
+}
+
+/**
+ * @brief Retrieves a snapshot of the underlying lookaside list statistics.
+ *
+ * @return The statistics.
+ */
+inline xpf::LookasideListStatistics
+GetStatistics(
+    void
+) noexcept(true)
+{
+    return this->m_Allocator.GetStatistics();
+}
+
+/**
+ * @brief Adds the underlying lookaside list to the module-wide cache registry,
+ *        so ApiTrimCaches() and the CacheTrimmer reclaim its cached blocks as well.
+ *        The objects kept constructed are not touched - only Trim() destroys them.
+ *
+ * @return None.
+ *
+ * @note Meant for long-lived pools. See LookasideListAllocator::JoinCacheRegistry().
+ */
+inline void
+JoinCacheRegistry(
+    void
+) noexcept(true)
+{
+    this->m_Allocator.JoinCacheRegistry();
+}
+
+/**
+ * @brief Retrieves a polymorphic allocator which hands out blocks from this pool.
+ *        Every block has room for a SharedPointer<Type> control block and the object.
+ *
+ * @return A stateful polymorphic allocator.
+ */
+inline xpf::PolymorphicAllocator
+GetAllocator(
+    void
+) noexcept(true)
+{
+    return xpf::PolymorphicAllocator{ .Context              = this,
+                                      .ContextAllocFunction = &ObjectPool::ContextAllocateMemory,
+                                      .ContextFreeFunction  = &ObjectPool::ContextFreeMemory };
+}
+
+ private:
+/**
+ * @brief Precedes every object. Used to chain the objects kept constructed.
+ */
+struct alignas(XPF_DEFAULT_ALIGNMENT) ObjectPoolSlot
+{
+    /**
+     * @brief Links the slot in the stack of constructed objects.
+     */
+    XPF_SINGLE_LIST_ENTRY ListEntry = { 0 };
+};  // struct ObjectPoolSlot
+
+/**
+ * @brief Retrieves the object stored in a slot.
+ *
+ * @param[in] Slot - The slot.
+ *
+ * @return The object.
+ */
+static inline Type*
+ObjectFromSlot(
+    _In_ ObjectPoolSlot* Slot
+) noexcept(true)
+{
+    return static_cast<Type*>(xpf::AlgoAddToPointer(Slot, sizeof(ObjectPoolSlot)));
+}
+
+/**
+ * @brief Retrieves the slot holding an object.
+ *
+ * @param[in] Object - The object.
+ *
+ * @return The slot.
+ */
+static inline ObjectPoolSlot*
+SlotFromObject(
+    _In_ Type* Object
+) noexcept(true)
+{
+    return reinterpret_cast<ObjectPoolSlot*>(reinterpret_cast<uint8_t*>(Object) - sizeof(ObjectPoolSlot));
+}
+
+/**
+ * @brief Gives back to the lookaside list a chain of slots whose objects were already destroyed.
+ *        The slots might have been in the stack of constructed objects, so they are retired first.
+ *        Only the slots which no Pop can read anymore are freed now - the rest on a later call.
+ *
+ * @param[in,out] First - The first slot entry of a NULL-terminated chain. Can be null,
+ *                        then only the slots retired by earlier calls are given back.
+ *
+ * @param[in,out] Last - The last slot entry of the chain.
+ *
+ * @return Nothing.
+ */
+inline void
+ReleaseSlots(
+    _Inout_opt_ XPF_SINGLE_LIST_ENTRY* First,
+    _Inout_opt_ XPF_SINGLE_LIST_ENTRY* Last
+) noexcept(true)
+{
+    if (nullptr != First)
+    {
+        this->m_ConstructedObjects.Retire(First, Last);
+    }
+
+    XPF_SINGLE_LIST_ENTRY* entry = this->m_ConstructedObjects.Reclaim();
+    while (nullptr != entry)
+    {
+        ObjectPoolSlot* slot = XPF_CONTAINING_RECORD(entry, ObjectPoolSlot, ListEntry);
+        entry = entry->Next;
+
+        this->m_Allocator.FreeMemory(slot);
+    }
+}
+
+/**
+ * @brief Destroys the objects kept constructed and gives their blocks back to the lookaside list.
+ *
+ * @return Nothing.
+ */
+inline void
+DestroyConstructedObjects(
+    void
+) noexcept(true)
+{
+    XPF_SINGLE_LIST_ENTRY* first = this->m_ConstructedObjects.Flush();
+    XPF_SINGLE_LIST_ENTRY* last = nullptr;
+
+    for (XPF_SINGLE_LIST_ENTRY* entry = first; nullptr != entry; entry = entry->Next)
+    {
+        xpf::ApiAtomicDecrement(&this->m_ConstructedCount);
+        xpf::MemoryAllocator::Destruct(ObjectFromSlot(XPF_CONTAINING_RECORD(entry, ObjectPoolSlot, ListEntry)));
+        last = entry;
+    }
+
+    //
+    // Even with nothing to destroy, this gives back the slots retired by earlier calls.
+    //
+    this->ReleaseSlots(first, last);
+}
+
+/**
+ * @brief Trampoline used by the polymorphic allocator.
+ *
+ * @param[in] Context - The ObjectPool instance.
+ *
+ * @param[in] BlockSize - The requsted block size. At most OBJECT_POOL_BLOCK_SIZE.
+ *
+ * @return A block of memory with the required size, or null on failure.
+ */
+_Ret_maybenull_
+static inline void*
+ContextAllocateMemory(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    return static_cast<ObjectPool*>(Context)->m_Allocator.AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief Trampoline used by the polymorphic allocator.
+ *
+ * @param[in] Context - The ObjectPool instance.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ */
+static inline void
+ContextFreeMemory(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    static_cast<ObjectPool*>(Context)->m_Allocator.FreeMemory(MemoryBlock);
+}
+
+ private:
+    xpf::LookasideListAllocator m_Allocator;
+    xpf::ObjectPoolResetHook<Type> m_ResetHook = nullptr;
+
+    xpf::LockFreeStack m_ConstructedObjects;
+    alignas(uint32_t) volatile uint32_t m_ConstructedCount = 0;
+
+ public:
+    /**
+     * @brief   The size of a block - big enough for either a slot and the object,
+     *          or for the SharedPointer control block and the object.
+     */
+    static constexpr size_t OBJECT_POOL_BLOCK_SIZE =
+        (sizeof(ObjectPoolSlot) + sizeof(Type) > xpf::SharedPointer<Type>::FULL_OBJECT_SIZE)
+            ? sizeof(ObjectPoolSlot) + sizeof(Type)
+            : xpf::SharedPointer<Type>::FULL_OBJECT_SIZE;
+
+    /**
+     * @brief   How many released objects can be kept constructed at once.
+     */
+    static constexpr uint32_t OBJECT_POOL_MAX_CONSTRUCTED = 1024;
+};  // class ObjectPool
+
+
+/**
+ * @brief In-Place creates a shared pointer whose control block and object live in a single pooled block.
+ *        Unlike MakeSharedWithAllocator, the block is not zeroed - the constructor initializes the object.
+ *        The object is destroyed when the last reference goes away - the reset hook is not used.
+ *
+ * @param[in,out] Pool                  - The pool which provides the memory. Must outlive the pointer.
+ * @param[in,out] ConstructorArguments  - To be provided to the object.
+ *
+ * @return a SharedPointer that holds the constructed object, or an empty object on failure.
+ */
+template<class Type,
+         typename... Arguments>
+inline SharedPointer<Type>
+MakePooledShared(
+    _Inout_ xpf::ObjectPool<Type>& Pool,
+    Arguments&&... ConstructorArguments
+) noexcept(true)
+{
+    SharedPointer<Type> sharedPtr{ Pool.GetAllocator() };
+    auto& allocator = sharedPtr.GetAllocator();
+    auto& memoryBlock = sharedPtr.GetMemoryBlock();
+
+    memoryBlock.ReferenceCounter = static_cast<int32_t*>(allocator.AllocateMemory(sharedPtr.FULL_OBJECT_SIZE));
+    if (nullptr != memoryBlock.ReferenceCounter)
+    {
+        xpf::MemoryAllocator::Construct(memoryBlock.ReferenceCounter,
+                                        int32_t{ 1 });
+
+        memoryBlock.ObjectBase = static_cast<Type*>(xpf::AlgoAddToPointer(memoryBlock.ReferenceCounter,
+                                                                          sharedPtr.REFERENCE_COUNTER_SIZE));
+        xpf::MemoryAllocator::Construct(memoryBlock.ObjectBase,
+                                        xpf::Forward<Arguments>(ConstructorArguments)...);
+    }
+    return sharedPtr;
+}
+};  // namespace xpf
@@ -0,0 +1,341 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/SamplingAllocationProfiler.hpp
+ *
+ * @brief       Allocator wrapper which samples allocations and aggregates them
+ *              per call stack, so the heaviest call sites can be found.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+#include "xpf_lib/public/Memory/CacheAligned.hpp"
+#include "xpf_lib/public/Locks/BusyLock.hpp"
+#include "xpf_lib/public/Containers/String.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief A snapshot of the profiler counters.
+ *        The counters are best effort - they may be slightly off while the profiler is in use.
+ */
+struct AllocationProfileStatistics
+{
+    /**
+     * @brief One of every SampleRate allocations is sampled.
+     */
+    uint32_t SampleRate = 0;
+
+    /**
+     * @brief The number of sampled allocations.
+     */
+    uint64_t SampledAllocations = 0;
+
+    /**
+     * @brief The number of bytes requested by the sampled allocations.
+     */
+    uint64_t SampledBytes = 0;
+
+    /**
+     * @brief The number of distinct call stacks in the table.
+     */
+    size_t UniqueStacks = 0;
+
+    /**
+     * @brief The number of samples which didn't fit in the table.
+     */
+    uint64_t DroppedSamples = 0;
+};  // struct AllocationProfileStatistics
+
+/**
+ * @brief This wraps another polymorphic allocator and profiles the allocations going through it.
+ *        One of every SampleRate allocations is sampled: its call stack is captured
+ *        and the bytes and the count are added to the entry of that stack in a fixed-size table.
+ *        Multiply the sampled values by the rate to get an estimate of the real ones.
+ *
+ *        The non-sampled path is a single atomic increment of a per-cpu counter,
+ *        so with a rate of 4096 it can be left on in production.
+ *        The stack is captured outside of the lock - the lock only guards the table update.
+ *
+ * @note  Frees are forwarded as they are - blocks don't carry a header, so the profile
+ *        shows where memory was allocated, not what is still in use.
+ *        The top frames of each stack belong to the profiler itself.
+ */
+class SamplingAllocationProfiler final
+{
+ public:
+/**
+ * @brief Default constructor.
+ *
+ * @param[in] BackingAllocator - The allocator which does the actual allocations.
+ *                               If stateful, it must outlive this object.
+ *
+ * @param[in] SampleRate - One of every SampleRate allocations is sampled. 0 is treated as 1.
+ *
+ * @param[in] TableCapacity - How many distinct stacks can be tracked. Rounded up to a power of 2.
+ *                            The table is allocated on the first sample.
+ */
+SamplingAllocationProfiler(
+    _In_ xpf::PolymorphicAllocator BackingAllocator = xpf::PolymorphicAllocator{},
+    _In_ uint32_t SampleRate = 4096,
+    _In_ size_t TableCapacity = 1024
+) noexcept(true)
+{
+    this->m_BackingAllocator = BackingAllocator;
+    this->m_SampleRate = (0 == SampleRate) ? 1
+                                           : SampleRate;
+    if ((this->m_SampleRate > 1) && (0 == (this->m_SampleRate & (this->m_SampleRate - 1))))
+    {
+        this->m_SampleMask = this->m_SampleRate - 1;
+    }
+
+    size_t capacity = PROFILER_MIN_TABLE_CAPACITY;
+    while ((capacity < TableCapacity) && (capacity < PROFILER_MAX_TABLE_CAPACITY))
+    {
+        capacity *= 2;
+    }
+    this->m_TableCapacity = capacity;
+}
+
+/**
+ * @brief Default destructor. Frees the table.
+ *        All blocks must have been freed by now.
+ */
+~SamplingAllocationProfiler(
+    void
+) noexcept(true)
+{
+    if (nullptr != this->m_Table)
+    {
+        xpf::ApiFreeMemory(this->m_Table);
+        this->m_Table = nullptr;
+    }
+}
+
+/**
+ * @brief Copy and move semantics are deleted.
+ *        The allocators given to containers point to this instance.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(SamplingAllocationProfiler, delete);
+
+/**
+ * @brief Allocates a block of memory using the backing allocator.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A block of memory as returned by the backing allocator, or null on failure.
+ */
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Frees a block of memory using the backing allocator.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ */
+void
+XPF_API
+FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true);
+
+/**
+ * @brief Retrieves a snapshot of the counters.
+ *
+ * @return The statistics.
+ */
+xpf::AllocationProfileStatistics
+XPF_API
+GetStatistics(
+    void
+) noexcept(true);
+
+/**
+ * @brief Forgets all samples collected so far.
+ *
+ * @return Nothing.
+ */
+void
+XPF_API
+Reset(
+    void
+) noexcept(true);
+
+/**
+ * @brief Writes the profile in a pprof-like text format:
+ *
+ *        heap profile: <count>: <bytes> [<count * rate>: <bytes * rate>] @ heap/<rate>
+ *        <count>: <bytes> [<count * rate>: <bytes * rate>] @ 0x<frame> 0x<frame> ...
+ *
+ *        The first line holds the totals, then there is a line for each call stack.
+ *        The frames are raw return addresses, innermost first - they can be symbolized offline.
+ *
+ * @param[out] Output - Will contain the report. It is reset first.
+ *                      Its allocator may be this profiler - the lock is not held while appending.
+ *
+ * @return A proper NTSTATUS error code.
+ */
+_Must_inspect_result_
+NTSTATUS
+XPF_API
+Dump(
+    _Inout_ xpf::String<char>& Output
+) noexcept(true);
+
+/**
+ * @brief Retrieves a polymorphic allocator which routes the requests through this profiler.
+ *
+ * @return A stateful polymorphic allocator. Can be given to Vector, String, RedBlackTree and so on.
+ */
+inline xpf::PolymorphicAllocator
+GetAllocator(
+    void
+) noexcept(true)
+{
+    return xpf::PolymorphicAllocator{ .Context              = this,
+                                      .ContextAllocFunction = &SamplingAllocationProfiler::ContextAllocateMemory,
+                                      .ContextFreeFunction  = &SamplingAllocationProfiler::ContextFreeMemory };
+}
+
+ private:
+/**
+ * @brief   How many frames are kept for each stack.
+ */
+static constexpr uint32_t PROFILER_MAX_FRAMES = 32;
+
+/**
+ * @brief An entry in the table. An entry with Count == 0 is free.
+ */
+struct ProfilerRecord
+{
+    /**
+     * @brief The hash of the frames - to quickly skip entries with other stacks.
+     */
+    uint64_t Hash = 0;
+
+    /**
+     * @brief The number of sampled allocations from this stack.
+     */
+    uint64_t Count = 0;
+
+    /**
+     * @brief The number of bytes requested by the sampled allocations from this stack.
+     */
+    uint64_t Bytes = 0;
+
+    /**
+     * @brief How many elements of Frames are valid.
+     */
+    uint32_t FramesCount = 0;
+
+    /**
+     * @brief The captured return addresses, innermost first.
+     */
+    void* Frames[PROFILER_MAX_FRAMES] = { 0 };
+};  // struct ProfilerRecord
+
+/**
+ * @brief Decides if the current allocation should be sampled.
+ *
+ * @return true if it should be sampled, false otherwise.
+ */
+bool
+XPF_API
+ShouldSample(
+    void
+) noexcept(true);
+
+/**
+ * @brief Captures the current stack and adds the allocation to its entry.
+ *
+ * @param[in] BlockSize - The size of the sampled allocation.
+ *
+ * @return Nothing.
+ */
+void
+XPF_API
+RecordSample(
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Trampoline used by the polymorphic allocator.
+ *
+ * @param[in] Context - The SamplingAllocationProfiler instance.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A block of memory with the required size, or null on failure.
+ */
+_Ret_maybenull_
+static void*
+ContextAllocateMemory(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Trampoline used by the polymorphic allocator.
+ *
+ * @param[in] Context - The SamplingAllocationProfiler instance.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return Nothing.
+ */
+static void
+ContextFreeMemory(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true);
+
+ private:
+    xpf::PolymorphicAllocator m_BackingAllocator;
+    uint32_t m_SampleRate = 0;
+    uint32_t m_SampleMask = 0;
+
+    /**
+     * @brief   The allocations are counted per cpu, so the hot path doesn't bounce a shared line.
+     */
+    static constexpr uint32_t PROFILER_MAX_COUNTERS = 16;
+    xpf::CacheAligned<volatile uint32_t> m_Counters[PROFILER_MAX_COUNTERS];
+
+    xpf::BusyLock m_Lock;
+    ProfilerRecord* m_Table = nullptr;
+    size_t m_TableCapacity = 0;
+
+    uint64_t m_SampledAllocations = 0;
+    uint64_t m_SampledBytes = 0;
+    uint64_t m_DroppedSamples = 0;
+    size_t m_UniqueStacks = 0;
+
+    /**
+     * @brief   Bounds for the table. A sample which doesn't find its entry
+     *          after PROFILER_MAX_PROBES slots is dropped.
+     */
+    static constexpr size_t PROFILER_MIN_TABLE_CAPACITY = 16;
+    static constexpr size_t PROFILER_MAX_TABLE_CAPACITY = 65536;
+    static constexpr size_t PROFILER_MAX_PROBES = 64;
+};  // class SamplingAllocationProfiler
+};  // namespace xpf
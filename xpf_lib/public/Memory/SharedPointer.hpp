@@ -20,6 +20,7 @@
 #include "xpf_lib/public/core/Core.hpp"
 #include "xpf_lib/public/core/TypeTraits.hpp"
 #include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
 
 #include "xpf_lib/public/Memory/MemoryAllocator.hpp"
 #include "xpf_lib/public/Memory/CompressedPair.hpp"
@@ -69,14 +70,13 @@ struct MemoryBlock
  *
  * @param[in]   Allocator - to be used when performing allocations.
  *
- * @note        For now only state-less allocators are supported.
+ * @note        Stateful allocators must outlive this object.
  */
 SharedPointer(
     _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
 ) noexcept(true)
 {
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.AllocFunction);
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.FreeFunction);
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
 
     this->m_CompressedPair.First() = Allocator;
 }
@@ -415,51 +415,30 @@ Dereference(
     auto& allocator = this->m_CompressedPair.First();
     auto& memoryBlock = this->m_CompressedPair.Second();
 
-    while (true)
+    if (!this->IsEmpty())
     {
         //
-        // Nothing to do here. Bail.
+        // Decrement the refcounter. The release order publishes our writes to the object
+        // to whoever destroys it. We can't go on negative references.
         //
-        if (this->IsEmpty())
-        {
-            break;
-        }
-
-        //
-        // Grab the current refcounter.
-        //
-        const int32_t currentCounter = (*memoryBlock.ReferenceCounter);
-
-        //
-        // Decrement the refcounter - We can't go on negative references.
-        //
-        const int32_t newRefCounter = currentCounter - 1;
-        if (newRefCounter < 0)
+        const int32_t previousCounter = xpf::ApiAtomicFetchSub(memoryBlock.ReferenceCounter,
+                                                               int32_t{ 1 },
+                                                               xpf::MemoryOrder::Release);
+        if (previousCounter < 1)
         {
             xpf::ApiPanic(STATUS_INVALID_STATE_TRANSITION);
-            break;
         }
-
-        //
-        // Someone changed the refcounter. Try again.
-        //
-        if (currentCounter != xpf::ApiAtomicCompareExchange(memoryBlock.ReferenceCounter,
-                                                            newRefCounter,
-                                                            currentCounter))
+        else if (1 == previousCounter)
         {
-            continue;
-        }
+            //
+            // We dropped the last reference. See the writes of the other owners before destroying.
+            //
+            xpf::ApiAtomicThreadFence(xpf::MemoryOrder::Acquire);
 
-        //
-        // Successfully decremented the counter. We might need to destroy the object.
-        //
-        if (0 == newRefCounter)
-        {
             xpf::MemoryAllocator::Destruct(memoryBlock.ReferenceCounter);
             xpf::MemoryAllocator::Destruct(memoryBlock.ObjectBase);
-            allocator.FreeFunction(memoryBlock.ReferenceCounter);
+            allocator.FreeMemory(memoryBlock.ReferenceCounter);
         }
-        break;
     }
 
     //
@@ -483,50 +462,24 @@ Reference(
     //
     auto& memoryBlock = this->m_CompressedPair.Second();
 
-    while (true)
+    //
+    // Nothing to do here. Bail.
+    //
+    if (this->IsEmpty())
     {
-        //
-        // Nothing to do here. Bail.
-        //
-        if (this->IsEmpty())
-        {
-            break;
-        }
-
-        //
-        // If we are full - spin and try again.
-        //
-        const int32_t currentCounter = (*memoryBlock.ReferenceCounter);
-        if (currentCounter == xpf::NumericLimits<int32_t>::MaxValue())
-        {
-            xpf::ApiYieldProcesor();
-            continue;
-        }
-
-        //
-        // Increment the refcounter - we should have at least 2 references after.
-        //
-        const int32_t newRefCounter = currentCounter + 1;
-        if (newRefCounter < 2)
-        {
-            xpf::ApiPanic(STATUS_INVALID_STATE_TRANSITION);
-            break;
-        }
-
-        //
-        // Someone changed the refcounter. Spin and try again.
-        //
-        if (currentCounter != xpf::ApiAtomicCompareExchange(memoryBlock.ReferenceCounter,
-                                                            newRefCounter,
-                                                            currentCounter))
-        {
-            continue;
-        }
+        return;
+    }
 
-        //
-        // Successfully incremented the counter. Exit.
-        //
-        break;
+    //
+    // We already own a reference, so the object can't go away - no ordering is needed.
+    // We should have had at least 1 reference before, and we can't wrap around.
+    //
+    const int32_t previousCounter = xpf::ApiAtomicFetchAdd(memoryBlock.ReferenceCounter,
+                                                           int32_t{ 1 },
+                                                           xpf::MemoryOrder::Relaxed);
+    if ((previousCounter < 1) || (previousCounter == xpf::NumericLimits<int32_t>::MaxValue()))
+    {
+        xpf::ApiPanic(STATUS_INVALID_STATE_TRANSITION);
     }
 }
 
@@ -562,6 +515,12 @@ Reference(
                   "Overflow during addition!");
 };  // class SharedPointer
 
+/**
+ * @brief The shared pointer holds no pointers to itself, so it can be relocated with a memory copy.
+ */
+template <class Type>
+constexpr inline bool TriviallyRelocatableOptIn<xpf::SharedPointer<Type>> = true;
+
 
 template<class TypeU,
          typename... Arguments>
@@ -589,7 +548,7 @@ MakeSharedWithAllocator(
     //
     // Try to allocate memory and construct an object of type U.
     //
-    memoryBlock.ReferenceCounter = static_cast<int32_t*>(allocator.AllocFunction(sharedPtr.FULL_OBJECT_SIZE));
+    memoryBlock.ReferenceCounter = static_cast<int32_t*>(allocator.AllocateMemory(sharedPtr.FULL_OBJECT_SIZE));
     if (nullptr != memoryBlock.ReferenceCounter)
     {
         //
@@ -675,7 +634,7 @@ DynamicSharedPointerCast(
         /*                                                                                   */                             \
         /* Try to allocate memory and construct an object of type U.                         */                             \
         /*                                                                                   */                             \
-        _memoryBlock.ReferenceCounter = static_cast<int32_t*>(_allocator.AllocFunction(Pointer.FULL_OBJECT_SIZE));          \
+        _memoryBlock.ReferenceCounter = static_cast<int32_t*>(_allocator.AllocateMemory(Pointer.FULL_OBJECT_SIZE));          \
         if (nullptr != _memoryBlock.ReferenceCounter)                                                                       \
         {                                                                                                                   \
             /*                                                                               */                             \
@@ -0,0 +1,133 @@
+﻿/**
+ * @file        xpf_lib/public/Memory/SlabAllocator.hpp
+ *
+ * @brief       General purpose allocator with geometric size classes.
+ *              Each size class carves slabs into fixed-size blocks
+ *              and keeps its own free list of blocks.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/MemoryAllocator.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief   This is a polymorphic allocator which routes the allocations through the slab allocator.
+ *          It can be given to Vector, String, RedBlackTree, SharedPointer and so on.
+ */
+#define XPF_SLAB_ALLOCATOR  xpf::PolymorphicAllocator{ .AllocFunction = &xpf::SlabAllocator::AllocateMemory,     \
+                                                       .FreeFunction  = &xpf::SlabAllocator::FreeMemory }
+
+/**
+ * @brief This is a general purpose memory allocator built on size classes.
+ *        The sizes are split in geometric classes (16, 32, 64, ... 8192 bytes).
+ *        Each class carves big slabs of memory into fixed-size blocks and
+ *        keeps a free list of them. Blocks are never returned to the system
+ *        while their slab is in use, so the system allocator is hit only
+ *        once per slab instead of once per allocation.
+ *
+ *        The blocks carry no header - the slabs are aligned to their size, so the
+ *        slab owning a block is found by masking its address. Each class also has
+ *        a per-processor magazine of free blocks, which moves blocks to and from the
+ *        class in batches - so the class lock is not taken on every call.
+ *
+ *        Requests larger than the biggest size class go straight to the system.
+ *
+ * @note  The slabs are allocated from the default (paged on windows KM) pool.
+ *        So this allocator can not be used above APC_LEVEL.
+ *
+ * @note  The state is shared by the whole module, so this class only exposes
+ *        static methods - this way it can be plugged in a PolymorphicAllocator.
+ */
+class SlabAllocator final
+{
+ public:
+/**
+ * @brief Default constructor.
+ */
+SlabAllocator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Default destructor.
+ */
+~SlabAllocator(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief This class can be moved and copied.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(SlabAllocator, default);
+
+/**
+ * @brief Allocates a block of memory with the required size.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @return A zeroed block of memory with the required size, or null on failure.
+ *         The block is aligned to XPF_DEFAULT_ALIGNMENT.
+ */
+_Check_return_
+_Ret_maybenull_
+static void*
+AllocateMemory(
+    _In_ size_t BlockSize
+) noexcept(true);
+
+/**
+ * @brief Frees a block of memory.
+ *
+ * @param[in,out] MemoryBlock - To be freed. Must have been allocated with SlabAllocator::AllocateMemory.
+ *
+ * @return Nothing.
+ *
+ * @note The block goes back to the magazine of the current processor,
+ *       and from there to the free list of its size class.
+ *       The memory is not returned to the system.
+ */
+static void
+FreeMemory(
+    _Inout_ void* MemoryBlock
+) noexcept(true);
+
+/**
+ * @brief Returns to the system all slabs which have no block in use.
+ *
+ * @return The number of bytes given back to the system.
+ *
+ * @note This drains the magazines and walks the free lists, so it should not be called on hot paths.
+ *       The slab allocator joins the cache registry when it creates its first slab,
+ *       so ApiTrimCaches() calls this as well.
+ */
+static size_t
+XPF_API
+ReleaseUnusedSlabs(
+    void
+) noexcept(true);
+
+/**
+ * @brief   The smallest and the biggest size class.
+ *          Requests above SLAB_MAX_CLASS_SIZE go to the system allocator.
+ */
+static constexpr size_t SLAB_MIN_CLASS_SIZE = 16;
+static constexpr size_t SLAB_MAX_CLASS_SIZE = 8192;
+};  // class SlabAllocator
+};  // namespace xpf
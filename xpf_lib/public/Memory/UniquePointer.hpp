@@ -69,14 +69,13 @@ struct MemoryBlock
  *
  * @param[in]   Allocator - to be used when performing allocations.
  *
- * @note        For now only state-less allocators are supported.
+ * @note        Stateful allocators must outlive this object.
  */
 UniquePointer(
     _In_ xpf::PolymorphicAllocator Allocator = xpf::PolymorphicAllocator{}
 ) noexcept(true)
 {
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.AllocFunction);
-    XPF_DEATH_ON_FAILURE(nullptr != Allocator.FreeFunction);
+    XPF_DEATH_ON_FAILURE(Allocator.IsValid());
 
     this->m_CompressedPair.First() = Allocator;
 }
@@ -207,7 +206,7 @@ Reset(
     if (!this->IsEmpty())
     {
         xpf::MemoryAllocator::Destruct(memoryBlock.ObjectBase);
-        allocator.FreeFunction(memoryBlock.AllocationBase);
+        allocator.FreeMemory(memoryBlock.AllocationBase);
 
         memoryBlock.AllocationBase = nullptr;
         memoryBlock.ObjectBase = nullptr;
@@ -442,7 +441,7 @@ MakeUniqueWithAllocator(
     //
     // Try to allocate memory and construct an object of type U.
     //
-    memoryBlock.AllocationBase = allocator.AllocFunction(sizeof(TypeU));
+    memoryBlock.AllocationBase = allocator.AllocateMemory(sizeof(TypeU));
     if (nullptr != memoryBlock.AllocationBase)
     {
         xpf::ApiZeroMemory(memoryBlock.AllocationBase, sizeof(TypeU));
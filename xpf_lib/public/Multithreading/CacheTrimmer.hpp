@@ -0,0 +1,189 @@
+﻿/**
+ * @file        xpf_lib/public/Multithreading/CacheTrimmer.hpp
+ *
+ * @brief       A background thread which periodically trims the caches
+ *              registered in the cache registry.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+#include "xpf_lib/public/Memory/Optional.hpp"
+#include "xpf_lib/public/Memory/CacheRegistry.hpp"
+
+#include "xpf_lib/public/Multithreading/Signal.hpp"
+#include "xpf_lib/public/Multithreading/Thread.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief   Every period, the trimmer compares the bytes cached by all registered
+ *          allocators with a budget. Over budget, everything is trimmed (CacheTrimLevel::Full).
+ *          Otherwise only the memory which stayed idle for a whole period (CacheTrimLevel::Idle).
+ *
+ * @note    The budget is about the cached memory and not about the process footprint,
+ *          as the latter can't be queried the same way on all platforms.
+ *
+ * @note    The trims run while the allocators are in use, so every registered cache must
+ *          support a concurrent Trim. The lookaside lists retire the blocks which a concurrent
+ *          lock-free Pop might still read, instead of freeing them right away.
+ */
+class CacheTrimmer final
+{
+ private:
+/**
+ * @brief CacheTrimmer constructor - default.
+ *        Create() should be used instead to ensure the thread is started.
+ */
+CacheTrimmer(
+    void
+) noexcept(true) = default;
+
+ public:
+/**
+ * @brief Default destructor. Stops the trimmer.
+ */
+~CacheTrimmer(
+    void
+) noexcept(true)
+{
+    this->Stop();
+}
+
+/**
+ * @brief Copy and move semantics are deleted.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(CacheTrimmer, delete);
+
+/**
+ * @brief Signals the trimmer thread and waits for it to finish.
+ *        It is fine to call this multiple times.
+ *
+ * @return Nothing.
+ */
+void
+XPF_API
+Stop(
+    void
+) noexcept(true);
+
+/**
+ * @brief Gets the number of trims done so far.
+ *
+ * @return The number of periods which elapsed.
+ */
+inline uint32_t
+Passes(
+    void
+) const noexcept(true)
+{
+    return this->m_Passes;
+}
+
+/**
+ * @brief Gets the number of trims which found the caches over budget.
+ *
+ * @return The number of CacheTrimLevel::Full trims.
+ */
+inline uint32_t
+FullTrims(
+    void
+) const noexcept(true)
+{
+    return this->m_FullTrims;
+}
+
+/**
+ * @brief Create and start a CacheTrimmer. This must be used instead of constructor.
+ *
+ * @param[in, out] TrimmerToCreate - the trimmer to be created. On input it will be empty.
+ *                                   On output it will contain a running trimmer
+ *                                   or an empty one on fail.
+ *
+ * @param[in] MemoryBudget - How many bytes the caches may hold before everything is trimmed.
+ *                           0 means no budget - only the idle memory is trimmed.
+ *
+ * @param[in] PeriodInMilliseconds - How often the caches are checked. Can't be 0.
+ *
+ * @return A proper NTSTATUS error code on fail, or STATUS_SUCCESS if everything went good.
+ *
+ * @note The function has strong guarantees that on success TrimmerToCreate has a value
+ *       and on fail TrimmerToCreate does not have a value.
+ */
+_Must_inspect_result_
+static NTSTATUS
+XPF_API
+Create(
+    _Inout_ xpf::Optional<xpf::CacheTrimmer>* TrimmerToCreate,
+    _In_ size_t MemoryBudget,
+    _In_ uint32_t PeriodInMilliseconds
+) noexcept(true);
+
+ private:
+/**
+ * @brief The trimmer thread routine.
+ *
+ * @param[in] Context - The CacheTrimmer.
+ *
+ * @return Nothing.
+ */
+static void
+XPF_API
+TrimmerCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true);
+
+ private:
+    /**
+     * @brief   Set by Stop() to wake the trimmer thread.
+     */
+    xpf::Optional<xpf::Signal> m_StopSignal;
+
+    /**
+     * @brief   The thread which does the trimming.
+     */
+    xpf::thread::Thread m_Thread;
+
+    /**
+     * @brief   The budget for the cached memory. 0 means no budget.
+     */
+    size_t m_MemoryBudget = 0;
+
+    /**
+     * @brief   How often the caches are checked.
+     */
+    uint32_t m_PeriodInMilliseconds = 0;
+
+    /**
+     * @brief   The number of trims done so far.
+     */
+    alignas(uint32_t) volatile uint32_t m_Passes = 0;
+
+    /**
+     * @brief   The number of trims which found the caches over budget.
+     */
+    alignas(uint32_t) volatile uint32_t m_FullTrims = 0;
+
+    /**
+     * @brief   Default MemoryAllocator is our friend as it requires access to the private
+     *          default constructor. It is used in the Create() method to ensure that
+     *          no partially constructed objects are created but instead they will be
+     *          all fully initialized.
+     */
+     friend class xpf::MemoryAllocator;
+};  // class CacheTrimmer
+};  // namespace xpf
@@ -0,0 +1,689 @@
+﻿/**
+ * @file        xpf_lib/public/Multithreading/ParallelSort.hpp
+ *
+ * @brief       Sorts a vector using the threadpool workers.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
+#include "xpf_lib/public/core/Sort.hpp"
+
+#include "xpf_lib/public/Containers/Vector.hpp"
+#include "xpf_lib/public/Multithreading/Signal.hpp"
+#include "xpf_lib/public/Multithreading/ThreadPool.hpp"
+
+
+namespace xpf
+{
+
+/**
+ * @brief Vectors with fewer elements than this are sorted on the calling thread.
+ *        Below this size the cost of waking up the workers is higher than the gain.
+ */
+static constexpr size_t XPF_PARALLEL_SORT_THRESHOLD = 64 * 1024;
+
+/**
+ * @brief The maximum number of chunks the vector is split into.
+ *        It matches the maximum number of threads of the threadpool.
+ */
+static constexpr size_t XPF_PARALLEL_SORT_MAX_CHUNKS = 64;
+
+/**
+ * @brief   What the tasks of the current pass do.
+ */
+enum class ParallelSortPass
+{
+    /**
+     * @brief   Each task sorts one chunk in place.
+     */
+    SortChunks = 0,
+
+    /**
+     * @brief   Pairs of sorted runs are merged from Source into Destination.
+     *          Each task produces the part of the output which lies over one chunk,
+     *          starting from the split points found in LeftSplits.
+     */
+    MergeRuns = 1,
+
+    /**
+     * @brief   Each task moves one chunk from Source back into Destination.
+     */
+    MoveBack = 2,
+};
+
+/**
+ * @brief   The state shared by the calling thread and the threadpool workers during one pass.
+ *          The tasks are not stored anywhere - task i always works on the elements of chunk i,
+ *          so each of them can be computed from its index.
+ */
+template <class Type, class Predicate>
+struct ParallelSortPassContext
+{
+    /**
+     * @brief   The elements to be read. For SortChunks they are also written.
+     */
+    Type* Source = nullptr;
+
+    /**
+     * @brief   The elements to be written. Unused for SortChunks.
+     */
+    Type* Destination = nullptr;
+
+    /**
+     * @brief   If true, Destination is not yet constructed - the elements must be
+     *          move constructed rather than move assigned.
+     */
+    bool IsDestinationRaw = false;
+
+    /**
+     * @brief   What the tasks of this pass do.
+     */
+    xpf::ParallelSortPass Pass = xpf::ParallelSortPass::SortChunks;
+
+    /**
+     * @brief   For MergeRuns, the number of chunks in each of the runs being merged.
+     */
+    size_t ChunksPerRun = 0;
+
+    /**
+     * @brief   For MergeRuns, LeftSplits[i] is the number of elements of the left run of its pair
+     *          which go before the first element of chunk i in the merged output.
+     *          They are all found before the merge starts - the search reads elements
+     *          which the other tasks are about to move away.
+     */
+    size_t LeftSplits[XPF_PARALLEL_SORT_MAX_CHUNKS + 1] = { 0 };
+
+    /**
+     * @brief   The total number of elements.
+     */
+    size_t Count = 0;
+
+    /**
+     * @brief   The number of chunks - this is also the number of tasks in the pass.
+     */
+    size_t Chunks = 0;
+
+    /**
+     * @brief   The predicate. It is called concurrently from multiple threads.
+     */
+    Predicate* SortingPredicate = nullptr;
+};
+
+/**
+ * @brief   Hands out the tasks of one pass. The calling thread keeps the pass context on its stack,
+ *          but the work items can run long after the pass is over - for example when the pool is busy,
+ *          or when the caller is itself a pool worker. So the work items only get this ticket,
+ *          which is allocated for each pass and freed by whoever lets go of it last.
+ */
+template <class Type, class Predicate>
+struct ParallelSortPassTicket
+{
+    /**
+     * @brief   The pass context. It is valid only while a task is in progress -
+     *          the calling thread waits for all tasks to finish before moving on.
+     */
+    xpf::ParallelSortPassContext<Type, Predicate>* Context = nullptr;
+
+    /**
+     * @brief   The number of tasks in the pass. Copied here, as a late work item
+     *          must find out there is nothing left to do without touching the context.
+     */
+    size_t Tasks = 0;
+
+    /**
+     * @brief   The index of the next task to be picked up.
+     */
+    xpf::Atomic<size_t> NextTask;
+
+    /**
+     * @brief   The number of tasks which are done. The thread which finishes the last one sets the signal.
+     */
+    xpf::Atomic<size_t> FinishedTasks;
+
+    /**
+     * @brief   One reference for the calling thread and one for each enqueued work item.
+     */
+    xpf::Atomic<uint32_t> References;
+
+    /**
+     * @brief   Set when all tasks are done.
+     */
+    xpf::Optional<xpf::Signal> AllTasksFinished;
+};
+
+/**
+ * @brief       Gets the index of the first element of a chunk.
+ *              The remainder is spread over the first chunks, so they differ by at most one element.
+ *
+ * @param[in]   Count - The total number of elements.
+ *
+ * @param[in]   Chunks - The number of chunks.
+ *
+ * @param[in]   Chunk - The chunk index, in [0, Chunks].
+ *
+ * @return The index of the first element of the chunk, or Count for Chunk == Chunks.
+ */
+inline size_t
+ParallelSortChunkBegin(
+    _In_ size_t Count,
+    _In_ size_t Chunks,
+    _In_ size_t Chunk
+) noexcept(true)
+{
+    const size_t remainder = Count % Chunks;
+    return (Count / Chunks) * Chunk + ((Chunk < remainder) ? Chunk : remainder);
+}
+
+/**
+ * @brief       Finds the pair of runs merged over a chunk. The last run can be left without a pair -
+ *              then its right run is empty and the elements are just moved.
+ *
+ * @param[in]   Count - The total number of elements.
+ *
+ * @param[in]   Chunks - The number of chunks.
+ *
+ * @param[in]   ChunksPerRun - The number of chunks in each of the runs being merged.
+ *
+ * @param[in]   Chunk - The chunk index.
+ *
+ * @param[out]  RunBegin - The index of the first element of the left run.
+ *
+ * @param[out]  RunMiddle - The index of the first element of the right run.
+ *
+ * @param[out]  RunEnd - One past the index of the last element of the right run.
+ *
+ * @param[out]  LastChunk - One past the last chunk covered by the pair.
+ */
+inline void
+ParallelSortRunBounds(
+    _In_ size_t Count,
+    _In_ size_t Chunks,
+    _In_ size_t ChunksPerRun,
+    _In_ size_t Chunk,
+    _Out_ size_t* RunBegin,
+    _Out_ size_t* RunMiddle,
+    _Out_ size_t* RunEnd,
+    _Out_ size_t* LastChunk
+) noexcept(true)
+{
+    const size_t pairChunks = ChunksPerRun * 2;
+    const size_t firstChunk = (Chunk / pairChunks) * pairChunks;
+    const size_t middleChunk = (firstChunk + ChunksPerRun < Chunks) ? firstChunk + ChunksPerRun
+                                                                    : Chunks;
+    *LastChunk = (firstChunk + pairChunks < Chunks) ? firstChunk + pairChunks
+                                                    : Chunks;
+
+    *RunBegin = xpf::ParallelSortChunkBegin(Count, Chunks, firstChunk);
+    *RunMiddle = xpf::ParallelSortChunkBegin(Count, Chunks, middleChunk);
+    *RunEnd = xpf::ParallelSortChunkBegin(Count, Chunks, *LastChunk);
+}
+
+/**
+ * @brief       Finds how many of the first Rank elements of the merge of Left and Right come from Left.
+ *              On equal elements Left goes first, so the merge is stable.
+ *              See "Merge Path - A Visually Intuitive Approach to Parallel Merging" (Green et al., 2014).
+ *
+ * @param[in]   Left - The first sorted run.
+ *
+ * @param[in]   LeftSize - The number of elements in Left.
+ *
+ * @param[in]   Right - The second sorted run.
+ *
+ * @param[in]   RightSize - The number of elements in Right.
+ *
+ * @param[in]   Rank - The position in the merged output, in [0, LeftSize + RightSize].
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ *
+ * @return The number of elements taken from Left. The rest (Rank - result) come from Right.
+ */
+template <class Type, class Predicate>
+inline size_t
+ParallelSortCoRank(
+    _In_ const Type* Left,
+    _In_ size_t LeftSize,
+    _In_ const Type* Right,
+    _In_ size_t RightSize,
+    _In_ size_t Rank,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    size_t low = (Rank > RightSize) ? Rank - RightSize : 0;
+    size_t high = (Rank < LeftSize) ? Rank : LeftSize;
+
+    while (low < high)
+    {
+        const size_t fromLeft = low + (high - low) / 2;
+        const size_t fromRight = Rank - fromLeft;
+
+        //
+        // Left[fromLeft] goes before Right[fromRight - 1] - so it is among the first Rank elements.
+        //
+        if (!SortingPredicate(Right[fromRight - 1], Left[fromLeft]))
+        {
+            low = fromLeft + 1;
+        }
+        else
+        {
+            high = fromLeft;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief       Moves an element into the destination, constructing it if the destination is raw memory.
+ *
+ * @param[in,out] Destination - Where to put the element.
+ *
+ * @param[in,out] Source - The element to be moved.
+ *
+ * @param[in]   IsDestinationRaw - true if Destination is not constructed.
+ */
+template <class Type>
+inline void
+ParallelSortPlaceElement(
+    _Inout_ Type* Destination,
+    _Inout_ Type& Source,
+    _In_ bool IsDestinationRaw
+) noexcept(true)
+{
+    if (IsDestinationRaw)
+    {
+        ::new (Destination) Type(xpf::Move(Source));
+    }
+    else
+    {
+        *Destination = xpf::Move(Source);
+    }
+}
+
+/**
+ * @brief       Runs one task of the current pass.
+ *
+ * @param[in,out] Context - The pass context.
+ *
+ * @param[in]   Task - The task index, in [0, Context.Chunks).
+ */
+template <class Type, class Predicate>
+inline void
+ParallelSortRunTask(
+    _Inout_ xpf::ParallelSortPassContext<Type, Predicate>& Context,
+    _In_ size_t Task
+) noexcept(true)
+{
+    const size_t begin = xpf::ParallelSortChunkBegin(Context.Count, Context.Chunks, Task);
+    const size_t end = xpf::ParallelSortChunkBegin(Context.Count, Context.Chunks, Task + 1);
+
+    if (xpf::ParallelSortPass::SortChunks == Context.Pass)
+    {
+        xpf::AlgoSort(Context.Source + begin, end - begin, *Context.SortingPredicate);
+        return;
+    }
+    if (xpf::ParallelSortPass::MoveBack == Context.Pass)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            xpf::ParallelSortPlaceElement(&Context.Destination[i], Context.Source[i], Context.IsDestinationRaw);
+        }
+        return;
+    }
+
+    size_t runBegin = 0;
+    size_t runMiddle = 0;
+    size_t runEnd = 0;
+    size_t lastChunk = 0;
+    xpf::ParallelSortRunBounds(Context.Count, Context.Chunks, Context.ChunksPerRun, Task,
+                               &runBegin, &runMiddle, &runEnd, &lastChunk);
+
+    Type* left = Context.Source + runBegin;
+    Type* right = Context.Source + runMiddle;
+
+    //
+    // The task which ends the pair takes everything that is left.
+    //
+    size_t fromLeft = Context.LeftSplits[Task];
+    size_t fromRight = (begin - runBegin) - fromLeft;
+    const size_t lastFromLeft = (Task + 1 < lastChunk) ? Context.LeftSplits[Task + 1]
+                                                       : runMiddle - runBegin;
+    const size_t lastFromRight = (end - runBegin) - lastFromLeft;
+
+    Type* output = Context.Destination + begin;
+    while ((fromLeft < lastFromLeft) && (fromRight < lastFromRight))
+    {
+        if ((*Context.SortingPredicate)(right[fromRight], left[fromLeft]))
+        {
+            xpf::ParallelSortPlaceElement(output++, right[fromRight++], Context.IsDestinationRaw);
+        }
+        else
+        {
+            xpf::ParallelSortPlaceElement(output++, left[fromLeft++], Context.IsDestinationRaw);
+        }
+    }
+    while (fromLeft < lastFromLeft)
+    {
+        xpf::ParallelSortPlaceElement(output++, left[fromLeft++], Context.IsDestinationRaw);
+    }
+    while (fromRight < lastFromRight)
+    {
+        xpf::ParallelSortPlaceElement(output++, right[fromRight++], Context.IsDestinationRaw);
+    }
+}
+
+/**
+ * @brief       Picks up tasks of the current pass until there are none left.
+ *
+ * @param[in,out] Ticket - The pass ticket.
+ */
+template <class Type, class Predicate>
+inline void
+ParallelSortRunTasks(
+    _Inout_ xpf::ParallelSortPassTicket<Type, Predicate>& Ticket
+) noexcept(true)
+{
+    while (true)
+    {
+        const size_t task = Ticket.NextTask.FetchAdd(1, xpf::MemoryOrder::Relaxed);
+        if (task >= Ticket.Tasks)
+        {
+            break;
+        }
+        xpf::ParallelSortRunTask(*Ticket.Context, task);
+
+        //
+        // After the last task is done the calling thread can move on - so no more accesses to the context.
+        //
+        if (Ticket.FinishedTasks.FetchAdd(1) + 1 == Ticket.Tasks)
+        {
+            (*Ticket.AllTasksFinished).Set();
+        }
+    }
+}
+
+/**
+ * @brief       Drops a reference to the pass ticket. The last one frees it.
+ *
+ * @param[in,out] Ticket - The pass ticket.
+ */
+template <class Type, class Predicate>
+inline void
+ParallelSortReleaseTicket(
+    _Inout_ xpf::ParallelSortPassTicket<Type, Predicate>* Ticket
+) noexcept(true)
+{
+    if (1 == Ticket->References.FetchSub(1))
+    {
+        xpf::MemoryAllocator::Destruct(Ticket);
+        xpf::MemoryAllocator::FreeMemory(Ticket);
+    }
+}
+
+/**
+ * @brief       The work item enqueued on the threadpool. It helps the calling thread with the tasks.
+ *              If it runs after all tasks were picked up, it does nothing.
+ *
+ * @param[in]   Context - The ParallelSortPassTicket of the pass.
+ */
+template <class Type, class Predicate>
+inline void
+XPF_API
+ParallelSortWorkerCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto ticket = static_cast<xpf::ParallelSortPassTicket<Type, Predicate>*>(Context);
+    if (nullptr == ticket)
+    {
+        XPF_DEATH_ON_FAILURE(false);
+        return;
+    }
+
+    xpf::ParallelSortRunTasks(*ticket);
+    xpf::ParallelSortReleaseTicket(ticket);
+}
+
+/**
+ * @brief       The threadpool is running down - the calling thread does the tasks on its own.
+ *
+ * @param[in]   Context - The ParallelSortPassTicket of the pass.
+ */
+template <class Type, class Predicate>
+inline void
+XPF_API
+ParallelSortWorkerNotProcessedCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto ticket = static_cast<xpf::ParallelSortPassTicket<Type, Predicate>*>(Context);
+    if (nullptr == ticket)
+    {
+        XPF_DEATH_ON_FAILURE(false);
+        return;
+    }
+    xpf::ParallelSortReleaseTicket(ticket);
+}
+
+/**
+ * @brief       Runs all the tasks of a pass. The calling thread enqueues up to Chunks - 1 work items,
+ *              then picks up tasks itself - every task which no worker started yet.
+ *              So it never waits for a work item to be scheduled: this is what lets a pool worker
+ *              sort on its own pool. It only waits (on a signal) for the tasks the workers started.
+ *              If the ticket can't be allocated the calling thread does all the tasks.
+ *
+ * @param[in,out] Context - The pass context.
+ *
+ * @param[in,out] Pool - The threadpool.
+ */
+template <class Type, class Predicate>
+inline void
+ParallelSortRunPass(
+    _Inout_ xpf::ParallelSortPassContext<Type, Predicate>& Context,
+    _Inout_ xpf::ThreadPool& Pool
+) noexcept(true)
+{
+    using TicketType = xpf::ParallelSortPassTicket<Type, Predicate>;
+
+    TicketType* ticket = static_cast<TicketType*>(xpf::MemoryAllocator::AllocateMemory(sizeof(TicketType)));
+    if (nullptr != ticket)
+    {
+        xpf::MemoryAllocator::Construct(ticket);
+        if (!NT_SUCCESS(xpf::Signal::Create(&ticket->AllTasksFinished, true)))
+        {
+            xpf::MemoryAllocator::Destruct(ticket);
+            xpf::MemoryAllocator::FreeMemory(ticket);
+            ticket = nullptr;
+        }
+    }
+    if (nullptr == ticket)
+    {
+        for (size_t task = 0; task < Context.Chunks; ++task)
+        {
+            xpf::ParallelSortRunTask(Context, task);
+        }
+        return;
+    }
+
+    ticket->Context = xpf::AddressOf(Context);
+    ticket->Tasks = Context.Chunks;
+    ticket->References.Store(1, xpf::MemoryOrder::Relaxed);
+
+    for (size_t i = 1; i < Context.Chunks; ++i)
+    {
+        (void) ticket->References.FetchAdd(1, xpf::MemoryOrder::Relaxed);
+
+        const NTSTATUS status = Pool.Enqueue(&xpf::ParallelSortWorkerCallback<Type, Predicate>,
+                                             &xpf::ParallelSortWorkerNotProcessedCallback<Type, Predicate>,
+                                             ticket);
+        if (!NT_SUCCESS(status))
+        {
+            (void) ticket->References.FetchSub(1, xpf::MemoryOrder::Relaxed);
+            break;
+        }
+    }
+
+    xpf::ParallelSortRunTasks(*ticket);
+
+    //
+    // All tasks are picked up. Wait for the ones the workers are still running.
+    // The work items which did not start yet will find nothing to do.
+    //
+    if (ticket->FinishedTasks.Load() != ticket->Tasks)
+    {
+        (void) (*ticket->AllTasksFinished).Wait();
+    }
+    xpf::ParallelSortReleaseTicket(ticket);
+}
+
+/**
+ * @brief       Sorts the elements with the provided SortingPredicate using the threadpool workers.
+ *              This is an unstable sort.
+ *
+ *              The vector is split into equal chunks which are sorted in parallel with xpf::AlgoSort.
+ *              Then the sorted runs are merged pairwise, log2(chunks) times, into a scratch buffer
+ *              and back. Each merge is split over all the workers, not only over the pairs of runs:
+ *              every task produces the part of the output which lies over one chunk,
+ *              and finds where its inputs start with a binary search on the two runs.
+ *
+ *              The calling thread takes part in each pass and picks up every task no worker has started,
+ *              so the sort completes even if the threadpool is busy or running down, and it can be
+ *              called from a threadpool worker. It blocks (without spinning) only for the tasks
+ *              which the workers are running.
+ *
+ * @param[in,out] Elements - The vector to be sorted.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ *                                 It is called concurrently from multiple threads.
+ *
+ * @param[in,out] Pool - The threadpool providing the workers.
+ *
+ * @param[in]   Parallelism - The number of chunks the vector is split into. Capped to
+ *                            XPF_PARALLEL_SORT_MAX_CHUNKS. By default the number of processors.
+ *
+ * @return      STATUS_INSUFFICIENT_RESOURCES if the scratch buffer could not be allocated -
+ *              the vector is left unchanged. STATUS_SUCCESS otherwise.
+ *
+ * @note        Vectors smaller than XPF_PARALLEL_SORT_THRESHOLD, or a Parallelism of 1,
+ *              are sorted on the calling thread without allocating.
+ *              Otherwise a scratch buffer as large as the vector is allocated using its allocator.
+ */
+template <class Type, class Predicate>
+_Must_inspect_result_
+inline NTSTATUS
+ParallelSort(
+    _Inout_ xpf::Vector<Type>& Elements,
+    _In_ Predicate SortingPredicate,
+    _Inout_ xpf::ThreadPool& Pool,
+    _In_ size_t Parallelism = xpf::ApiNumberOfProcessors()
+) noexcept(true)
+{
+    XPF_MAX_PASSIVE_LEVEL();
+
+    const size_t count = Elements.Size();
+    const size_t chunks = (Parallelism < xpf::XPF_PARALLEL_SORT_MAX_CHUNKS) ? Parallelism
+                                                                            : xpf::XPF_PARALLEL_SORT_MAX_CHUNKS;
+    if ((count < xpf::XPF_PARALLEL_SORT_THRESHOLD) || (chunks <= 1))
+    {
+        Elements.Sort(SortingPredicate);
+        return STATUS_SUCCESS;
+    }
+
+    size_t scratchSize = 0;
+    if (!xpf::ApiNumbersSafeMul(count, sizeof(Type), &scratchSize))
+    {
+        return STATUS_INTEGER_OVERFLOW;
+    }
+
+    xpf::Buffer scratch{ Elements.GetAllocator() };
+    if (!NT_SUCCESS(scratch.Resize(scratchSize)))
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    xpf::ParallelSortPassContext<Type, Predicate> context;
+    context.Source = &Elements[0];
+    context.Count = count;
+    context.Chunks = chunks;
+    context.SortingPredicate = xpf::AddressOf(SortingPredicate);
+
+    //
+    // First sort each chunk in place.
+    //
+    context.Pass = xpf::ParallelSortPass::SortChunks;
+    xpf::ParallelSortRunPass(context, Pool);
+
+    //
+    // Then merge the runs, going back and forth between the vector and the scratch buffer.
+    // The scratch buffer is raw memory until the first merge constructs its elements.
+    //
+    Type* vectorElements = &Elements[0];
+    Type* scratchElements = static_cast<Type*>(scratch.GetBuffer());
+    bool isScratchRaw = true;
+
+    context.Pass = xpf::ParallelSortPass::MergeRuns;
+    for (size_t chunksPerRun = 1; chunksPerRun < chunks; chunksPerRun = chunksPerRun * 2)
+    {
+        const bool isInVector = (context.Source == vectorElements);
+
+        context.ChunksPerRun = chunksPerRun;
+        context.Destination = isInVector ? scratchElements : vectorElements;
+        context.IsDestinationRaw = isInVector && isScratchRaw;
+
+        //
+        // A few binary searches per chunk - cheap enough to be done here.
+        //
+        for (size_t chunk = 0; chunk < chunks; ++chunk)
+        {
+            size_t runBegin = 0;
+            size_t runMiddle = 0;
+            size_t runEnd = 0;
+            size_t lastChunk = 0;
+            xpf::ParallelSortRunBounds(count, chunks, chunksPerRun, chunk,
+                                       &runBegin, &runMiddle, &runEnd, &lastChunk);
+
+            const size_t rank = xpf::ParallelSortChunkBegin(count, chunks, chunk) - runBegin;
+
+            context.LeftSplits[chunk] = xpf::ParallelSortCoRank(context.Source + runBegin,
+                                                                runMiddle - runBegin,
+                                                                context.Source + runMiddle,
+                                                                runEnd - runMiddle,
+                                                                rank,
+                                                                SortingPredicate);
+        }
+        xpf::ParallelSortRunPass(context, Pool);
+
+        isScratchRaw = false;
+        context.Source = context.Destination;
+    }
+
+    //
+    // The result might have ended in the scratch buffer.
+    //
+    if (context.Source != vectorElements)
+    {
+        context.Pass = xpf::ParallelSortPass::MoveBack;
+        context.Destination = vectorElements;
+        context.IsDestinationRaw = false;
+        xpf::ParallelSortRunPass(context, Pool);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        xpf::MemoryAllocator::Destruct(&scratchElements[i]);
+    }
+    return STATUS_SUCCESS;
+}
+};  // namespace xpf
@@ -23,8 +23,10 @@
 #include "xpf_lib/public/core/Core.hpp"
 #include "xpf_lib/public/core/TypeTraits.hpp"
 #include "xpf_lib/public/core/PlatformApi.hpp"
+#include "xpf_lib/public/core/Atomic.hpp"
 
 #include "xpf_lib/public/Memory/Optional.hpp"
+#include "xpf_lib/public/Memory/CacheAligned.hpp"
 #include "xpf_lib/public/Multithreading/Signal.hpp"
 
 
@@ -99,8 +101,9 @@ WaitForRelease(
      * @brief    Because we are using atomic intrinsics, this value need to be properly aligned.
      *           The rightmost bit will be used to mark that the rundown is active => no further access is allowed.
      *           The other 63 bits will be used to count the access.
+     *           Every Acquire and Release writes it, so it gets cache lines of its own.
      */
-    alignas(uint64_t) volatile uint64_t m_Rundown = 0;
+    xpf::CacheAligned<xpf::Atomic<uint64_t>> m_Rundown;
 
     /**
      * @brief   The parity bit is the rundown bit. Reserved.
@@ -26,7 +26,7 @@
 #include "xpf_lib/public/Locks/ReadWriteLock.hpp"
 #include "xpf_lib/public/Containers/TwoLockQueue.hpp"
 #include "xpf_lib/public/Containers/Vector.hpp"
-#include "xpf_lib/public/Memory/LookasideListAllocator.hpp"
+#include "xpf_lib/public/Memory/ObjectPool.hpp"
 #include "xpf_lib/public/Memory/SharedPointer.hpp"
 
 
@@ -36,10 +36,10 @@ namespace xpf
 /**
  * @brief   The allocations performed by the thread pool need to be non paged on windows kernel, as the threadpool
  *          is required to run at dispatch level as well. We define a separated allocator which will point to the
- *          critical memory allocator.
+ *          critical memory allocator. The blocks are cache line aligned, so the contexts of different
+ *          worker threads never share a cache line.
  */
-#define XPF_THREADPOOL_ALLOCATOR  xpf::PolymorphicAllocator{ .AllocFunction = &xpf::CriticalMemoryAllocator::AllocateMemory,     \
-                                                             .FreeFunction  = &xpf::CriticalMemoryAllocator::FreeMemory }
+#define XPF_THREADPOOL_ALLOCATOR  xpf::AlignedMemoryAllocator<XPF_CACHE_LINE_SIZE, true>::GetAllocator()
 
 /**
  * @brief   Forward definition.
@@ -119,9 +119,13 @@ class ThreadPool final
  */
 ThreadPool(
     void
-) noexcept(true) : m_WorkItemAllocator(sizeof(ThreadPoolWorkItem), true)
+) noexcept(true) : m_WorkItemPool(nullptr, true, true)
 {
-    XPF_NOTHING();
+    //
+    // The work item pool lives as long as the threadpool does,
+    // so let the cache trimmer reclaim what it keeps around.
+    //
+    this->m_WorkItemPool.JoinCacheRegistry();
 }
 
  public:
@@ -176,6 +180,23 @@ Rundown(
     void
 ) noexcept(true);
 
+/**
+ * @brief Spawns threads until the threadpool has at least NumberOfThreads.
+ *        The threadpool grows on its own under a heavy workload, but callers
+ *        which split their work in a known number of parts can ask for the threads upfront.
+ *
+ * @param[in] NumberOfThreads - The minimum number of threads. Can't exceed MAX_THREAD_QUOTA.
+ *
+ * @return STATUS_SUCCESS if the threadpool has at least NumberOfThreads,
+ *         a proper NTSTATUS error code if not.
+ */
+_Must_inspect_result_
+NTSTATUS
+XPF_API
+Grow(
+    _In_ size_t NumberOfThreads
+) noexcept(true);
+
 /**
  * @brief Create and initialize a ThreadPool. This must be used instead of constructor.
  *        It ensures the ThreadPool is not partially initialized.
@@ -302,10 +323,12 @@ ThreadPoolProcessWorkItems(
       */
      xpf::RundownProtection m_ThreadpoolRundown;
      /**
-      * @brief   We'll use a lookaside list memory allocator to construct the work items.
-      *          They all have the same size and they are the perfect match.
+      * @brief   We'll use an object pool to construct the work items.
+      *          They all have the same type and they are the perfect match.
+      *          No reset hook - the per-cpu cache scales better than a shared stack
+      *          of constructed items, and the items are cheap to construct.
       */
-     xpf::LookasideListAllocator m_WorkItemAllocator;
+     xpf::ObjectPool<ThreadPoolWorkItem> m_WorkItemPool;
      /**
       * @brief  This will be the currently available list of threads.
       *         This won't exceed MAX_THREAD_QUOTA.
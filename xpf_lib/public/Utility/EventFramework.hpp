@@ -25,6 +25,7 @@
 #include "xpf_lib/public/Multithreading/ThreadPool.hpp"
 
 #include "xpf_lib/public/Memory/SharedPointer.hpp"
+#include "xpf_lib/public/Memory/AtomicSharedPointer.hpp"
 #include "xpf_lib/public/Containers/Vector.hpp"
 
 
@@ -284,7 +285,7 @@ NotifyListeners(
 
 /**
  * @brief This method is used to clone the current listeners.
- *        This is helpful for Register / Unregister so we won't hold the busy lock during dispatch.
+ *        This is helpful for Register / Unregister so the dispatch does not take any lock.
  * 
  *
  * @return a Clone of the currently registered listeners.
@@ -307,15 +308,16 @@ CloneListeners(
 
     /**
      * @brief       This list stores the details about all registered listeners.
-     *              This is a shared pointer<vector> as we want the event framework
-     *              to have a minimal-scope lock.
+     *              This is an atomic shared pointer<vector> so the dispatch
+     *              can grab a snapshot without taking any lock.
      *              During register and unregister we'll clone the vector and replace it,
      *              so the in-progress listeners will consume events with the old list,
      *              and won't be affected.
      */
-     xpf::SharedPointer<ListenersList> m_Listeners{ XPF_EVENT_FRAMEWORK_ALLOCATOR };
+     xpf::AtomicSharedPointer<ListenersList> m_Listeners;
      /**
-      * @brief  This will guard the access to the m_Listeners. 
+      * @brief  This will serialize the updates of m_Listeners (clone and replace).
+      *         Readers don't take it.
       */
      xpf::BusyLock m_ListenersLock;
 
@@ -15,6 +15,7 @@
 
 
 #include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
 
 
 namespace xpf
@@ -205,4 +206,52 @@ AlgoAddToPointer(
 
     return pointer;
 }
+
+/**
+ * @brief Swaps two elements using their move semantics.
+ *
+ * @param[in,out] Left - The first element.
+ *
+ * @param[in,out] Right - The second element.
+ */
+template <class Type>
+inline void
+AlgoSwap(
+    _Inout_ Type& Left,
+    _Inout_ Type& Right
+) noexcept(true)
+{
+    Type temp{ xpf::Move(Left) };
+    Left = xpf::Move(Right);
+    Right = xpf::Move(temp);
+}
+
+/**
+ * @brief Counts the trailing zero bits of a value.
+ *
+ * @param[in] Value - The value to be inspected. Must not be 0.
+ *
+ * @return The index of the least significant bit which is set.
+ */
+inline uint32_t
+AlgoCountTrailingZeros(
+    _In_ uint64_t Value
+) noexcept(true)
+{
+    #if defined XPF_COMPILER_MSVC && (defined _M_X64 || defined _M_ARM64)
+        unsigned long index = 0;
+        (void) _BitScanForward64(&index, Value);
+        return static_cast<uint32_t>(index);
+    #elif defined XPF_COMPILER_MSVC
+        unsigned long index = 0;
+        if (_BitScanForward(&index, static_cast<unsigned long>(Value)))
+        {
+            return static_cast<uint32_t>(index);
+        }
+        (void) _BitScanForward(&index, static_cast<unsigned long>(Value >> 32));
+        return static_cast<uint32_t>(index) + 32;
+    #else
+        return static_cast<uint32_t>(__builtin_ctzll(Value));
+    #endif
+}
 };  // namespace xpf
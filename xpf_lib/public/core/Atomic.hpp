@@ -0,0 +1,905 @@
+﻿/**
+ * @file        xpf_lib/public/core/Atomic.hpp
+ *
+ * @brief       This contains atomic operations with explicit memory ordering,
+ *              and the xpf::Atomic class - similar with std::atomic.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+
+namespace xpf
+{
+/**
+ * @brief The memory ordering of an atomic operation. Same meaning as std::memory_order.
+ *
+ * @note  The interlocked operations on MSVC are full barriers,
+ *        so there a weaker order on a read-modify-write behaves like SequentiallyConsistent.
+ *        Loads and stores are plain accesses with the needed compiler barriers.
+ */
+enum class MemoryOrder : uint32_t
+{
+    /**
+     * @brief   Only atomicity is guaranteed. Good for counters and polling.
+     */
+    Relaxed = 0,
+
+    /**
+     * @brief   No reads or writes after the operation can be moved before it.
+     */
+    Acquire = 1,
+
+    /**
+     * @brief   No reads or writes before the operation can be moved after it.
+     */
+    Release = 2,
+
+    /**
+     * @brief   Both Acquire and Release.
+     */
+    AcquireRelease = 3,
+
+    /**
+     * @brief   Acquire and Release, plus a single total order of all such operations.
+     */
+    SequentiallyConsistent = 4,
+};  // enum class MemoryOrder
+
+/**
+ * @brief Checks at compile time that the type is supported by the atomic operations below.
+ *
+ * @return true if the type is an integer supported by the atomic operations.
+ */
+template <class Type>
+inline constexpr bool
+ApiAtomicIsSupportedType(
+    void
+) noexcept(true)
+{
+    return xpf::IsSameType<Type, uint8_t>  || xpf::IsSameType<Type, int8_t>    ||
+           xpf::IsSameType<Type, uint16_t> || xpf::IsSameType<Type, int16_t>   ||
+           xpf::IsSameType<Type, uint32_t> || xpf::IsSameType<Type, int32_t>   ||
+           xpf::IsSameType<Type, uint64_t> || xpf::IsSameType<Type, int64_t>;
+}
+
+#if defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+/**
+ * @brief Converts the memory order to the one used by the compiler builtins.
+ *
+ * @param[in] Order - The memory order to be converted.
+ *
+ * @return The equivalent __ATOMIC_* value.
+ */
+inline constexpr int
+ApiAtomicBuiltinOrder(
+    _In_ xpf::MemoryOrder Order
+) noexcept(true)
+{
+    switch (Order)
+    {
+        case xpf::MemoryOrder::Relaxed:
+            return __ATOMIC_RELAXED;
+        case xpf::MemoryOrder::Acquire:
+            return __ATOMIC_ACQUIRE;
+        case xpf::MemoryOrder::Release:
+            return __ATOMIC_RELEASE;
+        case xpf::MemoryOrder::AcquireRelease:
+            return __ATOMIC_ACQ_REL;
+        default:
+            return __ATOMIC_SEQ_CST;
+    }
+}
+#endif  // XPF_COMPILER_GCC || XPF_COMPILER_CLANG
+
+#if defined XPF_COMPILER_MSVC
+/**
+ * @brief Tells whether a plain volatile access to Type may be split in two.
+ *        On 32-bit x86 a 64-bit read or write compiles to two 32-bit moves,
+ *        so another processor could see half of a write. Such types go through
+ *        __iso_volatile_load64 / __iso_volatile_store64, which are single moves.
+ *
+ * @return true if Type needs the 64-bit intrinsics.
+ */
+template <class Type>
+constexpr inline bool
+ApiAtomicIsPlainAccessTorn(
+    void
+) noexcept(true)
+{
+    #if defined _M_IX86
+        return sizeof(Type) == sizeof(__int64);
+    #else
+        return false;
+    #endif
+}
+#endif  // XPF_COMPILER_MSVC
+
+/**
+ * @brief Issues a memory fence with the given order.
+ *
+ * @param[in] Order - The memory order of the fence.
+ *
+ * @return Nothing.
+ */
+inline void
+ApiAtomicThreadFence(
+    _In_ xpf::MemoryOrder Order
+) noexcept(true)
+{
+    #if defined XPF_COMPILER_MSVC
+        if (xpf::MemoryOrder::SequentiallyConsistent == Order)
+        {
+            MemoryBarrier();
+        }
+        else if (xpf::MemoryOrder::Relaxed != Order)
+        {
+            _ReadWriteBarrier();
+            #if defined _M_ARM64
+                __dmb(_ARM64_BARRIER_ISH);
+            #endif
+        }
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        __atomic_thread_fence(xpf::ApiAtomicBuiltinOrder(Order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically reads a value. Unlike a compare-exchange, this does not
+ *        take the cache line in exclusive mode, so polling loops don't slow down the writers.
+ *
+ * @param[in] Source - The value to be read. Must be naturally aligned.
+ *
+ * @param[in] Order - Relaxed, Acquire or SequentiallyConsistent.
+ *                    A release part has no meaning for a load, so it is ignored.
+ *
+ * @return The current value.
+ */
+template <class Type>
+inline Type
+ApiAtomicLoad(
+    _In_ const volatile Type* Source,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Source),
+                                                  alignof(Type)));
+
+    const xpf::MemoryOrder order = (xpf::MemoryOrder::Release == Order)         ? xpf::MemoryOrder::Relaxed
+                                 : (xpf::MemoryOrder::AcquireRelease == Order)  ? xpf::MemoryOrder::Acquire
+                                                                                : Order;
+    #if defined XPF_COMPILER_MSVC
+        Type value{};
+        if constexpr (xpf::ApiAtomicIsPlainAccessTorn<Type>())
+        {
+            value = static_cast<Type>(__iso_volatile_load64(reinterpret_cast<const volatile __int64*>(Source)));         // NOLINT(*)
+        }
+        else
+        {
+            value = *Source;
+        }
+        xpf::ApiAtomicThreadFence((xpf::MemoryOrder::Relaxed == order) ? xpf::MemoryOrder::Relaxed
+                                                                      : xpf::MemoryOrder::Acquire);
+        return value;
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        return __atomic_load_n(Source, xpf::ApiAtomicBuiltinOrder(order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically reads a pointer - for example one published with a compare-exchange.
+ *        An acquire load makes the writes done before the publication visible
+ *        before the pointed object is used.
+ *
+ * @param[in] Source - The pointer to be read. Must be naturally aligned.
+ *
+ * @param[in] Order - Relaxed, Acquire or SequentiallyConsistent.
+ *                    A release part has no meaning for a load, so it is ignored.
+ *
+ * @return The current pointer.
+ */
+template <class Type>
+inline Type*
+ApiAtomicLoad(
+    _In_ Type* const volatile* Source,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Source),
+                                                  alignof(Type*)));
+
+    const xpf::MemoryOrder order = (xpf::MemoryOrder::Release == Order)         ? xpf::MemoryOrder::Relaxed
+                                 : (xpf::MemoryOrder::AcquireRelease == Order)  ? xpf::MemoryOrder::Acquire
+                                                                                : Order;
+    #if defined XPF_COMPILER_MSVC
+        /* A pointer is one machine word - a volatile read of it is never split. */
+        Type* value = *Source;
+        xpf::ApiAtomicThreadFence((xpf::MemoryOrder::Relaxed == order) ? xpf::MemoryOrder::Relaxed
+                                                                      : xpf::MemoryOrder::Acquire);
+        return value;
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        return __atomic_load_n(Source, xpf::ApiAtomicBuiltinOrder(order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically replaces a value.
+ *
+ * @param[in,out] Destination - The value to be replaced. Must be naturally aligned.
+ *
+ * @param[in] Value - The new value.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+template <class Type>
+inline Type
+ApiAtomicExchange(
+    _Inout_ volatile Type* Destination,
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                  alignof(Type)));
+
+    #if defined XPF_COMPILER_MSVC
+        XPF_UNREFERENCED_PARAMETER(Order);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        if constexpr (sizeof(Type) == sizeof(char))
+        {
+            return static_cast<Type>(InterlockedExchange8(static_cast<volatile char*>(destination),                                 // NOLINT(*)
+                                                          static_cast<char>(Value)));                                               // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(short))
+        {
+            return static_cast<Type>(InterlockedExchange16(static_cast<volatile short*>(destination),                               // NOLINT(*)
+                                                           static_cast<short>(Value)));                                             // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(LONG))
+        {
+            return static_cast<Type>(InterlockedExchange(static_cast<volatile LONG*>(destination),                                  // NOLINT(*)
+                                                         static_cast<LONG>(Value)));                                                // NOLINT(*)
+        }
+        else
+        {
+            return static_cast<Type>(InterlockedExchange64(static_cast<volatile LONG64*>(destination),                              // NOLINT(*)
+                                                           static_cast<LONG64>(Value)));                                            // NOLINT(*)
+        }
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        return __atomic_exchange_n(Destination, Value, xpf::ApiAtomicBuiltinOrder(Order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically writes a value.
+ *
+ * @param[in,out] Destination - The value to be written. Must be naturally aligned.
+ *
+ * @param[in] Value - The new value.
+ *
+ * @param[in] Order - Relaxed, Release or SequentiallyConsistent.
+ *                    An acquire part has no meaning for a store, so it is ignored.
+ *
+ * @return Nothing.
+ */
+template <class Type>
+inline void
+ApiAtomicStore(
+    _Inout_ volatile Type* Destination,
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                  alignof(Type)));
+
+    const xpf::MemoryOrder order = (xpf::MemoryOrder::Acquire == Order)         ? xpf::MemoryOrder::Relaxed
+                                 : (xpf::MemoryOrder::AcquireRelease == Order)  ? xpf::MemoryOrder::Release
+                                                                                : Order;
+    #if defined XPF_COMPILER_MSVC
+        if (xpf::MemoryOrder::SequentiallyConsistent == order)
+        {
+            (void) xpf::ApiAtomicExchange(Destination, Value, order);
+            return;
+        }
+        xpf::ApiAtomicThreadFence((xpf::MemoryOrder::Relaxed == order) ? xpf::MemoryOrder::Relaxed
+                                                                      : xpf::MemoryOrder::Release);
+        if constexpr (xpf::ApiAtomicIsPlainAccessTorn<Type>())
+        {
+            __iso_volatile_store64(reinterpret_cast<volatile __int64*>(Destination),                                     // NOLINT(*)
+                                   static_cast<__int64>(Value));                                                          // NOLINT(*)
+        }
+        else
+        {
+            *Destination = Value;
+        }
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        __atomic_store_n(Destination, Value, xpf::ApiAtomicBuiltinOrder(order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically adds to a value.
+ *
+ * @param[in,out] Destination - The value to be increased. Must be naturally aligned.
+ *
+ * @param[in] Value - How much to add. Wraps around on overflow.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+template <class Type>
+inline Type
+ApiAtomicFetchAdd(
+    _Inout_ volatile Type* Destination,
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                  alignof(Type)));
+
+    #if defined XPF_COMPILER_MSVC
+        XPF_UNREFERENCED_PARAMETER(Order);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        if constexpr (sizeof(Type) == sizeof(char))
+        {
+            return static_cast<Type>(_InterlockedExchangeAdd8(static_cast<volatile char*>(destination),                             // NOLINT(*)
+                                                              static_cast<char>(Value)));                                           // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(short))
+        {
+            return static_cast<Type>(_InterlockedExchangeAdd16(static_cast<volatile short*>(destination),                           // NOLINT(*)
+                                                               static_cast<short>(Value)));                                         // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(LONG))
+        {
+            return static_cast<Type>(InterlockedExchangeAdd(static_cast<volatile LONG*>(destination),                               // NOLINT(*)
+                                                            static_cast<LONG>(Value)));                                             // NOLINT(*)
+        }
+        else
+        {
+            return static_cast<Type>(InterlockedExchangeAdd64(static_cast<volatile LONG64*>(destination),                           // NOLINT(*)
+                                                              static_cast<LONG64>(Value)));                                         // NOLINT(*)
+        }
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        return __atomic_fetch_add(Destination, Value, xpf::ApiAtomicBuiltinOrder(Order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically subtracts from a value.
+ *
+ * @param[in,out] Destination - The value to be decreased. Must be naturally aligned.
+ *
+ * @param[in] Value - How much to subtract. Wraps around on underflow.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+template <class Type>
+inline Type
+ApiAtomicFetchSub(
+    _Inout_ volatile Type* Destination,
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    //
+    // Two's complement - subtracting is adding the negated value.
+    //
+    return xpf::ApiAtomicFetchAdd(Destination, static_cast<Type>(Type{ 0 } - Value), Order);
+}
+
+/**
+ * @brief Atomically does a bitwise or on a value.
+ *
+ * @param[in,out] Destination - The value to be updated. Must be naturally aligned.
+ *
+ * @param[in] Value - The bits to be set.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+template <class Type>
+inline Type
+ApiAtomicFetchOr(
+    _Inout_ volatile Type* Destination,
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                  alignof(Type)));
+
+    #if defined XPF_COMPILER_MSVC
+        XPF_UNREFERENCED_PARAMETER(Order);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        if constexpr (sizeof(Type) == sizeof(char))
+        {
+            return static_cast<Type>(_InterlockedOr8(static_cast<volatile char*>(destination),                                      // NOLINT(*)
+                                                     static_cast<char>(Value)));                                                    // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(short))
+        {
+            return static_cast<Type>(_InterlockedOr16(static_cast<volatile short*>(destination),                                    // NOLINT(*)
+                                                      static_cast<short>(Value)));                                                  // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(LONG))
+        {
+            return static_cast<Type>(InterlockedOr(static_cast<volatile LONG*>(destination),                                        // NOLINT(*)
+                                                   static_cast<LONG>(Value)));                                                      // NOLINT(*)
+        }
+        else
+        {
+            return static_cast<Type>(InterlockedOr64(static_cast<volatile LONG64*>(destination),                                    // NOLINT(*)
+                                                     static_cast<LONG64>(Value)));                                                  // NOLINT(*)
+        }
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        return __atomic_fetch_or(Destination, Value, xpf::ApiAtomicBuiltinOrder(Order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically does a bitwise and on a value.
+ *
+ * @param[in,out] Destination - The value to be updated. Must be naturally aligned.
+ *
+ * @param[in] Value - The bits to be kept.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+template <class Type>
+inline Type
+ApiAtomicFetchAnd(
+    _Inout_ volatile Type* Destination,
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                  alignof(Type)));
+
+    #if defined XPF_COMPILER_MSVC
+        XPF_UNREFERENCED_PARAMETER(Order);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        if constexpr (sizeof(Type) == sizeof(char))
+        {
+            return static_cast<Type>(_InterlockedAnd8(static_cast<volatile char*>(destination),                                     // NOLINT(*)
+                                                      static_cast<char>(Value)));                                                   // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(short))
+        {
+            return static_cast<Type>(_InterlockedAnd16(static_cast<volatile short*>(destination),                                   // NOLINT(*)
+                                                       static_cast<short>(Value)));                                                 // NOLINT(*)
+        }
+        else if constexpr (sizeof(Type) == sizeof(LONG))
+        {
+            return static_cast<Type>(InterlockedAnd(static_cast<volatile LONG*>(destination),                                       // NOLINT(*)
+                                                    static_cast<LONG>(Value)));                                                     // NOLINT(*)
+        }
+        else
+        {
+            return static_cast<Type>(InterlockedAnd64(static_cast<volatile LONG64*>(destination),                                   // NOLINT(*)
+                                                      static_cast<LONG64>(Value)));                                                 // NOLINT(*)
+        }
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        return __atomic_fetch_and(Destination, Value, xpf::ApiAtomicBuiltinOrder(Order));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Atomically replaces a value if it is equal to the expected one.
+ *
+ * @param[in,out] Destination - The value to be replaced. Must be naturally aligned.
+ *
+ * @param[in,out] Expected - The value Destination should have.
+ *                           On failure it receives the current value, so loops don't have to read it again.
+ *
+ * @param[in] Desired - The new value.
+ *
+ * @param[in] Order - The memory order on success. On failure the order is the same without the release part.
+ *
+ * @return true if the value was replaced, false otherwise.
+ */
+template <class Type>
+inline bool
+ApiAtomicTryCompareExchange(
+    _Inout_ volatile Type* Destination,
+    _Inout_ Type& Expected,
+    _In_ Type Desired,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+
+    #if defined XPF_COMPILER_MSVC
+        XPF_UNREFERENCED_PARAMETER(Order);
+        const Type previous = xpf::ApiAtomicCompareExchange(Destination, Desired, Expected);
+        if (previous == Expected)
+        {
+            return true;
+        }
+        Expected = previous;
+        return false;
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                      alignof(Type)));
+
+        const xpf::MemoryOrder failureOrder = (xpf::MemoryOrder::Release == Order)         ? xpf::MemoryOrder::Relaxed
+                                            : (xpf::MemoryOrder::AcquireRelease == Order)  ? xpf::MemoryOrder::Acquire
+                                                                                           : Order;
+        return __atomic_compare_exchange_n(Destination,
+                                           &Expected,
+                                           Desired,
+                                           false,
+                                           xpf::ApiAtomicBuiltinOrder(Order),
+                                           xpf::ApiAtomicBuiltinOrder(failureOrder));
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+/**
+ * @brief Two machine words which are compared and exchanged together, with a single
+ *        double-width atomic operation (cmpxchg16b / casp on 64-bit platforms).
+ *        Aligned to its size, which is what the hardware requires.
+ */
+struct alignas(2 * sizeof(size_t)) AtomicWordPair
+{
+    /**
+     * @brief The first word.
+     */
+    size_t Low = 0;
+
+    /**
+     * @brief The second word.
+     */
+    size_t High = 0;
+};  // struct AtomicWordPair
+
+/**
+ * @brief Reads a pair of words. The two words are read one after the other (sequentially
+ *        consistent), so the result might be torn - the low word from one value, the high word
+ *        from the next one. This is fine for compare-exchange loops: a torn value fails the exchange.
+ *
+ * @param[in] Source - The pair to be read.
+ *
+ * @return The (possibly torn) value.
+ */
+inline xpf::AtomicWordPair
+ApiAtomicLoadPair(
+    _In_ const volatile xpf::AtomicWordPair* Source
+) noexcept(true)
+{
+    xpf::AtomicWordPair value;
+    value.High = xpf::ApiAtomicLoad(&Source->High);
+    value.Low = xpf::ApiAtomicLoad(&Source->Low);
+    return value;
+}
+
+/**
+ * @brief Atomically replaces a pair of words if it is equal to the expected one.
+ *        This is a full barrier on all platforms.
+ *
+ * @param[in,out] Destination - The pair to be replaced.
+ *
+ * @param[in,out] Expected - The value Destination should have.
+ *                           On failure it receives the current value.
+ *
+ * @param[in] Desired - The new value.
+ *
+ * @return true if the value was replaced, false otherwise.
+ */
+inline bool
+ApiAtomicTryCompareExchangePair(
+    _Inout_ volatile xpf::AtomicWordPair* Destination,
+    _Inout_ xpf::AtomicWordPair& Expected,
+    _In_ _Const_ const xpf::AtomicWordPair& Desired
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(Destination),
+                                                  alignof(xpf::AtomicWordPair)));
+
+    #if defined XPF_COMPILER_MSVC && (defined _M_X64 || defined _M_ARM64)
+        __int64 comparand[2] = { static_cast<__int64>(Expected.Low), static_cast<__int64>(Expected.High) };     // NOLINT(*)
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        const bool isExchanged = 0 != _InterlockedCompareExchange128(static_cast<volatile __int64*>(destination),   // NOLINT(*)
+                                                                     static_cast<__int64>(Desired.High),              // NOLINT(*)
+                                                                     static_cast<__int64>(Desired.Low),               // NOLINT(*)
+                                                                     comparand);
+        Expected.Low = static_cast<size_t>(comparand[0]);
+        Expected.High = static_cast<size_t>(comparand[1]);
+        return isExchanged;
+    #elif defined XPF_COMPILER_MSVC
+        /* On 32-bit platforms the pair fits in a 64-bit compare-exchange. */
+        const uint64_t expected = uint64_t{ Expected.Low } | (uint64_t{ Expected.High } << 32);
+        const uint64_t desired = uint64_t{ Desired.Low } | (uint64_t{ Desired.High } << 32);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        const uint64_t previous = xpf::ApiAtomicCompareExchange(static_cast<volatile uint64_t*>(destination),
+                                                                desired,
+                                                                expected);
+        Expected.Low = static_cast<size_t>(previous & 0xFFFFFFFF);
+        Expected.High = static_cast<size_t>(previous >> 32);
+        return previous == expected;
+    #elif (defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG) && defined __x86_64__
+        /* Spelled out, so the library doesn't need -mcx16 or libatomic. */
+        bool isExchanged = false;
+        __asm__ __volatile__("lock cmpxchg16b %1"
+                             : "=@ccz" (isExchanged),
+                               "+m" (*Destination),
+                               "+a" (Expected.Low),
+                               "+d" (Expected.High)
+                             : "b" (Desired.Low),
+                               "c" (Desired.High)
+                             : "memory");
+        return isExchanged;
+    #elif (defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG) && defined __aarch64__
+        __extension__ typedef unsigned __int128 XpfWordPairValue;
+
+        const XpfWordPairValue expected = XpfWordPairValue{ Expected.Low } | (XpfWordPairValue{ Expected.High } << 64);
+        const XpfWordPairValue desired = XpfWordPairValue{ Desired.Low } | (XpfWordPairValue{ Desired.High } << 64);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        const XpfWordPairValue previous = __sync_val_compare_and_swap(static_cast<volatile XpfWordPairValue*>(destination),
+                                                                      expected,
+                                                                      desired);
+        Expected.Low = static_cast<size_t>(previous);
+        Expected.High = static_cast<size_t>(previous >> 64);
+        return previous == expected;
+    #elif defined XPF_COMPILER_GCC || defined XPF_COMPILER_CLANG
+        static_assert(sizeof(size_t) == sizeof(uint32_t), "Unsupported platform!");
+
+        uint64_t expected = uint64_t{ Expected.Low } | (uint64_t{ Expected.High } << 32);
+        const uint64_t desired = uint64_t{ Desired.Low } | (uint64_t{ Desired.High } << 32);
+        volatile void* destination = static_cast<volatile void*>(Destination);
+
+        const bool isExchanged = xpf::ApiAtomicTryCompareExchange(static_cast<volatile uint64_t*>(destination),
+                                                                  expected,
+                                                                  desired);
+        Expected.Low = static_cast<size_t>(expected & 0xFFFFFFFF);
+        Expected.High = static_cast<size_t>(expected >> 32);
+        return isExchanged;
+    #else
+        #error Unknown Compiler
+    #endif
+}
+
+//
+// ************************************************************************************************
+// This is the section containing the atomic class.
+// ************************************************************************************************
+//
+
+/**
+ * @brief This is a value which is only accessed with atomic operations - similar with std::atomic.
+ *        Only integers are supported. By default the operations are sequentially consistent,
+ *        the hot paths should ask for the weakest order they need.
+ */
+template <class Type>
+class Atomic final
+{
+    static_assert(xpf::ApiAtomicIsSupportedType<Type>(), "Unsupported Type!");
+
+ public:
+/**
+ * @brief Atomic constructor.
+ *
+ * @param[in] Value - The initial value.
+ */
+constexpr Atomic(
+    _In_ Type Value = Type{ 0 }
+) noexcept(true) : m_Value{ Value }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Default destructor.
+ */
+~Atomic(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Copy and move semantics are deleted - the copy would not be atomic.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(Atomic, delete);
+
+/**
+ * @brief Reads the value.
+ *
+ * @param[in] Order - Relaxed, Acquire or SequentiallyConsistent.
+ *
+ * @return The current value.
+ */
+inline Type
+Load(
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) const noexcept(true)
+{
+    return xpf::ApiAtomicLoad(&this->m_Value, Order);
+}
+
+/**
+ * @brief Writes the value.
+ *
+ * @param[in] Value - The new value.
+ *
+ * @param[in] Order - Relaxed, Release or SequentiallyConsistent.
+ */
+inline void
+Store(
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    xpf::ApiAtomicStore(&this->m_Value, Value, Order);
+}
+
+/**
+ * @brief Replaces the value.
+ *
+ * @param[in] Value - The new value.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+inline Type
+Exchange(
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    return xpf::ApiAtomicExchange(&this->m_Value, Value, Order);
+}
+
+/**
+ * @brief Replaces the value if it is equal to Expected.
+ *
+ * @param[in,out] Expected - The expected value. On failure it receives the current value.
+ *
+ * @param[in] Desired - The new value.
+ *
+ * @param[in] Order - The memory order on success.
+ *
+ * @return true if the value was replaced, false otherwise.
+ */
+inline bool
+CompareExchange(
+    _Inout_ Type& Expected,
+    _In_ Type Desired,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    return xpf::ApiAtomicTryCompareExchange(&this->m_Value, Expected, Desired, Order);
+}
+
+/**
+ * @brief Adds to the value.
+ *
+ * @param[in] Value - How much to add.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+inline Type
+FetchAdd(
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    return xpf::ApiAtomicFetchAdd(&this->m_Value, Value, Order);
+}
+
+/**
+ * @brief Subtracts from the value.
+ *
+ * @param[in] Value - How much to subtract.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+inline Type
+FetchSub(
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    return xpf::ApiAtomicFetchSub(&this->m_Value, Value, Order);
+}
+
+/**
+ * @brief Sets bits in the value.
+ *
+ * @param[in] Value - The bits to be set.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+inline Type
+FetchOr(
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    return xpf::ApiAtomicFetchOr(&this->m_Value, Value, Order);
+}
+
+/**
+ * @brief Clears bits in the value.
+ *
+ * @param[in] Value - The bits to be kept.
+ *
+ * @param[in] Order - The memory order of the operation.
+ *
+ * @return The previous value.
+ */
+inline Type
+FetchAnd(
+    _In_ Type Value,
+    _In_ xpf::MemoryOrder Order = xpf::MemoryOrder::SequentiallyConsistent
+) noexcept(true)
+{
+    return xpf::ApiAtomicFetchAnd(&this->m_Value, Value, Order);
+}
+
+ private:
+    /**
+     * @brief   The underlying value. Aligned, as the atomic intrinsics require it.
+     */
+    alignas(Type) volatile Type m_Value;
+};  // class Atomic
+};  // namespace xpf
@@ -252,6 +252,7 @@
     #include <execinfo.h>
     #include <sys/types.h>
     #include <sys/time.h>
+    #include <sys/mman.h>
     #include <sys/socket.h>
     #include <uuid/uuid.h>
     #include <cstdlib>
@@ -460,6 +461,12 @@
  */
 #define XPF_ARRAYSIZE(elements)                         (sizeof((elements)) / sizeof((elements)[0]))
 
+/**
+ * @brief The size of a cache line on all supported architectures.
+ *        Data written by different processors should not share one (false sharing).
+ */
+#define XPF_CACHE_LINE_SIZE                             static_cast<size_t>(64)
+
 /**
  * @brief Helper macro to retrieve the base address of an instance of a structure
  * given the type of the structure and the address of a field within the containing structure.
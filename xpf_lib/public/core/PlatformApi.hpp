@@ -176,6 +176,84 @@ ApiAllocateMemory(
     _In_ bool CriticalAllocation = false
 ) noexcept(true);
 
+/**
+ * @brief Frees a block of memory allocated with ApiAllocateMemoryAligned.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @return None
+ */
+void
+XPF_API
+ApiFreeMemoryAligned(
+    _Inout_opt_ void* MemoryBlock
+) noexcept(true);
+
+/**
+ * @brief Allocates a block of memory with the required size and alignment.
+ *        The block is zeroed and it spans whole alignment units - so when the alignment
+ *        is a cache line, no other allocation shares a cache line with this block.
+ *
+ * @param[in] BlockSize - The requsted block size.
+ *
+ * @param[in] Alignment - The requested alignment. Must be a power of 2.
+ *                        Values smaller than XPF_DEFAULT_ALIGNMENT are rounded up to it.
+ *
+ * @param[in] CriticalAllocation - Same as for ApiAllocateMemory.
+ *
+ * @return A block of memory with the required size, or null on failure.
+ *         It must be freed with ApiFreeMemoryAligned.
+ */
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+ApiAllocateMemoryAligned(
+    _In_ size_t BlockSize,
+    _In_ size_t Alignment,
+    _In_ bool CriticalAllocation = false
+) noexcept(true);
+
+/**
+ * @brief Allocates whole pages directly from the system, bypassing the heap.
+ *        Meant for big blocks - they don't fragment the heap and are given back right away on free.
+ *
+ * @param[in] BlockSize - The requsted block size. It is rounded up to the page size.
+ *
+ * @param[in] UseLargePages - If true, and the block is big enough, we ask the system to back it
+ *                            with huge pages (on linux via transparent huge pages).
+ *                            This is only a hint - it is ignored where not supported.
+ *
+ * @return A zeroed, page aligned block of memory, or null on failure.
+ *         It must be freed with ApiFreePages, giving the same size.
+ *
+ * @note On windows KM there is no such thing - this goes to the (paged) pool.
+ */
+_Check_return_
+_Ret_maybenull_
+void*
+XPF_API
+ApiAllocatePages(
+    _In_ size_t BlockSize,
+    _In_ bool UseLargePages
+) noexcept(true);
+
+/**
+ * @brief Frees a block of memory allocated with ApiAllocatePages.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ *
+ * @param[in] BlockSize - The same size which was given to ApiAllocatePages.
+ *
+ * @return None
+ */
+void
+XPF_API
+ApiFreePages(
+    _Inout_opt_ void* MemoryBlock,
+    _In_ size_t BlockSize
+) noexcept(true);
+
 /**
  * @brief Suspends the execution of the current thread until the time-out interval elapses.
  *
@@ -201,6 +279,31 @@ ApiYieldProcesor(
     void
 ) noexcept(true);
 
+/**
+ * @brief Retrieves the number of logical processors available in the system.
+ *
+ * @return The number of logical processors. This is always at least 1.
+ */
+uint32_t
+XPF_API
+ApiNumberOfProcessors(
+    void
+) noexcept(true);
+
+/**
+ * @brief Retrieves the index of the logical processor the caller is running on.
+ *
+ * @return The index of the current processor.
+ *
+ * @note This is only a hint. Unless the caller runs at DISPATCH_LEVEL (windows KM)
+ *       the thread can be migrated to another processor at any time.
+ */
+uint32_t
+XPF_API
+ApiCurrentProcessorNumber(
+    void
+) noexcept(true);
+
 /**
  * @brief Limits the compiler optimizations that can reorder memory accesses across the point of the call.
  *
@@ -0,0 +1,1077 @@
+﻿/**
+ * @file        xpf_lib/public/core/Sort.hpp
+ *
+ * @brief       Sorting algorithms over contiguous ranges of elements.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#pragma once
+
+
+#include "xpf_lib/public/core/Core.hpp"
+#include "xpf_lib/public/core/TypeTraits.hpp"
+#include "xpf_lib/public/core/Algorithm.hpp"
+#include "xpf_lib/public/core/PlatformApi.hpp"
+
+
+namespace xpf
+{
+
+//
+// ************************************************************************************************
+// This is the section containing the tuning knobs of the sorting algorithms.
+// ************************************************************************************************
+//
+
+/**
+ * @brief Ranges smaller than this are sorted with insertion sort.
+ */
+static constexpr size_t XPF_SORT_INSERTION_THRESHOLD = 24;
+
+/**
+ * @brief Ranges larger than this use the pseudomedian of nine as pivot.
+ */
+static constexpr size_t XPF_SORT_NINTHER_THRESHOLD = 128;
+
+/**
+ * @brief An already partitioned range is insertion sorted optimistically.
+ *        The attempt is abandoned after this many element moves.
+ */
+static constexpr size_t XPF_SORT_PARTIAL_INSERTION_LIMIT = 8;
+
+/**
+ * @brief The number of elements classified in one go by the branchless partitioning.
+ *        The offsets are stored on one byte each, so this must not exceed 256.
+ */
+static constexpr size_t XPF_SORT_BLOCK_SIZE = 64;
+
+/**
+ * @brief The ranges waiting to be sorted are kept on a fixed stack.
+ *        The smaller side is always sorted first, so each entry is at most half of the one
+ *        below it - 64 entries are enough for any size_t count.
+ */
+static constexpr size_t XPF_SORT_MAX_PENDING_RANGES = 64;
+
+/**
+ * @brief The stable sort starts by insertion sorting runs of this many elements.
+ */
+static constexpr size_t XPF_STABLE_SORT_RUN_SIZE = 32;
+
+//
+// ************************************************************************************************
+// This is the section containing the heapsort.
+// ************************************************************************************************
+//
+
+/**
+ * @brief       Uses iterative heapsort to sort the elements with the provided SortingPredicate.
+ *              The heapsort implementation here is considered an unstable sort.
+ *              Unstable sorting algorithm can be defined as sorting algorithm in which the order of objects
+ *              with the same values in the sorted array are not guaranteed to be the same as in the input array.
+ *
+ * @param[in,out] Elements - The elements to be sorted.
+ *
+ * @param[in]   Count - The number of elements.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ *
+ * @note        Please see the following rerefence:
+ *              " Knuth, Donald (1997). "ï¿½5.2.3, Sorting by Selection".
+ *                The Art of Computer Programming. Vol. 3: Sorting and Searching (3rd ed.).
+ *                Addison-Wesley. pp. 144ï¿½155. ISBN 978-0-201-89685-5. "
+ */
+template <class Type, class Predicate>
+inline void
+AlgoHeapSort(
+    _Inout_ Type* Elements,
+    _In_ size_t Count,
+    _In_ Predicate SortingPredicate
+) noexcept(true)
+{
+    //
+    // In a max-heap, the children of an element from index i are the ones from index
+    // (i*2) + 1 and (i*2) + 2 respectively. So the elements in the second half are leafs.
+    //
+    size_t start = Count / 2;
+    size_t end = Count;
+
+    //
+    // The heapsort has two steps:
+    //      1. Construction of the max heap - we need to re-arange the elements
+    //         so that they have the max heap property.
+    //      2. The actual sorting which basically means moving the root (element 0)
+    //         to the end, and then restoring the max heap property.
+    //
+    while (end > 1)
+    {
+        if (start > 0)
+        {
+            //
+            // We are constructing the max heap. This will decrease until it is 0.
+            // Only after then the sorting begins.
+            //
+            start = start - 1;
+        }
+        else
+        {
+            //
+            // We're in sorting phase. Decrease the end and move the root to the last.
+            //
+            end = end - 1;
+            xpf::AlgoSwap(Elements[0], Elements[end]);
+        }
+
+        //
+        // Restore the max-heap property.
+        //
+        size_t root = start;
+        while (2 * root < end - 1)            /* While the root has at least one child */
+        {
+            size_t child = 2 * root + 1;      /* Left child of root. */
+
+            if (child < end - 1)              /* Check if there is a right child. */
+            {
+                /* Check if the right child is bigger than left. We need the bigger child, always. */
+                const bool isLeftSmaller = SortingPredicate(Elements[child],
+                                                            Elements[child+1]);
+                if (isLeftSmaller)
+                {
+                    child = child + 1;
+                }
+            }
+
+            /* Now check if root is smaller. */
+            const bool isRootSmaller = SortingPredicate(Elements[root],
+                                                        Elements[child]);
+            if (isRootSmaller)
+            {
+                /* Swap root and child and continue swapping the child down the heap. */
+                xpf::AlgoSwap(Elements[root], Elements[child]);
+                root = child;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+}
+
+//
+// ************************************************************************************************
+// This is the section containing the helpers of the introspective sort.
+// They work on raw pointers, so there are no bounds checks in the hot loops.
+// ************************************************************************************************
+//
+
+/**
+ * @brief       Insertion sort. It is stable.
+ *
+ * @param[in,out] Begin - The first element of the range.
+ *
+ * @param[in,out] End - One past the last element of the range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ */
+template <class Type, class Predicate>
+inline void
+AlgoInsertionSort(
+    _Inout_ Type* Begin,
+    _Inout_ Type* End,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    if (Begin == End)
+    {
+        return;
+    }
+
+    for (Type* current = Begin + 1; current != End; ++current)
+    {
+        Type* sift = current;
+        if (SortingPredicate(*sift, *(sift - 1)))
+        {
+            Type temp{ xpf::Move(*sift) };
+            do
+            {
+                *sift = xpf::Move(*(sift - 1));
+                --sift;
+            } while ((sift != Begin) && SortingPredicate(temp, *(sift - 1)));
+
+            *sift = xpf::Move(temp);
+        }
+    }
+}
+
+/**
+ * @brief       Insertion sort which assumes the element before Begin is not greater
+ *              than any element in the range, so it does not check the lower bound.
+ *
+ * @param[in,out] Begin - The first element of the range.
+ *
+ * @param[in,out] End - One past the last element of the range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ */
+template <class Type, class Predicate>
+inline void
+AlgoUnguardedInsertionSort(
+    _Inout_ Type* Begin,
+    _Inout_ Type* End,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    if (Begin == End)
+    {
+        return;
+    }
+
+    for (Type* current = Begin + 1; current != End; ++current)
+    {
+        Type* sift = current;
+        if (SortingPredicate(*sift, *(sift - 1)))
+        {
+            Type temp{ xpf::Move(*sift) };
+            do
+            {
+                *sift = xpf::Move(*(sift - 1));
+                --sift;
+            } while (SortingPredicate(temp, *(sift - 1)));
+
+            *sift = xpf::Move(temp);
+        }
+    }
+}
+
+/**
+ * @brief       Attempts to insertion sort a range which is expected to be almost sorted.
+ *
+ * @param[in,out] Begin - The first element of the range.
+ *
+ * @param[in,out] End - One past the last element of the range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ *
+ * @return true if the range was sorted, false if it gave up
+ *         after XPF_SORT_PARTIAL_INSERTION_LIMIT moves.
+ */
+template <class Type, class Predicate>
+inline bool
+AlgoPartialInsertionSort(
+    _Inout_ Type* Begin,
+    _Inout_ Type* End,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    if (Begin == End)
+    {
+        return true;
+    }
+
+    size_t moves = 0;
+    for (Type* current = Begin + 1; current != End; ++current)
+    {
+        Type* sift = current;
+        if (SortingPredicate(*sift, *(sift - 1)))
+        {
+            Type temp{ xpf::Move(*sift) };
+            do
+            {
+                *sift = xpf::Move(*(sift - 1));
+                --sift;
+            } while ((sift != Begin) && SortingPredicate(temp, *(sift - 1)));
+
+            *sift = xpf::Move(temp);
+            moves += static_cast<size_t>(current - sift);
+        }
+
+        if (moves > xpf::XPF_SORT_PARTIAL_INSERTION_LIMIT)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief       Sorts the three given elements.
+ *
+ * @param[in,out] First - The first element.
+ *
+ * @param[in,out] Second - The second element.
+ *
+ * @param[in,out] Third - The third element.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ */
+template <class Type, class Predicate>
+inline void
+AlgoSortThree(
+    _Inout_ Type* First,
+    _Inout_ Type* Second,
+    _Inout_ Type* Third,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    if (SortingPredicate(*Second, *First))
+    {
+        xpf::AlgoSwap(*First, *Second);
+    }
+    if (SortingPredicate(*Third, *Second))
+    {
+        xpf::AlgoSwap(*Second, *Third);
+        if (SortingPredicate(*Second, *First))
+        {
+            xpf::AlgoSwap(*First, *Second);
+        }
+    }
+}
+
+/**
+ * @brief       Partitions the range around the pivot in *Begin.
+ *              Elements equal to the pivot go to the right side.
+ *
+ * @param[in,out] Begin - The first element of the range. It holds the pivot.
+ *
+ * @param[in,out] End - One past the last element of the range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ *
+ * @param[out]  AlreadyPartitioned - Set to true if no element had to be moved.
+ *
+ * @return The final position of the pivot.
+ *
+ * @note        Requires the range to contain an element not less than the pivot
+ *              at its end, and an element which is not greater at its beginning
+ *              (guaranteed by the median selection).
+ */
+template <class Type, class Predicate>
+inline Type*
+AlgoSortPartitionRight(
+    _Inout_ Type* Begin,
+    _Inout_ Type* End,
+    _In_ Predicate& SortingPredicate,
+    _Out_ bool* AlreadyPartitioned
+) noexcept(true)
+{
+    Type pivot{ xpf::Move(*Begin) };
+    Type* first = Begin;
+    Type* last = End;
+
+    //
+    // Find the first element not less than the pivot. The median selection guarantees it exists.
+    //
+    while (SortingPredicate(*++first, pivot))
+    {
+        XPF_NOTHING();
+    }
+
+    //
+    // Find the last element less than the pivot. If there was no element less than
+    // the pivot before, there is no guard on the left, so check the bounds.
+    //
+    if (first - 1 == Begin)
+    {
+        while ((first < last) && !SortingPredicate(*--last, pivot))
+        {
+            XPF_NOTHING();
+        }
+    }
+    else
+    {
+        while (!SortingPredicate(*--last, pivot))
+        {
+            XPF_NOTHING();
+        }
+    }
+
+    *AlreadyPartitioned = (first >= last);
+
+    while (first < last)
+    {
+        xpf::AlgoSwap(*first, *last);
+        while (SortingPredicate(*++first, pivot))
+        {
+            XPF_NOTHING();
+        }
+        while (!SortingPredicate(*--last, pivot))
+        {
+            XPF_NOTHING();
+        }
+    }
+
+    Type* pivotPosition = first - 1;
+    *Begin = xpf::Move(*pivotPosition);
+    *pivotPosition = xpf::Move(pivot);
+
+    return pivotPosition;
+}
+
+/**
+ * @brief       Swaps the misplaced elements found by the branchless partitioning.
+ *
+ * @param[in,out] First - The base of the left offsets.
+ *
+ * @param[in,out] Last - The base of the right offsets.
+ *
+ * @param[in]   OffsetsLeft - The offsets of the left elements which belong to the right.
+ *
+ * @param[in]   OffsetsRight - The offsets of the right elements which belong to the left.
+ *
+ * @param[in]   Count - The number of pairs to be swapped.
+ *
+ * @param[in]   UseSwaps - If false, a cyclic permutation is used instead of swaps.
+ *                         It does fewer moves but leaves the blocks in a different order,
+ *                         so it is only used when one of the blocks is not fully consumed.
+ */
+template <class Type>
+inline void
+AlgoSortSwapOffsets(
+    _Inout_ Type* First,
+    _Inout_ Type* Last,
+    _In_ const uint8_t* OffsetsLeft,
+    _In_ const uint8_t* OffsetsRight,
+    _In_ size_t Count,
+    _In_ bool UseSwaps
+) noexcept(true)
+{
+    if (UseSwaps)
+    {
+        for (size_t i = 0; i < Count; ++i)
+        {
+            xpf::AlgoSwap(*(First + OffsetsLeft[i]), *(Last - OffsetsRight[i]));
+        }
+    }
+    else if (Count > 0)
+    {
+        Type* left = First + OffsetsLeft[0];
+        Type* right = Last - OffsetsRight[0];
+
+        Type temp{ xpf::Move(*left) };
+        *left = xpf::Move(*right);
+        for (size_t i = 1; i < Count; ++i)
+        {
+            left = First + OffsetsLeft[i];
+            *right = xpf::Move(*left);
+            right = Last - OffsetsRight[i];
+            *left = xpf::Move(*right);
+        }
+        *right = xpf::Move(temp);
+    }
+}
+
+/**
+ * @brief       Same as AlgoSortPartitionRight, but the elements are classified in blocks,
+ *              and the result of each comparison is used as an index rather than as a branch.
+ *              So the partitioning does not suffer from branch mispredictions on random data.
+ *              See "BlockQuicksort: Avoiding Branch Mispredictions in Quicksort"
+ *              (Edelkamp and Weiss, 2016) and the pattern-defeating quicksort (Peters, 2021).
+ *
+ * @param[in,out] Begin - The first element of the range. It holds the pivot.
+ *
+ * @param[in,out] End - One past the last element of the range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ *
+ * @param[out]  AlreadyPartitioned - Set to true if no element had to be moved.
+ *
+ * @return The final position of the pivot.
+ */
+template <class Type, class Predicate>
+inline Type*
+AlgoSortPartitionRightBranchless(
+    _Inout_ Type* Begin,
+    _Inout_ Type* End,
+    _In_ Predicate& SortingPredicate,
+    _Out_ bool* AlreadyPartitioned
+) noexcept(true)
+{
+    Type pivot{ xpf::Move(*Begin) };
+    Type* first = Begin;
+    Type* last = End;
+
+    while (SortingPredicate(*++first, pivot))
+    {
+        XPF_NOTHING();
+    }
+    if (first - 1 == Begin)
+    {
+        while ((first < last) && !SortingPredicate(*--last, pivot))
+        {
+            XPF_NOTHING();
+        }
+    }
+    else
+    {
+        while (!SortingPredicate(*--last, pivot))
+        {
+            XPF_NOTHING();
+        }
+    }
+
+    *AlreadyPartitioned = (first >= last);
+    if (!(*AlreadyPartitioned))
+    {
+        //
+        // *first and *last are misplaced - swap them. Now the unknown range is [first, last).
+        //
+        xpf::AlgoSwap(*first, *last);
+        ++first;
+
+        alignas(XPF_SORT_BLOCK_SIZE) uint8_t offsetsLeft[XPF_SORT_BLOCK_SIZE];
+        alignas(XPF_SORT_BLOCK_SIZE) uint8_t offsetsRight[XPF_SORT_BLOCK_SIZE];
+
+        Type* offsetsLeftBase = first;
+        Type* offsetsRightBase = last;
+        size_t countLeft = 0;
+        size_t countRight = 0;
+        size_t startLeft = 0;
+        size_t startRight = 0;
+
+        while (first < last)
+        {
+            //
+            // Fill the offset blocks which are empty. When only a few elements are left,
+            // split them between the two blocks.
+            //
+            const size_t unknownCount = static_cast<size_t>(last - first);
+            const size_t leftSplit = (countLeft == 0) ? ((countRight == 0) ? unknownCount / 2 : unknownCount)
+                                                      : 0;
+            const size_t rightSplit = (countRight == 0) ? (unknownCount - leftSplit)
+                                                        : 0;
+
+            const size_t leftBlock = (leftSplit >= XPF_SORT_BLOCK_SIZE) ? XPF_SORT_BLOCK_SIZE : leftSplit;
+            for (size_t i = 0; i < leftBlock; ++i)
+            {
+                offsetsLeft[countLeft] = static_cast<uint8_t>(i);
+                countLeft += !SortingPredicate(*first, pivot);
+                ++first;
+            }
+
+            const size_t rightBlock = (rightSplit >= XPF_SORT_BLOCK_SIZE) ? XPF_SORT_BLOCK_SIZE : rightSplit;
+            for (size_t i = 0; i < rightBlock; ++i)
+            {
+                offsetsRight[countRight] = static_cast<uint8_t>(i + 1);
+                countRight += SortingPredicate(*--last, pivot);
+            }
+
+            //
+            // Swap as many misplaced elements as we can.
+            //
+            const size_t count = (countLeft < countRight) ? countLeft : countRight;
+            xpf::AlgoSortSwapOffsets(offsetsLeftBase,
+                                     offsetsRightBase,
+                                     &offsetsLeft[startLeft],
+                                     &offsetsRight[startRight],
+                                     count,
+                                     countLeft == countRight);
+            countLeft -= count;
+            countRight -= count;
+            startLeft += count;
+            startRight += count;
+
+            if (countLeft == 0)
+            {
+                startLeft = 0;
+                offsetsLeftBase = first;
+            }
+            if (countRight == 0)
+            {
+                startRight = 0;
+                offsetsRightBase = last;
+            }
+        }
+
+        //
+        // At most one of the blocks still has misplaced elements. Move them to the middle.
+        //
+        if (countLeft != 0)
+        {
+            while (countLeft-- > 0)
+            {
+                xpf::AlgoSwap(*(offsetsLeftBase + offsetsLeft[startLeft + countLeft]), *--last);
+            }
+            first = last;
+        }
+        if (countRight != 0)
+        {
+            while (countRight-- > 0)
+            {
+                xpf::AlgoSwap(*(offsetsRightBase - offsetsRight[startRight + countRight]), *first);
+                ++first;
+            }
+        }
+    }
+
+    Type* pivotPosition = first - 1;
+    *Begin = xpf::Move(*pivotPosition);
+    *pivotPosition = xpf::Move(pivot);
+
+    return pivotPosition;
+}
+
+/**
+ * @brief       Partitions the range around the pivot in *Begin.
+ *              Elements equal to the pivot go to the left side.
+ *              It is used when the pivot is equal to the one of the previous partition,
+ *              so all the elements equal to it are put in place at once.
+ *
+ * @param[in,out] Begin - The first element of the range. It holds the pivot.
+ *
+ * @param[in,out] End - One past the last element of the range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ *
+ * @return The final position of the pivot.
+ */
+template <class Type, class Predicate>
+inline Type*
+AlgoSortPartitionLeft(
+    _Inout_ Type* Begin,
+    _Inout_ Type* End,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    Type pivot{ xpf::Move(*Begin) };
+    Type* first = Begin;
+    Type* last = End;
+
+    while (SortingPredicate(pivot, *--last))
+    {
+        XPF_NOTHING();
+    }
+
+    if (last + 1 == End)
+    {
+        while ((first < last) && !SortingPredicate(pivot, *++first))
+        {
+            XPF_NOTHING();
+        }
+    }
+    else
+    {
+        while (!SortingPredicate(pivot, *++first))
+        {
+            XPF_NOTHING();
+        }
+    }
+
+    while (first < last)
+    {
+        xpf::AlgoSwap(*first, *last);
+        while (SortingPredicate(pivot, *--last))
+        {
+            XPF_NOTHING();
+        }
+        while (!SortingPredicate(pivot, *++first))
+        {
+            XPF_NOTHING();
+        }
+    }
+
+    Type* pivotPosition = last;
+    *Begin = xpf::Move(*pivotPosition);
+    *pivotPosition = xpf::Move(pivot);
+
+    return pivotPosition;
+}
+
+/**
+ * @brief       Swaps a few elements of a badly partitioned side, to break the pattern
+ *              which caused it before the next partitioning.
+ *
+ * @param[in,out] Begin - The first element of the side.
+ *
+ * @param[in]   Size - The number of elements of the side.
+ */
+template <class Type>
+inline void
+AlgoSortBreakPatterns(
+    _Inout_ Type* Begin,
+    _In_ size_t Size
+) noexcept(true)
+{
+    if (Size < XPF_SORT_INSERTION_THRESHOLD)
+    {
+        return;
+    }
+
+    const size_t quarter = Size / 4;
+    Type* end = Begin + Size;
+
+    xpf::AlgoSwap(*Begin, *(Begin + quarter));
+    xpf::AlgoSwap(*(end - 1), *(end - quarter));
+    if (Size > XPF_SORT_NINTHER_THRESHOLD)
+    {
+        xpf::AlgoSwap(*(Begin + 1), *(Begin + (quarter + 1)));
+        xpf::AlgoSwap(*(Begin + 2), *(Begin + (quarter + 2)));
+        xpf::AlgoSwap(*(end - 2), *(end - (quarter + 1)));
+        xpf::AlgoSwap(*(end - 3), *(end - (quarter + 2)));
+    }
+}
+
+//
+// ************************************************************************************************
+// This is the section containing the sorting algorithms.
+// ************************************************************************************************
+//
+
+/**
+ * @brief       Sorts the elements with the provided SortingPredicate. This is an unstable sort.
+ *
+ *              This is an introspective sort in the style of the pattern-defeating quicksort:
+ *              - small ranges are insertion sorted;
+ *              - the pivot is the median of three (or the pseudomedian of nine for large ranges);
+ *              - the partitioning is branchless for trivially copyable types;
+ *              - runs of elements equal to a previous pivot are put in place in one pass;
+ *              - already partitioned ranges are optimistically insertion sorted, so sorted
+ *                and reverse sorted inputs take linear time;
+ *              - bad partitions shuffle a few elements, and after log2(n) of them
+ *                the range falls back to heapsort - so the worst case stays O(n log n).
+ *
+ *              It does not recurse. The pending ranges are kept in a fixed-size array,
+ *              so the stack usage is constant - it can be used in kernel mode.
+ *
+ * @param[in,out] Elements - The elements to be sorted.
+ *
+ * @param[in]   Count - The number of elements.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ *
+ * @note        Please see the following reference:
+ *              " Peters, Orson R. L. (2021). "Pattern-defeating Quicksort". arXiv:2106.05123. "
+ */
+template <class Type, class Predicate>
+inline void
+AlgoSort(
+    _Inout_ Type* Elements,
+    _In_ size_t Count,
+    _In_ Predicate SortingPredicate
+) noexcept(true)
+{
+    /**
+     * @brief A range which still needs to be sorted.
+     */
+    struct PendingRange
+    {
+        Type* Begin;
+        Type* End;
+        size_t BadPartitionsAllowed;
+        bool IsLeftmost;
+    };
+
+    if (Count < 2)
+    {
+        return;
+    }
+
+    size_t badPartitionsAllowed = 0;
+    for (size_t size = Count; size > 1; size = size / 2)
+    {
+        badPartitionsAllowed++;
+    }
+
+    PendingRange pending[XPF_SORT_MAX_PENDING_RANGES];
+    size_t pendingCount = 0;
+
+    pending[pendingCount++] = PendingRange{ Elements, Elements + Count, badPartitionsAllowed, true };
+
+    while (pendingCount > 0)
+    {
+        PendingRange range = pending[--pendingCount];
+
+        while (true)
+        {
+            const size_t size = static_cast<size_t>(range.End - range.Begin);
+
+            //
+            // Small ranges are insertion sorted. If the range is not the leftmost one,
+            // the pivot before it is a sentinel - so we can skip the bounds check.
+            //
+            if (size < XPF_SORT_INSERTION_THRESHOLD)
+            {
+                if (range.IsLeftmost)
+                {
+                    xpf::AlgoInsertionSort(range.Begin, range.End, SortingPredicate);
+                }
+                else
+                {
+                    xpf::AlgoUnguardedInsertionSort(range.Begin, range.End, SortingPredicate);
+                }
+                break;
+            }
+
+            //
+            // Choose the pivot and move it to the beginning.
+            //
+            const size_t half = size / 2;
+            if (size > XPF_SORT_NINTHER_THRESHOLD)
+            {
+                xpf::AlgoSortThree(range.Begin, range.Begin + half, range.End - 1, SortingPredicate);
+                xpf::AlgoSortThree(range.Begin + 1, range.Begin + (half - 1), range.End - 2, SortingPredicate);
+                xpf::AlgoSortThree(range.Begin + 2, range.Begin + (half + 1), range.End - 3, SortingPredicate);
+                xpf::AlgoSortThree(range.Begin + (half - 1), range.Begin + half, range.Begin + (half + 1),
+                                   SortingPredicate);
+                xpf::AlgoSwap(*range.Begin, *(range.Begin + half));
+            }
+            else
+            {
+                xpf::AlgoSortThree(range.Begin + half, range.Begin, range.End - 1, SortingPredicate);
+            }
+
+            //
+            // If the pivot is equal to the previous one, all elements in this range are not less
+            // than it. Put the ones equal to the pivot in place and continue with the rest.
+            //
+            if (!range.IsLeftmost && !SortingPredicate(*(range.Begin - 1), *range.Begin))
+            {
+                range.Begin = xpf::AlgoSortPartitionLeft(range.Begin, range.End, SortingPredicate) + 1;
+                continue;
+            }
+
+            bool alreadyPartitioned = false;
+            Type* pivotPosition = nullptr;
+            if constexpr (xpf::IsTriviallyCopyable<Type>())
+            {
+                pivotPosition = xpf::AlgoSortPartitionRightBranchless(range.Begin,
+                                                                      range.End,
+                                                                      SortingPredicate,
+                                                                      &alreadyPartitioned);
+            }
+            else
+            {
+                pivotPosition = xpf::AlgoSortPartitionRight(range.Begin,
+                                                            range.End,
+                                                            SortingPredicate,
+                                                            &alreadyPartitioned);
+            }
+
+            const size_t leftSize = static_cast<size_t>(pivotPosition - range.Begin);
+            const size_t rightSize = static_cast<size_t>(range.End - (pivotPosition + 1));
+
+            if ((leftSize < size / 8) || (rightSize < size / 8))
+            {
+                //
+                // Too many bad partitions - heapsort guarantees O(n log n).
+                //
+                range.BadPartitionsAllowed--;
+                if (0 == range.BadPartitionsAllowed)
+                {
+                    xpf::AlgoHeapSort(range.Begin, size, SortingPredicate);
+                    break;
+                }
+
+                xpf::AlgoSortBreakPatterns(range.Begin, leftSize);
+                xpf::AlgoSortBreakPatterns(pivotPosition + 1, rightSize);
+            }
+            else if (alreadyPartitioned &&
+                     xpf::AlgoPartialInsertionSort(range.Begin, pivotPosition, SortingPredicate) &&
+                     xpf::AlgoPartialInsertionSort(pivotPosition + 1, range.End, SortingPredicate))
+            {
+                //
+                // The range was likely sorted already - and it is now.
+                //
+                break;
+            }
+
+            //
+            // Keep the larger side for later and continue with the smaller one.
+            // This bounds the number of pending ranges to log2(Count).
+            //
+            const PendingRange leftRange{ range.Begin, pivotPosition, range.BadPartitionsAllowed, range.IsLeftmost };
+            const PendingRange rightRange{ pivotPosition + 1, range.End, range.BadPartitionsAllowed, false };
+
+            XPF_DEATH_ON_FAILURE(pendingCount < XPF_SORT_MAX_PENDING_RANGES);
+            if (leftSize < rightSize)
+            {
+                pending[pendingCount++] = rightRange;
+                range = leftRange;
+            }
+            else
+            {
+                pending[pendingCount++] = leftRange;
+                range = rightRange;
+            }
+        }
+    }
+}
+
+/**
+ * @brief       Merges two consecutive sorted ranges. The smaller one is moved to the scratch buffer.
+ *
+ * @param[in,out] Begin - The first element of the left range.
+ *
+ * @param[in,out] Middle - The first element of the right range.
+ *
+ * @param[in,out] End - One past the last element of the right range.
+ *
+ * @param[in,out] Scratch - Uninitialized memory for at least the size of the smaller range.
+ *
+ * @param[in]   SortingPredicate - The strict ordering between the elements.
+ */
+template <class Type, class Predicate>
+inline void
+AlgoStableSortMerge(
+    _Inout_ Type* Begin,
+    _Inout_ Type* Middle,
+    _Inout_ Type* End,
+    _Inout_ Type* Scratch,
+    _In_ Predicate& SortingPredicate
+) noexcept(true)
+{
+    //
+    // Already in order - nothing to merge.
+    //
+    if (!SortingPredicate(*Middle, *(Middle - 1)))
+    {
+        return;
+    }
+
+    const size_t leftSize = static_cast<size_t>(Middle - Begin);
+    const size_t rightSize = static_cast<size_t>(End - Middle);
+
+    if (leftSize <= rightSize)
+    {
+        for (size_t i = 0; i < leftSize; ++i)
+        {
+            ::new (&Scratch[i]) Type(xpf::Move(Begin[i]));
+        }
+
+        //
+        // Merge forward. On equal elements the left one goes first.
+        //
+        size_t left = 0;
+        Type* right = Middle;
+        Type* output = Begin;
+        while ((left < leftSize) && (right < End))
+        {
+            if (SortingPredicate(*right, Scratch[left]))
+            {
+                *output++ = xpf::Move(*right++);
+            }
+            else
+            {
+                *output++ = xpf::Move(Scratch[left++]);
+            }
+        }
+        while (left < leftSize)
+        {
+            *output++ = xpf::Move(Scratch[left++]);
+        }
+
+        for (size_t i = 0; i < leftSize; ++i)
+        {
+            Scratch[i].~Type();
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < rightSize; ++i)
+        {
+            ::new (&Scratch[i]) Type(xpf::Move(Middle[i]));
+        }
+
+        //
+        // Merge backward. On equal elements the right one goes last.
+        //
+        size_t right = rightSize;
+        Type* left = Middle;
+        Type* output = End;
+        while ((right > 0) && (left > Begin))
+        {
+            if (SortingPredicate(Scratch[right - 1], *(left - 1)))
+            {
+                *--output = xpf::Move(*--left);
+            }
+            else
+            {
+                *--output = xpf::Move(Scratch[--right]);
+            }
+        }
+        while (right > 0)
+        {
+            *--output = xpf::Move(Scratch[--right]);
+        }
+
+        for (size_t i = 0; i < rightSize; ++i)
+        {
+            Scratch[i].~Type();
+        }
+    }
+}
+
+/**
+ * @brief       Sorts the elements with the provided SortingPredicate, keeping the relative order
+ *              of the equal elements. This is a bottom-up merge sort: runs of
+ *              XPF_STABLE_SORT_RUN_SIZE elements are insertion sorted, then merged pairwise.
+ *              It is O(n log n) and does not recurse.
+ *
+ * @param[in,out] Elements - The elements to be sorted.
+ *
+ * @param[in]   Count - The number of elements.
+ *
+ * @param[in,out] Scratch - Uninitialized memory for at least Count / 2 elements.
+ *                          Can be nullptr when Count is not greater than XPF_STABLE_SORT_RUN_SIZE.
+ *
+ * @param[in]   SortingPredicate - a lambda with the signature(const& Left, const& Right) which returns
+ *                                 true if left should appear before right in the sorted array.
+ */
+template <class Type, class Predicate>
+inline void
+AlgoStableSort(
+    _Inout_ Type* Elements,
+    _In_ size_t Count,
+    _Inout_opt_ Type* Scratch,
+    _In_ Predicate SortingPredicate
+) noexcept(true)
+{
+    if (Count < 2)
+    {
+        return;
+    }
+
+    for (size_t start = 0; start < Count; start += XPF_STABLE_SORT_RUN_SIZE)
+    {
+        const size_t end = (Count - start > XPF_STABLE_SORT_RUN_SIZE) ? start + XPF_STABLE_SORT_RUN_SIZE
+                                                                      : Count;
+        xpf::AlgoInsertionSort(Elements + start, Elements + end, SortingPredicate);
+    }
+    if (Count <= XPF_STABLE_SORT_RUN_SIZE)
+    {
+        return;
+    }
+
+    XPF_DEATH_ON_FAILURE(nullptr != Scratch);
+    for (size_t width = XPF_STABLE_SORT_RUN_SIZE; width < Count; width = width * 2)
+    {
+        for (size_t start = 0; (start < Count) && (Count - start > width); start += 2 * width)
+        {
+            const size_t middle = start + width;
+            const size_t end = (Count - middle > width) ? middle + width
+                                                        : Count;
+            xpf::AlgoStableSortMerge(Elements + start,
+                                     Elements + middle,
+                                     Elements + end,
+                                     Scratch,
+                                     SortingPredicate);
+        }
+
+        //
+        // Don't overflow the width.
+        //
+        if (width > Count / 2)
+        {
+            break;
+        }
+    }
+}
+};  // namespace xpf
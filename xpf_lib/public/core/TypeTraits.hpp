@@ -73,6 +73,42 @@ constexpr inline bool IsTriviallyDestructible(void) noexcept(true)
     return __is_trivially_destructible(Type);
 }
 
+/**
+ * @brief Definition for std::is_trivially_copyable.
+ *        Determins whether type can be copied with a plain memory copy.
+ *        Uses a compiler intrinsic __is_trivially_copyable.
+ *
+ * @return true if the Type is trivially copyable,
+ *         false otherwise.
+ */
+template <class Type>
+constexpr inline bool IsTriviallyCopyable(void) noexcept(true)
+{
+    return __is_trivially_copyable(Type);
+}
+
+/**
+ * @brief Opt-in for types which are not trivially copyable,
+ *        but can still be moved to another address with a plain memory copy
+ *        (i.e. they do not hold pointers to themselves).
+ *        Specialize it as true for such types.
+ */
+template <class>
+constexpr inline bool TriviallyRelocatableOptIn = false;
+
+/**
+ * @brief Determines whether an object of Type can be relocated with a plain memory copy.
+ *        Relocation means move-construct at the new address followed by destroying the old object.
+ *
+ * @return true if the Type is trivially copyable or opted-in via TriviallyRelocatableOptIn,
+ *         false otherwise.
+ */
+template <class Type>
+constexpr inline bool IsTriviallyRelocatable(void) noexcept(true)
+{
+    return xpf::IsTriviallyCopyable<Type>() || xpf::TriviallyRelocatableOptIn<Type>;
+}
+
 /**
  * @brief Definition for std::is_empty.
  *        This template contains single parameter Type (Trait class)
@@ -49,6 +49,7 @@
     #define STATUS_INVALID_HANDLE               ((NTSTATUS)0xC0000008L)
     #define STATUS_INVALID_PARAMETER            ((NTSTATUS)0xC000000DL)
     #define STATUS_MORE_PROCESSING_REQUIRED     ((NTSTATUS)0xC0000016L)
+    #define STATUS_OBJECT_NAME_COLLISION        ((NTSTATUS)0xC0000035L)
     #define STATUS_DATA_ERROR                   ((NTSTATUS)0xC000003EL)
     #define STATUS_QUOTA_EXCEEDED               ((NTSTATUS)0xC0000044L)
     #define STATUS_MUTANT_NOT_OWNED             ((NTSTATUS)0xC0000046L)
@@ -21,19 +21,38 @@
 #include "public/core/TypeTraits.hpp"
 #include "public/core/Algorithm.hpp"
 #include "public/core/PlatformApi.hpp"
+#include "public/core/Sort.hpp"
+#include "public/core/Atomic.hpp"
 #include "public/core/Endianess.hpp"
 
 #include "public/Memory/MemoryAllocator.hpp"
+#include "public/Memory/CacheAligned.hpp"
 #include "public/Memory/CompressedPair.hpp"
 #include "public/Memory/UniquePointer.hpp"
 #include "public/Memory/SharedPointer.hpp"
+#include "public/Memory/AtomicSharedPointer.hpp"
 #include "public/Memory/Optional.hpp"
+#include "public/Memory/CacheRegistry.hpp"
 #include "public/Memory/LookasideListAllocator.hpp"
+#include "public/Memory/ObjectPool.hpp"
+#include "public/Memory/SlabAllocator.hpp"
+#include "public/Memory/MonotonicArena.hpp"
+#include "public/Memory/LargeBlockAllocator.hpp"
+#include "public/Memory/SamplingAllocationProfiler.hpp"
 
 #include "public/Containers/TwoLockQueue.hpp"
+#include "public/Containers/LockFreeStack.hpp"
 #include "public/Containers/String.hpp"
 #include "public/Containers/Vector.hpp"
+#include "public/Containers/SmallVector.hpp"
 #include "public/Containers/RedBlackTree.hpp"
+#include "public/Containers/HashMap.hpp"
+#include "public/Containers/BTreeMap.hpp"
+#include "public/Containers/OrderStatisticTree.hpp"
+#include "public/Containers/IntervalTree.hpp"
+#include "public/Containers/ConcurrentHashMap.hpp"
+#include "public/Containers/MpmcRingBuffer.hpp"
+#include "public/Containers/SpscRingBuffer.hpp"
 #include "public/Containers/Span.hpp"
 #include "public/Containers/Stream.hpp"
 
@@ -45,6 +64,8 @@
 #include "public/Multithreading/Signal.hpp"
 #include "public/Multithreading/RundownProtection.hpp"
 #include "public/Multithreading/ThreadPool.hpp"
+#include "public/Multithreading/ParallelSort.hpp"
+#include "public/Multithreading/CacheTrimmer.hpp"
 
 #include "public/Utility/EventFramework.hpp"
 #include "public/Utility/ISerializable.hpp"
@@ -0,0 +1,592 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestBTreeMap.cpp
+ *
+ * @brief       This contains tests for BTreeMap.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Allocates memory while the budget allows it.
+ *
+ * @param[in] Context - A pointer to a size_t budget - the number of allowed allocations.
+ *
+ * @param[in] BlockSize - The size of the block.
+ *
+ * @return The allocated block, or nullptr if the budget is exhausted.
+ */
+static void*
+MockBTreeMapAllocate(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    size_t* budget = static_cast<size_t*>(Context);
+    if (0 == *budget)
+    {
+        return nullptr;
+    }
+    (*budget)--;
+    return xpf::MemoryAllocator::AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief       Frees memory allocated with MockBTreeMapAllocate.
+ *
+ * @param[in] Context - A pointer to a size_t budget. Unused.
+ *
+ * @param[in,out] MemoryBlock - The block to be freed.
+ */
+static void
+MockBTreeMapFree(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+    xpf::MemoryAllocator::FreeMemory(MemoryBlock);
+}
+
+/**
+ * @brief Orders strings lexicographically - String has no operator<.
+ */
+struct MockBTreeMapStringCompare
+{
+    /**
+     * @brief       Compares two strings.
+     *
+     * @param[in]   Left  - The left operand.
+     * @param[in]   Right - The right operand.
+     *
+     * @return true if Left should appear before Right.
+     */
+    inline bool
+    operator()(
+        _In_ _Const_ const xpf::String<char>& Left,
+        _In_ _Const_ const xpf::String<char>& Right
+    ) const noexcept(true)
+    {
+        const size_t size = (Left.BufferSize() < Right.BufferSize()) ? Left.BufferSize()
+                                                                     : Right.BufferSize();
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (Left[i] != Right[i])
+            {
+                return Left[i] < Right[i];
+            }
+        }
+        return Left.BufferSize() < Right.BufferSize();
+    }
+};
+
+/**
+ * @brief       Validates the B-tree invariants:
+ *              - every node except the root has between MIN_KEYS and MAX_KEYS keys;
+ *              - the keys are sorted and the in-order walk visits Size() keys;
+ *              - every child points back to its parent at the right position;
+ *              - all leaves are on the same level.
+ *
+ * @param[in]   Map      - The BTreeMap to validate.
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+template <class Key, class Value, class Comparator>
+static void
+ValidateBTreeInvariants(
+    _In_ _Const_ const xpf::BTreeMap<Key, Value, Comparator>& Map,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    using MapType = xpf::BTreeMap<Key, Value, Comparator>;
+    using Node = typename MapType::Node;
+
+    struct PendingNode
+    {
+        const Node* TreeNode = nullptr;
+        size_t Depth = 0;
+    };
+
+    const Node* root = Map.Root();
+    if (nullptr == root)
+    {
+        if (!Map.IsEmpty())
+        {
+            xpf_test::LogTestInfo("    [!] BTree Violation: no root, but the map is not empty.\r\n");
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+        }
+        return;
+    }
+    if ((nullptr != root->Parent) || (0 == root->Count))
+    {
+        xpf_test::LogTestInfo("    [!] BTree Violation: invalid root.\r\n");
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+        return;
+    }
+
+    xpf::Vector<PendingNode> stack;
+    if (!NT_SUCCESS(stack.Emplace(PendingNode{ root, 0 })))
+    {
+        (*Scenario) = STATUS_INSUFFICIENT_RESOURCES;
+        return;
+    }
+
+    size_t leafDepth = xpf::NumericLimits<size_t>::MaxValue();
+    while (!stack.IsEmpty())
+    {
+        const PendingNode pending = stack[stack.Size() - 1];
+        if (!NT_SUCCESS(stack.Erase(stack.Size() - 1)))
+        {
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+
+        const Node* node = pending.TreeNode;
+        if ((node->Count > MapType::MAX_KEYS) || ((node != root) && (node->Count < MapType::MIN_KEYS)))
+        {
+            xpf_test::LogTestInfo("    [!] BTree Violation: node with %d keys.\r\n",
+                                  static_cast<int>(node->Count));                                               // NOLINT(*)
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+
+        if (node->IsLeaf)
+        {
+            if (leafDepth == xpf::NumericLimits<size_t>::MaxValue())
+            {
+                leafDepth = pending.Depth;
+            }
+            if (leafDepth != pending.Depth)
+            {
+                xpf_test::LogTestInfo("    [!] BTree Violation: leaves on different levels.\r\n");
+                (*Scenario) = STATUS_UNSUCCESSFUL;
+                return;
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i <= node->Count; ++i)
+        {
+            const Node* child = MapType::Children(node)[i];
+            if ((child->Parent != node) || (child->Position != i))
+            {
+                xpf_test::LogTestInfo("    [!] BTree Violation: broken parent link.\r\n");
+                (*Scenario) = STATUS_UNSUCCESSFUL;
+                return;
+            }
+            if (!NT_SUCCESS(stack.Emplace(PendingNode{ child, pending.Depth + 1 })))
+            {
+                (*Scenario) = STATUS_INSUFFICIENT_RESOURCES;
+                return;
+            }
+        }
+    }
+
+    Comparator compare;
+    size_t count = 0;
+    const Key* previous = nullptr;
+    for (auto it = Map.Begin(); it != Map.End(); ++it)
+    {
+        if ((nullptr != previous) && !compare(*previous, it.GetKey()))
+        {
+            xpf_test::LogTestInfo("    [!] BTree Violation: keys are not sorted.\r\n");
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+        previous = xpf::AddressOf(it.GetKey());
+        count++;
+    }
+    if (count != Map.Size())
+    {
+        xpf_test::LogTestInfo("    [!] BTree Violation: walked %llu keys, expected %llu.\r\n",
+                              static_cast<unsigned long long>(count),                                           // NOLINT(*)
+                              static_cast<unsigned long long>(Map.Size()));                                     // NOLINT(*)
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+    }
+}
+
+/**
+ * @brief       This tests the default constructor and the empty map.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, DefaultConstructor)
+{
+    xpf::BTreeMap<int, int> map;
+
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(0 == map.Size());
+    XPF_TEST_EXPECT_TRUE(map.Begin() == map.End());
+    XPF_TEST_EXPECT_TRUE(map.Find(42) == map.End());
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == map.Erase(42));
+    XPF_TEST_EXPECT_TRUE(nullptr == map.Root());
+
+    //
+    // The node has room for at least three keys, and it is odd so it splits evenly.
+    //
+    using IntMap = xpf::BTreeMap<int, int>;
+    using LargeMap = xpf::BTreeMap<uint64_t, uint64_t>;
+
+    XPF_TEST_EXPECT_TRUE((IntMap::MAX_KEYS % 2) == 1);
+    XPF_TEST_EXPECT_TRUE(IntMap::MAX_KEYS >= 3);
+    XPF_TEST_EXPECT_TRUE(LargeMap::MAX_KEYS == 15);
+}
+
+/**
+ * @brief       This tests Emplace, Find, the upsert and the in-order iteration.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, EmplaceAndFind)
+{
+    xpf::BTreeMap<int, int> map;
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        int key = (i * 7919) % 5000;
+        int value = key * 2;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+    }
+    XPF_TEST_EXPECT_TRUE(5000 == map.Size());
+    ValidateBTreeInvariants(map, _XpfArgScenario);
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        auto it = map.Find(i);
+        XPF_TEST_EXPECT_TRUE(it != map.End());
+        XPF_TEST_EXPECT_TRUE(i == it.GetKey());
+        XPF_TEST_EXPECT_TRUE(i * 2 == it.GetValue());
+    }
+    XPF_TEST_EXPECT_TRUE(map.Find(-1) == map.End());
+    XPF_TEST_EXPECT_TRUE(map.Find(5000) == map.End());
+
+    //
+    // Emplacing an existing key updates the value and leaves the size alone.
+    //
+    int key = 1234;
+    int value = -1;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+    XPF_TEST_EXPECT_TRUE(5000 == map.Size());
+    XPF_TEST_EXPECT_TRUE(-1 == map.Find(1234).GetValue());
+
+    int expected = 0;
+    for (auto it = map.Begin(); it != map.End(); ++it)
+    {
+        XPF_TEST_EXPECT_TRUE(expected == it.GetKey());
+        expected++;
+    }
+    XPF_TEST_EXPECT_TRUE(5000 == expected);
+}
+
+/**
+ * @brief       This tests Erase in every order - each path of the rebalancing is taken.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, EraseAndRebalance)
+{
+    xpf::BTreeMap<int, int> map;
+
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        for (int i = 0; i < 2000; ++i)
+        {
+            int key = i;
+            int value = i;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+        }
+        XPF_TEST_EXPECT_TRUE(2000 == map.Size());
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            //
+            // Ascending, descending and scattered erase orders.
+            //
+            const int key = (0 == pass) ? i
+                          : (1 == pass) ? 1999 - i
+                                        : (i * 7919) % 2000;
+
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(key)));
+            XPF_TEST_EXPECT_TRUE(map.Find(key) == map.End());
+            XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == map.Erase(key));
+
+            if (0 == (i % 97))
+            {
+                ValidateBTreeInvariants(map, _XpfArgScenario);
+            }
+        }
+        XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+        XPF_TEST_EXPECT_TRUE(nullptr == map.Root());
+    }
+}
+
+/**
+ * @brief       This tests random inserts and erases against a Map.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, ChurnAgainstMap)
+{
+    xpf::BTreeMap<uint32_t, uint32_t> btree;
+    xpf::Map<uint32_t, uint32_t> reference;
+
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < 50000; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        const uint32_t key = state % 3000;
+        if (0 != (state & 0x100000))
+        {
+            uint32_t k1 = key;
+            uint32_t v1 = static_cast<uint32_t>(i);
+            uint32_t k2 = key;
+            uint32_t v2 = static_cast<uint32_t>(i);
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(btree.Emplace(xpf::Move(k1), xpf::Move(v1))));
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(reference.Emplace(xpf::Move(k2), xpf::Move(v2))));
+        }
+        else
+        {
+            XPF_TEST_EXPECT_TRUE(btree.Erase(key) == reference.Erase(key));
+        }
+
+        if (0 == (i % 5000))
+        {
+            ValidateBTreeInvariants(btree, _XpfArgScenario);
+        }
+    }
+
+    XPF_TEST_EXPECT_TRUE(btree.Size() == reference.Size());
+    ValidateBTreeInvariants(btree, _XpfArgScenario);
+
+    auto referenceIt = reference.Begin();
+    for (auto it = btree.Begin(); it != btree.End(); ++it)
+    {
+        XPF_TEST_EXPECT_TRUE(referenceIt != reference.End());
+        XPF_TEST_EXPECT_TRUE(it.GetKey() == referenceIt.GetKey());
+        XPF_TEST_EXPECT_TRUE(it.GetValue() == referenceIt.GetValue());
+        ++referenceIt;
+    }
+    XPF_TEST_EXPECT_TRUE(referenceIt == reference.End());
+}
+
+/**
+ * @brief       This tests keys and values which own memory, a custom comparator,
+ *              the move semantics and Clear.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, StringKeysAndMove)
+{
+    xpf::BTreeMap<xpf::String<char>, xpf::String<wchar_t>, MockBTreeMapStringCompare> map;
+
+    for (size_t i = 0; i < 676; ++i)
+    {
+        const char key[] = { static_cast<char>('a' + ((i * 7) % 26)),
+                             static_cast<char>('a' + ((i / 26) % 26)),
+                             '\0' };
+
+        xpf::String<char> keyString;
+        xpf::String<wchar_t> valueString;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(keyString.Append(key)));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(valueString.Append(L"value")));
+
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(keyString), xpf::Move(valueString))));
+    }
+    XPF_TEST_EXPECT_TRUE(676 == map.Size());
+    ValidateBTreeInvariants(map, _XpfArgScenario);
+
+    xpf::String<char> lookup;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(lookup.Append("cb")));
+    auto it = map.Find(lookup);
+    XPF_TEST_EXPECT_TRUE(it != map.End());
+    XPF_TEST_EXPECT_TRUE(it.GetValue().View().Equals(L"value", true));
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(lookup)));
+    XPF_TEST_EXPECT_TRUE(map.Find(lookup) == map.End());
+    XPF_TEST_EXPECT_TRUE(675 == map.Size());
+    ValidateBTreeInvariants(map, _XpfArgScenario);
+
+    //
+    // Moving the map moves the ownership of the nodes.
+    //
+    xpf::BTreeMap<xpf::String<char>, xpf::String<wchar_t>, MockBTreeMapStringCompare> other{ xpf::Move(map) };
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(nullptr == map.Root());
+    XPF_TEST_EXPECT_TRUE(675 == other.Size());
+    ValidateBTreeInvariants(other, _XpfArgScenario);
+
+    map = xpf::Move(other);
+    XPF_TEST_EXPECT_TRUE(other.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(675 == map.Size());
+
+    map.Clear();
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(map.Begin() == map.End());
+}
+
+/**
+ * @brief       This tests that a failed allocation leaves the map usable.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, AllocationFailure)
+{
+    size_t budget = 0;
+
+    xpf::PolymorphicAllocator allocator;
+    allocator.Context = &budget;
+    allocator.ContextAllocFunction = &MockBTreeMapAllocate;
+    allocator.ContextFreeFunction = &MockBTreeMapFree;
+
+    xpf::BTreeMap<uint64_t, uint64_t> map{ allocator };
+
+    uint64_t key = 0;
+    uint64_t value = 0;
+    XPF_TEST_EXPECT_TRUE(STATUS_INSUFFICIENT_RESOURCES == map.Emplace(xpf::Move(key), xpf::Move(value)));
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+
+    //
+    // Insert until the allocations run out - every key inserted before stays reachable.
+    //
+    budget = 10;
+    uint64_t inserted = 0;
+    for (uint64_t i = 0; i < 10000; ++i)
+    {
+        key = (i * 7919) % 10000;
+        value = i;
+        const NTSTATUS status = map.Emplace(xpf::Move(key), xpf::Move(value));
+        if (!NT_SUCCESS(status))
+        {
+            XPF_TEST_EXPECT_TRUE(STATUS_INSUFFICIENT_RESOURCES == status);
+            break;
+        }
+        inserted++;
+    }
+    XPF_TEST_EXPECT_TRUE(0 == budget);
+    XPF_TEST_EXPECT_TRUE(inserted == map.Size());
+    XPF_TEST_EXPECT_TRUE(inserted < 10000);
+    ValidateBTreeInvariants(map, _XpfArgScenario);
+
+    for (uint64_t i = 0; i < inserted; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(map.Find((i * 7919) % 10000) != map.End());
+    }
+
+    //
+    // The update of an existing key does not allocate.
+    //
+    key = 0;
+    value = 42;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+    XPF_TEST_EXPECT_TRUE(42 == map.Find(0).GetValue());
+
+    //
+    // Erasing never allocates.
+    //
+    for (uint64_t i = 0; i < inserted; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase((i * 7919) % 10000)));
+    }
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+}
+
+/**
+ * @brief       Compares BTreeMap against RedBlackTree for a number of keys and logs the timings.
+ *              The keys are scattered by HashMix (a bijection, so they are distinct),
+ *              inserted, then all looked up in a different order.
+ *
+ * @param[in]   Count - The number of keys.
+ *
+ * @return      true if both containers found all the keys, false otherwise.
+ */
+static bool XPF_API
+MockBTreeBenchmarkAgainstRedBlackTree(
+    _In_ uint64_t Count
+) noexcept(true)
+{
+    bool isCorrect = true;
+
+    uint64_t btreeInsert = 0;
+    uint64_t btreeFind = 0;
+    {
+        xpf::BTreeMap<uint64_t, uint64_t> map;
+
+        const uint64_t insertStart = xpf::ApiCurrentTime();
+        for (uint64_t i = 0; i < Count; ++i)
+        {
+            uint64_t key = xpf::HashMix(i);
+            uint64_t value = i;
+            isCorrect = NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))) && isCorrect;
+        }
+        const uint64_t insertEnd = xpf::ApiCurrentTime();
+
+        uint64_t found = 0;
+        const uint64_t findStart = xpf::ApiCurrentTime();
+        for (uint64_t i = 0; i < Count; ++i)
+        {
+            found += (map.Find(xpf::HashMix((i * 40503) % Count)) != map.End()) ? 1 : 0;
+        }
+        const uint64_t findEnd = xpf::ApiCurrentTime();
+
+        isCorrect = (Count == map.Size()) && (Count == found) && isCorrect;
+
+        btreeInsert = insertEnd - insertStart;
+        btreeFind = findEnd - findStart;
+    }
+
+    uint64_t treeInsert = 0;
+    uint64_t treeFind = 0;
+    {
+        xpf::RedBlackTree<uint64_t, uint64_t> tree;
+
+        const uint64_t insertStart = xpf::ApiCurrentTime();
+        for (uint64_t i = 0; i < Count; ++i)
+        {
+            uint64_t key = xpf::HashMix(i);
+            uint64_t value = i;
+            isCorrect = NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))) && isCorrect;
+        }
+        const uint64_t insertEnd = xpf::ApiCurrentTime();
+
+        uint64_t found = 0;
+        const uint64_t findStart = xpf::ApiCurrentTime();
+        for (uint64_t i = 0; i < Count; ++i)
+        {
+            found += (tree.Find(xpf::HashMix((i * 40503) % Count)) != tree.End()) ? 1 : 0;
+        }
+        const uint64_t findEnd = xpf::ApiCurrentTime();
+
+        isCorrect = (Count == tree.Size()) && (Count == found) && isCorrect;
+
+        treeInsert = insertEnd - insertStart;
+        treeFind = findEnd - findStart;
+    }
+
+    xpf_test::LogTestInfo("    > %llu keys: BTreeMap insert %llu find %llu, RedBlackTree insert %llu find %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(Count),                                               // NOLINT(*)
+                          static_cast<unsigned long long>(btreeInsert),                                         // NOLINT(*)
+                          static_cast<unsigned long long>(btreeFind),                                           // NOLINT(*)
+                          static_cast<unsigned long long>(treeInsert),                                          // NOLINT(*)
+                          static_cast<unsigned long long>(treeFind));                                           // NOLINT(*)
+    return isCorrect;
+}
+
+/**
+ * @brief       This compares BTreeMap against RedBlackTree at 10K and 200K keys.
+ *              Kept small, as it runs with the rest of the suite - including the kernel mode one.
+ */
+XPF_TEST_SCENARIO(TestBTreeMap, BenchmarkAgainstRedBlackTree)
+{
+    XPF_TEST_EXPECT_TRUE(MockBTreeBenchmarkAgainstRedBlackTree(10000));
+    XPF_TEST_EXPECT_TRUE(MockBTreeBenchmarkAgainstRedBlackTree(200000));
+}
+
+#if defined XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+    /**
+     * @brief       This compares BTreeMap against RedBlackTree at 1M and 10M keys.
+     *              The 10M run needs about 700 MB, so it is only built with XPF_TESTS_ENABLE_LARGE_BENCHMARKS.
+     */
+    XPF_TEST_SCENARIO(TestBTreeMap, LargeBenchmarkAgainstRedBlackTree)
+    {
+        XPF_TEST_EXPECT_TRUE(MockBTreeBenchmarkAgainstRedBlackTree(1000000));
+        XPF_TEST_EXPECT_TRUE(MockBTreeBenchmarkAgainstRedBlackTree(10000000));
+    }
+#endif  // XPF_TESTS_ENABLE_LARGE_BENCHMARKS
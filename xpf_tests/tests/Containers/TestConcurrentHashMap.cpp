@@ -0,0 +1,423 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestConcurrentHashMap.cpp
+ *
+ * @brief       This contains tests for ConcurrentHashMap.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief The map type shared by the worker threads.
+ */
+using MockConcurrentMap = xpf::ConcurrentHashMap<uint64_t, uint64_t>;
+
+/**
+ * @brief       The context given to each worker thread.
+ */
+struct MockConcurrentHashMapContext
+{
+    /**
+     * @brief The map under test, or nullptr when the baseline is measured.
+     */
+    MockConcurrentMap* Map = nullptr;
+
+    /**
+     * @brief The baseline - a HashMap behind a single ReadWriteLock.
+     */
+    xpf::HashMap<uint64_t, uint64_t>* LockedMap = nullptr;
+    xpf::ReadWriteLock* Lock = nullptr;
+
+    /**
+     * @brief The keys [FirstKey, FirstKey + KeyCount) belong to this thread.
+     */
+    uint64_t FirstKey = 0;
+    uint64_t KeyCount = 0;
+
+    /**
+     * @brief The number of lookups done by the benchmark.
+     */
+    uint64_t Lookups = 0;
+
+    /**
+     * @brief Set when a thread observed something it should not have.
+     */
+    bool Failed = false;
+};
+
+/**
+ * @brief       Each thread inserts, updates, looks up and erases its own keys,
+ *              while the other threads do the same on theirs - in the same shards.
+ *
+ * @param[in] Context - A pointer to a MockConcurrentHashMapContext.
+ */
+static void XPF_API
+MockConcurrentHashMapWorker(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockConcurrentHashMapContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+    MockConcurrentMap& map = *context->Map;
+
+    for (uint64_t round = 0; round < 3; ++round)
+    {
+        for (uint64_t i = 0; i < context->KeyCount; ++i)
+        {
+            uint64_t key = context->FirstKey + i;
+            uint64_t value = key;
+            context->Failed |= !NT_SUCCESS(map.Insert(xpf::Move(key), xpf::Move(value)));
+        }
+        for (uint64_t i = 0; i < context->KeyCount; ++i)
+        {
+            uint64_t key = context->FirstKey + i;
+            uint64_t value = key * 3;
+            context->Failed |= !NT_SUCCESS(map.InsertOrUpdate(xpf::Move(key), xpf::Move(value)));
+        }
+        for (uint64_t i = 0; i < context->KeyCount; ++i)
+        {
+            const uint64_t key = context->FirstKey + i;
+            uint64_t found = 0;
+            context->Failed |= !NT_SUCCESS(map.Find(key, [&found](const uint64_t& Value) { found = Value; }));
+            context->Failed |= (found != key * 3);
+        }
+
+        //
+        // The last round leaves the keys in place, for the final check.
+        //
+        if (round < 2)
+        {
+            for (uint64_t i = 0; i < context->KeyCount; ++i)
+            {
+                context->Failed |= !NT_SUCCESS(map.Erase(context->FirstKey + i));
+            }
+        }
+    }
+}
+
+/**
+ * @brief       Looks up random keys, and updates one of them every 16 lookups.
+ *              Works on the ConcurrentHashMap or on the locked HashMap baseline.
+ *
+ * @param[in] Context - A pointer to a MockConcurrentHashMapContext.
+ */
+static void XPF_API
+MockConcurrentHashMapLookupWorker(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockConcurrentHashMapContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < context->Lookups; ++i)
+    {
+        uint64_t key = xpf::HashMix(context->FirstKey + i) % context->KeyCount;
+        uint64_t value = i;
+        const bool isUpdate = (0 == (i % 16));
+
+        if (nullptr != context->Map)
+        {
+            if (isUpdate)
+            {
+                context->Failed |= !NT_SUCCESS(context->Map->InsertOrUpdate(xpf::Move(key), xpf::Move(value)));
+            }
+            else
+            {
+                hits += context->Map->Contains(key) ? 1 : 0;
+            }
+        }
+        else if (isUpdate)
+        {
+            xpf::ExclusiveLockGuard guard{ *context->Lock };
+            context->Failed |= !NT_SUCCESS(context->LockedMap->Emplace(xpf::Move(key), xpf::Move(value)));
+        }
+        else
+        {
+            xpf::SharedLockGuard guard{ *context->Lock };
+            hits += (context->LockedMap->Find(key) != context->LockedMap->End()) ? 1 : 0;
+        }
+    }
+
+    //
+    // All the keys were inserted upfront.
+    //
+    context->Failed |= (hits != context->Lookups - ((context->Lookups + 15) / 16));
+}
+
+/**
+ * @brief       This tests the single-threaded behavior: insert, upsert, find, erase,
+ *              the iteration and Clear.
+ */
+XPF_TEST_SCENARIO(TestConcurrentHashMap, SingleThreaded)
+{
+    MockConcurrentMap map;
+
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(!map.Contains(1));
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == map.Erase(1));
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == map.Find(1, [](const uint64_t&) {}));
+
+    for (uint64_t i = 0; i < 10000; ++i)
+    {
+        uint64_t key = i;
+        uint64_t value = i + 1;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Insert(xpf::Move(key), xpf::Move(value))));
+    }
+    XPF_TEST_EXPECT_TRUE(10000 == map.Size());
+
+    //
+    // Insert does not replace, InsertOrUpdate does.
+    //
+    uint64_t key = 7;
+    uint64_t value = 100;
+    XPF_TEST_EXPECT_TRUE(STATUS_OBJECT_NAME_COLLISION == map.Insert(xpf::Move(key), xpf::Move(value)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.InsertOrUpdate(xpf::Move(key), xpf::Move(value))));
+    XPF_TEST_EXPECT_TRUE(10000 == map.Size());
+
+    uint64_t found = 0;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Find(7, [&found](const uint64_t& Value) { found = Value; })));
+    XPF_TEST_EXPECT_TRUE(100 == found);
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Find(8, [&found](const uint64_t& Value) { found = Value; })));
+    XPF_TEST_EXPECT_TRUE(9 == found);
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(7)));
+    XPF_TEST_EXPECT_TRUE(!map.Contains(7));
+    XPF_TEST_EXPECT_TRUE(9999 == map.Size());
+
+    //
+    // Every element is visited once, in the shard its hash selects.
+    //
+    size_t visited = 0;
+    uint64_t keySum = 0;
+    for (size_t shard = 0; shard < MockConcurrentMap::SHARD_COUNT; ++shard)
+    {
+        size_t inShard = 0;
+        map.ForEachInShard(shard, [&](const uint64_t& Key, const uint64_t&)
+                                  {
+                                      inShard += (map.ShardIndexOf(Key) == shard) ? 1 : 0;
+                                      visited++;
+                                  });
+
+        //
+        // The keys spread over the shards - none is empty, none holds twice its share.
+        //
+        XPF_TEST_EXPECT_TRUE(inShard > 0);
+        XPF_TEST_EXPECT_TRUE(inShard < 2 * (9999 / MockConcurrentMap::SHARD_COUNT));
+    }
+    XPF_TEST_EXPECT_TRUE(9999 == visited);
+
+    map.ForEach([&keySum](const uint64_t& Key, const uint64_t&) { keySum += Key; });
+    XPF_TEST_EXPECT_TRUE((9999 * 10000 / 2) - 7 == keySum);
+
+    map.Clear();
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Reserve(50000)));
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+}
+
+/**
+ * @brief The number of times MockConcurrentCountingHash was called.
+ */
+static volatile uint32_t gMockConcurrentHashCalls = 0;
+
+/**
+ * @brief       A hasher which counts how many times it is called.
+ */
+struct MockConcurrentCountingHash
+{
+    /**
+     * @brief       Hashes the key and counts the call.
+     *
+     * @param[in]   KeyToHash - The key to be hashed.
+     *
+     * @return      The hash of the key.
+     */
+    uint64_t
+    operator()(
+        _In_ _Const_ const uint64_t& KeyToHash
+    ) const noexcept(true)
+    {
+        xpf::ApiAtomicIncrement(&gMockConcurrentHashCalls);
+        return xpf::HashMix(KeyToHash);
+    }
+};  // struct MockConcurrentCountingHash
+
+/**
+ * @brief       This tests that each operation hashes the key only once -
+ *              the shard and the table inside it use the same hash.
+ */
+XPF_TEST_SCENARIO(TestConcurrentHashMap, HashesTheKeyOnce)
+{
+    xpf::ConcurrentHashMap<uint64_t, uint64_t, MockConcurrentCountingHash> map;
+    gMockConcurrentHashCalls = 0;
+
+    uint64_t key = 42;
+    uint64_t value = 1;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Insert(xpf::Move(key), xpf::Move(value))));
+    XPF_TEST_EXPECT_TRUE(1 == gMockConcurrentHashCalls);
+
+    key = 42;
+    value = 2;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.InsertOrUpdate(xpf::Move(key), xpf::Move(value))));
+    XPF_TEST_EXPECT_TRUE(2 == gMockConcurrentHashCalls);
+
+    XPF_TEST_EXPECT_TRUE(map.Contains(42));
+    XPF_TEST_EXPECT_TRUE(3 == gMockConcurrentHashCalls);
+
+    uint64_t found = 0;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Find(42, [&found](const uint64_t& Value) { found = Value; })));
+    XPF_TEST_EXPECT_TRUE(2 == found);
+    XPF_TEST_EXPECT_TRUE(4 == gMockConcurrentHashCalls);
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(42)));
+    XPF_TEST_EXPECT_TRUE(5 == gMockConcurrentHashCalls);
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+}
+
+/**
+ * @brief       This tests several threads inserting, updating and erasing at once.
+ */
+XPF_TEST_SCENARIO(TestConcurrentHashMap, ConcurrentUpdates)
+{
+    MockConcurrentMap map;
+    xpf::thread::Thread threads[8];
+    MockConcurrentHashMapContext contexts[8];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        contexts[i].Map = &map;
+        contexts[i].FirstKey = i * 5000;
+        contexts[i].KeyCount = 5000;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockConcurrentHashMapWorker, &contexts[i])));
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+        XPF_TEST_EXPECT_TRUE(!contexts[i].Failed);
+    }
+
+    XPF_TEST_EXPECT_TRUE(8 * 5000 == map.Size());
+
+    bool allUpdated = true;
+    map.ForEach([&allUpdated](const uint64_t& Key, const uint64_t& Value) { allUpdated &= (Value == Key * 3); });
+    XPF_TEST_EXPECT_TRUE(allUpdated);
+}
+
+/**
+ * @brief       Compares a read-mostly workload (1 update every 16 operations) on the
+ *              ConcurrentHashMap against a HashMap behind one ReadWriteLock, and logs the timings.
+ *
+ * @param[in]   KeyCount - The number of keys in both maps.
+ *
+ * @param[in]   LookupsPerThread - The number of operations done by each thread.
+ *
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+static void XPF_API
+MockConcurrentHashMapBenchmarkAgainstLockedHashMap(
+    _In_ uint64_t KeyCount,
+    _In_ uint64_t LookupsPerThread,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    bool isCorrect = true;
+
+    MockConcurrentMap map;
+    xpf::HashMap<uint64_t, uint64_t> lockedMap;
+    xpf::Optional<xpf::ReadWriteLock> lock;
+    if (!NT_SUCCESS(xpf::ReadWriteLock::Create(&lock)))
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+        return;
+    }
+
+    for (uint64_t i = 0; i < KeyCount; ++i)
+    {
+        uint64_t k1 = i;
+        uint64_t v1 = i;
+        uint64_t k2 = i;
+        uint64_t v2 = i;
+        isCorrect = NT_SUCCESS(map.Insert(xpf::Move(k1), xpf::Move(v1))) && isCorrect;
+        isCorrect = NT_SUCCESS(lockedMap.Emplace(xpf::Move(k2), xpf::Move(v2))) && isCorrect;
+    }
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+        return;
+    }
+
+    const size_t threadCounts[] = { 1, 4, 8 };
+    for (size_t t = 0; t < XPF_ARRAYSIZE(threadCounts); ++t)
+    {
+        uint64_t durations[2] = { 0 };
+        for (size_t pass = 0; pass < 2; ++pass)
+        {
+            xpf::thread::Thread threads[8];
+            MockConcurrentHashMapContext contexts[8];
+
+            const uint64_t start = xpf::ApiCurrentTime();
+            for (size_t i = 0; i < threadCounts[t]; ++i)
+            {
+                contexts[i].Map = (0 == pass) ? &map : nullptr;
+                contexts[i].LockedMap = &lockedMap;
+                contexts[i].Lock = &(*lock);
+                contexts[i].FirstKey = i * LookupsPerThread;
+                contexts[i].KeyCount = KeyCount;
+                contexts[i].Lookups = LookupsPerThread;
+                isCorrect = NT_SUCCESS(threads[i].Run(MockConcurrentHashMapLookupWorker, &contexts[i])) && isCorrect;
+            }
+            for (size_t i = 0; i < threadCounts[t]; ++i)
+            {
+                threads[i].Join();
+                isCorrect = !contexts[i].Failed && isCorrect;
+            }
+            durations[pass] = xpf::ApiCurrentTime() - start;
+        }
+
+        xpf_test::LogTestInfo("    > %llu threads x %llu operations: ConcurrentHashMap %llu, locked HashMap %llu (100 ns) \r\n",
+                              static_cast<unsigned long long>(threadCounts[t]),                                 // NOLINT(*)
+                              static_cast<unsigned long long>(LookupsPerThread),                                // NOLINT(*)
+                              static_cast<unsigned long long>(durations[0]),                                    // NOLINT(*)
+                              static_cast<unsigned long long>(durations[1]));                                   // NOLINT(*)
+    }
+
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+    }
+}
+
+/**
+ * @brief       This compares the ConcurrentHashMap against a locked HashMap,
+ *              at 20K keys and 100K operations per thread.
+ */
+XPF_TEST_SCENARIO(TestConcurrentHashMap, BenchmarkAgainstLockedHashMap)
+{
+    MockConcurrentHashMapBenchmarkAgainstLockedHashMap(20000, 100000, _XpfArgScenario);
+}
+
+#if defined XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+    /**
+     * @brief       The same comparison at 100K keys and 500K operations per thread.
+     *              Only built with XPF_TESTS_ENABLE_LARGE_BENCHMARKS.
+     */
+    XPF_TEST_SCENARIO(TestConcurrentHashMap, LargeBenchmarkAgainstLockedHashMap)
+    {
+        MockConcurrentHashMapBenchmarkAgainstLockedHashMap(100000, 500000, _XpfArgScenario);
+    }
+#endif  // XPF_TESTS_ENABLE_LARGE_BENCHMARKS
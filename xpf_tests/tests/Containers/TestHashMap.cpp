@@ -0,0 +1,432 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestHashMap.cpp
+ *
+ * @brief       This contains tests for HashTable, HashMap, and HashSet.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Allocates memory while the budget allows it.
+ *
+ * @param[in] Context - A pointer to a size_t budget - the number of allowed allocations.
+ *
+ * @param[in] BlockSize - The size of the block.
+ *
+ * @return The allocated block, or nullptr if the budget is exhausted.
+ */
+static void*
+MockHashMapAllocate(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    size_t* budget = static_cast<size_t*>(Context);
+    if (0 == *budget)
+    {
+        return nullptr;
+    }
+    (*budget)--;
+    return xpf::MemoryAllocator::AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief       Frees memory allocated with MockHashMapAllocate.
+ *
+ * @param[in] Context - A pointer to a size_t budget. Unused.
+ *
+ * @param[in,out] MemoryBlock - The block to be freed.
+ */
+static void
+MockHashMapFree(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+    xpf::MemoryAllocator::FreeMemory(MemoryBlock);
+}
+
+/**
+ * @brief A hasher which sends every key on the same probe sequence
+ *        with the same metadata byte - the worst case for the table.
+ */
+struct MockHashMapCollidingHash
+{
+    /**
+     * @brief       Hashes a key.
+     *
+     * @param[in]   KeyToHash - The key to be hashed. Unused.
+     *
+     * @return The same hash for every key.
+     */
+    inline uint64_t
+    operator()(
+        _In_ _Const_ const uint64_t& KeyToHash
+    ) const noexcept(true)
+    {
+        XPF_UNREFERENCED_PARAMETER(KeyToHash);
+        return 0x2A;
+    }
+};  // struct MockHashMapCollidingHash
+
+/**
+ * @brief       Generates the next pseudorandom number.
+ *
+ * @param[in,out] State - The generator state. Must not be 0.
+ *
+ * @return The next pseudorandom number.
+ */
+static uint64_t XPF_API
+MockHashMapNext(
+    _Inout_ uint64_t* State
+) noexcept(true)
+{
+    *State ^= *State << 13;
+    *State ^= *State >> 7;
+    *State ^= *State << 17;
+    return *State;
+}
+
+/**
+ * @brief       This tests the insertion, the upsert and the find.
+ */
+XPF_TEST_SCENARIO(TestHashMap, EmplaceAndFind)
+{
+    xpf::HashMap<uint64_t, uint64_t> map;
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(map.Find(5) == map.End());
+    XPF_TEST_EXPECT_TRUE(map.Begin() == map.End());
+
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ i }, uint64_t{ i * 10 })));
+    }
+    XPF_TEST_EXPECT_TRUE(1000 == map.Size());
+
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        auto it = map.Find(i);
+        XPF_TEST_EXPECT_TRUE(it != map.End());
+        XPF_TEST_EXPECT_TRUE(i == it.GetKey());
+        XPF_TEST_EXPECT_TRUE(i * 10 == it.GetValue());
+    }
+    XPF_TEST_EXPECT_TRUE(map.Find(1000) == map.End());
+
+    //
+    // Emplace on an existing key only updates the value.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ 7 }, uint64_t{ 77 })));
+    XPF_TEST_EXPECT_TRUE(1000 == map.Size());
+    XPF_TEST_EXPECT_TRUE(77 == map.Find(7).GetValue());
+
+    map.Find(8).GetValue() = 88;
+    XPF_TEST_EXPECT_TRUE(88 == map.Find(8).GetValue());
+
+    //
+    // Every element is visited exactly once.
+    //
+    uint64_t keySum = 0;
+    size_t count = 0;
+    for (auto it = map.Begin(); it != map.End(); ++it)
+    {
+        keySum += it.GetKey();
+        count++;
+    }
+    XPF_TEST_EXPECT_TRUE(1000 == count);
+    XPF_TEST_EXPECT_TRUE((999 * 1000) / 2 == keySum);
+
+    map.Clear();
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(map.Begin() == map.End());
+}
+
+/**
+ * @brief       This tests the erase and the reuse of the erased slots.
+ */
+XPF_TEST_SCENARIO(TestHashMap, EraseAndChurn)
+{
+    xpf::HashMap<uint64_t, uint64_t> map;
+
+    for (uint64_t i = 0; i < 500; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ i }, uint64_t{ i })));
+    }
+    for (uint64_t i = 0; i < 500; i += 2)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == map.Erase(0));
+    XPF_TEST_EXPECT_TRUE(250 == map.Size());
+
+    for (uint64_t i = 0; i < 500; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE((0 == (i % 2)) == (map.Find(i) == map.End()));
+    }
+
+    //
+    // A long insert / erase churn with a bounded number of live keys must not
+    // grow the table - the tombstones are dropped by same-size rehashes.
+    //
+    xpf::HashTable<uint64_t, uint64_t> table;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint64_t window[64] = { 0 };
+
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        const size_t position = i % XPF_ARRAYSIZE(window);
+        if (0 != window[position])
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(table.Erase(window[position])));
+        }
+        window[position] = MockHashMapNext(&state);
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(table.Emplace(uint64_t{ window[position] }, uint64_t{ i })));
+    }
+    XPF_TEST_EXPECT_TRUE(64 == table.Size());
+    XPF_TEST_EXPECT_TRUE(table.Capacity() <= 256);
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(window); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(table.Find(window[i]) != table.End());
+    }
+}
+
+/**
+ * @brief       This tests the HashTable overloads which take a hash the caller
+ *              already computed - they must agree with the ones which hash the key.
+ */
+XPF_TEST_SCENARIO(TestHashMap, PrecomputedHash)
+{
+    xpf::HashTable<uint64_t, uint64_t> table;
+    const xpf::DefaultHash<uint64_t> hasher;
+
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(table.Emplace(uint64_t{ i }, uint64_t{ i + 1 }, hasher(i))));
+    }
+    XPF_TEST_EXPECT_TRUE(1000 == table.Size());
+
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        auto it = table.Find(i, hasher(i));
+        XPF_TEST_EXPECT_TRUE(it != table.End());
+        XPF_TEST_EXPECT_TRUE(i + 1 == it.GetValue());
+        XPF_TEST_EXPECT_TRUE(table.Find(i) == it);
+    }
+
+    for (uint64_t i = 0; i < 1000; i += 2)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(table.Erase(i, hasher(i))));
+        XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == table.Erase(i, hasher(i)));
+        XPF_TEST_EXPECT_TRUE(table.Find(i) == table.End());
+    }
+    XPF_TEST_EXPECT_TRUE(500 == table.Size());
+}
+
+/**
+ * @brief       This tests a hasher which makes every key collide.
+ */
+XPF_TEST_SCENARIO(TestHashMap, Collisions)
+{
+    xpf::HashMap<uint64_t, uint64_t, MockHashMapCollidingHash> map;
+
+    for (uint64_t i = 0; i < 200; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ i }, uint64_t{ i + 1 })));
+    }
+    for (uint64_t i = 0; i < 200; i += 3)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(i)));
+    }
+    for (uint64_t i = 0; i < 200; ++i)
+    {
+        auto it = map.Find(i);
+        if (0 == (i % 3))
+        {
+            XPF_TEST_EXPECT_TRUE(it == map.End());
+        }
+        else
+        {
+            XPF_TEST_EXPECT_TRUE(it != map.End());
+            XPF_TEST_EXPECT_TRUE(i + 1 == it.GetValue());
+        }
+    }
+}
+
+/**
+ * @brief       This tests keys and values which own memory.
+ */
+XPF_TEST_SCENARIO(TestHashMap, StringKeys)
+{
+    xpf::HashMap<xpf::String<char>, xpf::String<wchar_t>> map;
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        const char key[] = { static_cast<char>('a' + (i % 26)),
+                             static_cast<char>('a' + ((i / 26) % 26)),
+                             '\0' };
+
+        xpf::String<char> keyString;
+        xpf::String<wchar_t> valueString;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(keyString.Append(key)));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(valueString.Append(L"value")));
+
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(keyString), xpf::Move(valueString))));
+    }
+    XPF_TEST_EXPECT_TRUE(300 == map.Size());
+
+    xpf::String<char> lookup;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(lookup.Append("cb")));
+    auto it = map.Find(lookup);
+    XPF_TEST_EXPECT_TRUE(it != map.End());
+    XPF_TEST_EXPECT_TRUE(it.GetValue().View().Equals(L"value", true));
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(lookup)));
+    XPF_TEST_EXPECT_TRUE(map.Find(lookup) == map.End());
+
+    //
+    // Moving the map moves the ownership of the table.
+    //
+    xpf::HashMap<xpf::String<char>, xpf::String<wchar_t>> other{ xpf::Move(map) };
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(299 == other.Size());
+
+    map = xpf::Move(other);
+    XPF_TEST_EXPECT_TRUE(other.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(299 == map.Size());
+}
+
+/**
+ * @brief       This tests the hash set.
+ */
+XPF_TEST_SCENARIO(TestHashMap, HashSet)
+{
+    xpf::HashSet<uint32_t> set;
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(set.Insert(uint32_t{ i % 50 })));
+    }
+    XPF_TEST_EXPECT_TRUE(50 == set.Size());
+    XPF_TEST_EXPECT_TRUE(set.Contains(49));
+    XPF_TEST_EXPECT_TRUE(!set.Contains(50));
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(set.Erase(49)));
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == set.Erase(49));
+    XPF_TEST_EXPECT_TRUE(!set.Contains(49));
+
+    size_t count = 0;
+    for (auto it = set.Begin(); it != set.End(); ++it)
+    {
+        XPF_TEST_EXPECT_TRUE(it.GetKey() < 49);
+        count++;
+    }
+    XPF_TEST_EXPECT_TRUE(49 == count);
+}
+
+/**
+ * @brief       This tests Reserve and the allocation failures.
+ */
+XPF_TEST_SCENARIO(TestHashMap, ReserveAndAllocationFailure)
+{
+    size_t budget = 1;
+
+    xpf::PolymorphicAllocator allocator;
+    allocator.Context = &budget;
+    allocator.ContextAllocFunction = &MockHashMapAllocate;
+    allocator.ContextFreeFunction = &MockHashMapFree;
+
+    xpf::HashMap<uint64_t, uint64_t> map{ allocator };
+
+    //
+    // A single allocation holds 1000 elements.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Reserve(1000)));
+    XPF_TEST_EXPECT_TRUE(0 == budget);
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ i }, uint64_t{ i })));
+    }
+
+    //
+    // Growing fails, the table stays as it was.
+    //
+    NTSTATUS status = STATUS_SUCCESS;
+    uint64_t key = 1000;
+    while (NT_SUCCESS(status))
+    {
+        status = map.Emplace(uint64_t{ key }, uint64_t{ key });
+        key++;
+    }
+    XPF_TEST_EXPECT_TRUE(STATUS_INSUFFICIENT_RESOURCES == status);
+    XPF_TEST_EXPECT_TRUE(key - 1 == map.Size());
+    XPF_TEST_EXPECT_TRUE(map.Find(key - 1) == map.End());
+    for (uint64_t i = 0; i < key - 1; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i == map.Find(i).GetValue());
+    }
+
+    //
+    // Updating an existing key never allocates.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ 5 }, uint64_t{ 55 })));
+    XPF_TEST_EXPECT_TRUE(55 == map.Find(5).GetValue());
+
+    budget = 1;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(uint64_t{ key }, uint64_t{ key })));
+    XPF_TEST_EXPECT_TRUE(key == map.Size());
+}
+
+/**
+ * @brief       This compares the lookups in HashMap and in the red-black tree Map.
+ */
+XPF_TEST_SCENARIO(TestHashMap, Benchmark)
+{
+    constexpr size_t count = 200000;
+
+    xpf::HashMap<uint64_t, uint64_t> hashMap;
+    xpf::Map<uint64_t, uint64_t> treeMap;
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint64_t key = MockHashMapNext(&state);
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(hashMap.Emplace(uint64_t{ key }, uint64_t{ i })));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(treeMap.Emplace(uint64_t{ key }, uint64_t{ i })));
+    }
+
+    uint64_t hashSum = 0;
+    state = 0x9E3779B97F4A7C15ull;
+    const uint64_t hashStart = xpf::ApiCurrentTime();
+    for (size_t i = 0; i < count; ++i)
+    {
+        hashSum += hashMap.Find(MockHashMapNext(&state)).GetValue();
+    }
+    const uint64_t hashEnd = xpf::ApiCurrentTime();
+
+    uint64_t treeSum = 0;
+    state = 0x9E3779B97F4A7C15ull;
+    const uint64_t treeStart = xpf::ApiCurrentTime();
+    for (size_t i = 0; i < count; ++i)
+    {
+        treeSum += treeMap.Find(MockHashMapNext(&state)).GetValue();
+    }
+    const uint64_t treeEnd = xpf::ApiCurrentTime();
+
+    XPF_TEST_EXPECT_TRUE(hashSum == treeSum);
+    XPF_TEST_EXPECT_TRUE(((count - 1) * count) / 2 == hashSum);
+
+    xpf_test::LogTestInfo("    > %llu lookups: HashMap %llu (100 ns), Map %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(count),                                           // NOLINT(*)
+                          static_cast<unsigned long long>(hashEnd - hashStart),                             // NOLINT(*)
+                          static_cast<unsigned long long>(treeEnd - treeStart));                            // NOLINT(*)
+}
@@ -0,0 +1,344 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestIntervalTree.cpp
+ *
+ * @brief       This contains tests for IntervalTree.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Validates that every node knows the largest interval end of its subtree.
+ *
+ * @param[in]   Tree     - The IntervalTree to validate.
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+template <class Bound, class Value>
+static void
+ValidateMaxHigh(
+    _In_ _Const_ const xpf::IntervalTree<Bound, Value>& Tree,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    using Node = typename xpf::IntervalTree<Bound, Value>::Node;
+
+    xpf::Vector<const Node*> stack;
+    if ((nullptr != Tree.Root()) && !NT_SUCCESS(stack.Emplace(Tree.Root())))
+    {
+        (*Scenario) = STATUS_INSUFFICIENT_RESOURCES;
+        return;
+    }
+
+    while (!stack.IsEmpty())
+    {
+        const Node* node = stack[stack.Size() - 1];
+        if (!NT_SUCCESS(stack.Erase(stack.Size() - 1)))
+        {
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+
+        Bound expected = node->NodeKey.High;
+        const Node* children[] = { node->Left, node->Right };
+        for (const Node* child : children)
+        {
+            if (nullptr == child)
+            {
+                continue;
+            }
+            if (expected < child->MaxHigh)
+            {
+                expected = child->MaxHigh;
+            }
+            if (!NT_SUCCESS(stack.Emplace(child)))
+            {
+                (*Scenario) = STATUS_INSUFFICIENT_RESOURCES;
+                return;
+            }
+        }
+
+        if ((expected < node->MaxHigh) || (node->MaxHigh < expected))
+        {
+            xpf_test::LogTestInfo("    [!] IntervalTree Violation: stale subtree end.\r\n");
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief       This tests the empty tree and the rejected intervals.
+ */
+XPF_TEST_SCENARIO(TestIntervalTree, DefaultConstructor)
+{
+    xpf::IntervalTree<int, int> tree;
+    size_t visited = 0;
+
+    XPF_TEST_EXPECT_TRUE(tree.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(0 == tree.Size());
+    XPF_TEST_EXPECT_TRUE(tree.Begin() == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.FindContaining(5) == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.FindOverlapping(0, 10) == tree.End());
+    tree.ForEachContaining(5, [&](const xpf::IntervalTreeKey<int>&, int&) { visited++; });
+    XPF_TEST_EXPECT_TRUE(0 == visited);
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == tree.Erase(0, 10));
+
+    //
+    // Empty and reversed intervals are rejected.
+    //
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == tree.Emplace(5, 5, 1));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == tree.Emplace(7, 3, 1));
+    XPF_TEST_EXPECT_TRUE(tree.IsEmpty());
+}
+
+/**
+ * @brief       This tests the half-open bounds and the duplicated starts.
+ */
+XPF_TEST_SCENARIO(TestIntervalTree, HalfOpenBounds)
+{
+    xpf::IntervalTree<int, int> tree;
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(10, 20, 1)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(20, 30, 2)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(10, 40, 3)));
+    XPF_TEST_EXPECT_TRUE(3 == tree.Size());
+    ValidateMaxHigh(tree, _XpfArgScenario);
+
+    //
+    // The start belongs to the interval, the end does not.
+    //
+    XPF_TEST_EXPECT_TRUE(tree.FindContaining(9) == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.FindContaining(40) == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.FindContaining(35).GetValue() == 3);
+    XPF_TEST_EXPECT_TRUE(tree.FindOverlapping(0, 10) == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.FindOverlapping(40, 50) == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.FindOverlapping(39, 50).GetValue() == 3);
+    XPF_TEST_EXPECT_TRUE(tree.FindOverlapping(15, 15) == tree.End());
+
+    int found[3] = { 0 };
+    size_t count = 0;
+    tree.ForEachContaining(20, [&](const xpf::IntervalTreeKey<int>&, int& Value)
+                               {
+                                   found[count++] = Value;
+                               });
+    XPF_TEST_EXPECT_TRUE(2 == count);
+    XPF_TEST_EXPECT_TRUE(3 == found[0]);
+    XPF_TEST_EXPECT_TRUE(2 == found[1]);
+
+    count = 0;
+    tree.ForEachOverlapping(19, 21, [&](const xpf::IntervalTreeKey<int>&, int& Value)
+                                    {
+                                        found[count++] = Value;
+                                    });
+    XPF_TEST_EXPECT_TRUE(3 == count);
+    XPF_TEST_EXPECT_TRUE(1 == found[0]);
+    XPF_TEST_EXPECT_TRUE(3 == found[1]);
+    XPF_TEST_EXPECT_TRUE(2 == found[2]);
+
+    //
+    // The same bounds update the value.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(10, 20, 7)));
+    XPF_TEST_EXPECT_TRUE(3 == tree.Size());
+    XPF_TEST_EXPECT_TRUE(7 == tree.Find(10, 20).GetValue());
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Erase(10, 40)));
+    XPF_TEST_EXPECT_TRUE(tree.FindContaining(35) == tree.End());
+    ValidateMaxHigh(tree, _XpfArgScenario);
+}
+
+/**
+ * @brief       This tests random inserts, erases and queries against a linear scan.
+ */
+XPF_TEST_SCENARIO(TestIntervalTree, ChurnAgainstLinearScan)
+{
+    struct Entry
+    {
+        int Low = 0;
+        int High = 0;
+        bool Present = false;
+    };
+
+    xpf::IntervalTree<int, int> tree;
+    Entry entries[400];
+
+    uint32_t state = 0x13579BDF;
+    auto next = [&state]()
+                {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+                    return state;
+                };
+
+    //
+    // Entry i is always [low, low + length) for the same low, so the
+    // reference knows each interval by its index.
+    //
+    for (int i = 0; i < 400; ++i)
+    {
+        entries[i].Low = static_cast<int>((static_cast<uint32_t>(i) * 2654435761u) % 10000);
+        entries[i].High = entries[i].Low + 1 + static_cast<int>(next() % 300);
+    }
+
+    for (size_t step = 0; step < 20000; ++step)
+    {
+        Entry& entry = entries[next() % 400];
+        if (0 != (next() & 1))
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(entry.Low, entry.High, int{ entry.Low })));
+            entry.Present = true;
+        }
+        else
+        {
+            const NTSTATUS expected = entry.Present ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+            XPF_TEST_EXPECT_TRUE(expected == tree.Erase(entry.Low, entry.High));
+            entry.Present = false;
+        }
+
+        if (0 != (step % 500))
+        {
+            continue;
+        }
+        ValidateMaxHigh(tree, _XpfArgScenario);
+
+        for (size_t query = 0; query < 50; ++query)
+        {
+            const int low = static_cast<int>(next() % 10400) - 200;
+            const int high = low + 1 + static_cast<int>(next() % 500);
+
+            size_t expectedContaining = 0;
+            size_t expectedOverlapping = 0;
+            for (size_t i = 0; i < XPF_ARRAYSIZE(entries); ++i)
+            {
+                if (!entries[i].Present)
+                {
+                    continue;
+                }
+                expectedContaining += (entries[i].Low <= low && low < entries[i].High) ? 1 : 0;
+                expectedOverlapping += (entries[i].Low < high && low < entries[i].High) ? 1 : 0;
+            }
+
+            size_t containing = 0;
+            tree.ForEachContaining(low, [&](const xpf::IntervalTreeKey<int>& Interval, int&)
+                                        {
+                                            containing += (Interval.Low <= low && low < Interval.High) ? 1 : 0;
+                                        });
+            size_t overlapping = 0;
+            const xpf::IntervalTreeKey<int>* previous = nullptr;
+            bool sorted = true;
+            tree.ForEachOverlapping(low, high, [&](const xpf::IntervalTreeKey<int>& Interval, int&)
+                                               {
+                                                   overlapping += (Interval.Low < high && low < Interval.High) ? 1 : 0;
+                                                   if ((nullptr != previous) && !(previous->Low <= Interval.Low))
+                                                   {
+                                                       sorted = false;
+                                                   }
+                                                   previous = xpf::AddressOf(Interval);
+                                               });
+
+            XPF_TEST_EXPECT_TRUE(expectedContaining == containing);
+            XPF_TEST_EXPECT_TRUE(expectedOverlapping == overlapping);
+            XPF_TEST_EXPECT_TRUE(sorted);
+            XPF_TEST_EXPECT_TRUE((0 == expectedContaining) == (tree.FindContaining(low) == tree.End()));
+            XPF_TEST_EXPECT_TRUE((0 == expectedOverlapping) == (tree.FindOverlapping(low, high) == tree.End()));
+        }
+    }
+}
+
+/**
+ * @brief       Compares the stabbing query against a linear scan of the same intervals, and logs the timings.
+ *              Many short intervals, so each point lies in only a few of them.
+ *
+ * @param[in]   Count - The number of intervals.
+ *
+ * @param[in]   Queries - The number of points looked up.
+ *
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+static void XPF_API
+MockIntervalTreeBenchmarkAgainstLinearScan(
+    _In_ uint64_t Count,
+    _In_ uint64_t Queries,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    bool isCorrect = true;
+
+    xpf::IntervalTree<uint64_t, uint64_t> tree;
+    xpf::Vector<xpf::IntervalTreeKey<uint64_t>> intervals;
+
+    for (uint64_t i = 0; i < Count; ++i)
+    {
+        const uint64_t low = xpf::HashMix(i) % (Count * 100);
+        const uint64_t high = low + 1 + (i % 250);
+
+        isCorrect = NT_SUCCESS(tree.Emplace(low, high, uint64_t{ i })) && isCorrect;
+        isCorrect = NT_SUCCESS(intervals.Emplace(xpf::IntervalTreeKey<uint64_t>{ low, high })) && isCorrect;
+    }
+
+    uint64_t treeHits = 0;
+    const uint64_t treeStart = xpf::ApiCurrentTime();
+    for (uint64_t q = 0; q < Queries; ++q)
+    {
+        const uint64_t point = xpf::HashMix(q + Count) % (Count * 100);
+        tree.ForEachContaining(point, [&](const xpf::IntervalTreeKey<uint64_t>&, uint64_t&) { treeHits++; });
+    }
+    const uint64_t treeEnd = xpf::ApiCurrentTime();
+
+    uint64_t scanHits = 0;
+    const uint64_t scanStart = xpf::ApiCurrentTime();
+    for (uint64_t q = 0; q < Queries; ++q)
+    {
+        const uint64_t point = xpf::HashMix(q + Count) % (Count * 100);
+        for (size_t i = 0; i < intervals.Size(); ++i)
+        {
+            scanHits += (intervals[i].Low <= point && point < intervals[i].High) ? 1 : 0;
+        }
+    }
+    const uint64_t scanEnd = xpf::ApiCurrentTime();
+
+    //
+    // Equal bounds are stored once, so the scan may count a duplicate twice.
+    //
+    isCorrect = (treeHits <= scanHits) && isCorrect;
+    isCorrect = (tree.Size() <= intervals.Size()) && isCorrect;
+
+    xpf_test::LogTestInfo("    > %llu intervals, %llu points: IntervalTree %llu, linear scan %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(Count),                                               // NOLINT(*)
+                          static_cast<unsigned long long>(Queries),                                             // NOLINT(*)
+                          static_cast<unsigned long long>(treeEnd - treeStart),                                 // NOLINT(*)
+                          static_cast<unsigned long long>(scanEnd - scanStart));                                // NOLINT(*)
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+    }
+}
+
+/**
+ * @brief       This compares the stabbing query against a linear scan, with 20K intervals and 500 points.
+ *              The scan is quadratic, so the suite keeps it small.
+ */
+XPF_TEST_SCENARIO(TestIntervalTree, BenchmarkAgainstLinearScan)
+{
+    MockIntervalTreeBenchmarkAgainstLinearScan(20000, 500, _XpfArgScenario);
+}
+
+#if defined XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+    /**
+     * @brief       The same comparison with 100K intervals and 2000 points.
+     *              Only built with XPF_TESTS_ENABLE_LARGE_BENCHMARKS.
+     */
+    XPF_TEST_SCENARIO(TestIntervalTree, LargeBenchmarkAgainstLinearScan)
+    {
+        MockIntervalTreeBenchmarkAgainstLinearScan(100000, 2000, _XpfArgScenario);
+    }
+#endif  // XPF_TESTS_ENABLE_LARGE_BENCHMARKS
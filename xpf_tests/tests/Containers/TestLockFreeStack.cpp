@@ -0,0 +1,366 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestLockFreeStack.cpp
+ *
+ * @brief       This contains tests for the lock-free stack.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       This is a mock struct for the lock-free stack.
+ */
+struct MockTestLfsElement
+{
+    /**
+     * @brief The required SINGLE_LIST_ENTRY which will be used
+     *        when inserting the element in the stack. It must be properly aligned.
+     */
+    alignas(XPF_DEFAULT_ALIGNMENT) xpf::XPF_SINGLE_LIST_ENTRY ListEntry = { 0 };
+
+    /**
+     * @brief A dummy value used to validate the order.
+     */
+    uint32_t DummyValue = 0;
+};
+
+/**
+ * @brief       This is a mock callback used for stress testing the lock-free stack.
+ *              The elements are shared between threads, so the same element
+ *              is popped and pushed back by different threads - the ABA scenario.
+ *
+ * @param[in] Context - A pointer to a lock-free stack.
+ */
+static void XPF_API
+MockLfsStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto stack = static_cast<xpf::LockFreeStack*>(Context);
+    if (nullptr != stack)
+    {
+        for (size_t i = 0; i < 100000; ++i)
+        {
+            xpf::XPF_SINGLE_LIST_ENTRY* first = stack->Pop();
+            xpf::XPF_SINGLE_LIST_ENTRY* second = stack->Pop();
+
+            if (nullptr != second)
+            {
+                second->Next = nullptr;
+                stack->Push(second);
+            }
+            if (nullptr != first)
+            {
+                first->Next = nullptr;
+                stack->Push(first);
+            }
+        }
+    }
+}
+
+/**
+ * @brief       The context shared by the threads of the ReclaimStress test.
+ */
+struct MockLfsReclaimContext
+{
+    /**
+     * @brief The stack under test.
+     */
+    xpf::LockFreeStack Stack;
+
+    /**
+     * @brief How many elements were allocated and freed.
+     */
+    xpf::Atomic<uint64_t> Allocated{ 0 };
+    xpf::Atomic<uint64_t> Freed{ 0 };
+};
+
+/**
+ * @brief       Frees a chain of elements given back by Reclaim().
+ *
+ * @param[in,out] Context - The context which counts the freed elements.
+ *
+ * @param[in,out] Chain - The first element of the chain. Can be NULL.
+ */
+static void
+MockLfsFreeChain(
+    _Inout_ MockLfsReclaimContext& Context,
+    _Inout_opt_ xpf::XPF_SINGLE_LIST_ENTRY* Chain
+) noexcept(true)
+{
+    while (nullptr != Chain)
+    {
+        xpf::XPF_SINGLE_LIST_ENTRY* next = Chain->Next;
+        xpf::MemoryAllocator::FreeMemory(Chain);
+        (void) Context.Freed.FetchAdd(1);
+        Chain = next;
+    }
+}
+
+/**
+ * @brief       This is a mock callback which replaces the popped elements with new ones,
+ *              and frees the old ones through Retire() / Reclaim() - while other threads
+ *              might still be reading them in Pop().
+ *
+ * @param[in] Context - A pointer to a MockLfsReclaimContext.
+ */
+static void XPF_API
+MockLfsReclaimCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockLfsReclaimContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        xpf::XPF_SINGLE_LIST_ENTRY* element = context->Stack.Pop();
+        if (nullptr != element)
+        {
+            context->Stack.Retire(element, element);
+        }
+
+        void* memory = xpf::MemoryAllocator::AllocateMemory(sizeof(xpf::XPF_SINGLE_LIST_ENTRY));
+        if (nullptr != memory)
+        {
+            (void) context->Allocated.FetchAdd(1);
+            context->Stack.Push(static_cast<xpf::XPF_SINGLE_LIST_ENTRY*>(memory));
+        }
+
+        if (0 == (i % 64))
+        {
+            MockLfsFreeChain(*context, context->Stack.Reclaim());
+        }
+    }
+}
+
+/**
+ * @brief       This tests the default constructor of the lock-free stack.
+ */
+XPF_TEST_SCENARIO(TestLockFreeStack, DefaultConstructorDestructor)
+{
+    xpf::LockFreeStack stack;
+
+    XPF_TEST_EXPECT_TRUE(stack.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(nullptr == stack.Pop());
+    XPF_TEST_EXPECT_TRUE(nullptr == stack.Flush());
+}
+
+/**
+ * @brief       This tests that the elements are retrieved in LIFO order.
+ */
+XPF_TEST_SCENARIO(TestLockFreeStack, PushPop)
+{
+    xpf::LockFreeStack stack;
+    MockTestLfsElement elements[10];
+
+    for (uint32_t i = 0; i < XPF_ARRAYSIZE(elements); ++i)
+    {
+        elements[i].DummyValue = i;
+        stack.Push(&elements[i].ListEntry);
+        XPF_TEST_EXPECT_TRUE(!stack.IsEmpty());
+    }
+
+    for (uint32_t i = XPF_ARRAYSIZE(elements); i > 0; --i)
+    {
+        xpf::XPF_SINGLE_LIST_ENTRY* entry = stack.Pop();
+        XPF_TEST_EXPECT_TRUE(nullptr != entry);
+
+        auto element = XPF_CONTAINING_RECORD(entry, MockTestLfsElement, ListEntry);
+        XPF_TEST_EXPECT_TRUE(element->DummyValue == i - 1);
+        XPF_TEST_EXPECT_TRUE(nullptr == entry->Next);
+    }
+
+    XPF_TEST_EXPECT_TRUE(stack.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(nullptr == stack.Pop());
+}
+
+/**
+ * @brief       This tests pushing a chain of elements and flushing the stack.
+ */
+XPF_TEST_SCENARIO(TestLockFreeStack, PushListFlush)
+{
+    xpf::LockFreeStack stack;
+    MockTestLfsElement elements[10];
+
+    //
+    // Push the first element alone, then the rest as a chain: 9 -> 8 -> ... -> 1.
+    //
+    stack.Push(&elements[0].ListEntry);
+    for (uint32_t i = 1; i < XPF_ARRAYSIZE(elements); ++i)
+    {
+        elements[i].DummyValue = i;
+        elements[i].ListEntry.Next = (i > 1) ? &elements[i - 1].ListEntry
+                                             : nullptr;
+    }
+    stack.PushList(&elements[9].ListEntry, &elements[1].ListEntry);
+
+    //
+    // Null chains are ignored.
+    //
+    stack.PushList(nullptr, nullptr);
+
+    xpf::XPF_SINGLE_LIST_ENTRY* entry = stack.Flush();
+    XPF_TEST_EXPECT_TRUE(stack.IsEmpty());
+
+    uint32_t expected = XPF_ARRAYSIZE(elements);
+    while (nullptr != entry)
+    {
+        expected--;
+
+        auto element = XPF_CONTAINING_RECORD(entry, MockTestLfsElement, ListEntry);
+        XPF_TEST_EXPECT_TRUE(element->DummyValue == expected);
+
+        entry = entry->Next;
+    }
+    XPF_TEST_EXPECT_TRUE(0 == expected);
+}
+
+/**
+ * @brief       This tests the lock-free stack under multithreaded stress.
+ *              No element should be lost or duplicated.
+ */
+XPF_TEST_SCENARIO(TestLockFreeStack, StressPushPop)
+{
+    xpf::LockFreeStack stack;
+    MockTestLfsElement elements[16];
+    xpf::thread::Thread threads[8];
+
+    for (uint32_t i = 0; i < XPF_ARRAYSIZE(elements); ++i)
+    {
+        elements[i].DummyValue = i;
+        stack.Push(&elements[i].ListEntry);
+    }
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockLfsStressCallback, &stack)));
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    //
+    // Every element must be found exactly once.
+    //
+    bool seen[XPF_ARRAYSIZE(elements)] = { false };
+    size_t count = 0;
+
+    xpf::XPF_SINGLE_LIST_ENTRY* entry = stack.Flush();
+    while (nullptr != entry)
+    {
+        auto element = XPF_CONTAINING_RECORD(entry, MockTestLfsElement, ListEntry);
+        XPF_TEST_EXPECT_TRUE(element->DummyValue < XPF_ARRAYSIZE(elements));
+        XPF_TEST_EXPECT_TRUE(!seen[element->DummyValue]);
+
+        seen[element->DummyValue] = true;
+        count++;
+
+        entry = entry->Next;
+    }
+    XPF_TEST_EXPECT_TRUE(count == XPF_ARRAYSIZE(elements));
+}
+
+/**
+ * @brief       This tests that the retired elements are given back by Reclaim()
+ *              only once - and all at once when no Pop is in progress.
+ */
+XPF_TEST_SCENARIO(TestLockFreeStack, RetireReclaim)
+{
+    xpf::LockFreeStack stack;
+    MockTestLfsElement elements[4];
+
+    XPF_TEST_EXPECT_TRUE(nullptr == stack.Reclaim());
+
+    for (uint32_t i = 0; i < XPF_ARRAYSIZE(elements); ++i)
+    {
+        elements[i].DummyValue = i;
+        stack.Push(&elements[i].ListEntry);
+    }
+
+    //
+    // Retire two single elements and a chain of two.
+    //
+    xpf::XPF_SINGLE_LIST_ENTRY* entry = stack.Pop();
+    XPF_TEST_EXPECT_TRUE(nullptr != entry);
+    stack.Retire(entry, entry);
+
+    entry = stack.Pop();
+    XPF_TEST_EXPECT_TRUE(nullptr != entry);
+    stack.Retire(entry, entry);
+
+    xpf::XPF_SINGLE_LIST_ENTRY* first = stack.Flush();
+    XPF_TEST_EXPECT_TRUE(nullptr != first);
+    XPF_TEST_EXPECT_TRUE(nullptr != first->Next);
+    stack.Retire(first, first->Next);
+    XPF_TEST_EXPECT_TRUE(stack.IsEmpty());
+
+    //
+    // Nobody pops, so everything comes back - each element once.
+    //
+    bool seen[XPF_ARRAYSIZE(elements)] = { false };
+    size_t count = 0;
+
+    entry = stack.Reclaim();
+    while (nullptr != entry)
+    {
+        auto element = XPF_CONTAINING_RECORD(entry, MockTestLfsElement, ListEntry);
+        XPF_TEST_EXPECT_TRUE(element->DummyValue < XPF_ARRAYSIZE(elements));
+        XPF_TEST_EXPECT_TRUE(!seen[element->DummyValue]);
+
+        seen[element->DummyValue] = true;
+        count++;
+
+        entry = entry->Next;
+    }
+    XPF_TEST_EXPECT_TRUE(count == XPF_ARRAYSIZE(elements));
+    XPF_TEST_EXPECT_TRUE(nullptr == stack.Reclaim());
+}
+
+/**
+ * @brief       This tests freeing popped elements while other threads pop from the stack.
+ *              Every element must be freed exactly once.
+ */
+XPF_TEST_SCENARIO(TestLockFreeStack, ReclaimStress)
+{
+    MockLfsReclaimContext context;
+    xpf::thread::Thread threads[4];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockLfsReclaimCallback, &context)));
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    //
+    // The threads are gone - whatever is left can be retired and given back.
+    //
+    xpf::XPF_SINGLE_LIST_ENTRY* first = context.Stack.Flush();
+    if (nullptr != first)
+    {
+        xpf::XPF_SINGLE_LIST_ENTRY* last = first;
+        while (nullptr != last->Next)
+        {
+            last = last->Next;
+        }
+        context.Stack.Retire(first, last);
+    }
+    MockLfsFreeChain(context, context.Stack.Reclaim());
+
+    XPF_TEST_EXPECT_TRUE(context.Allocated.Load() == context.Freed.Load());
+    XPF_TEST_EXPECT_TRUE(nullptr == context.Stack.Reclaim());
+}
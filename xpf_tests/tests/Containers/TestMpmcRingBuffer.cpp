@@ -0,0 +1,533 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestMpmcRingBuffer.cpp
+ *
+ * @brief       This contains tests for MpmcRingBuffer.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief The ring shared by the worker threads. Small, so it is often full and often empty.
+ */
+using MockMpmcRing = xpf::MpmcRingBuffer<uint64_t, 256>;
+
+/**
+ * @brief       The context shared by the producers and the consumers.
+ */
+struct MockMpmcRingBufferContext
+{
+    /**
+     * @brief The ring under test.
+     */
+    MockMpmcRing* Ring = nullptr;
+
+    /**
+     * @brief Each producer pushes the values [Id * ItemsPerThread, (Id + 1) * ItemsPerThread).
+     */
+    xpf::Atomic<uint64_t> NextProducerId{ 0 };
+    uint64_t ItemsPerThread = 0;
+
+    /**
+     * @brief Filled by the consumers - how many times each value was popped,
+     *        and whether each producer's values came out in order.
+     */
+    uint8_t* Seen = nullptr;
+    xpf::Atomic<uint32_t> OutOfOrder{ 0 };
+};
+
+/**
+ * @brief       Pushes ItemsPerThread values with SpinPush.
+ *
+ * @param[in] Context - A pointer to a MockMpmcRingBufferContext.
+ */
+static void XPF_API
+MockMpmcRingBufferProducer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockMpmcRingBufferContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    const uint64_t id = context->NextProducerId.FetchAdd(1);
+    for (uint64_t i = 0; i < context->ItemsPerThread; ++i)
+    {
+        uint64_t value = id * context->ItemsPerThread + i;
+        context->Ring->SpinPush(xpf::Move(value));
+    }
+}
+
+/**
+ * @brief       Pops ItemsPerThread values with SpinPop. The values of one
+ *              producer must come out of one consumer in increasing order.
+ *
+ * @param[in] Context - A pointer to a MockMpmcRingBufferContext.
+ */
+static void XPF_API
+MockMpmcRingBufferConsumer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockMpmcRingBufferContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    uint64_t lastOfProducer[4] = { 0 };
+    bool hasLast[4] = { false };
+
+    for (uint64_t i = 0; i < context->ItemsPerThread; ++i)
+    {
+        uint64_t value = 0;
+        context->Ring->SpinPop(value);
+        (void) xpf::ApiAtomicFetchAdd(&context->Seen[value], uint8_t{ 1 });
+
+        const uint64_t producer = value / context->ItemsPerThread;
+        if (hasLast[producer] && (value <= lastOfProducer[producer]))
+        {
+            (void) context->OutOfOrder.FetchAdd(1);
+        }
+        hasLast[producer] = true;
+        lastOfProducer[producer] = value;
+    }
+}
+
+/**
+ * @brief       An element of the TwoLockQueue baseline - allocated for each value.
+ */
+struct MockMpmcRingBufferTlqElement
+{
+    /**
+     * @brief The value carried by this element.
+     */
+    uint64_t Value = 0;
+
+    /**
+     * @brief The required SINGLE_LIST_ENTRY which links the element in the queue.
+     */
+    xpf::XPF_SINGLE_LIST_ENTRY ListEntry = { 0 };
+};
+
+/**
+ * @brief       The context of the TwoLockQueue baseline.
+ */
+struct MockMpmcRingBufferTlqContext
+{
+    /**
+     * @brief The queue under test.
+     */
+    xpf::TwoLockQueue Queue;
+
+    /**
+     * @brief The number of values each producer pushes and each consumer pops.
+     */
+    uint64_t ItemsPerThread = 0;
+
+    /**
+     * @brief The sum of all popped values.
+     */
+    xpf::Atomic<uint64_t> Sum{ 0 };
+};
+
+/**
+ * @brief       Allocates and pushes ItemsPerThread elements in the TwoLockQueue.
+ *
+ * @param[in] Context - A pointer to a MockMpmcRingBufferTlqContext.
+ */
+static void XPF_API
+MockMpmcRingBufferTlqProducer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockMpmcRingBufferTlqContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    for (uint64_t i = 0; i < context->ItemsPerThread; ++i)
+    {
+        void* memory = xpf::MemoryAllocator::AllocateMemory(sizeof(MockMpmcRingBufferTlqElement));
+        _Analysis_assume_(nullptr != memory);
+        XPF_DEATH_ON_FAILURE(nullptr != memory);
+
+        MockMpmcRingBufferTlqElement* element = static_cast<MockMpmcRingBufferTlqElement*>(memory);
+        xpf::MemoryAllocator::Construct(element);
+        element->Value = i;
+
+        xpf::TlqPush(context->Queue, &element->ListEntry);
+    }
+}
+
+/**
+ * @brief       Pops and frees ItemsPerThread elements from the TwoLockQueue,
+ *              yielding while it is empty.
+ *
+ * @param[in] Context - A pointer to a MockMpmcRingBufferTlqContext.
+ */
+static void XPF_API
+MockMpmcRingBufferTlqConsumer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockMpmcRingBufferTlqContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < context->ItemsPerThread; ++i)
+    {
+        xpf::XPF_SINGLE_LIST_ENTRY* entry = xpf::TlqPop(context->Queue);
+        while (nullptr == entry)
+        {
+            xpf::ApiYieldProcesor();
+            entry = xpf::TlqPop(context->Queue);
+        }
+
+        auto element = XPF_CONTAINING_RECORD(entry, MockMpmcRingBufferTlqElement, ListEntry);
+        sum += element->Value;
+
+        xpf::MemoryAllocator::Destruct(element);
+        xpf::MemoryAllocator::FreeMemory(element);
+    }
+    (void) context->Sum.FetchAdd(sum);
+}
+
+/**
+ * @brief       A move-only element which counts how many payloads are alive.
+ */
+class MockMpmcRingBufferElement
+{
+ public:
+/**
+ * @brief Constructor - default. Owns no payload.
+ */
+MockMpmcRingBufferElement(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Constructor.
+ *
+ * @param[in] Value - The payload. Must not be negative.
+ */
+explicit MockMpmcRingBufferElement(
+    _In_ int32_t Value
+) noexcept(true) : Payload{ Value }
+{
+    LiveCount++;
+}
+
+/**
+ * @brief Move constructor. Takes the payload.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ */
+MockMpmcRingBufferElement(
+    _Inout_ MockMpmcRingBufferElement&& Other
+) noexcept(true) : Payload{ Other.Payload }
+{
+    Other.Payload = -1;
+}
+
+/**
+ * @brief Move assignment. Drops the current payload and takes the other one.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after move.
+ */
+MockMpmcRingBufferElement&
+operator=(
+    _Inout_ MockMpmcRingBufferElement&& Other
+) noexcept(true)
+{
+    if (this != xpf::AddressOf(Other))
+    {
+        LiveCount -= (this->Payload >= 0) ? 1 : 0;
+        this->Payload = Other.Payload;
+        Other.Payload = -1;
+    }
+    return *this;
+}
+
+/**
+ * @brief Destructor. Drops the payload.
+ */
+~MockMpmcRingBufferElement(
+    void
+) noexcept(true)
+{
+    LiveCount -= (this->Payload >= 0) ? 1 : 0;
+}
+
+/**
+ * @brief Copy constructor - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+MockMpmcRingBufferElement(
+    _In_ _Const_ const MockMpmcRingBufferElement& Other
+) noexcept(true) = delete;
+
+/**
+ * @brief Copy assignment - deleted.
+ *
+ * @param[in] Other - The other object to construct from.
+ *
+ * @return A reference to *this object after copy.
+ */
+MockMpmcRingBufferElement&
+operator=(
+    _In_ _Const_ const MockMpmcRingBufferElement& Other
+) noexcept(true) = delete;
+
+   /**
+    * @brief The number of elements alive which own a payload.
+    */
+    static inline int32_t LiveCount = 0;
+
+   /**
+    * @brief The payload - negative for a moved-from or default element.
+    */
+    int32_t Payload = -1;
+};
+
+/**
+ * @brief       This tests a single thread filling, draining and wrapping around the ring.
+ */
+XPF_TEST_SCENARIO(TestMpmcRingBuffer, SingleThreaded)
+{
+    xpf::MpmcRingBuffer<uint32_t, 8> ring;
+    uint32_t value = 0;
+
+    XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(8 == ring.CAPACITY);
+    XPF_TEST_EXPECT_TRUE(!ring.TryPop(value));
+
+    //
+    // Many laps, each filling the ring to the brim.
+    //
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    for (size_t lap = 0; lap < 10; ++lap)
+    {
+        while (ring.Size() < 8)
+        {
+            uint32_t element = next++;
+            XPF_TEST_EXPECT_TRUE(ring.TryPush(xpf::Move(element)));
+        }
+
+        uint32_t rejected = 1000;
+        XPF_TEST_EXPECT_TRUE(!ring.TryPush(xpf::Move(rejected)));
+        XPF_TEST_EXPECT_TRUE(1000 == rejected);
+
+        //
+        // Pop a few - an odd number, so the ring wraps at a different cell each lap.
+        //
+        for (size_t i = 0; i < 3 + (lap % 4); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(ring.TryPop(value));
+            XPF_TEST_EXPECT_TRUE(expected++ == value);
+        }
+    }
+    while (ring.TryPop(value))
+    {
+        XPF_TEST_EXPECT_TRUE(expected++ == value);
+    }
+    XPF_TEST_EXPECT_TRUE(next == expected);
+    XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+}
+
+/**
+ * @brief       This tests that the elements are constructed and destroyed exactly once,
+ *              including the ones left in the ring when it is destroyed.
+ */
+XPF_TEST_SCENARIO(TestMpmcRingBuffer, ElementLifetime)
+{
+    MockMpmcRingBufferElement::LiveCount = 0;
+    {
+        xpf::MpmcRingBuffer<MockMpmcRingBufferElement, 4> ring;
+
+        for (int32_t i = 0; i < 4; ++i)
+        {
+            MockMpmcRingBufferElement element{ i };
+            XPF_TEST_EXPECT_TRUE(ring.TryPush(xpf::Move(element)));
+            XPF_TEST_EXPECT_TRUE(-1 == element.Payload);
+        }
+        XPF_TEST_EXPECT_TRUE(4 == MockMpmcRingBufferElement::LiveCount);
+
+        MockMpmcRingBufferElement popped;
+        ring.SpinPop(popped);
+        XPF_TEST_EXPECT_TRUE(0 == popped.Payload);
+        XPF_TEST_EXPECT_TRUE(4 == MockMpmcRingBufferElement::LiveCount);
+
+        MockMpmcRingBufferElement element{ 10 };
+        ring.SpinPush(xpf::Move(element));
+        XPF_TEST_EXPECT_TRUE(5 == MockMpmcRingBufferElement::LiveCount);
+    }
+    XPF_TEST_EXPECT_TRUE(0 == MockMpmcRingBufferElement::LiveCount);
+}
+
+/**
+ * @brief       This tests 4 producers and 4 consumers going through a small ring:
+ *              every value comes out exactly once, and the values of each producer
+ *              come out of each consumer in order.
+ */
+XPF_TEST_SCENARIO(TestMpmcRingBuffer, MultipleProducersMultipleConsumers)
+{
+    constexpr uint64_t itemsPerThread = 50000;
+
+    MockMpmcRing ring;
+    MockMpmcRingBufferContext context;
+    context.Ring = &ring;
+    context.ItemsPerThread = itemsPerThread;
+
+    xpf::Vector<uint8_t> seen;
+    for (uint64_t i = 0; i < 4 * itemsPerThread; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(seen.Emplace(uint8_t{ 0 })));
+    }
+    context.Seen = &seen[0];
+
+    xpf::thread::Thread producers[4];
+    xpf::thread::Thread consumers[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(consumers[i].Run(MockMpmcRingBufferConsumer, &context)));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(producers[i].Run(MockMpmcRingBufferProducer, &context)));
+    }
+    for (size_t i = 0; i < 4; ++i)
+    {
+        producers[i].Join();
+        consumers[i].Join();
+    }
+
+    XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(0 == context.OutOfOrder.Load());
+
+    size_t missing = 0;
+    for (size_t i = 0; i < seen.Size(); ++i)
+    {
+        missing += (1 == seen[i]) ? 0 : 1;
+    }
+    XPF_TEST_EXPECT_TRUE(0 == missing);
+}
+
+/**
+ * @brief       Compares the handoff of values from 2 producers to 2 consumers through
+ *              the MpmcRingBuffer against the TwoLockQueue, which needs an allocation
+ *              and two lock acquisitions per value, and logs the timings.
+ *
+ * @param[in]   ItemsPerThread - The number of values each producer pushes.
+ *
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+static void XPF_API
+MockMpmcRingBufferBenchmarkAgainstTwoLockQueue(
+    _In_ uint64_t ItemsPerThread,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    bool isCorrect = true;
+
+    uint64_t ringDuration = 0;
+    {
+        MockMpmcRing ring;
+        MockMpmcRingBufferContext context;
+        context.Ring = &ring;
+        context.ItemsPerThread = ItemsPerThread;
+
+        xpf::Vector<uint8_t> seen;
+        isCorrect = NT_SUCCESS(seen.ReserveCapacity(static_cast<size_t>(2 * ItemsPerThread))) && isCorrect;
+        for (uint64_t i = 0; i < 2 * ItemsPerThread; ++i)
+        {
+            isCorrect = NT_SUCCESS(seen.Emplace(uint8_t{ 0 })) && isCorrect;
+        }
+        if (!isCorrect)
+        {
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+        context.Seen = &seen[0];
+
+        xpf::thread::Thread threads[4];
+        const uint64_t start = xpf::ApiCurrentTime();
+        for (size_t i = 0; i < 2; ++i)
+        {
+            isCorrect = NT_SUCCESS(threads[i].Run(MockMpmcRingBufferProducer, &context)) && isCorrect;
+            isCorrect = NT_SUCCESS(threads[i + 2].Run(MockMpmcRingBufferConsumer, &context)) && isCorrect;
+        }
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            threads[i].Join();
+        }
+        ringDuration = xpf::ApiCurrentTime() - start;
+
+        isCorrect = ring.IsEmpty() && isCorrect;
+        isCorrect = (0 == context.OutOfOrder.Load()) && isCorrect;
+    }
+
+    uint64_t tlqDuration = 0;
+    {
+        MockMpmcRingBufferTlqContext context;
+        context.ItemsPerThread = ItemsPerThread;
+
+        xpf::thread::Thread threads[4];
+        const uint64_t start = xpf::ApiCurrentTime();
+        for (size_t i = 0; i < 2; ++i)
+        {
+            isCorrect = NT_SUCCESS(threads[i].Run(MockMpmcRingBufferTlqProducer, &context)) && isCorrect;
+            isCorrect = NT_SUCCESS(threads[i + 2].Run(MockMpmcRingBufferTlqConsumer, &context)) && isCorrect;
+        }
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            threads[i].Join();
+        }
+        tlqDuration = xpf::ApiCurrentTime() - start;
+
+        isCorrect = (ItemsPerThread * (ItemsPerThread - 1) == context.Sum.Load()) && isCorrect;
+    }
+
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+    }
+
+    xpf_test::LogTestInfo("    > 2 producers, 2 consumers, %llu values: MpmcRingBuffer %llu, TwoLockQueue %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(2 * ItemsPerThread),                                  // NOLINT(*)
+                          static_cast<unsigned long long>(ringDuration),                                        // NOLINT(*)
+                          static_cast<unsigned long long>(tlqDuration));                                        // NOLINT(*)
+}
+
+/**
+ * @brief       This compares the MpmcRingBuffer against the TwoLockQueue, at 100K values per producer.
+ */
+XPF_TEST_SCENARIO(TestMpmcRingBuffer, BenchmarkAgainstTwoLockQueue)
+{
+    MockMpmcRingBufferBenchmarkAgainstTwoLockQueue(100000, _XpfArgScenario);
+}
+
+#if defined XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+    /**
+     * @brief       The same comparison at 1M values per producer. Only built with XPF_TESTS_ENABLE_LARGE_BENCHMARKS.
+     */
+    XPF_TEST_SCENARIO(TestMpmcRingBuffer, LargeBenchmarkAgainstTwoLockQueue)
+    {
+        MockMpmcRingBufferBenchmarkAgainstTwoLockQueue(1000000, _XpfArgScenario);
+    }
+#endif  // XPF_TESTS_ENABLE_LARGE_BENCHMARKS
@@ -0,0 +1,254 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestOrderStatisticTree.cpp
+ *
+ * @brief       This contains tests for OrderStatisticTree.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Validates that every node knows the size of its subtree.
+ *
+ * @param[in]   Tree     - The OrderStatisticTree to validate.
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+template <class Key, class Value>
+static void
+ValidateSubtreeSizes(
+    _In_ _Const_ const xpf::OrderStatisticTree<Key, Value>& Tree,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    using Node = typename xpf::OrderStatisticTree<Key, Value>::Node;
+
+    const Node* root = Tree.Root();
+    const size_t rootSize = (nullptr != root) ? root->SubtreeSize : 0;
+    if (rootSize != Tree.Size())
+    {
+        xpf_test::LogTestInfo("    [!] OrderStatisticTree Violation: root holds %llu nodes, expected %llu.\r\n",
+                              static_cast<unsigned long long>(rootSize),                                        // NOLINT(*)
+                              static_cast<unsigned long long>(Tree.Size()));                                    // NOLINT(*)
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+        return;
+    }
+
+    xpf::Vector<const Node*> stack;
+    if ((nullptr != root) && !NT_SUCCESS(stack.Emplace(root)))
+    {
+        (*Scenario) = STATUS_INSUFFICIENT_RESOURCES;
+        return;
+    }
+
+    while (!stack.IsEmpty())
+    {
+        const Node* node = stack[stack.Size() - 1];
+        if (!NT_SUCCESS(stack.Erase(stack.Size() - 1)))
+        {
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+
+        size_t expected = 1;
+        const Node* children[] = { node->Left, node->Right };
+        for (const Node* child : children)
+        {
+            if (nullptr == child)
+            {
+                continue;
+            }
+            expected += child->SubtreeSize;
+            if (!NT_SUCCESS(stack.Emplace(child)))
+            {
+                (*Scenario) = STATUS_INSUFFICIENT_RESOURCES;
+                return;
+            }
+        }
+
+        if (expected != node->SubtreeSize)
+        {
+            xpf_test::LogTestInfo("    [!] OrderStatisticTree Violation: stale subtree size.\r\n");
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief       This tests the empty tree.
+ */
+XPF_TEST_SCENARIO(TestOrderStatisticTree, DefaultConstructor)
+{
+    xpf::OrderStatisticTree<int, int> tree;
+
+    XPF_TEST_EXPECT_TRUE(tree.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(0 == tree.Size());
+    XPF_TEST_EXPECT_TRUE(tree.Begin() == tree.End());
+    XPF_TEST_EXPECT_TRUE(tree.Select(0) == tree.End());
+    XPF_TEST_EXPECT_TRUE(0 == tree.Rank(42));
+    XPF_TEST_EXPECT_TRUE(STATUS_NOT_FOUND == tree.Erase(42));
+    XPF_TEST_EXPECT_TRUE(nullptr == tree.Root());
+
+    //
+    // The plain tree does not pay for the augmentation.
+    //
+    XPF_TEST_EXPECT_TRUE(sizeof(xpf::RedBlackTreeNode<int, int>) < sizeof(xpf::OrderStatisticTree<int, int>::Node));
+}
+
+/**
+ * @brief       This tests Select and Rank on keys inserted in scattered order.
+ */
+XPF_TEST_SCENARIO(TestOrderStatisticTree, SelectAndRank)
+{
+    xpf::OrderStatisticTree<int, int> tree;
+
+    //
+    // The keys are the even numbers 0, 2, ..., 3998.
+    //
+    for (int i = 0; i < 2000; ++i)
+    {
+        int key = ((i * 7919) % 2000) * 2;
+        int value = key + 1;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+    }
+    XPF_TEST_EXPECT_TRUE(2000 == tree.Size());
+    ValidateSubtreeSizes(tree, _XpfArgScenario);
+
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        const int key = static_cast<int>(i) * 2;
+
+        auto it = tree.Select(i);
+        XPF_TEST_EXPECT_TRUE(it != tree.End());
+        XPF_TEST_EXPECT_TRUE(key == it.GetKey());
+        XPF_TEST_EXPECT_TRUE(key + 1 == it.GetValue());
+
+        XPF_TEST_EXPECT_TRUE(i == tree.Rank(key));
+        XPF_TEST_EXPECT_TRUE(i + 1 == tree.Rank(key + 1));
+    }
+    XPF_TEST_EXPECT_TRUE(tree.Select(2000) == tree.End());
+    XPF_TEST_EXPECT_TRUE(0 == tree.Rank(-5));
+    XPF_TEST_EXPECT_TRUE(2000 == tree.Rank(100000));
+
+    //
+    // The upsert changes the value, not the positions.
+    //
+    int key = 100;
+    int value = -1;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+    XPF_TEST_EXPECT_TRUE(2000 == tree.Size());
+    XPF_TEST_EXPECT_TRUE(-1 == tree.Select(50).GetValue());
+    ValidateSubtreeSizes(tree, _XpfArgScenario);
+}
+
+/**
+ * @brief       This tests random inserts and erases against a sorted array of flags.
+ *              Every rotation and every fixup path must leave the sizes correct.
+ */
+XPF_TEST_SCENARIO(TestOrderStatisticTree, ChurnAgainstReference)
+{
+    xpf::OrderStatisticTree<uint32_t, uint32_t> tree;
+    bool present[1000] = { false };
+
+    uint32_t state = 0x2468ACE1;
+    for (size_t i = 0; i < 30000; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        uint32_t key = state % 1000;
+        if (0 != (state & 0x100000))
+        {
+            uint32_t value = key;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+            present[state % 1000] = true;
+        }
+        else
+        {
+            const NTSTATUS expected = present[key] ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+            XPF_TEST_EXPECT_TRUE(expected == tree.Erase(key));
+            present[key] = false;
+        }
+
+        if (0 == (i % 1000))
+        {
+            ValidateSubtreeSizes(tree, _XpfArgScenario);
+
+            size_t rank = 0;
+            for (uint32_t k = 0; k < 1000; ++k)
+            {
+                XPF_TEST_EXPECT_TRUE(rank == tree.Rank(k));
+                if (present[k])
+                {
+                    XPF_TEST_EXPECT_TRUE(k == tree.Select(rank).GetKey());
+                    rank++;
+                }
+            }
+            XPF_TEST_EXPECT_TRUE(rank == tree.Size());
+            XPF_TEST_EXPECT_TRUE(tree.Select(rank) == tree.End());
+        }
+    }
+
+    //
+    // Emptying the tree through Select(0).
+    //
+    while (!tree.IsEmpty())
+    {
+        const uint32_t smallest = tree.Select(0).GetKey();
+        XPF_TEST_EXPECT_TRUE(smallest == tree.Begin().GetKey());
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Erase(smallest)));
+    }
+    XPF_TEST_EXPECT_TRUE(nullptr == tree.Root());
+}
+
+/**
+ * @brief       This tests that BuildFromSorted fills in the subtree sizes.
+ */
+XPF_TEST_SCENARIO(TestOrderStatisticTree, BuildFromSorted)
+{
+    int keys[300] = { 0 };
+    int values[300] = { 0 };
+    for (int i = 0; i < 300; ++i)
+    {
+        keys[i] = i * 3;
+        values[i] = -i;
+    }
+
+    for (size_t size = 0; size <= 300; size += 23)
+    {
+        xpf::OrderStatisticTree<int, int> tree;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.BuildFromSorted(xpf::Span<int>{ keys, size },
+                                                             xpf::Span<int>{ values, size })));
+        XPF_TEST_EXPECT_TRUE(size == tree.Size());
+        ValidateSubtreeSizes(tree, _XpfArgScenario);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(keys[i] == tree.Select(i).GetKey());
+            XPF_TEST_EXPECT_TRUE(values[i] == tree.Select(i).GetValue());
+            XPF_TEST_EXPECT_TRUE(i == tree.Rank(keys[i]));
+        }
+
+        //
+        // The sizes stay correct when the built tree is modified.
+        //
+        int key = 1;
+        int value = 1;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+        XPF_TEST_EXPECT_TRUE(((size > 0) ? 1 : 0) == static_cast<int>(tree.Rank(1)));
+        if (size > 0)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Erase(keys[0])));
+        }
+        ValidateSubtreeSizes(tree, _XpfArgScenario);
+    }
+}
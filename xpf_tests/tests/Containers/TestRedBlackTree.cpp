@@ -295,6 +295,83 @@ ValidateRBTreeInvariants(
     ValidateRBTreeInvariants(TreeMap.Tree(), Scenario);
 }
 
+/**
+ * @brief       Allocates memory and counts the allocation.
+ *
+ * @param[in] Context - A pointer to two size_t counters: allocations and frees.
+ *
+ * @param[in] BlockSize - The size of the block.
+ *
+ * @return The allocated block.
+ */
+static void*
+MockRedBlackTreeAllocate(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    static_cast<size_t*>(Context)[0]++;
+    return xpf::MemoryAllocator::AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief       Frees memory allocated with MockRedBlackTreeAllocate and counts the free.
+ *
+ * @param[in] Context - A pointer to two size_t counters: allocations and frees.
+ *
+ * @param[in,out] MemoryBlock - The block to be freed.
+ */
+static void
+MockRedBlackTreeFree(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    static_cast<size_t*>(Context)[1]++;
+    xpf::MemoryAllocator::FreeMemory(MemoryBlock);
+}
+
+/**
+ * @brief       Allocates memory while the budget allows it.
+ *
+ * @param[in] Context - A pointer to a size_t budget - the number of allowed allocations.
+ *
+ * @param[in] BlockSize - The size of the block.
+ *
+ * @return The allocated block, or nullptr if the budget is exhausted.
+ */
+static void*
+MockRedBlackTreeBudgetAllocate(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    size_t* budget = static_cast<size_t*>(Context);
+    if (0 == *budget)
+    {
+        return nullptr;
+    }
+    (*budget)--;
+    return xpf::MemoryAllocator::AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief       Frees memory allocated with MockRedBlackTreeBudgetAllocate.
+ *
+ * @param[in] Context - A pointer to a size_t budget. Unused.
+ *
+ * @param[in,out] MemoryBlock - The block to be freed.
+ */
+static void
+MockRedBlackTreeBudgetFree(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+    xpf::MemoryAllocator::FreeMemory(MemoryBlock);
+}
+
 
 //
 // ************************************************************************************************
@@ -416,6 +493,105 @@ XPF_TEST_SCENARIO(TestRedBlackTree, AllocateDeallocateNode)
     tree.DeallocateNode(node);
 }
 
+/**
+ * @brief       This tests that the nodes are carved from slabs and reused after erase.
+ */
+XPF_TEST_SCENARIO(TestRedBlackTree, NodeSlab)
+{
+    size_t counters[2] = { 0, 0 };
+
+    xpf::PolymorphicAllocator allocator;
+    allocator.Context = counters;
+    allocator.ContextAllocFunction = &MockRedBlackTreeAllocate;
+    allocator.ContextFreeFunction = &MockRedBlackTreeFree;
+
+    {
+        xpf::RedBlackTree<int, xpf::String<char>> tree{ allocator };
+
+        /* 1000 nodes come from a handful of slabs. */
+        for (int i = 0; i < 1000; ++i)
+        {
+            xpf::String<char> value;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(value.Append("value")));
+
+            int key = i;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+        }
+        ValidateRBTreeInvariants(tree, _XpfArgScenario);
+
+        const size_t nodeAllocations = counters[0];
+        XPF_TEST_EXPECT_TRUE(nodeAllocations < 20);
+
+        /* Erased nodes are reused - no slab is allocated for the reinsertion. */
+        for (int i = 0; i < 1000; i += 2)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Erase(i)));
+        }
+        for (int i = 0; i < 1000; i += 2)
+        {
+            xpf::String<char> value;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(value.Append("other")));
+
+            int key = i;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+        }
+        XPF_TEST_EXPECT_TRUE(counters[0] == nodeAllocations);
+        XPF_TEST_EXPECT_TRUE(tree.Find(998).GetValue().View().Equals("other", true));
+        XPF_TEST_EXPECT_TRUE(tree.Find(999).GetValue().View().Equals("value", true));
+        ValidateRBTreeInvariants(tree, _XpfArgScenario);
+
+        /* Erasing the last node releases the slabs. */
+        for (int i = 0; i < 1000; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Erase(i)));
+        }
+        XPF_TEST_EXPECT_TRUE(counters[0] == counters[1]);
+
+        /* The tree is usable again and Clear() releases everything. */
+        int key = 5;
+        xpf::String<char> value;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+        tree.Clear();
+        XPF_TEST_EXPECT_TRUE(counters[0] == counters[1]);
+
+        key = 6;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+    }
+    XPF_TEST_EXPECT_TRUE(counters[0] == counters[1]);
+}
+
+/**
+ * @brief       This measures a bulk insert followed by Clear().
+ */
+XPF_TEST_SCENARIO(TestRedBlackTree, BulkInsertAndClearBenchmark)
+{
+    constexpr int count = 200000;
+
+    xpf::RedBlackTree<int, int> tree;
+
+    const uint64_t insertStart = xpf::ApiCurrentTime();
+    for (int i = 0; i < count; ++i)
+    {
+        int key = (i * 7919) % count;
+        int value = i;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(tree.Emplace(xpf::Move(key), xpf::Move(value))));
+    }
+    const uint64_t insertEnd = xpf::ApiCurrentTime();
+
+    XPF_TEST_EXPECT_TRUE(tree.Size() == size_t{ count });
+
+    const uint64_t clearStart = xpf::ApiCurrentTime();
+    tree.Clear();
+    const uint64_t clearEnd = xpf::ApiCurrentTime();
+
+    XPF_TEST_EXPECT_TRUE(tree.IsEmpty());
+
+    xpf_test::LogTestInfo("    > %d nodes: insert %llu (100 ns), clear %llu (100 ns) \r\n",
+                          count,
+                          static_cast<unsigned long long>(insertEnd - insertStart),                         // NOLINT(*)
+                          static_cast<unsigned long long>(clearEnd - clearStart));                          // NOLINT(*)
+}
+
 
 //
 // ************************************************************************************************
@@ -1242,6 +1418,269 @@ XPF_TEST_SCENARIO(TestMap, ClearAlreadyEmptyMap)
 }
 
 
+//
+// ************************************************************************************************
+// Map: Range Queries and Bulk Build
+// ************************************************************************************************
+//
+
+/**
+ * @brief       This tests LowerBound, UpperBound, and EqualRange.
+ */
+XPF_TEST_SCENARIO(TestMap, LowerUpperBoundAndEqualRange)
+{
+    xpf::Map<int, int> map;
+
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(0) == map.End());
+    XPF_TEST_EXPECT_TRUE(map.UpperBound(0) == map.End());
+
+    /* Keys 0, 10, 20, ..., 990. */
+    for (int i = 0; i < 100; ++i)
+    {
+        int key = i * 10;
+        int value = i;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+    }
+
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(-5) == map.Begin());
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(0).GetKey() == 0);
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(5).GetKey() == 10);
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(10).GetKey() == 10);
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(990).GetKey() == 990);
+    XPF_TEST_EXPECT_TRUE(map.LowerBound(991) == map.End());
+
+    XPF_TEST_EXPECT_TRUE(map.UpperBound(-5).GetKey() == 0);
+    XPF_TEST_EXPECT_TRUE(map.UpperBound(10).GetKey() == 20);
+    XPF_TEST_EXPECT_TRUE(map.UpperBound(15).GetKey() == 20);
+    XPF_TEST_EXPECT_TRUE(map.UpperBound(990) == map.End());
+
+    /* A present key gives a range of one element. */
+    auto range = map.EqualRange(500);
+    XPF_TEST_EXPECT_TRUE(range.First != range.Last);
+    XPF_TEST_EXPECT_TRUE(range.First.GetKey() == 500);
+    XPF_TEST_EXPECT_TRUE(range.Last.GetKey() == 510);
+    ++range.First;
+    XPF_TEST_EXPECT_TRUE(range.First == range.Last);
+
+    /* A missing key gives an empty range at its insertion point. */
+    range = map.EqualRange(505);
+    XPF_TEST_EXPECT_TRUE(range.First == range.Last);
+    XPF_TEST_EXPECT_TRUE(range.First.GetKey() == 510);
+
+    range = map.EqualRange(990);
+    XPF_TEST_EXPECT_TRUE(range.First.GetKey() == 990);
+    XPF_TEST_EXPECT_TRUE(range.Last == map.End());
+
+    /* A range scan over [200, 300). */
+    int scanned = 0;
+    for (auto it = map.LowerBound(200); it != map.LowerBound(300); ++it)
+    {
+        XPF_TEST_EXPECT_TRUE(it.GetKey() == 200 + scanned * 10);
+        scanned++;
+    }
+    XPF_TEST_EXPECT_TRUE(10 == scanned);
+}
+
+/**
+ * @brief       This tests erasing ranges of elements.
+ */
+XPF_TEST_SCENARIO(TestMap, EraseRange)
+{
+    xpf::Map<int, int> map;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        int key = i;
+        int value = i * 2;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+    }
+
+    /* An empty range erases nothing. */
+    XPF_TEST_EXPECT_TRUE(0 == map.EraseRange(map.LowerBound(100), map.LowerBound(100)));
+    XPF_TEST_EXPECT_TRUE(1000 == map.Size());
+
+    /* Erase [100, 200). */
+    XPF_TEST_EXPECT_TRUE(100 == map.EraseRange(map.LowerBound(100), map.LowerBound(200)));
+    XPF_TEST_EXPECT_TRUE(900 == map.Size());
+    ValidateRBTreeInvariants(map, _XpfArgScenario);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const bool erased = (i >= 100) && (i < 200);
+        XPF_TEST_EXPECT_TRUE(erased == (map.Find(i) == map.End()));
+    }
+
+    /* Erase the tail [900, end). */
+    XPF_TEST_EXPECT_TRUE(100 == map.EraseRange(map.LowerBound(900), map.End()));
+    XPF_TEST_EXPECT_TRUE(800 == map.Size());
+    ValidateRBTreeInvariants(map, _XpfArgScenario);
+
+    /* Erase the head [begin, 50). */
+    XPF_TEST_EXPECT_TRUE(50 == map.EraseRange(map.Begin(), map.LowerBound(50)));
+    XPF_TEST_EXPECT_TRUE(750 == map.Size());
+    XPF_TEST_EXPECT_TRUE(map.Begin().GetKey() == 50);
+    ValidateRBTreeInvariants(map, _XpfArgScenario);
+
+    /* Erase everything. */
+    XPF_TEST_EXPECT_TRUE(750 == map.EraseRange(map.Begin(), map.End()));
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(map.Begin() == map.End());
+}
+
+/**
+ * @brief       This tests BuildFromSorted for every size up to a few levels,
+ *              the invalid inputs, and the allocation failures.
+ */
+XPF_TEST_SCENARIO(TestMap, BuildFromSorted)
+{
+    int keys[300] = { 0 };
+    int values[300] = { 0 };
+    for (int i = 0; i < 300; ++i)
+    {
+        keys[i] = i * 3;
+        values[i] = -i;
+    }
+
+    /* Sizes 0 to 299 cover perfect trees and every count of red leaves on a few levels. */
+    xpf::Map<int, int> map;
+    for (int i = 0; i < 300; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.BuildFromSorted(xpf::Span<int>{ keys, static_cast<size_t>(i) },
+                                                            xpf::Span<int>{ values, static_cast<size_t>(i) })));
+        XPF_TEST_EXPECT_TRUE(map.Size() == static_cast<size_t>(i));
+        ValidateRBTreeInvariants(map, _XpfArgScenario);
+
+        int expected = 0;
+        for (auto it = map.Begin(); it != map.End(); ++it)
+        {
+            XPF_TEST_EXPECT_TRUE(it.GetKey() == expected * 3);
+            XPF_TEST_EXPECT_TRUE(it.GetValue() == -expected);
+            expected++;
+        }
+        XPF_TEST_EXPECT_TRUE(expected == i);
+    }
+
+    /* The built tree behaves like any other - insert and erase keep it valid. */
+    for (int i = 0; i < 300; i += 2)
+    {
+        int key = i * 3 + 1;
+        int value = 0;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Erase(i * 3)));
+    }
+    ValidateRBTreeInvariants(map, _XpfArgScenario);
+
+    /* Unsorted keys, duplicate keys, and mismatched sizes are rejected - the map is emptied. */
+    const int unsorted[] = { 1, 3, 2 };
+    const int duplicates[] = { 1, 2, 2 };
+    const int three[] = { 7, 8, 9 };
+    const int two[] = { 7, 8 };
+
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == map.BuildFromSorted(xpf::Span<int>{ unsorted },
+                                                                         xpf::Span<int>{ three }));
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == map.BuildFromSorted(xpf::Span<int>{ duplicates },
+                                                                         xpf::Span<int>{ three }));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == map.BuildFromSorted(xpf::Span<int>{ three },
+                                                                         xpf::Span<int>{ two }));
+    XPF_TEST_EXPECT_TRUE(map.IsEmpty());
+
+    /* A failed allocation half way leaves an empty, usable map. */
+    size_t budget = 2;
+
+    xpf::PolymorphicAllocator allocator;
+    allocator.Context = &budget;
+    allocator.ContextAllocFunction = &MockRedBlackTreeBudgetAllocate;
+    allocator.ContextFreeFunction = &MockRedBlackTreeBudgetFree;
+
+    xpf::Map<int, int> budgetMap{ allocator };
+    XPF_TEST_EXPECT_TRUE(STATUS_INSUFFICIENT_RESOURCES == budgetMap.BuildFromSorted(xpf::Span<int>{ keys },
+                                                                                            xpf::Span<int>{ values }));
+    XPF_TEST_EXPECT_TRUE(budgetMap.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(budgetMap.Begin() == budgetMap.End());
+
+    budget = 100;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(budgetMap.BuildFromSorted(xpf::Span<int>{ three },
+                                                              xpf::Span<int>{ three })));
+    XPF_TEST_EXPECT_TRUE(3 == budgetMap.Size());
+    ValidateRBTreeInvariants(budgetMap, _XpfArgScenario);
+}
+
+/**
+ * @brief       Compares BuildFromSorted with inserting the same sorted keys one by one, and logs the timings.
+ *
+ * @param[in]   Count - The number of keys.
+ *
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+static void XPF_API
+MockMapBuildFromSortedBenchmark(
+    _In_ size_t Count,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    bool isCorrect = true;
+
+    xpf::Vector<uint64_t> keys;
+    isCorrect = NT_SUCCESS(keys.ReserveCapacity(Count)) && isCorrect;
+    for (size_t i = 0; i < Count; ++i)
+    {
+        isCorrect = NT_SUCCESS(keys.Emplace(uint64_t{ i } * 2)) && isCorrect;
+    }
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+        return;
+    }
+
+    xpf::Map<uint64_t, uint64_t> inserted;
+    const uint64_t insertStart = xpf::ApiCurrentTime();
+    for (size_t i = 0; i < Count; ++i)
+    {
+        uint64_t key = keys[i];
+        uint64_t value = keys[i];
+        isCorrect = NT_SUCCESS(inserted.Emplace(xpf::Move(key), xpf::Move(value))) && isCorrect;
+    }
+    const uint64_t insertEnd = xpf::ApiCurrentTime();
+
+    xpf::Map<uint64_t, uint64_t> built;
+    const uint64_t buildStart = xpf::ApiCurrentTime();
+    isCorrect = NT_SUCCESS(built.BuildFromSorted(xpf::Span<uint64_t>{ &keys[0], keys.Size() },
+                                                 xpf::Span<uint64_t>{ &keys[0], keys.Size() })) && isCorrect;
+    const uint64_t buildEnd = xpf::ApiCurrentTime();
+
+    isCorrect = (Count == built.Size()) && (Count == inserted.Size()) && isCorrect;
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+    }
+    ValidateRBTreeInvariants(built, Scenario);
+
+    xpf_test::LogTestInfo("    > %llu sorted keys: Emplace %llu (100 ns), BuildFromSorted %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(Count),                                               // NOLINT(*)
+                          static_cast<unsigned long long>(insertEnd - insertStart),                             // NOLINT(*)
+                          static_cast<unsigned long long>(buildEnd - buildStart));                              // NOLINT(*)
+}
+
+/**
+ * @brief       This compares BuildFromSorted with inserting the same sorted keys one by one, at 200K keys.
+ */
+XPF_TEST_SCENARIO(TestMap, BuildFromSortedBenchmark)
+{
+    MockMapBuildFromSortedBenchmark(200000, _XpfArgScenario);
+}
+
+#if defined XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+    /**
+     * @brief       The same comparison at 1M keys. Only built with XPF_TESTS_ENABLE_LARGE_BENCHMARKS.
+     */
+    XPF_TEST_SCENARIO(TestMap, LargeBuildFromSortedBenchmark)
+    {
+        MockMapBuildFromSortedBenchmark(1000000, _XpfArgScenario);
+    }
+#endif  // XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+
+
 //
 // ************************************************************************************************
 // Set Tests
@@ -1441,3 +1880,33 @@ XPF_TEST_SCENARIO(TestSet, StressInsertErase)
         }
     }
 }
+
+/**
+ * @brief       This tests the range queries, the range erase and the bulk build of a set.
+ */
+XPF_TEST_SCENARIO(TestSet, RangesAndBuildFromSorted)
+{
+    const int keys[] = { 2, 4, 6, 8, 10, 12, 14 };
+
+    xpf::Set<int> set;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(set.BuildFromSorted(xpf::Span<int>{ keys })));
+    XPF_TEST_EXPECT_TRUE(set.Size() == XPF_ARRAYSIZE(keys));
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(keys); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(set.Contains(keys[i]));
+        XPF_TEST_EXPECT_TRUE(!set.Contains(keys[i] + 1));
+    }
+
+    XPF_TEST_EXPECT_TRUE(set.LowerBound(5).GetKey() == 6);
+    XPF_TEST_EXPECT_TRUE(set.UpperBound(6).GetKey() == 8);
+    XPF_TEST_EXPECT_TRUE(set.EqualRange(7).First == set.EqualRange(7).Last);
+
+    /* Erase [5, 11) - keys 6, 8 and 10. */
+    XPF_TEST_EXPECT_TRUE(3 == set.EraseRange(set.LowerBound(5), set.LowerBound(11)));
+    XPF_TEST_EXPECT_TRUE(4 == set.Size());
+    XPF_TEST_EXPECT_TRUE(set.Contains(4));
+    XPF_TEST_EXPECT_TRUE(!set.Contains(6));
+    XPF_TEST_EXPECT_TRUE(!set.Contains(10));
+    XPF_TEST_EXPECT_TRUE(set.Contains(12));
+}
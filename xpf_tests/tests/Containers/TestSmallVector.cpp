@@ -0,0 +1,277 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestSmallVector.cpp
+ *
+ * @brief       This contains tests for small vector
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Allocates memory and counts the allocation.
+ *
+ * @param[in] Context - A pointer to a size_t counter.
+ *
+ * @param[in] BlockSize - The size of the block.
+ *
+ * @return The allocated block.
+ */
+static void*
+MockSmallVectorAllocate(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    (*static_cast<size_t*>(Context))++;
+    return xpf::MemoryAllocator::AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief       Frees memory allocated with MockSmallVectorAllocate.
+ *
+ * @param[in] Context - A pointer to a size_t counter. Unused.
+ *
+ * @param[in,out] MemoryBlock - The block to be freed.
+ */
+static void
+MockSmallVectorFree(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+    xpf::MemoryAllocator::FreeMemory(MemoryBlock);
+}
+
+/**
+ * @brief       Creates an allocator which counts the allocations.
+ *
+ * @param[in] Counter - Incremented on each allocation.
+ *
+ * @return The allocator.
+ */
+static xpf::PolymorphicAllocator XPF_API
+MockSmallVectorCountingAllocator(
+    _In_ size_t* Counter
+) noexcept(true)
+{
+    xpf::PolymorphicAllocator allocator;
+    allocator.Context = Counter;
+    allocator.ContextAllocFunction = &MockSmallVectorAllocate;
+    allocator.ContextFreeFunction = &MockSmallVectorFree;
+    return allocator;
+}
+
+/**
+ * @brief       This tests the default constructor of small vector.
+ */
+XPF_TEST_SCENARIO(TestSmallVector, DefaultConstructorDestructor)
+{
+    xpf::SmallVector<uint64_t, 4> vector;
+    XPF_TEST_EXPECT_TRUE(vector.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(0 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(4 == vector.Capacity());
+    XPF_TEST_EXPECT_TRUE(vector.IsInline());
+
+    XPF_TEST_EXPECT_DEATH(vector[0] == 0);
+}
+
+/**
+ * @brief       This tests that the elements stay inline until the capacity is exceeded.
+ */
+XPF_TEST_SCENARIO(TestSmallVector, InlineAndSpill)
+{
+    size_t allocations = 0;
+    xpf::SmallVector<uint64_t, 4> vector{ MockSmallVectorCountingAllocator(&allocations) };
+
+    for (uint64_t i = 0; i < 4; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(vector.IsInline());
+    XPF_TEST_EXPECT_TRUE(0 == allocations);
+
+    //
+    // The fifth element spills.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(uint64_t{ 4 })));
+    XPF_TEST_EXPECT_TRUE(!vector.IsInline());
+    XPF_TEST_EXPECT_TRUE(1 == allocations);
+    XPF_TEST_EXPECT_TRUE(8 == vector.Capacity());
+    for (size_t i = 0; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i == vector[i]);
+    }
+
+    //
+    // Resizing to the inline capacity moves the elements back.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Erase(4)));
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.Resize(3)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Resize(4)));
+    XPF_TEST_EXPECT_TRUE(vector.IsInline());
+    for (size_t i = 0; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i == vector[i]);
+    }
+
+    //
+    // Clear goes back inline as well.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.ReserveCapacity(100)));
+    XPF_TEST_EXPECT_TRUE(!vector.IsInline());
+    XPF_TEST_EXPECT_TRUE(2 == allocations);
+
+    vector.Clear();
+    XPF_TEST_EXPECT_TRUE(vector.IsInline());
+    XPF_TEST_EXPECT_TRUE(4 == vector.Capacity());
+
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.Resize(xpf::NumericLimits<size_t>::MaxValue())));
+}
+
+/**
+ * @brief       This tests the move constructor and move assignment, both inline and spilled.
+ */
+XPF_TEST_SCENARIO(TestSmallVector, Move)
+{
+    xpf::SmallVector<xpf::String<char>, 2> inlineVector;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(inlineVector.Emplace()));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(inlineVector[0].Append("inline")));
+
+    xpf::SmallVector<xpf::String<char>, 2> movedInline{ xpf::Move(inlineVector) };
+    XPF_TEST_EXPECT_TRUE(inlineVector.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(movedInline.IsInline());
+    XPF_TEST_EXPECT_TRUE(1 == movedInline.Size());
+    XPF_TEST_EXPECT_TRUE(movedInline[0].View().Equals("inline", true));
+
+    xpf::SmallVector<xpf::String<char>, 2> spilledVector;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(spilledVector.Emplace()));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(spilledVector[i].Append("spilled")));
+    }
+    const xpf::String<char>* spilledElements = &spilledVector[0];
+
+    //
+    // Self-move does nothing.
+    //
+    spilledVector = xpf::Move(spilledVector);
+    XPF_TEST_EXPECT_TRUE(5 == spilledVector.Size());
+
+    //
+    // A spilled vector hands over its memory.
+    //
+    movedInline = xpf::Move(spilledVector);
+    XPF_TEST_EXPECT_TRUE(spilledVector.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(spilledVector.IsInline());
+    XPF_TEST_EXPECT_TRUE(5 == movedInline.Size());
+    XPF_TEST_EXPECT_TRUE(spilledElements == &movedInline[0]);
+    for (size_t i = 0; i < movedInline.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(movedInline[i].View().Equals("spilled", true));
+    }
+
+    //
+    // The moved-from vector can be reused.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(spilledVector.Emplace()));
+    XPF_TEST_EXPECT_TRUE(1 == spilledVector.Size());
+}
+
+/**
+ * @brief       This tests the range operations.
+ */
+XPF_TEST_SCENARIO(TestSmallVector, RangeOperations)
+{
+    const uint64_t values[] = { 1, 2, 3, 4, 5, 6 };
+
+    xpf::SmallVector<uint64_t, 4> vector;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.AppendRange(xpf::Span<uint64_t>{ &values[0], 2 })));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.InsertRange(1, xpf::Span<uint64_t>{ values })));
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.InsertRange(100, xpf::Span<uint64_t>{ values })));
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.AppendRange(xpf::Span<uint64_t>{ &vector[0], 1 })));
+
+    const uint64_t expected[] = { 1, 1, 2, 3, 4, 5, 6, 2 };
+    XPF_TEST_EXPECT_TRUE(XPF_ARRAYSIZE(expected) == vector.Size());
+    for (size_t i = 0; i < XPF_ARRAYSIZE(expected); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(expected[i] == vector[i]);
+    }
+
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.EraseRange(2, 100)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.EraseRange(2, 4)));
+    XPF_TEST_EXPECT_TRUE(4 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(6 == vector[2]);
+
+    XPF_TEST_EXPECT_TRUE(2 == vector.EraseIf([&](const uint64_t& Element) { return 1 == Element; }));
+    XPF_TEST_EXPECT_TRUE(2 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(6 == vector[0]);
+    XPF_TEST_EXPECT_TRUE(2 == vector[1]);
+
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.SwapRemove(2)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.SwapRemove(0)));
+    XPF_TEST_EXPECT_TRUE(1 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(2 == vector[0]);
+}
+
+/**
+ * @brief       This tests the shrinking of a spilled vector.
+ */
+XPF_TEST_SCENARIO(TestSmallVector, Shrink)
+{
+    xpf::SmallVector<uint64_t, 8> vector;
+    for (uint64_t i = 0; i < 128; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(128 == vector.Capacity());
+
+    //
+    // Erase most of them at once - it goes straight back inline.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.EraseRange(2, 125)));
+    XPF_TEST_EXPECT_TRUE(vector.IsInline());
+    XPF_TEST_EXPECT_TRUE(3 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(0 == vector[0]);
+    XPF_TEST_EXPECT_TRUE(1 == vector[1]);
+    XPF_TEST_EXPECT_TRUE(127 == vector[2]);
+}
+
+/**
+ * @brief       This tests Reserve and Sort.
+ */
+XPF_TEST_SCENARIO(TestSmallVector, ReserveAndSort)
+{
+    xpf::SmallVector<uint64_t, 4> vector;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Reserve(3, uint64_t{ 42 })));
+    XPF_TEST_EXPECT_TRUE(3 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(vector.IsInline());
+    for (size_t i = 0; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(42 == vector[i]);
+    }
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Reserve(0, uint64_t{ 0 })));
+    XPF_TEST_EXPECT_TRUE(vector.IsEmpty());
+
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace((i * 37) % 100)));
+    }
+    vector.Sort([&](const uint64_t& Left, const uint64_t& Right)
+                {
+                    return Left < Right;
+                });
+    for (size_t i = 0; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i == vector[i]);
+    }
+}
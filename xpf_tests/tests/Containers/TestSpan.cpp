@@ -1,7 +1,7 @@
 ﻿/**
  * @file        xpf_tests/tests/Containers/TestSpan.cpp
  *
- * @brief       This contains tests for Span.
+ * @brief       This contains tests for Span and MutableSpan.
  *
  * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
  *
@@ -163,3 +163,33 @@ XPF_TEST_SCENARIO(TestSpan, IndexOperatorBoundsCheck)
     /* Accessing index 100 on a span of 3 elements should trigger death on debug. */
     XPF_TEST_EXPECT_DEATH(span[100]);
 }
+
+/**
+ * @brief       This tests writing the elements through a MutableSpan,
+ *              its sub-spans and its read-only view.
+ */
+XPF_TEST_SCENARIO(TestSpan, MutableSpan)
+{
+    xpf::MutableSpan<int> empty;
+    XPF_TEST_EXPECT_TRUE(empty.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(nullptr == empty.Buffer());
+    XPF_TEST_EXPECT_TRUE(xpf::MutableSpan<int>(nullptr, 5).IsEmpty());
+
+    int data[] = { 1, 2, 3, 4 };
+    xpf::MutableSpan<int> span(data);
+    XPF_TEST_EXPECT_TRUE(span.Size() == size_t{ 4 });
+    XPF_TEST_EXPECT_TRUE(span.Buffer() == &data[0]);
+
+    span[0] = 10;
+    span.SubSpan(2, 100)[1] = 40;
+    XPF_TEST_EXPECT_TRUE(span.SubSpan(2, 100).Size() == size_t{ 2 });
+    XPF_TEST_EXPECT_TRUE(span.SubSpan(4, 1).IsEmpty());
+    XPF_TEST_EXPECT_TRUE((10 == data[0]) && (2 == data[1]) && (3 == data[2]) && (40 == data[3]));
+
+    const xpf::Span<int> view = span;
+    XPF_TEST_EXPECT_TRUE(view.Size() == size_t{ 4 });
+    XPF_TEST_EXPECT_TRUE(view.Buffer() == &data[0]);
+    XPF_TEST_EXPECT_TRUE(view[3] == 40);
+
+    XPF_TEST_EXPECT_DEATH(span[100]);
+}
@@ -0,0 +1,618 @@
+﻿/**
+ * @file        xpf_tests/tests/Containers/TestSpscRingBuffer.cpp
+ *
+ * @brief       This contains tests for SpscRingBuffer.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       The context shared by the producer and the consumer.
+ */
+struct MockSpscRingBufferContext
+{
+    /**
+     * @brief The ring under test.
+     */
+    xpf::SpscRingBuffer<uint64_t>* Ring = nullptr;
+
+    /**
+     * @brief If set, the consumer uses this ring instead - another object over the same region.
+     */
+    xpf::SpscRingBuffer<uint64_t>* ConsumerRing = nullptr;
+
+    /**
+     * @brief The producer pushes the values [0, ItemCount) in order.
+     */
+    uint64_t ItemCount = 0;
+
+    /**
+     * @brief How many values are moved by one PushN / PopN. 1 means TryPush / TryPop.
+     */
+    size_t BatchSize = 1;
+
+    /**
+     * @brief Filled by the consumer - how many values did not come out in order.
+     */
+    uint64_t OutOfOrder = 0;
+};
+
+/**
+ * @brief       Pushes ItemCount values, yielding while the ring is full.
+ *
+ * @param[in] Context - A pointer to a MockSpscRingBufferContext.
+ */
+static void XPF_API
+MockSpscRingBufferProducer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockSpscRingBufferContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    uint64_t batch[64] = { 0 };
+    uint64_t next = 0;
+    while (next < context->ItemCount)
+    {
+        if (1 == context->BatchSize)
+        {
+            while (!context->Ring->TryPush(next))
+            {
+                xpf::ApiYieldProcesor();
+            }
+            ++next;
+            continue;
+        }
+
+        size_t count = 0;
+        while ((count < context->BatchSize) && (next + count < context->ItemCount))
+        {
+            batch[count] = next + count;
+            ++count;
+        }
+
+        size_t pushed = 0;
+        while (pushed < count)
+        {
+            const size_t now = context->Ring->PushN(xpf::Span<uint64_t>{ &batch[pushed], count - pushed });
+            if (0 == now)
+            {
+                xpf::ApiYieldProcesor();
+            }
+            pushed += now;
+        }
+        next += count;
+    }
+}
+
+/**
+ * @brief       Pops ItemCount values, yielding while the ring is empty,
+ *              and checks they come out in the order they were pushed.
+ *
+ * @param[in] Context - A pointer to a MockSpscRingBufferContext.
+ */
+static void XPF_API
+MockSpscRingBufferConsumer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockSpscRingBufferContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    xpf::SpscRingBuffer<uint64_t>* ring = (nullptr != context->ConsumerRing) ? context->ConsumerRing
+                                                                              : context->Ring;
+    uint64_t batch[64] = { 0 };
+    uint64_t expected = 0;
+    while (expected < context->ItemCount)
+    {
+        size_t count = 0;
+        if (1 == context->BatchSize)
+        {
+            count = ring->TryPop(batch[0]) ? 1 : 0;
+        }
+        else
+        {
+            count = ring->PopN(xpf::MutableSpan<uint64_t>{ batch, context->BatchSize });
+        }
+
+        if (0 == count)
+        {
+            xpf::ApiYieldProcesor();
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            context->OutOfOrder += (batch[i] == expected++) ? 0 : 1;
+        }
+    }
+}
+
+/**
+ * @brief       Runs one producer and one consumer through the ring.
+ *
+ * @param[in,out] Context - The context shared by the two threads.
+ *
+ * @return The duration, in 100 ns units.
+ */
+static uint64_t
+MockSpscRingBufferRunPipeline(
+    _Inout_ MockSpscRingBufferContext& Context
+) noexcept(true)
+{
+    xpf::thread::Thread producer;
+    xpf::thread::Thread consumer;
+
+    const uint64_t start = xpf::ApiCurrentTime();
+    if (NT_SUCCESS(consumer.Run(MockSpscRingBufferConsumer, &Context)))
+    {
+        if (NT_SUCCESS(producer.Run(MockSpscRingBufferProducer, &Context)))
+        {
+            producer.Join();
+        }
+        else
+        {
+            /* Let the consumer finish - it is waiting for every value. */
+            MockSpscRingBufferProducer(&Context);
+        }
+        consumer.Join();
+    }
+    return xpf::ApiCurrentTime() - start;
+}
+
+/**
+ * @brief       The baseline - the same pipeline through a ring built for many threads.
+ */
+using MockSpscBaselineRing = xpf::MpmcRingBuffer<uint64_t, 1024>;
+
+/**
+ * @brief       The context of the MpmcRingBuffer baseline.
+ */
+struct MockSpscBaselineContext
+{
+    /**
+     * @brief The ring under test.
+     */
+    MockSpscBaselineRing* Ring = nullptr;
+
+    /**
+     * @brief The producer pushes the values [0, ItemCount) in order.
+     */
+    uint64_t ItemCount = 0;
+
+    /**
+     * @brief Filled by the consumer - how many values did not come out in order.
+     */
+    uint64_t OutOfOrder = 0;
+};
+
+/**
+ * @brief       Pushes ItemCount values in the MpmcRingBuffer with SpinPush.
+ *
+ * @param[in] Context - A pointer to a MockSpscBaselineContext.
+ */
+static void XPF_API
+MockSpscBaselineProducer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockSpscBaselineContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    for (uint64_t i = 0; i < context->ItemCount; ++i)
+    {
+        uint64_t value = i;
+        context->Ring->SpinPush(xpf::Move(value));
+    }
+}
+
+/**
+ * @brief       Pops ItemCount values from the MpmcRingBuffer with SpinPop.
+ *
+ * @param[in] Context - A pointer to a MockSpscBaselineContext.
+ */
+static void XPF_API
+MockSpscBaselineConsumer(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockSpscBaselineContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    for (uint64_t i = 0; i < context->ItemCount; ++i)
+    {
+        uint64_t value = 0;
+        context->Ring->SpinPop(value);
+        context->OutOfOrder += (value == i) ? 0 : 1;
+    }
+}
+
+/**
+ * @brief       This tests the storage states - invalid capacities, a second Allocate,
+ *              and a ring without storage rejecting everything.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, Storage)
+{
+    xpf::SpscRingBuffer<uint32_t> ring;
+    uint32_t value = 7;
+
+    XPF_TEST_EXPECT_TRUE(0 == ring.Capacity());
+    XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(!ring.TryPush(value));
+    XPF_TEST_EXPECT_TRUE(!ring.TryPop(value));
+    XPF_TEST_EXPECT_TRUE(0 == ring.PushN(xpf::Span<uint32_t>{ &value, 1 }));
+    XPF_TEST_EXPECT_TRUE(0 == ring.PopN(xpf::MutableSpan<uint32_t>{ &value, 1 }));
+
+    size_t regionSize = 0;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::SpscRingBuffer<uint32_t>::RegionSize(16, &regionSize)));
+    XPF_TEST_EXPECT_TRUE(sizeof(xpf::SpscRingBufferHeader) + 16 * sizeof(uint32_t) == regionSize);
+    size_t invalidSize = 1;
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == xpf::SpscRingBuffer<uint32_t>::RegionSize(12, &invalidSize));
+    XPF_TEST_EXPECT_TRUE(0 == invalidSize);
+
+    alignas(XPF_DEFAULT_ALIGNMENT) uint8_t region[sizeof(xpf::SpscRingBufferHeader) + 16 * sizeof(uint32_t) + XPF_DEFAULT_ALIGNMENT] = { 0 };
+
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.Allocate(0));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.Allocate(12));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.Attach(nullptr, sizeof(region), 16));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.Attach(region, sizeof(region), 12));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.Attach(region, sizeof(region), 32));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.Attach(&region[1], sizeof(region) - 1, 16));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == ring.AttachExisting(region, sizeof(region)));
+    XPF_TEST_EXPECT_TRUE(STATUS_INTEGER_OVERFLOW == ring.Allocate(size_t{ 1 } << (sizeof(size_t) * 8 - 1)));
+    XPF_TEST_EXPECT_TRUE(0 == ring.Capacity());
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(ring.Allocate(16)));
+    XPF_TEST_EXPECT_TRUE(16 == ring.Capacity());
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_STATE_TRANSITION == ring.Allocate(16));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_STATE_TRANSITION == ring.Attach(region, sizeof(region), 16));
+
+    //
+    // A region laid out for 16 can't be joined through a smaller view of it.
+    //
+    xpf::SpscRingBuffer<uint32_t> laidOut;
+    xpf::SpscRingBuffer<uint32_t> joined;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(laidOut.Attach(region, sizeof(region), 16)));
+    XPF_TEST_EXPECT_TRUE(STATUS_INVALID_PARAMETER == joined.AttachExisting(region, regionSize - 1));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(joined.AttachExisting(region, regionSize)));
+    XPF_TEST_EXPECT_TRUE(16 == joined.Capacity());
+}
+
+/**
+ * @brief       This tests a single thread filling, draining and wrapping around the ring
+ *              one element at a time.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, SingleThreaded)
+{
+    xpf::SpscRingBuffer<uint32_t> ring;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(ring.Allocate(8)));
+
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    uint32_t value = 0;
+    for (size_t lap = 0; lap < 10; ++lap)
+    {
+        while (ring.Size() < 8)
+        {
+            XPF_TEST_EXPECT_TRUE(ring.TryPush(next++));
+        }
+        XPF_TEST_EXPECT_TRUE(!ring.TryPush(uint32_t{ 1000 }));
+
+        //
+        // Pop a few - a different number each lap, so the ring wraps at a different cell.
+        //
+        for (size_t i = 0; i < 3 + (lap % 4); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(ring.TryPop(value));
+            XPF_TEST_EXPECT_TRUE(expected++ == value);
+        }
+    }
+    while (ring.TryPop(value))
+    {
+        XPF_TEST_EXPECT_TRUE(expected++ == value);
+    }
+    XPF_TEST_EXPECT_TRUE(next == expected);
+    XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+}
+
+/**
+ * @brief       This tests the bulk operations - a partial PushN when there is not
+ *              enough room, a partial PopN when there are not enough elements,
+ *              and copies which wrap around the end of the buffer.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, BulkOperations)
+{
+    xpf::SpscRingBuffer<uint32_t> ring;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(ring.Allocate(8)));
+
+    uint32_t input[12] = { 0 };
+    uint32_t output[12] = { 0 };
+    for (uint32_t i = 0; i < XPF_ARRAYSIZE(input); ++i)
+    {
+        input[i] = i;
+    }
+
+    //
+    // Only 8 fit - the first 8 are taken.
+    //
+    XPF_TEST_EXPECT_TRUE(8 == ring.PushN(xpf::Span<uint32_t>{ input, 12 }));
+    XPF_TEST_EXPECT_TRUE(0 == ring.PushN(xpf::Span<uint32_t>{ &input[8], 4 }));
+    XPF_TEST_EXPECT_TRUE(0 == ring.PushN(xpf::Span<uint32_t>{}));
+
+    XPF_TEST_EXPECT_TRUE(5 == ring.PopN(xpf::MutableSpan<uint32_t>{ output, 5 }));
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i == output[i]);
+    }
+
+    //
+    // The head is at cell 5 and the tail at cell 0 - the next push wraps.
+    // Then pop everything: the copy out wraps as well, and only 7 are there.
+    //
+    XPF_TEST_EXPECT_TRUE(4 == ring.PushN(xpf::Span<uint32_t>{ &input[8], 4 }));
+    XPF_TEST_EXPECT_TRUE(7 == ring.Size());
+    XPF_TEST_EXPECT_TRUE(7 == ring.PopN(xpf::MutableSpan<uint32_t>{ output }));
+    for (uint32_t i = 0; i < 7; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i + 5 == output[i]);
+    }
+    XPF_TEST_EXPECT_TRUE(0 == ring.PopN(xpf::MutableSpan<uint32_t>{ output }));
+    XPF_TEST_EXPECT_TRUE(0 == ring.PopN(xpf::MutableSpan<uint32_t>{}));
+    XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+
+    //
+    // Single and bulk operations mix.
+    //
+    XPF_TEST_EXPECT_TRUE(ring.TryPush(uint32_t{ 100 }));
+    XPF_TEST_EXPECT_TRUE(3 == ring.PushN(xpf::Span<uint32_t>{ input, 3 }));
+    XPF_TEST_EXPECT_TRUE(ring.TryPop(output[0]));
+    XPF_TEST_EXPECT_TRUE(100 == output[0]);
+    XPF_TEST_EXPECT_TRUE(3 == ring.PopN(xpf::MutableSpan<uint32_t>{ output, 3 }));
+    XPF_TEST_EXPECT_TRUE((0 == output[0]) && (1 == output[1]) && (2 == output[2]));
+}
+
+/**
+ * @brief       This tests a ring attached to a caller-supplied region: the elements
+ *              land in the cells after the header, and the ring does not free the region.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, AttachedRegion)
+{
+    alignas(XPF_DEFAULT_ALIGNMENT) uint8_t region[sizeof(xpf::SpscRingBufferHeader) + 4 * sizeof(uint64_t)] = { 0 };
+    {
+        xpf::SpscRingBuffer<uint64_t> ring;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(ring.Attach(region, sizeof(region), 4)));
+        XPF_TEST_EXPECT_TRUE(4 == ring.Capacity());
+
+        for (uint64_t i = 0; i < 6; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(ring.TryPush(i + 10));
+
+            uint64_t value = 0;
+            XPF_TEST_EXPECT_TRUE(ring.TryPop(value));
+            XPF_TEST_EXPECT_TRUE(i + 10 == value);
+        }
+        XPF_TEST_EXPECT_TRUE(ring.TryPush(uint64_t{ 42 }));
+    }
+
+    //
+    // Positions 0..5 went to cells 0,1,2,3,0,1 - and 42 to cell 2.
+    // The indices are in the header, at the start of the region.
+    //
+    uint64_t cells[4] = { 0 };
+    xpf::ApiCopyMemory(cells, &region[sizeof(xpf::SpscRingBufferHeader)], sizeof(cells));
+    XPF_TEST_EXPECT_TRUE(14 == cells[0]);
+    XPF_TEST_EXPECT_TRUE(15 == cells[1]);
+    XPF_TEST_EXPECT_TRUE(42 == cells[2]);
+    XPF_TEST_EXPECT_TRUE(13 == cells[3]);
+
+    const xpf::SpscRingBufferHeader* header = reinterpret_cast<const xpf::SpscRingBufferHeader*>(&region[0]);
+    XPF_TEST_EXPECT_TRUE(6 == header->Consumer.Get().Head.Load());
+    XPF_TEST_EXPECT_TRUE(7 == header->Producer.Get().Tail.Load());
+    XPF_TEST_EXPECT_TRUE(4 == header->Capacity);
+}
+
+/**
+ * @brief       This tests the region alone carries the ring: a copy of it, at another
+ *              address, is joined by a new object and gives back the same elements.
+ *              This is what a second mapping of shared memory looks like.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, RegionIsPositionIndependent)
+{
+    alignas(XPF_DEFAULT_ALIGNMENT) uint8_t region[sizeof(xpf::SpscRingBufferHeader) + 8 * sizeof(uint32_t)] = { 0 };
+    alignas(XPF_DEFAULT_ALIGNMENT) uint8_t mapping[sizeof(region)] = { 0 };
+
+    xpf::SpscRingBuffer<uint32_t> producer;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(producer.Attach(region, sizeof(region), 8)));
+
+    const uint32_t input[] = { 1, 2, 3, 4, 5, 6 };
+    XPF_TEST_EXPECT_TRUE(6 == producer.PushN(xpf::Span<uint32_t>{ input }));
+
+    uint32_t value = 0;
+    XPF_TEST_EXPECT_TRUE(producer.TryPop(value));
+    XPF_TEST_EXPECT_TRUE(1 == value);
+
+    xpf::ApiCopyMemory(mapping, region, sizeof(region));
+
+    xpf::SpscRingBuffer<uint32_t> consumer;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(consumer.AttachExisting(mapping, sizeof(mapping))));
+    XPF_TEST_EXPECT_TRUE(8 == consumer.Capacity());
+    XPF_TEST_EXPECT_TRUE(5 == consumer.Size());
+
+    uint32_t output[8] = { 0 };
+    XPF_TEST_EXPECT_TRUE(5 == consumer.PopN(xpf::MutableSpan<uint32_t>{ output }));
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(i + 2 == output[i]);
+    }
+    XPF_TEST_EXPECT_TRUE(consumer.IsEmpty());
+}
+
+/**
+ * @brief       This tests a producer thread and a consumer thread going through a small
+ *              ring, one element at a time and in batches: every value comes out, in order.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, ProducerConsumer)
+{
+    const size_t batchSizes[] = { 1, 7, 64 };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(batchSizes); ++i)
+    {
+        xpf::SpscRingBuffer<uint64_t> ring;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(ring.Allocate(128)));
+
+        MockSpscRingBufferContext context;
+        context.Ring = &ring;
+        context.ItemCount = 200000;
+        context.BatchSize = batchSizes[i];
+
+        (void) MockSpscRingBufferRunPipeline(context);
+
+        XPF_TEST_EXPECT_TRUE(0 == context.OutOfOrder);
+        XPF_TEST_EXPECT_TRUE(ring.IsEmpty());
+    }
+}
+
+/**
+ * @brief       This tests a producer and a consumer which each have their own
+ *              SpscRingBuffer object over the same region - as with shared memory.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, ProducerConsumerOverSharedRegion)
+{
+    size_t regionSize = 0;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::SpscRingBuffer<uint64_t>::RegionSize(128, &regionSize)));
+
+    void* region = xpf::MemoryAllocator::AllocateMemory(regionSize);
+    XPF_TEST_EXPECT_TRUE(nullptr != region);
+    _Analysis_assume_(nullptr != region);
+
+    {
+        xpf::SpscRingBuffer<uint64_t> producer;
+        xpf::SpscRingBuffer<uint64_t> consumer;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(producer.Attach(region, regionSize, 128)));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(consumer.AttachExisting(region, regionSize)));
+
+        MockSpscRingBufferContext context;
+        context.Ring = &producer;
+        context.ConsumerRing = &consumer;
+        context.ItemCount = 200000;
+        context.BatchSize = 7;
+
+        (void) MockSpscRingBufferRunPipeline(context);
+
+        XPF_TEST_EXPECT_TRUE(0 == context.OutOfOrder);
+        XPF_TEST_EXPECT_TRUE(producer.IsEmpty());
+        XPF_TEST_EXPECT_TRUE(consumer.IsEmpty());
+    }
+
+    xpf::MemoryAllocator::FreeMemory(region);
+}
+
+/**
+ * @brief       Compares a pipeline stage handing values to the next one through the
+ *              SpscRingBuffer - one at a time and in batches of 64 - against the
+ *              MpmcRingBuffer, which pays a compare-exchange per value on each side,
+ *              and logs the timings.
+ *
+ * @param[in]   ItemCount - The number of values handed over.
+ *
+ * @param[out]  Scenario - NTSTATUS pointer for test failure reporting.
+ */
+static void XPF_API
+MockSpscRingBufferBenchmarkAgainstMpmcRingBuffer(
+    _In_ uint64_t ItemCount,
+    _Inout_ NTSTATUS* Scenario
+) noexcept(true)
+{
+    bool isCorrect = true;
+
+    uint64_t spscDuration = 0;
+    uint64_t spscBatchDuration = 0;
+    {
+        xpf::SpscRingBuffer<uint64_t> ring;
+        if (!NT_SUCCESS(ring.Allocate(1024)))
+        {
+            (*Scenario) = STATUS_UNSUCCESSFUL;
+            return;
+        }
+
+        MockSpscRingBufferContext context;
+        context.Ring = &ring;
+        context.ItemCount = ItemCount;
+
+        context.BatchSize = 1;
+        spscDuration = MockSpscRingBufferRunPipeline(context);
+        isCorrect = (0 == context.OutOfOrder) && isCorrect;
+
+        context.BatchSize = 64;
+        spscBatchDuration = MockSpscRingBufferRunPipeline(context);
+        isCorrect = (0 == context.OutOfOrder) && isCorrect;
+    }
+
+    uint64_t mpmcDuration = 0;
+    {
+        MockSpscBaselineRing ring;
+        MockSpscBaselineContext context;
+        context.Ring = &ring;
+        context.ItemCount = ItemCount;
+
+        xpf::thread::Thread producer;
+        xpf::thread::Thread consumer;
+        const uint64_t start = xpf::ApiCurrentTime();
+        isCorrect = NT_SUCCESS(consumer.Run(MockSpscBaselineConsumer, &context)) && isCorrect;
+        isCorrect = NT_SUCCESS(producer.Run(MockSpscBaselineProducer, &context)) && isCorrect;
+        producer.Join();
+        consumer.Join();
+        mpmcDuration = xpf::ApiCurrentTime() - start;
+
+        isCorrect = (0 == context.OutOfOrder) && isCorrect;
+    }
+
+    if (!isCorrect)
+    {
+        (*Scenario) = STATUS_UNSUCCESSFUL;
+    }
+
+    xpf_test::LogTestInfo("    > 1 producer, 1 consumer, %llu values: SpscRingBuffer %llu, SpscRingBuffer (batches of 64) %llu, MpmcRingBuffer %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(ItemCount),                                           // NOLINT(*)
+                          static_cast<unsigned long long>(spscDuration),                                        // NOLINT(*)
+                          static_cast<unsigned long long>(spscBatchDuration),                                   // NOLINT(*)
+                          static_cast<unsigned long long>(mpmcDuration));                                       // NOLINT(*)
+}
+
+/**
+ * @brief       This compares the SpscRingBuffer against the MpmcRingBuffer, at 200K values.
+ */
+XPF_TEST_SCENARIO(TestSpscRingBuffer, BenchmarkAgainstMpmcRingBuffer)
+{
+    MockSpscRingBufferBenchmarkAgainstMpmcRingBuffer(200000, _XpfArgScenario);
+}
+
+#if defined XPF_TESTS_ENABLE_LARGE_BENCHMARKS
+    /**
+     * @brief       The same comparison at 2M values. Only built with XPF_TESTS_ENABLE_LARGE_BENCHMARKS.
+     */
+    XPF_TEST_SCENARIO(TestSpscRingBuffer, LargeBenchmarkAgainstMpmcRingBuffer)
+    {
+        MockSpscRingBufferBenchmarkAgainstMpmcRingBuffer(2000000, _XpfArgScenario);
+    }
+#endif  // XPF_TESTS_ENABLE_LARGE_BENCHMARKS
@@ -327,3 +327,66 @@ XPF_TEST_SCENARIO(TestTwoLockQueue, InterleavedPushPop)
 
     XPF_TEST_EXPECT_TRUE(nullptr == xpf::TlqPop(tlq));
 }
+
+/**
+ * @brief       This tests pushing and popping chains of elements.
+ */
+XPF_TEST_SCENARIO(TestTwoLockQueue, PushListPopList)
+{
+    xpf::TwoLockQueue tlq;
+    MockTestTlqElement elements[6];
+    size_t removedElements = 0;
+
+    //
+    // [0] --> [1] --> [2] pushed as one chain on an empty queue.
+    //
+    for (size_t i = 0; i < XPF_ARRAYSIZE(elements); ++i)
+    {
+        elements[i].DummyValue = static_cast<int8_t>(i);
+    }
+    elements[0].ListEntry.Next = &elements[1].ListEntry;
+    elements[1].ListEntry.Next = &elements[2].ListEntry;
+    xpf::TlqPushList(tlq, &elements[0].ListEntry, &elements[2].ListEntry);
+
+    //
+    // [0] --> [1] --> [2] --> [3] --> [4] --> [5] - the second chain goes at the tail.
+    //
+    elements[3].ListEntry.Next = &elements[4].ListEntry;
+    elements[4].ListEntry.Next = &elements[5].ListEntry;
+    xpf::TlqPushList(tlq, &elements[3].ListEntry, &elements[5].ListEntry);
+    XPF_TEST_EXPECT_TRUE(tlq.Tail == &elements[5].ListEntry);
+
+    //
+    // Pop [0] --> [1] --> [2] --> [3].
+    //
+    xpf::XPF_SINGLE_LIST_ENTRY* chain = xpf::TlqPopList(tlq, 4, &removedElements);
+    XPF_TEST_EXPECT_TRUE(removedElements == 4);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(chain == &elements[i].ListEntry);
+        chain = chain->Next;
+    }
+    XPF_TEST_EXPECT_TRUE(chain == nullptr);
+
+    //
+    // Pop everything else - even if we ask for more. The queue must end up empty.
+    //
+    chain = xpf::TlqPopList(tlq, 10, &removedElements);
+    size_t totalRemoved = removedElements;
+    while (nullptr != tlq.Head)
+    {
+        (void) xpf::TlqPopList(tlq, 10, &removedElements);
+        totalRemoved += removedElements;
+    }
+    XPF_TEST_EXPECT_TRUE(chain == &elements[4].ListEntry);
+    XPF_TEST_EXPECT_TRUE(totalRemoved == 2);
+    XPF_TEST_EXPECT_TRUE(tlq.Head == nullptr);
+    XPF_TEST_EXPECT_TRUE(tlq.Tail == nullptr);
+
+    //
+    // Popping from an empty queue returns nothing.
+    //
+    chain = xpf::TlqPopList(tlq, 10, &removedElements);
+    XPF_TEST_EXPECT_TRUE(chain == nullptr);
+    XPF_TEST_EXPECT_TRUE(removedElements == 0);
+}
@@ -24,7 +24,7 @@ XPF_TEST_SCENARIO(TestVector, DefaultConstructorDestructor)
     XPF_TEST_EXPECT_TRUE(vector.Size() == size_t{ 0 });
     XPF_TEST_EXPECT_TRUE(vector.IsEmpty());
 
-    const size_t expectedVectorSize = sizeof(void*) * 3 + 2 * sizeof(size_t);
+    const size_t expectedVectorSize = sizeof(xpf::PolymorphicAllocator) + sizeof(void*) + 2 * sizeof(size_t);
     static_assert(expectedVectorSize == static_cast<size_t>(sizeof(vector)),
                   "Compile time size check!");
 }
@@ -338,3 +338,474 @@ XPF_TEST_SCENARIO(TestVector, Reserve)
     XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
     XPF_TEST_EXPECT_TRUE(vector.Size() == 0);
 }
+
+/**
+ * @brief       This is a mock which keeps a pointer to itself, so it can't be relocated with a memory copy.
+ *              It is used to validate the element by element path of the vector.
+ */
+class MockVectorSelfReference
+{
+ public:
+/**
+ * @brief Constructor.
+ *
+ * @param[in] Value - The value to be stored.
+ */
+MockVectorSelfReference(
+    _In_ uint64_t Value
+) noexcept(true) : m_Self{ this }, m_Value{ Value }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Copy constructor.
+ *
+ * @param[in] Other - The other object to construct from.
+ */
+MockVectorSelfReference(
+    _In_ _Const_ const MockVectorSelfReference& Other
+) noexcept(true) : m_Self{ this }, m_Value{ Other.m_Value }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Move constructor.
+ *
+ * @param[in,out] Other - The other object to construct from.
+ */
+MockVectorSelfReference(
+    _Inout_ MockVectorSelfReference&& Other
+) noexcept(true) : m_Self{ this }, m_Value{ Other.m_Value }
+{
+    XPF_NOTHING();
+}
+
+/**
+ * @brief Move assignment.
+ *
+ * @param[in,out] Other - The other object to assign from.
+ *
+ * @return A reference to *this object after move.
+ */
+MockVectorSelfReference&
+operator=(
+    _Inout_ MockVectorSelfReference&& Other
+) noexcept(true)
+{
+    this->m_Value = Other.m_Value;
+    return *this;
+}
+
+/**
+ * @brief Destructor.
+ */
+~MockVectorSelfReference(
+    void
+) noexcept(true) = default;
+
+/**
+ * @brief Checks that the object was not relocated with a memory copy.
+ *
+ * @param[in] Value - The expected value.
+ *
+ * @return true if the object is at the address it was constructed at and holds Value.
+ */
+inline bool
+IsValid(
+    _In_ uint64_t Value
+) const noexcept(true)
+{
+    return (this->m_Self == this) && (this->m_Value == Value);
+}
+
+ private:
+    const MockVectorSelfReference* m_Self = nullptr;
+    uint64_t m_Value = 0;
+};
+
+/**
+ * @brief       Emplaces a number of elements into a vector.
+ *
+ * @param[in] Iterations - How many elements to emplace.
+ *
+ * @param[in] PreSize - If true, the capacity is reserved first.
+ *
+ * @return The elapsed time, in 100 ns units.
+ */
+template <class Type>
+static uint64_t XPF_API
+MockVectorEmplaceElements(
+    _In_ size_t Iterations,
+    _In_ bool PreSize
+) noexcept(true)
+{
+    const uint64_t startTime = xpf::ApiCurrentTime();
+
+    xpf::Vector<Type> vector;
+    if (PreSize)
+    {
+        XPF_DEATH_ON_FAILURE(NT_SUCCESS(vector.ReserveCapacity(Iterations)));
+    }
+    for (size_t i = 0; i < Iterations; ++i)
+    {
+        XPF_DEATH_ON_FAILURE(NT_SUCCESS(vector.Emplace(i)));
+    }
+
+    return xpf::ApiCurrentTime() - startTime;
+}
+
+/**
+ * @brief       This tests the ReserveCapacity method.
+ */
+XPF_TEST_SCENARIO(TestVector, ReserveCapacity)
+{
+    xpf::Vector<uint64_t> vector;
+    XPF_TEST_EXPECT_TRUE(0 == vector.Capacity());
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.ReserveCapacity(100)));
+    XPF_TEST_EXPECT_TRUE(100 == vector.Capacity());
+    XPF_TEST_EXPECT_TRUE(vector.IsEmpty());
+
+    //
+    // Emplacing within the capacity does not reallocate.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(uint64_t{ 1 })));
+    const uint64_t* firstElement = &vector[0];
+    for (uint64_t i = 2; i <= 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(firstElement == &vector[0]);
+    XPF_TEST_EXPECT_TRUE(100 == vector.Capacity());
+
+    //
+    // A smaller capacity is a no-op.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.ReserveCapacity(10)));
+    XPF_TEST_EXPECT_TRUE(100 == vector.Capacity());
+    XPF_TEST_EXPECT_TRUE(100 == vector.Size());
+
+    //
+    // A larger one keeps the elements.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.ReserveCapacity(1000)));
+    XPF_TEST_EXPECT_TRUE(1000 == vector.Capacity());
+    for (size_t i = 0; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(vector[i] == i + 1);
+    }
+
+    //
+    // Overflow during computation.
+    //
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.ReserveCapacity(xpf::NumericLimits<size_t>::MaxValue())));
+    XPF_TEST_EXPECT_TRUE(1000 == vector.Capacity());
+}
+
+/**
+ * @brief       This tests growing and erasing with relocatable and non-relocatable elements.
+ */
+XPF_TEST_SCENARIO(TestVector, Relocation)
+{
+    static_assert(xpf::IsTriviallyRelocatable<uint64_t>(), "Trivially copyable!");
+    static_assert(xpf::IsTriviallyRelocatable<xpf::Vector<uint64_t>>(), "Opted-in!");
+    static_assert(!xpf::IsTriviallyRelocatable<MockVectorSelfReference>(), "Not relocatable!");
+
+    //
+    // Element by element path.
+    //
+    xpf::Vector<MockVectorSelfReference> selfReferences;
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(selfReferences.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(selfReferences.Erase(0)));
+    for (size_t i = 0; i < selfReferences.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(selfReferences[i].IsValid(i + 1));
+    }
+
+    //
+    // Memory copy path with opted-in elements which own memory.
+    //
+    xpf::Vector<xpf::Vector<uint64_t>> vectors;
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vectors.Emplace()));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vectors[vectors.Size() - 1].Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vectors.Erase(0)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vectors.Erase(50)));
+    XPF_TEST_EXPECT_TRUE(98 == vectors.Size());
+    for (size_t i = 0; i < vectors.Size(); ++i)
+    {
+        const uint64_t expected = (i < 50) ? i + 1 : i + 2;
+        XPF_TEST_EXPECT_TRUE(1 == vectors[i].Size());
+        XPF_TEST_EXPECT_TRUE(expected == vectors[i][0]);
+    }
+}
+
+/**
+ * @brief       This tests that the capacity does not thrash around the growth boundary.
+ */
+XPF_TEST_SCENARIO(TestVector, ShrinkHysteresis)
+{
+    xpf::Vector<uint64_t> vector;
+    for (uint64_t i = 0; i < 64; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(64 == vector.Capacity());
+
+    //
+    // Alternate around the boundary - the capacity stays stable.
+    //
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+        XPF_TEST_EXPECT_TRUE(128 == vector.Capacity());
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Erase(vector.Size() - 1)));
+        XPF_TEST_EXPECT_TRUE(128 == vector.Capacity());
+    }
+
+    //
+    // Erase until less than a quarter is used - it shrinks by half only.
+    //
+    while (vector.Size() >= 32)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Erase(0)));
+    }
+    XPF_TEST_EXPECT_TRUE(64 == vector.Capacity());
+
+    //
+    // Small buffers are never shrunk.
+    //
+    while (!vector.IsEmpty())
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Erase(0)));
+    }
+    XPF_TEST_EXPECT_TRUE(16 == vector.Capacity());
+}
+
+/**
+ * @brief       This compares growing a vector by moving each element with the memory copy relocation,
+ *              and with a pre-sized vector.
+ */
+XPF_TEST_SCENARIO(TestVector, CapacityBenchmark)
+{
+    constexpr size_t iterations = 1000000;
+
+    const uint64_t moveTime = MockVectorEmplaceElements<MockVectorSelfReference>(iterations, false);
+    const uint64_t relocateTime = MockVectorEmplaceElements<uint64_t>(iterations, false);
+    const uint64_t reservedTime = MockVectorEmplaceElements<uint64_t>(iterations, true);
+
+    xpf_test::LogTestInfo("    > %llu elements: element moves %llu (100 ns), memory copy %llu (100 ns), "
+                          "reserved %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(iterations),                                          // NOLINT(*)
+                          static_cast<unsigned long long>(moveTime),                                            // NOLINT(*)
+                          static_cast<unsigned long long>(relocateTime),                                        // NOLINT(*)
+                          static_cast<unsigned long long>(reservedTime));                                       // NOLINT(*)
+}
+
+/**
+ * @brief       This tests the AppendRange and InsertRange methods.
+ */
+XPF_TEST_SCENARIO(TestVector, InsertRange)
+{
+    const uint64_t first[] = { 1, 2, 3 };
+    const uint64_t second[] = { 10, 20 };
+
+    xpf::Vector<uint64_t> vector;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.AppendRange(xpf::Span<uint64_t>{})));
+    XPF_TEST_EXPECT_TRUE(vector.IsEmpty());
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.AppendRange(xpf::Span<uint64_t>{ first })));
+    XPF_TEST_EXPECT_TRUE(3 == vector.Size());
+
+    //
+    // In the middle, at the front and at the back.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.InsertRange(1, xpf::Span<uint64_t>{ second })));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.InsertRange(0, xpf::Span<uint64_t>{ second })));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.InsertRange(vector.Size(), xpf::Span<uint64_t>{ first })));
+
+    const uint64_t expected[] = { 10, 20, 1, 10, 20, 2, 3, 1, 2, 3 };
+    XPF_TEST_EXPECT_TRUE(XPF_ARRAYSIZE(expected) == vector.Size());
+    for (size_t i = 0; i < XPF_ARRAYSIZE(expected); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(expected[i] == vector[i]);
+    }
+
+    //
+    // Invalid position and a range from the vector itself.
+    //
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.InsertRange(100, xpf::Span<uint64_t>{ first })));
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.AppendRange(xpf::Span<uint64_t>{ &vector[1], 2 })));
+    XPF_TEST_EXPECT_TRUE(XPF_ARRAYSIZE(expected) == vector.Size());
+
+    //
+    // A large range grows the vector only once.
+    //
+    xpf::Vector<uint64_t> large;
+    uint64_t values[1000] = { 0 };
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(large.AppendRange(xpf::Span<uint64_t>{ values })));
+    XPF_TEST_EXPECT_TRUE(1000 == large.Capacity());
+
+    //
+    // Non relocatable elements.
+    //
+    const MockVectorSelfReference mocks[] = { MockVectorSelfReference{ 100 }, MockVectorSelfReference{ 200 } };
+    xpf::Vector<MockVectorSelfReference> selfReferences;
+    for (uint64_t i = 0; i < 3; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(selfReferences.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(selfReferences.InsertRange(1, xpf::Span<MockVectorSelfReference>{ mocks })));
+    XPF_TEST_EXPECT_TRUE(5 == selfReferences.Size());
+    XPF_TEST_EXPECT_TRUE(selfReferences[0].IsValid(0));
+    XPF_TEST_EXPECT_TRUE(selfReferences[1].IsValid(100));
+    XPF_TEST_EXPECT_TRUE(selfReferences[2].IsValid(200));
+    XPF_TEST_EXPECT_TRUE(selfReferences[3].IsValid(1));
+    XPF_TEST_EXPECT_TRUE(selfReferences[4].IsValid(2));
+}
+
+/**
+ * @brief       This tests the EraseRange method.
+ */
+XPF_TEST_SCENARIO(TestVector, EraseRange)
+{
+    xpf::Vector<MockVectorSelfReference> vector;
+    for (uint64_t i = 0; i < 10; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.EraseRange(10, 0)));
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.EraseRange(5, 6)));
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.EraseRange(5, xpf::NumericLimits<size_t>::MaxValue())));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.EraseRange(5, 0)));
+    XPF_TEST_EXPECT_TRUE(10 == vector.Size());
+
+    //
+    // Erase 2, 3, 4 - then the last two.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.EraseRange(2, 3)));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.EraseRange(5, 2)));
+
+    const uint64_t expected[] = { 0, 1, 5, 6, 7 };
+    XPF_TEST_EXPECT_TRUE(XPF_ARRAYSIZE(expected) == vector.Size());
+    for (size_t i = 0; i < XPF_ARRAYSIZE(expected); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(vector[i].IsValid(expected[i]));
+    }
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.EraseRange(0, vector.Size())));
+    XPF_TEST_EXPECT_TRUE(vector.IsEmpty());
+
+    //
+    // A large erase shrinks the vector with a single reallocation.
+    //
+    xpf::Vector<uint64_t> large;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(large.ReserveCapacity(1024)));
+    for (uint64_t i = 0; i < 1024; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(large.Emplace(i)));
+    }
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(large.EraseRange(10, 1010)));
+    XPF_TEST_EXPECT_TRUE(32 == large.Capacity());
+    XPF_TEST_EXPECT_TRUE(14 == large.Size());
+    XPF_TEST_EXPECT_TRUE(1020 == large[10]);
+}
+
+/**
+ * @brief       This tests the EraseIf method.
+ */
+XPF_TEST_SCENARIO(TestVector, EraseIf)
+{
+    xpf::Vector<MockVectorSelfReference> vector;
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+
+    //
+    // Nothing to erase.
+    //
+    XPF_TEST_EXPECT_TRUE(0 == vector.EraseIf([&](const MockVectorSelfReference& Element)
+                                             {
+                                                 return Element.IsValid(1000);
+                                             }));
+    XPF_TEST_EXPECT_TRUE(100 == vector.Size());
+
+    //
+    // Erase the odd values - the predicate is called in order.
+    //
+    uint64_t index = 0;
+    XPF_TEST_EXPECT_TRUE(50 == vector.EraseIf([&](const MockVectorSelfReference& Element)
+                                              {
+                                                  XPF_DEATH_ON_FAILURE(Element.IsValid(index));
+                                                  return (0 != (index++ % 2));
+                                              }));
+    XPF_TEST_EXPECT_TRUE(50 == vector.Size());
+    for (size_t i = 0; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(vector[i].IsValid(i * 2));
+    }
+
+    //
+    // Erase everything.
+    //
+    xpf::Vector<uint64_t> values;
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(values.Emplace(i % 3)));
+    }
+    XPF_TEST_EXPECT_TRUE(34 == values.EraseIf([&](const uint64_t& Element) { return 0 == Element; }));
+    for (size_t i = 0; i < values.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(((i % 2) + 1) == values[i]);
+    }
+    XPF_TEST_EXPECT_TRUE(66 == values.EraseIf([&](const uint64_t&) { return true; }));
+    XPF_TEST_EXPECT_TRUE(values.IsEmpty());
+}
+
+/**
+ * @brief       This tests the SwapRemove method.
+ */
+XPF_TEST_SCENARIO(TestVector, SwapRemove)
+{
+    xpf::Vector<MockVectorSelfReference> vector;
+    for (uint64_t i = 0; i < 5; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(vector.SwapRemove(5)));
+
+    //
+    // The last element takes the place of the removed one.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.SwapRemove(1)));
+    XPF_TEST_EXPECT_TRUE(4 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(vector[0].IsValid(0));
+    XPF_TEST_EXPECT_TRUE(vector[1].IsValid(4));
+    XPF_TEST_EXPECT_TRUE(vector[2].IsValid(2));
+    XPF_TEST_EXPECT_TRUE(vector[3].IsValid(3));
+
+    //
+    // Removing the last element.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.SwapRemove(3)));
+    XPF_TEST_EXPECT_TRUE(3 == vector.Size());
+    XPF_TEST_EXPECT_TRUE(vector[2].IsValid(2));
+
+    xpf::Vector<uint64_t> values;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(values.Emplace(uint64_t{ 7 })));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(values.Emplace(uint64_t{ 8 })));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(values.SwapRemove(0)));
+    XPF_TEST_EXPECT_TRUE(8 == values[0]);
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(values.SwapRemove(0)));
+    XPF_TEST_EXPECT_TRUE(values.IsEmpty());
+}
@@ -0,0 +1,227 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestAtomicSharedPointer.cpp
+ *
+ * @brief       This contains tests for the atomic shared pointer.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       Counts how many MockSnapshot objects are alive.
+ */
+static volatile int32_t gMockSnapshotsAlive = 0;
+
+/**
+ * @brief       This is a mock snapshot. Both values are always equal,
+ *              so a reader can tell if it got a destroyed or a partially written object.
+ */
+class MockSnapshot
+{
+ public:
+/**
+ * @brief Constructor.
+ *
+ * @param[in] Value - The value of the snapshot.
+ */
+MockSnapshot(
+    _In_ uint64_t Value
+) noexcept(true) : m_First{ Value }, m_Second{ Value }
+{
+    xpf::ApiAtomicIncrement(&gMockSnapshotsAlive);
+}
+
+/**
+ * @brief Destructor. Poisons the values.
+ */
+~MockSnapshot(
+    void
+) noexcept(true)
+{
+    this->m_First = 1;
+    this->m_Second = 2;
+    xpf::ApiAtomicDecrement(&gMockSnapshotsAlive);
+}
+
+/**
+ * @brief Copy and move semantics are deleted.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(MockSnapshot, delete);
+
+/**
+ * @brief The first value.
+ */
+volatile uint64_t m_First = 0;
+
+/**
+ * @brief The second value.
+ */
+volatile uint64_t m_Second = 0;
+};
+
+/**
+ * @brief       This is the context shared by the stress threads.
+ */
+struct MockAtomicSharedPointerContext
+{
+    /**
+     * @brief   The value being published.
+     */
+    xpf::AtomicSharedPointer<MockSnapshot> Pointer;
+
+    /**
+     * @brief   Used to give each thread a role.
+     */
+    volatile uint32_t ThreadIndex = 0;
+
+    /**
+     * @brief   Set when a reader saw an inconsistent snapshot.
+     */
+    volatile uint32_t Corruptions = 0;
+};
+
+/**
+ * @brief       This is a mock callback used for stress testing.
+ *              The first two threads publish new values, the others read them.
+ *
+ * @param[in] Context - A pointer to a MockAtomicSharedPointerContext.
+ */
+static void XPF_API
+MockAtomicSharedPointerStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockAtomicSharedPointerContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    const uint32_t threadIndex = xpf::ApiAtomicIncrement(&context->ThreadIndex);
+    for (uint64_t i = 0; i < 10000; ++i)
+    {
+        if (threadIndex <= 2)
+        {
+            auto snapshot = xpf::MakeShared<MockSnapshot>(i + 100);
+            XPF_DEATH_ON_FAILURE(!snapshot.IsEmpty());
+            context->Pointer.Store(snapshot);
+        }
+        else
+        {
+            auto snapshot = context->Pointer.Load();
+            if (snapshot.IsEmpty())
+            {
+                continue;
+            }
+            if (((*snapshot).m_First != (*snapshot).m_Second) || ((*snapshot).m_First < 100))
+            {
+                xpf::ApiAtomicIncrement(&context->Corruptions);
+            }
+        }
+    }
+}
+
+/**
+ * @brief       This tests the default constructor and the constructor with a value.
+ */
+XPF_TEST_SCENARIO(TestAtomicSharedPointer, Constructors)
+{
+    xpf::AtomicSharedPointer<int> empty;
+    XPF_TEST_EXPECT_TRUE(empty.Load().IsEmpty());
+
+    auto value = xpf::MakeShared<int>(100);
+    XPF_TEST_EXPECT_TRUE(!value.IsEmpty());
+
+    xpf::AtomicSharedPointer<int> pointer{ value };
+    auto loaded = pointer.Load();
+    XPF_TEST_EXPECT_TRUE(!loaded.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(100 == (*loaded));
+    XPF_TEST_EXPECT_TRUE(loaded.Get() == value.Get());
+}
+
+/**
+ * @brief       This tests Store, Load and Exchange.
+ */
+XPF_TEST_SCENARIO(TestAtomicSharedPointer, StoreLoadExchange)
+{
+    xpf::AtomicSharedPointer<int> pointer;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        pointer.Store(xpf::MakeShared<int>(i));
+        XPF_TEST_EXPECT_TRUE(i == (*pointer.Load()));
+    }
+
+    //
+    // A loaded value stays valid after it is replaced.
+    //
+    auto snapshot = pointer.Load();
+    auto previous = pointer.Exchange(xpf::MakeShared<int>(100));
+    XPF_TEST_EXPECT_TRUE(previous.Get() == snapshot.Get());
+    XPF_TEST_EXPECT_TRUE(9 == (*snapshot));
+    XPF_TEST_EXPECT_TRUE(100 == (*pointer.Load()));
+
+    pointer.Store(xpf::SharedPointer<int>{});
+    XPF_TEST_EXPECT_TRUE(pointer.Load().IsEmpty());
+}
+
+/**
+ * @brief       This tests CompareExchange.
+ */
+XPF_TEST_SCENARIO(TestAtomicSharedPointer, CompareExchange)
+{
+    auto first = xpf::MakeShared<int>(1);
+    auto second = xpf::MakeShared<int>(2);
+    xpf::AtomicSharedPointer<int> pointer{ first };
+
+    //
+    // Same value, different object - fails and updates the expected value.
+    //
+    auto expected = xpf::MakeShared<int>(1);
+    XPF_TEST_EXPECT_TRUE(!pointer.CompareExchange(expected, second));
+    XPF_TEST_EXPECT_TRUE(expected.Get() == first.Get());
+    XPF_TEST_EXPECT_TRUE(pointer.Load().Get() == first.Get());
+
+    //
+    // Now expected is the current value.
+    //
+    XPF_TEST_EXPECT_TRUE(pointer.CompareExchange(expected, second));
+    XPF_TEST_EXPECT_TRUE(pointer.Load().Get() == second.Get());
+
+    //
+    // An empty expected value matches only an empty pointer.
+    //
+    xpf::SharedPointer<int> emptyExpected;
+    XPF_TEST_EXPECT_TRUE(!pointer.CompareExchange(emptyExpected, first));
+    XPF_TEST_EXPECT_TRUE(emptyExpected.Get() == second.Get());
+}
+
+/**
+ * @brief       This tests concurrent readers and writers.
+ */
+XPF_TEST_SCENARIO(TestAtomicSharedPointer, Stress)
+{
+    {
+        MockAtomicSharedPointerContext context;
+        xpf::thread::Thread threads[8];
+
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockAtomicSharedPointerStressCallback, &context)));
+        }
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            threads[i].Join();
+        }
+
+        XPF_TEST_EXPECT_TRUE(0 == context.Corruptions);
+        XPF_TEST_EXPECT_TRUE(1 == gMockSnapshotsAlive);
+    }
+    XPF_TEST_EXPECT_TRUE(0 == gMockSnapshotsAlive);
+}
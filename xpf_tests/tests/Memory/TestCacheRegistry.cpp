@@ -0,0 +1,244 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestCacheRegistry.cpp
+ *
+ * @brief       This contains tests for the cache registry and the cache trimmer.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       This is a mock cache - it only counts the calls.
+ */
+struct MockCache
+{
+    /**
+     * @brief   How many bytes are "cached".
+     */
+    size_t CachedBytes = 0;
+
+    /**
+     * @brief   How many times the trim function was called.
+     */
+    size_t TrimCalls = 0;
+
+    /**
+     * @brief   The level of the last trim.
+     */
+    xpf::CacheTrimLevel LastLevel = xpf::CacheTrimLevel::Idle;
+};
+
+/**
+ * @brief       The trim function of the mock cache. Gives back everything.
+ *
+ * @param[in] Context - A pointer to a MockCache.
+ *
+ * @param[in] Level - The trim level.
+ *
+ * @return The number of "released" bytes.
+ */
+static size_t
+MockCacheTrim(
+    _In_ void* Context,
+    _In_ xpf::CacheTrimLevel Level
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    MockCache* cache = static_cast<MockCache*>(Context);
+
+    const size_t releasedBytes = cache->CachedBytes;
+    cache->CachedBytes = 0;
+    cache->TrimCalls++;
+    cache->LastLevel = Level;
+    return releasedBytes;
+}
+
+/**
+ * @brief       The size function of the mock cache.
+ *
+ * @param[in] Context - A pointer to a MockCache.
+ *
+ * @return The number of "cached" bytes.
+ */
+static size_t
+MockCacheSize(
+    _In_ void* Context
+) noexcept(true)
+{
+    XPF_DEATH_ON_FAILURE(nullptr != Context);
+    return static_cast<MockCache*>(Context)->CachedBytes;
+}
+
+/**
+ * @brief       This tests registering and unregistering a cache.
+ */
+XPF_TEST_SCENARIO(TestCacheRegistry, RegisterUnregister)
+{
+    MockCache cache;
+    xpf::CacheRegistryEntry entry;
+    entry.Context = &cache;
+    entry.TrimFunction = &MockCacheTrim;
+    entry.SizeFunction = &MockCacheSize;
+
+    xpf::ApiRegisterCache(&entry);
+    XPF_TEST_EXPECT_TRUE(entry.IsRegistered);
+
+    //
+    // Registering twice is fine.
+    //
+    xpf::ApiRegisterCache(&entry);
+
+    cache.CachedBytes = 100;
+    XPF_TEST_EXPECT_TRUE(xpf::ApiCachedBytes() >= 100);
+    XPF_TEST_EXPECT_TRUE(xpf::ApiTrimCaches(xpf::CacheTrimLevel::Full) >= 100);
+    XPF_TEST_EXPECT_TRUE(1 == cache.TrimCalls);
+    XPF_TEST_EXPECT_TRUE(xpf::CacheTrimLevel::Full == cache.LastLevel);
+
+    xpf::ApiUnregisterCache(&entry);
+    XPF_TEST_EXPECT_TRUE(!entry.IsRegistered);
+
+    //
+    // Unregistered caches are not trimmed anymore. Unregistering twice is fine.
+    //
+    (void) xpf::ApiTrimCaches(xpf::CacheTrimLevel::Idle);
+    XPF_TEST_EXPECT_TRUE(1 == cache.TrimCalls);
+    xpf::ApiUnregisterCache(&entry);
+    xpf::ApiUnregisterCache(nullptr);
+}
+
+/**
+ * @brief       This tests that ApiTrimCaches reaches the lookaside lists.
+ */
+XPF_TEST_SCENARIO(TestCacheRegistry, TrimLookasideList)
+{
+    xpf::LookasideListAllocator allocator(64, false, true);
+    allocator.JoinCacheRegistry();
+    allocator.JoinCacheRegistry();
+    void* blocks[10] = { nullptr };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(64);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 10);
+    XPF_TEST_EXPECT_TRUE(xpf::ApiCachedBytes() >= 10 * 64);
+
+    //
+    // The first idle trim only starts the interval.
+    //
+    (void) xpf::ApiTrimCaches(xpf::CacheTrimLevel::Idle);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 10);
+
+    XPF_TEST_EXPECT_TRUE(xpf::ApiTrimCaches(xpf::CacheTrimLevel::Full) >= 10 * 64);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 0);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().TrimmedBlocks == 10);
+}
+
+/**
+ * @brief       This tests that a lookaside list which did not join the registry is left alone.
+ */
+XPF_TEST_SCENARIO(TestCacheRegistry, LookasideListNotJoined)
+{
+    xpf::LookasideListAllocator allocator(64, false);
+
+    void* block = allocator.AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    allocator.FreeMemory(block);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 1);
+
+    (void) xpf::ApiTrimCaches(xpf::CacheTrimLevel::Full);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 1);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().TrimmedBlocks == 0);
+}
+
+/**
+ * @brief       This tests that an object pool can join the registry through its lookaside list.
+ */
+XPF_TEST_SCENARIO(TestCacheRegistry, TrimObjectPool)
+{
+    xpf::ObjectPool<uint64_t> pool;
+    pool.JoinCacheRegistry();
+    uint64_t* objects[10] = { nullptr };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(objects); ++i)
+    {
+        objects[i] = pool.Acquire(uint64_t{ i });
+        XPF_TEST_EXPECT_TRUE(nullptr != objects[i]);
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(objects); ++i)
+    {
+        pool.Release(objects[i]);
+        objects[i] = nullptr;
+    }
+    XPF_TEST_EXPECT_TRUE(pool.GetStatistics().CurrentDepth == 10);
+
+    XPF_TEST_EXPECT_TRUE(xpf::ApiTrimCaches(xpf::CacheTrimLevel::Full) >= 10 * sizeof(uint64_t));
+    XPF_TEST_EXPECT_TRUE(pool.GetStatistics().CurrentDepth == 0);
+    XPF_TEST_EXPECT_TRUE(pool.GetStatistics().TrimmedBlocks == 10);
+}
+
+/**
+ * @brief       This tests that ApiTrimCaches reaches the slab allocator.
+ */
+XPF_TEST_SCENARIO(TestCacheRegistry, TrimSlabAllocator)
+{
+    void* block = xpf::SlabAllocator::AllocateMemory(48);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    XPF_TEST_EXPECT_TRUE(xpf::ApiCachedBytes() > 0);
+
+    xpf::SlabAllocator::FreeMemory(block);
+    XPF_TEST_EXPECT_TRUE(xpf::ApiTrimCaches(xpf::CacheTrimLevel::Idle) > 0);
+    XPF_TEST_EXPECT_TRUE(0 == xpf::SlabAllocator::ReleaseUnusedSlabs());
+}
+
+/**
+ * @brief       This tests that the cache trimmer trims everything when over budget.
+ */
+XPF_TEST_SCENARIO(TestCacheRegistry, CacheTrimmer)
+{
+    xpf::Optional<xpf::CacheTrimmer> trimmer;
+    XPF_TEST_EXPECT_TRUE(!NT_SUCCESS(xpf::CacheTrimmer::Create(&trimmer, 1, 0)));
+    XPF_TEST_EXPECT_TRUE(!trimmer.HasValue());
+
+    MockCache cache;
+    xpf::CacheRegistryEntry entry;
+    entry.Context = &cache;
+    entry.TrimFunction = &MockCacheTrim;
+    entry.SizeFunction = &MockCacheSize;
+
+    cache.CachedBytes = 100;
+    xpf::ApiRegisterCache(&entry);
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::CacheTrimmer::Create(&trimmer, 1, 10)));
+    XPF_TEST_EXPECT_TRUE(trimmer.HasValue());
+
+    for (size_t i = 0; i < 500; ++i)
+    {
+        if ((*trimmer).Passes() >= 2)
+        {
+            break;
+        }
+        xpf::ApiSleep(10);
+    }
+    (*trimmer).Stop();
+    (*trimmer).Stop();
+
+    XPF_TEST_EXPECT_TRUE((*trimmer).Passes() >= 2);
+    XPF_TEST_EXPECT_TRUE((*trimmer).FullTrims() >= 1);
+    XPF_TEST_EXPECT_TRUE(0 == cache.CachedBytes);
+    XPF_TEST_EXPECT_TRUE(cache.TrimCalls >= 2);
+
+    xpf::ApiUnregisterCache(&entry);
+}
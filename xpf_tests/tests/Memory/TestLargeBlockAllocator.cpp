@@ -0,0 +1,148 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestLargeBlockAllocator.cpp
+ *
+ * @brief       This contains tests for the large block allocator.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       This tests the page allocation routines.
+ */
+XPF_TEST_SCENARIO(TestLargeBlockAllocator, AllocateAndFreePages)
+{
+    const size_t sizes[] = { 0, 1, 4096, 100000, size_t{ 5 } * 1024 * 1024 };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(sizes); ++i)
+    {
+        uint8_t* block = static_cast<uint8_t*>(xpf::ApiAllocatePages(sizes[i], true));
+        XPF_TEST_EXPECT_TRUE(nullptr != block);
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(block),
+                                                      decltype(xpf::AlgoPointerToValue(block)){ 4096 }));
+
+        //
+        // The pages are zeroed and writeable - touch the first and the last byte.
+        //
+        if (sizes[i] != 0)
+        {
+            XPF_TEST_EXPECT_TRUE(0 == block[0]);
+            XPF_TEST_EXPECT_TRUE(0 == block[sizes[i] - 1]);
+            block[0] = 0xAB;
+            block[sizes[i] - 1] = 0xAB;
+        }
+
+        xpf::ApiFreePages(block, sizes[i]);
+        block = nullptr;
+    }
+
+    xpf::ApiFreePages(nullptr, 0);
+}
+
+/**
+ * @brief       This tests both the small and the large paths of the allocator.
+ */
+XPF_TEST_SCENARIO(TestLargeBlockAllocator, AllocateAndFree)
+{
+    using Allocator = xpf::LargeBlockAllocator<65536>;
+
+    const size_t sizes[] = { 0, 10, 65535, 65536, 1000000 };
+    for (size_t i = 0; i < XPF_ARRAYSIZE(sizes); ++i)
+    {
+        uint8_t* block = static_cast<uint8_t*>(Allocator::AllocateMemory(sizes[i]));
+        XPF_TEST_EXPECT_TRUE(nullptr != block);
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(block),
+                                                      decltype(xpf::AlgoPointerToValue(block)){ XPF_DEFAULT_ALIGNMENT }));
+
+        bool allZero = true;
+        for (size_t j = 0; j < sizes[i]; ++j)
+        {
+            allZero = allZero && (0 == block[j]);
+            block[j] = 0xAB;
+        }
+        XPF_TEST_EXPECT_TRUE(allZero);
+
+        Allocator::FreeMemory(block);
+        block = nullptr;
+    }
+
+    Allocator::FreeMemory(nullptr);
+    XPF_TEST_EXPECT_TRUE(nullptr == Allocator::AllocateMemory(xpf::NumericLimits<size_t>::MaxValue()));
+}
+
+/**
+ * @brief       This tests that the big blocks carry no header - a huge page request maps exactly
+ *              one huge page, and the block is the start of the mapping.
+ */
+XPF_TEST_SCENARIO(TestLargeBlockAllocator, BigBlocksHaveNoHeader)
+{
+    const size_t hugePageSize = size_t{ 2 } * 1024 * 1024;
+
+    uint8_t* block = static_cast<uint8_t*>(xpf::LargeBlockAllocator<>::AllocateMemory(hugePageSize));
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(block),
+                                                  decltype(xpf::AlgoPointerToValue(block)){ 4096 }));
+    #if defined XPF_PLATFORM_LINUX_UM
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(block),
+                                                      decltype(xpf::AlgoPointerToValue(block)){ hugePageSize }));
+    #endif  // XPF_PLATFORM_LINUX_UM
+
+    block[0] = 0xAB;
+    block[hugePageSize - 1] = 0xAB;
+
+    //
+    // A page aligned block which is not in the side table is left alone.
+    //
+    void* pages = xpf::ApiAllocatePages(4096, false);
+    XPF_TEST_EXPECT_TRUE(nullptr != pages);
+    XPF_TEST_EXPECT_TRUE(!xpf::ApiFreeLargeBlock(pages));
+    XPF_TEST_EXPECT_TRUE(!xpf::ApiFreeLargeBlock(nullptr));
+    xpf::ApiFreePages(pages, 4096);
+
+    xpf::LargeBlockAllocator<>::FreeMemory(block);
+    block = nullptr;
+}
+
+/**
+ * @brief       This tests the allocator plugged in a buffer, which grows and shrinks
+ *              across the threshold.
+ */
+XPF_TEST_SCENARIO(TestLargeBlockAllocator, BufferResize)
+{
+    xpf::Buffer buffer{ XPF_LARGE_BLOCK_ALLOCATOR };
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(buffer.Resize(100)));
+    static_cast<uint8_t*>(buffer.GetBuffer())[99] = 0xAB;
+
+    //
+    // Grow above the threshold - the content must be preserved.
+    //
+    const size_t largeSize = size_t{ 8 } * 1024 * 1024;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(buffer.Resize(largeSize)));
+    XPF_TEST_EXPECT_TRUE(buffer.GetSize() == largeSize);
+
+    uint8_t* bytes = static_cast<uint8_t*>(buffer.GetBuffer());
+    XPF_TEST_EXPECT_TRUE(0xAB == bytes[99]);
+    XPF_TEST_EXPECT_TRUE(0 == bytes[largeSize - 1]);
+
+    for (size_t i = 0; i < largeSize; i += 4096)
+    {
+        bytes[i] = static_cast<uint8_t>(i / 4096);
+    }
+
+    //
+    // And shrink back below it.
+    //
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(buffer.Resize(8192)));
+    bytes = static_cast<uint8_t*>(buffer.GetBuffer());
+    XPF_TEST_EXPECT_TRUE(0 == bytes[0]);
+    XPF_TEST_EXPECT_TRUE(1 == bytes[4096]);
+
+    buffer.Clear();
+}
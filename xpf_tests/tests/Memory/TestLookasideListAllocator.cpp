@@ -28,6 +28,11 @@ struct MockLookasideStressContext
      * @brief The block size to allocate.
      */
     size_t BlockSize = 0;
+
+    /**
+     * @brief How many blocks are kept alive at once by the batch callback.
+     */
+    size_t HeldBlocks = 64;
 };
 
 /**
@@ -54,6 +59,81 @@ MockLookasideStressCallback(
     }
 }
 
+/**
+ * @brief       This is a mock callback used for stress testing the per-cpu cache.
+ *              It keeps a couple of blocks alive at once, so the magazines
+ *              are both refilled from and spilled to the shared queue.
+ *
+ * @param[in] Context - A pointer to a MockLookasideStressContext.
+ */
+static void XPF_API
+MockLookasideBatchStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto mockContext = static_cast<MockLookasideStressContext*>(Context);
+    if (nullptr != mockContext && nullptr != mockContext->Allocator)
+    {
+        void* blocks[64] = { nullptr };
+        const size_t heldBlocks = (mockContext->HeldBlocks < XPF_ARRAYSIZE(blocks)) ? mockContext->HeldBlocks
+                                                                                    : XPF_ARRAYSIZE(blocks);
+
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            for (size_t j = 0; j < heldBlocks; ++j)
+            {
+                blocks[j] = mockContext->Allocator->AllocateMemory(mockContext->BlockSize);
+            }
+            for (size_t j = 0; j < heldBlocks; ++j)
+            {
+                if (nullptr != blocks[j])
+                {
+                    mockContext->Allocator->FreeMemory(blocks[j]);
+                    blocks[j] = nullptr;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief       Runs the batch stress callback on a number of threads.
+ *
+ * @param[in] Allocator - The allocator to be stressed.
+ *
+ * @param[in] NumberOfThreads - How many threads to use. At most 8.
+ *
+ * @param[in] HeldBlocks - How many blocks each thread keeps alive at once.
+ *
+ * @return The elapsed time, in 100 ns units.
+ */
+static uint64_t XPF_API
+MockLookasideRunBatchStress(
+    _In_ xpf::LookasideListAllocator* Allocator,
+    _In_ size_t NumberOfThreads,
+    _In_ size_t HeldBlocks
+) noexcept(true)
+{
+    MockLookasideStressContext context;
+    context.Allocator = Allocator;
+    context.BlockSize = 64;
+    context.HeldBlocks = HeldBlocks;
+
+    xpf::thread::Thread threads[8];
+    XPF_DEATH_ON_FAILURE(NumberOfThreads <= XPF_ARRAYSIZE(threads));
+
+    const uint64_t startTime = xpf::ApiCurrentTime();
+    for (size_t i = 0; i < NumberOfThreads; ++i)
+    {
+        XPF_DEATH_ON_FAILURE(NT_SUCCESS(threads[i].Run(MockLookasideBatchStressCallback, &context)));
+    }
+    for (size_t i = 0; i < NumberOfThreads; ++i)
+    {
+        threads[i].Join();
+    }
+    return xpf::ApiCurrentTime() - startTime;
+}
+
 /**
  * @brief       This tests the default constructor and destructor of LookasideListAllocator.
  */
@@ -249,3 +329,349 @@ XPF_TEST_SCENARIO(TestLookasideListAllocator, SmallElementSizeClamped)
 
     allocator.FreeMemory(block);
 }
+
+/**
+ * @brief       This tests basic allocate and free operations with the per-cpu cache enabled.
+ *              Enough blocks are used to go through both refill and spill paths.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, PerCpuCacheAllocateAndFree)
+{
+    xpf::LookasideListAllocator allocator(128, false, true);
+    void* blocks[200] = { nullptr };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(128);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+
+        for (size_t j = 0; j < 128; ++j)
+        {
+            static_cast<uint8_t*>(blocks[i])[j] = 0xAB;
+        }
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+
+    //
+    // The blocks are now reused - either from the magazine or from the shared queue.
+    // Either way, they must be zero-filled.
+    //
+    bool allZero = true;
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(128);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(blocks[i]);
+        for (size_t j = 0; j < 128; ++j)
+        {
+            allZero = allZero && (bytes[j] == 0);
+        }
+    }
+    XPF_TEST_EXPECT_TRUE(allZero);
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+
+    //
+    // Requests bigger than the element size still fail.
+    //
+    XPF_TEST_EXPECT_TRUE(nullptr == allocator.AllocateMemory(129));
+}
+
+/**
+ * @brief       This tests that the per-cpu cache is silently skipped when
+ *              the elements are too big to be worth caching per processor.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, PerCpuCacheHugeElements)
+{
+    xpf::LookasideListAllocator allocator(size_t{ 1048576 * 10 }, true, true);
+
+    void* block = allocator.AllocateMemory(1048576);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+
+    allocator.FreeMemory(block);
+}
+
+/**
+ * @brief       This tests the per-cpu cache under multithreaded stress.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, PerCpuCacheStress)
+{
+    xpf::LookasideListAllocator allocator(64, true, true);
+    (void) MockLookasideRunBatchStress(&allocator, 8, 64);
+}
+
+/**
+ * @brief       This tests the lock-free stack as shared store. The blocks are returned in LIFO order.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, LockFreeStackAllocateAndFree)
+{
+    xpf::LookasideListAllocator allocator(64, false, false, true);
+
+    void* first = allocator.AllocateMemory(64);
+    void* second = allocator.AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(nullptr != first);
+    XPF_TEST_EXPECT_TRUE(nullptr != second);
+
+    static_cast<uint8_t*>(first)[10] = 0xAB;
+    allocator.FreeMemory(first);
+    allocator.FreeMemory(second);
+
+    //
+    // The most recently freed block comes back first - and it is zeroed.
+    //
+    void* reusedSecond = allocator.AllocateMemory(64);
+    void* reusedFirst = allocator.AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(reusedSecond == second);
+    XPF_TEST_EXPECT_TRUE(reusedFirst == first);
+    XPF_TEST_EXPECT_TRUE(0 == static_cast<uint8_t*>(reusedFirst)[10]);
+
+    allocator.FreeMemory(reusedFirst);
+    allocator.FreeMemory(reusedSecond);
+}
+
+/**
+ * @brief       This tests the lock-free stack as shared store under multithreaded stress,
+ *              both alone and behind the per-cpu cache.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, LockFreeStackStress)
+{
+    xpf::LookasideListAllocator allocator(64, true, false, true);
+    (void) MockLookasideRunBatchStress(&allocator, 8, 64);
+
+    xpf::LookasideListAllocator cachedAllocator(64, true, true, true);
+    (void) MockLookasideRunBatchStress(&cachedAllocator, 8, 64);
+}
+
+/**
+ * @brief       This compares the shared queue, the per-cpu cache and the lock-free stack for 1 to 8 threads.
+ *              The timings are only logged - they depend too much on the machine to be asserted.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, PerCpuCacheScaling)
+{
+    const size_t threadCounts[] = { 1, 2, 4, 8 };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threadCounts); ++i)
+    {
+        xpf::LookasideListAllocator sharedAllocator(64, true, false);
+        xpf::LookasideListAllocator cachedAllocator(64, true, true);
+        xpf::LookasideListAllocator stackAllocator(64, true, false, true);
+
+        const uint64_t sharedTime = MockLookasideRunBatchStress(&sharedAllocator, threadCounts[i], 8);
+        const uint64_t cachedTime = MockLookasideRunBatchStress(&cachedAllocator, threadCounts[i], 8);
+        const uint64_t stackTime = MockLookasideRunBatchStress(&stackAllocator, threadCounts[i], 8);
+
+        xpf_test::LogTestInfo("    > %llu threads: shared queue %llu (100 ns), per-cpu cache %llu (100 ns), "
+                              "lock-free stack %llu (100 ns) \r\n",
+                              static_cast<unsigned long long>(threadCounts[i]),                                 // NOLINT(*)
+                              static_cast<unsigned long long>(sharedTime),                                      // NOLINT(*)
+                              static_cast<unsigned long long>(cachedTime),                                      // NOLINT(*)
+                              static_cast<unsigned long long>(stackTime));                                      // NOLINT(*)
+    }
+}
+
+/**
+ * @brief       This tests the hit, miss and high-water statistics.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, Statistics)
+{
+    xpf::LookasideListAllocator allocator(64, false);
+    void* blocks[10] = { nullptr };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(64);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+    for (size_t i = 0; i < 4; ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(64);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+    }
+
+    xpf::LookasideListStatistics statistics = allocator.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(statistics.Misses == 10);
+    XPF_TEST_EXPECT_TRUE(statistics.Hits == 4);
+    XPF_TEST_EXPECT_TRUE(statistics.CurrentDepth == 6);
+    XPF_TEST_EXPECT_TRUE(statistics.HighWaterDepth == 10);
+    XPF_TEST_EXPECT_TRUE(statistics.TrimmedBlocks == 0);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+}
+
+/**
+ * @brief       This tests that the zeroing of reused blocks can be turned off.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, ZeroOnReuseOptOut)
+{
+    xpf::LookasideListAllocator allocator(64, false);
+    allocator.SetZeroOnReuse(false);
+
+    uint8_t* block = static_cast<uint8_t*>(allocator.AllocateMemory(64));
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+
+    //
+    // The first bytes hold the list entry while the block is cached, so check the last one.
+    //
+    block[63] = 0xAB;
+    allocator.FreeMemory(block);
+
+    uint8_t* reusedBlock = static_cast<uint8_t*>(allocator.AllocateMemory(64));
+    XPF_TEST_EXPECT_TRUE(reusedBlock == block);
+    XPF_TEST_EXPECT_TRUE(0xAB == reusedBlock[63]);
+
+    allocator.FreeMemory(reusedBlock);
+}
+
+/**
+ * @brief       This tests that a configured max depth is respected.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, MaxDepth)
+{
+    xpf::LookasideListAllocator allocator(64, false);
+    allocator.SetMaxDepth(3);
+
+    void* blocks[10] = { nullptr };
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(64);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+
+    xpf::LookasideListStatistics statistics = allocator.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(statistics.MaxDepth == 3);
+    XPF_TEST_EXPECT_TRUE(statistics.CurrentDepth == 3);
+
+    //
+    // Lowering the depth releases the extra blocks on the next trim.
+    //
+    allocator.SetMaxDepth(1);
+    XPF_TEST_EXPECT_TRUE(2 == allocator.Trim());
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 1);
+}
+
+/**
+ * @brief       This tests that Trim() releases only the blocks which stayed idle.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, TrimIdleBlocks)
+{
+    xpf::LookasideListAllocator allocator(64, false);
+    void* blocks[10] = { nullptr };
+
+    //
+    // A burst of 10 blocks.
+    //
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(64);
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+
+    //
+    // The first trim only starts the interval.
+    //
+    XPF_TEST_EXPECT_TRUE(0 == allocator.Trim());
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 10);
+
+    //
+    // Now the demand is 4 blocks - so 6 stayed idle.
+    //
+    for (size_t i = 0; i < 4; ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(64);
+    }
+    for (size_t i = 0; i < 4; ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+    XPF_TEST_EXPECT_TRUE(6 == allocator.Trim());
+
+    //
+    // No demand at all - everything is released.
+    //
+    XPF_TEST_EXPECT_TRUE(4 == allocator.Trim());
+
+    xpf::LookasideListStatistics statistics = allocator.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(statistics.CurrentDepth == 0);
+    XPF_TEST_EXPECT_TRUE(statistics.TrimmedBlocks == 10);
+}
+
+/**
+ * @brief       This tests Trim() on the per-cpu magazines, while other threads use the allocator.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, PerCpuCacheTrim)
+{
+    xpf::LookasideListAllocator allocator(64, true, true);
+
+    (void) MockLookasideRunBatchStress(&allocator, 4, 16);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth > 0);
+
+    (void) allocator.Trim();
+    (void) allocator.Trim();
+
+    xpf::LookasideListStatistics statistics = allocator.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(statistics.CurrentDepth == 0);
+    XPF_TEST_EXPECT_TRUE(statistics.Hits + statistics.Misses == 4 * 1000 * 16);
+}
+
+/**
+ * @brief       This tests Trim() and SetMaxDepth() on the lock-free stack, while other threads use the allocator.
+ *              The trimmed blocks might still be read by a concurrent Pop, so they must not be freed right away.
+ */
+XPF_TEST_SCENARIO(TestLookasideListAllocator, LockFreeStackConcurrentTrim)
+{
+    xpf::LookasideListAllocator allocator(64, true, true, true);
+
+    MockLookasideStressContext context;
+    context.Allocator = &allocator;
+    context.BlockSize = 64;
+    context.HeldBlocks = 16;
+
+    xpf::thread::Thread threads[4];
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockLookasideBatchStressCallback, &context)));
+    }
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        allocator.SetMaxDepth((i % 2 == 0) ? 8 : 1024);
+        (void) allocator.Trim((i % 4 == 0) ? xpf::CacheTrimLevel::Full
+                                           : xpf::CacheTrimLevel::Idle);
+        xpf::ApiYieldProcesor();
+    }
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    (void) allocator.Trim(xpf::CacheTrimLevel::Full);
+    XPF_TEST_EXPECT_TRUE(allocator.GetStatistics().CurrentDepth == 0);
+}
@@ -15,6 +15,59 @@
 #include "xpf_tests/XPF-TestIncludes.hpp"
 #include "xpf_tests/Mocks/TestMocks.hpp"
 
+/**
+ * @brief       This is a mock context for a stateful polymorphic allocator.
+ *              It counts the allocations and frees routed through it.
+ */
+struct MockCountingAllocatorContext
+{
+    /**
+     * @brief How many allocations were performed.
+     */
+    size_t Allocations = 0;
+
+    /**
+     * @brief How many frees were performed.
+     */
+    size_t Frees = 0;
+};
+
+/**
+ * @brief       Mock stateful allocation function.
+ *
+ * @param[in] Context - A MockCountingAllocatorContext.
+ *
+ * @param[in] BlockSize - The requested size.
+ *
+ * @return A block of memory, or null on failure.
+ */
+static void*
+MockCountingAllocate(
+    _In_ void* Context,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    static_cast<MockCountingAllocatorContext*>(Context)->Allocations++;
+    return xpf::MemoryAllocator::AllocateMemory(BlockSize);
+}
+
+/**
+ * @brief       Mock stateful free function.
+ *
+ * @param[in] Context - A MockCountingAllocatorContext.
+ *
+ * @param[in,out] MemoryBlock - To be freed.
+ */
+static void
+MockCountingFree(
+    _In_ void* Context,
+    _Inout_ void* MemoryBlock
+) noexcept(true)
+{
+    static_cast<MockCountingAllocatorContext*>(Context)->Frees++;
+    xpf::MemoryAllocator::FreeMemory(MemoryBlock);
+}
+
 
 
 /**
@@ -54,3 +107,121 @@ XPF_TEST_SCENARIO(TestMemoryAllocator, NonTriviallyDestructibleObject)
     xpf::MemoryAllocator::FreeMemory(baseObject);
     baseObject = nullptr;
 }
+
+/**
+ * @brief       This tests that the default polymorphic allocator is stateless and valid.
+ */
+XPF_TEST_SCENARIO(TestMemoryAllocator, PolymorphicAllocatorStateless)
+{
+    xpf::PolymorphicAllocator allocator;
+    XPF_TEST_EXPECT_TRUE(allocator.IsValid());
+    XPF_TEST_EXPECT_TRUE(nullptr == allocator.Context);
+
+    void* block = allocator.AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    allocator.FreeMemory(block);
+
+    //
+    // Only one of the context functions set - the allocator is not valid.
+    //
+    xpf::PolymorphicAllocator invalidAllocator{ .ContextAllocFunction = &MockCountingAllocate };
+    XPF_TEST_EXPECT_TRUE(!invalidAllocator.IsValid());
+}
+
+/**
+ * @brief       This tests that a stateful polymorphic allocator receives its context,
+ *              including when it is used by containers.
+ */
+XPF_TEST_SCENARIO(TestMemoryAllocator, PolymorphicAllocatorStateful)
+{
+    MockCountingAllocatorContext context;
+    xpf::PolymorphicAllocator allocator{ .Context              = &context,
+                                         .ContextAllocFunction = &MockCountingAllocate,
+                                         .ContextFreeFunction  = &MockCountingFree };
+    XPF_TEST_EXPECT_TRUE(allocator.IsValid());
+
+    void* block = allocator.AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    allocator.FreeMemory(block);
+
+    XPF_TEST_EXPECT_TRUE(context.Allocations == 1);
+    XPF_TEST_EXPECT_TRUE(context.Frees == 1);
+
+    {
+        xpf::Vector<int> vector{ allocator };
+        for (int i = 0; i < 100; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+        }
+    }
+    XPF_TEST_EXPECT_TRUE(context.Allocations > 1);
+    XPF_TEST_EXPECT_TRUE(context.Allocations == context.Frees);
+}
+
+/**
+ * @brief       This tests the aligned memory allocator, both directly and through containers.
+ */
+XPF_TEST_SCENARIO(TestMemoryAllocator, AlignedMemoryAllocator)
+{
+    void* block = xpf::AlignedMemoryAllocator<256, true>::AllocateMemory(10);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(block),
+                                                  decltype(xpf::AlgoPointerToValue(block)){ 256 }));
+    xpf::AlignedMemoryAllocator<256, true>::FreeMemory(block);
+
+    xpf::PolymorphicAllocator allocator = xpf::CacheAlignedMemoryAllocator::GetAllocator();
+    XPF_TEST_EXPECT_TRUE(allocator.IsValid());
+
+    xpf::Vector<int> vector{ allocator };
+    for (int i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(&vector[0]),
+                                                      static_cast<decltype(xpf::AlgoPointerToValue(&vector[0]))>(
+                                                          XPF_CACHE_LINE_SIZE)));
+    }
+
+    auto sharedPointer = xpf::MakeSharedWithAllocator<uint64_t>(allocator, 100);
+    XPF_TEST_EXPECT_TRUE(!sharedPointer.IsEmpty());
+    XPF_TEST_EXPECT_TRUE((*sharedPointer) == 100);
+}
+
+/**
+ * @brief       This tests the cache aligned wrapper.
+ */
+XPF_TEST_SCENARIO(TestMemoryAllocator, CacheAligned)
+{
+    //
+    // The wrapped object must not share a cache line with its neighbours,
+    // regardless of where the wrapper starts.
+    //
+    struct MockNeighbours
+    {
+        uint8_t Before = 0;
+        xpf::CacheAligned<uint64_t> Value{ uint64_t{ 100 } };
+        uint8_t After = 0;
+    };
+    static_assert(alignof(MockNeighbours) <= XPF_DEFAULT_ALIGNMENT, "Must be usable by the containers!");
+
+    auto neighbours = xpf::MakeShared<MockNeighbours>();
+    XPF_TEST_EXPECT_TRUE(!neighbours.IsEmpty());
+
+    const auto valueLine = xpf::AlgoPointerToValue(&(*neighbours).Value.Get()) / XPF_CACHE_LINE_SIZE;
+    const auto beforeLine = xpf::AlgoPointerToValue(&(*neighbours).Before) / XPF_CACHE_LINE_SIZE;
+    const auto afterLine = xpf::AlgoPointerToValue(&(*neighbours).After) / XPF_CACHE_LINE_SIZE;
+    XPF_TEST_EXPECT_TRUE(valueLine != beforeLine);
+    XPF_TEST_EXPECT_TRUE(valueLine != afterLine);
+
+    //
+    // And it can be used as the wrapped object.
+    //
+    XPF_TEST_EXPECT_TRUE((*neighbours).Value.Get() == 100);
+    uint64_t& reference = (*neighbours).Value;
+    reference = 200;
+    XPF_TEST_EXPECT_TRUE((*neighbours).Value.Get() == 200);
+
+    xpf::CacheAligned<xpf::BusyLock> lock;
+    {
+        xpf::ExclusiveLockGuard guard{ lock };
+    }
+}
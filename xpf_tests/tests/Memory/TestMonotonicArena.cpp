@@ -0,0 +1,178 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestMonotonicArena.cpp
+ *
+ * @brief       This contains tests for the monotonic arena.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       This is a mock callback used for stress testing the monotonic arena.
+ *
+ * @param[in] Context - A pointer to a MonotonicArena.
+ */
+static void XPF_API
+MockMonotonicArenaStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto arena = static_cast<xpf::MonotonicArena*>(Context);
+    if (nullptr != arena)
+    {
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            uint8_t* block = static_cast<uint8_t*>(arena->AllocateMemory(i % 100 + 1));
+            if (nullptr != block)
+            {
+                block[i % 100] = 0xAB;
+            }
+        }
+    }
+}
+
+/**
+ * @brief       This tests the default constructor and destructor of MonotonicArena.
+ */
+XPF_TEST_SCENARIO(TestMonotonicArena, DefaultConstructorDestructor)
+{
+    xpf::MonotonicArena arena;
+    XPF_TEST_EXPECT_TRUE(0 == arena.UsedBytes());
+}
+
+/**
+ * @brief       This tests that allocations are aligned, zeroed and sequential.
+ */
+XPF_TEST_SCENARIO(TestMonotonicArena, AllocateAndFree)
+{
+    xpf::MonotonicArena arena(1024);
+
+    uint8_t* first = static_cast<uint8_t*>(arena.AllocateMemory(10));
+    uint8_t* second = static_cast<uint8_t*>(arena.AllocateMemory(0));
+    uint8_t* third = static_cast<uint8_t*>(arena.AllocateMemory(100));
+
+    XPF_TEST_EXPECT_TRUE(nullptr != first);
+    XPF_TEST_EXPECT_TRUE(nullptr != second);
+    XPF_TEST_EXPECT_TRUE(nullptr != third);
+
+    //
+    // Bumped from the same chunk, each block rounded up to the default alignment.
+    //
+    XPF_TEST_EXPECT_TRUE(second == first + XPF_DEFAULT_ALIGNMENT);
+    XPF_TEST_EXPECT_TRUE(third == second + XPF_DEFAULT_ALIGNMENT);
+    XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(third),
+                                                  decltype(xpf::AlgoPointerToValue(third)){ XPF_DEFAULT_ALIGNMENT }));
+
+    bool allZero = true;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        allZero = allZero && (third[i] == 0);
+    }
+    XPF_TEST_EXPECT_TRUE(allZero);
+
+    //
+    // Free is a no-op.
+    //
+    arena.FreeMemory(first);
+    arena.FreeMemory(nullptr);
+    XPF_TEST_EXPECT_TRUE(arena.UsedBytes() == 2 * XPF_DEFAULT_ALIGNMENT + 112);
+
+    arena.Release();
+    XPF_TEST_EXPECT_TRUE(0 == arena.UsedBytes());
+}
+
+/**
+ * @brief       This tests that requests bigger than a chunk get their own chunk,
+ *              and that the room left in the current chunk is still used after.
+ */
+XPF_TEST_SCENARIO(TestMonotonicArena, LargeAllocations)
+{
+    xpf::MonotonicArena arena(1024);
+
+    uint8_t* small = static_cast<uint8_t*>(arena.AllocateMemory(16));
+    XPF_TEST_EXPECT_TRUE(nullptr != small);
+
+    uint8_t* large = static_cast<uint8_t*>(arena.AllocateMemory(100000));
+    XPF_TEST_EXPECT_TRUE(nullptr != large);
+    large[99999] = 0xAB;
+
+    uint8_t* afterLarge = static_cast<uint8_t*>(arena.AllocateMemory(16));
+    XPF_TEST_EXPECT_TRUE(afterLarge == small + 16);
+
+    //
+    // Fill the chunk so a new one is needed.
+    //
+    for (size_t i = 0; i < 100; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(nullptr != arena.AllocateMemory(100));
+    }
+}
+
+/**
+ * @brief       This tests the arena plugged in containers via a stateful polymorphic allocator.
+ */
+XPF_TEST_SCENARIO(TestMonotonicArena, PolymorphicAllocator)
+{
+    xpf::MonotonicArena arena;
+
+    {
+        xpf::Vector<uint32_t> vector{ arena.GetAllocator() };
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+        }
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(vector[i] == i);
+        }
+
+        xpf::String<char> string{ arena.GetAllocator() };
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(string.Append("Hello ")));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(string.Append("arena!")));
+        XPF_TEST_EXPECT_TRUE(string.View().Equals("Hello arena!", true));
+
+        xpf::Map<uint32_t, uint32_t> map{ arena.GetAllocator() };
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            uint32_t key = i;
+            uint32_t value = i * 2;
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(map.Emplace(xpf::Move(key), xpf::Move(value))));
+        }
+        XPF_TEST_EXPECT_TRUE(map.Size() == 100);
+
+        auto sharedPointer = xpf::MakeSharedWithAllocator<uint64_t>(arena.GetAllocator(), 100);
+        XPF_TEST_EXPECT_TRUE(!sharedPointer.IsEmpty());
+        XPF_TEST_EXPECT_TRUE((*sharedPointer) == 100);
+    }
+
+    XPF_TEST_EXPECT_TRUE(arena.UsedBytes() > 0);
+    arena.Release();
+    XPF_TEST_EXPECT_TRUE(arena.UsedBytes() == 0);
+}
+
+/**
+ * @brief       This tests the arena under multithreaded stress.
+ */
+XPF_TEST_SCENARIO(TestMonotonicArena, StressAllocate)
+{
+    xpf::MonotonicArena arena(4096);
+    xpf::thread::Thread threads[8];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockMonotonicArenaStressCallback, &arena)));
+    }
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    XPF_TEST_EXPECT_TRUE(arena.UsedBytes() > 0);
+}
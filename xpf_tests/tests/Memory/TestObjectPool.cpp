@@ -0,0 +1,325 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestObjectPool.cpp
+ *
+ * @brief       This contains tests for the object pool.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       Counts how many MockPoolObject were constructed.
+ */
+static volatile uint32_t gMockPoolConstructed = 0;
+
+/**
+ * @brief       Counts how many MockPoolObject were destroyed.
+ */
+static volatile uint32_t gMockPoolDestroyed = 0;
+
+/**
+ * @brief       Counts how many times the reset hook was called.
+ */
+static volatile uint32_t gMockPoolResets = 0;
+
+/**
+ * @brief       This is a mock object for the pool. It counts its constructions and destructions.
+ */
+class MockPoolObject
+{
+ public:
+/**
+ * @brief Constructor.
+ *
+ * @param[in] Value - The initial value.
+ */
+MockPoolObject(
+    _In_ uint64_t Value = 0
+) noexcept(true) : m_Value{ Value }
+{
+    xpf::ApiAtomicIncrement(&gMockPoolConstructed);
+}
+
+/**
+ * @brief Destructor.
+ */
+~MockPoolObject(
+    void
+) noexcept(true)
+{
+    xpf::ApiAtomicIncrement(&gMockPoolDestroyed);
+}
+
+/**
+ * @brief Copy and move semantics are deleted.
+ */
+XPF_CLASS_COPY_MOVE_BEHAVIOR(MockPoolObject, delete);
+
+/**
+ * @brief A dummy value.
+ */
+uint64_t m_Value = 0;
+};
+
+/**
+ * @brief       The reset hook used for the mock object.
+ *
+ * @param[in,out] Object - The object to be reset.
+ */
+static void
+MockPoolObjectReset(
+    _Inout_ MockPoolObject& Object
+) noexcept(true)
+{
+    Object.m_Value = 0;
+    xpf::ApiAtomicIncrement(&gMockPoolResets);
+}
+
+/**
+ * @brief       Resets the mock counters.
+ */
+static void XPF_API
+MockPoolResetCounters(
+    void
+) noexcept(true)
+{
+    gMockPoolConstructed = 0;
+    gMockPoolDestroyed = 0;
+    gMockPoolResets = 0;
+}
+
+/**
+ * @brief       This is a mock callback used for stress testing the pool.
+ *
+ * @param[in] Context - A pointer to an ObjectPool<MockPoolObject>.
+ */
+static void XPF_API
+MockPoolStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto pool = static_cast<xpf::ObjectPool<MockPoolObject>*>(Context);
+    if (nullptr != pool)
+    {
+        MockPoolObject* objects[8] = { nullptr };
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            for (size_t j = 0; j < XPF_ARRAYSIZE(objects); ++j)
+            {
+                objects[j] = pool->Acquire(uint64_t{ 100 });
+                XPF_DEATH_ON_FAILURE(nullptr != objects[j]);
+                XPF_DEATH_ON_FAILURE(objects[j]->m_Value == 0 || objects[j]->m_Value == 100);
+                objects[j]->m_Value = 100;
+            }
+            for (size_t j = 0; j < XPF_ARRAYSIZE(objects); ++j)
+            {
+                pool->Release(objects[j]);
+                objects[j] = nullptr;
+            }
+        }
+    }
+}
+
+/**
+ * @brief       This tests acquiring and releasing objects without a reset hook.
+ *              Each acquire constructs and each release destroys.
+ */
+XPF_TEST_SCENARIO(TestObjectPool, AcquireRelease)
+{
+    MockPoolResetCounters();
+    {
+        xpf::ObjectPool<MockPoolObject> pool;
+
+        MockPoolObject* object = pool.Acquire(uint64_t{ 42 });
+        XPF_TEST_EXPECT_TRUE(nullptr != object);
+        XPF_TEST_EXPECT_TRUE(42 == object->m_Value);
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(object),
+                                                      decltype(xpf::AlgoPointerToValue(object)){ XPF_DEFAULT_ALIGNMENT }));
+        pool.Release(object);
+        XPF_TEST_EXPECT_TRUE(1 == gMockPoolConstructed);
+        XPF_TEST_EXPECT_TRUE(1 == gMockPoolDestroyed);
+
+        //
+        // The block is recycled, but the object is constructed again.
+        //
+        object = pool.Acquire();
+        XPF_TEST_EXPECT_TRUE(nullptr != object);
+        XPF_TEST_EXPECT_TRUE(0 == object->m_Value);
+        XPF_TEST_EXPECT_TRUE(2 == gMockPoolConstructed);
+        XPF_TEST_EXPECT_TRUE(pool.GetStatistics().Hits >= 1);
+
+        pool.Release(object);
+        pool.Release(nullptr);
+        XPF_TEST_EXPECT_TRUE(0 == gMockPoolResets);
+    }
+    XPF_TEST_EXPECT_TRUE(gMockPoolConstructed == gMockPoolDestroyed);
+}
+
+/**
+ * @brief       This tests that with a reset hook the objects are recycled without
+ *              being destroyed and constructed again.
+ */
+XPF_TEST_SCENARIO(TestObjectPool, ResetHook)
+{
+    MockPoolResetCounters();
+    {
+        xpf::ObjectPool<MockPoolObject> pool{ MockPoolObjectReset };
+
+        MockPoolObject* object = pool.Acquire(uint64_t{ 42 });
+        XPF_TEST_EXPECT_TRUE(nullptr != object);
+        XPF_TEST_EXPECT_TRUE(42 == object->m_Value);
+        pool.Release(object);
+
+        XPF_TEST_EXPECT_TRUE(1 == gMockPoolResets);
+        XPF_TEST_EXPECT_TRUE(0 == gMockPoolDestroyed);
+
+        //
+        // The same object comes back, as the hook left it.
+        //
+        MockPoolObject* recycled = pool.Acquire(uint64_t{ 7 });
+        XPF_TEST_EXPECT_TRUE(recycled == object);
+        XPF_TEST_EXPECT_TRUE(0 == recycled->m_Value);
+        XPF_TEST_EXPECT_TRUE(1 == gMockPoolConstructed);
+
+        //
+        // The pool is empty now, so this one is constructed.
+        //
+        MockPoolObject* other = pool.Acquire(uint64_t{ 7 });
+        XPF_TEST_EXPECT_TRUE(nullptr != other);
+        XPF_TEST_EXPECT_TRUE(7 == other->m_Value);
+        XPF_TEST_EXPECT_TRUE(2 == gMockPoolConstructed);
+
+        pool.Release(recycled);
+        pool.Release(other);
+
+        //
+        // Trim destroys the constructed objects.
+        //
+        (void) pool.Trim();
+        XPF_TEST_EXPECT_TRUE(2 == gMockPoolDestroyed);
+    }
+    XPF_TEST_EXPECT_TRUE(gMockPoolConstructed == gMockPoolDestroyed);
+}
+
+/**
+ * @brief       This tests that only a limited number of objects is kept constructed,
+ *              and that the rest are destroyed by the pool destructor.
+ */
+XPF_TEST_SCENARIO(TestObjectPool, ConstructedLimit)
+{
+    constexpr uint32_t limit = xpf::ObjectPool<MockPoolObject>::OBJECT_POOL_MAX_CONSTRUCTED;
+    constexpr size_t count = limit + 100;
+
+    MockPoolResetCounters();
+    {
+        xpf::ObjectPool<MockPoolObject> pool{ MockPoolObjectReset };
+        xpf::Vector<MockPoolObject*> objects;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            MockPoolObject* object = pool.Acquire();
+            XPF_TEST_EXPECT_TRUE(nullptr != object);
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(objects.Emplace(object)));
+        }
+        for (size_t i = 0; i < objects.Size(); ++i)
+        {
+            pool.Release(objects[i]);
+        }
+
+        XPF_TEST_EXPECT_TRUE(limit == gMockPoolResets);
+        XPF_TEST_EXPECT_TRUE(count - limit == gMockPoolDestroyed);
+    }
+    XPF_TEST_EXPECT_TRUE(count == gMockPoolConstructed);
+    XPF_TEST_EXPECT_TRUE(count == gMockPoolDestroyed);
+}
+
+/**
+ * @brief       This tests shared pointers allocated from the pool.
+ */
+XPF_TEST_SCENARIO(TestObjectPool, MakePooledShared)
+{
+    MockPoolResetCounters();
+    {
+        xpf::ObjectPool<MockPoolObject> pool;
+
+        for (uint64_t i = 0; i < 10; ++i)
+        {
+            xpf::SharedPointer<MockPoolObject> pointer = xpf::MakePooledShared(pool, i);
+            XPF_TEST_EXPECT_TRUE(!pointer.IsEmpty());
+            XPF_TEST_EXPECT_TRUE(i == (*pointer).m_Value);
+
+            xpf::SharedPointer<MockPoolObject> copy = pointer;
+            pointer.Reset();
+            XPF_TEST_EXPECT_TRUE(!copy.IsEmpty());
+            XPF_TEST_EXPECT_TRUE(i == (*copy).m_Value);
+        }
+        XPF_TEST_EXPECT_TRUE(10 == gMockPoolConstructed);
+        XPF_TEST_EXPECT_TRUE(10 == gMockPoolDestroyed);
+
+        //
+        // Every pointer after the first one reused the same block.
+        //
+        XPF_TEST_EXPECT_TRUE(pool.GetStatistics().Hits >= 9);
+    }
+}
+
+/**
+ * @brief       This tests the pool with a reset hook used by multiple threads.
+ */
+XPF_TEST_SCENARIO(TestObjectPool, Stress)
+{
+    MockPoolResetCounters();
+    {
+        xpf::ObjectPool<MockPoolObject> pool{ MockPoolObjectReset };
+        xpf::thread::Thread threads[8];
+
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockPoolStressCallback, &pool)));
+        }
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            threads[i].Join();
+        }
+
+        //
+        // At most 8 objects per thread were alive at once, plus one per thread being released.
+        //
+        XPF_TEST_EXPECT_TRUE(gMockPoolConstructed <= 64 + 8);
+    }
+    XPF_TEST_EXPECT_TRUE(gMockPoolConstructed == gMockPoolDestroyed);
+}
+
+/**
+ * @brief       This tests Trim() while other threads acquire and release objects.
+ *              The slots of the destroyed objects might still be read by a concurrent Acquire.
+ */
+XPF_TEST_SCENARIO(TestObjectPool, ConcurrentTrim)
+{
+    MockPoolResetCounters();
+    {
+        xpf::ObjectPool<MockPoolObject> pool{ MockPoolObjectReset };
+        xpf::thread::Thread threads[4];
+
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockPoolStressCallback, &pool)));
+        }
+        for (size_t i = 0; i < 200; ++i)
+        {
+            (void) pool.Trim();
+            xpf::ApiYieldProcesor();
+        }
+        for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+        {
+            threads[i].Join();
+        }
+    }
+    XPF_TEST_EXPECT_TRUE(gMockPoolConstructed == gMockPoolDestroyed);
+}
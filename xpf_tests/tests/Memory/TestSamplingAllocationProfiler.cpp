@@ -0,0 +1,216 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestSamplingAllocationProfiler.cpp
+ *
+ * @brief       This contains tests for the sampling allocation profiler.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       This is a mock callback used for stress testing the profiler.
+ *
+ * @param[in] Context - A pointer to a SamplingAllocationProfiler.
+ */
+static void XPF_API
+MockProfilerStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto profiler = static_cast<xpf::SamplingAllocationProfiler*>(Context);
+    if (nullptr != profiler)
+    {
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            void* block = profiler->AllocateMemory(i % 100 + 1);
+            profiler->FreeMemory(block);
+        }
+    }
+}
+
+/**
+ * @brief       Allocates and frees a number of blocks through the given allocator.
+ *
+ * @param[in] Allocator - The allocator to be used.
+ *
+ * @param[in] Iterations - How many blocks to allocate.
+ *
+ * @param[in] BlockSize - The size of each block.
+ *
+ * @return The elapsed time, in 100 ns units.
+ */
+static uint64_t XPF_API
+MockProfilerAllocateBlocks(
+    _In_ const xpf::PolymorphicAllocator& Allocator,
+    _In_ size_t Iterations,
+    _In_ size_t BlockSize
+) noexcept(true)
+{
+    const uint64_t startTime = xpf::ApiCurrentTime();
+    for (size_t i = 0; i < Iterations; ++i)
+    {
+        void* block = Allocator.AllocateMemory(BlockSize);
+        XPF_DEATH_ON_FAILURE(nullptr != block);
+        Allocator.FreeMemory(block);
+    }
+    return xpf::ApiCurrentTime() - startTime;
+}
+
+/**
+ * @brief       This tests the default constructor and destructor of the profiler.
+ */
+XPF_TEST_SCENARIO(TestSamplingAllocationProfiler, DefaultConstructorDestructor)
+{
+    xpf::SamplingAllocationProfiler profiler;
+
+    const xpf::AllocationProfileStatistics statistics = profiler.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(4096 == statistics.SampleRate);
+    XPF_TEST_EXPECT_TRUE(0 == statistics.SampledAllocations);
+    XPF_TEST_EXPECT_TRUE(0 == statistics.SampledBytes);
+    XPF_TEST_EXPECT_TRUE(0 == statistics.UniqueStacks);
+    XPF_TEST_EXPECT_TRUE(0 == statistics.DroppedSamples);
+
+    xpf::String<char> report;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(profiler.Dump(report)));
+    XPF_TEST_EXPECT_TRUE(report.View().Equals("heap profile: 0: 0 [0: 0] @ heap/4096\n", true));
+}
+
+/**
+ * @brief       This tests that with a rate of 1 every allocation is recorded,
+ *              and that the samples are aggregated per call site.
+ */
+XPF_TEST_SCENARIO(TestSamplingAllocationProfiler, SampleEverything)
+{
+    xpf::SamplingAllocationProfiler profiler{ xpf::PolymorphicAllocator{}, 1 };
+    const xpf::PolymorphicAllocator allocator = profiler.GetAllocator();
+
+    void* blocks[8] = { nullptr };
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = allocator.AllocateMemory(100);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+    }
+    void* otherBlock = allocator.AllocateMemory(50);
+    XPF_TEST_EXPECT_TRUE(nullptr != otherBlock);
+
+    const xpf::AllocationProfileStatistics statistics = profiler.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(9 == statistics.SampledAllocations);
+    XPF_TEST_EXPECT_TRUE(850 == statistics.SampledBytes);
+    XPF_TEST_EXPECT_TRUE(statistics.UniqueStacks >= 2);
+    XPF_TEST_EXPECT_TRUE(statistics.UniqueStacks <= 9);
+    XPF_TEST_EXPECT_TRUE(0 == statistics.DroppedSamples);
+
+    xpf::String<char> report;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(profiler.Dump(report)));
+    XPF_TEST_EXPECT_TRUE(report.View().StartsWith("heap profile: 9: 850 [9: 850] @ heap/1\n", true));
+    XPF_TEST_EXPECT_TRUE(report.View().EndsWith("\n", true));
+
+    //
+    // Frees go straight to the backing allocator.
+    //
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        allocator.FreeMemory(blocks[i]);
+    }
+    allocator.FreeMemory(otherBlock);
+    XPF_TEST_EXPECT_TRUE(9 == profiler.GetStatistics().SampledAllocations);
+
+    profiler.Reset();
+    XPF_TEST_EXPECT_TRUE(0 == profiler.GetStatistics().SampledAllocations);
+    XPF_TEST_EXPECT_TRUE(0 == profiler.GetStatistics().UniqueStacks);
+}
+
+/**
+ * @brief       This tests that roughly one of every SampleRate allocations is sampled.
+ */
+XPF_TEST_SCENARIO(TestSamplingAllocationProfiler, SampleRate)
+{
+    xpf::SamplingAllocationProfiler profiler{ xpf::PolymorphicAllocator{}, 8 };
+
+    (void) MockProfilerAllocateBlocks(profiler.GetAllocator(), 800, 16);
+
+    //
+    // The counters are per cpu - if the thread migrated, a few samples are "lost"
+    // in the counters of the other processors.
+    //
+    const xpf::AllocationProfileStatistics statistics = profiler.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(statistics.SampledAllocations <= 100);
+    XPF_TEST_EXPECT_TRUE(statistics.SampledAllocations >= 50);
+    XPF_TEST_EXPECT_TRUE(statistics.SampledBytes == statistics.SampledAllocations * 16);
+
+    xpf::String<char> report;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(profiler.Dump(report)));
+    XPF_TEST_EXPECT_TRUE(report.View().StartsWith("heap profile: ", true));
+}
+
+/**
+ * @brief       This tests the profiler plugged into a container,
+ *              with the report allocated through the profiler as well.
+ */
+XPF_TEST_SCENARIO(TestSamplingAllocationProfiler, ContainerAllocator)
+{
+    xpf::SamplingAllocationProfiler profiler{ xpf::PolymorphicAllocator{}, 1 };
+    {
+        xpf::Vector<uint64_t> vector{ profiler.GetAllocator() };
+        for (uint64_t i = 0; i < 100; ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+        }
+    }
+    const uint64_t sampledAllocations = profiler.GetStatistics().SampledAllocations;
+    XPF_TEST_EXPECT_TRUE(sampledAllocations > 0);
+
+    xpf::String<char> report{ profiler.GetAllocator() };
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(profiler.Dump(report)));
+    XPF_TEST_EXPECT_TRUE(!report.IsEmpty());
+    XPF_TEST_EXPECT_TRUE(profiler.GetStatistics().SampledAllocations > sampledAllocations);
+}
+
+/**
+ * @brief       This tests the profiler used by multiple threads.
+ */
+XPF_TEST_SCENARIO(TestSamplingAllocationProfiler, Stress)
+{
+    xpf::SamplingAllocationProfiler profiler{ xpf::PolymorphicAllocator{}, 64, 16 };
+    xpf::thread::Thread threads[8];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockProfilerStressCallback, &profiler)));
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    const xpf::AllocationProfileStatistics statistics = profiler.GetStatistics();
+    XPF_TEST_EXPECT_TRUE(statistics.SampledAllocations > 0);
+    XPF_TEST_EXPECT_TRUE(statistics.SampledAllocations <= 80000 / 64);
+    XPF_TEST_EXPECT_TRUE(statistics.UniqueStacks <= 16);
+}
+
+/**
+ * @brief       This compares the cost of the default allocator with and without the profiler.
+ */
+XPF_TEST_SCENARIO(TestSamplingAllocationProfiler, OverheadBenchmark)
+{
+    constexpr size_t iterations = 1000000;
+
+    xpf::SamplingAllocationProfiler profiler{ xpf::PolymorphicAllocator{}, 4096 };
+
+    const uint64_t defaultTime = MockProfilerAllocateBlocks(xpf::PolymorphicAllocator{}, iterations, 64);
+    const uint64_t profiledTime = MockProfilerAllocateBlocks(profiler.GetAllocator(), iterations, 64);
+
+    xpf_test::LogTestInfo("    > %llu blocks: default allocator %llu (100 ns), profiled 1/4096 %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(iterations),                                          // NOLINT(*)
+                          static_cast<unsigned long long>(defaultTime),                                         // NOLINT(*)
+                          static_cast<unsigned long long>(profiledTime));                                       // NOLINT(*)
+
+    XPF_TEST_EXPECT_TRUE(profiler.GetStatistics().SampledAllocations > 0);
+}
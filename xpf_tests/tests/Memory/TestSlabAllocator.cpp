@@ -0,0 +1,257 @@
+﻿/**
+ * @file        xpf_tests/tests/Memory/TestSlabAllocator.cpp
+ *
+ * @brief       This contains tests for the slab allocator.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+/**
+ * @brief       This is a mock callback used for stress testing the slab allocator.
+ *              Each thread keeps blocks of different size classes alive at once.
+ *
+ * @param[in] Context - Unused.
+ */
+static void XPF_API
+MockSlabStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    XPF_UNREFERENCED_PARAMETER(Context);
+
+    void* blocks[32] = { nullptr };
+
+    for (size_t i = 0; i < 500; ++i)
+    {
+        for (size_t j = 0; j < XPF_ARRAYSIZE(blocks); ++j)
+        {
+            const size_t blockSize = size_t{ 8 } << (j % 12);
+
+            blocks[j] = xpf::SlabAllocator::AllocateMemory(blockSize);
+            if (nullptr != blocks[j])
+            {
+                static_cast<uint8_t*>(blocks[j])[0] = 0xAB;
+                static_cast<uint8_t*>(blocks[j])[blockSize - 1] = 0xCD;
+            }
+        }
+        for (size_t j = 0; j < XPF_ARRAYSIZE(blocks); ++j)
+        {
+            xpf::SlabAllocator::FreeMemory(blocks[j]);
+            blocks[j] = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief       This tests allocations from all size classes, as well as the large ones.
+ */
+XPF_TEST_SCENARIO(TestSlabAllocator, AllocateAndFree)
+{
+    const size_t sizes[] = { 0, 1, 15, 16, 17, 100, 1024, 4000, 8191, 8192, 8193, 32768, 1048576 };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(sizes); ++i)
+    {
+        uint8_t* block = static_cast<uint8_t*>(xpf::SlabAllocator::AllocateMemory(sizes[i]));
+        XPF_TEST_EXPECT_TRUE(nullptr != block);
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(block),
+                                                      decltype(xpf::AlgoPointerToValue(block)){ XPF_DEFAULT_ALIGNMENT }));
+
+        //
+        // The whole requested size must be usable.
+        //
+        for (size_t j = 0; j < sizes[i]; ++j)
+        {
+            block[j] = 0xAB;
+        }
+
+        xpf::SlabAllocator::FreeMemory(block);
+    }
+
+    //
+    // Freeing null is a no-op.
+    //
+    xpf::SlabAllocator::FreeMemory(nullptr);
+}
+
+/**
+ * @brief       This tests that blocks are reused and zeroed.
+ */
+XPF_TEST_SCENARIO(TestSlabAllocator, FreeAndReuse)
+{
+    uint8_t* block = static_cast<uint8_t*>(xpf::SlabAllocator::AllocateMemory(200));
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        block[i] = 0xAB;
+    }
+    xpf::SlabAllocator::FreeMemory(block);
+
+    //
+    // Same size class - we get the last freed block back from the magazine, zeroed.
+    //
+    uint8_t* reusedBlock = static_cast<uint8_t*>(xpf::SlabAllocator::AllocateMemory(250));
+    XPF_TEST_EXPECT_TRUE(reusedBlock == block);
+
+    bool allZero = true;
+    for (size_t i = 0; i < 250; ++i)
+    {
+        allZero = allZero && (reusedBlock[i] == 0);
+    }
+    XPF_TEST_EXPECT_TRUE(allZero);
+
+    xpf::SlabAllocator::FreeMemory(reusedBlock);
+}
+
+/**
+ * @brief       This tests that the blocks carry no header - the small blocks are packed
+ *              in a few slabs, and only the big blocks are page aligned.
+ */
+XPF_TEST_SCENARIO(TestSlabAllocator, NoBlockHeader)
+{
+    static constexpr size_t BLOCKS_COUNT = 4000;
+    void** blocks = static_cast<void**>(xpf::MemoryAllocator::AllocateMemory(BLOCKS_COUNT * sizeof(void*)));
+    XPF_TEST_EXPECT_TRUE(nullptr != blocks);
+
+    (void) xpf::SlabAllocator::ReleaseUnusedSlabs();
+
+    uint64_t slabs[8] = { 0 };
+    size_t slabsCount = 0;
+    bool isAnyPageAligned = false;
+
+    for (size_t i = 0; i < BLOCKS_COUNT; ++i)
+    {
+        blocks[i] = xpf::SlabAllocator::AllocateMemory(16);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+
+        const uint64_t blockValue = static_cast<uint64_t>(xpf::AlgoPointerToValue(blocks[i]));
+        isAnyPageAligned = isAnyPageAligned || xpf::AlgoIsNumberAligned(blockValue, uint64_t{ 4096 });
+
+        const uint64_t slab = blockValue & ~uint64_t{ 65535 };
+        bool isKnownSlab = false;
+        for (size_t j = 0; j < slabsCount; ++j)
+        {
+            isKnownSlab = isKnownSlab || (slabs[j] == slab);
+        }
+        if (!isKnownSlab && slabsCount < XPF_ARRAYSIZE(slabs))
+        {
+            slabs[slabsCount++] = slab;
+        }
+    }
+
+    //
+    // With a 16 byte header per block we would need twice as many slabs.
+    //
+    XPF_TEST_EXPECT_TRUE(!isAnyPageAligned);
+    XPF_TEST_EXPECT_TRUE(slabsCount <= 2);
+
+    for (size_t i = 0; i < BLOCKS_COUNT; ++i)
+    {
+        xpf::SlabAllocator::FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+    xpf::MemoryAllocator::FreeMemory(blocks);
+
+    void* bigBlock = xpf::SlabAllocator::AllocateMemory(xpf::SlabAllocator::SLAB_MAX_CLASS_SIZE + 1);
+    XPF_TEST_EXPECT_TRUE(nullptr != bigBlock);
+    XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(bigBlock),
+                                                  decltype(xpf::AlgoPointerToValue(bigBlock)){ 4096 }));
+    xpf::SlabAllocator::FreeMemory(bigBlock);
+
+    (void) xpf::SlabAllocator::ReleaseUnusedSlabs();
+}
+
+/**
+ * @brief       This tests the slab allocator plugged in the containers.
+ */
+XPF_TEST_SCENARIO(TestSlabAllocator, PolymorphicAllocator)
+{
+    xpf::Vector<uint32_t> vector{ XPF_SLAB_ALLOCATOR };
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace(i)));
+    }
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(vector[i] == i);
+    }
+
+    xpf::String<char> string{ XPF_SLAB_ALLOCATOR };
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(string.Append("Hello ")));
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(string.Append("slab!")));
+    XPF_TEST_EXPECT_TRUE(string.View().Equals("Hello slab!", true));
+
+    xpf::Set<uint32_t> set{ XPF_SLAB_ALLOCATOR };
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        uint32_t key = i;
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(set.Insert(xpf::Move(key))));
+    }
+    XPF_TEST_EXPECT_TRUE(set.Contains(42));
+    XPF_TEST_EXPECT_TRUE(set.Size() == 100);
+
+    auto sharedPointer = xpf::MakeSharedWithAllocator<uint64_t>(XPF_SLAB_ALLOCATOR, 100);
+    XPF_TEST_EXPECT_TRUE(!sharedPointer.IsEmpty());
+    XPF_TEST_EXPECT_TRUE((*sharedPointer) == 100);
+}
+
+/**
+ * @brief       This tests that unused slabs can be released and the allocator still works after.
+ */
+XPF_TEST_SCENARIO(TestSlabAllocator, ReleaseUnusedSlabs)
+{
+    void* blocks[300] = { nullptr };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        blocks[i] = xpf::SlabAllocator::AllocateMemory(64);
+        XPF_TEST_EXPECT_TRUE(nullptr != blocks[i]);
+    }
+
+    //
+    // Keep one block alive - its slab must survive the release.
+    //
+    for (size_t i = 1; i < XPF_ARRAYSIZE(blocks); ++i)
+    {
+        xpf::SlabAllocator::FreeMemory(blocks[i]);
+        blocks[i] = nullptr;
+    }
+    xpf::SlabAllocator::ReleaseUnusedSlabs();
+
+    static_cast<uint8_t*>(blocks[0])[63] = 0xAB;
+    xpf::SlabAllocator::FreeMemory(blocks[0]);
+    blocks[0] = nullptr;
+
+    xpf::SlabAllocator::ReleaseUnusedSlabs();
+
+    void* block = xpf::SlabAllocator::AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(nullptr != block);
+    xpf::SlabAllocator::FreeMemory(block);
+}
+
+/**
+ * @brief       This tests the slab allocator under multithreaded stress.
+ */
+XPF_TEST_SCENARIO(TestSlabAllocator, StressAllocFree)
+{
+    xpf::thread::Thread threads[8];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockSlabStressCallback, nullptr)));
+    }
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    xpf::SlabAllocator::ReleaseUnusedSlabs();
+}
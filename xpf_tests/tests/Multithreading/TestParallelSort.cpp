@@ -0,0 +1,352 @@
+﻿/**
+ * @file        xpf_tests/tests/Multithreading/TestParallelSort.cpp
+ *
+ * @brief       This contains tests for the parallel sort.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Fills a vector with pseudorandom numbers.
+ *
+ * @param[in,out] Vector - Cleared, then filled with Count elements.
+ *
+ * @param[in] Count - The number of elements.
+ *
+ * @param[in] Modulo - The values are in [0, Modulo).
+ *
+ * @return The sum of the elements, or 0 if they could not be added.
+ */
+static uint64_t XPF_API
+MockParallelSortFill(
+    _Inout_ xpf::Vector<uint64_t>& Vector,
+    _In_ size_t Count,
+    _In_ uint64_t Modulo
+) noexcept(true)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    uint64_t sum = 0;
+
+    Vector.Clear();
+    if (!NT_SUCCESS(Vector.ReserveCapacity(Count)))
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < Count; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        const uint64_t value = state % Modulo;
+        if (!NT_SUCCESS(Vector.Emplace(value)))
+        {
+            return 0;
+        }
+        sum += value;
+    }
+    return sum;
+}
+
+/**
+ * @brief       Checks that a vector is sorted and sums to the expected value.
+ *
+ * @param[in] Vector - The vector to be checked.
+ *
+ * @param[in] ExpectedSum - The sum of the elements before sorting.
+ *
+ * @return true if the vector is sorted and no element was lost.
+ */
+static bool XPF_API
+MockParallelSortIsSorted(
+    _In_ const xpf::Vector<uint64_t>& Vector,
+    _In_ uint64_t ExpectedSum
+) noexcept(true)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < Vector.Size(); ++i)
+    {
+        sum += Vector[i];
+        if ((i > 0) && (Vector[i] < Vector[i - 1]))
+        {
+            return false;
+        }
+    }
+    return sum == ExpectedSum;
+}
+
+/**
+ * @brief       Compares two strings lexicographically.
+ *
+ * @param[in] Left - The first string.
+ *
+ * @param[in] Right - The second string.
+ *
+ * @return true if Left should appear before Right.
+ */
+static bool XPF_API
+MockParallelSortIsLess(
+    _In_ const xpf::String<char>& Left,
+    _In_ const xpf::String<char>& Right
+) noexcept(true)
+{
+    const size_t size = (Left.BufferSize() < Right.BufferSize()) ? Left.BufferSize()
+                                                                 : Right.BufferSize();
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (Left[i] != Right[i])
+        {
+            return Left[i] < Right[i];
+        }
+    }
+    return Left.BufferSize() < Right.BufferSize();
+}
+
+/**
+ * @brief       The context of a parallel sort started from a threadpool worker.
+ */
+struct MockParallelSortWorkerContext
+{
+    /**
+     * @brief   The threadpool - the sort runs on it, and so does the work item calling it.
+     */
+    xpf::ThreadPool* Pool = nullptr;
+
+    /**
+     * @brief   How many sorts completed and were correct.
+     */
+    xpf::Atomic<uint32_t> Sorted;
+
+    /**
+     * @brief   How many sorts completed.
+     */
+    xpf::Atomic<uint32_t> Finished;
+};
+
+/**
+ * @brief       A work item which sorts a vector on the same threadpool it runs on.
+ *
+ * @param[in] Context - A pointer to a MockParallelSortWorkerContext.
+ */
+static void XPF_API
+MockParallelSortWorkerCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockParallelSortWorkerContext*>(Context);
+    if (nullptr == context)
+    {
+        return;
+    }
+
+    xpf::Vector<uint64_t> vector;
+    const uint64_t sum = MockParallelSortFill(vector, xpf::XPF_PARALLEL_SORT_THRESHOLD * 2, 1000);
+
+    const NTSTATUS status = xpf::ParallelSort(vector,
+                                              [&](const uint64_t& Left, const uint64_t& Right)
+                                              {
+                                                  return Left < Right;
+                                              },
+                                              *context->Pool,
+                                              16);
+    if (NT_SUCCESS(status) && (0 != sum) && MockParallelSortIsSorted(vector, sum))
+    {
+        (void) context->Sorted.FetchAdd(1);
+    }
+    (void) context->Finished.FetchAdd(1);
+}
+
+/**
+ * @brief       A work item which was not processed - it still counts as finished.
+ *
+ * @param[in] Context - A pointer to a MockParallelSortWorkerContext.
+ */
+static void XPF_API
+MockParallelSortWorkerNotProcessedCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockParallelSortWorkerContext*>(Context);
+    if (nullptr != context)
+    {
+        (void) context->Finished.FetchAdd(1);
+    }
+}
+
+/**
+ * @brief       This tests the parallel sort with different numbers of chunks.
+ */
+XPF_TEST_SCENARIO(TestParallelSort, Parallelism)
+{
+    xpf::Optional<xpf::ThreadPool> threadpool;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ThreadPool::Create(&threadpool)));
+    XPF_TEST_EXPECT_TRUE(threadpool.HasValue());
+
+    const size_t parallelism[] = { 0, 1, 2, 3, 7, 8, 16, 100 };
+    const uint64_t modulo[] = { 16, 0xFFFFFFFFFFFFFFFFull };
+
+    xpf::Vector<uint64_t> vector;
+    for (size_t i = 0; i < XPF_ARRAYSIZE(parallelism); ++i)
+    {
+        for (size_t j = 0; j < XPF_ARRAYSIZE(modulo); ++j)
+        {
+            const uint64_t sum = MockParallelSortFill(vector, 200003, modulo[j]);
+            XPF_TEST_EXPECT_TRUE(0 != sum);
+
+            const NTSTATUS status = xpf::ParallelSort(vector,
+                                                      [&](const uint64_t& Left, const uint64_t& Right)
+                                                      {
+                                                          return Left < Right;
+                                                      },
+                                                      *threadpool,
+                                                      parallelism[i]);
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+            XPF_TEST_EXPECT_TRUE(200003 == vector.Size());
+            XPF_TEST_EXPECT_TRUE(MockParallelSortIsSorted(vector, sum));
+        }
+    }
+
+    //
+    // Below the threshold the vector is sorted on the calling thread.
+    //
+    const uint64_t sum = MockParallelSortFill(vector, 1000, 1000);
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ParallelSort(vector,
+                                                      [&](const uint64_t& Left, const uint64_t& Right)
+                                                      {
+                                                          return Left < Right;
+                                                      },
+                                                      *threadpool)));
+    XPF_TEST_EXPECT_TRUE(MockParallelSortIsSorted(vector, sum));
+}
+
+/**
+ * @brief       This tests the parallel sort on a type which owns memory,
+ *              and on a threadpool which was run down.
+ */
+XPF_TEST_SCENARIO(TestParallelSort, NonTrivialTypeAndRundown)
+{
+    xpf::Optional<xpf::ThreadPool> threadpool;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ThreadPool::Create(&threadpool)));
+    XPF_TEST_EXPECT_TRUE(threadpool.HasValue());
+
+    xpf::Vector<xpf::String<char>> vector;
+    for (size_t i = 0; i < xpf::XPF_PARALLEL_SORT_THRESHOLD + 5; ++i)
+    {
+        const char letters[] = { static_cast<char>('a' + ((i * 7) % 26)),
+                                 static_cast<char>('a' + ((i * 13) % 26)),
+                                 static_cast<char>('a' + (i % 26)),
+                                 '\0' };
+
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.Emplace()));
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector[i].Append(letters)));
+    }
+
+    auto predicate = [&](const xpf::String<char>& Left, const xpf::String<char>& Right)
+                     {
+                         return MockParallelSortIsLess(Left, Right);
+                     };
+
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ParallelSort(vector, predicate, *threadpool, 5)));
+    for (size_t i = 1; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(!predicate(vector[i], vector[i - 1]));
+        XPF_TEST_EXPECT_TRUE(3 == vector[i].BufferSize());
+    }
+
+    //
+    // The threadpool no longer accepts work - the calling thread sorts on its own.
+    //
+    (*threadpool).Rundown();
+
+    auto reversePredicate = [&](const xpf::String<char>& Left, const xpf::String<char>& Right)
+                            {
+                                return MockParallelSortIsLess(Right, Left);
+                            };
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ParallelSort(vector, reversePredicate, *threadpool, 4)));
+    for (size_t i = 1; i < vector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(!reversePredicate(vector[i], vector[i - 1]));
+        XPF_TEST_EXPECT_TRUE(3 == vector[i].BufferSize());
+    }
+}
+
+/**
+ * @brief       This tests the parallel sort called from the workers of the threadpool it uses.
+ *              The work items it enqueues might be queued behind the caller - it must not wait for them.
+ */
+XPF_TEST_SCENARIO(TestParallelSort, FromThreadPoolWorker)
+{
+    xpf::Optional<xpf::ThreadPool> threadpool;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ThreadPool::Create(&threadpool)));
+    XPF_TEST_EXPECT_TRUE(threadpool.HasValue());
+
+    MockParallelSortWorkerContext context;
+    context.Pool = &(*threadpool);
+
+    constexpr uint32_t workItems = 8;
+    for (uint32_t i = 0; i < workItems; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS((*threadpool).Enqueue(MockParallelSortWorkerCallback,
+                                                              MockParallelSortWorkerNotProcessedCallback,
+                                                              &context)));
+    }
+
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        if (workItems == context.Finished.Load())
+        {
+            break;
+        }
+        xpf::ApiSleep(10);
+    }
+    XPF_TEST_EXPECT_TRUE(workItems == context.Finished.Load());
+    XPF_TEST_EXPECT_TRUE(workItems == context.Sorted.Load());
+
+    (*threadpool).Rundown();
+}
+
+/**
+ * @brief       This measures the scaling of the parallel sort from 1 to 16 threads.
+ */
+XPF_TEST_SCENARIO(TestParallelSort, Benchmark)
+{
+    constexpr size_t count = 4000000;
+
+    xpf::Optional<xpf::ThreadPool> threadpool;
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(xpf::ThreadPool::Create(&threadpool)));
+    XPF_TEST_EXPECT_TRUE(threadpool.HasValue());
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS((*threadpool).Grow(16)));
+
+    xpf::Vector<uint64_t> vector;
+    for (size_t threads = 1; threads <= 16; threads = threads * 2)
+    {
+        const uint64_t sum = MockParallelSortFill(vector, count, 0xFFFFFFFFFFFFFFFFull);
+
+        const uint64_t start = xpf::ApiCurrentTime();
+        const NTSTATUS status = xpf::ParallelSort(vector,
+                                                  [&](const uint64_t& Left, const uint64_t& Right)
+                                                  {
+                                                      return Left < Right;
+                                                  },
+                                                  *threadpool,
+                                                  threads);
+        const uint64_t end = xpf::ApiCurrentTime();
+
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+        XPF_TEST_EXPECT_TRUE(MockParallelSortIsSorted(vector, sum));
+
+        xpf_test::LogTestInfo("    > %llu elements on %llu threads: %llu (100 ns) \r\n",
+                              static_cast<unsigned long long>(count),                                           // NOLINT(*)
+                              static_cast<unsigned long long>(threads),                                         // NOLINT(*)
+                              static_cast<unsigned long long>(end - start));                                    // NOLINT(*)
+    }
+}
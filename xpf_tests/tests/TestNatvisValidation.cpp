@@ -44,6 +44,15 @@ XPF_TEST_SCENARIO(TestNatvisValidation, BreakpointTarget)
     status = intVector.Emplace(30);
     XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
 
+    //
+    // SmallVector<int, 4>
+    //
+    xpf::SmallVector<int, 4> intSmallVector;
+    status = intSmallVector.Emplace(10);
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+    status = intSmallVector.Emplace(20);
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+
     //
     // StringView<char> and StringView<wchar_t>
     //
@@ -66,6 +75,11 @@ XPF_TEST_SCENARIO(TestNatvisValidation, BreakpointTarget)
     //
     xpf::Span<int> intSpan(&intVector[0], intVector.Size());
 
+    //
+    // MutableSpan<int>
+    //
+    xpf::MutableSpan<int> intMutableSpan(&intVector[0], intVector.Size());
+
     //
     // Optional<int> (empty and with value)
     //
@@ -85,6 +99,12 @@ XPF_TEST_SCENARIO(TestNatvisValidation, BreakpointTarget)
     auto sharedInt = xpf::MakeShared<int>(200);
     XPF_TEST_EXPECT_TRUE(!sharedInt.IsEmpty());
 
+    //
+    // AtomicSharedPointer<int>
+    //
+    xpf::AtomicSharedPointer<int> atomicSharedInt{ sharedInt };
+    XPF_TEST_EXPECT_TRUE(!atomicSharedInt.Load().IsEmpty());
+
     //
     // BusyLock
     //
@@ -129,6 +149,14 @@ XPF_TEST_SCENARIO(TestNatvisValidation, BreakpointTarget)
     xpf::XPF_SINGLE_LIST_ENTRY tlqEntry = { nullptr };
     xpf::TlqPush(tlq, &tlqEntry);
 
+    //
+    // LockFreeStack (push so it stays alive - the entry must be properly aligned)
+    //
+    xpf::LockFreeStack lockFreeStack;
+    alignas(XPF_DEFAULT_ALIGNMENT) xpf::XPF_SINGLE_LIST_ENTRY lfsEntry = { nullptr };
+    lockFreeStack.Push(&lfsEntry);
+    XPF_TEST_EXPECT_TRUE(!lockFreeStack.IsEmpty());
+
     //
     // LookasideListAllocator (alloc + free so the compiler keeps it alive)
     //
@@ -137,6 +165,22 @@ XPF_TEST_SCENARIO(TestNatvisValidation, BreakpointTarget)
     XPF_TEST_EXPECT_TRUE(nullptr != lookasideBlock);
     lookasideAllocator.FreeMemory(lookasideBlock);
 
+    //
+    // ObjectPool<int> (acquire + release so the compiler keeps it alive)
+    //
+    xpf::ObjectPool<int> objectPool;
+    int* pooledObject = objectPool.Acquire(100);
+    XPF_TEST_EXPECT_TRUE(nullptr != pooledObject);
+    objectPool.Release(pooledObject);
+
+    //
+    // MonotonicArena and a stateful PolymorphicAllocator pointing to it
+    //
+    xpf::MonotonicArena monotonicArena;
+    xpf::PolymorphicAllocator arenaAllocator = monotonicArena.GetAllocator();
+    void* arenaBlock = arenaAllocator.AllocateMemory(64);
+    XPF_TEST_EXPECT_TRUE(nullptr != arenaBlock);
+
     //
     // RedBlackTree<int, int> with RedBlackTreeNode and RedBlackTreeIterator
     //
@@ -170,6 +214,65 @@ XPF_TEST_SCENARIO(TestNatvisValidation, BreakpointTarget)
     status = intSet.Insert(int{200});
     XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
 
+    //
+    // HashMap<int, int>
+    //
+    xpf::HashMap<int, int> intHashMap;
+    status = intHashMap.Emplace(int{10}, int{1000});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+    status = intHashMap.Emplace(int{20}, int{2000});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+
+    //
+    // HashSet<int>
+    //
+    xpf::HashSet<int> intHashSet;
+    status = intHashSet.Insert(int{100});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+
+    //
+    // BTreeMap<int, int> with BTreeNode and BTreeIterator
+    //
+    xpf::BTreeMap<int, int> intBTreeMap;
+    status = intBTreeMap.Emplace(int{10}, int{1000});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+    status = intBTreeMap.Emplace(int{20}, int{2000});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+    auto intBTreeMapIt = intBTreeMap.Begin();
+    XPF_TEST_EXPECT_TRUE(intBTreeMapIt != intBTreeMap.End());
+
+    //
+    // OrderStatisticTree<int, int> and IntervalTree<int, int> - augmented RedBlackTree
+    //
+    xpf::OrderStatisticTree<int, int> intOrderStatisticTree;
+    status = intOrderStatisticTree.Emplace(int{1}, int{100});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+
+    xpf::IntervalTree<int, int> intIntervalTree;
+    status = intIntervalTree.Emplace(10, 20, int{100});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+
+    //
+    // ConcurrentHashMap<int, int> with ConcurrentHashMapShard
+    //
+    xpf::ConcurrentHashMap<int, int> intConcurrentHashMap;
+    status = intConcurrentHashMap.Insert(int{1}, int{100});
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+
+    //
+    // MpmcRingBuffer<int, 8>
+    //
+    xpf::MpmcRingBuffer<int, 8> intMpmcRingBuffer;
+    XPF_TEST_EXPECT_TRUE(intMpmcRingBuffer.TryPush(int{42}));
+
+    //
+    // SpscRingBuffer<int>
+    //
+    xpf::SpscRingBuffer<int> intSpscRingBuffer;
+    status = intSpscRingBuffer.Allocate(8);
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+    XPF_TEST_EXPECT_TRUE(intSpscRingBuffer.TryPush(int{42}));
+
     //
     // thread::Thread
     //
@@ -0,0 +1,277 @@
+﻿/**
+ * @file        xpf_tests/tests/core/TestAtomic.cpp
+ *
+ * @brief       This contains tests for the atomic operations with explicit memory ordering.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       Runs the free atomic functions on a value of the given type.
+ *
+ * @param[in] Order - The memory order to be used.
+ *
+ * @return true if all operations returned the expected values.
+ */
+template <class Type>
+static bool XPF_API
+MockAtomicRunOperations(
+    _In_ xpf::MemoryOrder Order
+) noexcept(true)
+{
+    alignas(Type) volatile Type value = Type{ 0 };
+    bool isValid = true;
+
+    xpf::ApiAtomicStore(&value, Type{ 5 }, Order);
+    isValid = isValid && (Type{ 5 } == xpf::ApiAtomicLoad(&value, Order));
+
+    isValid = isValid && (Type{ 5 } == xpf::ApiAtomicExchange(&value, Type{ 6 }, Order));
+    isValid = isValid && (Type{ 6 } == xpf::ApiAtomicFetchAdd(&value, Type{ 2 }, Order));
+    isValid = isValid && (Type{ 8 } == xpf::ApiAtomicFetchSub(&value, Type{ 3 }, Order));
+    isValid = isValid && (Type{ 5 } == xpf::ApiAtomicFetchOr(&value, Type{ 0x12 }, Order));
+    isValid = isValid && (Type{ 0x17 } == xpf::ApiAtomicFetchAnd(&value, Type{ 0x0F }, Order));
+    isValid = isValid && (Type{ 0x07 } == xpf::ApiAtomicLoad(&value));
+
+    Type expected = Type{ 1 };
+    isValid = isValid && !xpf::ApiAtomicTryCompareExchange(&value, expected, Type{ 9 }, Order);
+    isValid = isValid && (Type{ 0x07 } == expected);
+    isValid = isValid && xpf::ApiAtomicTryCompareExchange(&value, expected, Type{ 9 }, Order);
+    isValid = isValid && (Type{ 9 } == xpf::ApiAtomicLoad(&value));
+
+    return isValid;
+}
+
+/**
+ * @brief       This is a mock callback used for stress testing the atomic class.
+ *
+ * @param[in] Context - A pointer to an xpf::Atomic<uint64_t>.
+ */
+static void XPF_API
+MockAtomicStressCallback(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto counter = static_cast<xpf::Atomic<uint64_t>*>(Context);
+    if (nullptr != counter)
+    {
+        for (size_t i = 0; i < 100000; ++i)
+        {
+            (void) counter->FetchAdd(3, xpf::MemoryOrder::Relaxed);
+            (void) counter->FetchSub(1, xpf::MemoryOrder::Release);
+        }
+    }
+}
+
+/**
+ * @brief       The context of the torn access test.
+ */
+struct MockAtomicTornContext
+{
+    /**
+     * @brief The value written by the writer and read by the readers.
+     *        It only ever holds 0 or all bits set.
+     */
+    xpf::Atomic<uint64_t> Value;
+
+    /**
+     * @brief Set by the writer when it is done.
+     */
+    xpf::Atomic<uint32_t> IsDone;
+
+    /**
+     * @brief The number of reads which saw something else - half of a write.
+     */
+    xpf::Atomic<uint64_t> TornReads;
+};
+
+/**
+ * @brief       Flips the value between 0 and all bits set, with relaxed and release stores.
+ *
+ * @param[in] Context - A pointer to a MockAtomicTornContext.
+ */
+static void XPF_API
+MockAtomicTornWriter(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockAtomicTornContext*>(Context);
+    if (nullptr != context)
+    {
+        for (size_t i = 0; i < 1000000; ++i)
+        {
+            context->Value.Store(~uint64_t{ 0 }, xpf::MemoryOrder::Relaxed);
+            context->Value.Store(uint64_t{ 0 }, xpf::MemoryOrder::Release);
+        }
+        context->IsDone.Store(1);
+    }
+}
+
+/**
+ * @brief       Reads the value until the writer is done, and counts the torn reads.
+ *
+ * @param[in] Context - A pointer to a MockAtomicTornContext.
+ */
+static void XPF_API
+MockAtomicTornReader(
+    _In_opt_ xpf::thread::CallbackArgument Context
+) noexcept(true)
+{
+    auto context = static_cast<MockAtomicTornContext*>(Context);
+    if (nullptr != context)
+    {
+        uint64_t tornReads = 0;
+        while (0 == context->IsDone.Load(xpf::MemoryOrder::Relaxed))
+        {
+            const uint64_t relaxed = context->Value.Load(xpf::MemoryOrder::Relaxed);
+            const uint64_t acquired = context->Value.Load(xpf::MemoryOrder::Acquire);
+
+            tornReads += ((0 == relaxed) || (~uint64_t{ 0 } == relaxed)) ? 0 : 1;
+            tornReads += ((0 == acquired) || (~uint64_t{ 0 } == acquired)) ? 0 : 1;
+        }
+        (void) context->TornReads.FetchAdd(tornReads);
+    }
+}
+
+/**
+ * @brief       This tests the free functions on all supported types and orders.
+ */
+XPF_TEST_SCENARIO(TestAtomic, FreeFunctions)
+{
+    const xpf::MemoryOrder orders[] = { xpf::MemoryOrder::Relaxed,
+                                        xpf::MemoryOrder::Acquire,
+                                        xpf::MemoryOrder::Release,
+                                        xpf::MemoryOrder::AcquireRelease,
+                                        xpf::MemoryOrder::SequentiallyConsistent };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(orders); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<uint8_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<int8_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<uint16_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<int16_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<uint32_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<int32_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<uint64_t>(orders[i]));
+        XPF_TEST_EXPECT_TRUE(MockAtomicRunOperations<int64_t>(orders[i]));
+    }
+    xpf::ApiAtomicThreadFence(xpf::MemoryOrder::SequentiallyConsistent);
+}
+
+/**
+ * @brief       This tests loading a pointer published with a compare-exchange.
+ */
+XPF_TEST_SCENARIO(TestAtomic, PointerLoad)
+{
+    int object = 42;
+    void* volatile published = nullptr;
+
+    XPF_TEST_EXPECT_TRUE(nullptr == xpf::ApiAtomicLoad(&published, xpf::MemoryOrder::Acquire));
+    XPF_TEST_EXPECT_TRUE(nullptr == xpf::ApiAtomicCompareExchangePointer(&published, &object, nullptr));
+
+    const xpf::MemoryOrder orders[] = { xpf::MemoryOrder::Relaxed,
+                                        xpf::MemoryOrder::Acquire,
+                                        xpf::MemoryOrder::Release,
+                                        xpf::MemoryOrder::AcquireRelease,
+                                        xpf::MemoryOrder::SequentiallyConsistent };
+    for (size_t i = 0; i < XPF_ARRAYSIZE(orders); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(&object == xpf::ApiAtomicLoad(&published, orders[i]));
+    }
+    XPF_TEST_EXPECT_TRUE(42 == *static_cast<int*>(xpf::ApiAtomicLoad(&published)));
+}
+
+/**
+ * @brief       This tests the wrap around of the arithmetic operations.
+ */
+XPF_TEST_SCENARIO(TestAtomic, WrapAround)
+{
+    xpf::Atomic<uint8_t> unsignedValue{ uint8_t{ 0xFF } };
+    XPF_TEST_EXPECT_TRUE(uint8_t{ 0xFF } == unsignedValue.FetchAdd(1));
+    XPF_TEST_EXPECT_TRUE(uint8_t{ 0 } == unsignedValue.FetchSub(1));
+    XPF_TEST_EXPECT_TRUE(uint8_t{ 0xFF } == unsignedValue.Load());
+
+    xpf::Atomic<int32_t> signedValue{ -2 };
+    XPF_TEST_EXPECT_TRUE(-2 == signedValue.FetchAdd(5));
+    XPF_TEST_EXPECT_TRUE(3 == signedValue.FetchSub(10));
+    XPF_TEST_EXPECT_TRUE(-7 == signedValue.Load(xpf::MemoryOrder::Acquire));
+}
+
+/**
+ * @brief       This tests the atomic class methods.
+ */
+XPF_TEST_SCENARIO(TestAtomic, AtomicClass)
+{
+    xpf::Atomic<uint32_t> value;
+    XPF_TEST_EXPECT_TRUE(0 == value.Load());
+
+    value.Store(10, xpf::MemoryOrder::Release);
+    XPF_TEST_EXPECT_TRUE(10 == value.Load(xpf::MemoryOrder::Relaxed));
+    XPF_TEST_EXPECT_TRUE(10 == value.Exchange(20, xpf::MemoryOrder::AcquireRelease));
+    XPF_TEST_EXPECT_TRUE(20 == value.FetchOr(0x100));
+    XPF_TEST_EXPECT_TRUE(0x114 == value.FetchAnd(0x100));
+
+    uint32_t expected = 0;
+    XPF_TEST_EXPECT_TRUE(!value.CompareExchange(expected, 1, xpf::MemoryOrder::Acquire));
+    XPF_TEST_EXPECT_TRUE(0x100 == expected);
+    XPF_TEST_EXPECT_TRUE(value.CompareExchange(expected, 1, xpf::MemoryOrder::Acquire));
+    XPF_TEST_EXPECT_TRUE(1 == value.Load());
+}
+
+/**
+ * @brief       This tests the atomic class used by multiple threads.
+ */
+XPF_TEST_SCENARIO(TestAtomic, Stress)
+{
+    xpf::Atomic<uint64_t> counter;
+    xpf::thread::Thread threads[8];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(threads[i].Run(MockAtomicStressCallback, &counter)));
+    }
+    for (size_t i = 0; i < XPF_ARRAYSIZE(threads); ++i)
+    {
+        threads[i].Join();
+    }
+
+    XPF_TEST_EXPECT_TRUE(XPF_ARRAYSIZE(threads) * 100000 * 2 == counter.Load(xpf::MemoryOrder::Acquire));
+}
+
+/**
+ * @brief       This tests that 64-bit loads and stores are never seen half done.
+ *              A plain access is split in two on 32-bit x86 (Win32), so a reader
+ *              could see the high half of one value and the low half of another.
+ */
+XPF_TEST_SCENARIO(TestAtomic, NoTornLoadsOrStores)
+{
+    MockAtomicTornContext context;
+    xpf::thread::Thread writer;
+    xpf::thread::Thread readers[3];
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(readers); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(readers[i].Run(MockAtomicTornReader, &context)));
+    }
+    if (!NT_SUCCESS(writer.Run(MockAtomicTornWriter, &context)))
+    {
+        /* Let the readers finish. */
+        context.IsDone.Store(1);
+        XPF_TEST_EXPECT_TRUE(false);
+    }
+
+    writer.Join();
+    for (size_t i = 0; i < XPF_ARRAYSIZE(readers); ++i)
+    {
+        readers[i].Join();
+    }
+    XPF_TEST_EXPECT_TRUE(0 == context.TornReads.Load());
+}
@@ -40,6 +40,49 @@ XPF_TEST_SCENARIO(TestPlatformApi, AllocAndFree)
     ptr = nullptr;
 }
 
+/**
+ * @brief       This tests the aligned alloc and free routines.
+ *
+ */
+XPF_TEST_SCENARIO(TestPlatformApi, AlignedAllocAndFree)
+{
+    const size_t alignments[] = { 1, 16, 64, 256, 4096 };
+
+    for (size_t i = 0; i < XPF_ARRAYSIZE(alignments); ++i)
+    {
+        uint8_t* ptr = static_cast<uint8_t*>(xpf::ApiAllocateMemoryAligned(100, alignments[i], (i % 2) == 0));
+        XPF_TEST_EXPECT_TRUE(nullptr != ptr);
+        XPF_TEST_EXPECT_TRUE(xpf::AlgoIsNumberAligned(xpf::AlgoPointerToValue(ptr),
+                                                      static_cast<decltype(xpf::AlgoPointerToValue(ptr))>(alignments[i])));
+
+        bool allZero = true;
+        for (size_t j = 0; j < 100; ++j)
+        {
+            allZero = allZero && (0 == ptr[j]);
+        }
+        XPF_TEST_EXPECT_TRUE(allZero);
+
+        xpf::ApiFreeMemoryAligned(ptr);
+        ptr = nullptr;
+    }
+
+    //
+    // Zero size alloc.
+    //
+    void* ptr = xpf::ApiAllocateMemoryAligned(0, 64);
+    XPF_TEST_EXPECT_TRUE(nullptr != ptr);
+    xpf::ApiFreeMemoryAligned(ptr);
+
+    //
+    // Invalid alignments and sizes.
+    //
+    XPF_TEST_EXPECT_TRUE(nullptr == xpf::ApiAllocateMemoryAligned(100, 0));
+    XPF_TEST_EXPECT_TRUE(nullptr == xpf::ApiAllocateMemoryAligned(100, 48));
+    XPF_TEST_EXPECT_TRUE(nullptr == xpf::ApiAllocateMemoryAligned(xpf::NumericLimits<size_t>::MaxValue(), 64));
+
+    xpf::ApiFreeMemoryAligned(nullptr);
+}
+
 
 /**
  * @brief       This tests the to lowercase method.
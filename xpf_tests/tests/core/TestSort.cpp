@@ -0,0 +1,451 @@
+﻿/**
+ * @file        xpf_tests/tests/core/TestSort.cpp
+ *
+ * @brief       This contains tests for the sorting algorithms.
+ *
+ * @author      Andrei-Marius MUNTEA (munteaandrei17@gmail.com)
+ *
+ * @copyright   Copyright © Andrei-Marius MUNTEA 2020-2023.
+ *              All rights reserved.
+ *
+ * @license     See top-level directory LICENSE file.
+ */
+
+
+#include "xpf_tests/XPF-TestIncludes.hpp"
+
+
+/**
+ * @brief       An element which is not trivially copyable, so the sort can't use the
+ *              branchless partitioning. The sequence is used to check the stability.
+ */
+struct MockSortElement
+{
+    MockSortElement(void) noexcept(true) = default;
+    ~MockSortElement(void) noexcept(true) = default;
+
+    MockSortElement(
+        _In_ uint64_t Key,
+        _In_ uint64_t Sequence
+    ) noexcept(true) : m_Key{ Key },
+                       m_Sequence{ Sequence }
+    {
+        XPF_NOTHING();
+    }
+
+    MockSortElement(
+        _In_ const MockSortElement& Other
+    ) noexcept(true) : m_Key{ Other.m_Key },
+                       m_Sequence{ Other.m_Sequence }
+    {
+        XPF_NOTHING();
+    }
+
+    MockSortElement(
+        _Inout_ MockSortElement&& Other
+    ) noexcept(true) : m_Key{ Other.m_Key },
+                       m_Sequence{ Other.m_Sequence }
+    {
+        Other.m_Key = 0;
+        Other.m_Sequence = 0;
+    }
+
+    MockSortElement&
+    operator=(
+        _In_ const MockSortElement& Other
+    ) noexcept(true)
+    {
+        this->m_Key = Other.m_Key;
+        this->m_Sequence = Other.m_Sequence;
+        return *this;
+    }
+
+    MockSortElement&
+    operator=(
+        _Inout_ MockSortElement&& Other
+    ) noexcept(true)
+    {
+        if (this != &Other)
+        {
+            this->m_Key = Other.m_Key;
+            this->m_Sequence = Other.m_Sequence;
+            Other.m_Key = 0;
+            Other.m_Sequence = 0;
+        }
+        return *this;
+    }
+
+    uint64_t m_Key = 0;
+    uint64_t m_Sequence = 0;
+};
+
+/**
+ * @brief       The input patterns the sort is tested against.
+ */
+enum class MockSortPattern
+{
+    Sorted,
+    Reversed,
+    Equal,
+    OrganPipe,
+    Sawtooth,
+    FewUnique,
+    Random,
+    MaxPattern
+};
+
+/**
+ * @brief       A small xorshift generator - the tests must be reproducible.
+ *
+ * @param[in,out] State - The state of the generator. Must not be 0.
+ *
+ * @return The next pseudorandom number.
+ */
+static uint64_t XPF_API
+MockSortNextRandom(
+    _Inout_ uint64_t* State
+) noexcept(true)
+{
+    uint64_t value = *State;
+    value ^= value << 13;
+    value ^= value >> 7;
+    value ^= value << 17;
+    *State = value;
+    return value;
+}
+
+/**
+ * @brief       Generates the key of the element at the given index.
+ *
+ * @param[in] Pattern - The pattern to be generated.
+ *
+ * @param[in] Index - The index of the element.
+ *
+ * @param[in] Count - The total number of elements.
+ *
+ * @param[in,out] RandomState - The state of the random generator.
+ *
+ * @return The key.
+ */
+static uint64_t XPF_API
+MockSortGenerateKey(
+    _In_ MockSortPattern Pattern,
+    _In_ size_t Index,
+    _In_ size_t Count,
+    _Inout_ uint64_t* RandomState
+) noexcept(true)
+{
+    switch (Pattern)
+    {
+        case MockSortPattern::Sorted:
+            return Index;
+        case MockSortPattern::Reversed:
+            return Count - Index;
+        case MockSortPattern::Equal:
+            return 42;
+        case MockSortPattern::OrganPipe:
+            return (Index < Count / 2) ? Index : Count - Index;
+        case MockSortPattern::Sawtooth:
+            return Index % 37;
+        case MockSortPattern::FewUnique:
+            return MockSortNextRandom(RandomState) % 4;
+        default:
+            return MockSortNextRandom(RandomState);
+    }
+}
+
+/**
+ * @brief       Fills a vector with the given pattern.
+ *
+ * @param[in,out] Vector - Cleared, then filled with Count elements.
+ *
+ * @param[in] Pattern - The pattern to be generated.
+ *
+ * @param[in] Count - The number of elements.
+ *
+ * @return true if all elements were added.
+ */
+template <class Type>
+static bool XPF_API
+MockSortFill(
+    _Inout_ xpf::Vector<Type>& Vector,
+    _In_ MockSortPattern Pattern,
+    _In_ size_t Count
+) noexcept(true)
+{
+    uint64_t randomState = 0x9E3779B97F4A7C15ull;
+
+    Vector.Clear();
+    if (!NT_SUCCESS(Vector.ReserveCapacity(Count)))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < Count; ++i)
+    {
+        const uint64_t key = MockSortGenerateKey(Pattern, i, Count, &randomState);
+
+        NTSTATUS status = STATUS_UNSUCCESSFUL;
+        if constexpr (xpf::IsSameType<Type, MockSortElement>)
+        {
+            status = Vector.Emplace(key, uint64_t{ i });
+        }
+        else
+        {
+            status = Vector.Emplace(key);
+        }
+        if (!NT_SUCCESS(status))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief       Checks that a vector of uint64_t is sorted and sums to the expected value.
+ *
+ * @param[in] Vector - The vector to be checked.
+ *
+ * @param[in] ExpectedSum - The sum of the elements before sorting.
+ *
+ * @return true if the vector is sorted and no element was lost.
+ */
+static bool XPF_API
+MockSortIsSorted(
+    _In_ const xpf::Vector<uint64_t>& Vector,
+    _In_ uint64_t ExpectedSum
+) noexcept(true)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < Vector.Size(); ++i)
+    {
+        sum += Vector[i];
+        if ((i > 0) && (Vector[i] < Vector[i - 1]))
+        {
+            return false;
+        }
+    }
+    return sum == ExpectedSum;
+}
+
+/**
+ * @brief       Checks that a vector of MockSortElement is sorted by key, and that
+ *              the elements with equal keys are ordered by sequence.
+ *
+ * @param[in] Vector - The vector to be checked.
+ *
+ * @return true if the vector is stably sorted.
+ */
+static bool XPF_API
+MockSortIsStablySorted(
+    _In_ const xpf::Vector<MockSortElement>& Vector
+) noexcept(true)
+{
+    for (size_t i = 1; i < Vector.Size(); ++i)
+    {
+        if (Vector[i].m_Key < Vector[i - 1].m_Key)
+        {
+            return false;
+        }
+        if ((Vector[i].m_Key == Vector[i - 1].m_Key) && (Vector[i].m_Sequence < Vector[i - 1].m_Sequence))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief       This tests the unstable sort on all patterns and on many small sizes.
+ */
+XPF_TEST_SCENARIO(TestSort, Patterns)
+{
+    const size_t sizes[] = { 0, 1, 2, 3, 23, 24, 25, 100, 127, 128, 129, 1000, 10007, 100000 };
+
+    xpf::Vector<uint64_t> vector;
+    for (size_t pattern = 0; pattern < static_cast<size_t>(MockSortPattern::MaxPattern); ++pattern)
+    {
+        for (size_t i = 0; i < XPF_ARRAYSIZE(sizes); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(MockSortFill(vector, static_cast<MockSortPattern>(pattern), sizes[i]));
+
+            uint64_t sum = 0;
+            for (size_t j = 0; j < vector.Size(); ++j)
+            {
+                sum += vector[j];
+            }
+
+            vector.Sort([&](const uint64_t& Left, const uint64_t& Right)
+                        {
+                            return Left < Right;
+                        });
+            XPF_TEST_EXPECT_TRUE(sizes[i] == vector.Size());
+            XPF_TEST_EXPECT_TRUE(MockSortIsSorted(vector, sum));
+        }
+    }
+
+    //
+    // Every size up to a few times the insertion threshold.
+    //
+    for (size_t size = 0; size <= 100; ++size)
+    {
+        XPF_TEST_EXPECT_TRUE(MockSortFill(vector, MockSortPattern::Random, size));
+
+        uint64_t sum = 0;
+        for (size_t j = 0; j < vector.Size(); ++j)
+        {
+            sum += vector[j];
+        }
+
+        vector.Sort([&](const uint64_t& Left, const uint64_t& Right)
+                    {
+                        return Left < Right;
+                    });
+        XPF_TEST_EXPECT_TRUE(MockSortIsSorted(vector, sum));
+    }
+}
+
+/**
+ * @brief       This tests the unstable sort on a type which is not trivially copyable,
+ *              and with a descending predicate.
+ */
+XPF_TEST_SCENARIO(TestSort, NonTrivialType)
+{
+    xpf::Vector<MockSortElement> vector;
+    for (size_t pattern = 0; pattern < static_cast<size_t>(MockSortPattern::MaxPattern); ++pattern)
+    {
+        XPF_TEST_EXPECT_TRUE(MockSortFill(vector, static_cast<MockSortPattern>(pattern), 5000));
+
+        vector.Sort([&](const MockSortElement& Left, const MockSortElement& Right)
+                    {
+                        return Left.m_Key > Right.m_Key;
+                    });
+        for (size_t i = 1; i < vector.Size(); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(vector[i - 1].m_Key >= vector[i].m_Key);
+        }
+    }
+}
+
+/**
+ * @brief       This tests that the stable sort keeps the order of the equal elements.
+ */
+XPF_TEST_SCENARIO(TestSort, StableSort)
+{
+    const size_t sizes[] = { 0, 1, 31, 32, 33, 64, 65, 1000, 4099 };
+
+    xpf::Vector<MockSortElement> vector;
+    for (size_t pattern = 0; pattern < static_cast<size_t>(MockSortPattern::MaxPattern); ++pattern)
+    {
+        for (size_t i = 0; i < XPF_ARRAYSIZE(sizes); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(MockSortFill(vector, static_cast<MockSortPattern>(pattern), sizes[i]));
+
+            const NTSTATUS status = vector.StableSort([&](const MockSortElement& Left, const MockSortElement& Right)
+                                                      {
+                                                          return Left.m_Key < Right.m_Key;
+                                                      });
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(status));
+            XPF_TEST_EXPECT_TRUE(sizes[i] == vector.Size());
+            XPF_TEST_EXPECT_TRUE(MockSortIsStablySorted(vector));
+        }
+    }
+
+    //
+    // The small vector uses its own allocator for the scratch buffer.
+    //
+    xpf::SmallVector<MockSortElement, 8> smallVector;
+    for (uint64_t i = 0; i < 500; ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(NT_SUCCESS(smallVector.Emplace(i % 3, i)));
+    }
+    XPF_TEST_EXPECT_TRUE(NT_SUCCESS(smallVector.StableSort([&](const MockSortElement& Left,
+                                                               const MockSortElement& Right)
+                                                           {
+                                                               return Left.m_Key < Right.m_Key;
+                                                           })));
+    for (size_t i = 1; i < smallVector.Size(); ++i)
+    {
+        XPF_TEST_EXPECT_TRUE(smallVector[i - 1].m_Key <= smallVector[i].m_Key);
+        if (smallVector[i - 1].m_Key == smallVector[i].m_Key)
+        {
+            XPF_TEST_EXPECT_TRUE(smallVector[i - 1].m_Sequence < smallVector[i].m_Sequence);
+        }
+    }
+}
+
+/**
+ * @brief       This tests that an adversarial predicate can't make the sort quadratic,
+ *              by counting the comparisons on the patterns which are bad for quicksort.
+ */
+XPF_TEST_SCENARIO(TestSort, ComparisonCount)
+{
+    constexpr size_t count = 100000;
+
+    xpf::Vector<uint64_t> vector;
+    for (size_t pattern = 0; pattern < static_cast<size_t>(MockSortPattern::MaxPattern); ++pattern)
+    {
+        XPF_TEST_EXPECT_TRUE(MockSortFill(vector, static_cast<MockSortPattern>(pattern), count));
+
+        size_t comparisons = 0;
+        vector.Sort([&](const uint64_t& Left, const uint64_t& Right)
+                    {
+                        comparisons++;
+                        return Left < Right;
+                    });
+
+        //
+        // n * log2(n) is about 1.7 million - leave plenty of room, quadratic would be 10 billion.
+        //
+        XPF_TEST_EXPECT_TRUE(comparisons < 10 * 1700000);
+    }
+}
+
+/**
+ * @brief       This compares the heapsort with the introspective sort and the stable sort.
+ */
+XPF_TEST_SCENARIO(TestSort, Benchmark)
+{
+    constexpr size_t count = 1000000;
+
+    xpf::Vector<uint64_t> vector;
+    uint64_t times[3] = { 0, 0, 0 };
+
+    for (size_t algorithm = 0; algorithm < XPF_ARRAYSIZE(times); ++algorithm)
+    {
+        XPF_TEST_EXPECT_TRUE(MockSortFill(vector, MockSortPattern::Random, count));
+
+        auto predicate = [&](const uint64_t& Left, const uint64_t& Right)
+                         {
+                             return Left < Right;
+                         };
+
+        const uint64_t start = xpf::ApiCurrentTime();
+        if (0 == algorithm)
+        {
+            xpf::AlgoHeapSort(&vector[0], vector.Size(), predicate);
+        }
+        else if (1 == algorithm)
+        {
+            vector.Sort(predicate);
+        }
+        else
+        {
+            XPF_TEST_EXPECT_TRUE(NT_SUCCESS(vector.StableSort(predicate)));
+        }
+        times[algorithm] = xpf::ApiCurrentTime() - start;
+
+        for (size_t i = 1; i < vector.Size(); ++i)
+        {
+            XPF_TEST_EXPECT_TRUE(vector[i - 1] <= vector[i]);
+        }
+    }
+
+    xpf_test::LogTestInfo("    > %llu random elements: heapsort %llu (100 ns), sort %llu (100 ns), "
+                          "stable sort %llu (100 ns) \r\n",
+                          static_cast<unsigned long long>(count),                                               // NOLINT(*)
+                          static_cast<unsigned long long>(times[0]),                                            // NOLINT(*)
+                          static_cast<unsigned long long>(times[1]),                                            // NOLINT(*)
+                          static_cast<unsigned long long>(times[2]));                                           // NOLINT(*)
+}